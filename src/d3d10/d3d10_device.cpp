@@ -1023,18 +1023,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumBuffers,
           ID3D10Buffer* const*              ppConstantBuffers) {
-    ID3D11Buffer* d3d11Buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
-
-    if (NumBuffers > D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumBuffers; i++) {
-      d3d11Buffers[i] = ppConstantBuffers && ppConstantBuffers[i]
-        ? static_cast<D3D10Buffer*>(ppConstantBuffers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->VSSetConstantBuffers(StartSlot, NumBuffers, d3d11Buffers);
+    m_context->SetD3D10ConstantBuffers(DxbcProgramType::VertexShader,
+      StartSlot, NumBuffers, ppConstantBuffers);
   }
 
 
@@ -1042,18 +1032,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumViews,
           ID3D10ShaderResourceView* const*  ppShaderResourceViews) {
-    ID3D11ShaderResourceView* d3d11Views[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
-
-    if (NumViews > D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumViews; i++) {
-      d3d11Views[i] = ppShaderResourceViews && ppShaderResourceViews[i]
-        ? static_cast<D3D10ShaderResourceView*>(ppShaderResourceViews[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->VSSetShaderResources(StartSlot, NumViews, d3d11Views);
+    m_context->SetD3D10ShaderResources(DxbcProgramType::VertexShader,
+      StartSlot, NumViews, ppShaderResourceViews);
   }
 
 
@@ -1061,18 +1041,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumSamplers,
           ID3D10SamplerState* const*        ppSamplers) {
-    ID3D11SamplerState* d3d11Samplers[D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT];
-
-    if (NumSamplers > D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumSamplers; i++) {
-      d3d11Samplers[i] = ppSamplers && ppSamplers[i]
-        ? static_cast<D3D10SamplerState*>(ppSamplers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->VSSetSamplers(StartSlot, NumSamplers, d3d11Samplers);
+    m_context->SetD3D10Samplers(DxbcProgramType::VertexShader,
+      StartSlot, NumSamplers, ppSamplers);
   }
 
 
@@ -1143,18 +1113,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumBuffers,
           ID3D10Buffer* const*              ppConstantBuffers) {
-    ID3D11Buffer* d3d11Buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
-
-    if (NumBuffers > D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumBuffers; i++) {
-      d3d11Buffers[i] = ppConstantBuffers && ppConstantBuffers[i]
-        ? static_cast<D3D10Buffer*>(ppConstantBuffers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->GSSetConstantBuffers(StartSlot, NumBuffers, d3d11Buffers);
+    m_context->SetD3D10ConstantBuffers(DxbcProgramType::GeometryShader,
+      StartSlot, NumBuffers, ppConstantBuffers);
   }
 
 
@@ -1162,18 +1122,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumViews,
           ID3D10ShaderResourceView* const*  ppShaderResourceViews) {
-    ID3D11ShaderResourceView* d3d11Views[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
-
-    if (NumViews > D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumViews; i++) {
-      d3d11Views[i] = ppShaderResourceViews && ppShaderResourceViews[i]
-        ? static_cast<D3D10ShaderResourceView*>(ppShaderResourceViews[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->GSSetShaderResources(StartSlot, NumViews, d3d11Views);
+    m_context->SetD3D10ShaderResources(DxbcProgramType::GeometryShader,
+      StartSlot, NumViews, ppShaderResourceViews);
   }
 
 
@@ -1181,18 +1131,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumSamplers,
           ID3D10SamplerState* const*        ppSamplers) {
-    ID3D11SamplerState* d3d11Samplers[D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT];
-
-    if (NumSamplers > D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumSamplers; i++) {
-      d3d11Samplers[i] = ppSamplers && ppSamplers[i]
-        ? static_cast<D3D10SamplerState*>(ppSamplers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->GSSetSamplers(StartSlot, NumSamplers, d3d11Samplers);
+    m_context->SetD3D10Samplers(DxbcProgramType::GeometryShader,
+      StartSlot, NumSamplers, ppSamplers);
   }
 
 
@@ -1263,18 +1203,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumBuffers,
           ID3D10Buffer* const*              ppConstantBuffers) {
-    ID3D11Buffer* d3d11Buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
-
-    if (NumBuffers > D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumBuffers; i++) {
-      d3d11Buffers[i] = ppConstantBuffers && ppConstantBuffers[i]
-        ? static_cast<D3D10Buffer*>(ppConstantBuffers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->PSSetConstantBuffers(StartSlot, NumBuffers, d3d11Buffers);
+    m_context->SetD3D10ConstantBuffers(DxbcProgramType::PixelShader,
+      StartSlot, NumBuffers, ppConstantBuffers);
   }
 
 
@@ -1282,18 +1212,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumViews,
           ID3D10ShaderResourceView* const*  ppShaderResourceViews) {
-    ID3D11ShaderResourceView* d3d11Views[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
-
-    if (NumViews > D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumViews; i++) {
-      d3d11Views[i] = ppShaderResourceViews && ppShaderResourceViews[i]
-        ? static_cast<D3D10ShaderResourceView*>(ppShaderResourceViews[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->PSSetShaderResources(StartSlot, NumViews, d3d11Views);
+    m_context->SetD3D10ShaderResources(DxbcProgramType::PixelShader,
+      StartSlot, NumViews, ppShaderResourceViews);
   }
 
 
@@ -1301,18 +1221,8 @@ namespace dxvk {
           UINT                              StartSlot,
           UINT                              NumSamplers,
           ID3D10SamplerState* const*        ppSamplers) {
-    ID3D11SamplerState* d3d11Samplers[D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT];
-
-    if (NumSamplers > D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
-      return;
-
-    for (uint32_t i = 0; i < NumSamplers; i++) {
-      d3d11Samplers[i] = ppSamplers && ppSamplers[i]
-        ? static_cast<D3D10SamplerState*>(ppSamplers[i])->GetD3D11Iface()
-        : nullptr;
-    }
-
-    m_context->PSSetSamplers(StartSlot, NumSamplers, d3d11Samplers);
+    m_context->SetD3D10Samplers(DxbcProgramType::PixelShader,
+      StartSlot, NumSamplers, ppSamplers);
   }
 
 
@@ -36,7 +36,17 @@ namespace dxvk {
           ID3D10Device*             pDevice,
     const D3D10_STATE_BLOCK_MASK*   pMask)
   : m_device(pDevice), m_mask(*pMask) {
-
+    m_vsSsoRanges = ComputeRanges(m_mask.VSSamplers,        D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT);
+    m_vsSrvRanges = ComputeRanges(m_mask.VSShaderResources, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+    m_vsCboRanges = ComputeRanges(m_mask.VSConstantBuffers, D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+    m_gsSsoRanges = ComputeRanges(m_mask.GSSamplers,        D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT);
+    m_gsSrvRanges = ComputeRanges(m_mask.GSShaderResources, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+    m_gsCboRanges = ComputeRanges(m_mask.GSConstantBuffers, D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+    m_psSsoRanges = ComputeRanges(m_mask.PSSamplers,        D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT);
+    m_psSrvRanges = ComputeRanges(m_mask.PSShaderResources, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+    m_psCboRanges = ComputeRanges(m_mask.PSConstantBuffers, D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+
+    m_iaVertexBufferRanges = ComputeRanges(m_mask.IAVertexBuffers, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
   }
 
   
@@ -66,65 +76,79 @@ namespace dxvk {
 
 
   HRESULT STDMETHODCALLTYPE D3D10StateBlock::Capture() {
-    m_state = D3D10_STATE_BLOCK_STATE();
-
-    if (TestBit(&m_mask.VS, 0)) m_device->VSGetShader(&m_state.vs);
-    if (TestBit(&m_mask.GS, 0)) m_device->GSGetShader(&m_state.gs);
-    if (TestBit(&m_mask.PS, 0)) m_device->PSGetShader(&m_state.ps);
-    
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSSamplers, i)) m_device->VSGetSamplers(i, 1, &m_state.vsSso[i]);
-      if (TestBit(m_mask.GSSamplers, i)) m_device->GSGetSamplers(i, 1, &m_state.gsSso[i]);
-      if (TestBit(m_mask.PSSamplers, i)) m_device->PSGetSamplers(i, 1, &m_state.psSso[i]);
+    // Getters overwrite the pointers without releasing previously
+    // captured objects, so release everything we are about to
+    // capture. Objects outside the mask are never captured.
+    if (TestBit(&m_mask.VS, 0)) {
+      m_state.vs = nullptr;
+      m_device->VSGetShader(&m_state.vs);
     }
-    
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSShaderResources, i)) m_device->VSGetShaderResources(i, 1, &m_state.vsSrv[i]);
-      if (TestBit(m_mask.GSShaderResources, i)) m_device->GSGetShaderResources(i, 1, &m_state.gsSrv[i]);
-      if (TestBit(m_mask.PSShaderResources, i)) m_device->PSGetShaderResources(i, 1, &m_state.psSrv[i]);
+
+    if (TestBit(&m_mask.GS, 0)) {
+      m_state.gs = nullptr;
+      m_device->GSGetShader(&m_state.gs);
     }
-    
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSConstantBuffers, i)) m_device->VSGetConstantBuffers(i, 1, &m_state.vsCbo[i]);
-      if (TestBit(m_mask.GSConstantBuffers, i)) m_device->GSGetConstantBuffers(i, 1, &m_state.gsCbo[i]);
-      if (TestBit(m_mask.PSConstantBuffers, i)) m_device->PSGetConstantBuffers(i, 1, &m_state.psCbo[i]);
+
+    if (TestBit(&m_mask.PS, 0)) {
+      m_state.ps = nullptr;
+      m_device->PSGetShader(&m_state.ps);
     }
 
-    for (uint32_t i = 0; i < D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.IAVertexBuffers, i)) {
-        m_device->IAGetVertexBuffers(i, 1,
-          &m_state.iaVertexBuffers[i],
-          &m_state.iaVertexOffsets[i],
-          &m_state.iaVertexStrides[i]);
-      }
+    CaptureRanges(m_vsSsoRanges, m_state.vsSso, &ID3D10Device::VSGetSamplers);
+    CaptureRanges(m_vsSrvRanges, m_state.vsSrv, &ID3D10Device::VSGetShaderResources);
+    CaptureRanges(m_vsCboRanges, m_state.vsCbo, &ID3D10Device::VSGetConstantBuffers);
+    CaptureRanges(m_gsSsoRanges, m_state.gsSso, &ID3D10Device::GSGetSamplers);
+    CaptureRanges(m_gsSrvRanges, m_state.gsSrv, &ID3D10Device::GSGetShaderResources);
+    CaptureRanges(m_gsCboRanges, m_state.gsCbo, &ID3D10Device::GSGetConstantBuffers);
+    CaptureRanges(m_psSsoRanges, m_state.psSso, &ID3D10Device::PSGetSamplers);
+    CaptureRanges(m_psSrvRanges, m_state.psSrv, &ID3D10Device::PSGetShaderResources);
+    CaptureRanges(m_psCboRanges, m_state.psCbo, &ID3D10Device::PSGetConstantBuffers);
+
+    for (const auto& range : m_iaVertexBufferRanges) {
+      for (uint32_t i = 0; i < range.NumSlots; i++)
+        m_state.iaVertexBuffers[range.StartSlot + i] = nullptr;
+
+      m_device->IAGetVertexBuffers(range.StartSlot, range.NumSlots,
+        &m_state.iaVertexBuffers[range.StartSlot],
+        &m_state.iaVertexOffsets[range.StartSlot],
+        &m_state.iaVertexStrides[range.StartSlot]);
     }
 
     if (TestBit(&m_mask.IAIndexBuffer, 0)) {
+      m_state.iaIndexBuffer = nullptr;
       m_device->IAGetIndexBuffer(
         &m_state.iaIndexBuffer,
         &m_state.iaIndexFormat,
         &m_state.iaIndexOffset);
     }
 
-    if (TestBit(&m_mask.IAInputLayout, 0))
+    if (TestBit(&m_mask.IAInputLayout, 0)) {
+      m_state.iaInputLayout = nullptr;
       m_device->IAGetInputLayout(&m_state.iaInputLayout);
+    }
     
     if (TestBit(&m_mask.IAPrimitiveTopology, 0))
       m_device->IAGetPrimitiveTopology(&m_state.iaTopology);
     
     if (TestBit(&m_mask.OMRenderTargets, 0)) {
+      for (auto& rtv : m_state.omRtv)
+        rtv = nullptr;
+
+      m_state.omDsv = nullptr;
       m_device->OMGetRenderTargets(
         D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT,
         &m_state.omRtv[0], &m_state.omDsv);
     }
 
     if (TestBit(&m_mask.OMDepthStencilState, 0)) {
+      m_state.omDepthStencilState = nullptr;
       m_device->OMGetDepthStencilState(
         &m_state.omDepthStencilState,
         &m_state.omStencilRef);
     }
     
     if (TestBit(&m_mask.OMBlendState, 0)) {
+      m_state.omBlendState = nullptr;
       m_device->OMGetBlendState(
         &m_state.omBlendState,
          m_state.omBlendFactor,
@@ -141,18 +165,25 @@ namespace dxvk {
       m_device->RSGetScissorRects(&m_state.rsScissorCount, m_state.rsScissors);
     }
 
-    if (TestBit(&m_mask.RSRasterizerState, 0))
+    if (TestBit(&m_mask.RSRasterizerState, 0)) {
+      m_state.rsState = nullptr;
       m_device->RSGetState(&m_state.rsState);
+    }
     
     if (TestBit(&m_mask.SOBuffers, 0)) {
+      for (auto& so : m_state.soBuffers)
+        so = nullptr;
+
       m_device->SOGetTargets(
         D3D10_SO_BUFFER_SLOT_COUNT,
         &m_state.soBuffers[0],
         &m_state.soOffsets[0]);
     }
 
-    if (TestBit(&m_mask.Predication, 0))
+    if (TestBit(&m_mask.Predication, 0)) {
+      m_state.predicate = nullptr;
       m_device->GetPredication(&m_state.predicate, &m_state.predicateInvert);
+    }
 
     return S_OK;
   }
@@ -163,33 +194,22 @@ namespace dxvk {
     if (TestBit(&m_mask.GS, 0)) m_device->GSSetShader(m_state.gs.ptr());
     if (TestBit(&m_mask.PS, 0)) m_device->PSSetShader(m_state.ps.ptr());
     
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSSamplers, i)) m_device->VSSetSamplers(i, 1, &m_state.vsSso[i]);
-      if (TestBit(m_mask.GSSamplers, i)) m_device->GSSetSamplers(i, 1, &m_state.gsSso[i]);
-      if (TestBit(m_mask.PSSamplers, i)) m_device->PSSetSamplers(i, 1, &m_state.psSso[i]);
-    }
-    
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSShaderResources, i)) m_device->VSSetShaderResources(i, 1, &m_state.vsSrv[i]);
-      if (TestBit(m_mask.GSShaderResources, i)) m_device->GSSetShaderResources(i, 1, &m_state.gsSrv[i]);
-      if (TestBit(m_mask.PSShaderResources, i)) m_device->PSSetShaderResources(i, 1, &m_state.psSrv[i]);
-    }
-    
-    for (uint32_t i = 0; i < D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.VSConstantBuffers, i)) m_device->VSSetConstantBuffers(i, 1, &m_state.vsCbo[i]);
-      if (TestBit(m_mask.GSConstantBuffers, i)) m_device->GSSetConstantBuffers(i, 1, &m_state.gsCbo[i]);
-      if (TestBit(m_mask.PSConstantBuffers, i)) m_device->PSSetConstantBuffers(i, 1, &m_state.psCbo[i]);
+    ApplyRanges(m_vsSsoRanges, m_state.vsSso, &ID3D10Device::VSSetSamplers);
+    ApplyRanges(m_vsSrvRanges, m_state.vsSrv, &ID3D10Device::VSSetShaderResources);
+    ApplyRanges(m_vsCboRanges, m_state.vsCbo, &ID3D10Device::VSSetConstantBuffers);
+    ApplyRanges(m_gsSsoRanges, m_state.gsSso, &ID3D10Device::GSSetSamplers);
+    ApplyRanges(m_gsSrvRanges, m_state.gsSrv, &ID3D10Device::GSSetShaderResources);
+    ApplyRanges(m_gsCboRanges, m_state.gsCbo, &ID3D10Device::GSSetConstantBuffers);
+    ApplyRanges(m_psSsoRanges, m_state.psSso, &ID3D10Device::PSSetSamplers);
+    ApplyRanges(m_psSrvRanges, m_state.psSrv, &ID3D10Device::PSSetShaderResources);
+    ApplyRanges(m_psCboRanges, m_state.psCbo, &ID3D10Device::PSSetConstantBuffers);
+
+    for (const auto& range : m_iaVertexBufferRanges) {
+      m_device->IASetVertexBuffers(range.StartSlot, range.NumSlots,
+        &m_state.iaVertexBuffers[range.StartSlot],
+        &m_state.iaVertexOffsets[range.StartSlot],
+        &m_state.iaVertexStrides[range.StartSlot]);
     }
-
-    for (uint32_t i = 0; i < D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; i++) {
-      if (TestBit(m_mask.IAVertexBuffers, i)) {
-        m_device->IASetVertexBuffers(i, 1,
-          &m_state.iaVertexBuffers[i],
-          &m_state.iaVertexOffsets[i],
-          &m_state.iaVertexStrides[i]);
-      }
-    }
-
     if (TestBit(&m_mask.IAIndexBuffer, 0)) {
       m_device->IASetIndexBuffer(
         m_state.iaIndexBuffer.ptr(),
@@ -259,6 +279,49 @@ namespace dxvk {
   }
 
 
+  template<typename T, typename Fn>
+  void D3D10StateBlock::CaptureRanges(
+    const D3D10_STATE_BLOCK_RANGES& Ranges,
+          Com<T>*                   pObjects,
+          Fn                        Method) {
+    for (const auto& range : Ranges) {
+      for (uint32_t i = 0; i < range.NumSlots; i++)
+        pObjects[range.StartSlot + i] = nullptr;
+
+      (m_device.ptr()->*Method)(range.StartSlot, range.NumSlots, &pObjects[range.StartSlot]);
+    }
+  }
+
+
+  template<typename T, typename Fn>
+  void D3D10StateBlock::ApplyRanges(
+    const D3D10_STATE_BLOCK_RANGES& Ranges,
+          Com<T>*                   pObjects,
+          Fn                        Method) {
+    for (const auto& range : Ranges)
+      (m_device.ptr()->*Method)(range.StartSlot, range.NumSlots, &pObjects[range.StartSlot]);
+  }
+
+
+  D3D10_STATE_BLOCK_RANGES D3D10StateBlock::ComputeRanges(
+    const BYTE*                     pMask,
+          UINT                      Count) {
+    D3D10_STATE_BLOCK_RANGES result;
+
+    for (uint32_t i = 0; i < Count; i++) {
+      if (!TestBit(pMask, i))
+        continue;
+
+      if (!result.empty() && result.back().StartSlot + result.back().NumSlots == i)
+        result.back().NumSlots += 1;
+      else
+        result.push_back({ i, 1u });
+    }
+
+    return result;
+  }
+
+
   BOOL D3D10StateBlock::TestBit(
     const BYTE*                     pMask,
           UINT                      Idx) {
@@ -5,6 +5,19 @@
 
 namespace dxvk {
 
+  /**
+   * \brief Range of consecutive slots in a state block mask
+   *
+   * Lets the state block capture and apply slot arrays
+   * with one call per range rather than one per slot.
+   */
+  struct D3D10_STATE_BLOCK_RANGE {
+    UINT StartSlot;
+    UINT NumSlots;
+  };
+
+  using D3D10_STATE_BLOCK_RANGES = std::vector<D3D10_STATE_BLOCK_RANGE>;
+
   struct D3D10_STATE_BLOCK_STATE {
     Com<ID3D10VertexShader>       vs                  = { };
     Com<ID3D10SamplerState>       vsSso[D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT]              = { };
@@ -73,6 +86,33 @@ namespace dxvk {
     D3D10_STATE_BLOCK_MASK  m_mask;
     D3D10_STATE_BLOCK_STATE m_state;
 
+    D3D10_STATE_BLOCK_RANGES m_vsSsoRanges;
+    D3D10_STATE_BLOCK_RANGES m_vsSrvRanges;
+    D3D10_STATE_BLOCK_RANGES m_vsCboRanges;
+    D3D10_STATE_BLOCK_RANGES m_gsSsoRanges;
+    D3D10_STATE_BLOCK_RANGES m_gsSrvRanges;
+    D3D10_STATE_BLOCK_RANGES m_gsCboRanges;
+    D3D10_STATE_BLOCK_RANGES m_psSsoRanges;
+    D3D10_STATE_BLOCK_RANGES m_psSrvRanges;
+    D3D10_STATE_BLOCK_RANGES m_psCboRanges;
+    D3D10_STATE_BLOCK_RANGES m_iaVertexBufferRanges;
+
+    template<typename T, typename Fn>
+    void CaptureRanges(
+      const D3D10_STATE_BLOCK_RANGES& Ranges,
+            Com<T>*                   pObjects,
+            Fn                        Method);
+
+    template<typename T, typename Fn>
+    void ApplyRanges(
+      const D3D10_STATE_BLOCK_RANGES& Ranges,
+            Com<T>*                   pObjects,
+            Fn                        Method);
+
+    static D3D10_STATE_BLOCK_RANGES ComputeRanges(
+      const BYTE*                     pMask,
+            UINT                      Count);
+
     static BOOL TestBit(
       const BYTE*                     pMask,
             UINT                      Idx);
@@ -74,6 +74,11 @@ namespace dxvk {
 
     D3D10DeviceLock lock = m_container->LockContext();
 
+    DxvkGpuProfiler& profiler = m_container->m_device->getGpuProfiler();
+
+    if (unlikely(profiler.isCpuProfilingEnabled()))
+      m_cpuScopes.push_back(profiler.beginCpuScope(dxvk::str::fromws(Name)));
+
     m_container->EmitCs([color = Color, labelName = dxvk::str::fromws(Name)](DxvkContext *ctx) {
       VkDebugUtilsLabelEXT label;
       label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
@@ -98,6 +103,12 @@ namespace dxvk {
       ctx->endDebugLabel();
     });
 
+    if (unlikely(!m_cpuScopes.empty())) {
+      m_container->m_device->getGpuProfiler().endCpuScope(
+        m_cpuScopes.back(), DxvkCpuProfilerTrack::AppThread);
+      m_cpuScopes.pop_back();
+    }
+
     return m_eventDepth--;
   }
 
@@ -2,6 +2,9 @@
 
 #include "d3d11_include.h"
 #include "../dxvk/dxvk_annotation.h"
+#include "../dxvk/dxvk_gpu_profiler.h"
+
+#include <vector>
 
 namespace dxvk {
 
@@ -41,6 +44,9 @@ namespace dxvk {
 
     // Stack depth for non-finalized BeginEvent calls
     int32_t m_eventDepth;
+
+    // CPU scopes for non-finalized BeginEvent calls
+    std::vector<DxvkCpuProfilerScope> m_cpuScopes;
   };
 
 }
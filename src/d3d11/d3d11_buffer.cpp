@@ -83,7 +83,9 @@ namespace dxvk {
   
   
   D3D11Buffer::~D3D11Buffer() {
-
+    // Applications may create identical buffers every frame,
+    // let the device hand this one out again once it is idle
+    m_parent->GetDXVKDevice()->recycleBuffer(std::move(m_buffer));
   }
   
   
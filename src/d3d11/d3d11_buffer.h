@@ -38,6 +38,7 @@ namespace dxvk {
   
   class D3D11Buffer : public D3D11DeviceChild<ID3D11Buffer> {
     static constexpr VkDeviceSize BufferSliceAlignment = 64;
+    static constexpr uint32_t     CachedMemoryReadCount = 4;
   public:
     
     D3D11Buffer(
@@ -114,6 +115,19 @@ namespace dxvk {
       return m_mapped;
     }
 
+    /**
+     * \brief Tracks a CPU read from mapped memory
+     *
+     * Reading from write-combined memory is extremely slow,
+     * so buffers that get read back repeatedly should be
+     * moved to cached memory.
+     * \returns \c true if the buffer should be moved
+     */
+    bool TrackCpuRead() {
+      return !(m_buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+          && ++m_cpuReadCount == CachedMemoryReadCount;
+    }
+
     D3D10Buffer* GetD3D10Iface() {
       return &m_d3d10;
     }
@@ -151,6 +165,7 @@ namespace dxvk {
     Rc<DxvkBuffer>                m_soCounter;
     DxvkBufferSliceHandle         m_mapped;
     uint64_t                      m_seq = 0ull;
+    uint32_t                      m_cpuReadCount = 0u;
 
     D3D11DXGIResource             m_resource;
     D3D10Buffer                   m_d3d10;
@@ -13,6 +13,8 @@ namespace dxvk {
   enum class D3D11CmdType {
     DrawIndirect,
     DrawIndirectIndexed,
+    DrawIndexed,
+    Draw,
   };
 
 
@@ -40,4 +42,38 @@ namespace dxvk {
     uint32_t            stride;
   };
 
+
+  /**
+   * \brief Indexed draw command data
+   * 
+   * Stores consecutive indexed draws with the same
+   * instance parameters, so that they can be merged
+   * into a single multi-draw.
+   */
+  struct D3D11CmdDrawIndexedData : public D3D11CmdData {
+    constexpr static uint32_t MaxDraws = 8;
+
+    uint32_t            instanceCount;
+    uint32_t            firstInstance;
+    uint32_t            count;
+    VkMultiDrawIndexedInfoEXT draws[MaxDraws];
+  };
+
+
+  /**
+   * \brief Non-indexed draw command data
+   * 
+   * Stores consecutive non-indexed draws with
+   * the same instance parameters, so that they
+   * can be merged into a single multi-draw.
+   */
+  struct D3D11CmdDrawData : public D3D11CmdData {
+    constexpr static uint32_t MaxDraws = 8;
+
+    uint32_t            instanceCount;
+    uint32_t            firstInstance;
+    uint32_t            count;
+    VkMultiDrawInfoEXT  draws[MaxDraws];
+  };
+
 }
\ No newline at end of file
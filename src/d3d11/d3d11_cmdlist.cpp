@@ -41,6 +41,24 @@ namespace dxvk {
   }
   
   
+  void D3D11CommandList::Reserve(
+          size_t              ChunkCount,
+          size_t              ResourceCount) {
+    m_chunks.reserve(ChunkCount);
+    m_resources.reserve(ResourceCount);
+  }
+
+
+  size_t D3D11CommandList::GetChunkCount() const {
+    return m_chunks.size();
+  }
+
+
+  size_t D3D11CommandList::GetResourceCount() const {
+    return m_resources.size();
+  }
+
+
   void D3D11CommandList::AddChunk(DxvkCsChunkRef&& Chunk) {
     m_chunks.push_back(std::move(Chunk));
   }
@@ -53,29 +71,27 @@ namespace dxvk {
 
   void D3D11CommandList::EmitToCommandList(ID3D11CommandList* pCommandList) {
     auto cmdList = static_cast<D3D11CommandList*>(pCommandList);
-    
-    for (const auto& chunk : m_chunks)
-      cmdList->m_chunks.push_back(chunk);
 
-    for (const auto& query : m_queries)
-      cmdList->m_queries.push_back(query);
+    cmdList->m_chunks.insert(cmdList->m_chunks.end(),
+      m_chunks.begin(), m_chunks.end());
 
-    for (const auto& resource : m_resources)
-      cmdList->m_resources.push_back(resource);
+    cmdList->m_queries.insert(cmdList->m_queries.end(),
+      m_queries.begin(), m_queries.end());
+
+    cmdList->m_resources.insert(cmdList->m_resources.end(),
+      m_resources.begin(), m_resources.end());
 
     MarkSubmitted();
   }
   
   
   uint64_t D3D11CommandList::EmitToCsThread(DxvkCsThread* CsThread) {
-    uint64_t seq = 0;
-
     for (const auto& query : m_queries)
       query->DoDeferredEnd();
 
-    for (const auto& chunk : m_chunks)
-      seq = CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
-    
+    uint64_t seq = CsThread->dispatchChunks(
+      m_chunks.data(), m_chunks.size());
+
     for (const auto& resource : m_resources)
       TrackResourceSequenceNumber(resource, seq);
 
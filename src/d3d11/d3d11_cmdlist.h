@@ -20,6 +20,23 @@ namespace dxvk {
     
     UINT STDMETHODCALLTYPE GetContextFlags() final;
     
+    /**
+     * \brief Pre-allocates storage
+     *
+     * Deferred contexts tend to record lists of similar
+     * size every frame, so reserving storage up front
+     * avoids repeated reallocations while recording.
+     * \param [in] ChunkCount Expected number of chunks
+     * \param [in] ResourceCount Expected number of resources
+     */
+    void Reserve(
+            size_t              ChunkCount,
+            size_t              ResourceCount);
+
+    size_t GetChunkCount() const;
+
+    size_t GetResourceCount() const;
+
     void AddChunk(
             DxvkCsChunkRef&&    Chunk);
 
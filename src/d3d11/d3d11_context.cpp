@@ -10,6 +10,38 @@
 
 namespace dxvk {
 
+  /**
+   * \brief Retrieves implementation of a bindable object
+   *
+   * Overloaded so that the binding functions can take both
+   * D3D11 interfaces and the D3D10 wrapper objects, which
+   * store a pointer to the D3D11 object they wrap.
+   */
+  static inline D3D11Buffer* GetCommonObject(ID3D11Buffer* pObject) {
+    return static_cast<D3D11Buffer*>(pObject);
+  }
+
+  static inline D3D11Buffer* GetCommonObject(ID3D10Buffer* pObject) {
+    return pObject ? static_cast<D3D10Buffer*>(pObject)->GetD3D11Iface() : nullptr;
+  }
+
+  static inline D3D11ShaderResourceView* GetCommonObject(ID3D11ShaderResourceView* pObject) {
+    return static_cast<D3D11ShaderResourceView*>(pObject);
+  }
+
+  static inline D3D11ShaderResourceView* GetCommonObject(ID3D10ShaderResourceView* pObject) {
+    return pObject ? static_cast<D3D10ShaderResourceView*>(pObject)->GetD3D11Iface() : nullptr;
+  }
+
+  static inline D3D11SamplerState* GetCommonObject(ID3D11SamplerState* pObject) {
+    return static_cast<D3D11SamplerState*>(pObject);
+  }
+
+  static inline D3D11SamplerState* GetCommonObject(ID3D10SamplerState* pObject) {
+    return pObject ? static_cast<D3D10SamplerState*>(pObject)->GetD3D11Iface() : nullptr;
+  }
+
+
   D3D11DeviceContext::D3D11DeviceContext(
           D3D11Device*            pParent,
     const Rc<DxvkDevice>&         Device,
@@ -878,76 +910,78 @@ namespace dxvk {
     VkClearValue        clearValue  = ConvertColorValue(Color, formatInfo);
     VkImageAspectFlags  clearAspect = formatInfo->aspectMask & (VK_IMAGE_ASPECT_COLOR_BIT | VK_IMAGE_ASPECT_DEPTH_BIT);
 
-    // Clear all the rectangles that are specified
+    // Gather all valid rectangles so that the backend can
+    // clear them in one go, rather than emitting one command
+    // and one set of barriers for each individual rectangle
+    std::vector<DxvkClearRect> rects;
+    rects.reserve(std::max(NumRects, 1u));
+
     for (uint32_t i = 0; i < NumRects || i < 1; i++) {
+      DxvkClearRect rect;
+
       if (pRect) {
         if (pRect[i].left >= pRect[i].right
         || pRect[i].top >= pRect[i].bottom)
           continue;
-      }
-      
-      if (bufView != nullptr) {
-        VkDeviceSize offset = 0;
-        VkDeviceSize length = bufView->info().rangeLength / formatInfo->elementSize;
-
-        if (pRect) {
-          offset = pRect[i].left;
-          length = pRect[i].right - pRect[i].left;
-        }
 
-        EmitCs([
-          cBufferView   = bufView,
-          cRangeOffset  = offset,
-          cRangeLength  = length,
-          cClearValue   = clearValue
-        ] (DxvkContext* ctx) {
-          ctx->clearBufferView(
-            cBufferView,
-            cRangeOffset,
-            cRangeLength,
-            cClearValue.color);
-        });
+        rect.offset = { pRect[i].left, pRect[i].top, 0 };
+        rect.extent = {
+          uint32_t(pRect[i].right - pRect[i].left),
+          uint32_t(pRect[i].bottom - pRect[i].top), 1 };
+      } else if (bufView != nullptr) {
+        rect.offset = { 0, 0, 0 };
+        rect.extent = { uint32_t(bufView->info().rangeLength / formatInfo->elementSize), 1, 1 };
+      } else {
+        rect.offset = { 0, 0, 0 };
+        rect.extent = imgView->mipLevelExtent(0);
       }
 
-      if (imgView != nullptr) {
-        VkOffset3D offset = { 0, 0, 0 };
-        VkExtent3D extent = imgView->mipLevelExtent(0);
+      rects.push_back(rect);
+    }
 
-        if (pRect) {
-          offset = { pRect[i].left, pRect[i].top, 0 };
-          extent = {
-            uint32_t(pRect[i].right - pRect[i].left),
-            uint32_t(pRect[i].bottom - pRect[i].top), 1 };
-        }
-        
-        EmitCs([
-          cImageView    = imgView,
-          cAreaOffset   = offset,
-          cAreaExtent   = extent,
-          cClearAspect  = clearAspect,
-          cClearValue   = clearValue
-        ] (DxvkContext* ctx) {
-          const VkImageUsageFlags rtUsage =
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (rects.empty())
+      return;
 
-          bool isFullSize = cImageView->mipLevelExtent(0) == cAreaExtent;
+    if (bufView != nullptr) {
+      EmitCs([
+        cBufferView   = bufView,
+        cClearRanges  = std::move(rects),
+        cClearValue   = clearValue
+      ] (DxvkContext* ctx) {
+        ctx->clearBufferViewRanges(
+          cBufferView,
+          cClearRanges.size(),
+          cClearRanges.data(),
+          cClearValue.color);
+      });
+    } else if (imgView != nullptr) {
+      EmitCs([
+        cImageView    = imgView,
+        cClearRects   = std::move(rects),
+        cClearAspect  = clearAspect,
+        cClearValue   = clearValue
+      ] (DxvkContext* ctx) {
+        const VkImageUsageFlags rtUsage =
+          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-          if ((cImageView->info().usage & rtUsage) && isFullSize) {
-            ctx->clearRenderTarget(
-              cImageView,
-              cClearAspect,
-              cClearValue);
-          } else {
-            ctx->clearImageView(
-              cImageView,
-              cAreaOffset,
-              cAreaExtent,
-              cClearAspect,
-              cClearValue);
-          }
-        });
-      }
+        bool isFullSize = cClearRects.size() == 1
+          && cImageView->mipLevelExtent(0) == cClearRects[0].extent;
+
+        if ((cImageView->info().usage & rtUsage) && isFullSize) {
+          ctx->clearRenderTarget(
+            cImageView,
+            cClearAspect,
+            cClearValue);
+        } else {
+          ctx->clearImageViewRects(
+            cImageView,
+            cClearRects.size(),
+            cClearRects.data(),
+            cClearAspect,
+            cClearValue);
+        }
+      });
     }
   }
   
@@ -1168,11 +1202,8 @@ namespace dxvk {
           UINT            StartVertexLocation) {
     D3D10DeviceLock lock = LockContext();
 
-    EmitCs([=] (DxvkContext* ctx) {
-      ctx->draw(
-        VertexCount, 1,
-        StartVertexLocation, 0);
-    });
+    EmitDraw(VertexCount, 1,
+      StartVertexLocation, 0);
   }
   
   
@@ -1182,12 +1213,9 @@ namespace dxvk {
           INT             BaseVertexLocation) {
     D3D10DeviceLock lock = LockContext();
     
-    EmitCs([=] (DxvkContext* ctx) {
-      ctx->drawIndexed(
-        IndexCount, 1,
-        StartIndexLocation,
-        BaseVertexLocation, 0);
-    });
+    EmitDrawIndexed(IndexCount, 1,
+      StartIndexLocation,
+      BaseVertexLocation, 0);
   }
   
   
@@ -1198,13 +1226,11 @@ namespace dxvk {
           UINT            StartInstanceLocation) {
     D3D10DeviceLock lock = LockContext();
     
-    EmitCs([=] (DxvkContext* ctx) {
-      ctx->draw(
-        VertexCountPerInstance,
-        InstanceCount,
-        StartVertexLocation,
-        StartInstanceLocation);
-    });
+    EmitDraw(
+      VertexCountPerInstance,
+      InstanceCount,
+      StartVertexLocation,
+      StartInstanceLocation);
   }
   
   
@@ -1216,14 +1242,12 @@ namespace dxvk {
           UINT            StartInstanceLocation) {
     D3D10DeviceLock lock = LockContext();
     
-    EmitCs([=] (DxvkContext* ctx) {
-      ctx->drawIndexed(
-        IndexCountPerInstance,
-        InstanceCount,
-        StartIndexLocation,
-        BaseVertexLocation,
-        StartInstanceLocation);
-    });
+    EmitDrawIndexed(
+      IndexCountPerInstance,
+      InstanceCount,
+      StartIndexLocation,
+      BaseVertexLocation,
+      StartInstanceLocation);
   }
   
   
@@ -1366,6 +1390,8 @@ namespace dxvk {
     const UINT*                             pOffsets) {
     D3D10DeviceLock lock = LockContext();
     
+    D3D11VertexBufferBatch batch;
+
     for (uint32_t i = 0; i < NumBuffers; i++) {
       auto newBuffer = static_cast<D3D11Buffer*>(ppVertexBuffers[i]);
       bool needsUpdate = m_state.ia.vertexBuffers[StartSlot + i].buffer != newBuffer;
@@ -1380,9 +1406,11 @@ namespace dxvk {
         m_state.ia.vertexBuffers[StartSlot + i].offset = pOffsets[i];
         m_state.ia.vertexBuffers[StartSlot + i].stride = pStrides[i];
 
-        BindVertexBuffer(StartSlot + i, newBuffer, pOffsets[i], pStrides[i]);
+        AddVertexBuffer(batch, StartSlot + i, newBuffer, pOffsets[i], pStrides[i]);
       }
     }
+
+    BindVertexBuffers(batch);
   }
   
   
@@ -2821,7 +2849,8 @@ namespace dxvk {
 
 
   BOOL STDMETHODCALLTYPE D3D11DeviceContext::IsAnnotationEnabled() {
-    return m_device->instance()->extensions().extDebugUtils;
+    return m_device->instance()->extensions().extDebugUtils
+        || m_device->getGpuProfiler().isEnabled();
   }
 
 
@@ -2894,17 +2923,143 @@ namespace dxvk {
   }
   
   
+  void D3D11DeviceContext::SetD3D10ConstantBuffers(
+          DxbcProgramType                   ShaderStage,
+          UINT                              StartSlot,
+          UINT                              NumBuffers,
+          ID3D10Buffer* const*              ppConstantBuffers) {
+    D3D10DeviceLock lock = LockContext();
+
+    std::array<ID3D10Buffer*, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> nullObjects;
+
+    if (unlikely(NumBuffers > nullObjects.size()))
+      return;
+
+    if (unlikely(!ppConstantBuffers)) {
+      nullObjects.fill(nullptr);
+      ppConstantBuffers = nullObjects.data();
+    }
+
+    switch (ShaderStage) {
+      case DxbcProgramType::VertexShader:
+        SetConstantBuffers<DxbcProgramType::VertexShader>(
+          m_state.vs.constantBuffers,
+          StartSlot, NumBuffers, ppConstantBuffers);
+        break;
+
+      case DxbcProgramType::GeometryShader:
+        SetConstantBuffers<DxbcProgramType::GeometryShader>(
+          m_state.gs.constantBuffers,
+          StartSlot, NumBuffers, ppConstantBuffers);
+        break;
+
+      case DxbcProgramType::PixelShader:
+        SetConstantBuffers<DxbcProgramType::PixelShader>(
+          m_state.ps.constantBuffers,
+          StartSlot, NumBuffers, ppConstantBuffers);
+        break;
+
+      default:
+        Logger::err(str::format("D3D11: Invalid D3D10 shader stage: ", uint32_t(ShaderStage)));
+    }
+  }
+
+
+  void D3D11DeviceContext::SetD3D10ShaderResources(
+          DxbcProgramType                   ShaderStage,
+          UINT                              StartSlot,
+          UINT                              NumViews,
+          ID3D10ShaderResourceView* const*  ppShaderResourceViews) {
+    D3D10DeviceLock lock = LockContext();
+
+    std::array<ID3D10ShaderResourceView*, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> nullObjects;
+
+    if (unlikely(NumViews > nullObjects.size()))
+      return;
+
+    if (unlikely(!ppShaderResourceViews)) {
+      nullObjects.fill(nullptr);
+      ppShaderResourceViews = nullObjects.data();
+    }
+
+    switch (ShaderStage) {
+      case DxbcProgramType::VertexShader:
+        SetShaderResources<DxbcProgramType::VertexShader>(
+          m_state.vs.shaderResources,
+          StartSlot, NumViews, ppShaderResourceViews);
+        break;
+
+      case DxbcProgramType::GeometryShader:
+        SetShaderResources<DxbcProgramType::GeometryShader>(
+          m_state.gs.shaderResources,
+          StartSlot, NumViews, ppShaderResourceViews);
+        break;
+
+      case DxbcProgramType::PixelShader:
+        SetShaderResources<DxbcProgramType::PixelShader>(
+          m_state.ps.shaderResources,
+          StartSlot, NumViews, ppShaderResourceViews);
+        break;
+
+      default:
+        Logger::err(str::format("D3D11: Invalid D3D10 shader stage: ", uint32_t(ShaderStage)));
+    }
+  }
+
+
+  void D3D11DeviceContext::SetD3D10Samplers(
+          DxbcProgramType                   ShaderStage,
+          UINT                              StartSlot,
+          UINT                              NumSamplers,
+          ID3D10SamplerState* const*        ppSamplers) {
+    D3D10DeviceLock lock = LockContext();
+
+    std::array<ID3D10SamplerState*, D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT> nullObjects;
+
+    if (unlikely(NumSamplers > nullObjects.size()))
+      return;
+
+    if (unlikely(!ppSamplers)) {
+      nullObjects.fill(nullptr);
+      ppSamplers = nullObjects.data();
+    }
+
+    switch (ShaderStage) {
+      case DxbcProgramType::VertexShader:
+        SetSamplers<DxbcProgramType::VertexShader>(
+          m_state.vs.samplers,
+          StartSlot, NumSamplers, ppSamplers);
+        break;
+
+      case DxbcProgramType::GeometryShader:
+        SetSamplers<DxbcProgramType::GeometryShader>(
+          m_state.gs.samplers,
+          StartSlot, NumSamplers, ppSamplers);
+        break;
+
+      case DxbcProgramType::PixelShader:
+        SetSamplers<DxbcProgramType::PixelShader>(
+          m_state.ps.samplers,
+          StartSlot, NumSamplers, ppSamplers);
+        break;
+
+      default:
+        Logger::err(str::format("D3D11: Invalid D3D10 shader stage: ", uint32_t(ShaderStage)));
+    }
+  }
+
+
   void D3D11DeviceContext::ApplyInputLayout() {
     auto inputLayout = m_state.ia.inputLayout.prvRef();
 
     if (likely(inputLayout != nullptr)) {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::InputLayout, [
         cInputLayout = std::move(inputLayout)
       ] (DxvkContext* ctx) {
         cInputLayout->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(D3D11CsStateKey::InputLayout, [] (DxvkContext* ctx) {
         ctx->setInputLayout(0, nullptr, 0, nullptr);
       });
     }
@@ -2938,7 +3093,7 @@ namespace dxvk {
       iaState = { VK_PRIMITIVE_TOPOLOGY_PATCH_LIST, VK_FALSE, vertexCount };
     }
     
-    EmitCs([iaState] (DxvkContext* ctx) {
+    EmitCsState(D3D11CsStateKey::PrimitiveTopology, [iaState] (DxvkContext* ctx) {
       ctx->setInputAssemblyState(iaState);
     });
   }
@@ -2946,14 +3101,14 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyBlendState() {
     if (m_state.om.cbState != nullptr) {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::BlendState, [
         cBlendState = m_state.om.cbState,
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         cBlendState->BindToContext(ctx, cSampleMask);
       });
     } else {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::BlendState, [
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         DxvkBlendMode cbState;
@@ -2972,7 +3127,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyBlendFactor() {
-    EmitCs([
+    EmitCsState(D3D11CsStateKey::BlendFactor, [
       cBlendConstants = DxvkBlendConstants {
         m_state.om.blendFactor[0], m_state.om.blendFactor[1],
         m_state.om.blendFactor[2], m_state.om.blendFactor[3] }
@@ -2984,13 +3139,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyDepthStencilState() {
     if (m_state.om.dsState != nullptr) {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::DepthStencilState, [
         cDepthStencilState = m_state.om.dsState
       ] (DxvkContext* ctx) {
         cDepthStencilState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(D3D11CsStateKey::DepthStencilState, [] (DxvkContext* ctx) {
         DxvkDepthStencilState dsState;
         InitDefaultDepthStencilState(&dsState);
 
@@ -3001,7 +3156,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyStencilRef() {
-    EmitCs([
+    EmitCsState(D3D11CsStateKey::StencilRef, [
       cStencilRef = m_state.om.stencilRef
     ] (DxvkContext* ctx) {
       ctx->setStencilReference(cStencilRef);
@@ -3011,13 +3166,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyRasterizerState() {
     if (m_state.rs.state != nullptr) {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::RasterizerState, [
         cRasterizerState = m_state.rs.state
       ] (DxvkContext* ctx) {
         cRasterizerState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(D3D11CsStateKey::RasterizerState, [] (DxvkContext* ctx) {
         DxvkRasterizerState rsState;
         InitDefaultRasterizerState(&rsState);
 
@@ -3115,7 +3270,7 @@ namespace dxvk {
     }
     
     if (likely(viewportCount == 1)) {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::ViewportState, [
         cViewport = viewports[0],
         cScissor  = scissors[0]
       ] (DxvkContext* ctx) {
@@ -3124,7 +3279,7 @@ namespace dxvk {
           &cScissor);
       });
     } else {
-      EmitCs([
+      EmitCsState(D3D11CsStateKey::ViewportState, [
         cViewportCount = viewportCount,
         cViewports     = viewports,
         cScissors      = scissors
@@ -3142,7 +3297,9 @@ namespace dxvk {
   void D3D11DeviceContext::BindShader(
     const D3D11CommonShader*    pShaderModule) {
     // Bind the shader and the ICB at once
-    EmitCs([
+    auto key = D3D11CsStateKey(uint32_t(D3D11CsStateKey::Shader) + uint32_t(ShaderStage));
+
+    EmitCsState(key, [
       cSlice  = pShaderModule           != nullptr
              && pShaderModule->GetIcb() != nullptr
         ? DxvkBufferSlice(pShaderModule->GetIcb())
@@ -3212,26 +3369,37 @@ namespace dxvk {
   }
 
 
-  void D3D11DeviceContext::BindVertexBuffer(
+  void D3D11DeviceContext::BindVertexBuffers(
+          D3D11VertexBufferBatch&           Batch) {
+    if (!Batch.count)
+      return;
+
+    EmitCs([
+      cBatch = std::move(Batch)
+    ] (DxvkContext* ctx) {
+      for (uint32_t i = 0; i < cBatch.count; i++) {
+        const auto& bind = cBatch.bindings[i];
+        ctx->bindVertexBuffer(bind.slot, bind.slice, bind.stride);
+      }
+    });
+
+    Batch.count = 0;
+  }
+  
+  
+  void D3D11DeviceContext::AddVertexBuffer(
+          D3D11VertexBufferBatch&           Batch,
           UINT                              Slot,
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Stride) {
-    if (likely(pBuffer != nullptr)) {
-      EmitCs([
-        cSlotId       = Slot,
-        cBufferSlice  = pBuffer->GetBufferSlice(Offset),
-        cStride       = Stride
-      ] (DxvkContext* ctx) {
-        ctx->bindVertexBuffer(cSlotId, cBufferSlice, cStride);
-      });
-    } else {
-      EmitCs([
-        cSlotId       = Slot
-      ] (DxvkContext* ctx) {
-        ctx->bindVertexBuffer(cSlotId, DxvkBufferSlice(), 0);
-      });
-    }
+    auto& bind = Batch.add();
+    bind.slot   = Slot;
+    bind.stride = pBuffer != nullptr ? Stride : 0;
+    bind.slice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice();
+
+    if (Batch.full())
+      BindVertexBuffers(Batch);
   }
   
   
@@ -3243,7 +3411,7 @@ namespace dxvk {
       ? VK_INDEX_TYPE_UINT16
       : VK_INDEX_TYPE_UINT32;
     
-    EmitCs([
+    EmitCsState(D3D11CsStateKey::IndexBuffer, [
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
       cIndexType    = indexType
     ] (DxvkContext* ctx) {
@@ -3284,18 +3452,39 @@ namespace dxvk {
 
 
   template<DxbcProgramType ShaderStage>
-  void D3D11DeviceContext::BindConstantBuffer(
-          UINT                              Slot,
-          D3D11Buffer*                      pBuffer,
-          UINT                              Offset,
-          UINT                              Length) {
+  void D3D11DeviceContext::BindConstantBuffers(
+          D3D11ConstantBufferBatch&         Batch) {
+    if (!Batch.count)
+      return;
+
     EmitCs([
-      cSlotId      = Slot,
-      cBufferSlice = Length ? pBuffer->GetBufferSlice(16 * Offset, 16 * Length) : DxvkBufferSlice()
+      cBatch = std::move(Batch)
     ] (DxvkContext* ctx) {
       VkShaderStageFlagBits stage = GetShaderStage(ShaderStage);
-      ctx->bindResourceBuffer(stage, cSlotId, cBufferSlice);
+
+      for (uint32_t i = 0; i < cBatch.count; i++) {
+        const auto& bind = cBatch.bindings[i];
+        ctx->bindResourceBuffer(stage, bind.slot, bind.slice);
+      }
     });
+
+    Batch.count = 0;
+  }
+  
+  
+  template<DxbcProgramType ShaderStage>
+  void D3D11DeviceContext::AddConstantBuffer(
+          D3D11ConstantBufferBatch&         Batch,
+          UINT                              Slot,
+          D3D11Buffer*                      pBuffer,
+          UINT                              Offset,
+          UINT                              Length) {
+    auto& bind = Batch.add();
+    bind.slot  = Slot;
+    bind.slice = Length ? pBuffer->GetBufferSlice(16 * Offset, 16 * Length) : DxvkBufferSlice();
+
+    if (Batch.full())
+      BindConstantBuffers<ShaderStage>(Batch);
   }
   
   
@@ -3328,6 +3517,42 @@ namespace dxvk {
   }
   
   
+  template<DxbcProgramType ShaderStage>
+  void D3D11DeviceContext::BindShaderResources(
+          D3D11ShaderResourceBatch&         Batch) {
+    if (!Batch.count)
+      return;
+
+    EmitCs([
+      cBatch = std::move(Batch)
+    ] (DxvkContext* ctx) {
+      VkShaderStageFlagBits stage = GetShaderStage(ShaderStage);
+
+      for (uint32_t i = 0; i < cBatch.count; i++) {
+        const auto& bind = cBatch.bindings[i];
+        ctx->bindResourceView(stage, bind.slot, bind.imageView, bind.bufferView);
+      }
+    });
+
+    Batch.count = 0;
+  }
+  
+  
+  template<DxbcProgramType ShaderStage>
+  void D3D11DeviceContext::AddShaderResource(
+          D3D11ShaderResourceBatch&         Batch,
+          UINT                              Slot,
+          D3D11ShaderResourceView*          pResource) {
+    auto& bind = Batch.add();
+    bind.slot       = Slot;
+    bind.imageView  = pResource != nullptr ? pResource->GetImageView()  : nullptr;
+    bind.bufferView = pResource != nullptr ? pResource->GetBufferView() : nullptr;
+
+    if (Batch.full())
+      BindShaderResources<ShaderStage>(Batch);
+  }
+  
+  
   template<DxbcProgramType ShaderStage>
   void D3D11DeviceContext::BindUnorderedAccessView(
           UINT                              UavSlot,
@@ -3425,6 +3650,12 @@ namespace dxvk {
       Logger::err("D3D11: CopyImage: Incompatible sample count");
       return;
     }
+
+    // Transient depth buffers have no memory to copy from or to
+    if (pDstTexture->IsTransient() || pSrcTexture->IsTransient()) {
+      Logger::err("D3D11: CopyImage: Cannot copy transient depth buffer");
+      return;
+    }
     
     // Obviously, the copy region must not be empty
     VkExtent3D dstMipExtent = pDstTexture->MipLevelExtent(pDstLayers->mipLevel);
@@ -3688,19 +3919,18 @@ namespace dxvk {
     if (Length <= 1024 && !(Offset & 0x3) && !(Length & 0x3)) {
       // The backend has special code paths for small buffer updates,
       // however both offset and size must be aligned to four bytes.
-      DxvkDataSlice dataSlice = AllocUpdateBufferSlice(Length);
-      std::memcpy(dataSlice.ptr(), pSrcData, Length);
-
-      EmitCs([
-        cDataBuffer   = std::move(dataSlice),
+      // The data is small enough to be stored inline in the CS chunk.
+      void* payload = EmitCsCmdWithPayload([
         cBufferSlice  = std::move(bufferSlice)
-      ] (DxvkContext* ctx) {
+      ] (DxvkContext* ctx, const void* pData, size_t) {
         ctx->updateBuffer(
           cBufferSlice.buffer(),
           cBufferSlice.offset(),
           cBufferSlice.length(),
-          cDataBuffer.ptr());
-      });
+          pData);
+      }, Length);
+
+      std::memcpy(payload, pSrcData, Length);
     } else {
       // Otherwise, to avoid large data copies on the CS thread,
       // write directly to a staging buffer and dispatch a copy
@@ -3732,12 +3962,39 @@ namespace dxvk {
     const void*                             pSrcData,
           UINT                              SrcRowPitch,
           UINT                              SrcDepthPitch) {
-    if (DstSubresource >= pDstTexture->CountSubresources())
+    VkImageSubresource subresource;
+    VkOffset3D offset;
+    VkExtent3D extent;
+
+    if (!GetTextureUpdateRegion(pDstTexture, DstSubresource, pDstBox, &subresource, &offset, &extent))
       return;
 
     VkFormat packedFormat = pDstTexture->GetPackedFormat();
-
     auto formatInfo = imageFormatInfo(packedFormat);
+
+    auto stagingSlice = AllocStagingBuffer(util::computeImageDataSize(packedFormat, extent));
+
+    util::packImageData(stagingSlice.mapPtr(0),
+      pSrcData, SrcRowPitch, SrcDepthPitch, 0, 0,
+      pDstTexture->GetVkImageType(), extent, 1,
+      formatInfo, formatInfo->aspectMask);
+
+    UpdateImage(pDstTexture, &subresource,
+      offset, extent, std::move(stagingSlice));
+  }
+
+
+  bool D3D11DeviceContext::GetTextureUpdateRegion(
+          D3D11CommonTexture*               pDstTexture,
+          UINT                              DstSubresource,
+    const D3D11_BOX*                        pDstBox,
+          VkImageSubresource*               pSubresource,
+          VkOffset3D*                       pOffset,
+          VkExtent3D*                       pExtent) {
+    if (DstSubresource >= pDstTexture->CountSubresources())
+      return false;
+
+    auto formatInfo = imageFormatInfo(pDstTexture->GetPackedFormat());
     auto subresource = pDstTexture->GetSubresourceFromIndex(
         formatInfo->aspectMask, DstSubresource);
 
@@ -3750,7 +4007,7 @@ namespace dxvk {
       if (pDstBox->left >= pDstBox->right
         || pDstBox->top >= pDstBox->bottom
         || pDstBox->front >= pDstBox->back)
-        return;  // no-op, but legal
+        return false;  // no-op, but legal
 
       offset.x = pDstBox->left;
       offset.y = pDstBox->top;
@@ -3763,18 +4020,13 @@ namespace dxvk {
 
     if (!util::isBlockAligned(offset, extent, formatInfo->blockSize, mipExtent)) {
       Logger::err("D3D11: UpdateSubresource1: Unaligned region");
-      return;
+      return false;
     }
 
-    auto stagingSlice = AllocStagingBuffer(util::computeImageDataSize(packedFormat, extent));
-
-    util::packImageData(stagingSlice.mapPtr(0),
-      pSrcData, SrcRowPitch, SrcDepthPitch, 0, 0,
-      pDstTexture->GetVkImageType(), extent, 1,
-      formatInfo, formatInfo->aspectMask);
-
-    UpdateImage(pDstTexture, &subresource,
-      offset, extent, std::move(stagingSlice));
+    *pSubresource = subresource;
+    *pOffset = offset;
+    *pExtent = extent;
+    return true;
   }
 
 
@@ -3873,6 +4125,72 @@ namespace dxvk {
   }
 
 
+  void D3D11DeviceContext::EmitDraw(
+          UINT                              VertexCount,
+          UINT                              InstanceCount,
+          UINT                              StartVertexLocation,
+          UINT                              StartInstanceLocation) {
+    // Same as for indexed draws, merge consecutive draws
+    // if no state can have changed in between them
+    auto cmdData = static_cast<D3D11CmdDrawData*>(m_cmdData);
+
+    if (!cmdData
+     || cmdData->type != D3D11CmdType::Draw
+     || cmdData->count == D3D11CmdDrawData::MaxDraws
+     || cmdData->instanceCount != InstanceCount
+     || cmdData->firstInstance != StartInstanceLocation) {
+      cmdData = EmitCsCmd<D3D11CmdDrawData>(
+        [] (DxvkContext* ctx, const D3D11CmdDrawData* data) {
+          ctx->drawMulti(data->count, data->draws,
+            data->instanceCount, data->firstInstance);
+        });
+
+      cmdData->type          = D3D11CmdType::Draw;
+      cmdData->instanceCount = InstanceCount;
+      cmdData->firstInstance = StartInstanceLocation;
+      cmdData->count         = 0;
+    }
+
+    VkMultiDrawInfoEXT& draw = cmdData->draws[cmdData->count++];
+    draw.firstVertex  = StartVertexLocation;
+    draw.vertexCount  = VertexCount;
+  }
+
+
+  void D3D11DeviceContext::EmitDrawIndexed(
+          UINT                              IndexCount,
+          UINT                              InstanceCount,
+          UINT                              StartIndexLocation,
+          INT                               BaseVertexLocation,
+          UINT                              StartInstanceLocation) {
+    // If no other command was recorded since the last indexed draw,
+    // no state can have changed, so merge both into one multi-draw
+    auto cmdData = static_cast<D3D11CmdDrawIndexedData*>(m_cmdData);
+
+    if (!cmdData
+     || cmdData->type != D3D11CmdType::DrawIndexed
+     || cmdData->count == D3D11CmdDrawIndexedData::MaxDraws
+     || cmdData->instanceCount != InstanceCount
+     || cmdData->firstInstance != StartInstanceLocation) {
+      cmdData = EmitCsCmd<D3D11CmdDrawIndexedData>(
+        [] (DxvkContext* ctx, const D3D11CmdDrawIndexedData* data) {
+          ctx->drawIndexedMulti(data->count, data->draws,
+            data->instanceCount, data->firstInstance);
+        });
+
+      cmdData->type          = D3D11CmdType::DrawIndexed;
+      cmdData->instanceCount = InstanceCount;
+      cmdData->firstInstance = StartInstanceLocation;
+      cmdData->count         = 0;
+    }
+
+    VkMultiDrawIndexedInfoEXT& draw = cmdData->draws[cmdData->count++];
+    draw.firstIndex   = StartIndexLocation;
+    draw.indexCount   = IndexCount;
+    draw.vertexOffset = BaseVertexLocation;
+  }
+
+
   void D3D11DeviceContext::SetDrawBuffers(
           ID3D11Buffer*                     pBufferForArgs,
           ID3D11Buffer*                     pBufferForCount) {
@@ -3889,16 +4207,18 @@ namespace dxvk {
   }
 
 
-  template<DxbcProgramType ShaderStage>
+  template<DxbcProgramType ShaderStage, typename T>
   void D3D11DeviceContext::SetConstantBuffers(
           D3D11ConstantBufferBindings&      Bindings,
           UINT                              StartSlot,
           UINT                              NumBuffers,
-          ID3D11Buffer* const*              ppConstantBuffers) {
+          T* const*                         ppConstantBuffers) {
     uint32_t slotId = computeConstantBufferBinding(ShaderStage, StartSlot);
     
+    D3D11ConstantBufferBatch batch;
+
     for (uint32_t i = 0; i < NumBuffers; i++) {
-      auto newBuffer = static_cast<D3D11Buffer*>(ppConstantBuffers[i]);
+      auto newBuffer = GetCommonObject(ppConstantBuffers[i]);
       
       UINT constantCount = 0;
       
@@ -3912,9 +4232,11 @@ namespace dxvk {
         Bindings[StartSlot + i].constantCount  = constantCount;
         Bindings[StartSlot + i].constantBound  = constantCount;
         
-        BindConstantBuffer<ShaderStage>(slotId + i, newBuffer, 0, constantCount);
+        AddConstantBuffer<ShaderStage>(batch, slotId + i, newBuffer, 0, constantCount);
       }
     }
+
+    BindConstantBuffers<ShaderStage>(batch);
   }
   
   
@@ -3928,6 +4250,8 @@ namespace dxvk {
     const UINT*                             pNumConstants) {
     uint32_t slotId = computeConstantBufferBinding(ShaderStage, StartSlot);
     
+    D3D11ConstantBufferBatch batch;
+
     for (uint32_t i = 0; i < NumBuffers; i++) {
       auto newBuffer = static_cast<D3D11Buffer*>(ppConstantBuffers[i]);
       
@@ -3972,22 +4296,24 @@ namespace dxvk {
         Bindings[StartSlot + i].constantCount  = constantCount;
         Bindings[StartSlot + i].constantBound  = constantBound;
         
-        BindConstantBuffer<ShaderStage>(slotId + i, newBuffer, constantOffset, constantBound);
+        AddConstantBuffer<ShaderStage>(batch, slotId + i, newBuffer, constantOffset, constantBound);
       }
     }
+
+    BindConstantBuffers<ShaderStage>(batch);
   }
   
   
-  template<DxbcProgramType ShaderStage>
+  template<DxbcProgramType ShaderStage, typename T>
   void D3D11DeviceContext::SetSamplers(
           D3D11SamplerBindings&             Bindings,
           UINT                              StartSlot,
           UINT                              NumSamplers,
-          ID3D11SamplerState* const*        ppSamplers) {
+          T* const*                         ppSamplers) {
     uint32_t slotId = computeSamplerBinding(ShaderStage, StartSlot);
     
     for (uint32_t i = 0; i < NumSamplers; i++) {
-      auto sampler = static_cast<D3D11SamplerState*>(ppSamplers[i]);
+      auto sampler = GetCommonObject(ppSamplers[i]);
       
       if (Bindings[StartSlot + i] != sampler) {
         Bindings[StartSlot + i] = sampler;
@@ -3997,16 +4323,18 @@ namespace dxvk {
   }
   
   
-  template<DxbcProgramType ShaderStage>
+  template<DxbcProgramType ShaderStage, typename T>
   void D3D11DeviceContext::SetShaderResources(
           D3D11ShaderResourceBindings&      Bindings,
           UINT                              StartSlot,
           UINT                              NumResources,
-          ID3D11ShaderResourceView* const*  ppResources) {
+          T* const*                         ppResources) {
     uint32_t slotId = computeSrvBinding(ShaderStage, StartSlot);
     
+    D3D11ShaderResourceBatch batch;
+
     for (uint32_t i = 0; i < NumResources; i++) {
-      auto resView = static_cast<D3D11ShaderResourceView*>(ppResources[i]);
+      auto resView = GetCommonObject(ppResources[i]);
       
       if (Bindings.views[StartSlot + i] != resView) {
         if (unlikely(resView && resView->TestHazards())) {
@@ -4020,9 +4348,11 @@ namespace dxvk {
         }
 
         Bindings.views[StartSlot + i] = resView;
-        BindShaderResource<ShaderStage>(slotId + i, resView);
+        AddShaderResource<ShaderStage>(batch, slotId + i, resView);
       }
     }
+
+    BindShaderResources<ShaderStage>(batch);
   }
   
   
@@ -4217,81 +4547,224 @@ namespace dxvk {
       m_state.ia.indexBuffer.offset,
       m_state.ia.indexBuffer.format);
     
+    D3D11VertexBufferBatch vbBatch;
+
     for (uint32_t i = 0; i < m_state.ia.vertexBuffers.size(); i++) {
-      BindVertexBuffer(i,
+      AddVertexBuffer(vbBatch, i,
         m_state.ia.vertexBuffers[i].buffer.ptr(),
         m_state.ia.vertexBuffers[i].offset,
         m_state.ia.vertexBuffers[i].stride);
     }
 
+    BindVertexBuffers(vbBatch);
+
     for (uint32_t i = 0; i < m_state.so.targets.size(); i++)
       BindXfbBuffer(i, m_state.so.targets[i].buffer.ptr(), ~0u);
     
-    RestoreConstantBuffers<DxbcProgramType::VertexShader>   (m_state.vs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::HullShader>     (m_state.hs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::DomainShader>   (m_state.ds.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::GeometryShader> (m_state.gs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::PixelShader>    (m_state.ps.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::ComputeShader>  (m_state.cs.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::VertexShader>   (m_state.vs.constantBuffers, nullptr);
+    RestoreConstantBuffers<DxbcProgramType::HullShader>     (m_state.hs.constantBuffers, nullptr);
+    RestoreConstantBuffers<DxbcProgramType::DomainShader>   (m_state.ds.constantBuffers, nullptr);
+    RestoreConstantBuffers<DxbcProgramType::GeometryShader> (m_state.gs.constantBuffers, nullptr);
+    RestoreConstantBuffers<DxbcProgramType::PixelShader>    (m_state.ps.constantBuffers, nullptr);
+    RestoreConstantBuffers<DxbcProgramType::ComputeShader>  (m_state.cs.constantBuffers, nullptr);
     
-    RestoreSamplers<DxbcProgramType::VertexShader>  (m_state.vs.samplers);
-    RestoreSamplers<DxbcProgramType::HullShader>    (m_state.hs.samplers);
-    RestoreSamplers<DxbcProgramType::DomainShader>  (m_state.ds.samplers);
-    RestoreSamplers<DxbcProgramType::GeometryShader>(m_state.gs.samplers);
-    RestoreSamplers<DxbcProgramType::PixelShader>   (m_state.ps.samplers);
-    RestoreSamplers<DxbcProgramType::ComputeShader> (m_state.cs.samplers);
+    RestoreSamplers<DxbcProgramType::VertexShader>  (m_state.vs.samplers, nullptr);
+    RestoreSamplers<DxbcProgramType::HullShader>    (m_state.hs.samplers, nullptr);
+    RestoreSamplers<DxbcProgramType::DomainShader>  (m_state.ds.samplers, nullptr);
+    RestoreSamplers<DxbcProgramType::GeometryShader>(m_state.gs.samplers, nullptr);
+    RestoreSamplers<DxbcProgramType::PixelShader>   (m_state.ps.samplers, nullptr);
+    RestoreSamplers<DxbcProgramType::ComputeShader> (m_state.cs.samplers, nullptr);
     
-    RestoreShaderResources<DxbcProgramType::VertexShader>   (m_state.vs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::HullShader>     (m_state.hs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::DomainShader>   (m_state.ds.shaderResources);
-    RestoreShaderResources<DxbcProgramType::GeometryShader> (m_state.gs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::PixelShader>    (m_state.ps.shaderResources);
-    RestoreShaderResources<DxbcProgramType::ComputeShader>  (m_state.cs.shaderResources);
+    RestoreShaderResources<DxbcProgramType::VertexShader>   (m_state.vs.shaderResources, nullptr);
+    RestoreShaderResources<DxbcProgramType::HullShader>     (m_state.hs.shaderResources, nullptr);
+    RestoreShaderResources<DxbcProgramType::DomainShader>   (m_state.ds.shaderResources, nullptr);
+    RestoreShaderResources<DxbcProgramType::GeometryShader> (m_state.gs.shaderResources, nullptr);
+    RestoreShaderResources<DxbcProgramType::PixelShader>    (m_state.ps.shaderResources, nullptr);
+    RestoreShaderResources<DxbcProgramType::ComputeShader>  (m_state.cs.shaderResources, nullptr);
     
-    RestoreUnorderedAccessViews<DxbcProgramType::PixelShader>   (m_state.ps.unorderedAccessViews);
-    RestoreUnorderedAccessViews<DxbcProgramType::ComputeShader> (m_state.cs.unorderedAccessViews);
+    RestoreUnorderedAccessViews<DxbcProgramType::PixelShader>   (m_state.ps.unorderedAccessViews, nullptr);
+    RestoreUnorderedAccessViews<DxbcProgramType::ComputeShader> (m_state.cs.unorderedAccessViews, nullptr);
   }
   
   
+  void D3D11DeviceContext::RestoreChangedState(
+    const D3D11ContextState&                Previous) {
+    bool rtvChanged = Previous.om.depthStencilView != m_state.om.depthStencilView;
+
+    for (uint32_t i = 0; i < m_state.om.renderTargetViews.size() && !rtvChanged; i++)
+      rtvChanged = Previous.om.renderTargetViews[i] != m_state.om.renderTargetViews[i];
+
+    if (rtvChanged)
+      BindFramebuffer();
+
+    if (Previous.vs.shader != m_state.vs.shader) BindShader<DxbcProgramType::VertexShader>   (GetCommonShader(m_state.vs.shader.ptr()));
+    if (Previous.hs.shader != m_state.hs.shader) BindShader<DxbcProgramType::HullShader>     (GetCommonShader(m_state.hs.shader.ptr()));
+    if (Previous.ds.shader != m_state.ds.shader) BindShader<DxbcProgramType::DomainShader>   (GetCommonShader(m_state.ds.shader.ptr()));
+    if (Previous.gs.shader != m_state.gs.shader) BindShader<DxbcProgramType::GeometryShader> (GetCommonShader(m_state.gs.shader.ptr()));
+    if (Previous.ps.shader != m_state.ps.shader) BindShader<DxbcProgramType::PixelShader>    (GetCommonShader(m_state.ps.shader.ptr()));
+    if (Previous.cs.shader != m_state.cs.shader) BindShader<DxbcProgramType::ComputeShader>  (GetCommonShader(m_state.cs.shader.ptr()));
+
+    if (Previous.ia.inputLayout != m_state.ia.inputLayout)
+      ApplyInputLayout();
+
+    if (Previous.ia.primitiveTopology != m_state.ia.primitiveTopology)
+      ApplyPrimitiveTopology();
+
+    if (Previous.om.cbState    != m_state.om.cbState
+     || Previous.om.sampleMask != m_state.om.sampleMask)
+      ApplyBlendState();
+
+    if (std::memcmp(Previous.om.blendFactor, m_state.om.blendFactor, sizeof(m_state.om.blendFactor)))
+      ApplyBlendFactor();
+
+    if (Previous.om.dsState != m_state.om.dsState)
+      ApplyDepthStencilState();
+
+    if (Previous.om.stencilRef != m_state.om.stencilRef)
+      ApplyStencilRef();
+
+    // The rasterizer state affects the sample count
+    // push constant as well as the scissor test
+    bool rsChanged = Previous.rs.state != m_state.rs.state;
+
+    if (rsChanged)
+      ApplyRasterizerState();
+
+    if (rsChanged || Previous.om.sampleCount != m_state.om.sampleCount)
+      ApplyRasterizerSampleCount();
+
+    if (rsChanged
+     || Previous.rs.numViewports != m_state.rs.numViewports
+     || Previous.rs.numScissors  != m_state.rs.numScissors
+     || std::memcmp(Previous.rs.viewports.data(), m_state.rs.viewports.data(), sizeof(D3D11_VIEWPORT) * m_state.rs.numViewports)
+     || std::memcmp(Previous.rs.scissors.data(),  m_state.rs.scissors.data(),  sizeof(D3D11_RECT)     * m_state.rs.numScissors))
+      ApplyViewportState();
+
+    if (Previous.id.argBuffer != m_state.id.argBuffer
+     || Previous.id.cntBuffer != m_state.id.cntBuffer) {
+      BindDrawBuffers(
+        m_state.id.argBuffer.ptr(),
+        m_state.id.cntBuffer.ptr());
+    }
+
+    if (Previous.ia.indexBuffer.buffer != m_state.ia.indexBuffer.buffer
+     || Previous.ia.indexBuffer.offset != m_state.ia.indexBuffer.offset
+     || Previous.ia.indexBuffer.format != m_state.ia.indexBuffer.format) {
+      BindIndexBuffer(
+        m_state.ia.indexBuffer.buffer.ptr(),
+        m_state.ia.indexBuffer.offset,
+        m_state.ia.indexBuffer.format);
+    }
+
+    D3D11VertexBufferBatch vbBatch;
+
+    for (uint32_t i = 0; i < m_state.ia.vertexBuffers.size(); i++) {
+      const auto& prev = Previous.ia.vertexBuffers[i];
+      const auto& curr = m_state.ia.vertexBuffers[i];
+
+      if (prev.buffer != curr.buffer
+       || prev.offset != curr.offset
+       || prev.stride != curr.stride)
+        AddVertexBuffer(vbBatch, i, curr.buffer.ptr(), curr.offset, curr.stride);
+    }
+
+    BindVertexBuffers(vbBatch);
+
+    for (uint32_t i = 0; i < m_state.so.targets.size(); i++) {
+      if (Previous.so.targets[i].buffer != m_state.so.targets[i].buffer)
+        BindXfbBuffer(i, m_state.so.targets[i].buffer.ptr(), ~0u);
+    }
+
+    RestoreConstantBuffers<DxbcProgramType::VertexShader>   (m_state.vs.constantBuffers, &Previous.vs.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::HullShader>     (m_state.hs.constantBuffers, &Previous.hs.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::DomainShader>   (m_state.ds.constantBuffers, &Previous.ds.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::GeometryShader> (m_state.gs.constantBuffers, &Previous.gs.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::PixelShader>    (m_state.ps.constantBuffers, &Previous.ps.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::ComputeShader>  (m_state.cs.constantBuffers, &Previous.cs.constantBuffers);
+
+    RestoreSamplers<DxbcProgramType::VertexShader>  (m_state.vs.samplers, &Previous.vs.samplers);
+    RestoreSamplers<DxbcProgramType::HullShader>    (m_state.hs.samplers, &Previous.hs.samplers);
+    RestoreSamplers<DxbcProgramType::DomainShader>  (m_state.ds.samplers, &Previous.ds.samplers);
+    RestoreSamplers<DxbcProgramType::GeometryShader>(m_state.gs.samplers, &Previous.gs.samplers);
+    RestoreSamplers<DxbcProgramType::PixelShader>   (m_state.ps.samplers, &Previous.ps.samplers);
+    RestoreSamplers<DxbcProgramType::ComputeShader> (m_state.cs.samplers, &Previous.cs.samplers);
+
+    RestoreShaderResources<DxbcProgramType::VertexShader>   (m_state.vs.shaderResources, &Previous.vs.shaderResources);
+    RestoreShaderResources<DxbcProgramType::HullShader>     (m_state.hs.shaderResources, &Previous.hs.shaderResources);
+    RestoreShaderResources<DxbcProgramType::DomainShader>   (m_state.ds.shaderResources, &Previous.ds.shaderResources);
+    RestoreShaderResources<DxbcProgramType::GeometryShader> (m_state.gs.shaderResources, &Previous.gs.shaderResources);
+    RestoreShaderResources<DxbcProgramType::PixelShader>    (m_state.ps.shaderResources, &Previous.ps.shaderResources);
+    RestoreShaderResources<DxbcProgramType::ComputeShader>  (m_state.cs.shaderResources, &Previous.cs.shaderResources);
+
+    RestoreUnorderedAccessViews<DxbcProgramType::PixelShader>   (m_state.ps.unorderedAccessViews, &Previous.ps.unorderedAccessViews);
+    RestoreUnorderedAccessViews<DxbcProgramType::ComputeShader> (m_state.cs.unorderedAccessViews, &Previous.cs.unorderedAccessViews);
+  }
+
+
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreConstantBuffers(
-          D3D11ConstantBufferBindings&      Bindings) {
+          D3D11ConstantBufferBindings&      Bindings,
+    const D3D11ConstantBufferBindings*      pPrevious) {
     uint32_t slotId = computeConstantBufferBinding(Stage, 0);
     
+    D3D11ConstantBufferBatch batch;
+
     for (uint32_t i = 0; i < Bindings.size(); i++) {
-      BindConstantBuffer<Stage>(slotId + i, Bindings[i].buffer.ptr(),
+      if (pPrevious
+       && (*pPrevious)[i].buffer         == Bindings[i].buffer
+       && (*pPrevious)[i].constantOffset == Bindings[i].constantOffset
+       && (*pPrevious)[i].constantBound  == Bindings[i].constantBound)
+        continue;
+
+      AddConstantBuffer<Stage>(batch, slotId + i, Bindings[i].buffer.ptr(),
         Bindings[i].constantOffset, Bindings[i].constantBound);
     }
+
+    BindConstantBuffers<Stage>(batch);
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreSamplers(
-          D3D11SamplerBindings&             Bindings) {
+          D3D11SamplerBindings&             Bindings,
+    const D3D11SamplerBindings*             pPrevious) {
     uint32_t slotId = computeSamplerBinding(Stage, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
-      BindSampler<Stage>(slotId + i, Bindings[i]);
+    for (uint32_t i = 0; i < Bindings.size(); i++) {
+      if (!pPrevious || (*pPrevious)[i] != Bindings[i])
+        BindSampler<Stage>(slotId + i, Bindings[i]);
+    }
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreShaderResources(
-          D3D11ShaderResourceBindings&      Bindings) {
+          D3D11ShaderResourceBindings&      Bindings,
+    const D3D11ShaderResourceBindings*      pPrevious) {
     uint32_t slotId = computeSrvBinding(Stage, 0);
     
-    for (uint32_t i = 0; i < Bindings.views.size(); i++)
-      BindShaderResource<Stage>(slotId + i, Bindings.views[i].ptr());
+    D3D11ShaderResourceBatch batch;
+
+    for (uint32_t i = 0; i < Bindings.views.size(); i++) {
+      if (!pPrevious || pPrevious->views[i] != Bindings.views[i])
+        AddShaderResource<Stage>(batch, slotId + i, Bindings.views[i].ptr());
+    }
+
+    BindShaderResources<Stage>(batch);
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreUnorderedAccessViews(
-          D3D11UnorderedAccessBindings&     Bindings) {
+          D3D11UnorderedAccessBindings&     Bindings,
+    const D3D11UnorderedAccessBindings*     pPrevious) {
     uint32_t uavSlotId = computeUavBinding       (Stage, 0);
     uint32_t ctrSlotId = computeUavCounterBinding(Stage, 0);
     
     for (uint32_t i = 0; i < Bindings.size(); i++) {
+      if (pPrevious && (*pPrevious)[i] == Bindings[i])
+        continue;
+
       BindUnorderedAccessView<Stage>(
         uavSlotId + i,
         Bindings[i].ptr(),
@@ -4556,7 +5029,7 @@ namespace dxvk {
   
 
   DxvkCsChunkRef D3D11DeviceContext::AllocCsChunk() {
-    return m_parent->AllocCsChunk(m_csFlags);
+    return m_parent->AllocCsChunk(m_csFlags, m_csSizer.sizeClass());
   }
   
 
@@ -18,6 +18,71 @@ namespace dxvk {
   
   class D3D11Device;
   
+  /**
+   * \brief Binding batch
+   * 
+   * Collects changed bindings of one shader stage or
+   * of the input assembler, so that they can be applied
+   * to the DXVK context with a single CS command rather
+   * than one command per slot.
+   */
+  template<typename T>
+  struct D3D11BindingBatch {
+    constexpr static uint32_t MaxBindings = 8;
+
+    uint32_t                    count = 0;
+    std::array<T, MaxBindings>  bindings;
+
+    T& add() {
+      return bindings[count++];
+    }
+
+    bool full() const {
+      return count == MaxBindings;
+    }
+  };
+  
+  struct D3D11VertexBufferBind {
+    uint32_t            slot;
+    uint32_t            stride;
+    DxvkBufferSlice     slice;
+  };
+  
+  struct D3D11ConstantBufferBind {
+    uint32_t            slot;
+    DxvkBufferSlice     slice;
+  };
+  
+  struct D3D11ShaderResourceBind {
+    uint32_t            slot;
+    Rc<DxvkImageView>   imageView;
+    Rc<DxvkBufferView>  bufferView;
+  };
+  
+  using D3D11VertexBufferBatch   = D3D11BindingBatch<D3D11VertexBufferBind>;
+  using D3D11ConstantBufferBatch = D3D11BindingBatch<D3D11ConstantBufferBind>;
+  using D3D11ShaderResourceBatch = D3D11BindingBatch<D3D11ShaderResourceBind>;
+
+  /**
+   * \brief CS state command keys
+   *
+   * Identifies the pieces of context state that are
+   * entirely overwritten by a single state command.
+   * Shader keys are offset by the program type.
+   */
+  enum class D3D11CsStateKey : uint32_t {
+    InputLayout = 1,
+    PrimitiveTopology,
+    BlendState,
+    BlendFactor,
+    DepthStencilState,
+    StencilRef,
+    RasterizerState,
+    ViewportState,
+    IndexBuffer,
+    Shader,
+  };
+  
   class D3D11DeviceContext : public D3D11DeviceChild<ID3D11DeviceContext4> {
     friend class D3D11DeviceContextExt;
     // Needed in order to call EmitCs for pushing markers
@@ -690,6 +755,52 @@ namespace dxvk {
       return m_multithread.AcquireLock();
     }
 
+    /**
+     * \brief Binds D3D10 constant buffers
+     *
+     * Used by the D3D10 device in order to bind D3D10
+     * objects directly, without converting them to
+     * D3D11 interfaces first. Only the vertex, geometry
+     * and pixel shader stages are supported.
+     * \param [in] ShaderStage Shader stage
+     * \param [in] StartSlot First slot to bind
+     * \param [in] NumBuffers Number of buffers
+     * \param [in] ppConstantBuffers Buffers, may be \c nullptr
+     */
+    void SetD3D10ConstantBuffers(
+            DxbcProgramType                   ShaderStage,
+            UINT                              StartSlot,
+            UINT                              NumBuffers,
+            ID3D10Buffer* const*              ppConstantBuffers);
+
+    /**
+     * \brief Binds D3D10 shader resource views
+     *
+     * \param [in] ShaderStage Shader stage
+     * \param [in] StartSlot First slot to bind
+     * \param [in] NumViews Number of views
+     * \param [in] ppShaderResourceViews Views, may be \c nullptr
+     */
+    void SetD3D10ShaderResources(
+            DxbcProgramType                   ShaderStage,
+            UINT                              StartSlot,
+            UINT                              NumViews,
+            ID3D10ShaderResourceView* const*  ppShaderResourceViews);
+
+    /**
+     * \brief Binds D3D10 samplers
+     *
+     * \param [in] ShaderStage Shader stage
+     * \param [in] StartSlot First slot to bind
+     * \param [in] NumSamplers Number of samplers
+     * \param [in] ppSamplers Samplers, may be \c nullptr
+     */
+    void SetD3D10Samplers(
+            DxbcProgramType                   ShaderStage,
+            UINT                              StartSlot,
+            UINT                              NumSamplers,
+            ID3D10SamplerState* const*        ppSamplers);
+
   protected:
     
     D3D11DeviceContextExt       m_contextExt;
@@ -704,6 +815,7 @@ namespace dxvk {
     D3D11UserDefinedAnnotation  m_annotation;
 
     DxvkCsChunkFlags            m_csFlags;
+    DxvkCsChunkSizer            m_csSizer;
     DxvkCsChunkRef              m_csChunk;
     
     D3D11ContextState           m_state;
@@ -737,7 +849,11 @@ namespace dxvk {
             D3D11Buffer*                      pBufferForArgs,
             D3D11Buffer*                      pBufferForCount);
     
-    void BindVertexBuffer(
+    void BindVertexBuffers(
+            D3D11VertexBufferBatch&           Batch);
+    
+    void AddVertexBuffer(
+            D3D11VertexBufferBatch&           Batch,
             UINT                              Slot,
             D3D11Buffer*                      pBuffer,
             UINT                              Offset,
@@ -754,7 +870,12 @@ namespace dxvk {
             UINT                              Offset);
     
     template<DxbcProgramType ShaderStage>
-    void BindConstantBuffer(
+    void BindConstantBuffers(
+            D3D11ConstantBufferBatch&         Batch);
+    
+    template<DxbcProgramType ShaderStage>
+    void AddConstantBuffer(
+            D3D11ConstantBufferBatch&         Batch,
             UINT                              Slot,
             D3D11Buffer*                      pBuffer,
             UINT                              Offset,
@@ -770,6 +891,16 @@ namespace dxvk {
             UINT                              Slot,
             D3D11ShaderResourceView*          pResource);
     
+    template<DxbcProgramType ShaderStage>
+    void BindShaderResources(
+            D3D11ShaderResourceBatch&         Batch);
+    
+    template<DxbcProgramType ShaderStage>
+    void AddShaderResource(
+            D3D11ShaderResourceBatch&         Batch,
+            UINT                              Slot,
+            D3D11ShaderResourceView*          pResource);
+    
     template<DxbcProgramType ShaderStage>
     void BindUnorderedAccessView(
             UINT                              UavSlot,
@@ -857,6 +988,17 @@ namespace dxvk {
       } else {
         D3D11CommonTexture* textureResource = GetCommonTexture(pDstResource);
 
+        // Linear images and buffer-backed staging images can be
+        // written directly if they are idle, which saves both
+        // staging memory and a GPU-side copy
+        auto mapMode = textureResource->GetMapMode();
+
+        if ((mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT
+          || mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_STAGING)
+         && pContext->UpdateMappedImage(textureResource, DstSubresource,
+              pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch))
+          return;
+
         pContext->UpdateTexture(textureResource,
           DstSubresource, pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch);
       }
@@ -876,6 +1018,14 @@ namespace dxvk {
             UINT                              SrcRowPitch,
             UINT                              SrcDepthPitch);
 
+    bool GetTextureUpdateRegion(
+            D3D11CommonTexture*               pDstTexture,
+            UINT                              DstSubresource,
+      const D3D11_BOX*                        pDstBox,
+            VkImageSubresource*               pSubresource,
+            VkOffset3D*                       pOffset,
+            VkExtent3D*                       pExtent);
+
     void UpdateImage(
             D3D11CommonTexture*               pDstTexture,
       const VkImageSubresource*               pDstSubresource,
@@ -886,13 +1036,26 @@ namespace dxvk {
     void SetDrawBuffers(
             ID3D11Buffer*                     pBufferForArgs,
             ID3D11Buffer*                     pBufferForCount);
+
+    void EmitDraw(
+            UINT                              VertexCount,
+            UINT                              InstanceCount,
+            UINT                              StartVertexLocation,
+            UINT                              StartInstanceLocation);
+
+    void EmitDrawIndexed(
+            UINT                              IndexCount,
+            UINT                              InstanceCount,
+            UINT                              StartIndexLocation,
+            INT                               BaseVertexLocation,
+            UINT                              StartInstanceLocation);
     
-    template<DxbcProgramType ShaderStage>
+    template<DxbcProgramType ShaderStage, typename T>
     void SetConstantBuffers(
             D3D11ConstantBufferBindings&      Bindings,
             UINT                              StartSlot,
             UINT                              NumBuffers,
-            ID3D11Buffer* const*              ppConstantBuffers);
+            T* const*                         ppConstantBuffers);
     
     template<DxbcProgramType ShaderStage>
     void SetConstantBuffers1(
@@ -903,19 +1066,19 @@ namespace dxvk {
       const UINT*                             pFirstConstant,
       const UINT*                             pNumConstants);
     
-    template<DxbcProgramType ShaderStage>
+    template<DxbcProgramType ShaderStage, typename T>
     void SetSamplers(
             D3D11SamplerBindings&             Bindings,
             UINT                              StartSlot,
             UINT                              NumSamplers,
-            ID3D11SamplerState* const*        ppSamplers);
+            T* const*                         ppSamplers);
     
-    template<DxbcProgramType ShaderStage>
+    template<DxbcProgramType ShaderStage, typename T>
     void SetShaderResources(
             D3D11ShaderResourceBindings&      Bindings,
             UINT                              StartSlot,
             UINT                              NumResources,
-            ID3D11ShaderResourceView* const*  ppResources);
+            T* const*                         ppResources);
     
     void GetConstantBuffers(
       const D3D11ConstantBufferBindings&      Bindings,
@@ -940,22 +1103,29 @@ namespace dxvk {
     void ResetState();
 
     void RestoreState();
+
+    void RestoreChangedState(
+      const D3D11ContextState&                Previous);
     
     template<DxbcProgramType Stage>
     void RestoreConstantBuffers(
-            D3D11ConstantBufferBindings&      Bindings);
+            D3D11ConstantBufferBindings&      Bindings,
+      const D3D11ConstantBufferBindings*      pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreSamplers(
-            D3D11SamplerBindings&             Bindings);
+            D3D11SamplerBindings&             Bindings,
+      const D3D11SamplerBindings*             pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreShaderResources(
-            D3D11ShaderResourceBindings&      Bindings);
+            D3D11ShaderResourceBindings&      Bindings,
+      const D3D11ShaderResourceBindings*      pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreUnorderedAccessViews(
-            D3D11UnorderedAccessBindings&     Bindings);
+            D3D11UnorderedAccessBindings&     Bindings,
+      const D3D11UnorderedAccessBindings*     pPrevious);
     
     bool TestRtvUavHazards(
             UINT                              NumRTVs,
@@ -1046,6 +1216,7 @@ namespace dxvk {
       m_cmdData = nullptr;
 
       if (unlikely(!m_csChunk->push(command))) {
+        m_csSizer.notifyChunk(m_csChunk);
         EmitCsChunk(std::move(m_csChunk));
         
         m_csChunk = AllocCsChunk();
@@ -1053,12 +1224,26 @@ namespace dxvk {
       }
     }
 
+    template<typename Cmd>
+    void EmitCsState(D3D11CsStateKey key, Cmd&& command) {
+      m_cmdData = nullptr;
+
+      if (unlikely(!m_csChunk->pushState(command, uint32_t(key)))) {
+        m_csSizer.notifyChunk(m_csChunk);
+        EmitCsChunk(std::move(m_csChunk));
+        
+        m_csChunk = AllocCsChunk();
+        m_csChunk->pushState(command, uint32_t(key));
+      }
+    }
+
     template<typename M, typename Cmd, typename... Args>
     M* EmitCsCmd(Cmd&& command, Args&&... args) {
       M* data = m_csChunk->pushCmd<M, Cmd, Args...>(
         command, std::forward<Args>(args)...);
 
       if (unlikely(!data)) {
+        m_csSizer.notifyChunk(m_csChunk);
         EmitCsChunk(std::move(m_csChunk));
         
         m_csChunk = AllocCsChunk();
@@ -1069,9 +1254,27 @@ namespace dxvk {
       m_cmdData = data;
       return data;
     }
+
+    template<typename Cmd>
+    void* EmitCsCmdWithPayload(Cmd&& command, size_t size) {
+      m_cmdData = nullptr;
+
+      void* payload = m_csChunk->pushCmdWithPayload(command, size);
+
+      if (unlikely(!payload)) {
+        m_csSizer.notifyChunk(m_csChunk);
+        EmitCsChunk(std::move(m_csChunk));
+
+        m_csChunk = AllocCsChunk();
+        payload = m_csChunk->pushCmdWithPayload(command, size);
+      }
+
+      return payload;
+    }
     
     void FlushCsChunk() {
       if (likely(!m_csChunk->empty())) {
+        m_csSizer.notifyChunk(m_csChunk);
         EmitCsChunk(std::move(m_csChunk));
         m_csChunk = AllocCsChunk();
         m_cmdData = nullptr;
@@ -165,9 +165,13 @@ namespace dxvk {
     FinalizeQueries();
     FlushCsChunk();
     
+    size_t chunkCount    = m_commandList->GetChunkCount();
+    size_t resourceCount = m_commandList->GetResourceCount();
+
     if (ppCommandList != nullptr)
       *ppCommandList = m_commandList.ref();
     m_commandList = CreateCommandList();
+    m_commandList->Reserve(chunkCount, resourceCount);
     
     if (RestoreDeferredContextState)
       RestoreState();
@@ -186,6 +190,8 @@ namespace dxvk {
           D3D11_MAP                   MapType,
           UINT                        MapFlags,
           D3D11_MAPPED_SUBRESOURCE*   pMappedResource) {
+    DXVK_TRACE_SCOPE("D3D11DeferredContext::Map");
+
     D3D10DeviceLock lock = LockContext();
 
     if (unlikely(!pResource || !pMappedResource))
@@ -300,17 +306,31 @@ namespace dxvk {
     } else {
       // For GPU-writable resources, we need a data slice
       // to perform the update operation at execution time.
-      auto dataSlice = AllocUpdateBufferSlice(pBuffer->Desc()->ByteWidth);
-      pMappedResource->pData = dataSlice.ptr();
-
-      EmitCs([
-        cDstBuffer = pBuffer->GetBuffer(),
-        cDataSlice = dataSlice
-      ] (DxvkContext* ctx) {
-        DxvkBufferSliceHandle slice = cDstBuffer->allocSlice();
-        std::memcpy(slice.mapPtr, cDataSlice.ptr(), cDataSlice.length());
-        ctx->invalidateBuffer(cDstBuffer, slice);
-      });
+      // Small buffers are written directly to the CS chunk,
+      // which stays alive until the command list is destroyed.
+      UINT byteWidth = pBuffer->Desc()->ByteWidth;
+
+      if (byteWidth <= DxvkCsChunk::MaxPayloadSize) {
+        pMappedResource->pData = EmitCsCmdWithPayload([
+          cDstBuffer = pBuffer->GetBuffer()
+        ] (DxvkContext* ctx, const void* pData, size_t Size) {
+          DxvkBufferSliceHandle slice = cDstBuffer->allocSlice();
+          std::memcpy(slice.mapPtr, pData, Size);
+          ctx->invalidateBuffer(cDstBuffer, slice);
+        }, byteWidth);
+      } else {
+        auto dataSlice = AllocUpdateBufferSlice(byteWidth);
+        pMappedResource->pData = dataSlice.ptr();
+
+        EmitCs([
+          cDstBuffer = pBuffer->GetBuffer(),
+          cDataSlice = dataSlice
+        ] (DxvkContext* ctx) {
+          DxvkBufferSliceHandle slice = cDstBuffer->allocSlice();
+          std::memcpy(slice.mapPtr, cDataSlice.ptr(), cDataSlice.length());
+          ctx->invalidateBuffer(cDstBuffer, slice);
+        });
+      }
     }
     
     return S_OK;
@@ -133,6 +133,18 @@ namespace dxvk {
       const void*                         pSrcData,
             UINT                          CopyFlags);
 
+    bool UpdateMappedImage(
+            D3D11CommonTexture*           pDstTexture,
+            UINT                          DstSubresource,
+      const D3D11_BOX*                    pDstBox,
+      const void*                         pSrcData,
+            UINT                          SrcRowPitch,
+            UINT                          SrcDepthPitch) {
+      // Deferred contexts cannot know whether the
+      // image will be idle when the command list runs
+      return false;
+    }
+
     void FinalizeQueries();
 
     Com<D3D11CommandList> CreateCommandList();
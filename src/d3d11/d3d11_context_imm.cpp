@@ -1,12 +1,9 @@
 #include "d3d11_cmdlist.h"
 #include "d3d11_context_imm.h"
 #include "d3d11_device.h"
+#include "d3d11_fence.h"
 #include "d3d11_texture.h"
 
-constexpr static uint32_t MinFlushIntervalUs = 750;
-constexpr static uint32_t IncFlushIntervalUs = 250;
-constexpr static uint32_t MaxPendingSubmits  = 6;
-
 namespace dxvk {
   
   D3D11ImmediateContext::D3D11ImmediateContext(
@@ -176,7 +173,8 @@ namespace dxvk {
       FlushCsChunk();
       
       // Reset flush timer used for implicit flushes
-      m_lastFlush = dxvk::high_resolution_clock::now();
+      m_flushTracker.notifyFlush(m_device.ptr(), m_csSeqNum);
+      m_hasPendingReadback = false;
       m_csIsBusy  = false;
     }
   }
@@ -185,16 +183,62 @@ namespace dxvk {
   HRESULT STDMETHODCALLTYPE D3D11ImmediateContext::Signal(
           ID3D11Fence*                pFence,
           UINT64                      Value) {
-    Logger::err("D3D11ImmediateContext::Signal: Not implemented");
-    return E_NOTIMPL;
+    auto fence = static_cast<D3D11Fence*>(pFence);
+
+    if (!fence)
+      return E_INVALIDARG;
+
+    m_parent->FlushInitContext();
+
+    D3D10DeviceLock lock = LockContext();
+
+    // The fence is signaled once the current command
+    // list completes, so submit it right away
+    EmitCs([
+      cFence = fence->GetFence(),
+      cValue = Value
+    ] (DxvkContext* ctx) {
+      ctx->signalFence(cFence, cValue);
+      ctx->flushCommandList();
+    });
+
+    FlushCsChunk();
+
+    m_flushTracker.notifyFlush(m_device.ptr(), m_csSeqNum);
+    m_hasPendingReadback = false;
+    m_csIsBusy  = false;
+    return S_OK;
   }
 
 
   HRESULT STDMETHODCALLTYPE D3D11ImmediateContext::Wait(
           ID3D11Fence*                pFence,
           UINT64                      Value) {
-    Logger::err("D3D11ImmediateContext::Wait: Not implemented");
-    return E_NOTIMPL;
+    auto fence = static_cast<D3D11Fence*>(pFence);
+
+    if (!fence)
+      return E_INVALIDARG;
+
+    m_parent->FlushInitContext();
+
+    D3D10DeviceLock lock = LockContext();
+
+    // Submit prior work so that only commands
+    // recorded after this call wait for the fence
+    EmitCs([
+      cFence = fence->GetFence(),
+      cValue = Value
+    ] (DxvkContext* ctx) {
+      ctx->flushCommandList();
+      ctx->waitFence(cFence, cValue);
+    });
+
+    FlushCsChunk();
+
+    m_flushTracker.notifyFlush(m_device.ptr(), m_csSeqNum);
+    m_hasPendingReadback = false;
+    m_csIsBusy  = false;
+    return S_OK;
   }
 
 
@@ -245,6 +289,8 @@ namespace dxvk {
           D3D11_MAP                   MapType,
           UINT                        MapFlags,
           D3D11_MAPPED_SUBRESOURCE*   pMappedResource) {
+    DXVK_TRACE_SCOPE("D3D11ImmediateContext::Map");
+
     D3D10DeviceLock lock = LockContext();
 
     if (unlikely(!pResource))
@@ -429,6 +475,30 @@ namespace dxvk {
           return DXGI_ERROR_WAS_STILL_DRAWING;
 
         DxvkBufferSliceHandle physSlice = pResource->GetMappedSlice();
+
+        // Some games read back from buffers that we put into write-combined
+        // memory. If that happens repeatedly, move the buffer to cached
+        // memory and copy the current contents over once.
+        if (unlikely(MapType != D3D11_MAP_WRITE && pResource->TrackCpuRead())) {
+          Logger::info(str::format("D3D11: Moving buffer of size ", bufferSize, " to cached memory"));
+
+          buffer->setMemoryFlags(buffer->memFlags()
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+          auto prevSlice = physSlice;
+          physSlice = pResource->DiscardSlice();
+
+          EmitCs([
+            cBuffer      = std::move(buffer),
+            cBufferSlice = physSlice
+          ] (DxvkContext* ctx) {
+            ctx->invalidateBuffer(cBuffer, cBufferSlice);
+          });
+
+          std::memcpy(physSlice.mapPtr, prevSlice.mapPtr, physSlice.length);
+        }
+
         pMappedResource->pData      = physSlice.mapPtr;
         pMappedResource->RowPitch   = bufferSize;
         pMappedResource->DepthPitch = bufferSize;
@@ -476,19 +546,44 @@ namespace dxvk {
     void* mapPtr;
 
     if (mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT) {
-      // Wait for the resource to become available. We do not
-      // support image renaming, so stall on DISCARD instead.
-      if (MapType == D3D11_MAP_WRITE_DISCARD)
-        MapFlags &= ~D3D11_MAP_FLAG_DO_NOT_WAIT;
+      bool doRename = MapType == D3D11_MAP_WRITE_DISCARD
+        && pResource->CanDiscardImage();
 
-      if (MapType != D3D11_MAP_WRITE_NO_OVERWRITE) {
-        if (!WaitForResource(mappedImage, sequenceNumber, MapType, MapFlags))
-          return DXGI_ERROR_WAS_STILL_DRAWING;
+      // If we know for sure that the image is currently not
+      // in use by the GPU, we don't have to rename it.
+      if (doRename && m_csThread.lastSequenceNumber() >= sequenceNumber
+       && !mappedImage->isInUse(DxvkAccess::Read))
+        doRename = false;
+
+      if (doRename) {
+        FlushImplicit(TRUE);
+
+        // Hand out new storage right away, the image itself
+        // gets renamed once the CS thread reaches this point
+        EmitCs([
+          cImage    = mappedImage,
+          cStorage  = pResource->DiscardImage()
+        ] (DxvkContext* ctx) {
+          ctx->invalidateImage(cImage, cStorage);
+        });
+
+        if (pResource->HasSequenceNumber())
+          TrackTextureSequenceNumber(pResource, Subresource);
+      } else {
+        // Wait for the resource to become available. Images
+        // that cannot be renamed have to stall on DISCARD.
+        if (MapType == D3D11_MAP_WRITE_DISCARD)
+          MapFlags &= ~D3D11_MAP_FLAG_DO_NOT_WAIT;
+
+        if (MapType != D3D11_MAP_WRITE_NO_OVERWRITE) {
+          if (!WaitForResource(mappedImage, sequenceNumber, MapType, MapFlags))
+            return DXGI_ERROR_WAS_STILL_DRAWING;
+        }
       }
       
       // Query the subresource's memory layout and hope that
       // the application respects the returned pitch values.
-      mapPtr = mappedImage->mapPtr(0);
+      mapPtr = pResource->GetMapPtr();
     } else {
       constexpr uint32_t DoInvalidate = (1u << 0);
       constexpr uint32_t DoPreserve   = (1u << 1);
@@ -639,6 +734,144 @@ namespace dxvk {
   }
 
 
+  bool D3D11ImmediateContext::UpdateMappedImage(
+          D3D11CommonTexture*           pDstTexture,
+          UINT                          DstSubresource,
+    const D3D11_BOX*                    pDstBox,
+    const void*                         pSrcData,
+          UINT                          SrcRowPitch,
+          UINT                          SrcDepthPitch) {
+    if (pDstTexture->GetMapMode() == D3D11_COMMON_TEXTURE_MAP_MODE_STAGING) {
+      return UpdateMappedStagingImage(pDstTexture, DstSubresource,
+        pDstBox, pSrcData, SrcRowPitch, SrcDepthPitch);
+    }
+
+    Rc<DxvkImage> image = pDstTexture->GetImage();
+
+    // Never stall here. If any pending CS chunk or GPU
+    // submission may still access the image, fall back
+    // to the regular staging buffer path instead.
+    uint64_t sequenceNumber = pDstTexture->GetSequenceNumber(DstSubresource);
+
+    if (sequenceNumber == DxvkCsThread::SynchronizeAll) {
+      if (!m_csChunk->empty())
+        return false;
+
+      sequenceNumber = m_csSeqNum;
+    }
+
+    if (m_csThread.lastSequenceNumber() < sequenceNumber
+     || image->isInUse(DxvkAccess::Read))
+      return false;
+
+    VkImageSubresource subresource;
+    VkOffset3D offset;
+    VkExtent3D extent;
+
+    // Invalid regions are no-ops, so there is nothing left to do
+    if (!GetTextureUpdateRegion(pDstTexture, DstSubresource, pDstBox, &subresource, &offset, &extent))
+      return true;
+
+    auto formatInfo = image->formatInfo();
+
+    VkSubresourceLayout layout = image->querySubresourceLayout(subresource);
+
+    VkOffset3D blockOffset = util::computeBlockOffset(offset, formatInfo->blockSize);
+    VkExtent3D blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
+
+    for (uint32_t z = 0; z < blockCount.depth; z++) {
+      for (uint32_t y = 0; y < blockCount.height; y++) {
+        auto dst = image->mapPtr(layout.offset
+          + (blockOffset.z + z) * layout.depthPitch
+          + (blockOffset.y + y) * layout.rowPitch
+          +  blockOffset.x * formatInfo->elementSize);
+
+        auto src = reinterpret_cast<const char*>(pSrcData)
+          + z * SrcDepthPitch
+          + y * SrcRowPitch;
+
+        std::memcpy(dst, src, blockCount.width * formatInfo->elementSize);
+      }
+    }
+
+    return true;
+  }
+
+
+  bool D3D11ImmediateContext::UpdateMappedStagingImage(
+          D3D11CommonTexture*           pDstTexture,
+          UINT                          DstSubresource,
+    const D3D11_BOX*                    pDstBox,
+    const void*                         pSrcData,
+          UINT                          SrcRowPitch,
+          UINT                          SrcDepthPitch) {
+    VkImageSubresource subresource;
+    VkOffset3D offset;
+    VkExtent3D extent;
+
+    // Invalid regions are no-ops, so there is nothing left to do
+    if (!GetTextureUpdateRegion(pDstTexture, DstSubresource, pDstBox, &subresource, &offset, &extent))
+      return true;
+
+    // The mapped buffer is tightly packed, so only updates
+    // that cover the entire subresource can be packed into
+    // it directly. Partial updates use the GPU copy path.
+    VkExtent3D mipExtent = pDstTexture->MipLevelExtent(subresource.mipLevel);
+
+    if (offset.x || offset.y || offset.z
+     || extent.width  != mipExtent.width
+     || extent.height != mipExtent.height
+     || extent.depth  != mipExtent.depth)
+      return false;
+
+    Rc<DxvkBuffer> mappedBuffer = pDstTexture->GetMappedBuffer(DstSubresource);
+    uint64_t sequenceNumber = pDstTexture->GetSequenceNumber(DstSubresource);
+
+    if (sequenceNumber == DxvkCsThread::SynchronizeAll) {
+      if (!m_csChunk->empty())
+        return false;
+
+      sequenceNumber = m_csSeqNum;
+    }
+
+    DxvkBufferSliceHandle slice;
+
+    if (m_csThread.lastSequenceNumber() >= sequenceNumber
+     && !mappedBuffer->isInUse(DxvkAccess::Read)) {
+      slice = pDstTexture->GetMappedSlice(DstSubresource);
+    } else {
+      // Since the previous contents get overwritten entirely, discard
+      // the mapped buffer instead of waiting for the GPU. Use the same
+      // restrictions as implicit discards in Map to limit memory usage.
+      if (pDstTexture->GetMappedSlice(DstSubresource).length >= m_maxImplicitDiscardSize
+       || pDstTexture->CountSubresources() > 1)
+        return false;
+
+      FlushImplicit(TRUE);
+
+      slice = pDstTexture->DiscardSlice(DstSubresource);
+
+      EmitCs([
+        cImageBuffer = std::move(mappedBuffer),
+        cBufferSlice = slice
+      ] (DxvkContext* ctx) {
+        ctx->invalidateBuffer(cImageBuffer, cBufferSlice);
+      });
+
+      if (pDstTexture->HasSequenceNumber())
+        TrackTextureSequenceNumber(pDstTexture, DstSubresource);
+    }
+
+    auto formatInfo = imageFormatInfo(pDstTexture->GetPackedFormat());
+
+    util::packImageData(slice.mapPtr,
+      pSrcData, SrcRowPitch, SrcDepthPitch, 0, 0,
+      pDstTexture->GetVkImageType(), extent, 1,
+      formatInfo, formatInfo->aspectMask);
+    return true;
+  }
+
+
   void STDMETHODCALLTYPE D3D11ImmediateContext::SwapDeviceContextState(
           ID3DDeviceContextState*           pState,
           ID3DDeviceContextState**          ppPreviousState) {
@@ -658,10 +891,17 @@ namespace dxvk {
     
     m_stateObject = newState;
 
-    oldState->SetState(m_state);
-    newState->GetState(m_state);
+    if (oldState == newState)
+      return;
+
+    // Move the current state into the old state object and take
+    // the new state object's state, leaving the new object with
+    // stale state that will be overwritten once it gets swapped
+    // out again. Only bindings that differ need to be reapplied.
+    oldState->SwapState(m_state);
+    newState->SwapState(m_state);
 
-    RestoreState();
+    RestoreChangedState(oldState->GetStoredState());
   }
 
 
@@ -744,7 +984,10 @@ namespace dxvk {
     uint64_t sequenceNumber = GetCurrentSequenceNumber();
     pResource->TrackSequenceNumber(Subresource, sequenceNumber);
 
-    FlushImplicit(TRUE);
+    if (pResource->Desc()->CPUAccessFlags & D3D11_CPU_ACCESS_READ)
+      FlushReadback();
+    else
+      FlushImplicit(TRUE);
   }
 
 
@@ -753,7 +996,10 @@ namespace dxvk {
     uint64_t sequenceNumber = GetCurrentSequenceNumber();
     pResource->TrackSequenceNumber(sequenceNumber);
 
-    FlushImplicit(TRUE);
+    if (pResource->Desc()->CPUAccessFlags & D3D11_CPU_ACCESS_READ)
+      FlushReadback();
+    else
+      FlushImplicit(TRUE);
   }
 
 
@@ -766,20 +1012,28 @@ namespace dxvk {
 
 
   void D3D11ImmediateContext::FlushImplicit(BOOL StrongHint) {
-    // Flush only if the GPU is about to go idle, in
-    // order to keep the number of submissions low.
-    uint32_t pending = m_device->pendingSubmissions();
+    DxvkFlushHint hint = StrongHint
+      ? DxvkFlushHint::Strong
+      : DxvkFlushHint::Weak;
 
-    if (StrongHint || pending <= MaxPendingSubmits) {
-      auto now = dxvk::high_resolution_clock::now();
+    if (m_hasPendingReadback)
+      hint = DxvkFlushHint::Readback;
 
-      uint32_t delay = MinFlushIntervalUs
-                     + IncFlushIntervalUs * pending;
+    if (m_flushTracker.considerFlush(m_device.ptr(), hint, m_csSeqNum))
+      Flush();
+  }
 
-      // Prevent flushing too often in short intervals.
-      if (now - m_lastFlush >= std::chrono::microseconds(delay))
-        Flush();
-    }
+
+  void D3D11ImmediateContext::FlushReadback() {
+    // The application is likely going to map the resource for
+    // reading soon, so submit pending commands as early as we
+    // can in order to hide GPU latency. If we flushed recently,
+    // make the next implicit flush point submit regardless of
+    // the number of pending submissions.
+    if (m_flushTracker.considerFlush(m_device.ptr(), DxvkFlushHint::Readback, m_csSeqNum))
+      Flush();
+    else
+      m_hasPendingReadback = true;
   }
 
 
@@ -4,6 +4,8 @@
 
 #include "../util/sync/sync_signal.h"
 
+#include "../dxvk/dxvk_flush.h"
+
 #include "d3d11_context.h"
 #include "d3d11_state_object.h"
 #include "d3d11_video.h"
@@ -127,8 +129,9 @@ namespace dxvk {
 
     VkDeviceSize            m_maxImplicitDiscardSize = 0ull;
 
-    dxvk::high_resolution_clock::time_point m_lastFlush
-      = dxvk::high_resolution_clock::now();
+    bool                    m_hasPendingReadback = false;
+
+    DxvkFlushTracker        m_flushTracker;
     
     D3D11VideoContext            m_videoContext;
     Com<D3D11DeviceContextState> m_stateObject;
@@ -157,6 +160,22 @@ namespace dxvk {
       const void*                         pSrcData,
             UINT                          CopyFlags);
 
+    bool UpdateMappedImage(
+            D3D11CommonTexture*           pDstTexture,
+            UINT                          DstSubresource,
+      const D3D11_BOX*                    pDstBox,
+      const void*                         pSrcData,
+            UINT                          SrcRowPitch,
+            UINT                          SrcDepthPitch);
+
+    bool UpdateMappedStagingImage(
+            D3D11CommonTexture*           pDstTexture,
+            UINT                          DstSubresource,
+      const D3D11_BOX*                    pDstBox,
+      const void*                         pSrcData,
+            UINT                          SrcRowPitch,
+            UINT                          SrcDepthPitch);
+
     void SynchronizeDevice();
 
     void EndFrame();
@@ -180,6 +199,8 @@ namespace dxvk {
 
     void FlushImplicit(BOOL StrongHint);
 
+    void FlushReadback();
+
     void SignalEvent(HANDLE hEvent);
     
   };
@@ -12,6 +12,7 @@
 #include "d3d11_context_def.h"
 #include "d3d11_context_imm.h"
 #include "d3d11_device.h"
+#include "d3d11_fence.h"
 #include "d3d11_input_layout.h"
 #include "d3d11_interop.h"
 #include "d3d11_query.h"
@@ -42,7 +43,8 @@ namespace dxvk {
     m_dxvkAdapter   (m_dxvkDevice->adapter()),
     m_d3d11Formats  (m_dxvkAdapter),
     m_d3d11Options  (m_dxvkDevice->instance()->config(), m_dxvkDevice),
-    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options) {
+    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options),
+    m_csChunkPool   (m_dxvkDevice) {
     m_initializer = new D3D11Initializer(this);
     m_context     = new D3D11ImmediateContext(this, m_dxvkDevice);
     m_d3d10Device = new D3D10Device(this, m_context.ptr());
@@ -737,7 +739,7 @@ namespace dxvk {
     moduleInfo.tess    = nullptr;
     moduleInfo.xfb     = nullptr;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
     HRESULT hr = CreateShaderModule(&module,
@@ -769,7 +771,7 @@ namespace dxvk {
     moduleInfo.tess    = nullptr;
     moduleInfo.xfb     = nullptr;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
     HRESULT hr = CreateShaderModule(&module,
@@ -862,7 +864,7 @@ namespace dxvk {
       }
     }
 
-    Sha1Hash hash = Sha1Hash::compute(chunks.size(), chunks.data());
+    Sha1Hash hash = m_shaderModules.GetShaderHash(chunks.size(), chunks.data());
     
     // Create the actual shader module
     DxbcModuleInfo moduleInfo;
@@ -899,7 +901,7 @@ namespace dxvk {
     moduleInfo.tess    = nullptr;
     moduleInfo.xfb     = nullptr;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
 
@@ -938,7 +940,7 @@ namespace dxvk {
     if (tessInfo.maxTessFactor >= 8.0f)
       moduleInfo.tess = &tessInfo;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
     HRESULT hr = CreateShaderModule(&module,
@@ -969,7 +971,7 @@ namespace dxvk {
     moduleInfo.tess    = nullptr;
     moduleInfo.xfb     = nullptr;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
     HRESULT hr = CreateShaderModule(&module,
@@ -1000,7 +1002,7 @@ namespace dxvk {
     moduleInfo.tess    = nullptr;
     moduleInfo.xfb     = nullptr;
 
-    Sha1Hash hash = Sha1Hash::compute(
+    Sha1Hash hash = m_shaderModules.GetShaderHash(
       pShaderBytecode, BytecodeLength);
     
     HRESULT hr = CreateShaderModule(&module,
@@ -1351,12 +1353,13 @@ namespace dxvk {
           void**                      ppFence) {
     InitReturnPtr(ppFence);
 
-    static bool s_errorShown = false;
-
-    if (!std::exchange(s_errorShown, true))
-      Logger::err("D3D11Device::CreateFence: Not implemented");
-    
-    return E_NOTIMPL;
+    try {
+      Com<D3D11Fence> fence = new D3D11Fence(this, InitialValue, Flags, INVALID_HANDLE_VALUE);
+      return fence->QueryInterface(ReturnedInterface, ppFence);
+    } catch (const DxvkError& e) {
+      Logger::err(e.message());
+      return E_FAIL;
+    }
   }
 
 
@@ -1422,8 +1425,16 @@ namespace dxvk {
           void**      ppFence) {
     InitReturnPtr(ppFence);
 
-    Logger::err("D3D11Device::OpenSharedFence: Not implemented");
-    return E_NOTIMPL;
+    if (hFence == nullptr || hFence == INVALID_HANDLE_VALUE)
+      return E_INVALIDARG;
+
+    try {
+      Com<D3D11Fence> fence = new D3D11Fence(this, 0, D3D11_FENCE_FLAG_SHARED, hFence);
+      return fence->QueryInterface(ReturnedInterface, ppFence);
+    } catch (const DxvkError& e) {
+      Logger::err(e.message());
+      return E_FAIL;
+    }
   }
 
 
@@ -1893,6 +1904,12 @@ namespace dxvk {
   void D3D11Device::FlushInitContext() {
     m_initializer->Flush();
   }
+
+
+  void D3D11Device::InitPendingTexture(
+          D3D11CommonTexture*       pTexture) {
+    m_initializer->InitPendingTexture(pTexture);
+  }
   
   
   bool D3D11Device::CheckFeatureLevelSupport(
@@ -1929,6 +1946,8 @@ namespace dxvk {
 
     enabled.extMemoryPriority.memoryPriority                      = supported.extMemoryPriority.memoryPriority;
 
+    enabled.extMultiDraw.multiDraw                                = supported.extMultiDraw.multiDraw;
+
     enabled.extRobustness2.robustBufferAccess2                    = supported.extRobustness2.robustBufferAccess2;
     enabled.extRobustness2.robustImageAccess2                     = supported.extRobustness2.robustImageAccess2;
 
@@ -2018,15 +2037,25 @@ namespace dxvk {
     if (FAILED(hr))
       return hr;
 
-    auto shader = commonShader.GetShader();
+    // Checking shader flags requires the translated shader, so
+    // only wait for translation if an extension is unsupported
+    const auto& extensions = m_dxvkDevice->extensions();
 
-    if (shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
-     && !m_dxvkDevice->extensions().extShaderStencilExport)
-      return E_INVALIDARG;
+    if (!extensions.extShaderStencilExport
+     || !extensions.extShaderViewportIndexLayer) {
+      auto shader = commonShader.GetShader();
 
-    if (shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
-     && !m_dxvkDevice->extensions().extShaderViewportIndexLayer)
-      return E_INVALIDARG;
+      if (shader == nullptr)
+        return E_INVALIDARG;
+
+      if (shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
+       && !extensions.extShaderStencilExport)
+        return E_INVALIDARG;
+
+      if (shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
+       && !extensions.extShaderViewportIndexLayer)
+        return E_INVALIDARG;
+    }
 
     *pShaderModule = std::move(commonShader);
     return S_OK;
@@ -2853,8 +2882,16 @@ namespace dxvk {
     const D3D11_VIDEO_DECODER_DESC*                     pVideoDesc,
     const D3D11_VIDEO_DECODER_CONFIG*                   pConfig,
           ID3D11VideoDecoder**                          ppDecoder) {
-    Logger::err("D3D11VideoDevice::CreateVideoDecoder: Stub");
-    return E_NOTIMPL;
+    InitReturnPtr(ppDecoder);
+
+    // We do not expose any decoder profiles, so any
+    // valid decoder description is unsupported
+    static bool s_errorShown = false;
+
+    if (!std::exchange(s_errorShown, true))
+      Logger::warn("D3D11VideoDevice::CreateVideoDecoder: Hardware video decoding not supported");
+
+    return E_INVALIDARG;
   }
 
 
@@ -2944,7 +2981,6 @@ namespace dxvk {
 
 
   UINT STDMETHODCALLTYPE D3D11VideoDevice::GetVideoDecoderProfileCount() {
-    Logger::err("D3D11VideoDevice::GetVideoDecoderProfileCount: Stub");
     return 0;
   }
 
@@ -2952,8 +2988,9 @@ namespace dxvk {
   HRESULT STDMETHODCALLTYPE D3D11VideoDevice::GetVideoDecoderProfile(
           UINT                                          Index,
           GUID*                                         pDecoderProfile) {
-    Logger::err("D3D11VideoDevice::GetVideoDecoderProfile: Stub");
-    return E_NOTIMPL;
+    // No decoder profiles are exposed, so the
+    // index is out of range for any profile
+    return E_INVALIDARG;
   }
 
 
@@ -2961,16 +2998,20 @@ namespace dxvk {
     const GUID*                                         pDecoderProfile,
           DXGI_FORMAT                                   Format,
           BOOL*                                         pSupported) {
-    Logger::err("D3D11VideoDevice::CheckVideoDecoderFormat: Stub");
-    return E_NOTIMPL;
+    if (pSupported)
+      *pSupported = FALSE;
+
+    return E_INVALIDARG;
   }
 
 
   HRESULT STDMETHODCALLTYPE D3D11VideoDevice::GetVideoDecoderConfigCount(
     const D3D11_VIDEO_DECODER_DESC*                     pDesc,
           UINT*                                         pCount) {
-    Logger::err("D3D11VideoDevice::GetVideoDecoderConfigCount: Stub");
-    return E_NOTIMPL;
+    if (pCount)
+      *pCount = 0;
+
+    return E_INVALIDARG;
   }
 
 
@@ -2978,8 +3019,7 @@ namespace dxvk {
     const D3D11_VIDEO_DECODER_DESC*                     pDesc,
           UINT                                          Index,
           D3D11_VIDEO_DECODER_CONFIG*                   pConfig) {
-    Logger::err("D3D11VideoDevice::GetVideoDecoderConfig: Stub");
-    return E_NOTIMPL;
+    return E_INVALIDARG;
   }
 
 
@@ -391,6 +391,9 @@ namespace dxvk {
     }
     
     void FlushInitContext();
+
+    void InitPendingTexture(
+            D3D11CommonTexture*       pTexture);
     
     VkPipelineStageFlags GetEnabledShaderStages() const {
       return m_dxvkDevice->getShaderPipelineStages();
@@ -408,8 +411,8 @@ namespace dxvk {
             DXGI_FORMAT           Format,
             DXGI_VK_FORMAT_MODE   Mode) const;
     
-    DxvkCsChunkRef AllocCsChunk(DxvkCsChunkFlags flags) {
-      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(flags);
+    DxvkCsChunkRef AllocCsChunk(DxvkCsChunkFlags flags, uint32_t sizeClass) {
+      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(flags, sizeClass);
       return DxvkCsChunkRef(chunk, &m_csChunkPool);
     }
     
@@ -0,0 +1,112 @@
+#include "d3d11_device.h"
+#include "d3d11_fence.h"
+
+namespace dxvk {
+
+  D3D11Fence::D3D11Fence(
+          D3D11Device*        pDevice,
+          UINT64              InitialValue,
+          D3D11_FENCE_FLAG    Flags,
+          HANDLE              hFence)
+  : D3D11DeviceChild<ID3D11Fence>(pDevice),
+    m_flags(Flags) {
+    DxvkFenceCreateInfo fenceInfo;
+    fenceInfo.initialValue = InitialValue;
+
+    if (Flags & D3D11_FENCE_FLAG_SHARED) {
+      fenceInfo.sharingType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_D3D11_FENCE_BIT;
+
+      if (hFence == nullptr || hFence == INVALID_HANDLE_VALUE) {
+        fenceInfo.sharingMode = DxvkSharedHandleMode::Export;
+      } else {
+        fenceInfo.sharingMode = DxvkSharedHandleMode::Import;
+#ifdef _WIN32
+        fenceInfo.sharedHandle = hFence;
+#endif
+      }
+    }
+
+    if (Flags & ~D3D11_FENCE_FLAG_SHARED)
+      Logger::warn(str::format("D3D11Fence: Unsupported flags: ", std::hex, Flags & ~D3D11_FENCE_FLAG_SHARED));
+
+    m_fence = pDevice->GetDXVKDevice()->createFence(fenceInfo);
+  }
+
+
+  D3D11Fence::~D3D11Fence() {
+
+  }
+
+
+  HRESULT STDMETHODCALLTYPE D3D11Fence::QueryInterface(
+          REFIID              riid,
+          void**              ppvObject) {
+    if (ppvObject == nullptr)
+      return E_POINTER;
+
+    *ppvObject = nullptr;
+
+    if (riid == __uuidof(IUnknown)
+     || riid == __uuidof(ID3D11DeviceChild)
+     || riid == __uuidof(ID3D11Fence)) {
+      *ppvObject = ref(this);
+      return S_OK;
+    }
+
+    Logger::warn("D3D11Fence: Unknown interface query");
+    Logger::warn(str::format(riid));
+    return E_NOINTERFACE;
+  }
+
+
+  HRESULT STDMETHODCALLTYPE D3D11Fence::CreateSharedHandle(
+    const SECURITY_ATTRIBUTES* pAttributes,
+          DWORD               dwAccess,
+          LPCWSTR             lpName,
+          HANDLE*             pHandle) {
+    if (!(m_flags & D3D11_FENCE_FLAG_SHARED) || pHandle == nullptr)
+      return E_INVALIDARG;
+
+    if (pAttributes)
+      Logger::warn("D3D11Fence::CreateSharedHandle: attributes not supported");
+
+    if (lpName)
+      Logger::warn("D3D11Fence::CreateSharedHandle: naming shared fences not supported");
+
+    HANDLE sharedHandle = m_fence->sharedHandle();
+
+    if (sharedHandle == INVALID_HANDLE_VALUE)
+      return E_INVALIDARG;
+
+    *pHandle = sharedHandle;
+    return S_OK;
+  }
+
+
+  HRESULT STDMETHODCALLTYPE D3D11Fence::SetEventOnCompletion(
+          UINT64              Value,
+          HANDLE              hEvent) {
+    if (hEvent) {
+      m_fence->enqueueWait(Value, [hEvent] {
+        SetEvent(hEvent);
+      });
+    } else {
+      // Block until the fence reaches the given value
+      sync::Fence fence(0);
+
+      m_fence->enqueueWait(Value, [&fence] {
+        fence.signal(1);
+      });
+
+      fence.wait(1);
+    }
+
+    return S_OK;
+  }
+
+
+  UINT64 STDMETHODCALLTYPE D3D11Fence::GetCompletedValue() {
+    return m_fence->getValue();
+  }
+
+}
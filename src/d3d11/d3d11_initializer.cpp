@@ -9,20 +9,30 @@ namespace dxvk {
           D3D11Device*                pParent)
   : m_parent(pParent),
     m_device(pParent->GetDXVKDevice()),
-    m_context(m_device->createContext(DxvkContextType::Supplementary)) {
+    m_context(m_device->createContext(DxvkContextType::Supplementary)),
+    m_uploadStaging(m_device, StagingBufferSize) {
     m_context->beginRecording(
       m_device->createCommandList());
+
+    m_uploadThread = dxvk::thread([this] () { UploadThread(); });
   }
 
   
   D3D11Initializer::~D3D11Initializer() {
+    { std::lock_guard<dxvk::mutex> lock(m_uploadMutex);
+      m_uploadStop = true;
+      m_uploadCond.notify_one();
+    }
 
+    m_uploadThread.join();
   }
 
 
   void D3D11Initializer::Flush() {
     std::lock_guard<dxvk::mutex> lock(m_mutex);
 
+    ExecuteUploads();
+
     if (m_transferCommands != 0)
       FlushInternal();
   }
@@ -69,25 +79,36 @@ namespace dxvk {
   void D3D11Initializer::InitDeviceLocalBuffer(
           D3D11Buffer*                pBuffer,
     const D3D11_SUBRESOURCE_DATA*     pInitialData) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-
     DxvkBufferSlice bufferSlice = pBuffer->GetBufferSlice();
 
     if (pInitialData != nullptr && pInitialData->pSysMem != nullptr) {
-      m_transferMemory   += bufferSlice.length();
-      m_transferCommands += 1;
-      
-      m_context->uploadBuffer(
-        bufferSlice.buffer(),
-        pInitialData->pSysMem);
+      // Copy the data to the shared staging buffer right away
+      // and leave recording the copy to the upload thread, so
+      // that we do not have to wait for the context lock.
+      std::lock_guard<dxvk::mutex> lock(m_uploadMutex);
+
+      D3D11PendingBufferUpload upload;
+      upload.buffer = bufferSlice.buffer();
+      upload.source = m_uploadStaging.alloc(CACHE_LINE_SIZE, bufferSlice.length());
+
+      std::memcpy(upload.source.mapPtr(0),
+        pInitialData->pSysMem, bufferSlice.length());
+
+      m_uploads.push_back(std::move(upload));
+      m_uploadMemory += bufferSlice.length();
+
+      if (m_uploads.size() >= MaxTransferCommands
+       || m_uploadMemory   >= MaxTransferMemory)
+        m_uploadCond.notify_one();
     } else {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
       m_transferCommands += 1;
 
       m_context->initBuffer(
         bufferSlice.buffer());
-    }
 
-    FlushImplicit();
+      FlushImplicit();
+    }
   }
 
 
@@ -174,19 +195,12 @@ namespace dxvk {
       }
     } else {
       if (mapMode != D3D11_COMMON_TEXTURE_MAP_MODE_STAGING) {
-        m_transferCommands += 1;
-        
-        // While the Microsoft docs state that resource contents are
-        // undefined if no initial data is provided, some applications
-        // expect a resource to be pre-cleared.
-        VkImageSubresourceRange subresources;
-        subresources.aspectMask     = formatInfo->aspectMask;
-        subresources.baseMipLevel   = 0;
-        subresources.levelCount     = desc->MipLevels;
-        subresources.baseArrayLayer = 0;
-        subresources.layerCount     = desc->ArraySize;
-
-        m_context->initImage(image, subresources, VK_IMAGE_LAYOUT_UNDEFINED);
+        // Clearing a lazily allocated image would bind memory
+        // to it right away, so only do that on first use.
+        if (image->isAllocated())
+          ClearDeviceLocalTexture(pTexture, image);
+        else
+          pTexture->SetInitPending();
       }
 
       if (mapMode != D3D11_COMMON_TEXTURE_MAP_MODE_NONE) {
@@ -201,6 +215,21 @@ namespace dxvk {
   }
 
 
+  void D3D11Initializer::InitPendingTexture(
+          D3D11CommonTexture*         pTexture) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    // Another thread may have initialized the image already
+    Rc<DxvkImage> image = pTexture->ClaimPendingInit();
+
+    if (image == nullptr)
+      return;
+
+    ClearDeviceLocalTexture(pTexture, image);
+    FlushImplicit();
+  }
+
+
   void D3D11Initializer::InitHostVisibleTexture(
           D3D11CommonTexture*         pTexture,
     const D3D11_SUBRESOURCE_DATA*     pInitialData) {
@@ -253,6 +282,30 @@ namespace dxvk {
   }
 
 
+  void D3D11Initializer::ClearDeviceLocalTexture(
+          D3D11CommonTexture*         pTexture,
+    const Rc<DxvkImage>&              image) {
+    auto desc = pTexture->Desc();
+
+    VkFormat packedFormat = m_parent->LookupPackedFormat(desc->Format, pTexture->GetFormatMode()).Format;
+    auto formatInfo = imageFormatInfo(packedFormat);
+
+    m_transferCommands += 1;
+
+    // While the Microsoft docs state that resource contents are
+    // undefined if no initial data is provided, some applications
+    // expect a resource to be pre-cleared.
+    VkImageSubresourceRange subresources;
+    subresources.aspectMask     = formatInfo->aspectMask;
+    subresources.baseMipLevel   = 0;
+    subresources.levelCount     = desc->MipLevels;
+    subresources.baseArrayLayer = 0;
+    subresources.layerCount     = desc->ArraySize;
+
+    m_context->initImage(image, subresources, VK_IMAGE_LAYOUT_UNDEFINED);
+  }
+
+
   void D3D11Initializer::FlushImplicit() {
     if (m_transferCommands > MaxTransferCommands
      || m_transferMemory   > MaxTransferMemory)
@@ -267,4 +320,48 @@ namespace dxvk {
     m_transferMemory   = 0;
   }
 
+
+  void D3D11Initializer::ExecuteUploads() {
+    { std::lock_guard<dxvk::mutex> lock(m_uploadMutex);
+      std::swap(m_uploads, m_uploadsExecuting);
+      m_uploadMemory = 0;
+    }
+
+    // Record all copies in one go. Each buffer gets its own
+    // copy command since every buffer is a separate Vulkan
+    // buffer, but barriers are batched by the context.
+    for (const auto& upload : m_uploadsExecuting) {
+      m_transferCommands += 1;
+      m_transferMemory   += upload.source.length();
+
+      m_context->uploadBuffer(upload.buffer, upload.source);
+
+      FlushImplicit();
+    }
+
+    m_uploadsExecuting.clear();
+  }
+
+
+  void D3D11Initializer::UploadThread() {
+    env::setThreadName("dxvk-initializer");
+
+    while (true) {
+      { std::unique_lock<dxvk::mutex> lock(m_uploadMutex);
+
+        m_uploadCond.wait(lock, [this] {
+          return m_uploadStop
+              || m_uploads.size() >= MaxTransferCommands
+              || m_uploadMemory   >= MaxTransferMemory;
+        });
+
+        if (m_uploadStop)
+          return;
+      }
+
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      ExecuteUploads();
+    }
+  }
+
 }
\ No newline at end of file
@@ -7,6 +7,18 @@ namespace dxvk {
 
   class D3D11Device;
 
+  /**
+   * \brief Pending buffer upload
+   *
+   * Initial buffer data that has already been
+   * copied to a shared staging buffer, but for
+   * which no copy command has been recorded yet.
+   */
+  struct D3D11PendingBufferUpload {
+    Rc<DxvkBuffer>    buffer;
+    DxvkBufferSlice   source;
+  };
+
   /**
    * \brief Resource initialization context
    * 
@@ -14,10 +26,16 @@ namespace dxvk {
    * initialization. This includes initialization
    * with application-defined data, as well as
    * zero-initialization for buffers and images.
+   *
+   * Initial buffer data is packed into large staging
+   * buffers, and copy commands are recorded in batches
+   * on a worker thread, so that buffer creation does
+   * not have to wait for the context.
    */
   class D3D11Initializer {
     constexpr static size_t MaxTransferMemory    = 32 * 1024 * 1024;
     constexpr static size_t MaxTransferCommands  = 512;
+    constexpr static size_t StagingBufferSize    = 4 * 1024 * 1024;
   public:
 
     D3D11Initializer(
@@ -37,6 +55,9 @@ namespace dxvk {
 
     void InitUavCounter(
             D3D11UnorderedAccessView*   pUav);
+
+    void InitPendingTexture(
+            D3D11CommonTexture*         pTexture);
     
   private:
 
@@ -49,6 +70,17 @@ namespace dxvk {
     size_t            m_transferCommands  = 0;
     size_t            m_transferMemory    = 0;
 
+    dxvk::mutex               m_uploadMutex;
+    dxvk::condition_variable  m_uploadCond;
+    DxvkStagingBuffer         m_uploadStaging;
+    size_t                    m_uploadMemory = 0;
+    bool                      m_uploadStop   = false;
+
+    std::vector<D3D11PendingBufferUpload> m_uploads;
+    std::vector<D3D11PendingBufferUpload> m_uploadsExecuting;
+
+    dxvk::thread              m_uploadThread;
+
     void InitDeviceLocalBuffer(
             D3D11Buffer*                pBuffer,
       const D3D11_SUBRESOURCE_DATA*     pInitialData);
@@ -65,9 +97,17 @@ namespace dxvk {
             D3D11CommonTexture*         pTexture,
       const D3D11_SUBRESOURCE_DATA*     pInitialData);
     
+    void ClearDeviceLocalTexture(
+            D3D11CommonTexture*         pTexture,
+      const Rc<DxvkImage>&              image);
+
     void FlushImplicit();
     void FlushInternal();
 
+    void ExecuteUploads();
+
+    void UploadThread();
+
   };
 
 }
\ No newline at end of file
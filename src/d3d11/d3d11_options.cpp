@@ -22,6 +22,8 @@ namespace dxvk {
     this->numBackBuffers        = config.getOption<int32_t>("dxgi.numBackBuffers", 0);
     this->maxFrameLatency       = config.getOption<int32_t>("dxgi.maxFrameLatency", 0);
     this->maxFrameRate          = config.getOption<int32_t>("dxgi.maxFrameRate", 0);
+    this->lowLatencyMode        = config.getOption<bool>("dxgi.lowLatencyMode", false);
+    this->alignFrameRateToVblank = config.getOption<bool>("dxgi.alignFrameRateToVblank", false);
     this->syncInterval          = config.getOption<int32_t>("dxgi.syncInterval", -1);
     this->tearFree              = config.getOption<Tristate>("dxgi.tearFree", Tristate::Auto);
 
@@ -35,6 +37,9 @@ namespace dxvk {
       ? VkDeviceSize(maxDynamicImageBufferSize) << 10
       : VkDeviceSize(~0ull);
 
+    this->linearStagingTextures = config.getOption<bool>("d3d11.linearStagingTextures", false);
+    this->transientDepthBuffers = config.getOption<bool>("d3d11.transientDepthBuffers", true);
+
     this->constantBufferRangeCheck = config.getOption<bool>("d3d11.constantBufferRangeCheck", false)
       && DxvkGpuVendor(devInfo.core.properties.vendorID) != DxvkGpuVendor::Amd;
 
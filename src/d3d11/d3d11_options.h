@@ -92,12 +92,28 @@ namespace dxvk {
     /// Limit frame rate
     int32_t maxFrameRate;
 
+    /// Align frame rate limiter to measured vblanks
+    bool alignFrameRateToVblank;
+
+    /// Delay frame start based on measured GPU
+    /// completion in order to reduce input latency
+    bool lowLatencyMode;
+
     /// Limit discardable resource size
     VkDeviceSize maxImplicitDiscardSize;
 
     /// Limit size of buffer-mapped images
     VkDeviceSize maxDynamicImageBufferSize;
 
+    /// Back staging textures with linear images rather
+    /// than buffers, so that mapping them for readback
+    /// does not require an image to buffer copy.
+    bool linearStagingTextures;
+
+    /// Back multisampled depth buffers that are never sampled
+    /// or copied with lazily allocated memory where available.
+    bool transientDepthBuffers;
+
     /// Defer surface creation until first present call. This
     /// fixes issues with games that create multiple swap chains
     /// for a single window that may interfere with each other.
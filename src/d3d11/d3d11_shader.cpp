@@ -3,6 +3,145 @@
 
 namespace dxvk {
   
+  D3D11CommonShaderState::D3D11CommonShaderState(
+          DxvkDevice*         pDevice,
+    const DxvkShaderKey*      pShaderKey,
+    const DxbcModuleInfo*     pDxbcModuleInfo,
+    const Sha1Hash&           CacheHash,
+          std::unique_ptr<DxbcModule>&& Module,
+          bool                Passthrough)
+  : m_device      (pDevice),
+    m_key         (*pShaderKey),
+    m_name        (pShaderKey->toString()),
+    m_moduleInfo  (*pDxbcModuleInfo),
+    m_tessInfo    (),
+    m_cacheHash   (CacheHash),
+    m_module      (std::move(Module)),
+    m_passthrough (Passthrough) {
+    // Keep our own copy of the tessellation info since
+    // the shader may be translated after this returns
+    if (pDxbcModuleInfo->tess) {
+      m_tessInfo = *pDxbcModuleInfo->tess;
+      m_moduleInfo.tess = &m_tessInfo;
+    }
+  }
+
+
+  D3D11CommonShaderState::D3D11CommonShaderState(
+          DxvkDevice*         pDevice,
+    const Rc<DxvkShader>&     Shader)
+  : m_device      (pDevice),
+    m_key         (Shader->getShaderKey()),
+    m_name        (m_key.toString()),
+    m_moduleInfo  (),
+    m_tessInfo    () {
+    FinalizeShader(Shader);
+    m_status.store(StatusDone, std::memory_order_release);
+  }
+
+
+  D3D11CommonShaderState::~D3D11CommonShaderState() {
+
+  }
+
+
+  bool D3D11CommonShaderState::Translate() {
+    uint32_t status = StatusPending;
+
+    if (!m_status.compare_exchange_strong(status, StatusRunning, std::memory_order_acquire))
+      return true;
+
+    bool success = true;
+
+    try {
+      Logger::debug(str::format("Compiling shader ", m_name));
+
+      Rc<DxvkShader> shader = m_passthrough
+        ? m_module->compilePassthroughShader(m_moduleInfo, m_name)
+        : m_module->compile                 (m_moduleInfo, m_name);
+      shader->setShaderKey(m_key);
+
+      // Stream output declarations are not part of the shader
+      // key, so shaders using stream output are never cached.
+      if (m_moduleInfo.xfb == nullptr)
+        m_device->getShaderCache().addShader(shader, m_cacheHash);
+
+      FinalizeShader(shader);
+    } catch (const DxvkError& e) {
+      Logger::err(str::format("Failed to compile shader ", m_name, ": ", e.message()));
+      success = false;
+    }
+
+    // The DXBC module is no longer needed, and stream
+    // output info is owned by the caller of Translate
+    m_module = nullptr;
+    m_moduleInfo.xfb = nullptr;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_status.store(StatusDone, std::memory_order_release);
+    }
+
+    m_cond.notify_all();
+    return success;
+  }
+
+
+  Rc<DxvkShader> D3D11CommonShaderState::WaitForShader() {
+    // Translate the shader on the calling thread
+    // if no worker has picked it up yet
+    Translate();
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_status.load(std::memory_order_acquire) == StatusDone;
+    });
+
+    return m_shader;
+  }
+
+
+  void D3D11CommonShaderState::FinalizeShader(
+    const Rc<DxvkShader>&     Shader) {
+    // If requested by the user, dump the
+    // compiled SPIR-V module to a file.
+    const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
+
+    if (dumpPath.size() != 0) {
+      std::ofstream dumpStream(
+        str::tows(str::format(dumpPath, "/", m_name, ".spv").c_str()).c_str(),
+        std::ios_base::binary | std::ios_base::trunc);
+      
+      Shader->dump(dumpStream);
+    }
+    
+    // Create shader constant buffer if necessary
+    const DxvkShaderCreateInfo& shaderInfo = Shader->info();
+
+    if (shaderInfo.uniformSize) {
+      DxvkBufferCreateInfo info;
+      info.size   = shaderInfo.uniformSize;
+      info.usage  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+      info.stages = util::pipelineStages(shaderInfo.stage);
+      info.access = VK_ACCESS_UNIFORM_READ_BIT;
+      
+      VkMemoryPropertyFlags memFlags
+        = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+        | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+      
+      m_buffer = m_device->createBuffer(info, memFlags);
+      std::memcpy(m_buffer->mapPtr(0), shaderInfo.uniformData, shaderInfo.uniformSize);
+
+      // The buffer now holds the only copy we need
+      Shader->releaseUniformData();
+    }
+
+    m_device->registerShader(Shader);
+    m_shader = Shader;
+  }
+
+
   D3D11CommonShader:: D3D11CommonShader() { }
   D3D11CommonShader::~D3D11CommonShader() { }
   
@@ -14,16 +153,13 @@ namespace dxvk {
     const void*           pShaderBytecode,
           size_t          BytecodeLength) {
     const std::string name = pShaderKey->toString();
-    Logger::debug(str::format("Compiling shader ", name));
-    
+
     DxbcReader reader(
       reinterpret_cast<const char*>(pShaderBytecode),
       BytecodeLength);
     
-    DxbcModule module(reader);
-    
-    // If requested by the user, dump both the raw DXBC
-    // shader and the compiled SPIR-V module to a file.
+    // If requested by the user, dump the raw DXBC shader
+    // to a file. The SPIR-V module is dumped once compiled.
     const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
     
     if (dumpPath.size() != 0) {
@@ -31,53 +167,111 @@ namespace dxvk {
         std::ios_base::binary | std::ios_base::trunc));
     }
     
+    Rc<DxvkDevice> device = pDevice->GetDXVKDevice();
+
+    DxvkShaderCache& shaderCache = device->getShaderCache();
+    Sha1Hash shaderCacheHash = GetShaderCacheHash(pDxbcModuleInfo);
+
+    if (pDxbcModuleInfo->xfb == nullptr) {
+      Rc<DxvkShader> shader = shaderCache.findShader(*pShaderKey, shaderCacheHash);
+
+      if (shader != nullptr) {
+        m_state = std::make_shared<D3D11CommonShaderState>(device.ptr(), shader);
+        return;
+      }
+    }
+
+    // Parse the module right away so that invalid
+    // shaders are still rejected at creation time
+    auto module = std::make_unique<DxbcModule>(reader);
+
     // Decide whether we need to create a pass-through
     // geometry shader for vertex shader stream output
     bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
-      && (module.programInfo().type() == DxbcProgramType::VertexShader
-       || module.programInfo().type() == DxbcProgramType::DomainShader);
+      && (module->programInfo().type() == DxbcProgramType::VertexShader
+       || module->programInfo().type() == DxbcProgramType::DomainShader);
 
-    if (module.programInfo().shaderStage() != pShaderKey->type() && !passthroughShader)
+    if (module->programInfo().shaderStage() != pShaderKey->type() && !passthroughShader)
       throw DxvkError("Mismatching shader type.");
 
-    m_shader = passthroughShader
-      ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
-      : module.compile                 (*pDxbcModuleInfo, name);
-    m_shader->setShaderKey(*pShaderKey);
-    
-    if (dumpPath.size() != 0) {
-      std::ofstream dumpStream(
-        str::tows(str::format(dumpPath, "/", name, ".spv").c_str()).c_str(),
-        std::ios_base::binary | std::ios_base::trunc);
-      
-      m_shader->dump(dumpStream);
-    }
-    
-    // Create shader constant buffer if necessary
-    const DxvkShaderCreateInfo& shaderInfo = m_shader->info();
+    m_state = std::make_shared<D3D11CommonShaderState>(device.ptr(),
+      pShaderKey, pDxbcModuleInfo, shaderCacheHash,
+      std::move(module), passthroughShader);
+
+    // Stream output declarations reference memory owned by
+    // the application, so those shaders cannot be translated
+    // asynchronously. All other shaders get translated once
+    // the caller starts the translation.
+    if (pDxbcModuleInfo->xfb != nullptr && !m_state->Translate())
+      throw DxvkError(str::format("Failed to compile shader ", name));
+  }
 
-    if (shaderInfo.uniformSize) {
-      DxvkBufferCreateInfo info;
-      info.size   = shaderInfo.uniformSize;
-      info.usage  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-      info.stages = util::pipelineStages(shaderInfo.stage);
-      info.access = VK_ACCESS_UNIFORM_READ_BIT;
-      
-      VkMemoryPropertyFlags memFlags
-        = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-        | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-      
-      m_buffer = pDevice->GetDXVKDevice()->createBuffer(info, memFlags);
-      std::memcpy(m_buffer->mapPtr(0), shaderInfo.uniformData, shaderInfo.uniformSize);
-    }
 
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
+  void D3D11CommonShader::StartTranslation() const {
+    if (m_state == nullptr || !m_state->IsPending())
+      return;
+
+    // The task only holds a weak reference so that it does
+    // not keep shaders alive past the lifetime of the device
+    m_state->GetDevice()->runShaderTask([
+      cState = std::weak_ptr<D3D11CommonShaderState>(m_state)
+    ] {
+      auto state = cState.lock();
+
+      if (state != nullptr)
+        state->Translate();
+    });
   }
 
   
-  D3D11ShaderModuleSet:: D3D11ShaderModuleSet() { }
-  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() { }
+  Sha1Hash D3D11CommonShader::GetShaderCacheHash(
+    const DxbcModuleInfo* pDxbcModuleInfo) {
+    Sha1Hash optionsHash = pDxbcModuleInfo->options.hash();
+
+    float maxTessFactor = pDxbcModuleInfo->tess
+      ? pDxbcModuleInfo->tess->maxTessFactor
+      : 0.0f;
+
+    std::array<Sha1Data, 2> chunks = {{
+      { &optionsHash,   sizeof(optionsHash)   },
+      { &maxTessFactor, sizeof(maxTessFactor) },
+    }};
+
+    return Sha1Hash::compute(chunks.size(), chunks.data());
+  }
+
+
+  D3D11ShaderModuleSet::D3D11ShaderModuleSet() {
+    m_modules.setLockName("D3D11ShaderModuleSet::modules");
+    m_hashes.setLockName("D3D11ShaderModuleSet::hashes");
+  }
+
+
+  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() {
+    m_modules.forEach([] (const DxvkShaderKey& key, const D3D11CommonShader& module) {
+      module.GetShader();
+    });
+  }
+
+
+  Sha1Hash D3D11ShaderModuleSet::GetShaderHash(
+          size_t              NumChunks,
+    const Sha1Data*           pChunks) {
+    Hash128 key;
+
+    for (size_t i = 0; i < NumChunks; i++) {
+      key = i ? Hash128::compute(pChunks[i].data, pChunks[i].size, key)
+              : Hash128::compute(pChunks[i].data, pChunks[i].size);
+    }
+
+    auto entry = m_hashes.find(key);
+
+    if (entry)
+      return *entry;
+
+    Sha1Hash hash = Sha1Hash::compute(NumChunks, pChunks);
+    return *m_hashes.emplace(key, hash).first;
+  }
   
   
   HRESULT D3D11ShaderModuleSet::GetShaderModule(
@@ -88,13 +282,11 @@ namespace dxvk {
           size_t              BytecodeLength,
           D3D11CommonShader*  pShader) {
     // Use the shader's unique key for the lookup
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      
-      auto entry = m_modules.find(*pShaderKey);
-      if (entry != m_modules.end()) {
-        *pShader = entry->second;
-        return S_OK;
-      }
+    auto entry = m_modules.find(*pShaderKey);
+
+    if (entry) {
+      *pShader = *entry;
+      return S_OK;
     }
     
     // This shader has not been compiled yet, so we have to create a
@@ -112,15 +304,17 @@ namespace dxvk {
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      
-      auto status = m_modules.insert({ *pShaderKey, module });
-      if (!status.second) {
-        *pShader = status.first->second;
-        return S_OK;
-      }
+    auto status = m_modules.emplace(*pShaderKey, module);
+
+    if (!status.second) {
+      *pShader = *status.first;
+      return S_OK;
     }
     
+    // Only translate the shader once we know that
+    // it is not a duplicate of an existing one
+    module.StartTranslation();
+
     *pShader = std::move(module);
     return S_OK;
   }
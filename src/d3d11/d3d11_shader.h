@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -10,7 +12,10 @@
 
 #include "../util/sha1/sha1_util.h"
 
+#include "../util/sync/sync_hashmap.h"
+
 #include "../util/util_env.h"
+#include "../util/util_hash128.h"
 
 #include "d3d11_device_child.h"
 #include "d3d11_interfaces.h"
@@ -18,13 +23,129 @@
 namespace dxvk {
   
   class D3D11Device;
+
+  /**
+   * \brief Shader translation state
+   *
+   * Holds the parsed DXBC module of a shader until it
+   * is translated, as well as the translated shader.
+   * Translation normally runs on a worker thread, but
+   * if the shader is needed before any worker gets to
+   * it, the thread that needs it translates it itself.
+   */
+  class D3D11CommonShaderState {
+    constexpr static uint32_t StatusPending = 0;
+    constexpr static uint32_t StatusRunning = 1;
+    constexpr static uint32_t StatusDone    = 2;
+  public:
+
+    D3D11CommonShaderState(
+            DxvkDevice*         pDevice,
+      const DxvkShaderKey*      pShaderKey,
+      const DxbcModuleInfo*     pDxbcModuleInfo,
+      const Sha1Hash&           CacheHash,
+            std::unique_ptr<DxbcModule>&& Module,
+            bool                Passthrough);
+
+    D3D11CommonShaderState(
+            DxvkDevice*         pDevice,
+      const Rc<DxvkShader>&     Shader);
+
+    ~D3D11CommonShaderState();
+
+    /**
+     * \brief Retrieves translated shader
+     *
+     * Waits for translation to complete, or
+     * translates the shader on the calling
+     * thread if it has not started yet.
+     * \returns Shader, or \c nullptr on error
+     */
+    Rc<DxvkShader> GetShader() {
+      if (likely(m_status.load(std::memory_order_acquire) == StatusDone))
+        return m_shader;
+
+      return WaitForShader();
+    }
+
+    /**
+     * \brief Retrieves immediate constant buffer
+     * \returns Constant buffer, if any
+     */
+    Rc<DxvkBuffer> GetIcb() {
+      GetShader();
+      return m_buffer;
+    }
+
+    /**
+     * \brief Retrieves shader name
+     * \returns Shader name
+     */
+    const std::string& GetName() const {
+      return m_name;
+    }
+
+    /**
+     * \brief Retrieves the device
+     * \returns DXVK device
+     */
+    DxvkDevice* GetDevice() const {
+      return m_device;
+    }
+
+    /**
+     * \brief Checks whether translation is pending
+     * \returns \c true if translation has not started
+     */
+    bool IsPending() const {
+      return m_status.load(std::memory_order_acquire) == StatusPending;
+    }
+
+    /**
+     * \brief Translates the shader
+     *
+     * Does nothing if translation has already
+     * been started by a different thread.
+     * \returns \c false if translation failed
+     */
+    bool Translate();
+
+  private:
+
+    DxvkDevice*                 m_device;
+    DxvkShaderKey               m_key;
+    std::string                 m_name;
+
+    DxbcModuleInfo              m_moduleInfo;
+    DxbcTessInfo                m_tessInfo;
+    Sha1Hash                    m_cacheHash;
+
+    std::unique_ptr<DxbcModule> m_module;
+    bool                        m_passthrough = false;
+
+    std::atomic<uint32_t>       m_status = { StatusPending };
+    dxvk::mutex                 m_mutex;
+    dxvk::condition_variable    m_cond;
+
+    Rc<DxvkShader>              m_shader;
+    Rc<DxvkBuffer>              m_buffer;
+
+    Rc<DxvkShader> WaitForShader();
+
+    void FinalizeShader(
+      const Rc<DxvkShader>&     Shader);
+
+  };
   
   /**
    * \brief Common shader object
    * 
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
-   * used to identify the shader.
+   * used to identify the shader. Shaders that are
+   * not found in the shader cache are translated
+   * asynchronously, and any method that needs the
+   * translated shader waits for the translation.
    */
   class D3D11CommonShader {
     
@@ -40,21 +161,31 @@ namespace dxvk {
     ~D3D11CommonShader();
 
     Rc<DxvkShader> GetShader() const {
-      return m_shader;
+      return m_state != nullptr ? m_state->GetShader() : nullptr;
     }
 
     Rc<DxvkBuffer> GetIcb() const {
-      return m_buffer;
+      return m_state != nullptr ? m_state->GetIcb() : nullptr;
     }
     
     std::string GetName() const {
-      return m_shader->debugName();
+      return m_state->GetName();
     }
+
+    /**
+     * \brief Starts translating the shader
+     *
+     * Queues translation on a worker thread
+     * if the shader is not translated yet.
+     */
+    void StartTranslation() const;
     
   private:
     
-    Rc<DxvkShader> m_shader;
-    Rc<DxvkBuffer> m_buffer;
+    std::shared_ptr<D3D11CommonShaderState> m_state;
+
+    static Sha1Hash GetShaderCacheHash(
+      const DxbcModuleInfo* pDxbcModuleInfo);
     
   };
   
@@ -134,7 +265,36 @@ namespace dxvk {
   public:
     
     D3D11ShaderModuleSet();
+
+    /**
+     * \brief Destroys the shader module set
+     *
+     * Waits for all pending shader translations,
+     * since they reference the device.
+     */
     ~D3D11ShaderModuleSet();
+
+    /**
+     * \brief Computes shader hash
+     *
+     * Shader keys use SHA-1 hashes since they are stored
+     * in the state cache. Applications tend to create the
+     * same shaders many times, so the SHA-1 hash of known
+     * bytecode is looked up using a much cheaper hash.
+     * \param [in] NumChunks Number of data chunks
+     * \param [in] pChunks Data chunks to hash
+     * \returns SHA-1 hash of the given data
+     */
+    Sha1Hash GetShaderHash(
+            size_t              NumChunks,
+      const Sha1Data*           pChunks);
+
+    Sha1Hash GetShaderHash(
+      const void*               pShaderBytecode,
+            size_t              BytecodeLength) {
+      Sha1Data chunk = { pShaderBytecode, BytecodeLength };
+      return GetShaderHash(1, &chunk);
+    }
     
     HRESULT GetShaderModule(
             D3D11Device*        pDevice,
@@ -146,12 +306,15 @@ namespace dxvk {
     
   private:
     
-    dxvk::mutex m_mutex;
-    
-    std::unordered_map<
+    sync::HashMap<
       DxvkShaderKey,
       D3D11CommonShader,
       DxvkHash, DxvkEq> m_modules;
+
+    sync::HashMap<
+      Hash128,
+      Sha1Hash,
+      DxvkHash, DxvkEq> m_hashes;
     
   };
   
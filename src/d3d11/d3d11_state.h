@@ -1,6 +1,6 @@
 #pragma once
 
-#include <unordered_map>
+#include "../util/sync/sync_hashmap.h"
 
 #include "d3d11_blend.h"
 #include "d3d11_depth_stencil.h"
@@ -37,7 +37,8 @@ namespace dxvk {
    * When creating state objects, D3D11 first checks if
    * an object with the same description already exists
    * and returns it if that is the case. This class
-   * implements that behaviour.
+   * implements that behaviour. Lookups are lock-free,
+   * since state objects are often recreated every frame.
    */
   template<typename T>
   class D3D11StateObjectSet {
@@ -54,24 +55,12 @@ namespace dxvk {
      * \returns Pointer to the state object
      */
     T* Create(D3D11Device* device, const DescType& desc) {
-      std::lock_guard<dxvk::mutex> lock(m_mutex);
-      
-      auto entry = m_objects.find(desc);
-      
-      if (entry != m_objects.end())
-        return ref(&entry->second);
-      
-      auto result = m_objects.emplace(
-        std::piecewise_construct,
-        std::tuple(desc),
-        std::tuple(device, desc));
-      return ref(&result.first->second);
+      return ref(m_objects.emplace(desc, device, desc).first);
     }
     
   private:
     
-    dxvk::mutex                                m_mutex;
-    std::unordered_map<DescType, T,
+    sync::HashMap<DescType, T,
       D3D11StateDescHash, D3D11StateDescEqual> m_objects;
     
   };
@@ -35,6 +35,26 @@ namespace dxvk {
       State = m_state;
     }
 
+    /**
+     * \brief Exchanges stored state with the context state
+     *
+     * The stored state is only ever read when the object
+     * gets bound to a context, so moving state in and out
+     * avoids copying and reference counting every binding.
+     * \param [in,out] State Context state
+     */
+    void SwapState(D3D11ContextState& State) {
+      std::swap(m_state, State);
+    }
+
+    /**
+     * \brief Retrieves stored state
+     * \returns Stored state
+     */
+    const D3D11ContextState& GetStoredState() const {
+      return m_state;
+    }
+
   private:
 
     D3D11ContextState m_state;
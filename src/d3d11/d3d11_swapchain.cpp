@@ -22,7 +22,8 @@ namespace dxvk {
     m_desc      (*pDesc),
     m_device    (pDevice->GetDXVKDevice()),
     m_context   (m_device->createContext(DxvkContextType::Supplementary)),
-    m_frameLatencyCap(pDevice->GetOptions()->maxFrameLatency) {
+    m_frameLatencyCap(pDevice->GetOptions()->maxFrameLatency),
+    m_lowLatencyMode(pDevice->GetOptions()->lowLatencyMode) {
     CreateFrameLatencyEvent();
 
     if (!pDevice->GetOptions()->deferSurfaceCreation)
@@ -31,10 +32,21 @@ namespace dxvk {
     CreateBackBuffer();
     CreateBlitter();
     CreateHud();
+
+    m_presentThread = dxvk::thread([this] () { RunPresentThread(); });
   }
 
 
   D3D11SwapChain::~D3D11SwapChain() {
+    SynchronizePresentThread();
+
+    { std::lock_guard<dxvk::mutex> lock(m_presentMutex);
+      m_presentStopped = true;
+    }
+
+    m_presentCond.notify_all();
+    m_presentThread.join();
+
     m_device->waitForSubmission(&m_presentStatus);
     m_device->waitForIdle();
     
@@ -121,6 +133,9 @@ namespace dxvk {
             || m_desc.BufferCount != pDesc->BufferCount
             || m_desc.Flags       != pDesc->Flags;
 
+    // The present thread may still be reading the back buffer
+    SynchronizePresentThread();
+
     m_desc = *pDesc;
     CreateBackBuffer();
     return S_OK;
@@ -139,6 +154,9 @@ namespace dxvk {
     const DXGI_RGB*                 pControlPoints) {
     bool isIdentity = true;
 
+    // The blitter is used by the present thread
+    SynchronizePresentThread();
+
     if (NumControlPoints > 1) {
       std::array<DxvkGammaCp, 1025> cp;
 
@@ -192,6 +210,8 @@ namespace dxvk {
           UINT                      SyncInterval,
           UINT                      PresentFlags,
     const DXGI_PRESENT_PARAMETERS*  pPresentParameters) {
+    DXVK_TRACE_SCOPE("D3D11SwapChain::Present");
+
     auto options = m_parent->GetOptions();
 
     if (options->syncInterval >= 0)
@@ -209,13 +229,19 @@ namespace dxvk {
 
     HRESULT hr = S_OK;
 
-    if (!m_presenter->hasSwapChain()) {
-      RecreateSwapChain(m_vsync);
-      m_dirty = false;
-    }
+    // Only synchronize with the present thread if the
+    // swap chain was lost or needs to be recreated
+    if (m_dirty || !m_presentHasSwapChain.load()) {
+      SynchronizePresentThread();
 
-    if (!m_presenter->hasSwapChain())
-      hr = DXGI_STATUS_OCCLUDED;
+      if (!m_presenter->hasSwapChain()) {
+        RecreateSwapChain(m_vsync);
+        m_dirty = false;
+      }
+
+      if (!m_presenter->hasSwapChain())
+        hr = DXGI_STATUS_OCCLUDED;
+    }
 
     if (m_device->getDeviceStatus() != VK_SUCCESS)
       hr = DXGI_ERROR_DEVICE_RESET;
@@ -227,7 +253,7 @@ namespace dxvk {
       RecreateSwapChain(m_vsync);
     
     try {
-      PresentImage(SyncInterval);
+      hr = PresentImage(SyncInterval);
     } catch (const DxvkError& e) {
       Logger::err(e.message());
       hr = E_FAIL;
@@ -254,6 +280,8 @@ namespace dxvk {
 
 
   HRESULT D3D11SwapChain::PresentImage(UINT SyncInterval) {
+    auto presentTime = dxvk::high_resolution_clock::now();
+
     Com<ID3D11DeviceContext> deviceContext = nullptr;
     m_parent->GetImmediateContext(&deviceContext);
 
@@ -264,12 +292,102 @@ namespace dxvk {
 
     // Bump our frame id.
     ++m_frameId;
-    
-    for (uint32_t i = 0; i < SyncInterval || i < 1; i++) {
-      SynchronizePresent();
+
+    D3D11SwapChainPresentRequest request;
+    request.frameId       = m_frameId;
+    request.syncInterval  = SyncInterval;
+    request.vsync         = m_vsync;
+    request.presentTime   = presentTime;
+
+    SubmitPresent(immediateContext, request);
+
+    // Acquire and blit happen on the present thread, so
+    // pacing is purely controlled by the frame latency
+    SyncFrameLatency();
+
+    // In low latency mode, start the next frame as late as possible
+    // without starving the GPU, based on measured GPU completion
+    if (m_lowLatencyMode)
+      m_presenter->delayFrameStart(m_device->getLatencyTracker().getFrameStartDelay());
+
+    // The present thread usually finishes this frame while we wait
+    // for frame latency, so the loss is reported for that frame. If
+    // it is still busy, report it on the next call instead.
+    if (m_presentLostSwapChain.exchange(false))
+      return DXGI_STATUS_OCCLUDED;
+
+    return S_OK;
+  }
+
+
+  void D3D11SwapChain::SubmitPresent(
+          D3D11ImmediateContext*  pContext,
+    const D3D11SwapChainPresentRequest& Request) {
+    auto lock = pContext->LockContext();
+
+    // Hand the request to the present thread from the CS thread,
+    // so that the blit is ordered after all rendering commands.
+    // Wait for the blit to be submitted before executing any
+    // further commands, since those may write the back buffer.
+    pContext->EmitCs([this,
+      cRequest = Request
+    ] (DxvkContext* ctx) {
+      std::unique_lock<dxvk::mutex> lock(m_presentMutex);
+      m_presentQueue.push(cRequest);
+      m_presentCond.notify_all();
+
+      m_presentCond.wait(lock, [this, frameId = cRequest.frameId] {
+        return m_presentFrameId >= frameId;
+      });
+
+      lock.unlock();
+      ctx->defragmentMemory();
+    });
+
+    pContext->FlushCsChunk();
+  }
+
+
+  void D3D11SwapChain::RunPresentThread() {
+    env::setThreadName("dxvk-present");
+
+    std::unique_lock<dxvk::mutex> lock(m_presentMutex);
+
+    while (true) {
+      m_presentCond.wait(lock, [this] {
+        return m_presentStopped || !m_presentQueue.empty();
+      });
+
+      if (m_presentQueue.empty())
+        return;
+
+      D3D11SwapChainPresentRequest request = m_presentQueue.front();
+      lock.unlock();
+
+      try {
+        if (!ExecutePresent(request))
+          m_presentLostSwapChain = true;
+      } catch (const DxvkError& e) {
+        Logger::err(e.message());
+      }
+
+      m_presentHasSwapChain = m_presenter->hasSwapChain();
+
+      lock.lock();
+      m_presentQueue.pop();
+      m_presentFrameId = request.frameId;
+      m_presentCond.notify_all();
+    }
+  }
+
+
+  bool D3D11SwapChain::ExecutePresent(
+    const D3D11SwapChainPresentRequest& Request) {
+    for (uint32_t i = 0; i < Request.syncInterval || i < 1; i++) {
+      SynchronizePresent(Request.vsync);
 
       if (!m_presenter->hasSwapChain())
-        return DXGI_STATUS_OCCLUDED;
+        return false;
 
       // Presentation semaphores and WSI swap chain image
       vk::PresenterInfo info = m_presenter->info();
@@ -280,10 +398,10 @@ namespace dxvk {
       VkResult status = m_presenter->acquireNextImage(sync, imageIndex);
 
       while (status != VK_SUCCESS && status != VK_SUBOPTIMAL_KHR) {
-        RecreateSwapChain(m_vsync);
+        RecreateSwapChain(Request.vsync);
 
         if (!m_presenter->hasSwapChain())
-          return DXGI_STATUS_OCCLUDED;
+          return false;
         
         info = m_presenter->info();
         status = m_presenter->acquireNextImage(sync, imageIndex);
@@ -301,59 +419,57 @@ namespace dxvk {
       if (m_hud != nullptr)
         m_hud->render(m_context, info.format, info.imageExtent);
       
-      if (i + 1 >= SyncInterval)
-        m_context->signal(m_frameLatencySignal, m_frameId);
+      // With present wait, the presenter signals the frame once it
+      // has actually been displayed rather than when the GPU is done
+      uint64_t displayFrameId = 0;
+
+      if (i + 1 >= Request.syncInterval) {
+        if (m_presenter->hasPresentWait())
+          displayFrameId = Request.frameId;
+        else
+          m_context->signal(m_frameLatencySignal, Request.frameId);
+      }
 
-      SubmitPresent(immediateContext, sync, i);
-    }
+      m_presentStatus.result = VK_NOT_READY;
 
-    SyncFrameLatency();
-    return S_OK;
-  }
+      m_device->submitCommandList(m_context->endRecording(),
+        sync.acquire, sync.present);
 
+      if (m_hud != nullptr && !i)
+        m_hud->update();
 
-  void D3D11SwapChain::SubmitPresent(
-          D3D11ImmediateContext*  pContext,
-    const vk::PresenterSync&      Sync,
-          uint32_t                FrameId) {
-    auto lock = pContext->LockContext();
+      m_device->presentImage(m_presenter, Request.presentTime,
+        displayFrameId, &m_presentStatus);
+    }
 
-    // Present from CS thread so that we don't
-    // have to synchronize with it first.
-    m_presentStatus.result = VK_NOT_READY;
+    return true;
+  }
 
-    pContext->EmitCs([this,
-      cFrameId     = FrameId,
-      cSync        = Sync,
-      cHud         = m_hud,
-      cCommandList = m_context->endRecording()
-    ] (DxvkContext* ctx) {
-      m_device->submitCommandList(cCommandList,
-        cSync.acquire, cSync.present);
 
-      if (cHud != nullptr && !cFrameId)
-        cHud->update();
+  void D3D11SwapChain::SynchronizePresentThread() {
+    std::unique_lock<dxvk::mutex> lock(m_presentMutex);
 
-      m_device->presentImage(m_presenter, &m_presentStatus);
+    m_presentCond.wait(lock, [this] {
+      return m_presentFrameId >= m_frameId;
     });
-
-    pContext->FlushCsChunk();
   }
 
 
-  void D3D11SwapChain::SynchronizePresent() {
+  void D3D11SwapChain::SynchronizePresent(
+          BOOL                      Vsync) {
     // Recreate swap chain if the previous present call failed
     VkResult status = m_device->waitForSubmission(&m_presentStatus);
     
     if (status != VK_SUCCESS)
-      RecreateSwapChain(m_vsync);
+      RecreateSwapChain(Vsync);
   }
 
 
   void D3D11SwapChain::RecreateSwapChain(BOOL Vsync) {
-    // Ensure that we can safely destroy the swap chain
+    // Ensure that the previous present has been executed. The
+    // presenter retires the old swap chain and frees it once the
+    // GPU is done with it, so we don't have to wait for idle.
     m_device->waitForSubmission(&m_presentStatus);
-    m_device->waitForIdle();
 
     m_presentStatus.result = VK_SUCCESS;
 
@@ -364,7 +480,13 @@ namespace dxvk {
     presenterDesc.numPresentModes = PickPresentModes(Vsync, presenterDesc.presentModes);
     presenterDesc.fullScreenExclusive = PickFullscreenMode();
 
-    if (m_presenter->recreateSwapChain(presenterDesc) != VK_SUCCESS)
+    m_device->lockSubmission();
+    VkResult status = m_presenter->recreateSwapChain(presenterDesc);
+    m_device->unlockSubmission();
+
+    m_presentHasSwapChain = m_presenter->hasSwapChain();
+
+    if (status != VK_SUCCESS)
       throw DxvkError("D3D11SwapChain: Failed to recreate swap chain");
     
     CreateRenderTargetViews();
@@ -387,6 +509,7 @@ namespace dxvk {
     presenterDevice.queue         = graphicsQueue.queueHandle;
     presenterDevice.adapter       = m_device->adapter()->handle();
     presenterDevice.features.fullScreenExclusive = m_device->extensions().extFullScreenExclusive;
+    presenterDevice.features.presentWait = m_device->features().khrPresentWait.presentWait;
 
     vk::PresenterDesc presenterDesc;
     presenterDesc.imageExtent     = { m_desc.Width, m_desc.Height };
@@ -401,8 +524,12 @@ namespace dxvk {
       presenterDevice,
       presenterDesc);
     
+    m_presenter->setFrameSignal(m_frameLatencySignal);
     m_presenter->setFrameRateLimit(m_parent->GetOptions()->maxFrameRate);
     m_presenter->setFrameRateLimiterRefreshRate(m_displayRefreshRate);
+    m_presenter->setFrameRateLimiterVblankAlignment(m_parent->GetOptions()->alignFrameRateToVblank);
+
+    m_presentHasSwapChain = m_presenter->hasSwapChain();
 
     CreateRenderTargetViews();
   }
@@ -422,7 +549,8 @@ namespace dxvk {
     imageInfo.extent      = { info.imageExtent.width, info.imageExtent.height, 1 };
     imageInfo.numLayers   = 1;
     imageInfo.mipLevels   = 1;
-    imageInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                          | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     imageInfo.stages      = 0;
     imageInfo.access      = 0;
     imageInfo.tiling      = VK_IMAGE_TILING_OPTIMAL;
@@ -568,6 +696,9 @@ namespace dxvk {
     if (m_frameLatencyCap)
       maxFrameLatency = std::min(maxFrameLatency, m_frameLatencyCap);
 
+    if (m_lowLatencyMode)
+      maxFrameLatency = 1;
+
     maxFrameLatency = std::min(maxFrameLatency, m_desc.BufferCount + 1);
     return maxFrameLatency;
   }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <queue>
+
 #include "d3d11_texture.h"
 
 #include "../dxvk/hud/dxvk_hud.h"
@@ -8,11 +10,26 @@
 
 #include "../util/sync/sync_signal.h"
 
+#include "../util/thread.h"
+
 namespace dxvk {
   
   class D3D11Device;
   class D3D11DXGIDevice;
 
+  /**
+   * \brief Present request
+   *
+   * Parameters of a single \c Present call as
+   * passed to the swap chain's present thread.
+   */
+  struct D3D11SwapChainPresentRequest {
+    uint64_t                                frameId;
+    uint32_t                                syncInterval;
+    bool                                    vsync;
+    dxvk::high_resolution_clock::time_point presentTime;
+  };
+
   class D3D11SwapChain : public ComObject<IDXGIVkSwapChain> {
     constexpr static uint32_t DefaultFrameLatency = 1;
   public:
@@ -106,6 +123,7 @@ namespace dxvk {
     uint64_t                m_frameId      = DXGI_MAX_SWAP_CHAIN_BUFFERS;
     uint32_t                m_frameLatency = DefaultFrameLatency;
     uint32_t                m_frameLatencyCap = 0;
+    bool                    m_lowLatencyMode = false;
     HANDLE                  m_frameLatencyEvent = nullptr;
     Rc<sync::CallbackFence> m_frameLatencySignal;
 
@@ -114,14 +132,31 @@ namespace dxvk {
 
     double                  m_displayRefreshRate = 0.0;
 
+    dxvk::mutex                 m_presentMutex;
+    dxvk::condition_variable    m_presentCond;
+    dxvk::thread                m_presentThread;
+    bool                        m_presentStopped = false;
+    uint64_t                    m_presentFrameId = m_frameId;
+    std::atomic<bool>           m_presentHasSwapChain = { false };
+    std::atomic<bool>           m_presentLostSwapChain = { false };
+
+    std::queue<D3D11SwapChainPresentRequest> m_presentQueue;
+
     HRESULT PresentImage(UINT SyncInterval);
 
     void SubmitPresent(
             D3D11ImmediateContext*  pContext,
-      const vk::PresenterSync&      Sync,
-            uint32_t                FrameId);
+      const D3D11SwapChainPresentRequest& Request);
+
+    void RunPresentThread();
+
+    bool ExecutePresent(
+      const D3D11SwapChainPresentRequest& Request);
 
-    void SynchronizePresent();
+    void SynchronizePresentThread();
+
+    void SynchronizePresent(
+            BOOL                      Vsync);
 
     void RecreateSwapChain(
             BOOL                      Vsync);
@@ -190,6 +190,31 @@ namespace dxvk {
     // should in no way affect the default image layout
     imageInfo.usage |= EnableMetaCopyUsage(imageInfo.format, imageInfo.tiling);
     imageInfo.usage |= EnableMetaPackUsage(imageInfo.format, m_desc.CPUAccessFlags);
+
+    if (m_desc.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS)
+      imageInfo.usage |= EnableMetaMipGenUsage(&imageInfo);
+
+    // Multisampled depth buffers that are only ever bound as a DSV
+    // never need to leave tile memory on tiling GPUs, so we can
+    // create them as transient attachments if the format allows.
+    if (m_device->GetOptions()->transientDepthBuffers && vkImage == VK_NULL_HANDLE
+     && imageInfo.sampleCount != VK_SAMPLE_COUNT_1_BIT
+     && imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL
+     && imageInfo.sharing.mode == DxvkSharedHandleMode::None
+     && m_desc.Usage == D3D11_USAGE_DEFAULT
+     && m_desc.BindFlags == D3D11_BIND_DEPTH_STENCIL
+     && m_desc.CPUAccessFlags == 0 && m_desc.MiscFlags == 0
+     && m_desc.MipLevels == 1 && m_desc.ArraySize == 1
+     && m_device->GetDXVKDevice()->adapter()->hasLazilyAllocatedMemory(~0u)) {
+      DxvkImageCreateInfo transientInfo = imageInfo;
+      transientInfo.usage   = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                            | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+      transientInfo.stages &= ~VK_PIPELINE_STAGE_TRANSFER_BIT;
+      transientInfo.access &= ~(VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+
+      if (CheckImageSupport(&transientInfo, transientInfo.tiling))
+        imageInfo = transientInfo;
+    }
     
     // Check if we can actually create the image
     if (!CheckImageSupport(&imageInfo, imageInfo.tiling)) {
@@ -218,16 +243,29 @@ namespace dxvk {
     else
       m_image = m_device->GetDXVKDevice()->createImageFromVkImage(imageInfo, vkImage);
 
+    if (m_mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT)
+      m_mapPtr = m_image->mapPtr(0);
+
     if (imageInfo.sharing.mode == DxvkSharedHandleMode::Export)
       ExportImageInfo();
   }
   
   
   D3D11CommonTexture::~D3D11CommonTexture() {
-    
+    if (m_image != nullptr)
+      m_device->GetDXVKDevice()->recycleImage(std::move(m_image));
   }
   
   
+  Rc<DxvkImage> D3D11CommonTexture::DiscardImage() {
+    Rc<DxvkImage> storage = m_device->GetDXVKDevice()->createImage(
+      m_image->info(), m_image->memFlags());
+
+    m_mapPtr = storage->mapPtr(0);
+    return storage;
+  }
+
+
   VkDeviceSize D3D11CommonTexture::ComputeMappedOffset(UINT Subresource, UINT Plane, VkOffset3D Offset) const {
     auto packedFormatInfo = imageFormatInfo(m_packedFormat);
 
@@ -538,6 +576,29 @@ namespace dxvk {
   }
 
   
+  VkImageUsageFlags D3D11CommonTexture::EnableMetaMipGenUsage(
+    const DxvkImageCreateInfo*  pImageInfo) const {
+    // The compute-based mip generation path writes all
+    // levels as storage images, so enable that usage if
+    // the format supports it without any restrictions.
+    if (pImageInfo->type != VK_IMAGE_TYPE_2D
+     || pImageInfo->tiling != VK_IMAGE_TILING_OPTIMAL)
+      return 0;
+
+    VkFormatProperties properties = m_device->GetDXVKDevice()->adapter()->formatProperties(pImageInfo->format);
+
+    if (!(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT))
+      return 0;
+
+    DxvkImageCreateInfo imageInfo = *pImageInfo;
+    imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+    return CheckImageSupport(&imageInfo, imageInfo.tiling)
+      ? VK_IMAGE_USAGE_STORAGE_BIT
+      : 0;
+  }
+
+
   VkMemoryPropertyFlags D3D11CommonTexture::GetMemoryFlags() const {
     VkMemoryPropertyFlags memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                                       | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -563,8 +624,19 @@ namespace dxvk {
     // If the resource cannot be used in the actual rendering pipeline, we
     // do not need to create an actual image and can instead implement copy
     // functions as buffer-to-image and image-to-buffer copies.
-    if (!m_desc.BindFlags && m_desc.Usage != D3D11_USAGE_DEFAULT)
+    if (!m_desc.BindFlags && m_desc.Usage != D3D11_USAGE_DEFAULT) {
+      // If requested, use a linear image for staging textures instead,
+      // so that the CPU can access the image memory without any copies.
+      // Formats with a special D3D11 memory layout still need a buffer.
+      if (m_desc.Usage == D3D11_USAGE_STAGING
+       && m_device->GetOptions()->linearStagingTextures
+       && !GetPackedDepthStencilFormat(m_desc.Format)
+       && !imageFormatInfo(pImageInfo->format)->flags.test(DxvkFormatFlag::MultiPlane)
+       && this->CheckImageSupport(pImageInfo, VK_IMAGE_TILING_LINEAR))
+        return D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT;
+
       return D3D11_COMMON_TEXTURE_MAP_MODE_STAGING;
+    }
 
     // Depth-stencil formats in D3D11 can be mapped and follow special
     // packing rules, so we need to copy that data into a buffer first
@@ -643,6 +715,11 @@ namespace dxvk {
   }
 
 
+  void D3D11CommonTexture::InitPendingImage() const {
+    m_device->InitPendingTexture(const_cast<D3D11CommonTexture*>(this));
+  }
+
+
   D3D11CommonTexture::MappedBuffer D3D11CommonTexture::CreateMappedBuffer(UINT MipLevel) const {
     const DxvkFormatInfo* formatInfo = imageFormatInfo(
       m_device->LookupPackedFormat(m_desc.Format, GetFormatMode()).Format);
@@ -691,8 +768,12 @@ namespace dxvk {
     
     // Filter out unnecessary flags. Transfer operations
     // are handled by the backend in a transparent manner.
+    // The backend also moves images to the GENERAL layout
+    // once they are used as a storage image, so images that
+    // are never bound as a UAV can keep an optimal layout.
     Usage &= ~(VK_IMAGE_USAGE_TRANSFER_DST_BIT
-             | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+             | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+             | VK_IMAGE_USAGE_STORAGE_BIT);
     
     // If the image is used only as an attachment, we never
     // have to transform the image back to a different layout
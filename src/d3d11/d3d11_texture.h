@@ -187,8 +187,83 @@ namespace dxvk {
      * \returns The DXVK image
      */
     Rc<DxvkImage> GetImage() const {
+      if (unlikely(m_initPending.load(std::memory_order_acquire)))
+        InitPendingImage();
+
       return m_image;
     }
+
+    /**
+     * \brief Host pointer to directly mapped image memory
+     *
+     * Only valid for directly mapped images. Points to the
+     * storage that the application currently writes to,
+     * which may not have been swapped into the image on
+     * the CS thread yet if the image was discarded.
+     * \returns Pointer to the start of image memory
+     */
+    void* GetMapPtr() const {
+      return m_mapPtr;
+    }
+
+    /**
+     * \brief Checks whether the image can be discarded
+     *
+     * Dynamic images that are mapped directly can get
+     * their storage replaced on \c D3D11_MAP_WRITE_DISCARD
+     * rather than waiting for the GPU to finish using it.
+     * \returns \c true if \ref DiscardImage can be used
+     */
+    bool CanDiscardImage() const {
+      return m_mapMode == D3D11_COMMON_TEXTURE_MAP_MODE_DIRECT
+          && m_desc.Usage == D3D11_USAGE_DYNAMIC
+          && CountSubresources() == 1
+          && m_image->canRename();
+    }
+
+    /**
+     * \brief Allocates new image storage
+     *
+     * The returned image must be passed to the
+     * DXVK context in order to rename the image.
+     * Updates the pointer returned by \ref GetMapPtr.
+     * \returns Image providing the new storage
+     */
+    Rc<DxvkImage> DiscardImage();
+
+    /**
+     * \brief Defers image initialization to first use
+     *
+     * Used for lazily allocated images that were created
+     * without initial data, so that no memory is bound
+     * until the application actually uses the texture.
+     */
+    void SetInitPending() {
+      m_initPending.store(true, std::memory_order_release);
+    }
+
+    /**
+     * \brief Claims pending image initialization
+     *
+     * \returns The image if it still needs to be
+     *    initialized, or \c nullptr otherwise
+     */
+    Rc<DxvkImage> ClaimPendingInit() {
+      return m_initPending.exchange(false, std::memory_order_acq_rel)
+        ? m_image : nullptr;
+    }
+
+    /**
+     * \brief Checks whether the image is transient
+     *
+     * Transient images can only be used as attachments,
+     * and their contents cannot be copied or read back.
+     * \returns \c true for transient depth buffers
+     */
+    bool IsTransient() const {
+      return m_image != nullptr
+          && (m_image->info().usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+    }
     
     /**
      * \brief Mapped subresource buffer
@@ -393,9 +468,13 @@ namespace dxvk {
     VkFormat                      m_packedFormat;
     
     Rc<DxvkImage>                 m_image;
+    void*                         m_mapPtr = nullptr;
+    std::atomic<bool>             m_initPending = { false };
     std::vector<MappedBuffer>     m_buffers;
     std::vector<MappedInfo>       m_mapInfo;
     
+    void InitPendingImage() const;
+
     MappedBuffer CreateMappedBuffer(
             UINT                  MipLevel) const;
     
@@ -415,6 +494,9 @@ namespace dxvk {
             VkFormat              Format,
             UINT                  CpuAccess) const;
     
+    VkImageUsageFlags EnableMetaMipGenUsage(
+      const DxvkImageCreateInfo*  pImageInfo) const;
+    
     VkMemoryPropertyFlags GetMemoryFlags() const;
     
     D3D11_COMMON_TEXTURE_MAP_MODE DetermineMapMode(
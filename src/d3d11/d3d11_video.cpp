@@ -4,6 +4,7 @@
 #include "d3d11_context_imm.h"
 #include "d3d11_video.h"
 
+#include <d3d11_video_blit_comp.h>
 #include <d3d11_video_blit_frag.h>
 #include <d3d11_video_blit_vert.h>
 
@@ -148,7 +149,7 @@ namespace dxvk {
       DxvkImageCreateInfo info = dxvkImage->info();
       info.flags  = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
       info.usage  = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-      info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
       info.access = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
       info.tiling = VK_IMAGE_TILING_OPTIMAL;
       info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -282,8 +283,29 @@ namespace dxvk {
         throw DxvkError("Invalid view dimension");
     }
 
-    m_view = pDevice->GetDXVKDevice()->createImageView(
-      GetCommonTexture(pResource)->GetImage(), viewInfo);
+    Rc<DxvkImage> dxvkImage = GetCommonTexture(pResource)->GetImage();
+    m_view = pDevice->GetDXVKDevice()->createImageView(dxvkImage, viewInfo);
+
+    // If the image can be used as a storage image, create a
+    // storage view so that blits can use the compute path
+    VkFormatProperties formatProperties = pDevice->GetDXVKDevice()->adapter()->formatProperties(viewInfo.format);
+
+    if ((dxvkImage->info().usage & VK_IMAGE_USAGE_STORAGE_BIT)
+     && (dxvkImage->info().tiling == VK_IMAGE_TILING_OPTIMAL)
+     && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+     && (viewInfo.type == VK_IMAGE_VIEW_TYPE_2D)
+     && (IsIdentitySwizzle(viewInfo.swizzle))) {
+      viewInfo.usage   = VK_IMAGE_USAGE_STORAGE_BIT;
+      m_storageView = pDevice->GetDXVKDevice()->createImageView(dxvkImage, viewInfo);
+    }
+  }
+
+
+  bool D3D11VideoProcessorOutputView::IsIdentitySwizzle(VkComponentMapping Swizzle) {
+    return (Swizzle.r == VK_COMPONENT_SWIZZLE_IDENTITY || Swizzle.r == VK_COMPONENT_SWIZZLE_R)
+        && (Swizzle.g == VK_COMPONENT_SWIZZLE_IDENTITY || Swizzle.g == VK_COMPONENT_SWIZZLE_G)
+        && (Swizzle.b == VK_COMPONENT_SWIZZLE_IDENTITY || Swizzle.b == VK_COMPONENT_SWIZZLE_B)
+        && (Swizzle.a == VK_COMPONENT_SWIZZLE_IDENTITY || Swizzle.a == VK_COMPONENT_SWIZZLE_A);
   }
 
 
@@ -328,14 +350,42 @@ namespace dxvk {
   : m_ctx(pContext) {
     SpirvCodeBuffer vsCode(d3d11_video_blit_vert);
     SpirvCodeBuffer fsCode(d3d11_video_blit_frag);
+    SpirvCodeBuffer csCode(d3d11_video_blit_comp);
+
+    DxvkSamplerCreateInfo samplerInfo;
+    samplerInfo.magFilter       = VK_FILTER_LINEAR;
+    samplerInfo.minFilter       = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode      = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.mipmapLodBias   = 0.0f;
+    samplerInfo.mipmapLodMin    = 0.0f;
+    samplerInfo.mipmapLodMax    = 0.0f;
+    samplerInfo.useAnisotropy   = VK_FALSE;
+    samplerInfo.maxAnisotropy   = 1.0f;
+    samplerInfo.addressModeU    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.compareToDepth  = VK_FALSE;
+    samplerInfo.compareOp       = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.borderColor     = VkClearColorValue();
+    samplerInfo.usePixelCoord   = VK_FALSE;
+    samplerInfo.nonSeamless     = VK_FALSE;
+    m_sampler = Device->createSampler(samplerInfo);
 
     const std::array<DxvkBindingInfo, 4> fsBindings = {{
       { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, VK_IMAGE_VIEW_TYPE_MAX_ENUM, 0, VK_ACCESS_UNIFORM_READ_BIT },
-      { VK_DESCRIPTOR_TYPE_SAMPLER,        1, VK_IMAGE_VIEW_TYPE_MAX_ENUM, 0, 0 },
+      { VK_DESCRIPTOR_TYPE_SAMPLER,        1, VK_IMAGE_VIEW_TYPE_MAX_ENUM, 0, 0, 0, m_sampler.ptr() },
       { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  2, VK_IMAGE_VIEW_TYPE_2D,       0, VK_ACCESS_SHADER_READ_BIT },
       { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  3, VK_IMAGE_VIEW_TYPE_2D,       0, VK_ACCESS_SHADER_READ_BIT },
     }};
 
+    const std::array<DxvkBindingInfo, 5> csBindings = {{
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, VK_IMAGE_VIEW_TYPE_MAX_ENUM, 0, VK_ACCESS_UNIFORM_READ_BIT },
+      { VK_DESCRIPTOR_TYPE_SAMPLER,        1, VK_IMAGE_VIEW_TYPE_MAX_ENUM, 0, 0, 0, m_sampler.ptr() },
+      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  2, VK_IMAGE_VIEW_TYPE_2D,       0, VK_ACCESS_SHADER_READ_BIT },
+      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  3, VK_IMAGE_VIEW_TYPE_2D,       0, VK_ACCESS_SHADER_READ_BIT },
+      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  4, VK_IMAGE_VIEW_TYPE_2D,       0, VK_ACCESS_SHADER_WRITE_BIT },
+    }};
+
     DxvkShaderCreateInfo vsInfo;
     vsInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
     vsInfo.outputMask = 0x1;
@@ -349,29 +399,16 @@ namespace dxvk {
     fsInfo.outputMask = 0x1;
     m_fs = new DxvkShader(fsInfo, std::move(fsCode));
 
-    DxvkSamplerCreateInfo samplerInfo;
-    samplerInfo.magFilter       = VK_FILTER_LINEAR;
-    samplerInfo.minFilter       = VK_FILTER_LINEAR;
-    samplerInfo.mipmapMode      = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-    samplerInfo.mipmapLodBias   = 0.0f;
-    samplerInfo.mipmapLodMin    = 0.0f;
-    samplerInfo.mipmapLodMax    = 0.0f;
-    samplerInfo.useAnisotropy   = VK_FALSE;
-    samplerInfo.maxAnisotropy   = 1.0f;
-    samplerInfo.addressModeU    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeW    = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.compareToDepth  = VK_FALSE;
-    samplerInfo.compareOp       = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.borderColor     = VkClearColorValue();
-    samplerInfo.usePixelCoord   = VK_FALSE;
-    samplerInfo.nonSeamless     = VK_FALSE;
-    m_sampler = Device->createSampler(samplerInfo);
+    DxvkShaderCreateInfo csInfo;
+    csInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    csInfo.bindingCount = csBindings.size();
+    csInfo.bindings = csBindings.data();
+    m_cs = new DxvkShader(csInfo, std::move(csCode));
 
     DxvkBufferCreateInfo bufferInfo;
     bufferInfo.size = sizeof(UboData);
     bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    bufferInfo.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    bufferInfo.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     bufferInfo.access = VK_ACCESS_UNIFORM_READ_BIT;
     m_ubo = Device->createBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   }
@@ -1190,24 +1227,38 @@ namespace dxvk {
 
   void D3D11VideoContext::BindOutputView(
           ID3D11VideoProcessorOutputView* pOutputView) {
-    auto dxvkView = static_cast<D3D11VideoProcessorOutputView*>(pOutputView)->GetView();
-
-    m_ctx->EmitCs([this, cView = dxvkView] (DxvkContext* ctx) {
-      DxvkRenderTargets rt;
-      rt.color[0].view = cView;
-      rt.color[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-      ctx->bindRenderTargets(rt);
-      ctx->bindShader(VK_SHADER_STAGE_VERTEX_BIT, m_vs);
-      ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_fs);
-      ctx->bindResourceBuffer(VK_SHADER_STAGE_FRAGMENT_BIT, 0, DxvkBufferSlice(m_ubo));
-
-      DxvkInputAssemblyState iaState;
-      iaState.primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-      iaState.primitiveRestart = VK_FALSE;
-      iaState.patchVertexCount = 0;
-      ctx->setInputAssemblyState(iaState);
-    });
+    auto outputView = static_cast<D3D11VideoProcessorOutputView*>(pOutputView);
+    auto dxvkView = outputView->GetView();
+    auto storageView = outputView->GetStorageView();
+
+    // Prefer writing the output directly from a compute shader,
+    // which avoids starting a render pass for every stream
+    m_useCompute = storageView != nullptr;
+
+    if (m_useCompute) {
+      m_ctx->EmitCs([this, cView = storageView] (DxvkContext* ctx) {
+        ctx->bindShader(VK_SHADER_STAGE_COMPUTE_BIT, m_cs);
+        ctx->bindResourceBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 0, DxvkBufferSlice(m_ubo));
+        ctx->bindResourceView(VK_SHADER_STAGE_COMPUTE_BIT, 4, cView, nullptr);
+      });
+    } else {
+      m_ctx->EmitCs([this, cView = dxvkView] (DxvkContext* ctx) {
+        DxvkRenderTargets rt;
+        rt.color[0].view = cView;
+        rt.color[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        ctx->bindRenderTargets(rt);
+        ctx->bindShader(VK_SHADER_STAGE_VERTEX_BIT, m_vs);
+        ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, m_fs);
+        ctx->bindResourceBuffer(VK_SHADER_STAGE_FRAGMENT_BIT, 0, DxvkBufferSlice(m_ubo));
+
+        DxvkInputAssemblyState iaState;
+        iaState.primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        iaState.primitiveRestart = VK_FALSE;
+        iaState.patchVertexCount = 0;
+        ctx->setInputAssemblyState(iaState);
+      });
+    }
 
     VkExtent3D viewExtent = dxvkView->mipLevelExtent(0);
     m_dstExtent = { viewExtent.width, viewExtent.height };
@@ -1250,7 +1301,8 @@ namespace dxvk {
     m_ctx->EmitCs([this,
       cStreamState  = *pStreamState,
       cViews        = view->GetViews(),
-      cIsYCbCr      = view->IsYCbCr()
+      cIsYCbCr      = view->IsYCbCr(),
+      cUseCompute   = m_useCompute
     ] (DxvkContext* ctx) {
       VkViewport viewport;
       viewport.x        = 0.0f;
@@ -1289,12 +1341,46 @@ namespace dxvk {
         uboData.yMax = 0.9215686f;
       }
 
+      if (cUseCompute) {
+        // Only process pixels within both the destination
+        // rectangle and the output view, which is what the
+        // scissor test would do for the graphics path
+        int32_t x0 = std::max(int32_t(viewport.x), 0);
+        int32_t y0 = std::max(int32_t(viewport.y), 0);
+        int32_t x1 = std::min(int32_t(viewport.x + viewport.width),  int32_t(m_dstExtent.width));
+        int32_t y1 = std::min(int32_t(viewport.y + viewport.height), int32_t(m_dstExtent.height));
+
+        if (x1 <= x0 || y1 <= y0)
+          return;
+
+        uboData.dstOffset[0] = viewport.x;
+        uboData.dstOffset[1] = viewport.y;
+        uboData.dstSize[0] = viewport.width;
+        uboData.dstSize[1] = viewport.height;
+        uboData.dstBase[0] = x0;
+        uboData.dstBase[1] = y0;
+        uboData.dstExtent[0] = uint32_t(x1 - x0);
+        uboData.dstExtent[1] = uint32_t(y1 - y0);
+
+        DxvkBufferSliceHandle uboSlice = m_ubo->allocSlice();
+        memcpy(uboSlice.mapPtr, &uboData, sizeof(uboData));
+
+        ctx->invalidateBuffer(m_ubo, uboSlice);
+
+        for (uint32_t i = 0; i < cViews.size(); i++)
+          ctx->bindResourceView(VK_SHADER_STAGE_COMPUTE_BIT, 2 + i, cViews[i], nullptr);
+
+        ctx->dispatch(
+          (uboData.dstExtent[0] + 7) / 8,
+          (uboData.dstExtent[1] + 7) / 8, 1);
+        return;
+      }
+
       DxvkBufferSliceHandle uboSlice = m_ubo->allocSlice();
       memcpy(uboSlice.mapPtr, &uboData, sizeof(uboData));
 
       ctx->invalidateBuffer(m_ubo, uboSlice);
       ctx->setViewports(1, &viewport, &scissor);
-      ctx->bindResourceSampler(VK_SHADER_STAGE_FRAGMENT_BIT, 1, m_sampler);
 
       for (uint32_t i = 0; i < cViews.size(); i++)
         ctx->bindResourceView(VK_SHADER_STAGE_FRAGMENT_BIT, 2 + i, cViews[i], nullptr);
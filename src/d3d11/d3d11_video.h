@@ -198,11 +198,18 @@ namespace dxvk {
       return m_view;
     }
 
+    Rc<DxvkImageView> GetStorageView() const {
+      return m_storageView;
+    }
+
   private:
 
     Com<ID3D11Resource>                     m_resource;
     D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC  m_desc;
     Rc<DxvkImageView>                       m_view;
+    Rc<DxvkImageView>                       m_storageView;
+
+    static bool IsIdentitySwizzle(VkComponentMapping Swizzle);
 
   };
 
@@ -586,6 +593,11 @@ namespace dxvk {
       float coordMatrix[3][2];
       float yMin, yMax;
       VkBool32 isPlanar;
+      uint32_t reserved;
+      float dstOffset[2];
+      float dstSize[2];
+      int32_t dstBase[2];
+      uint32_t dstExtent[2];
     };
 
     D3D11ImmediateContext* m_ctx;
@@ -593,9 +605,11 @@ namespace dxvk {
     Rc<DxvkSampler> m_sampler;
     Rc<DxvkShader> m_vs;
     Rc<DxvkShader> m_fs;
+    Rc<DxvkShader> m_cs;
     Rc<DxvkBuffer> m_ubo;
 
     VkExtent2D m_dstExtent = { 0u, 0u };
+    bool m_useCompute = false;
 
     void ApplyColorMatrix(float pDst[3][4], const float pSrc[3][4]);
 
@@ -163,7 +163,12 @@ namespace dxvk {
       return D3D_OK;
 
     // Let's actually ask Vulkan now that we got some quirks out the way!
-    return CheckDeviceVkFormat(mapping.FormatColor, Usage, RType);
+    // Converted formats are stored in the conversion format instead.
+    VkFormat format = mapping.ConversionFormatInfo.FormatColor != VK_FORMAT_UNDEFINED
+      ? mapping.ConversionFormatInfo.FormatColor
+      : mapping.FormatColor;
+
+    return CheckDeviceVkFormat(format, Usage, RType);
   }
 
 
@@ -768,14 +773,9 @@ namespace dxvk {
 
     // Walk over all modes that the display supports and
     // return those that match the requested format etc.
-    DEVMODEW devMode = { };
-    devMode.dmSize = sizeof(DEVMODEW);
-
-    uint32_t modeIndex = 0;
-
     const auto forcedRatio = Ratio<DWORD>(options.forceAspectRatio);
 
-    while (GetMonitorDisplayMode(GetDefaultMonitor(), modeIndex++, &devMode)) {
+    for (const auto& devMode : GetMonitorDisplayModes(GetDefaultMonitor())) {
       // Skip interlaced modes altogether
       if (devMode.dmDisplayFlags & DM_INTERLACED)
         continue;
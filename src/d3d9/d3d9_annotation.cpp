@@ -127,6 +127,11 @@ namespace dxvk {
   INT STDMETHODCALLTYPE D3D9UserDefinedAnnotation::BeginEvent(
           D3DCOLOR                Color,
           LPCWSTR                 Name) {
+    DxvkGpuProfiler& profiler = m_container->GetDXVKDevice()->getGpuProfiler();
+
+    if (unlikely(profiler.isCpuProfilingEnabled()))
+      m_cpuScopes.push_back(profiler.beginCpuScope(dxvk::str::fromws(Name)));
+
     m_container->EmitCs([color = Color, labelName = dxvk::str::fromws(Name)](DxvkContext *ctx) {
       VkDebugUtilsLabelEXT label;
       label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
@@ -147,6 +152,12 @@ namespace dxvk {
       ctx->endDebugLabel();
     });
 
+    if (unlikely(!m_cpuScopes.empty())) {
+      m_container->GetDXVKDevice()->getGpuProfiler().endCpuScope(
+        m_cpuScopes.back(), DxvkCpuProfilerTrack::AppThread);
+      m_cpuScopes.pop_back();
+    }
+
     // Handled by the global list.
     return 0;
   }
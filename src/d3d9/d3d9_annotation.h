@@ -3,6 +3,7 @@
 #include "d3d9_device.h"
 #include "d3d9_include.h"
 #include "../dxvk/dxvk_annotation.h"
+#include "../dxvk/dxvk_gpu_profiler.h"
 
 #include <atomic>
 #include <mutex>
@@ -83,6 +84,10 @@ namespace dxvk {
 
     D3D9DeviceEx* m_container;
 
+    // CPU scopes for non-finalized BeginEvent calls,
+    // synchronized by the global annotation list
+    std::vector<DxvkCpuProfilerScope> m_cpuScopes;
+
   };
 
 }
\ No newline at end of file
@@ -21,6 +21,16 @@ namespace dxvk {
   }
 
 
+  D3D9CommonBuffer::~D3D9CommonBuffer() {
+    // Let the device reuse the buffers for identical
+    // vertex or index buffers created later on
+    m_parent->GetDXVKDevice()->recycleBuffer(std::move(m_buffer));
+
+    if (m_stagingBuffer != nullptr)
+      m_parent->GetDXVKDevice()->recycleBuffer(std::move(m_stagingBuffer));
+  }
+
+
   HRESULT D3D9CommonBuffer::Lock(
           UINT   OffsetToLock,
           UINT   SizeToLock,
@@ -72,12 +72,15 @@ namespace dxvk {
 
   class D3D9CommonBuffer {
     static constexpr VkDeviceSize BufferSliceAlignment = 64;
+    static constexpr uint32_t     CachedMemoryReadCount = 4;
   public:
 
     D3D9CommonBuffer(
             D3D9DeviceEx*      pDevice,
       const D3D9_BUFFER_DESC*  pDesc);
 
+    ~D3D9CommonBuffer();
+
     HRESULT Lock(
             UINT   OffsetToLock,
             UINT   SizeToLock,
@@ -139,10 +142,47 @@ namespace dxvk {
       return m_sliceHandle;
     }
 
+    /**
+     * \brief Checks whether a discard can reuse the mapped slice
+     *
+     * Directly mapped buffers are only ever read by draws. If no
+     * draw was recorded since the last discard, the slice that
+     * was allocated by it cannot be in use by the GPU yet, so
+     * it can be handed out again without renaming the buffer.
+     * \param [in] DrawSeq Current draw sequence number
+     * \returns \c true if the mapped slice can be reused
+     */
+    inline bool CanReuseDiscardSlice(uint64_t DrawSeq) const {
+      return m_mapMode == D3D9_COMMON_BUFFER_MAP_MODE_DIRECT
+          && m_discardSeq == DrawSeq;
+    }
+
+    /**
+     * \brief Remembers when the buffer was last discarded
+     * \param [in] DrawSeq Current draw sequence number
+     */
+    inline void SetDiscardSeq(uint64_t DrawSeq) {
+      m_discardSeq = DrawSeq;
+    }
+
     inline DxvkBufferSliceHandle GetMappedSlice() const {
       return m_sliceHandle;
     }
 
+    /**
+     * \brief Tracks a read-only lock of the buffer
+     *
+     * Directly mapped buffers live in write-combined memory,
+     * which is extremely slow to read from. Buffers that get
+     * read back repeatedly should be moved to cached memory.
+     * \returns \c true if the buffer should be moved
+     */
+    inline bool TrackCpuRead() {
+      return m_mapMode == D3D9_COMMON_BUFFER_MAP_MODE_DIRECT
+          && !(m_buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+          && ++m_cpuReadCount == CachedMemoryReadCount;
+    }
+
     inline DWORD GetMapFlags() const      { return m_mapFlags; }
     inline void SetMapFlags(DWORD Flags)  { m_mapFlags = Flags; }
 
@@ -255,8 +295,10 @@ namespace dxvk {
     D3D9Range                   m_gpuReadingRange;
 
     uint32_t                    m_lockCount = 0;
+    uint32_t                    m_cpuReadCount = 0;
 
     uint64_t                    m_seq = 0ull;
+    uint64_t                    m_discardSeq = ~0ull;
 
   };
 
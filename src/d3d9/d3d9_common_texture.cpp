@@ -20,10 +20,6 @@ namespace dxvk {
                     ? D3D9Format::D32
                     : D3D9Format::X8R8G8B8;
 
-    for (uint32_t i = 0; i < m_dirtyBoxes.size(); i++) {
-      AddDirtyBox(nullptr, i);
-    }
-
     if (m_desc.Pool != D3DPOOL_DEFAULT) {
       const uint32_t subresources = CountSubresources();
       for (uint32_t i = 0; i < subresources; i++) {
@@ -76,16 +72,35 @@ namespace dxvk {
     if (m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_SYSTEMMEM)
       CreateBuffers();
 
+    // The mip count may have changed during image creation
+    m_dirtyBoxes.resize(CountSubresources());
+
+    for (uint32_t i = 0; i < m_dirtyBoxes.size(); i++)
+      AddSubresourceDirtyBox(nullptr, i);
+
     m_exposedMipLevels = m_desc.MipLevels;
 
     if (m_desc.Usage & D3DUSAGE_AUTOGENMIPMAP)
       m_exposedMipLevels = 1;
+
+    if (IsManaged() && m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_BACKED)
+      m_device->RegisterManagedTexture(this);
   }
 
 
   D3D9CommonTexture::~D3D9CommonTexture() {
+    // Must happen first so that the device does
+    // not evict the image while we destroy it
+    m_device->UnregisterManagedTexture(this);
+
+    if (m_mappedSize != 0)
+      m_device->ChangeMappedTextureMemory(this, m_mappedSize, 0);
+
     if (m_size != 0)
       m_device->ChangeReportedMemory(m_size);
+
+    if (m_image != nullptr)
+      m_device->GetDXVKDevice()->recycleImage(std::move(m_image));
   }
 
 
@@ -191,10 +206,57 @@ namespace dxvk {
     m_buffers[Subresource] = m_device->GetDXVKDevice()->createBuffer(info, memType);
     m_mappedSlices[Subresource] = m_buffers[Subresource]->getSliceHandle();
 
+    if (m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_BACKED) {
+      m_device->ChangeMappedTextureMemory(this, m_mappedSize, m_mappedSize + info.size);
+      m_mappedSize += info.size;
+    }
+
     return true;
   }
 
 
+  void D3D9CommonTexture::DestroyBufferSubresource(UINT Subresource) {
+    if (m_buffers[Subresource] != nullptr
+     && m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_BACKED) {
+      VkDeviceSize size = m_buffers[Subresource]->info().size;
+      m_device->ChangeMappedTextureMemory(this, m_mappedSize, m_mappedSize - size);
+      m_mappedSize -= size;
+    }
+
+    m_buffers[Subresource] = nullptr;
+    SetNeedsReadback(Subresource, true);
+  }
+
+
+  bool D3D9CommonTexture::CanReleaseBuffers() const {
+    if (m_mapMode != D3D9_COMMON_TEXTURE_MAP_MODE_BACKED || m_image == nullptr || m_evicted)
+      return false;
+
+    // Pending uploads only exist in the mapping buffers, and
+    // converted formats cannot be read back from the image
+    if (IsAnySubresourceLocked() || m_needsUpload.any()
+     || m_mapping.ConversionFormatInfo.FormatType != D3D9ConversionFormat_None)
+      return false;
+
+    return true;
+  }
+
+
+  VkDeviceSize D3D9CommonTexture::ReleaseBuffers() {
+    VkDeviceSize size = m_mappedSize;
+
+    for (uint32_t i = 0; i < CountSubresources(); i++) {
+      if (m_buffers[i] != nullptr) {
+        m_buffers[i] = nullptr;
+        SetNeedsReadback(i, true);
+      }
+    }
+
+    m_mappedSize = 0;
+    return size;
+  }
+
+
   VkDeviceSize D3D9CommonTexture::GetMipSize(UINT Subresource) const {
     const UINT MipLevel = Subresource % m_desc.MipLevels;
 
@@ -268,11 +330,19 @@ namespace dxvk {
     bool isMutable     = m_mapping.FormatSrgb != VK_FORMAT_UNDEFINED;
     bool isColorFormat = (formatProperties->aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0;
 
+    // Converted images are viewed with the conversion formats
+    std::array<VkFormat, 2> viewFormats = { m_mapping.FormatColor, m_mapping.FormatSrgb };
+
+    if (m_mapping.ConversionFormatInfo.FormatColor != VK_FORMAT_UNDEFINED) {
+      viewFormats = { m_mapping.ConversionFormatInfo.FormatColor, m_mapping.ConversionFormatInfo.FormatSrgb };
+      isMutable   = m_mapping.ConversionFormatInfo.FormatSrgb != VK_FORMAT_UNDEFINED;
+    }
+
     if (isMutable && isColorFormat) {
       imageInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
 
-      imageInfo.viewFormatCount = 2;
-      imageInfo.viewFormats     = m_mapping.Formats;
+      imageInfo.viewFormatCount = viewFormats.size();
+      imageInfo.viewFormats     = viewFormats.data();
     }
 
     // Are we an RT, need to gen mips or an offscreen plain surface?
@@ -310,6 +380,9 @@ namespace dxvk {
     // in no way affect the default image layout
     imageInfo.usage |= EnableMetaCopyUsage(imageInfo.format, imageInfo.tiling);
 
+    if (m_desc.Usage & D3DUSAGE_AUTOGENMIPMAP)
+      imageInfo.usage |= EnableMetaMipGenUsage(&imageInfo);
+
     // Check if we can actually create the image
     if (!CheckImageSupport(&imageInfo, imageInfo.tiling)) {
       throw DxvkError(str::format(
@@ -415,6 +488,29 @@ namespace dxvk {
   }
 
 
+  VkImageUsageFlags D3D9CommonTexture::EnableMetaMipGenUsage(
+    const DxvkImageCreateInfo*  pImageInfo) const {
+    // The compute-based mip generation path writes all
+    // levels as storage images, so enable that usage if
+    // the format supports it without any restrictions.
+    if (pImageInfo->type != VK_IMAGE_TYPE_2D
+     || pImageInfo->tiling != VK_IMAGE_TILING_OPTIMAL)
+      return 0;
+
+    VkFormatProperties properties = m_device->GetDXVKDevice()->adapter()->formatProperties(pImageInfo->format);
+
+    if (!(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT))
+      return 0;
+
+    DxvkImageCreateInfo imageInfo = *pImageInfo;
+    imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+    return CheckImageSupport(&imageInfo, imageInfo.tiling)
+      ? VK_IMAGE_USAGE_STORAGE_BIT
+      : 0;
+  }
+
+
   VkImageType D3D9CommonTexture::GetImageTypeFromResourceType(D3DRESOURCETYPE Type) {
     switch (Type) {
       case D3DRTYPE_SURFACE:
@@ -586,6 +682,7 @@ namespace dxvk {
       if (NeedsUpload(Subresource)) {
         m_device->FlushImage(this, Subresource);
         SetNeedsUpload(Subresource, false);
+        ClearDirtyBox(Subresource);
 
         if (!NeedsAnyUpload())
           m_device->MarkTextureUploaded(this);
@@ -594,12 +691,62 @@ namespace dxvk {
   }
 
 
+  bool D3D9CommonTexture::CanEvict() const {
+    if (!IsManaged() || m_evicted || m_image == nullptr)
+      return false;
+
+    // Mip maps generated on the GPU only exist in the image,
+    // and locked or GPU-written subresources may not have an
+    // up-to-date copy in the mapping buffer.
+    if (IsAutomaticMip() || IsAnySubresourceLocked() || m_needsReadback.any())
+      return false;
+
+    for (uint32_t i = 0; i < CountSubresources(); i++) {
+      if (m_buffers[i] == nullptr)
+        return false;
+    }
+
+    return true;
+  }
+
+
+  VkDeviceSize D3D9CommonTexture::EvictImage() {
+    VkDeviceSize size = m_image->memSize();
+
+    m_image      = nullptr;
+    m_sampleView = D3D9ColorView();
+    m_evicted    = true;
+
+    for (uint32_t i = 0; i < m_dirtyBoxes.size(); i++)
+      AddSubresourceDirtyBox(nullptr, i);
+
+    for (uint32_t i = 0; i < CountSubresources(); i++)
+      SetNeedsUpload(i, true);
+
+    return size;
+  }
+
+
+  void D3D9CommonTexture::RestoreImage() {
+    m_image   = CreatePrimaryImage(m_type, false, nullptr);
+    m_evicted = false;
+
+    CreateSampleView(m_sampleLod);
+  }
+
+
   void D3D9CommonTexture::CreateSampleView(UINT Lod) {
     // This will be a no-op for SYSTEMMEM types given we
     // don't expose the cap to allow texturing with them.
     if (unlikely(m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_SYSTEMMEM))
       return;
 
+    // Evicted textures recreate their view on restore
+    m_sampleLod = Lod;
+
+    if (unlikely(m_evicted))
+      return;
+
     m_sampleView.Color = CreateView(AllLayers, Lod, VK_IMAGE_USAGE_SAMPLED_BIT, false);
 
     if (IsSrgbCompatible())
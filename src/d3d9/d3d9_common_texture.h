@@ -65,7 +65,7 @@ namespace dxvk {
   using D3D9SubresourceBitset = bit::bitset<caps::MaxSubresources>;
 
   class D3D9CommonTexture {
-
+    friend class D3D9DeviceEx;
   public:
 
     D3D9CommonTexture(
@@ -238,10 +238,27 @@ namespace dxvk {
      * \brief Destroys a buffer
      * Destroys mapping and staging buffers for a given subresource
      */
-    void DestroyBufferSubresource(UINT Subresource) {
-      m_buffers[Subresource] = nullptr;
-      SetNeedsReadback(Subresource, true);
-    }
+    void DestroyBufferSubresource(UINT Subresource);
+
+    /**
+     * \brief Checks whether mapping buffers can be released
+     *
+     * The buffers can only be released if their contents can
+     * be restored by reading back the image, i.e. if the image
+     * is up to date and no format conversion is involved.
+     * \returns \c true if \c ReleaseBuffers is safe to call
+     */
+    bool CanReleaseBuffers() const;
+
+    /**
+     * \brief Releases all mapping buffers
+     *
+     * Contents will be read back from the image
+     * the next time a subresource gets locked.
+     * Does not notify the device.
+     * \returns Amount of memory released
+     */
+    VkDeviceSize ReleaseBuffers();
 
     bool IsDynamic() const {
       return m_desc.Usage & D3DUSAGE_DYNAMIC;
@@ -395,7 +412,52 @@ namespace dxvk {
     void PreLoadAll();
     void PreLoadSubresource(UINT Subresource);
 
+    /**
+     * \brief Marks a region of all mip levels of a layer dirty
+     *
+     * Used for \c AddDirtyRect and \c AddDirtyBox, where the
+     * region is given in coordinates of the top-level mip and
+     * applies to all mip levels.
+     * \param [in] pDirtyBox Dirty region, or \c nullptr for everything
+     * \param [in] layer Array layer or cube face
+     */
     void AddDirtyBox(CONST D3DBOX* pDirtyBox, uint32_t layer) {
+      for (uint32_t m = 0; m < m_desc.MipLevels; m++) {
+        uint32_t subresource = CalcSubresource(layer, m);
+
+        if (pDirtyBox) {
+          D3DBOX box = *pDirtyBox;
+          box.Left   >>= m;
+          box.Top    >>= m;
+          box.Front  >>= m;
+          box.Right    = (box.Right  + (1u << m) - 1) >> m;
+          box.Bottom   = (box.Bottom + (1u << m) - 1) >> m;
+          box.Back     = (box.Back   + (1u << m) - 1) >> m;
+          AddSubresourceDirtyBox(&box, subresource);
+        } else {
+          AddSubresourceDirtyBox(nullptr, subresource);
+        }
+      }
+    }
+
+    /**
+     * \brief Marks a region of a single subresource dirty
+     *
+     * Dirty regions are tracked per subresource so that
+     * uploads only need to copy the modified region of
+     * each mip level rather than the union of all levels.
+     * \param [in] pDirtyBox Dirty region in coordinates of the
+     *    subresource's mip level, or \c nullptr for everything
+     * \param [in] Subresource Subresource index
+     */
+    void AddSubresourceDirtyBox(CONST D3DBOX* pDirtyBox, UINT Subresource) {
+      UINT mipLevel = Subresource % m_desc.MipLevels;
+      UINT width    = std::max(m_desc.Width  >> mipLevel, 1u);
+      UINT height   = std::max(m_desc.Height >> mipLevel, 1u);
+      UINT depth    = std::max(m_desc.Depth  >> mipLevel, 1u);
+
+      D3DBOX& dirtyBox = m_dirtyBoxes[Subresource];
+
       if (pDirtyBox) {
         D3DBOX box = *pDirtyBox;
         if (box.Right <= box.Left
@@ -403,11 +465,10 @@ namespace dxvk {
           || box.Back <= box.Front)
           return;
 
-        box.Right = std::min(box.Right, m_desc.Width);
-        box.Bottom = std::min(box.Bottom, m_desc.Height);
-        box.Back = std::min(box.Back, m_desc.Depth);
+        box.Right = std::min(box.Right, width);
+        box.Bottom = std::min(box.Bottom, height);
+        box.Back = std::min(box.Back, depth);
 
-        D3DBOX& dirtyBox = m_dirtyBoxes[layer];
         if (dirtyBox.Left == dirtyBox.Right) {
           dirtyBox = box;
         } else {
@@ -419,18 +480,34 @@ namespace dxvk {
           dirtyBox.Back    = std::max(dirtyBox.Back,   box.Back);
         }
       } else {
-        m_dirtyBoxes[layer] = { 0, 0, m_desc.Width, m_desc.Height, 0, m_desc.Depth };
+        dirtyBox = { 0, 0, width, height, 0, depth };
       }
     }
 
+    void ClearDirtyBox(UINT Subresource) {
+      m_dirtyBoxes[Subresource] = { 0, 0, 0, 0, 0, 0 };
+    }
+
     void ClearDirtyBoxes() {
       for (uint32_t i = 0; i < m_dirtyBoxes.size(); i++) {
         m_dirtyBoxes[i] = { 0, 0, 0, 0, 0, 0 };
       }
     }
 
-    const D3DBOX& GetDirtyBox(uint32_t layer) const {
-      return m_dirtyBoxes[layer];
+    /**
+     * \brief Dirty region of a subresource
+     *
+     * \param [in] Subresource Subresource index
+     * \returns Dirty region in coordinates of the
+     *    subresource's mip level. May be empty.
+     */
+    const D3DBOX& GetDirtyBox(UINT Subresource) const {
+      return m_dirtyBoxes[Subresource];
+    }
+
+    bool IsDirtyBoxEmpty(UINT Subresource) const {
+      const D3DBOX& box = m_dirtyBoxes[Subresource];
+      return box.Left >= box.Right || box.Top >= box.Bottom || box.Front >= box.Back;
     }
 
     static VkImageType GetImageTypeFromResourceType(
@@ -461,6 +538,75 @@ namespace dxvk {
         : 0ull;
     }
 
+    /**
+     * \brief Records when the texture was last bound
+     * \param [in] FrameId Current residency frame
+     */
+    void SetLastUsedFrame(uint64_t FrameId) {
+      m_lastUsedFrame = FrameId;
+    }
+
+    /**
+     * \brief Queries when the texture was last bound
+     * \returns Residency frame of the last bind
+     */
+    uint64_t GetLastUsedFrame() const {
+      return m_lastUsedFrame;
+    }
+
+    /**
+     * \brief Records when the texture was last locked
+     * \param [in] FrameId Current residency frame
+     */
+    void SetLastLockFrame(uint64_t FrameId) {
+      m_lastLockFrame = FrameId;
+    }
+
+    /**
+     * \brief Queries when the texture was last locked
+     * \returns Residency frame of the last lock
+     */
+    uint64_t GetLastLockFrame() const {
+      return m_lastLockFrame;
+    }
+
+    /**
+     * \brief Checks whether the image is evicted
+     * \returns \c true if the image needs to be restored
+     */
+    bool IsEvicted() const {
+      return m_evicted;
+    }
+
+    /**
+     * \brief Checks whether the image can be evicted
+     *
+     * Managed textures keep a copy of their contents in
+     * their mapping buffers, so the image can be freed
+     * and uploaded again later as long as that copy is
+     * up to date for all subresources.
+     * \returns \c true if the image can be evicted
+     */
+    bool CanEvict() const;
+
+    /**
+     * \brief Evicts the image
+     *
+     * Frees the image and its views, and marks all
+     * subresources for upload. The image must be
+     * restored before any further GPU access.
+     * \returns Amount of image memory released
+     */
+    VkDeviceSize EvictImage();
+
+    /**
+     * \brief Restores an evicted image
+     *
+     * Recreates the image and its views. Contents are
+     * undefined until the texture has been uploaded.
+     */
+    void RestoreImage();
+
   private:
 
     D3D9DeviceEx*                 m_device;
@@ -506,7 +652,18 @@ namespace dxvk {
 
     D3DTEXTUREFILTERTYPE          m_mipFilter = D3DTEXF_LINEAR;
 
-    std::array<D3DBOX, 6>         m_dirtyBoxes;
+    std::vector<D3DBOX>           m_dirtyBoxes;
+
+    UINT                          m_sampleLod = 0;
+
+    bool                          m_evicted = false;
+
+    uint64_t                      m_lastUsedFrame = 0;
+    size_t                        m_residencyIndex = ~size_t(0);
+
+    uint64_t                      m_lastLockFrame = 0;
+    VkDeviceSize                  m_mappedSize    = 0;
+    size_t                        m_mappingIndex  = ~size_t(0);
 
     /**
      * \brief Mip level
@@ -530,6 +687,9 @@ namespace dxvk {
             VkFormat              Format,
             VkImageTiling         Tiling) const;
 
+    VkImageUsageFlags EnableMetaMipGenUsage(
+      const DxvkImageCreateInfo*  pImageInfo) const;
+
     D3D9_COMMON_TEXTURE_MAP_MODE DetermineMapMode() const {
       if (m_desc.Format == D3D9Format::NULL_FORMAT)
         return D3D9_COMMON_TEXTURE_MAP_MODE_NONE;
@@ -9,6 +9,7 @@
 #include "../util/util_math.h"
 #include "../util/util_vector.h"
 
+#include <algorithm>
 #include <cstdint>
 
 namespace dxvk {
@@ -44,11 +45,59 @@ namespace dxvk {
     Rc<DxvkBuffer>        boolBuffer;
   };
 
+  /**
+   * \brief Dirty constant register range
+   *
+   * Union of all registers of one constant type that
+   * were written since the last upload. Lets uploads
+   * skip buffers whose registers were not modified,
+   * or which the bound shader does not read.
+   */
+  struct D3D9ConstantRange {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+
+    bool empty() const {
+      return lo >= hi;
+    }
+
+    bool overlaps(uint32_t count) const {
+      return lo < std::min(hi, count);
+    }
+
+    void add(uint32_t start, uint32_t count) {
+      if (empty()) {
+        lo = start;
+        hi = start + count;
+      } else {
+        lo = std::min(lo, start);
+        hi = std::max(hi, start + count);
+      }
+    }
+
+    void clear() {
+      lo = 0;
+      hi = 0;
+    }
+  };
+
   struct D3D9ConstantSets {
     D3D9SwvpConstantBuffers   swvpBuffers;
     Rc<DxvkBuffer>            buffer;
     DxsoShaderMetaInfo        meta  = {};
+    /// Set if all constants need to be uploaded,
+    /// e.g. because the shader layout changed
     bool                      dirty = true;
+    D3D9ConstantRange         dirtyF;
+    D3D9ConstantRange         dirtyI;
+    D3D9ConstantRange         dirtyB;
+
+    void clearDirty() {
+      dirty = false;
+      dirtyF.clear();
+      dirtyI.clear();
+      dirtyB.clear();
+    }
   };
 
 }
\ No newline at end of file
@@ -49,6 +49,7 @@ namespace dxvk {
     , m_d3d9Options    ( dxvkDevice, pParent->GetInstance()->config() )
     , m_multithread    ( BehaviorFlags & D3DCREATE_MULTITHREADED )
     , m_isSWVP         ( (BehaviorFlags & D3DCREATE_SOFTWARE_VERTEXPROCESSING) ? true : false )
+    , m_csChunkPool    ( dxvkDevice )
     , m_csThread       ( dxvkDevice, dxvkDevice->createContext(DxvkContextType::Primary) )
     , m_csChunk        ( AllocCsChunk() ) {
     // If we can SWVP, then we use an extended constant set
@@ -59,7 +60,7 @@ namespace dxvk {
     if (canSWVP)
       Logger::info("D3D9DeviceEx: Using extended constant set for software vertex processing.");
 
-    if (m_dxvkDevice->instance()->extensions().extDebugUtils)
+    if (m_dxvkDevice->instance()->extensions().extDebugUtils || m_dxvkDevice->getGpuProfiler().isEnabled())
       m_annotation = new D3D9UserDefinedAnnotation(this);
 
     m_initializer      = new D3D9Initializer(m_dxvkDevice);
@@ -110,6 +111,10 @@ namespace dxvk {
 
     CreateConstantBuffers();
 
+    // Register fixed-function shaders from previous runs
+    // so that their pipelines can be compiled early
+    m_ffModules.PreloadShaders(this);
+
     m_availableMemory = DetermineInitialTextureMemory();
 
     // Initially set all the dirty flags so we
@@ -141,6 +146,7 @@ namespace dxvk {
     m_flags.set(D3D9DeviceFlag::DirtySharedPixelShaderData);
     m_flags.set(D3D9DeviceFlag::DirtyDepthBounds);
     m_flags.set(D3D9DeviceFlag::DirtyPointScale);
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
   }
 
 
@@ -148,6 +154,9 @@ namespace dxvk {
     Flush();
     SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
+    // Background shader compilation accesses the device
+    m_ffModules.WaitForPendingShaders();
+
     if (m_annotation)
       delete m_annotation;
 
@@ -813,23 +822,18 @@ namespace dxvk {
       return D3DERR_INVALIDCALL;
 
     for (uint32_t a = 0; a < arraySlices; a++) {
-      const D3DBOX& box = srcTexInfo->GetDirtyBox(a);
-      if (box.Left >= box.Right || box.Top >= box.Bottom || box.Front >= box.Back)
-        continue;
-
-      VkExtent3D mip0Extent = {
-        uint32_t(box.Right - box.Left),
-        uint32_t(box.Bottom - box.Top),
-        uint32_t(box.Back - box.Front)
-      };
-      VkOffset3D mip0Offset = { int32_t(box.Left), int32_t(box.Top), int32_t(box.Front) };
-
       for (uint32_t dstMip = 0; dstMip < mipLevels; dstMip++) {
         uint32_t srcMip = dstMip + srcMipOffset;
         uint32_t srcSubresource = srcTexInfo->CalcSubresource(a, srcMip);
         uint32_t dstSubresource = dstTexInfo->CalcSubresource(a, dstMip);
-        VkExtent3D extent = util::computeMipLevelExtent(mip0Extent, srcMip);
-        VkOffset3D offset = util::computeMipLevelOffset(mip0Offset, srcMip);
+
+        if (srcTexInfo->IsDirtyBoxEmpty(srcSubresource))
+          continue;
+
+        const D3DBOX& box = srcTexInfo->GetDirtyBox(srcSubresource);
+
+        VkExtent3D extent = { box.Right - box.Left, box.Bottom - box.Top, box.Back - box.Front };
+        VkOffset3D offset = { int32_t(box.Left), int32_t(box.Top), int32_t(box.Front) };
 
         UpdateTextureFromBuffer(dstTexInfo, srcTexInfo, dstSubresource, srcSubresource, offset, extent, offset);
         dstTexInfo->SetNeedsReadback(dstSubresource, true);
@@ -903,6 +907,7 @@ namespace dxvk {
     dstTexInfo->SetNeedsReadback(dst->GetSubresource(), true);
     TrackTextureMappingBufferSequenceNumber(dstTexInfo, dst->GetSubresource());
 
+    FlushReadback();
     return D3D_OK;
   }
 
@@ -1574,12 +1579,14 @@ namespace dxvk {
 
 
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::GetTransform(D3DTRANSFORMSTATETYPE State, D3DMATRIX* pMatrix) {
-    D3D9DeviceLock lock = LockDevice();
-
     if (unlikely(pMatrix == nullptr))
       return D3DERR_INVALIDCALL;
 
-    *pMatrix = bit::cast<D3DMATRIX>(m_state.transforms[GetTransformIndex(State)]);
+    uint32_t idx = GetTransformIndex(State);
+
+    m_multithread.ReadState([this, idx, pMatrix] {
+      *pMatrix = bit::cast<D3DMATRIX>(m_state.transforms[idx]);
+    });
 
     return D3D_OK;
   }
@@ -1593,7 +1600,9 @@ namespace dxvk {
 
     uint32_t idx = GetTransformIndex(TransformState);
 
+    m_multithread.BeginStateWrite();
     m_state.transforms[idx] = m_state.transforms[idx] * ConvertMatrix(pMatrix);
+    m_multithread.EndStateWrite();
 
     m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
 
@@ -1811,7 +1820,11 @@ namespace dxvk {
       const bool oldNVDB = states[D3DRS_ADAPTIVETESS_X] == uint32_t(D3D9Format::NVDB);
       const bool oldAlphaTest = IsAlphaTestEnabled();
 
+      m_multithread.BeginStateWrite();
       states[State] = Value;
+      m_multithread.EndStateWrite();
+
+      m_flags.set(D3D9DeviceFlag::DirtyDrawState);
 
       // AMD's driver hack for ATOC and RESZ
       if (unlikely(State == D3DRS_POINTSIZE)) {
@@ -2127,8 +2140,6 @@ namespace dxvk {
 
 
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::GetRenderState(D3DRENDERSTATETYPE State, DWORD* pValue) {
-    D3D9DeviceLock lock = LockDevice();
-
     if (unlikely(pValue == nullptr))
       return D3DERR_INVALIDCALL;
 
@@ -2136,10 +2147,16 @@ namespace dxvk {
       return D3DERR_INVALIDCALL;
     }
 
-    if (State < D3DRS_ZENABLE || State > D3DRS_BLENDOPALPHA)
+    if (State < D3DRS_ZENABLE || State > D3DRS_BLENDOPALPHA) {
       *pValue = 0;
-    else
+      return D3D_OK;
+    }
+
+    // Render states are only modified with the device lock
+    // held, so a consistent read does not need to take it
+    m_multithread.ReadState([this, State, pValue] {
       *pValue = m_state.renderStates[State];
+    });
 
     return D3D_OK;
   }
@@ -2370,6 +2387,9 @@ namespace dxvk {
     if (bSoftware && !CanSWVP())
       return D3DERR_INVALIDCALL;
 
+    if (m_isSWVP != bool(bSoftware))
+      m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     m_isSWVP = bSoftware;
 
     return D3D_OK;
@@ -2626,7 +2646,19 @@ namespace dxvk {
     uint32_t offset = DestIndex * decl->GetSize();
 
     auto slice = dst->GetBufferSlice<D3D9_COMMON_BUFFER_TYPE_REAL>();
-         slice = slice.subSlice(offset, slice.length() - offset);
+
+    if (unlikely(offset >= slice.length()))
+      return D3DERR_INVALIDCALL;
+
+    slice = slice.subSlice(offset, slice.length() - offset);
+
+    // Clamp the vertex count to the size of the destination buffer,
+    // so that the copy to the mapping buffer stays in bounds
+    if (decl->GetSize())
+      VertexCount = std::min<UINT>(VertexCount, slice.length() / decl->GetSize());
+
+    if (unlikely(!VertexCount))
+      return D3D_OK;
 
     EmitCs([this,
       cDecl          = ref(decl),
@@ -2664,6 +2696,7 @@ namespace dxvk {
     // We unbound the pixel shader before,
     // let's make sure that gets rebound.
     m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
 
     if (m_state.pixelShader != nullptr) {
       BindShader<DxsoProgramTypes::PixelShader>(
@@ -2839,7 +2872,11 @@ namespace dxvk {
     bool oldCopies = oldShader && oldShader->GetMeta().needsConstantCopies;
     bool newCopies = newShader && newShader->GetMeta().needsConstantCopies;
 
-    m_consts[DxsoProgramTypes::VertexShader].dirty |= oldCopies || newCopies || !oldShader;
+    // Packed float constants are laid out differently for each shader
+    bool oldPacked = oldShader && oldShader->GetMeta().packedConstantsF;
+    bool newPacked = newShader && newShader->GetMeta().packedConstantsF;
+
+    m_consts[DxsoProgramTypes::VertexShader].dirty |= oldCopies || newCopies || oldPacked || newPacked || !oldShader;
     m_consts[DxsoProgramTypes::VertexShader].meta  = newShader ? newShader->GetMeta() : DxsoShaderMetaInfo();
 
     if (newShader && oldShader) {
@@ -3007,8 +3044,10 @@ namespace dxvk {
       vbo.stride = Stride;
     }
 
-    if (needsUpdate)
+    if (needsUpdate) {
       BindVertexBuffer(StreamNumber, buffer, OffsetInBytes, Stride);
+      m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+    }
 
     return D3D_OK;
   }
@@ -3112,6 +3151,8 @@ namespace dxvk {
 
     BindIndices();
 
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     return D3D_OK;
   }
 
@@ -3171,7 +3212,11 @@ namespace dxvk {
     bool oldCopies = oldShader && oldShader->GetMeta().needsConstantCopies;
     bool newCopies = newShader && newShader->GetMeta().needsConstantCopies;
 
-    m_consts[DxsoProgramTypes::PixelShader].dirty |= oldCopies || newCopies || !oldShader;
+    // Packed float constants are laid out differently for each shader
+    bool oldPacked = oldShader && oldShader->GetMeta().packedConstantsF;
+    bool newPacked = newShader && newShader->GetMeta().packedConstantsF;
+
+    m_consts[DxsoProgramTypes::PixelShader].dirty |= oldCopies || newCopies || oldPacked || newPacked || !oldShader;
     m_consts[DxsoProgramTypes::PixelShader].meta  = newShader ? newShader->GetMeta() : DxsoShaderMetaInfo();
 
     if (newShader && oldShader) {
@@ -3202,6 +3247,8 @@ namespace dxvk {
 
     UpdateActiveHazardsRT(UINT32_MAX);
 
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     return D3D_OK;
   }
 
@@ -3675,6 +3722,8 @@ namespace dxvk {
 
     state[StateSampler][Type] = Value;
 
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     if (Type == D3DSAMP_ADDRESSU
      || Type == D3DSAMP_ADDRESSV
      || Type == D3DSAMP_ADDRESSW
@@ -3783,12 +3832,20 @@ namespace dxvk {
 
     DWORD combinedUsage = oldUsage | newUsage;
 
+    if (oldTexture != nullptr)
+      oldTexture->SetLastUsedFrame(m_residencyFrame);
+
+    if (newTexture != nullptr)
+      newTexture->SetLastUsedFrame(m_residencyFrame);
+
     TextureChangePrivate(m_state.textures[StateSampler], pTexture);
 
     m_dirtyTextures |= 1u << StateSampler;
 
     UpdateActiveTextures(StateSampler, combinedUsage);
 
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     return D3D_OK;
   }
 
@@ -3799,7 +3856,9 @@ namespace dxvk {
     if (unlikely(ShouldRecord()))
       return m_recorder->SetStateTransform(idx, pMatrix);
 
+    m_multithread.BeginStateWrite();
     m_state.transforms[idx] = ConvertMatrix(pMatrix);
+    m_multithread.EndStateWrite();
 
     m_flags.set(D3D9DeviceFlag::DirtyFFVertexData);
 
@@ -3828,6 +3887,8 @@ namespace dxvk {
     if (likely(m_state.textureStages[Stage][Type] != Value)) {
       m_state.textureStages[Stage][Type] = Value;
 
+      m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
       switch (Type) {
         case DXVK_TSS_COLOROP:
         case DXVK_TSS_COLORARG0:
@@ -3898,6 +3959,8 @@ namespace dxvk {
 
     enabled.extMemoryPriority.memoryPriority = supported.extMemoryPriority.memoryPriority;
 
+    enabled.extMultiDraw.multiDraw = supported.extMultiDraw.multiDraw;
+
     enabled.extShaderDemoteToHelperInvocation.shaderDemoteToHelperInvocation = supported.extShaderDemoteToHelperInvocation.shaderDemoteToHelperInvocation;
 
     enabled.extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor = supported.extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor;
@@ -3920,8 +3983,9 @@ namespace dxvk {
     enabled.core.features.shaderClipDistance = VK_TRUE;
     enabled.core.features.shaderCullDistance = VK_TRUE;
 
-    // Ensure we support real BC formats and unofficial vendor ones.
-    enabled.core.features.textureCompressionBC = VK_TRUE;
+    // Real BC formats and unofficial vendor ones. If the device
+    // lacks support, the format table decodes them on upload.
+    enabled.core.features.textureCompressionBC = supported.core.features.textureCompressionBC;
 
     enabled.extDepthClipEnable.depthClipEnable = supported.extDepthClipEnable.depthClipEnable;
     enabled.extHostQueryReset.hostQueryReset = VK_TRUE;
@@ -3966,6 +4030,7 @@ namespace dxvk {
   template<bool UpBuffer>
   D3D9BufferSlice D3D9DeviceEx::AllocTempBuffer(VkDeviceSize size) {
     constexpr VkDeviceSize DefaultSize = 1 << 20;
+    constexpr VkDeviceSize MaxSize     = 4 << 20;
 
     VkMemoryPropertyFlags memoryFlags
       = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
@@ -3975,23 +4040,36 @@ namespace dxvk {
       memoryFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     }
 
+    DxvkBufferCreateInfo info;
+    info.size   = size;
+    if constexpr (UpBuffer) {
+      info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                  | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+      info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                  | VK_ACCESS_INDEX_READ_BIT;
+      info.stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    } else {
+      info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+      info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      info.access = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    }
+
     D3D9BufferSlice& currentSlice = UpBuffer ? m_upBuffer : m_managedUploadBuffer;
 
-    if (size <= DefaultSize) {
-      if (unlikely(!currentSlice.slice.defined())) {
-        DxvkBufferCreateInfo info;
-        info.size   = DefaultSize;
-        if constexpr (UpBuffer) {
-          info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-                      | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-          info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
-                      | VK_ACCESS_INDEX_READ_BIT;
-          info.stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-        } else {
-          info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
-          info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-          info.access = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
-        }
+    if (size <= MaxSize) {
+      // The temp buffer is used as a persistently mapped ring. Once it is
+      // exhausted, the buffer gets renamed, and the buffer recycles its
+      // previous slices once the GPU is done with them. If the allocation
+      // doesn't fit into the buffer at all, grow it rather than falling
+      // back to one dedicated buffer per allocation.
+      VkDeviceSize bufferSize = currentSlice.slice.defined()
+        ? currentSlice.slice.buffer()->info().size : 0;
+
+      if (unlikely(bufferSize < size)) {
+        info.size = DefaultSize;
+
+        while (info.size < size)
+          info.size *= 2;
 
         currentSlice.slice  = DxvkBufferSlice(m_dxvkDevice->createBuffer(info, memoryFlags));
         currentSlice.mapPtr = currentSlice.slice.mapPtr(0);
@@ -4013,21 +4091,12 @@ namespace dxvk {
       result.slice  = currentSlice.slice.subSlice(0, size);
       result.mapPtr = reinterpret_cast<char*>(currentSlice.mapPtr) + currentSlice.slice.offset();
 
-      VkDeviceSize adjust = align(size, CACHE_LINE_SIZE);
+      VkDeviceSize adjust = std::min(align(size, CACHE_LINE_SIZE), currentSlice.slice.length());
       currentSlice.slice = currentSlice.slice.subSlice(adjust, currentSlice.slice.length() - adjust);
       return result;
     } else {
       // Create a temporary buffer for very large allocations
-      DxvkBufferCreateInfo info;
-      info.size   = size;
-      if constexpr (UpBuffer) {
-        info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-                    | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
-                    | VK_ACCESS_INDEX_READ_BIT;
-        info.stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-      } else {
-        info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+      if constexpr (!UpBuffer) {
         info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
         info.access = VK_ACCESS_TRANSFER_READ_BIT;
       }
@@ -4125,6 +4194,8 @@ namespace dxvk {
             D3DLOCKED_BOX*          pLockedBox,
       const D3DBOX*                 pBox,
             DWORD                   Flags) {
+    DXVK_TRACE_SCOPE("D3D9DeviceEx::LockImage");
+
     D3D9DeviceLock lock = LockDevice();
 
     UINT Subresource = pResource->CalcSubresource(Face, MipLevel);
@@ -4145,6 +4216,7 @@ namespace dxvk {
     auto& desc = *(pResource->Desc());
 
     bool alloced = pResource->CreateBufferSubresource(Subresource);
+    pResource->SetLastLockFrame(m_residencyFrame);
 
     const Rc<DxvkBuffer> mappedBuffer = pResource->GetBuffer(Subresource);
 
@@ -4328,18 +4400,7 @@ namespace dxvk {
     const bool noDirtyUpdate = Flags & D3DLOCK_NO_DIRTY_UPDATE;
     if (likely((pResource->IsManaged() && m_d3d9Options.evictManagedOnUnlock)
       || ((desc.Pool == D3DPOOL_DEFAULT || !noDirtyUpdate) && !readOnly))) {
-      if (pBox && MipLevel != 0) {
-        D3DBOX scaledBox = *pBox;
-        scaledBox.Left   <<= MipLevel;
-        scaledBox.Right    = std::min(scaledBox.Right << MipLevel, pResource->Desc()->Width);
-        scaledBox.Top    <<= MipLevel;
-        scaledBox.Bottom   = std::min(scaledBox.Bottom << MipLevel, pResource->Desc()->Height);
-        scaledBox.Back   <<= MipLevel;
-        scaledBox.Front    = std::min(scaledBox.Front << MipLevel, pResource->Desc()->Depth);
-        pResource->AddDirtyBox(&scaledBox, Face);
-      } else {
-        pResource->AddDirtyBox(pBox, Face);
-      }
+      pResource->AddSubresourceDirtyBox(pBox, Subresource);
     }
 
     if (managed && !m_d3d9Options.evictManagedOnUnlock && !readOnly) {
@@ -4387,15 +4448,13 @@ namespace dxvk {
 
     // Flush image contents from staging if we aren't read only
     // and we aren't deferring for managed.
-    const D3DBOX& box = pResource->GetDirtyBox(Face);
     bool shouldFlush  = pResource->GetMapMode() == D3D9_COMMON_TEXTURE_MAP_MODE_BACKED;
-         shouldFlush &= box.Left < box.Right && box.Top < box.Bottom && box.Front < box.Back;
+         shouldFlush &= !pResource->IsDirtyBoxEmpty(Subresource);
          shouldFlush &= !pResource->IsManaged() || m_d3d9Options.evictManagedOnUnlock;
 
     if (shouldFlush) {
         this->FlushImage(pResource, Subresource);
-        if (!pResource->IsAnySubresourceLocked())
-          pResource->ClearDirtyBoxes();
+        pResource->ClearDirtyBox(Subresource);
     }
 
     // Toss our staging buffer if we're not dynamic
@@ -4416,18 +4475,19 @@ namespace dxvk {
   HRESULT D3D9DeviceEx::FlushImage(
         D3D9CommonTexture*      pResource,
         UINT                    Subresource) {
+    if (unlikely(pResource->IsEvicted()))
+      RestoreManagedTexture(pResource);
 
-    const Rc<DxvkImage> image = pResource->GetImage();
-    auto formatInfo  = imageFormatInfo(image->info().format);
-    auto subresource = pResource->GetSubresourceFromIndex(
-      formatInfo->aspectMask, Subresource);
+    // Only copy the region that was modified since the last
+    // upload. Locks with D3DLOCK_NO_DIRTY_UPDATE and mip levels
+    // that were not written to leave the region empty.
+    if (pResource->IsDirtyBoxEmpty(Subresource))
+      return D3D_OK;
 
-    const D3DBOX& box = pResource->GetDirtyBox(subresource.arrayLayer);
+    const D3DBOX& box = pResource->GetDirtyBox(Subresource);
 
-    VkExtent3D mip0Extent = { box.Right - box.Left, box.Bottom - box.Top, box.Back - box.Front };
-    VkExtent3D extent = util::computeMipLevelExtent(mip0Extent, subresource.mipLevel);
-    VkOffset3D mip0Offset = { int32_t(box.Left), int32_t(box.Top), int32_t(box.Front) };
-    VkOffset3D offset = util::computeMipLevelOffset(mip0Offset, subresource.mipLevel);
+    VkExtent3D extent = { box.Right - box.Left, box.Bottom - box.Top, box.Back - box.Front };
+    VkOffset3D offset = { int32_t(box.Left), int32_t(box.Top), int32_t(box.Front) };
 
     UpdateTextureFromBuffer(pResource, pResource, Subresource, Subresource, offset, extent, offset);
 
@@ -4532,6 +4592,10 @@ namespace dxvk {
     else {
       const DxvkFormatInfo* formatInfo = imageFormatInfo(pDestTexture->GetFormatMapping().FormatColor);
 
+      // The image format differs from the packed format, which
+      // may use blocks larger than a single pixel
+      srcTexLevelExtentBlockCount = util::computeBlockCount(srcTexLevelExtent, formatInfo->blockSize);
+
       // Add more blocks for the other planes that we might have.
       // TODO: PLEASE CLEAN ME
       srcTexLevelExtentBlockCount.height *= std::min(convertFormat.PlaneCount, 2u);
@@ -4555,8 +4619,16 @@ namespace dxvk {
         slice.mapPtr, srcSlice.mapPtr, srcTexLevelExtentBlockCount, formatInfo->elementSize,
         pitch, std::min(convertFormat.PlaneCount, 2u) * pitch * srcTexLevelExtentBlockCount.height);
 
-      Flush();
-      SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+      // The converter records into its own context, which gets submitted
+      // before the main context on the next flush. Only synchronize if
+      // commands were recorded since the last conversion, so that
+      // converting all subresources of a texture needs one submission.
+      if (!m_csChunk->empty() || m_csSeqNum != m_convertSeqNum) {
+        Flush();
+        SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
+
+        m_convertSeqNum = m_csSeqNum;
+      }
 
       m_converter->ConvertFormat(
         convertFormat,
@@ -4585,6 +4657,8 @@ namespace dxvk {
           UINT                    SizeToLock,
           void**                  ppbData,
           DWORD                   Flags) {
+    DXVK_TRACE_SCOPE("D3D9DeviceEx::LockBuffer");
+
     D3D9DeviceLock lock = LockDevice();
 
     if (unlikely(ppbData == nullptr))
@@ -4622,25 +4696,37 @@ namespace dxvk {
     uint32_t size   = respectUserBounds ? std::min(SizeToLock, desc.Size - offset) : desc.Size;
     D3D9Range lockRange = D3D9Range(offset, offset + size);
 
-    if ((desc.Pool == D3DPOOL_DEFAULT || !(Flags & D3DLOCK_NO_DIRTY_UPDATE)) && !(Flags & D3DLOCK_READONLY))
+    if ((desc.Pool == D3DPOOL_DEFAULT || !(Flags & D3DLOCK_NO_DIRTY_UPDATE)) && !(Flags & D3DLOCK_READONLY)) {
       pResource->DirtyRange().Conjoin(lockRange);
 
+      if (desc.Pool != D3DPOOL_DEFAULT)
+        m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+    }
+
     Rc<DxvkBuffer> mappingBuffer = pResource->GetBuffer<D3D9_COMMON_BUFFER_TYPE_MAPPING>();
 
     DxvkBufferSliceHandle physSlice;
 
     if (Flags & D3DLOCK_DISCARD) {
-      // Allocate a new backing slice for the buffer and set
-      // it as the 'new' mapped slice. This assumes that the
-      // only way to invalidate a buffer is by mapping it.
-      physSlice = pResource->DiscardMapSlice();
+      if (pResource->CanReuseDiscardSlice(m_drawSeq)) {
+        // Nothing could have read the slice from the previous
+        // discard yet, so keep writing to it. This avoids burning
+        // through slices with repeated discards between draws.
+        physSlice = pResource->GetMappedSlice();
+      } else {
+        // Allocate a new backing slice for the buffer and set
+        // it as the 'new' mapped slice. This assumes that the
+        // only way to invalidate a buffer is by mapping it.
+        physSlice = pResource->DiscardMapSlice();
+        pResource->SetDiscardSeq(m_drawSeq);
 
-      EmitCs([
-        cBuffer      = std::move(mappingBuffer),
-        cBufferSlice = physSlice
-      ] (DxvkContext* ctx) {
-        ctx->invalidateBuffer(cBuffer, cBufferSlice);
-      });
+        EmitCs([
+          cBuffer      = std::move(mappingBuffer),
+          cBufferSlice = physSlice
+        ] (DxvkContext* ctx) {
+          ctx->invalidateBuffer(cBuffer, cBufferSlice);
+        });
+      }
 
       pResource->SetNeedsReadback(false);
       pResource->GPUReadingRange().Clear();
@@ -4677,6 +4763,28 @@ namespace dxvk {
         pResource->SetNeedsReadback(false);
         pResource->GPUReadingRange().Clear();
       }
+
+      // If the app keeps reading back a directly mapped buffer, move
+      // it to cached memory and copy the current contents over once.
+      if (unlikely(readOnly && pResource->TrackCpuRead())) {
+        Logger::info(str::format("D3D9: Moving buffer of size ", desc.Size, " to cached memory"));
+
+        mappingBuffer->setMemoryFlags(mappingBuffer->memFlags()
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+          | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+        auto prevSlice = physSlice;
+        physSlice = pResource->DiscardMapSlice();
+
+        EmitCs([
+          cBuffer      = std::move(mappingBuffer),
+          cBufferSlice = physSlice
+        ] (DxvkContext* ctx) {
+          ctx->invalidateBuffer(cBuffer, cBufferSlice);
+        });
+
+        std::memcpy(physSlice.mapPtr, prevSlice.mapPtr, physSlice.length);
+      }
     }
 
     uint8_t* data = reinterpret_cast<uint8_t*>(physSlice.mapPtr);
@@ -4771,20 +4879,48 @@ namespace dxvk {
 
 
   void D3D9DeviceEx::FlushImplicit(BOOL StrongHint) {
-    // Flush only if the GPU is about to go idle, in
-    // order to keep the number of submissions low.
-    uint32_t pending = m_dxvkDevice->pendingSubmissions();
+    DxvkFlushHint hint = StrongHint
+      ? DxvkFlushHint::Strong
+      : DxvkFlushHint::Weak;
 
-    if (StrongHint || pending <= MaxPendingSubmits) {
-      auto now = dxvk::high_resolution_clock::now();
+    if (m_hasPendingReadback)
+      hint = DxvkFlushHint::Readback;
 
-      uint32_t delay = MinFlushIntervalUs
-                     + IncFlushIntervalUs * pending;
+    if (m_flushTracker.considerFlush(m_dxvkDevice.ptr(), hint, m_csSeqNum))
+      Flush();
+  }
 
-      // Prevent flushing too often in short intervals.
-      if (now - m_lastFlush >= std::chrono::microseconds(delay))
-        Flush();
-    }
+
+  void D3D9DeviceEx::FlushReadback() {
+    // The copy into the system memory surface is only waited
+    // for when the surface gets locked, so submit it early
+    // in order for it to have completed by then. If we flushed
+    // recently, make the next implicit flush point submit.
+    if (m_flushTracker.considerFlush(m_dxvkDevice.ptr(), DxvkFlushHint::Readback, m_csSeqNum))
+      Flush();
+    else
+      m_hasPendingReadback = true;
+  }
+
+
+  void D3D9DeviceEx::FlushForQuery(uint64_t SequenceNumber) {
+    D3D9DeviceLock lock = LockDevice();
+
+    // The query will complete without further submissions
+    // once the GPU gets to it, so polling it must not flush
+    if (SequenceNumber <= m_submittedSeqNum)
+      return;
+
+    // While the GPU is still busy, queries ended later in the
+    // frame would not complete any sooner if we submitted them
+    // now, so only let the first polled query flush in a frame.
+    if (m_d3d9Options.coalesceQueryFlushes && m_queryFlushedThisFrame
+     && m_dxvkDevice->pendingSubmissions())
+      return;
+
+    FlushImplicit(FALSE);
+
+    m_queryFlushedThisFrame |= SequenceNumber <= m_submittedSeqNum;
   }
 
 
@@ -4920,11 +5056,13 @@ namespace dxvk {
                           DxsoProgramType::PixelShader,
                           DxsoConstantBuffers::PSConstantBuffer);
 
-    m_vsClipPlanes =
-      CreateConstantBuffer(false,
-                           caps::MaxClipPlanes * sizeof(D3D9ClipPlane),
-                           DxsoProgramType::VertexShader,
-                           DxsoConstantBuffers::VSClipPlanes);
+    if (!m_d3d9Options.inlineClipPlanes) {
+      m_vsClipPlanes =
+        CreateConstantBuffer(false,
+                             caps::MaxClipPlanes * sizeof(D3D9ClipPlane),
+                             DxsoProgramType::VertexShader,
+                             DxsoConstantBuffers::VSClipPlanes);
+    }
 
     m_vsFixedFunction =
       CreateConstantBuffer(false,
@@ -4951,6 +5089,27 @@ namespace dxvk {
                             : sizeof(D3D9FixedFunctionVertexBlendDataHW),
                            DxsoProgramType::VertexShader,
                            DxsoConstantBuffers::VSVertexBlendData);
+
+    // Spec constant values, read by both stages in pipelines
+    // that are used while the specialized ones are compiling
+    DxvkBufferCreateInfo specInfo = { };
+    specInfo.usage  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    specInfo.access = VK_ACCESS_UNIFORM_READ_BIT;
+    specInfo.size   = sizeof(D3D9SpecializationInfo);
+    specInfo.stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                    | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    m_specBuffer = m_dxvkDevice->createBuffer(specInfo,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    EmitCs([
+      cBuffer = m_specBuffer
+    ] (DxvkContext* ctx) {
+      ctx->bindResourceBuffer(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        getSpecConstantBufferSlot(), DxvkBufferSlice(cBuffer, 0, cBuffer->info().size));
+    });
+
+    m_flags.set(D3D9DeviceFlag::DirtySpecializationEntries);
   }
 
 
@@ -4964,10 +5123,17 @@ namespace dxvk {
 
     D3D9ConstantSets& constSet = m_consts[DxsoProgramType::VertexShader];
 
-    if (!constSet.dirty)
+    // Each constant type lives in its own buffer, so only
+    // re-upload the ones where the shader reads a register
+    // that was modified since the last upload.
+    bool floatsDirty = constSet.dirty || constSet.dirtyF.overlaps(constSet.meta.maxConstIndexF);
+    bool intsDirty   = constSet.dirty || constSet.dirtyI.overlaps(constSet.meta.maxConstIndexI);
+    bool boolsDirty  = constSet.dirty || constSet.dirtyB.overlaps(constSet.meta.maxConstIndexB);
+
+    if (!floatsDirty && !intsDirty && !boolsDirty)
       return;
 
-    constSet.dirty = false;
+    constSet.clearDirty();
 
     uint32_t floatCount = m_vsFloatConstsCount;
     if (constSet.meta.needsConstantCopies) {
@@ -4983,7 +5149,7 @@ namespace dxvk {
     Rc<DxvkBuffer>& floatBuffer = constSet.swvpBuffers.floatBuffer;
     // Max copy source size is 8192 * 16 => always aligned to any plausible value
     // => we won't copy out of bounds
-    if (likely(constSet.meta.maxConstIndexF != 0 || floatBuffer == nullptr)) {
+    if (likely((floatsDirty && constSet.meta.maxConstIndexF != 0) || floatBuffer == nullptr)) {
       DxvkBufferSliceHandle floatBufferSlice = CopySoftwareConstants(DxsoConstantBuffers::VSFloatConstantBuffer, floatBuffer, Src.fConsts, floatDataSize, m_dxsoOptions.vertexFloatConstantBufferAsSSBO);
 
       if (constSet.meta.needsConstantCopies) {
@@ -5001,12 +5167,12 @@ namespace dxvk {
     Rc<DxvkBuffer>& intBuffer = constSet.swvpBuffers.intBuffer;
     // Max copy source size is 2048 * 16 => always aligned to any plausible value
     // => we won't copy out of bounds
-    if (likely(constSet.meta.maxConstIndexI != 0 || intBuffer == nullptr)) {
+    if (likely((intsDirty && constSet.meta.maxConstIndexI != 0) || intBuffer == nullptr)) {
       CopySoftwareConstants(DxsoConstantBuffers::VSIntConstantBuffer, intBuffer, Src.iConsts, intDataSize, false);
     }
 
     Rc<DxvkBuffer>& boolBuffer = constSet.swvpBuffers.boolBuffer;
-    if (likely(constSet.meta.maxConstIndexB != 0 || boolBuffer == nullptr)) {
+    if (likely((boolsDirty && constSet.meta.maxConstIndexB != 0) || boolBuffer == nullptr)) {
       CopySoftwareConstants(DxsoConstantBuffers::VSBoolConstantBuffer, boolBuffer, Src.bConsts, boolDataSize, false);
     }
   }
@@ -5045,10 +5211,17 @@ namespace dxvk {
     */
     D3D9ConstantSets& constSet = m_consts[ShaderStage];
 
-    if (!constSet.dirty)
+    // Float and integer constants share one buffer here. Boolean
+    // constants are passed to the shader separately and don't
+    // require an upload.
+    bool dirty = constSet.dirty
+      || constSet.dirtyF.overlaps(constSet.meta.maxConstIndexF)
+      || constSet.dirtyI.overlaps(constSet.meta.maxConstIndexI);
+
+    if (!dirty)
       return;
 
-    constSet.dirty = false;
+    constSet.clearDirty();
 
     uint32_t floatCount = ShaderStage == DxsoProgramType::VertexShader ? m_vsFloatConstsCount : m_psFloatConstsCount;
     if (constSet.meta.needsConstantCopies) {
@@ -5057,6 +5230,13 @@ namespace dxvk {
     }
     floatCount = std::min(constSet.meta.maxConstIndexF, floatCount);
 
+    const DxsoPackedConstants* packedConsts = nullptr;
+
+    if (constSet.meta.packedConstantsF) {
+      packedConsts = &GetCommonShader(Shader)->GetPackedConstantsF();
+      floatCount = uint32_t(packedConsts->size());
+    }
+
     const uint32_t intRange = caps::MaxOtherConstants * sizeof(Vector4i);
     const uint32_t intDataSize = constSet.meta.maxConstIndexI * sizeof(Vector4i);
     uint32_t floatDataSize = floatCount * sizeof(Vector4);
@@ -5093,8 +5273,14 @@ namespace dxvk {
 
     if (constSet.meta.maxConstIndexI != 0)
       std::memcpy(dst->iConsts, Src.iConsts, intDataSize);
-    if (constSet.meta.maxConstIndexF != 0)
+
+    if (packedConsts != nullptr) {
+      // Only copy the registers that the shader actually reads
+      for (uint32_t i = 0; i < packedConsts->size(); i++)
+        dst->fConsts[i] = Src.fConsts[(*packedConsts)[i]];
+    } else if (constSet.meta.maxConstIndexF != 0) {
       std::memcpy(dst->fConsts, Src.fConsts, floatDataSize);
+    }
 
     if (constSet.meta.needsConstantCopies) {
       Vector4* data = reinterpret_cast<Vector4*>(dst->fConsts);
@@ -5125,6 +5311,32 @@ namespace dxvk {
   void D3D9DeviceEx::UpdateClipPlanes() {
     m_flags.clr(D3D9DeviceFlag::DirtyClipPlanes);
 
+    if (m_d3d9Options.inlineClipPlanes) {
+      std::array<D3D9ClipPlane, caps::MaxClipPlanes> planes;
+
+      static_assert(sizeof(planes) <= MaxInlineUniformBlockSize);
+
+      for (uint32_t i = 0; i < caps::MaxClipPlanes; i++) {
+        planes[i] = (m_state.renderStates[D3DRS_CLIPPLANEENABLE] & (1 << i))
+          ? m_state.clipPlanes[i]
+          : D3D9ClipPlane();
+      }
+
+      // Clip planes are written straight into the descriptor
+      // set, which avoids renaming a buffer on every change
+      EmitCs([
+        cSlotId = computeResourceSlotId(
+          DxsoProgramType::VertexShader,
+          DxsoBindingType::ConstantBuffer,
+          DxsoConstantBuffers::VSClipPlanes),
+        cPlanes = planes
+      ] (DxvkContext* ctx) {
+        ctx->bindInlineUniformData(VK_SHADER_STAGE_VERTEX_BIT,
+          cSlotId, sizeof(cPlanes), cPlanes.data());
+      });
+      return;
+    }
+
     auto slice = m_vsClipPlanes->allocSlice();
     auto dst = reinterpret_cast<D3D9ClipPlane*>(slice.mapPtr);
 
@@ -5234,9 +5446,12 @@ namespace dxvk {
       FlushCsChunk();
 
       // Reset flush timer used for implicit flushes
-      m_lastFlush = dxvk::high_resolution_clock::now();
+      m_flushTracker.notifyFlush(m_dxvkDevice.ptr(), m_csSeqNum);
+      m_hasPendingReadback = false;
       m_csIsBusy = false;
     }
+
+    m_submittedSeqNum = m_csSeqNum;
   }
 
 
@@ -5244,6 +5459,14 @@ namespace dxvk {
     EmitCs([] (DxvkContext* ctx) {
       ctx->endFrame();
     });
+
+    EvictManagedTextures();
+    UnmapTextures();
+
+    m_queryFlushedThisFrame = false;
+
+    m_dxvkDevice->addStatCtr(DxvkStatCounter::DrawStateFastPath, std::exchange(m_drawFastCount, 0u));
+    m_dxvkDevice->addStatCtr(DxvkStatCounter::DrawStateFullPath, std::exchange(m_drawFullCount, 0u));
   }
 
 
@@ -5441,14 +5664,187 @@ namespace dxvk {
   }
 
 
+  void D3D9DeviceEx::RegisterManagedTexture(D3D9CommonTexture* pResource) {
+    if (m_dxvkDevice->config().memoryEvictThreshold <= 0)
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_residencyMutex);
+
+    pResource->m_residencyIndex = m_managedTextures.size();
+    pResource->m_lastUsedFrame  = m_residencyFrame;
+
+    m_managedTextures.push_back(pResource);
+  }
+
+
+  void D3D9DeviceEx::UnregisterManagedTexture(D3D9CommonTexture* pResource) {
+    // Only registered textures can have a valid index,
+    // and only we ever change it, so this is safe
+    if (pResource->m_residencyIndex == ~size_t(0))
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_residencyMutex);
+
+    size_t index = pResource->m_residencyIndex;
+
+    if (index + 1 < m_managedTextures.size()) {
+      m_managedTextures[index] = m_managedTextures.back();
+      m_managedTextures[index]->m_residencyIndex = index;
+    }
+
+    m_managedTextures.pop_back();
+  }
+
+
+  void D3D9DeviceEx::EvictManagedTextures() {
+    std::lock_guard<dxvk::mutex> lock(m_residencyMutex);
+
+    m_residencyFrame += 1;
+
+    if (m_managedTextures.empty())
+      return;
+
+    int64_t pressure = m_dxvkDevice->getMemoryPressure();
+
+    if (pressure <= 0)
+      return;
+
+    uint32_t count = std::min<size_t>(m_managedTextures.size(), MaxEvictScanCount);
+    VkDeviceSize evicted = 0;
+
+    for (uint32_t i = 0; i < count && evicted < VkDeviceSize(pressure); i++) {
+      if (m_residencyCursor >= m_managedTextures.size())
+        m_residencyCursor = 0;
+
+      D3D9CommonTexture* texture = m_managedTextures[m_residencyCursor++];
+
+      if (texture->GetLastUsedFrame() + MinEvictAge > m_residencyFrame
+       || !texture->CanEvict())
+        continue;
+
+      // Bound textures are likely to be used again soon
+      bool isBound = false;
+
+      for (uint32_t j : bit::BitMask(m_activeTextures))
+        isBound |= GetCommonTexture(m_state.textures[j]) == texture;
+
+      if (!isBound)
+        evicted += texture->EvictImage();
+    }
+
+    if (evicted) {
+      Logger::debug(str::format("D3D9: Evicted ",
+        evicted >> 10, " kB of managed textures"));
+    }
+  }
+
+
+  void D3D9DeviceEx::ChangeMappedTextureMemory(
+          D3D9CommonTexture*  pResource,
+          VkDeviceSize        OldSize,
+          VkDeviceSize        NewSize) {
+    if (!IsTrackingMappedTextures())
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_residencyMutex);
+
+    m_mappedMemory += NewSize - OldSize;
+
+    if (!OldSize && NewSize) {
+      pResource->m_mappingIndex = m_mappedTextures.size();
+      m_mappedTextures.push_back(pResource);
+    } else if (OldSize && !NewSize) {
+      size_t index = pResource->m_mappingIndex;
+
+      if (index + 1 < m_mappedTextures.size()) {
+        m_mappedTextures[index] = m_mappedTextures.back();
+        m_mappedTextures[index]->m_mappingIndex = index;
+      }
+
+      m_mappedTextures.pop_back();
+      pResource->m_mappingIndex = ~size_t(0);
+    }
+  }
+
+
+  void D3D9DeviceEx::UnmapTextures() {
+    if (!IsTrackingMappedTextures())
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_residencyMutex);
+
+    const VkDeviceSize limit = m_d3d9Options.textureMemory > 0
+      ? VkDeviceSize(m_d3d9Options.textureMemory) << 20
+      : ~VkDeviceSize(0);
+
+    const uint64_t managedAge = uint64_t(std::max(m_d3d9Options.managedTextureUnmapAge, 0));
+
+    if (m_mappedMemory <= limit && !managedAge)
+      return;
+
+    uint32_t count = std::min<size_t>(m_mappedTextures.size(), MaxUnmapScanCount);
+    VkDeviceSize released = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+      bool overLimit = m_mappedMemory > limit;
+
+      if (!overLimit && !managedAge)
+        break;
+
+      if (m_mappingCursor >= m_mappedTextures.size())
+        m_mappingCursor = 0;
+
+      D3D9CommonTexture* texture = m_mappedTextures[m_mappingCursor];
+
+      // Over the limit, release any texture that has not been
+      // locked recently. Otherwise, only release managed ones
+      // that have not been locked for the configured age.
+      uint64_t minAge = overLimit ? MinUnmapAge : managedAge;
+
+      if ((!overLimit && !texture->IsManaged())
+       || texture->GetLastLockFrame() + minAge > m_residencyFrame
+       || !texture->CanReleaseBuffers()) {
+        m_mappingCursor += 1;
+        continue;
+      }
+
+      VkDeviceSize size = texture->ReleaseBuffers();
+      m_mappedMemory -= size;
+      released += size;
+
+      // Remove the texture from the list, the cursor
+      // now points to the texture that took its place
+      size_t index = texture->m_mappingIndex;
+
+      if (index + 1 < m_mappedTextures.size()) {
+        m_mappedTextures[index] = m_mappedTextures.back();
+        m_mappedTextures[index]->m_mappingIndex = index;
+      }
+
+      m_mappedTextures.pop_back();
+      texture->m_mappingIndex = ~size_t(0);
+    }
+
+    if (released) {
+      Logger::debug(str::format("D3D9: Released ",
+        released >> 10, " kB of texture mapping buffers"));
+    }
+  }
+
+
+  void D3D9DeviceEx::RestoreManagedTexture(D3D9CommonTexture* pResource) {
+    pResource->RestoreImage();
+
+    m_initializer->InitTexture(pResource);
+  }
+
+
   template <bool Points>
   void D3D9DeviceEx::UpdatePointMode() {
     if constexpr (!Points) {
       m_lastPointMode = 0;
 
-      EmitCs([](DxvkContext* ctx) {
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PointMode, 0);
-      });
+      SetSpecConstant(D3D9SpecConstantId::PointMode, 0);
     }
     else {
       auto& rs = m_state.renderStates;
@@ -5470,9 +5866,7 @@ namespace dxvk {
       }
 
       if (unlikely(mode != m_lastPointMode)) {
-        EmitCs([cMode = mode] (DxvkContext* ctx) {
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PointMode, cMode);
-        });
+        SetSpecConstant(D3D9SpecConstantId::PointMode, mode);
 
         m_lastPointMode = mode;
       }
@@ -5521,11 +5915,9 @@ namespace dxvk {
       if (m_flags.test(D3D9DeviceFlag::DirtyFogState)) {
         m_flags.clr(D3D9DeviceFlag::DirtyFogState);
 
-        EmitCs([cMode = mode] (DxvkContext* ctx) {
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::FogEnabled,    true);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::VertexFogMode, cMode);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PixelFogMode,  D3DFOG_NONE);
-        });
+        SetSpecConstant(D3D9SpecConstantId::FogEnabled,    true);
+        SetSpecConstant(D3D9SpecConstantId::VertexFogMode, mode);
+        SetSpecConstant(D3D9SpecConstantId::PixelFogMode,  D3DFOG_NONE);
       }
     }
     else if (pixelFog) {
@@ -5536,11 +5928,9 @@ namespace dxvk {
       if (m_flags.test(D3D9DeviceFlag::DirtyFogState)) {
         m_flags.clr(D3D9DeviceFlag::DirtyFogState);
 
-        EmitCs([cMode = mode] (DxvkContext* ctx) {
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::FogEnabled,    true);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::VertexFogMode, D3DFOG_NONE);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PixelFogMode,  cMode);
-        });
+        SetSpecConstant(D3D9SpecConstantId::FogEnabled,    true);
+        SetSpecConstant(D3D9SpecConstantId::VertexFogMode, D3DFOG_NONE);
+        SetSpecConstant(D3D9SpecConstantId::PixelFogMode,  mode);
       }
     }
     else {
@@ -5550,11 +5940,9 @@ namespace dxvk {
       if (m_flags.test(D3D9DeviceFlag::DirtyFogState)) {
         m_flags.clr(D3D9DeviceFlag::DirtyFogState);
 
-        EmitCs([cEnabled = fogEnabled] (DxvkContext* ctx) {
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::FogEnabled,    cEnabled);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::VertexFogMode, D3DFOG_NONE);
-          ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PixelFogMode,  D3DFOG_NONE);
-        });
+        SetSpecConstant(D3D9SpecConstantId::FogEnabled,    fogEnabled);
+        SetSpecConstant(D3D9SpecConstantId::VertexFogMode, D3DFOG_NONE);
+        SetSpecConstant(D3D9SpecConstantId::PixelFogMode,  D3DFOG_NONE);
       }
     }
   }
@@ -5883,9 +6271,7 @@ namespace dxvk {
       ? DecodeCompareOp(D3DCMPFUNC(rs[D3DRS_ALPHAFUNC]))
       : VK_COMPARE_OP_ALWAYS;
 
-    EmitCs([cAlphaOp = alphaOp] (DxvkContext* ctx) {
-      ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::AlphaCompareOp, cAlphaOp);
-    });
+    SetSpecConstant(D3D9SpecConstantId::AlphaCompareOp, alphaOp);
   }
 
 
@@ -5928,6 +6314,17 @@ namespace dxvk {
 
     NormalizeSamplerKey(key);
 
+    // Many sampler state changes do not affect the normalized
+    // key, e.g. the anisotropy level of non-anisotropic samplers.
+    // Skip the rebind entirely if the key did not change.
+    const uint32_t samplerBit = 1u << Sampler;
+
+    if ((m_boundSamplerMask & samplerBit) && D3D9SamplerKeyEq()(m_boundSamplerKeys[Sampler], key))
+      return;
+
+    m_boundSamplerKeys[Sampler] = key;
+    m_boundSamplerMask |= samplerBit;
+
     auto samplerInfo = RemapStateSamplerShader(Sampler);
 
     const uint32_t slot = computeResourceSlotId(
@@ -5935,14 +6332,18 @@ namespace dxvk {
       samplerInfo.second);
 
     EmitCs([this,
-      cSlot = slot,
-      cKey  = key
+      cSampler = Sampler,
+      cSlot    = slot,
+      cKey     = key
     ] (DxvkContext* ctx) {
       VkShaderStageFlags stage = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
-      auto pair = m_samplers.find(cKey);
-      if (pair != m_samplers.end()) {
-        ctx->bindResourceSampler(stage, cSlot, pair->second);
+      // Samplers are cached by the device, but most rebinds
+      // use the same state as before, so check that first
+      auto& samplerSlot = m_samplerSlots[cSampler];
+
+      if (samplerSlot.sampler != nullptr && D3D9SamplerKeyEq()(samplerSlot.key, cKey)) {
+        ctx->bindResourceSampler(stage, cSlot, samplerSlot.sampler);
         return;
       }
 
@@ -5982,10 +6383,10 @@ namespace dxvk {
       try {
         auto sampler = m_dxvkDevice->createSampler(info);
 
-        m_samplers.insert(std::make_pair(cKey, sampler));
-        ctx->bindResourceSampler(stage, cSlot, std::move(sampler));
+        samplerSlot.key     = cKey;
+        samplerSlot.sampler = sampler;
 
-        m_samplerCount++;
+        ctx->bindResourceSampler(stage, cSlot, std::move(sampler));
       }
       catch (const DxvkError& e) {
         Logger::err(e.message());
@@ -6083,6 +6484,33 @@ namespace dxvk {
 
 
   void D3D9DeviceEx::PrepareDraw(D3DPRIMITIVETYPE PrimitiveType) {
+    m_drawSeq += 1;
+
+    const uint32_t usedSamplerMask = m_psShaderMasks.samplerMask | m_vsShaderMasks.samplerMask;
+    const uint32_t usedTextureMask = m_activeTextures & usedSamplerMask;
+
+    // Setters of state that has no dedicated dirty flag set DirtyDrawState,
+    // and every other flag still set at this point was left alone by the
+    // last full pass because it does not apply to the current state. So if
+    // the flags match that snapshot, all validation below would be a no-op.
+    const uint32_t pendingTextureWork =
+        ((m_dirtySamplerStates | m_activeTexturesToUpload | m_activeTexturesToGen) & usedTextureMask)
+      | (m_dirtyTextures & usedSamplerMask);
+
+    if (likely(m_flags == m_lastDrawFlags
+            && !m_flags.test(D3D9DeviceFlag::DirtyDrawState)
+            && !m_activeHazardsRT
+            && !pendingTextureWork
+            && PrimitiveType != D3DPT_POINTLIST
+            && m_lastPointMode == 0
+            && (m_lastHazardsDS == 0) == (m_activeHazardsDS == 0))) {
+      m_drawFastCount += 1;
+      return;
+    }
+
+    m_drawFullCount += 1;
+    m_flags.clr(D3D9DeviceFlag::DirtyDrawState);
+
     if (unlikely(m_activeHazardsRT != 0)) {
       EmitCs([](DxvkContext* ctx) {
         ctx->emitRenderTargetReadbackBarrier();
@@ -6103,9 +6531,6 @@ namespace dxvk {
         FlushBuffer(vbo);
     }
 
-    const uint32_t usedSamplerMask = m_psShaderMasks.samplerMask | m_vsShaderMasks.samplerMask;
-    const uint32_t usedTextureMask = m_activeTextures & usedSamplerMask;
-
     const uint32_t texturesToUpload = m_activeTexturesToUpload & usedTextureMask;
     if (unlikely(texturesToUpload != 0))
       UploadManagedTextures(texturesToUpload);
@@ -6257,6 +6682,11 @@ namespace dxvk {
         ctx->setDepthBounds(cDepthBounds);
       });
     }
+
+    if (m_flags.test(D3D9DeviceFlag::DirtySpecializationEntries))
+      UploadSpecConstants();
+
+    m_lastDrawFlags = m_flags;
   }
 
 
@@ -6435,7 +6865,8 @@ namespace dxvk {
       cQuery->End(ctx);
     });
 
-    pQuery->NotifyEnd();
+    // The chunk containing the end command is dispatched next
+    pQuery->NotifyEnd(m_csSeqNum + 1);
     if (unlikely(pQuery->IsEvent())) {
       pQuery->IsStalling()
         ? Flush()
@@ -6450,7 +6881,9 @@ namespace dxvk {
     m_state.vsConsts.bConsts[idx] &= ~mask;
     m_state.vsConsts.bConsts[idx] |= bits & mask;
 
-    m_consts[DxsoProgramTypes::VertexShader].dirty = true;
+    m_consts[DxsoProgramTypes::VertexShader].dirtyB.add(idx * 32, 32);
+
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
   }
 
 
@@ -6458,7 +6891,9 @@ namespace dxvk {
     m_state.psConsts.bConsts[idx] &= ~mask;
     m_state.psConsts.bConsts[idx] |= bits & mask;
 
-    m_consts[DxsoProgramTypes::PixelShader].dirty = true;
+    m_consts[DxsoProgramTypes::PixelShader].dirtyB.add(idx * 32, 32);
+
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
   }
 
 
@@ -6525,17 +6960,14 @@ namespace dxvk {
       }
     }
 
-    if constexpr (ConstantType != D3D9ConstantType::Bool) {
-      uint32_t maxCount = ConstantType == D3D9ConstantType::Float
-        ? m_consts[ProgramType].meta.maxConstIndexF
-        : m_consts[ProgramType].meta.maxConstIndexI;
+    if constexpr (ConstantType == D3D9ConstantType::Float)
+      m_consts[ProgramType].dirtyF.add(StartRegister, Count);
+    else if constexpr (ConstantType == D3D9ConstantType::Int)
+      m_consts[ProgramType].dirtyI.add(StartRegister, Count);
+    else
+      m_consts[ProgramType].dirtyB.add(StartRegister, Count);
 
-      m_consts[ProgramType].dirty |= StartRegister < maxCount;
-    } else if constexpr (ProgramType == DxsoProgramType::VertexShader) {
-      if (unlikely(CanSWVP())) {
-        m_consts[DxsoProgramType::VertexShader].dirty |= StartRegister < m_consts[ProgramType].meta.maxConstIndexB;
-      }
-    }
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
 
     UpdateStateConstants<ProgramType, ConstantType, T>(
       &m_state,
@@ -6828,14 +7260,35 @@ namespace dxvk {
       if (idx >= 1)
         key.Stages[idx - 1].Contents.ResultIsTemp = false;
 
+      // The uber shader reads the stage state from the constant
+      // buffer, and keeps being used until the specialized shader
+      // for the current state has been compiled in the background.
+      bool useUberShader = m_d3d9Options.ffUberShader
+        && key.SupportsUberShader();
+
+      if (m_d3d9Options.ffUberShader && m_ffPixelShaderKey != key) {
+        m_ffPixelShaderKey = key;
+        m_flags.set(D3D9DeviceFlag::DirtyFFPixelData);
+      }
+
       EmitCs([
         this,
         cKey     = key,
+        cAsync   = useUberShader,
        &cShaders = m_ffModules
       ](DxvkContext* ctx) {
-        auto shader = cShaders.GetShaderModule(this, cKey);
+        auto shader = cAsync
+          ? cShaders.GetShaderModuleAsync(this, cKey)
+          : cShaders.GetShaderModule(this, cKey);
         ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, shader.GetShader());
       });
+
+      // Check again on the next draw so that we can
+      // switch to the specialized shader once it is ready
+      if (useUberShader && !m_ffModules.IsShaderReady(key)) {
+        m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
+        m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+      }
     }
 
     // Constants
@@ -6856,6 +7309,26 @@ namespace dxvk {
 
       D3D9FixedFunctionPS* data = reinterpret_cast<D3D9FixedFunctionPS*>(slice.mapPtr);
       DecodeD3DCOLOR((D3DCOLOR)rs[D3DRS_TEXTUREFACTOR], data->textureFactor.data);
+
+      if (m_d3d9Options.ffUberShader) {
+        for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+          const auto& src = m_ffPixelShaderKey.Stages[i].Contents;
+          auto& dst = data->stages[i];
+
+          dst.colorOp        = src.ColorOp;
+          dst.colorArgs[0]   = src.ColorArg0;
+          dst.colorArgs[1]   = src.ColorArg1;
+          dst.colorArgs[2]   = src.ColorArg2;
+          dst.alphaOp        = src.AlphaOp;
+          dst.alphaArgs[0]   = src.AlphaArg0;
+          dst.alphaArgs[1]   = src.AlphaArg1;
+          dst.alphaArgs[2]   = src.AlphaArg2;
+          dst.resultIsTemp   = src.ResultIsTemp;
+          dst.projected      = src.Projected;
+          dst.projectedCount = src.ProjectedCount;
+          dst.reserved       = 0;
+        }
+      }
     }
   }
 
@@ -6876,9 +7349,7 @@ namespace dxvk {
     if (value == m_lastBoolSpecConstantVertex)
       return;
 
-    EmitCs([cBitfield = value](DxvkContext* ctx) {
-      ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::VertexShaderBools, cBitfield);
-      });
+    SetSpecConstant(D3D9SpecConstantId::VertexShaderBools, value);
 
     m_lastBoolSpecConstantVertex = value;
   }
@@ -6888,9 +7359,7 @@ namespace dxvk {
     if (value == m_lastBoolSpecConstantPixel)
       return;
 
-    EmitCs([cBitfield = value](DxvkContext* ctx) {
-      ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::PixelShaderBools, cBitfield);
-      });
+    SetSpecConstant(D3D9SpecConstantId::PixelShaderBools, value);
 
     m_lastBoolSpecConstantPixel = value;
   }
@@ -6902,15 +7371,9 @@ namespace dxvk {
       m_lastProjectionBitfield  = projections;
       m_lastFetch4 = fetch4;
 
-      EmitCs([
-        cSamplerType = types,
-        cProjectionType = projections,
-        cFetch4 = fetch4
-      ] (DxvkContext* ctx) {
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::SamplerType, cSamplerType);
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::ProjectionType, cProjectionType);
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::Fetch4, cFetch4);
-      });
+      SetSpecConstant(D3D9SpecConstantId::SamplerType, types);
+      SetSpecConstant(D3D9SpecConstantId::ProjectionType, projections);
+      SetSpecConstant(D3D9SpecConstantId::Fetch4, fetch4);
     }
   }
 
@@ -6920,17 +7383,45 @@ namespace dxvk {
       m_lastSamplerNull = nullMask;
       m_lastSamplerDepthMode = depthMask;
 
-      EmitCs([
-        cNullMask = nullMask,
-        cDepthMask = depthMask
-      ] (DxvkContext* ctx) {
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::SamplerNull, cNullMask);
-        ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::SamplerDepthMode, cDepthMask);
-      });
+      SetSpecConstant(D3D9SpecConstantId::SamplerNull, nullMask);
+      SetSpecConstant(D3D9SpecConstantId::SamplerDepthMode, depthMask);
     }
   }
 
 
+  void D3D9DeviceEx::SetSpecConstant(D3D9SpecConstantId Id, uint32_t Value) {
+    // Keep a copy in the spec constant buffer for pipelines
+    // that are compiled without specialization constants
+    if (m_specInfo.data[Id] != Value) {
+      m_specInfo.data[Id] = Value;
+      m_flags.set(D3D9DeviceFlag::DirtySpecializationEntries);
+    }
+
+    EmitCs([
+      cId    = Id,
+      cValue = Value
+    ] (DxvkContext* ctx) {
+      ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, cId, cValue);
+    });
+  }
+
+
+  void D3D9DeviceEx::UploadSpecConstants() {
+    m_flags.clr(D3D9DeviceFlag::DirtySpecializationEntries);
+
+    DxvkBufferSliceHandle slice = m_specBuffer->allocSlice();
+
+    EmitCs([
+      cBuffer = m_specBuffer,
+      cSlice  = slice
+    ] (DxvkContext* ctx) {
+      ctx->invalidateBuffer(cBuffer, cSlice);
+    });
+
+    std::memcpy(slice.mapPtr, &m_specInfo, sizeof(m_specInfo));
+  }
+
+
   void D3D9DeviceEx::ApplyPrimitiveType(
     DxvkContext*      pContext,
     D3DPRIMITIVETYPE  PrimType) {
@@ -7060,6 +7551,8 @@ namespace dxvk {
 
 
   HRESULT D3D9DeviceEx::ResetState(D3DPRESENT_PARAMETERS* pPresentationParameters) {
+    m_flags.set(D3D9DeviceFlag::DirtyDrawState);
+
     if (!pPresentationParameters->EnableAutoDepthStencil)
       SetDepthStencilSurface(nullptr);
 
@@ -2,6 +2,7 @@
 
 #include "../dxvk/dxvk_device.h"
 #include "../dxvk/dxvk_cs.h"
+#include "../dxvk/dxvk_flush.h"
 
 #include "d3d9_include.h"
 #include "d3d9_cursor.h"
@@ -72,6 +73,8 @@ namespace dxvk {
     ValidSampleMask,
     DirtyDepthBounds,
     DirtyPointScale,
+    DirtySpecializationEntries,
+    DirtyDrawState,
 
     InScene,
   };
@@ -92,12 +95,19 @@ namespace dxvk {
     constexpr static uint32_t DefaultFrameLatency = 3;
     constexpr static uint32_t MaxFrameLatency     = 20;
 
-    constexpr static uint32_t MinFlushIntervalUs = 750;
-    constexpr static uint32_t IncFlushIntervalUs = 250;
-    constexpr static uint32_t MaxPendingSubmits = 6;
-
     constexpr static uint32_t NullStreamIdx = caps::MaxStreams;
 
+    /// Number of managed textures to look at per frame
+    constexpr static uint32_t MaxEvictScanCount = 256;
+    /// Number of frames a managed texture must remain
+    /// unbound for before its image can be evicted
+    constexpr static uint64_t MinEvictAge = 300;
+    /// Number of mapped textures to look at per frame
+    constexpr static uint32_t MaxUnmapScanCount = 256;
+    /// Number of frames a texture must remain unlocked
+    /// for before its mapping buffers can be released
+    constexpr static uint64_t MinUnmapAge = 60;
+
     friend class D3D9SwapChainEx;
     friend class D3D9UserDefinedAnnotation;
   public:
@@ -773,6 +783,77 @@ namespace dxvk {
 
     void MarkTextureUploaded(D3D9CommonTexture* pResource);
 
+    /**
+     * \brief Registers a managed texture for eviction
+     *
+     * Called when a managed texture is created. Has
+     * no effect if memory eviction is disabled.
+     * \param [in] pResource The texture
+     */
+    void RegisterManagedTexture(D3D9CommonTexture* pResource);
+
+    /**
+     * \brief Unregisters a managed texture
+     *
+     * Called when a texture is destroyed.
+     * \param [in] pResource The texture
+     */
+    void UnregisterManagedTexture(D3D9CommonTexture* pResource);
+
+    /**
+     * \brief Evicts cold managed textures
+     *
+     * Frees the images of managed textures that have not been
+     * bound in a while if device memory is over budget. The
+     * images are restored and uploaded from the mapping buffers
+     * on next use. Called once per frame.
+     */
+    void EvictManagedTextures();
+
+    /**
+     * \brief Tracks mapping buffer memory of a texture
+     *
+     * Called whenever a mapping buffer of a texture with
+     * a backing image gets created or destroyed. Has no
+     * effect if mapped texture memory is not limited.
+     * \param [in] pResource The texture
+     * \param [in] OldSize Previous mapping buffer size
+     * \param [in] NewSize New mapping buffer size
+     */
+    void ChangeMappedTextureMemory(
+            D3D9CommonTexture*  pResource,
+            VkDeviceSize        OldSize,
+            VkDeviceSize        NewSize);
+
+    /**
+     * \brief Releases cold mapping buffers
+     *
+     * Frees the mapping buffers of textures that have not been
+     * locked in a while if the total size of mapping buffers
+     * exceeds the configured limit, as well as the buffers of
+     * managed textures that exceeded the configured unmap age.
+     * This keeps the address space usage of 32-bit processes
+     * in check. Called once per frame.
+     */
+    void UnmapTextures();
+
+    /**
+     * \brief Checks whether texture mapping buffers are tracked
+     * \returns \c true if any unmapping policy is enabled
+     */
+    bool IsTrackingMappedTextures() const {
+      return m_d3d9Options.textureMemory > 0
+          || m_d3d9Options.managedTextureUnmapAge > 0;
+    }
+
+    /**
+     * \brief Restores an evicted managed texture
+     *
+     * The caller must upload the texture afterwards.
+     * \param [in] pResource The texture
+     */
+    void RestoreManagedTexture(D3D9CommonTexture* pResource);
+
     template <bool Points>
     void UpdatePointMode();
 
@@ -899,6 +980,18 @@ namespace dxvk {
 
     void FlushImplicit(BOOL StrongHint);
 
+    void FlushReadback();
+
+    /**
+     * \brief Flushes for a query that is being polled
+     *
+     * Does not submit anything if the commands that complete
+     * the query were already submitted, since the query will
+     * then complete on its own.
+     * \param [in] SequenceNumber CS chunk that ends the query
+     */
+    void FlushForQuery(uint64_t SequenceNumber);
+
     bool ChangeReportedMemory(int64_t delta) {
       if (IsExtended())
         return true;
@@ -927,19 +1020,21 @@ namespace dxvk {
     HRESULT InitialReset(D3DPRESENT_PARAMETERS* pPresentationParameters, D3DDISPLAYMODEEX* pFullscreenDisplayMode);
 
     UINT GetSamplerCount() const {
-      return m_samplerCount.load();
+      return m_dxvkDevice->getSamplerStats().liveCount;
     }
 
   private:
 
     DxvkCsChunkRef AllocCsChunk() {
-      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(DxvkCsChunkFlag::SingleUse);
+      DxvkCsChunk* chunk = m_csChunkPool.allocChunk(
+        DxvkCsChunkFlag::SingleUse, m_csSizer.sizeClass());
       return DxvkCsChunkRef(chunk, &m_csChunkPool);
     }
 
     template<typename Cmd>
     void EmitCs(Cmd&& command) {
       if (unlikely(!m_csChunk->push(command))) {
+        m_csSizer.notifyChunk(m_csChunk);
         EmitCsChunk(std::move(m_csChunk));
 
         m_csChunk = AllocCsChunk();
@@ -951,6 +1046,7 @@ namespace dxvk {
 
     void FlushCsChunk() {
       if (likely(!m_csChunk->empty())) {
+        m_csSizer.notifyChunk(m_csChunk);
         EmitCsChunk(std::move(m_csChunk));
         m_csChunk = AllocCsChunk();
       }
@@ -1130,6 +1226,10 @@ namespace dxvk {
 
     void UpdateCommonSamplerSpecConstants(uint32_t boundMask, uint32_t depthMask);
 
+    void SetSpecConstant(D3D9SpecConstantId Id, uint32_t Value);
+
+    void UploadSpecConstants();
+
     void TrackBufferMappingBufferSequenceNumber(
       D3D9CommonBuffer* pResource);
 
@@ -1166,10 +1266,22 @@ namespace dxvk {
     Rc<DxvkBuffer>                  m_vsVertexBlend;
     Rc<DxvkBuffer>                  m_psFixedFunction;
     Rc<DxvkBuffer>                  m_psShared;
+    Rc<DxvkBuffer>                  m_specBuffer;
+
+    D3D9SpecializationInfo          m_specInfo;
 
     D3D9BufferSlice                 m_upBuffer;
     D3D9BufferSlice                 m_managedUploadBuffer;
 
+    dxvk::mutex                     m_residencyMutex;
+    std::vector<D3D9CommonTexture*> m_managedTextures;
+    size_t                          m_residencyCursor = 0;
+    uint64_t                        m_residencyFrame  = 0;
+
+    std::vector<D3D9CommonTexture*> m_mappedTextures;
+    size_t                          m_mappingCursor   = 0;
+    VkDeviceSize                    m_mappedMemory    = 0;
+
     D3D9Cursor                      m_cursor;
 
     Com<D3D9Surface, false>         m_autoDepthStencil;
@@ -1179,11 +1291,12 @@ namespace dxvk {
     const D3D9Options               m_d3d9Options;
     DxsoOptions                     m_dxsoOptions;
 
-    std::unordered_map<
-      D3D9SamplerKey,
-      Rc<DxvkSampler>,
-      D3D9SamplerKeyHash,
-      D3D9SamplerKeyEq>             m_samplers;
+    // Only accessed on the CS thread
+    std::array<D3D9SamplerSlot, SamplerCount> m_samplerSlots;
+
+    // Last key bound to each sampler slot
+    std::array<D3D9SamplerKey, SamplerCount> m_boundSamplerKeys;
+    uint32_t                        m_boundSamplerMask = 0;
 
     std::unordered_map<
       DWORD,
@@ -1194,6 +1307,15 @@ namespace dxvk {
     D3D9InputAssemblyState          m_iaState;
 
     D3D9DeviceFlags                 m_flags;
+    // Flags as left behind by the last full PrepareDraw. If
+    // nothing changed since, the next draw can skip validation.
+    D3D9DeviceFlags                 m_lastDrawFlags;
+    uint32_t                        m_drawFastCount = 0;
+    uint32_t                        m_drawFullCount = 0;
+    // Incremented on every draw, used to tell whether
+    // a buffer may have been read since it was discarded.
+    uint64_t                        m_drawSeq = 0;
+
     // Last state of depth textures. Doesn't update when NULL is bound.
     // & with m_activeTextures to normalize.
     uint32_t                        m_instancedData = 0;
@@ -1230,6 +1352,7 @@ namespace dxvk {
     uint32_t                        m_lastFetch4    = 0;
     uint32_t                        m_lastHazardsDS = 0;
     uint32_t                        m_lastSamplerTypesFF = 0;
+    D3D9FFShaderKeyFS               m_ffPixelShaderKey;
 
     D3D9ShaderMasks                 m_vsShaderMasks = D3D9ShaderMasks();
     D3D9ShaderMasks                 m_psShaderMasks = FixedFunctionMask;
@@ -1260,15 +1383,18 @@ namespace dxvk {
     D3D9ViewportInfo                m_viewportInfo;
 
     DxvkCsChunkPool                 m_csChunkPool;
-    dxvk::high_resolution_clock::time_point m_lastFlush
-      = dxvk::high_resolution_clock::now();
+    DxvkFlushTracker                m_flushTracker;
+    bool                            m_hasPendingReadback = false;
     DxvkCsThread                    m_csThread;
+    DxvkCsChunkSizer                m_csSizer;
     DxvkCsChunkRef                  m_csChunk;
     uint64_t                        m_csSeqNum = 0ull;
+    uint64_t                        m_submittedSeqNum = 0ull;
+    bool                            m_queryFlushedThisFrame = false;
+    uint64_t                        m_convertSeqNum = ~0ull;
     bool                            m_csIsBusy = false;
 
     std::atomic<int64_t>            m_availableMemory = { 0 };
-    std::atomic<int32_t>            m_samplerCount    = { 0 };
 
     Direct3DState9                  m_state;
 
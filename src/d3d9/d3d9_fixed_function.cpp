@@ -15,9 +15,22 @@ namespace dxvk {
 
   D3D9FixedFunctionOptions::D3D9FixedFunctionOptions(const D3D9Options* options) {
     invariantPosition = options->invariantPosition;
+    inlineClipPlanes  = options->inlineClipPlanes;
   }
 
-  uint32_t DoFixedFunctionFog(SpirvModule& spvModule, const D3D9FogContext& fogCtx) {
+
+  Sha1Hash D3D9FixedFunctionOptions::hash() const {
+    // The first entry distinguishes fixed-function
+    // shaders from other shaders in the shader cache
+    std::array<uint32_t, 3> data = {
+      uint32_t(0x39304646), // 'FF09'
+      uint32_t(invariantPosition),
+      uint32_t(inlineClipPlanes) };
+
+    return Sha1Hash::compute(data.data(), data.size() * sizeof(uint32_t));
+  }
+
+  uint32_t DoFixedFunctionFog(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, const D3D9FogContext& fogCtx) {
     uint32_t floatType  = spvModule.defFloatType(32);
     uint32_t uint32Type = spvModule.defIntType(32, 0);
     uint32_t vec3Type   = spvModule.defVectorType(floatType, 3);
@@ -41,20 +54,13 @@ namespace dxvk {
     uint32_t fogDensity = spvModule.opLoad(floatType,
       spvModule.opAccessChain(floatPtr, fogCtx.RenderState, 1, &fogDensityMember));
 
-    uint32_t fogMode = spvModule.specConst32(uint32Type, 0);
-
-    if (!fogCtx.IsPixel) {
-      spvModule.setDebugName(fogMode, "vertex_fog_mode");
-      spvModule.decorateSpecId(fogMode, getSpecId(D3D9SpecConstantId::VertexFogMode));
-    }
-    else {
-      spvModule.setDebugName(fogMode, "pixel_fog_mode");
-      spvModule.decorateSpecId(fogMode, getSpecId(D3D9SpecConstantId::PixelFogMode));
-    }
+    uint32_t fogMode = spec.get(spvModule, fogCtx.SpecUBO, fogCtx.IsPixel
+      ? D3D9SpecConstantId::PixelFogMode
+      : D3D9SpecConstantId::VertexFogMode);
 
-    uint32_t fogEnabled = spvModule.specConstBool(false);
-    spvModule.setDebugName(fogEnabled, "fog_enabled");
-    spvModule.decorateSpecId(fogEnabled, getSpecId(D3D9SpecConstantId::FogEnabled));
+    uint32_t fogEnabled = spvModule.opINotEqual(spvModule.defBoolType(),
+      spec.get(spvModule, fogCtx.SpecUBO, D3D9SpecConstantId::FogEnabled),
+      spvModule.constu32(0));
 
     uint32_t doFog   = spvModule.allocateId();
     uint32_t skipFog = spvModule.allocateId();
@@ -254,7 +260,39 @@ namespace dxvk {
   }
 
 
-  D3D9PointSizeInfoVS GetPointSizeInfoVS(SpirvModule& spvModule, uint32_t vPos, uint32_t vtx, uint32_t perVertPointSize, uint32_t rsBlock, bool isFixedFunction) {
+  uint32_t SetupSpecUBO(SpirvModule& spvModule, std::vector<DxvkBindingInfo>& bindings) {
+    uint32_t uintType = spvModule.defIntType(32, 0);
+
+    std::array<uint32_t, SpecConstantCount> specMembers;
+    specMembers.fill(uintType);
+
+    uint32_t specStruct = spvModule.defStructTypeUnique(specMembers.size(), specMembers.data());
+
+    spvModule.setDebugName         (specStruct, "spec_state_t");
+    spvModule.decorate             (specStruct, spv::DecorationBlock);
+
+    for (uint32_t i = 0; i < SpecConstantCount; i++)
+      spvModule.memberDecorateOffset(specStruct, i, sizeof(uint32_t) * i);
+
+    uint32_t specBlock = spvModule.newVar(
+      spvModule.defPointerType(specStruct, spv::StorageClassUniform),
+      spv::StorageClassUniform);
+
+    spvModule.setDebugName         (specBlock, "spec_state");
+    spvModule.decorateDescriptorSet(specBlock, 0);
+    spvModule.decorateBinding      (specBlock, getSpecConstantBufferSlot());
+
+    DxvkBindingInfo binding = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
+    binding.resourceBinding = getSpecConstantBufferSlot();
+    binding.viewType        = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
+    binding.access          = VK_ACCESS_UNIFORM_READ_BIT;
+    bindings.push_back(binding);
+
+    return specBlock;
+  }
+
+
+  D3D9PointSizeInfoVS GetPointSizeInfoVS(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, uint32_t vPos, uint32_t vtx, uint32_t perVertPointSize, uint32_t rsBlock, uint32_t specUbo, bool isFixedFunction) {
     uint32_t floatType  = spvModule.defFloatType(32);
     uint32_t floatPtr   = spvModule.defPointerType(floatType, spv::StorageClassPushConstant);
     uint32_t vec3Type   = spvModule.defVectorType(floatType, 3);
@@ -270,9 +308,7 @@ namespace dxvk {
     uint32_t value = perVertPointSize != 0 ? perVertPointSize : LoadFloat(D3D9RenderStateItem::PointSize);
 
     if (isFixedFunction) {
-      uint32_t pointMode = spvModule.specConst32(uint32Type, 0);
-      spvModule.setDebugName(pointMode, "point_mode");
-      spvModule.decorateSpecId(pointMode, getSpecId(D3D9SpecConstantId::PointMode));
+      uint32_t pointMode = spec.get(spvModule, specUbo, D3D9SpecConstantId::PointMode);
 
       uint32_t scaleBit  = spvModule.opBitFieldUExtract(uint32Type, pointMode, spvModule.consti32(0), spvModule.consti32(1));
       uint32_t isScale   = spvModule.opIEqual(boolType, scaleBit, spvModule.constu32(1));
@@ -318,14 +354,12 @@ namespace dxvk {
   }
 
 
-  D3D9PointSizeInfoPS GetPointSizeInfoPS(SpirvModule& spvModule, uint32_t rsBlock) {
+  D3D9PointSizeInfoPS GetPointSizeInfoPS(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, uint32_t rsBlock, uint32_t specUbo) {
     uint32_t uint32Type = spvModule.defIntType(32, 0);
     uint32_t boolType   = spvModule.defBoolType();
     uint32_t boolVec4   = spvModule.defVectorType(boolType, 4);
 
-    uint32_t pointMode = spvModule.specConst32(uint32Type, 0);
-    spvModule.setDebugName(pointMode, "point_mode");
-    spvModule.decorateSpecId(pointMode, getSpecId(D3D9SpecConstantId::PointMode));
+    uint32_t pointMode = spec.get(spvModule, specUbo, D3D9SpecConstantId::PointMode);
 
     uint32_t spriteBit  = spvModule.opBitFieldUExtract(uint32Type, pointMode, spvModule.consti32(1), spvModule.consti32(1));
     uint32_t isSprite   = spvModule.opIEqual(boolType, spriteBit, spvModule.constu32(1));
@@ -517,6 +551,7 @@ namespace dxvk {
 
   enum D3D9FFPSMembers {
     TextureFactor = 0,
+    StageData,
 
     MemberCount
   };
@@ -631,8 +666,11 @@ namespace dxvk {
     uint32_t              m_entryPointId;
 
     uint32_t              m_rsBlock;
+    uint32_t              m_specUbo;
     uint32_t              m_mainFuncLabel;
 
+    D3D9ShaderSpecConstantManager m_spec;
+
     D3D9FixedFunctionOptions m_options;
   };
 
@@ -1163,6 +1201,7 @@ namespace dxvk {
     fogCtx.IsPixel     = false;
     fogCtx.RangeFog    = m_vsKey.Data.Contents.RangeFog;
     fogCtx.RenderState = m_rsBlock;
+    fogCtx.SpecUBO     = m_specUbo;
     fogCtx.vPos        = vtx;
     fogCtx.HasFogInput = m_vsKey.Data.Contents.HasFog;
     fogCtx.vFog        = m_vs.in.FOG;
@@ -1171,9 +1210,9 @@ namespace dxvk {
     fogCtx.IsPositionT = m_vsKey.Data.Contents.HasPositionT;
     fogCtx.HasSpecular = m_vsKey.Data.Contents.HasColor1;
     fogCtx.Specular    = m_vs.in.COLOR[1];
-    m_module.opStore(m_vs.out.FOG, DoFixedFunctionFog(m_module, fogCtx));
+    m_module.opStore(m_vs.out.FOG, DoFixedFunctionFog(m_spec, m_module, fogCtx));
 
-    auto pointInfo = GetPointSizeInfoVS(m_module, 0, vtx, m_vs.in.POINTSIZE, m_rsBlock, true);
+    auto pointInfo = GetPointSizeInfoVS(m_spec, m_module, 0, vtx, m_vs.in.POINTSIZE, m_rsBlock, m_specUbo, true);
 
     uint32_t pointSize = m_module.opFClamp(m_floatType, pointInfo.defaultValue, pointInfo.min, pointInfo.max);
     m_module.opStore(m_vs.out.POINTSIZE, pointSize);
@@ -1198,6 +1237,8 @@ namespace dxvk {
     }
 
     m_rsBlock = SetupRenderStateBlock(m_module, count);
+    m_specUbo = SetupSpecUBO(m_module, m_bindings);
+    m_spec.declareFallback(m_module);
   }
 
 
@@ -1542,6 +1583,27 @@ namespace dxvk {
 
 
   void D3D9FFShaderCompiler::compilePS() {
+    const bool uberShader = m_fsKey.Stages[0].Contents.UberShader;
+
+    // The uber shader keeps its registers in function variables
+    // since the stages are executed conditionally. These must be
+    // declared before any other code is emitted.
+    struct {
+      uint32_t current;
+      uint32_t temp;
+      uint32_t texture;
+      uint32_t result;
+    } uberVars = { };
+
+    if (uberShader) {
+      uint32_t ptrType = m_module.defPointerType(m_vec4Type, spv::StorageClassFunction);
+
+      uberVars.current = m_module.newVar(ptrType, spv::StorageClassFunction);
+      uberVars.temp    = m_module.newVar(ptrType, spv::StorageClassFunction);
+      uberVars.texture = m_module.newVar(ptrType, spv::StorageClassFunction);
+      uberVars.result  = m_module.newVar(ptrType, spv::StorageClassFunction);
+    }
+
     setupPS();
 
     uint32_t diffuse  = m_ps.in.COLOR[0];
@@ -1554,6 +1616,12 @@ namespace dxvk {
     
     uint32_t texture = m_module.constvec4f32(0.0f, 0.0f, 0.0f, 1.0f);
 
+    if (uberShader) {
+      m_module.opStore(uberVars.current, current);
+      m_module.opStore(uberVars.temp,    temp);
+      m_module.opStore(uberVars.texture, texture);
+    }
+
     for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
       const auto& stage = m_fsKey.Stages[i].Contents;
 
@@ -1882,6 +1950,242 @@ namespace dxvk {
         return dst;
       };
 
+      if (uberShader) {
+        uint32_t boolType  = m_module.defBoolType();
+        uint32_t bvec2Type = m_module.defVectorType(boolType, 2);
+        uint32_t bvec4Type = m_module.defVectorType(boolType, 4);
+        uint32_t uvec4Type = m_module.defVectorType(m_uint32Type, 4);
+
+        auto LoadStageData = [&](uint32_t stageIdx, uint32_t vectorIdx) {
+          std::array<uint32_t, 2> indices = {
+            m_module.constu32(uint32_t(D3D9FFPSMembers::StageData)),
+            m_module.constu32(3 * stageIdx + vectorIdx) };
+
+          uint32_t ptr = m_module.opAccessChain(
+            m_module.defPointerType(uvec4Type, spv::StorageClassUniform),
+            m_ps.constantBuffer, indices.size(), indices.data());
+
+          return m_module.opLoad(uvec4Type, ptr);
+        };
+
+        auto Extract = [&](uint32_t vector, uint32_t idx) {
+          return m_module.opCompositeExtract(m_uint32Type, vector, 1, &idx);
+        };
+
+        auto IsEqual = [&](uint32_t value, uint32_t literal) {
+          return m_module.opIEqual(boolType, value, m_module.constu32(literal));
+        };
+
+        auto HasBits = [&](uint32_t value, uint32_t mask) {
+          return m_module.opINotEqual(boolType,
+            m_module.opBitwiseAnd(m_uint32Type, value, m_module.constu32(mask)),
+            m_module.constu32(0));
+        };
+
+        auto SelectVec4 = [&](uint32_t cond, uint32_t a, uint32_t b) {
+          std::array<uint32_t, 4> conds = { cond, cond, cond, cond };
+          uint32_t condVec = m_module.opCompositeConstruct(bvec4Type, conds.size(), conds.data());
+          return m_module.opSelect(m_vec4Type, condVec, a, b);
+        };
+
+        uint32_t colorData = LoadStageData(i, 0);
+        uint32_t alphaData = LoadStageData(i, 1);
+        uint32_t miscData  = LoadStageData(i, 2);
+
+        uint32_t colorOp = Extract(colorData, 0);
+        uint32_t alphaOp = Extract(alphaData, 0);
+
+        // All stages after the first disabled one are disabled too,
+        // so skipping individual stages is enough. The condition is
+        // uniform, which keeps implicit derivatives well-defined.
+        uint32_t enabledLabel = m_module.allocateId();
+        uint32_t skipLabel    = m_module.allocateId();
+
+        m_module.opSelectionMerge(skipLabel, spv::SelectionControlMaskNone);
+        m_module.opBranchConditional(
+          m_module.opINotEqual(boolType, colorOp, m_module.constu32(D3DTOP_DISABLE)),
+          enabledLabel, skipLabel);
+        m_module.opLabel(enabledLabel);
+
+        current = m_module.opLoad(m_vec4Type, uberVars.current);
+        temp    = m_module.opLoad(m_vec4Type, uberVars.temp);
+        texture = m_module.opLoad(m_vec4Type, uberVars.texture);
+
+        // Whether the texture is used is not known in advance,
+        // so sample it unconditionally.
+        uint32_t projected = HasBits(Extract(miscData, 1), ~0u);
+        uint32_t projCount = Extract(miscData, 2);
+
+        uint32_t projIdx = m_module.opSelect(m_uint32Type, IsEqual(projCount, 0),
+          m_module.constu32(3), m_module.opISub(m_uint32Type, projCount, m_module.constu32(1)));
+        projIdx = m_module.opUMin(m_uint32Type, projIdx, m_module.constu32(3));
+
+        uint32_t projValue = m_module.opVectorExtractDynamic(m_floatType, m_ps.in.TEXCOORD[i], projIdx);
+        projValue = m_module.opSelect(m_floatType, projected, projValue, m_module.constf32(1.0f));
+
+        std::array<uint32_t, 2> xy = { 0, 1 };
+        uint32_t texcoord = m_module.opVectorShuffle(m_vec2Type,
+          m_ps.in.TEXCOORD[i], m_ps.in.TEXCOORD[i], xy.size(), xy.data());
+        texcoord = m_module.opVectorTimesScalar(m_vec2Type, texcoord,
+          m_module.opFDiv(m_floatType, m_module.constf32(1.0f), projValue));
+
+        uint32_t isBumpLuminance = 0;
+
+        if (i != 0) {
+          uint32_t prevColorOp = Extract(LoadStageData(i - 1, 0), 0);
+
+          isBumpLuminance = IsEqual(prevColorOp, D3DTOP_BUMPENVMAPLUMINANCE);
+
+          uint32_t isBump = m_module.opLogicalOr(boolType,
+            IsEqual(prevColorOp, D3DTOP_BUMPENVMAP), isBumpLuminance);
+
+          std::array<uint32_t, 2> conds = { isBump, isBump };
+          uint32_t condVec = m_module.opCompositeConstruct(bvec2Type, conds.size(), conds.data());
+
+          texcoord = m_module.opSelect(m_vec2Type, condVec,
+            DoBumpmapCoords(m_vec2Type, texcoord), texcoord);
+        }
+
+        SpirvImageOperands imageOperands;
+        uint32_t imageVarId = m_module.opLoad(m_ps.samplers[i].typeId, m_ps.samplers[i].varId);
+        texture = m_module.opImageSampleImplicitLod(m_vec4Type, imageVarId, texcoord, imageOperands);
+
+        if (i != 0) {
+          uint32_t index = m_module.constu32(D3D9SharedPSStages_Count * (i - 1) + D3D9SharedPSStages_BumpEnvLScale);
+          uint32_t lScale = m_module.opAccessChain(m_module.defPointerType(m_floatType, spv::StorageClassUniform),
+                                                   m_ps.sharedState, 1, &index);
+                   lScale = m_module.opLoad(m_floatType, lScale);
+
+                   index = m_module.constu32(D3D9SharedPSStages_Count * (i - 1) + D3D9SharedPSStages_BumpEnvLOffset);
+          uint32_t lOffset = m_module.opAccessChain(m_module.defPointerType(m_floatType, spv::StorageClassUniform),
+                                                    m_ps.sharedState, 1, &index);
+                   lOffset = m_module.opLoad(m_floatType, lOffset);
+
+          uint32_t zIndex = 2;
+          uint32_t scale = m_module.opCompositeExtract(m_floatType, texture, 1, &zIndex);
+                   scale = m_module.opFMul(m_floatType, scale, lScale);
+                   scale = m_module.opFAdd(m_floatType, scale, lOffset);
+                   scale = m_module.opFClamp(m_floatType, scale, m_module.constf32(0.0f), m_module.constf32(1.0));
+                   scale = m_module.opSelect(m_floatType, isBumpLuminance, scale, m_module.constf32(1.0f));
+
+          texture = m_module.opVectorTimesScalar(m_vec4Type, texture, scale);
+        }
+
+        m_module.opStore(uberVars.texture, texture);
+        processedTexture = true;
+
+        uint32_t constantOffset = m_module.constu32(D3D9SharedPSStages_Count * i + D3D9SharedPSStages_Constant);
+        uint32_t constant = m_module.opAccessChain(m_module.defPointerType(m_vec4Type, spv::StorageClassUniform),
+          m_ps.sharedState, 1, &constantOffset);
+        constant = m_module.opLoad(m_vec4Type, constant);
+
+        auto GetUberArg = [&] (uint32_t arg) {
+          std::array<std::pair<uint32_t, uint32_t>, 7> sources = {{
+            { D3DTA_CONSTANT, constant },
+            { D3DTA_CURRENT,  current  },
+            { D3DTA_DIFFUSE,  diffuse  },
+            { D3DTA_SPECULAR, specular },
+            { D3DTA_TEMP,     temp     },
+            { D3DTA_TEXTURE,  texture  },
+            { D3DTA_TFACTOR,  m_ps.constants.textureFactor },
+          }};
+
+          uint32_t select = m_module.opBitwiseAnd(m_uint32Type, arg, m_module.constu32(D3DTA_SELECTMASK));
+          uint32_t reg = m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f);
+
+          for (const auto& source : sources)
+            reg = SelectVec4(IsEqual(select, source.first), source.second, reg);
+
+          reg = SelectVec4(HasBits(arg, D3DTA_COMPLEMENT),     Complement(reg),     reg);
+          reg = SelectVec4(HasBits(arg, D3DTA_ALPHAREPLICATE), AlphaReplicate(reg), reg);
+          return reg;
+        };
+
+        auto DoUberOp = [&] (uint32_t op, uint32_t dst, const std::array<uint32_t, TextureArgCount>& args) {
+          // Bump mapping only affects the texture of the next stage,
+          // and pre-modulation is not implemented, so these as well
+          // as disabled stages fall through to the default case.
+          static constexpr std::array<D3DTEXTUREOP, 22> ops = {
+            D3DTOP_SELECTARG1,
+            D3DTOP_SELECTARG2,
+            D3DTOP_MODULATE,
+            D3DTOP_MODULATE2X,
+            D3DTOP_MODULATE4X,
+            D3DTOP_ADD,
+            D3DTOP_ADDSIGNED,
+            D3DTOP_ADDSIGNED2X,
+            D3DTOP_SUBTRACT,
+            D3DTOP_ADDSMOOTH,
+            D3DTOP_BLENDDIFFUSEALPHA,
+            D3DTOP_BLENDTEXTUREALPHA,
+            D3DTOP_BLENDFACTORALPHA,
+            D3DTOP_BLENDTEXTUREALPHAPM,
+            D3DTOP_BLENDCURRENTALPHA,
+            D3DTOP_MODULATEALPHA_ADDCOLOR,
+            D3DTOP_MODULATECOLOR_ADDALPHA,
+            D3DTOP_MODULATEINVALPHA_ADDCOLOR,
+            D3DTOP_MODULATEINVCOLOR_ADDALPHA,
+            D3DTOP_DOTPRODUCT3,
+            D3DTOP_MULTIPLYADD,
+            D3DTOP_LERP,
+          };
+
+          std::array<SpirvSwitchCaseLabel, ops.size()> caseLabels;
+
+          for (uint32_t j = 0; j < ops.size(); j++) {
+            caseLabels[j].literal = uint32_t(ops[j]);
+            caseLabels[j].labelId = m_module.allocateId();
+          }
+
+          uint32_t defaultLabel = m_module.allocateId();
+          uint32_t mergeLabel   = m_module.allocateId();
+
+          m_module.opSelectionMerge(mergeLabel, spv::SelectionControlMaskNone);
+          m_module.opSwitch(op, defaultLabel, caseLabels.size(), caseLabels.data());
+
+          for (uint32_t j = 0; j < ops.size(); j++) {
+            m_module.opLabel(caseLabels[j].labelId);
+            m_module.opStore(uberVars.result, DoOp(ops[j], dst, args));
+            m_module.opBranch(mergeLabel);
+          }
+
+          m_module.opLabel(defaultLabel);
+          m_module.opStore(uberVars.result, dst);
+          m_module.opBranch(mergeLabel);
+
+          m_module.opLabel(mergeLabel);
+          return m_module.opLoad(m_vec4Type, uberVars.result);
+        };
+
+        std::array<uint32_t, TextureArgCount> colorArgs;
+        std::array<uint32_t, TextureArgCount> alphaArgs;
+
+        for (uint32_t j = 0; j < TextureArgCount; j++) {
+          colorArgs[j] = GetUberArg(Extract(colorData, j + 1));
+          alphaArgs[j] = GetUberArg(Extract(alphaData, j + 1));
+        }
+
+        uint32_t resultIsTemp = HasBits(Extract(miscData, 0), ~0u);
+        uint32_t dst = SelectVec4(resultIsTemp, temp, current);
+
+        uint32_t colorResult = DoUberOp(colorOp, dst, colorArgs);
+        uint32_t alphaResult = DoUberOp(alphaOp, dst, alphaArgs);
+
+        // D3DTOP_DOTPRODUCT3 also writes the alpha component
+        alphaResult = SelectVec4(IsEqual(colorOp, D3DTOP_DOTPRODUCT3), colorResult, alphaResult);
+
+        std::array<uint32_t, 4> indices = { 0, 1, 2, 4 + 3 };
+        uint32_t result = m_module.opVectorShuffle(m_vec4Type,
+          colorResult, alphaResult, indices.size(), indices.data());
+
+        m_module.opStore(uberVars.temp,    SelectVec4(resultIsTemp, result, temp));
+        m_module.opStore(uberVars.current, SelectVec4(resultIsTemp, current, result));
+
+        m_module.opBranch(skipLabel);
+        m_module.opLabel(skipLabel);
+        continue;
+      }
+
       uint32_t& dst = stage.ResultIsTemp ? temp : current;
 
       D3DTEXTUREOP colorOp = (D3DTEXTUREOP)stage.ColorOp;
@@ -1941,6 +2245,9 @@ namespace dxvk {
       }
     }
 
+    if (uberShader)
+      current = m_module.opLoad(m_vec4Type, uberVars.current);
+
     if (m_fsKey.Stages[0].Contents.GlobalSpecularEnable) {
       uint32_t specular = m_module.opFMul(m_vec4Type, m_ps.in.COLOR[1], m_module.constvec4f32(1.0f, 1.0f, 1.0f, 0.0f));
 
@@ -1951,6 +2258,7 @@ namespace dxvk {
     fogCtx.IsPixel     = true;
     fogCtx.RangeFog    = false;
     fogCtx.RenderState = m_rsBlock;
+    fogCtx.SpecUBO     = m_specUbo;
     fogCtx.vPos        = m_ps.in.POS;
     fogCtx.vFog        = m_ps.in.FOG;
     fogCtx.oColor      = current;
@@ -1958,7 +2266,7 @@ namespace dxvk {
     fogCtx.IsPositionT = false;
     fogCtx.HasSpecular = false;
     fogCtx.Specular    = 0;
-    current = DoFixedFunctionFog(m_module, fogCtx);
+    current = DoFixedFunctionFog(m_spec, m_module, fogCtx);
 
     m_module.opStore(m_ps.out.COLOR, current);
 
@@ -1975,7 +2283,7 @@ namespace dxvk {
       spv::ExecutionModeOriginUpperLeft);
 
     uint32_t pointCoord = GetPointCoord(m_module, m_entryPointInterfaces);
-    auto pointInfo = GetPointSizeInfoPS(m_module, m_rsBlock);
+    auto pointInfo = GetPointSizeInfoPS(m_spec, m_module, m_rsBlock, m_specUbo);
 
     // We need to replace TEXCOORD inputs with gl_PointCoord
     // if D3DRS_POINTSPRITEENABLE is set.
@@ -1993,8 +2301,15 @@ namespace dxvk {
     m_ps.out.COLOR   = declareIO(false, DxsoSemantic{ DxsoUsage::Color, 0 });
 
     // Constant Buffer for PS.
+    // Stage data is stored as three uvec4 per stage
+    const uint32_t stageArrayType = m_module.defArrayTypeUnique(
+      m_module.defVectorType(m_uint32Type, 4),
+      m_module.constu32(3 * caps::TextureStageCount));
+    m_module.decorateArrayStride(stageArrayType, sizeof(Vector4));
+
     std::array<uint32_t, uint32_t(D3D9FFPSMembers::MemberCount)> members = {
-      m_vec4Type // Texture Factor
+      m_vec4Type,    // Texture Factor
+      stageArrayType // Stage Data
     };
 
     const uint32_t structType =
@@ -2010,6 +2325,7 @@ namespace dxvk {
 
     m_module.setDebugName(structType, "D3D9FixedFunctionPS");
     m_module.setDebugMemberName(structType, 0, "textureFactor");
+    m_module.setDebugMemberName(structType, 1, "stages");
 
     m_ps.constantBuffer = m_module.newVar(
       m_module.defPointerType(structType, spv::StorageClassUniform),
@@ -2150,10 +2466,17 @@ namespace dxvk {
     m_module.decorateDescriptorSet(clipPlaneBlock, 0);
     m_module.decorateBinding      (clipPlaneBlock, bindingId);
     
+    // Inline uniform blocks use the same SPIR-V declaration
+    // as uniform buffers, only the descriptor type differs
     DxvkBindingInfo binding = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
     binding.resourceBinding = bindingId;
     binding.viewType        = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
     binding.access          = VK_ACCESS_UNIFORM_READ_BIT;
+    binding.uniformSize     = caps::MaxClipPlanes * 4 * sizeof(float);
+
+    if (m_options.inlineClipPlanes)
+      binding.descriptorType = VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT;
+
     m_bindings.push_back(binding);
 
     // Declare output array for clip distances
@@ -2195,9 +2518,7 @@ namespace dxvk {
     uint32_t floatPtr = m_module.defPointerType(m_floatType, spv::StorageClassPushConstant);
 
     // Declare spec constants for render states
-    uint32_t alphaFuncId = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.setDebugName(alphaFuncId, "alpha_func");
-    m_module.decorateSpecId(alphaFuncId, getSpecId(D3D9SpecConstantId::AlphaCompareOp));
+    uint32_t alphaFuncId = m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::AlphaCompareOp);
 
     // Implement alpha test
     auto oC0 = m_ps.out.COLOR;
@@ -2291,40 +2612,45 @@ namespace dxvk {
 
 
   D3D9FFShader::D3D9FFShader(
-          D3D9DeviceEx*         pDevice,
-    const D3D9FFShaderKeyVS&    Key) {
-    Sha1Hash hash = Sha1Hash::compute(&Key, sizeof(Key));
-    DxvkShaderKey shaderKey = { VK_SHADER_STAGE_VERTEX_BIT, hash };
-
-    std::string name = str::format("FF_", shaderKey.toString());
-
-    D3D9FFShaderCompiler compiler(
-      pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
-
-    m_shader = compiler.compile();
-    m_isgn   = compiler.isgn();
+          D3D9DeviceEx*           pDevice,
+          D3D9FFShaderModuleSet*  pModuleSet,
+    const D3D9FFShaderKeyVS&      Key) {
+    CreateShader(pDevice, pModuleSet, Key, VK_SHADER_STAGE_VERTEX_BIT);
+  }
 
-    Dump(Key, name);
 
-    m_shader->setShaderKey(shaderKey);
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
+  D3D9FFShader::D3D9FFShader(
+          D3D9DeviceEx*           pDevice,
+          D3D9FFShaderModuleSet*  pModuleSet,
+    const D3D9FFShaderKeyFS&      Key) {
+    CreateShader(pDevice, pModuleSet, Key, VK_SHADER_STAGE_FRAGMENT_BIT);
   }
 
 
-  D3D9FFShader::D3D9FFShader(
-          D3D9DeviceEx*         pDevice,
-    const D3D9FFShaderKeyFS&    Key) {
+  template <typename T>
+  void D3D9FFShader::CreateShader(
+          D3D9DeviceEx*           pDevice,
+          D3D9FFShaderModuleSet*  pModuleSet,
+    const T&                      Key,
+          VkShaderStageFlagBits   Stage) {
     Sha1Hash hash = Sha1Hash::compute(&Key, sizeof(Key));
-    DxvkShaderKey shaderKey = { VK_SHADER_STAGE_FRAGMENT_BIT, hash };
+    DxvkShaderKey shaderKey = { Stage, hash };
+
+    // Use the preloaded shader object if there is one, since
+    // the state cache may already have compiled pipelines
+    // for it. It is already registered with the device.
+    m_shader = pModuleSet->TakeCachedShader(shaderKey);
+
+    if (m_shader != nullptr)
+      return;
 
     std::string name = str::format("FF_", shaderKey.toString());
 
+    D3D9FixedFunctionOptions options(pDevice->GetOptions());
+
     D3D9FFShaderCompiler compiler(
       pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
+      Key, name, options);
 
     m_shader = compiler.compile();
     m_isgn   = compiler.isgn();
@@ -2332,6 +2658,8 @@ namespace dxvk {
     Dump(Key, name);
 
     m_shader->setShaderKey(shaderKey);
+
+    pDevice->GetDXVKDevice()->getShaderCache().addShader(m_shader, options.hash());
     pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
 
@@ -2358,7 +2686,7 @@ namespace dxvk {
       return entry->second;
     
     D3D9FFShader shader(
-      pDevice, ShaderKey);
+      pDevice, this, ShaderKey);
 
     m_vsModules.insert({ShaderKey, shader});
 
@@ -2375,7 +2703,7 @@ namespace dxvk {
       return entry->second;
     
     D3D9FFShader shader(
-      pDevice, ShaderKey);
+      pDevice, this, ShaderKey);
 
     m_fsModules.insert({ShaderKey, shader});
 
@@ -2383,6 +2711,111 @@ namespace dxvk {
   }
 
 
+  D3D9FFShader D3D9FFShaderModuleSet::GetShaderModuleAsync(
+          D3D9DeviceEx*         pDevice,
+    const D3D9FFShaderKeyFS&    ShaderKey) {
+    auto entry = m_fsModules.find(ShaderKey);
+    if (entry != m_fsModules.end())
+      return entry->second;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      auto compiled = m_fsCompiled.find(ShaderKey);
+
+      if (compiled != m_fsCompiled.end()) {
+        D3D9FFShader shader = compiled->second;
+        m_fsCompiled.erase(compiled);
+        m_fsModules.insert({ShaderKey, shader});
+        return shader;
+      }
+
+      if (m_fsPending.insert(ShaderKey).second) {
+        pDevice->GetDXVKDevice()->runShaderTask([this, pDevice, cKey = ShaderKey] {
+          D3D9FFShader shader(pDevice, this, cKey);
+
+          std::lock_guard<dxvk::mutex> lock(m_mutex);
+          m_fsPending.erase(cKey);
+          m_fsReady.insert(cKey);
+          m_fsCompiled.insert({cKey, shader});
+          m_cond.notify_all();
+        });
+      }
+    }
+
+    return GetShaderModule(pDevice, ShaderKey.GetUberShaderKey());
+  }
+
+
+  bool D3D9FFShaderModuleSet::IsShaderReady(
+    const D3D9FFShaderKeyFS&    ShaderKey) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_fsReady.find(ShaderKey) != m_fsReady.end();
+  }
+
+
+  void D3D9FFShaderModuleSet::WaitForPendingShaders() {
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_fsPending.empty();
+    });
+  }
+
+
+  void D3D9FFShaderModuleSet::PreloadShaders(
+          D3D9DeviceEx*         pDevice) {
+    Rc<DxvkDevice> device = pDevice->GetDXVKDevice();
+
+    D3D9FixedFunctionOptions options(pDevice->GetOptions());
+
+    auto shaders = device->getShaderCache().findShaders(options.hash());
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (const auto& shader : shaders) {
+      device->registerShader(shader);
+      m_cachedShaders.insert({ shader->getShaderKey(), shader });
+    }
+
+    if (!shaders.empty())
+      Logger::info(str::format("D3D9: Loaded ", shaders.size(), " fixed-function shaders"));
+  }
+
+
+  Rc<DxvkShader> D3D9FFShaderModuleSet::TakeCachedShader(
+    const DxvkShaderKey&        ShaderKey) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    auto entry = m_cachedShaders.find(ShaderKey);
+
+    if (entry == m_cachedShaders.end())
+      return nullptr;
+
+    Rc<DxvkShader> shader = std::move(entry->second);
+    m_cachedShaders.erase(entry);
+    return shader;
+  }
+
+
+  bool D3D9FFShaderKeyFS::SupportsUberShader() const {
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+      if (D3DRESOURCETYPE(Stages[i].Contents.Type + D3DRTYPE_TEXTURE) != D3DRTYPE_TEXTURE)
+        return false;
+    }
+
+    return true;
+  }
+
+
+  D3D9FFShaderKeyFS D3D9FFShaderKeyFS::GetUberShaderKey() const {
+    D3D9FFShaderKeyFS key;
+
+    auto& stage0 = key.Stages[0].Contents;
+    stage0.GlobalSpecularEnable = Stages[0].Contents.GlobalSpecularEnable;
+    stage0.GlobalFlatShade      = Stages[0].Contents.GlobalFlatShade;
+    stage0.UberShader           = true;
+    return key;
+  }
+
+
   size_t D3D9FFShaderKeyHash::operator () (const D3D9FFShaderKeyVS& key) const {
     DxvkHashState state;
 
@@ -3,17 +3,20 @@
 #include "d3d9_include.h"
 
 #include "d3d9_caps.h"
+#include "d3d9_spec_constants.h"
 
 #include "../dxvk/dxvk_shader.h"
 
 #include "../dxso/dxso_isgn.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <bitset>
 
 namespace dxvk {
 
   class D3D9DeviceEx;
+  class D3D9FFShaderModuleSet;
   class SpirvModule;
 
   struct D3D9Options;
@@ -23,6 +26,7 @@ namespace dxvk {
     bool     IsPixel;
     bool     RangeFog;
     uint32_t RenderState;
+    uint32_t SpecUBO;
     uint32_t vPos;
     uint32_t vFog;
 
@@ -39,16 +43,29 @@ namespace dxvk {
   struct D3D9FixedFunctionOptions {
     D3D9FixedFunctionOptions(const D3D9Options* options);
 
+    /**
+     * \brief Computes hash of all options
+     *
+     * Used to look up generated fixed-function
+     * shaders in the shader cache.
+     * \returns Options hash
+     */
+    Sha1Hash hash() const;
+
     bool invariantPosition;
+    bool inlineClipPlanes;
   };
 
   // Returns new oFog if VS
   // Returns new oColor if PS
-  uint32_t DoFixedFunctionFog(SpirvModule& spvModule, const D3D9FogContext& fogCtx);
+  uint32_t DoFixedFunctionFog(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, const D3D9FogContext& fogCtx);
 
   // Returns a render state block
   uint32_t SetupRenderStateBlock(SpirvModule& spvModule, uint32_t count);
 
+  // Returns the spec constant buffer and adds its binding
+  uint32_t SetupSpecUBO(SpirvModule& spvModule, std::vector<DxvkBindingInfo>& bindings);
+
   struct D3D9PointSizeInfoVS {
     uint32_t defaultValue;
     uint32_t min;
@@ -56,13 +73,13 @@ namespace dxvk {
   };
 
   // Default point size and point scale magic!
-  D3D9PointSizeInfoVS GetPointSizeInfoVS(SpirvModule& spvModule, uint32_t vPos, uint32_t vtx, uint32_t perVertPointSize, uint32_t rsBlock, bool isFixedFunction);
+  D3D9PointSizeInfoVS GetPointSizeInfoVS(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, uint32_t vPos, uint32_t vtx, uint32_t perVertPointSize, uint32_t rsBlock, uint32_t specUbo, bool isFixedFunction);
 
   struct D3D9PointSizeInfoPS {
     uint32_t isSprite;
   };
 
-  D3D9PointSizeInfoPS GetPointSizeInfoPS(SpirvModule& spvModule, uint32_t rsBlock);
+  D3D9PointSizeInfoPS GetPointSizeInfoPS(D3D9ShaderSpecConstantManager& spec, SpirvModule& spvModule, uint32_t rsBlock, uint32_t specUbo);
 
   uint32_t GetPointCoord(SpirvModule& spvModule, std::vector<uint32_t>& entryPointInterfaces);
 
@@ -154,6 +171,10 @@ namespace dxvk {
         // Affects all stages.
         uint32_t     GlobalSpecularEnable : 1;
         uint32_t     GlobalFlatShade      : 1;
+
+        // Read from Stage 0. Generates a shader that reads
+        // the stage state from the constant buffer instead.
+        uint32_t     UberShader           : 1;
       } Contents;
 
       uint32_t Primitive[2];
@@ -173,6 +194,23 @@ namespace dxvk {
     }
 
     D3D9FFShaderStage Stages[caps::TextureStageCount];
+
+    /**
+     * \brief Checks whether the uber shader can be used
+     *
+     * The uber shader only supports 2D textures, since
+     * the sampler types are not known in advance.
+     * \returns \c true if all stages use 2D textures
+     */
+    bool SupportsUberShader() const;
+
+    /**
+     * \brief Computes uber shader key
+     *
+     * Only keeps the global state from the first stage.
+     * \returns Key of the corresponding uber shader
+     */
+    D3D9FFShaderKeyFS GetUberShaderKey() const;
   };
 
   struct D3D9FFShaderKeyHash {
@@ -195,12 +233,14 @@ namespace dxvk {
   public:
 
     D3D9FFShader(
-            D3D9DeviceEx*         pDevice,
-      const D3D9FFShaderKeyVS&    Key);
+            D3D9DeviceEx*           pDevice,
+            D3D9FFShaderModuleSet*  pModuleSet,
+      const D3D9FFShaderKeyVS&      Key);
 
     D3D9FFShader(
-            D3D9DeviceEx*         pDevice,
-      const D3D9FFShaderKeyFS&    Key);
+            D3D9DeviceEx*           pDevice,
+            D3D9FFShaderModuleSet*  pModuleSet,
+      const D3D9FFShaderKeyFS&      Key);
 
     template <typename T>
     void Dump(const T& Key, const std::string& Name);
@@ -215,6 +255,13 @@ namespace dxvk {
 
     DxsoIsgn       m_isgn;
 
+    template <typename T>
+    void CreateShader(
+            D3D9DeviceEx*           pDevice,
+            D3D9FFShaderModuleSet*  pModuleSet,
+      const T&                      Key,
+            VkShaderStageFlagBits   Stage);
+
   };
 
 
@@ -230,8 +277,82 @@ namespace dxvk {
             D3D9DeviceEx*         pDevice,
       const D3D9FFShaderKeyFS&    ShaderKey);
 
+    /**
+     * \brief Retrieves a pixel shader without blocking
+     *
+     * If the specialized shader is not available yet, it
+     * gets compiled on a worker thread and the uber shader
+     * is returned instead. Must only be used with keys
+     * that support the uber shader.
+     * \param [in] pDevice The device
+     * \param [in] ShaderKey Shader key
+     * \returns The specialized shader or the uber shader
+     */
+    D3D9FFShader GetShaderModuleAsync(
+            D3D9DeviceEx*         pDevice,
+      const D3D9FFShaderKeyFS&    ShaderKey);
+
+    /**
+     * \brief Checks whether a specialized shader is ready
+     *
+     * Can be called from any thread.
+     * \param [in] ShaderKey Shader key
+     * \returns \c true if background compilation has finished
+     */
+    bool IsShaderReady(
+      const D3D9FFShaderKeyFS&    ShaderKey);
+
+    /**
+     * \brief Waits for background compilation
+     *
+     * Must be called before the device gets destroyed.
+     */
+    void WaitForPendingShaders();
+
+    /**
+     * \brief Loads cached fixed-function shaders
+     *
+     * Registers all fixed-function shaders generated in
+     * previous runs with the device, so that the state
+     * cache can compile pipelines for them before they
+     * are first used.
+     * \param [in] pDevice The device
+     */
+    void PreloadShaders(
+            D3D9DeviceEx*         pDevice);
+
+    /**
+     * \brief Retrieves a preloaded shader
+     *
+     * \param [in] ShaderKey Shader key
+     * \returns The shader, or \c nullptr if it was not preloaded
+     */
+    Rc<DxvkShader> TakeCachedShader(
+      const DxvkShaderKey&        ShaderKey);
+
   private:
 
+    dxvk::mutex                 m_mutex;
+    dxvk::condition_variable    m_cond;
+
+    std::unordered_map<
+      DxvkShaderKey,
+      Rc<DxvkShader>,
+      DxvkHash, DxvkEq> m_cachedShaders;
+
+    std::unordered_map<
+      D3D9FFShaderKeyFS,
+      D3D9FFShader,
+      D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsCompiled;
+
+    std::unordered_set<
+      D3D9FFShaderKeyFS,
+      D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsPending;
+
+    std::unordered_set<
+      D3D9FFShaderKeyFS,
+      D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsReady;
+
     std::unordered_map<
       D3D9FFShaderKeyVS,
       D3D9FFShader,
@@ -3,7 +3,7 @@
 namespace dxvk {
 
   // It is also worth noting that the msb/lsb-ness is flipped between VK and D3D9.
-  D3D9_VK_FORMAT_MAPPING ConvertFormatUnfixed(D3D9Format Format) {
+  static D3D9_VK_FORMAT_MAPPING ConvertFormatUnfixedImpl(D3D9Format Format, bool WarnUnknown) {
     switch (Format) {
       case D3D9Format::Unknown: return {};
 
@@ -43,7 +43,16 @@ namespace dxvk {
         VK_FORMAT_UNDEFINED,
         VK_IMAGE_ASPECT_COLOR_BIT };
 
-      case D3D9Format::R3G3B2: return {}; // Unsupported
+      case D3D9Format::R3G3B2: return {
+        // Any 8-bit format will do...
+        VK_FORMAT_R8_UNORM,
+        VK_FORMAT_UNDEFINED,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G,
+          VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_ONE },
+        { D3D9ConversionFormat_R3G3B2, 1u,
+        // No Vulkan format has 3-bit channels, so expand
+          VK_FORMAT_R8G8B8A8_UNORM } };
 
       case D3D9Format::A8: return {
         VK_FORMAT_R8_UNORM,
@@ -52,7 +61,16 @@ namespace dxvk {
         { VK_COMPONENT_SWIZZLE_ZERO, VK_COMPONENT_SWIZZLE_ZERO,
           VK_COMPONENT_SWIZZLE_ZERO, VK_COMPONENT_SWIZZLE_R }};
 
-      case D3D9Format::A8R3G3B2: return {}; // Unsupported
+      case D3D9Format::A8R3G3B2: return {
+        // Any 16-bit format will do...
+        VK_FORMAT_R8G8_UNORM,
+        VK_FORMAT_UNDEFINED,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G,
+          VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A },
+        { D3D9ConversionFormat_A8R3G3B2, 1u,
+        // No Vulkan format has 3-bit channels, so expand
+          VK_FORMAT_R8G8B8A8_UNORM } };
 
       case D3D9Format::X4R4G4B4: return {
         VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT,
@@ -420,11 +438,16 @@ namespace dxvk {
       case D3D9Format::RAWZ: return {}; // Unsupported
 
       default:
-        Logger::warn(str::format("ConvertFormat: Unknown format encountered: ", Format));
+        if (WarnUnknown)
+          Logger::warn(str::format("ConvertFormat: Unknown format encountered: ", Format));
         return {}; // Unsupported
     }
   }
 
+  D3D9_VK_FORMAT_MAPPING ConvertFormatUnfixed(D3D9Format Format) {
+    return ConvertFormatUnfixedImpl(Format, true);
+  }
+
   D3D9VkFormatTable::D3D9VkFormatTable(
     const Rc<DxvkAdapter>& adapter,
     const D3D9Options&     options) {
@@ -448,6 +471,12 @@ namespace dxvk {
     m_a4r4g4b4Support = CheckImageFormatSupport(adapter, VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT,
       VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 
+    // Some mobile and integrated GPUs lack BC support
+    // entirely, we decode those formats during upload
+    m_bcSupport = adapter->features().core.features.textureCompressionBC
+      && CheckImageFormatSupport(adapter, VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
     if (!m_d24s8Support)
       Logger::info("D3D9: VK_FORMAT_D24_UNORM_S8_UINT -> VK_FORMAT_D32_SFLOAT_S8_UINT");
 
@@ -460,12 +489,33 @@ namespace dxvk {
 
     if (!m_a4r4g4b4Support)
       Logger::warn("D3D9: VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT -> VK_FORMAT_B4G4R4A4_UNORM_PACK16");
+
+    if (!m_bcSupport)
+      Logger::warn("D3D9: BC formats not supported, decoding to VK_FORMAT_R8G8B8A8_UNORM");
+
+    // Resolve all formats with small enum values up front, so
+    // that looking them up later doesn't go through the switch
+    for (uint32_t i = 0; i < m_mappings.size(); i++) {
+      D3D9Format format = D3D9Format(i);
+      m_mappings[i] = ComputeFormatMapping(format,
+        ConvertFormatUnfixedImpl(format, false));
+    }
   }
 
   D3D9_VK_FORMAT_MAPPING D3D9VkFormatTable::GetFormatMapping(
           D3D9Format          Format) const {
-    D3D9_VK_FORMAT_MAPPING mapping = ConvertFormatUnfixed(Format);
+    uint32_t formatId = uint32_t(Format);
 
+    if (likely(formatId < m_mappings.size()))
+      return m_mappings[formatId];
+
+    return ComputeFormatMapping(Format,
+      ConvertFormatUnfixedImpl(Format, true));
+  }
+
+  D3D9_VK_FORMAT_MAPPING D3D9VkFormatTable::ComputeFormatMapping(
+          D3D9Format          Format,
+          D3D9_VK_FORMAT_MAPPING mapping) const {
     if (Format == D3D9Format::X4R4G4B4 && !m_x4r4g4b4Support)
       return D3D9_VK_FORMAT_MAPPING();
 
@@ -495,6 +545,30 @@ namespace dxvk {
         VK_COMPONENT_SWIZZLE_A, alphaSwizzle };
     }
 
+    if (!m_bcSupport) {
+      // Keep the BC format so that mapping buffers retain their
+      // compressed layout, but store the decoded data as RGBA8.
+      D3D9ConversionFormat conversion = D3D9ConversionFormat_None;
+
+      switch (mapping.FormatColor) {
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: conversion = D3D9ConversionFormat_BC1; break;
+        case VK_FORMAT_BC2_UNORM_BLOCK:      conversion = D3D9ConversionFormat_BC2; break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:      conversion = D3D9ConversionFormat_BC3; break;
+        case VK_FORMAT_BC4_UNORM_BLOCK:      conversion = D3D9ConversionFormat_BC4; break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:      conversion = D3D9ConversionFormat_BC5; break;
+        default: break;
+      }
+
+      if (conversion != D3D9ConversionFormat_None) {
+        mapping.ConversionFormatInfo.FormatType  = conversion;
+        mapping.ConversionFormatInfo.PlaneCount  = 1;
+        mapping.ConversionFormatInfo.FormatColor = VK_FORMAT_R8G8B8A8_UNORM;
+        mapping.ConversionFormatInfo.FormatSrgb  = mapping.FormatSrgb != VK_FORMAT_UNDEFINED
+          ? VK_FORMAT_R8G8B8A8_SRGB
+          : VK_FORMAT_UNDEFINED;
+      }
+    }
+
     return mapping;
   }
 
@@ -136,6 +136,13 @@ namespace dxvk {
     D3D9ConversionFormat_A2W10V10U10,
     D3D9ConversionFormat_NV12,
     D3D9ConversionFormat_YV12,
+    D3D9ConversionFormat_R3G3B2,
+    D3D9ConversionFormat_A8R3G3B2,
+    D3D9ConversionFormat_BC1,
+    D3D9ConversionFormat_BC2,
+    D3D9ConversionFormat_BC3,
+    D3D9ConversionFormat_BC4,
+    D3D9ConversionFormat_BC5,
     D3D9ConversionFormat_Count
   };
 
@@ -178,7 +185,9 @@ namespace dxvk {
    * formats.
    */
   class D3D9VkFormatTable {
-
+    /// Formats with an enum value below this are
+    /// resolved once and looked up from a table
+    constexpr static uint32_t FormatTableSize = uint32_t(D3D9Format::A2B10G10R10_XR_BIAS) + 1;
   public:
 
     D3D9VkFormatTable(
@@ -206,18 +215,25 @@ namespace dxvk {
 
   private:
 
+    D3D9_VK_FORMAT_MAPPING ComputeFormatMapping(
+            D3D9Format              Format,
+            D3D9_VK_FORMAT_MAPPING  mapping) const;
+
     bool CheckImageFormatSupport(
       const Rc<DxvkAdapter>&      Adapter,
       VkFormat              Format,
       VkFormatFeatureFlags  Features) const;
 
     bool m_a4r4g4b4Support;
+    bool m_bcSupport;
     bool m_d24s8Support;
     bool m_d16s8Support;
 
     bool m_dfSupport;
     bool m_x4r4g4b4Support;
     bool m_d32supportFinal;
+
+    std::array<D3D9_VK_FORMAT_MAPPING, FormatTableSize> m_mappings;
   };
 
 }
@@ -6,6 +6,8 @@
 #include <d3d9_convert_a2w10v10u10.h>
 #include <d3d9_convert_nv12.h>
 #include <d3d9_convert_yv12.h>
+#include <d3d9_convert_r3g3b2.h>
+#include <d3d9_convert_bc.h>
 
 namespace dxvk {
 
@@ -57,6 +59,36 @@ namespace dxvk {
         ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32_UINT, 0, { 1u, 1u });
         break;
 
+      case D3D9ConversionFormat_R3G3B2:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R8_UINT, 0, { 1u, 1u });
+        break;
+
+      case D3D9ConversionFormat_A8R3G3B2:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R16_UINT, 1, { 1u, 1u });
+        break;
+
+      // The spec constant selects the block format, each
+      // invocation decodes one pixel from its 4x4 block
+      case D3D9ConversionFormat_BC1:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32G32_UINT, 1, { 1u, 1u });
+        break;
+
+      case D3D9ConversionFormat_BC2:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32G32B32A32_UINT, 2, { 1u, 1u });
+        break;
+
+      case D3D9ConversionFormat_BC3:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32G32B32A32_UINT, 3, { 1u, 1u });
+        break;
+
+      case D3D9ConversionFormat_BC4:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32G32_UINT, 4, { 1u, 1u });
+        break;
+
+      case D3D9ConversionFormat_BC5:
+        ConvertGenericFormat(conversionFormat, dstImage, dstSubresource, srcSlice, VK_FORMAT_R32G32B32A32_UINT, 5, { 1u, 1u });
+        break;
+
       default:
         Logger::warn("Unimplemented format conversion");
     }
@@ -101,8 +133,8 @@ namespace dxvk {
     m_context->bindShader(VK_SHADER_STAGE_COMPUTE_BIT, m_shaders[videoFormat.FormatType]);
     m_context->pushConstants(0, sizeof(VkExtent2D), &imageExtent);
     m_context->dispatch(
-      (imageExtent.width  / 8) + (imageExtent.width  % 8),
-      (imageExtent.height / 8) + (imageExtent.height % 8),
+      (imageExtent.width  + 7) / 8,
+      (imageExtent.height + 7) / 8,
       1);
 
     // Reset the spec constants used...
@@ -121,6 +153,13 @@ namespace dxvk {
     m_shaders[D3D9ConversionFormat_A2W10V10U10] = InitShader(d3d9_convert_a2w10v10u10);
     m_shaders[D3D9ConversionFormat_NV12] = InitShader(d3d9_convert_nv12);
     m_shaders[D3D9ConversionFormat_YV12] = InitShader(d3d9_convert_yv12);
+    m_shaders[D3D9ConversionFormat_R3G3B2] = InitShader(d3d9_convert_r3g3b2);
+    m_shaders[D3D9ConversionFormat_A8R3G3B2] = m_shaders[D3D9ConversionFormat_R3G3B2];
+    m_shaders[D3D9ConversionFormat_BC1] = InitShader(d3d9_convert_bc);
+    m_shaders[D3D9ConversionFormat_BC2] = m_shaders[D3D9ConversionFormat_BC1];
+    m_shaders[D3D9ConversionFormat_BC3] = m_shaders[D3D9ConversionFormat_BC1];
+    m_shaders[D3D9ConversionFormat_BC4] = m_shaders[D3D9ConversionFormat_BC1];
+    m_shaders[D3D9ConversionFormat_BC5] = m_shaders[D3D9ConversionFormat_BC1];
   }
 
 
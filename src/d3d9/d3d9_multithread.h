@@ -2,6 +2,8 @@
 
 #include "d3d9_include.h"
 
+#include "../util/sync/sync_seqlock.h"
+
 namespace dxvk {
 
   /**
@@ -66,11 +68,48 @@ namespace dxvk {
         : D3D9DeviceLock();
     }
 
+    /**
+     * \brief Reads state without taking the lock
+     *
+     * Used by simple getters so that worker threads
+     * querying state do not contend with the thread
+     * that is submitting draws. Only state that is
+     * modified inside \ref BeginStateWrite and
+     * \ref EndStateWrite may be read this way.
+     * \param [in] fn Function that copies the state
+     */
+    template<typename Fn>
+    void ReadState(const Fn& fn) const {
+      if (m_protected)
+        m_stateSeq.read(fn);
+      else
+        fn();
+    }
+
+    /**
+     * \brief Begins modifying lock-free state
+     *
+     * Must be called with the lock held.
+     */
+    void BeginStateWrite() {
+      if (m_protected)
+        m_stateSeq.beginWrite();
+    }
+
+    /**
+     * \brief Ends modifying lock-free state
+     */
+    void EndStateWrite() {
+      if (m_protected)
+        m_stateSeq.endWrite();
+    }
+
   private:
 
     BOOL            m_protected;
 
     sync::RecursiveSpinlock m_mutex;
+    sync::SeqLock           m_stateSeq;
 
   };
 
@@ -2,6 +2,8 @@
 
 #include "d3d9_caps.h"
 
+#include "../util/util_env.h"
+
 namespace dxvk {
 
   static int32_t parsePciId(const std::string& str) {
@@ -41,6 +43,8 @@ namespace dxvk {
 
     this->maxFrameLatency               = config.getOption<int32_t>     ("d3d9.maxFrameLatency",               0);
     this->maxFrameRate                  = config.getOption<int32_t>     ("d3d9.maxFrameRate",                  0);
+    this->lowLatencyMode                = config.getOption<bool>        ("d3d9.lowLatencyMode",                false);
+    this->alignFrameRateToVblank        = config.getOption<bool>        ("d3d9.alignFrameRateToVblank",        false);
     this->presentInterval               = config.getOption<int32_t>     ("d3d9.presentInterval",               -1);
     this->shaderModel                   = config.getOption<int32_t>     ("d3d9.shaderModel",                   3);
     this->evictManagedOnUnlock          = config.getOption<bool>        ("d3d9.evictManagedOnUnlock",          false);
@@ -53,6 +57,8 @@ namespace dxvk {
     this->deferSurfaceCreation          = config.getOption<bool>        ("d3d9.deferSurfaceCreation",          false);
     this->samplerAnisotropy             = config.getOption<int32_t>     ("d3d9.samplerAnisotropy",             -1);
     this->maxAvailableMemory            = config.getOption<int32_t>     ("d3d9.maxAvailableMemory",            4096);
+    this->textureMemory                 = config.getOption<int32_t>     ("d3d9.textureMemory",                 env::is32BitHostPlatform() ? 256 : 0);
+    this->managedTextureUnmapAge        = config.getOption<int32_t>     ("d3d9.managedTextureUnmapAge",        env::is32BitHostPlatform() ? 600 : 0);
     this->supportDFFormats              = config.getOption<bool>        ("d3d9.supportDFFormats",              true);
     this->supportX4R4G4B4               = config.getOption<bool>        ("d3d9.supportX4R4G4B4",               true);
     this->supportD32                    = config.getOption<bool>        ("d3d9.supportD32",                    true);
@@ -63,6 +69,7 @@ namespace dxvk {
     this->enableDialogMode              = config.getOption<bool>        ("d3d9.enableDialogMode",              false);
     this->forceSamplerTypeSpecConstants = config.getOption<bool>        ("d3d9.forceSamplerTypeSpecConstants", false);
     this->forceSwapchainMSAA            = config.getOption<int32_t>     ("d3d9.forceSwapchainMSAA",            -1);
+    this->renderScale                   = std::clamp(config.getOption<int32_t>("d3d9.renderScale", 100), 25, 100);
     this->forceAspectRatio              = config.getOption<std::string> ("d3d9.forceAspectRatio",              "");
     this->allowDoNotWait                = config.getOption<bool>        ("d3d9.allowDoNotWait",                true);
     this->allowDiscard                  = config.getOption<bool>        ("d3d9.allowDiscard",                  true);
@@ -74,6 +81,8 @@ namespace dxvk {
     this->deviceLocalConstantBuffers    = config.getOption<bool>        ("d3d9.deviceLocalConstantBuffers",    false);
     this->allowDirectBufferMapping      = config.getOption<bool>        ("d3d9.allowDirectBufferMapping",      true);
     this->seamlessCubes                 = config.getOption<bool>        ("d3d9.seamlessCubes",                 false);
+    this->ffUberShader                  = config.getOption<bool>        ("d3d9.ffUberShader",                  false);
+    this->coalesceQueryFlushes          = config.getOption<bool>        ("d3d9.coalesceQueryFlushes",          false);
 
     // If we are not Nvidia, enable general hazards.
     this->generalHazards = adapter != nullptr
@@ -83,6 +92,9 @@ namespace dxvk {
                             0, 0);
     applyTristate(this->generalHazards, config.getOption<Tristate>("d3d9.generalHazards", Tristate::Auto));
 
+    this->inlineClipPlanes = device != nullptr
+                          && device->canUseInlineUniformBlocks();
+
     std::string floatEmulation = Config::toLower(config.getOption<std::string>("d3d9.floatEmulation", "auto"));
     if (floatEmulation == "strict") {
       d3d9FloatEmulation = D3D9FloatEmulation::Strict;
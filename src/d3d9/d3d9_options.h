@@ -33,6 +33,13 @@ namespace dxvk {
     /// Limit frame rate
     int32_t maxFrameRate;
 
+    /// Align frame rate limiter to measured vblanks
+    bool alignFrameRateToVblank;
+
+    /// Delay frame start based on measured GPU
+    /// completion in order to reduce input latency
+    bool lowLatencyMode;
+
     /// Set the max shader model the device can support in the caps.
     int32_t shaderModel;
 
@@ -86,6 +93,18 @@ namespace dxvk {
     /// tracking and GetAvailableTextureMem
     uint32_t maxAvailableMemory;
 
+    /// Mapped texture memory limit, in MiB
+    ///
+    /// Releases the mapping buffers of textures that have not
+    /// been locked in a while once their total size exceeds
+    /// this limit. Saves address space in 32-bit processes.
+    int32_t textureMemory;
+
+    /// Releases the mapping buffers of managed textures that have
+    /// not been locked for this many frames, regardless of the
+    /// memory limit. Most managed textures are only written once.
+    int32_t managedTextureUnmapAge;
+
     /// D3D9 Floating Point Emulation (anything * 0 = 0)
     D3D9FloatEmulation d3d9FloatEmulation;
 
@@ -127,6 +146,10 @@ namespace dxvk {
     /// Forces an MSAA level on the swapchain
     int32_t forceSwapchainMSAA;
 
+    /// Implicitly sized windowed back buffers are
+    /// created at this percentage of the window size
+    int32_t renderScale;
+
     /// Allow D3DLOCK_DONOTWAIT
     bool allowDoNotWait;
 
@@ -160,6 +183,19 @@ namespace dxvk {
 
     /// Don't use non seamless cube maps
     bool seamlessCubes;
+
+    /// Use a generic fixed-function pixel shader while
+    /// the specialized one is compiled in the background
+    bool ffUberShader;
+
+    /// Submit at most once per frame for queries
+    /// polled with D3DGETDATA_FLUSH while the GPU
+    /// is busy
+    bool coalesceQueryFlushes;
+
+    /// Pass user clip planes to shaders as an inline
+    /// uniform block rather than a uniform buffer
+    bool inlineClipPlanes;
   };
 
 }
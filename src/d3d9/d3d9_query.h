@@ -59,8 +59,9 @@ namespace dxvk {
       return m_stallFlag;
     }
 
-    void NotifyEnd() {
+    void NotifyEnd(uint64_t SequenceNumber) {
       m_stallMask <<= 1;
+      m_endSeqNum = SequenceNumber;
     }
 
     void NotifyStall() {
@@ -80,6 +81,8 @@ namespace dxvk {
     uint32_t m_stallMask = 0;
     bool     m_stallFlag = false;
 
+    uint64_t m_endSeqNum = 0ull;
+
     std::atomic<uint32_t> m_resetCtr = { 0u };
 
     D3D9_QUERY_DATA m_dataCache;
@@ -5,6 +5,7 @@
 #include "d3d9_util.h"
 
 #include "../dxvk/dxvk_hash.h"
+#include "../dxvk/dxvk_sampler.h"
 
 #include "../util/util_math.h"
 
@@ -32,6 +33,18 @@ namespace dxvk {
     bool operator () (const D3D9SamplerKey& a, const D3D9SamplerKey& b) const;
   };
 
+  /**
+   * \brief Sampler bound to a sampler slot
+   *
+   * Stores the last key bound to a slot along with the
+   * sampler, so that binding the same state again does
+   * not require a look-up in the device's sampler pool.
+   */
+  struct D3D9SamplerSlot {
+    D3D9SamplerKey  key     = { };
+    Rc<DxvkSampler> sampler = nullptr;
+  };
+
   inline void NormalizeSamplerKey(D3D9SamplerKey& key) {
     key.AddressU = std::clamp(key.AddressU, D3DTADDRESS_WRAP, D3DTADDRESS_MIRRORONCE);
     key.AddressV = std::clamp(key.AddressV, D3DTADDRESS_WRAP, D3DTADDRESS_MIRRORONCE);
@@ -72,6 +72,7 @@ namespace dxvk {
     m_meta      = pModule->meta();
     m_constants = pModule->constants();
     m_maxDefinedConst = pModule->maxDefinedConstant();
+    m_packedConstsF   = pModule->packedConstantsF();
 
     m_shaders[0]->setShaderKey(Key);
 
@@ -119,13 +120,11 @@ namespace dxvk {
       Sha1Hash::compute(pShaderBytecode, info.bytecodeByteLength));
 
     // Use the shader's unique key for the lookup
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      
-      auto entry = m_modules.find(lookupKey);
-      if (entry != m_modules.end()) {
-        *pShaderModule = entry->second;
-        return;
-      }
+    auto entry = m_modules.find(lookupKey);
+
+    if (entry) {
+      *pShaderModule = *entry;
+      return;
     }
     
     // This shader has not been compiled yet, so we have to create a
@@ -138,14 +137,10 @@ namespace dxvk {
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      
-      auto status = m_modules.insert({ lookupKey, *pShaderModule });
-      if (!status.second) {
-        *pShaderModule = status.first->second;
-        return;
-      }
-    }
+    auto status = m_modules.emplace(lookupKey, *pShaderModule);
+
+    if (!status.second)
+      *pShaderModule = *status.first;
   }
 
 }
@@ -4,6 +4,7 @@
 #include "../dxso/dxso_module.h"
 #include "d3d9_shader_permutations.h"
 #include "d3d9_util.h"
+#include "../util/sync/sync_hashmap.h"
 
 #include <array>
 
@@ -58,6 +59,8 @@ namespace dxvk {
 
     uint32_t GetMaxDefinedConstant() const { return m_maxDefinedConst; }
 
+    const DxsoPackedConstants& GetPackedConstantsF() const { return m_packedConstsF; }
+
   private:
 
     DxsoIsgn              m_isgn;
@@ -68,6 +71,7 @@ namespace dxvk {
     DxsoShaderMetaInfo    m_meta;
     DxsoDefinedConstants  m_constants;
     uint32_t              m_maxDefinedConst;
+    DxsoPackedConstants   m_packedConstsF;
 
     DxsoPermutations      m_shaders;
 
@@ -182,9 +186,7 @@ namespace dxvk {
     
   private:
     
-    dxvk::mutex m_mutex;
-    
-    std::unordered_map<
+    sync::HashMap<
       DxvkShaderKey,
       D3D9CommonShader,
       DxvkHash, DxvkEq> m_modules;
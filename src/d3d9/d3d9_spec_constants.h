@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 
+#include "../dxvk/dxvk_spec_const.h"
+
+#include "../spirv/spirv_module.h"
+
 namespace dxvk {
 
   enum D3D9SpecConstantId : uint32_t {
@@ -20,6 +25,92 @@ namespace dxvk {
 
     SamplerDepthMode  = 10,
     SamplerNull       = 11,
+
+    SpecConstantCount = 12,
+  };
+
+
+  /**
+   * \brief Spec constant values
+   *
+   * Mirrors the current value of each spec constant.
+   * Stored in the spec constant buffer so that shaders
+   * can read the values in unspecialized pipelines.
+   */
+  struct D3D9SpecializationInfo {
+    std::array<uint32_t, SpecConstantCount> data = { };
+  };
+
+
+  /**
+   * \brief Spec constant manager
+   *
+   * Declares each spec constant at most once per shader module.
+   * Pipelines compiled without specialization, such as the ones
+   * linked from pipeline libraries, read the value from the spec
+   * constant buffer instead, so that they can be used for any
+   * combination of spec constant values.
+   */
+  class D3D9ShaderSpecConstantManager {
+
+  public:
+
+    /**
+     * \brief Emits code to read a spec constant
+     *
+     * \param [in] module SPIR-V module
+     * \param [in] specUbo Spec constant buffer variable
+     * \param [in] id Spec constant ID
+     * \returns 32-bit unsigned integer value
+     */
+    uint32_t get(SpirvModule& module, uint32_t specUbo, D3D9SpecConstantId id) {
+      uint32_t uintType = module.defIntType(32, 0);
+      uint32_t memberId = module.constu32(uint32_t(id));
+
+      uint32_t uboValue = module.opLoad(uintType, module.opAccessChain(
+        module.defPointerType(uintType, spv::StorageClassUniform),
+        specUbo, 1, &memberId));
+
+      return module.opSelect(uintType, getOptimized(module),
+        getSpecConstant(module, id), uboValue);
+    }
+
+    /**
+     * \brief Declares the spec constant fallback
+     *
+     * Marks the shader as compatible with unspecialized
+     * pipelines even if it does not read any spec constants.
+     * \param [in] module SPIR-V module
+     */
+    void declareFallback(SpirvModule& module) {
+      getOptimized(module);
+    }
+
+  private:
+
+    uint32_t m_optimized = 0;
+
+    std::array<uint32_t, SpecConstantCount> m_specConstants = { };
+
+    uint32_t getOptimized(SpirvModule& module) {
+      if (!m_optimized) {
+        m_optimized = module.specConstBool(false);
+        module.decorateSpecId(m_optimized, uint32_t(DxvkSpecConstantId::SpecConstantsOptimized));
+        module.setDebugName(m_optimized, "spec_optimized");
+      }
+
+      return m_optimized;
+    }
+
+    uint32_t getSpecConstant(SpirvModule& module, D3D9SpecConstantId id) {
+      if (!m_specConstants[id]) {
+        m_specConstants[id] = module.specConst32(module.defIntType(32, 0), 0);
+        module.decorateSpecId(m_specConstants[id], getSpecId(id));
+      }
+
+      return m_specConstants[id];
+    }
+
   };
 
-}
\ No newline at end of file
+}
@@ -137,8 +137,22 @@ namespace dxvk {
   };
 
 
+  struct D3D9FixedFunctionPSStage {
+    uint32_t colorOp;
+    uint32_t colorArgs[3];
+    uint32_t alphaOp;
+    uint32_t alphaArgs[3];
+    uint32_t resultIsTemp;
+    uint32_t projected;
+    uint32_t projectedCount;
+    uint32_t reserved;
+  };
+
+
   struct D3D9FixedFunctionPS {
     Vector4 textureFactor;
+    // Only read by the fixed-function uber shader
+    D3D9FixedFunctionPSStage stages[caps::TextureStageCount];
   };
 
   enum D3D9SharedPSStages {
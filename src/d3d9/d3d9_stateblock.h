@@ -253,47 +253,31 @@ namespace dxvk {
       }
 
       if (m_captures.flags.test(D3D9CapturedStateFlag::VsConstants)) {
-        for (uint32_t i = 0; i < m_captures.vsConsts.fConsts.dwordCount(); i++) {
-          for (uint32_t consts : bit::BitMask(m_captures.vsConsts.fConsts.dword(i))) {
-            uint32_t idx = i * 32 + consts;
+        ForEachRange(m_captures.vsConsts.fConsts, [&] (uint32_t idx, uint32_t count) {
+          dst->SetVertexShaderConstantF(idx, (float*)&src->vsConsts.fConsts[idx], count);
+        });
 
-            dst->SetVertexShaderConstantF(idx, (float*)&src->vsConsts.fConsts[idx], 1);
-          }
-        }
-
-        for (uint32_t i = 0; i < m_captures.vsConsts.iConsts.dwordCount(); i++) {
-          for (uint32_t consts : bit::BitMask(m_captures.vsConsts.iConsts.dword(i))) {
-            uint32_t idx = i * 32 + consts;
+        ForEachRange(m_captures.vsConsts.iConsts, [&] (uint32_t idx, uint32_t count) {
+          dst->SetVertexShaderConstantI(idx, (int*)&src->vsConsts.iConsts[idx], count);
+        });
 
-            dst->SetVertexShaderConstantI(idx, (int*)&src->vsConsts.iConsts[idx], 1);
-          }
-        }
-
-        if (m_captures.vsConsts.bConsts.any()) {
-          for (uint32_t i = 0; i < m_captures.vsConsts.bConsts.dwordCount(); i++)
+        for (uint32_t i = 0; i < m_captures.vsConsts.bConsts.dwordCount(); i++) {
+          if (m_captures.vsConsts.bConsts.dword(i))
             dst->SetVertexBoolBitfield(i, m_captures.vsConsts.bConsts.dword(i), src->vsConsts.bConsts[i]);
         }
       }
 
       if (m_captures.flags.test(D3D9CapturedStateFlag::PsConstants)) {
-        for (uint32_t i = 0; i < m_captures.psConsts.fConsts.dwordCount(); i++) {
-          for (uint32_t consts : bit::BitMask(m_captures.psConsts.fConsts.dword(i))) {
-            uint32_t idx = i * 32 + consts;
-
-            dst->SetPixelShaderConstantF(idx, (float*)&src->psConsts.fConsts[idx], 1);
-          }
-        }
+        ForEachRange(m_captures.psConsts.fConsts, [&] (uint32_t idx, uint32_t count) {
+          dst->SetPixelShaderConstantF(idx, (float*)&src->psConsts.fConsts[idx], count);
+        });
 
-        for (uint32_t i = 0; i < m_captures.psConsts.iConsts.dwordCount(); i++) {
-          for (uint32_t consts : bit::BitMask(m_captures.psConsts.iConsts.dword(i))) {
-            uint32_t idx = i * 32 + consts;
+        ForEachRange(m_captures.psConsts.iConsts, [&] (uint32_t idx, uint32_t count) {
+          dst->SetPixelShaderConstantI(idx, (int*)&src->psConsts.iConsts[idx], count);
+        });
 
-            dst->SetPixelShaderConstantI(idx, (int*)&src->psConsts.iConsts[idx], 1);
-          }
-        }
-
-        if (m_captures.psConsts.bConsts.any()) {
-          for (uint32_t i = 0; i < m_captures.psConsts.bConsts.dwordCount(); i++)
+        for (uint32_t i = 0; i < m_captures.psConsts.bConsts.dwordCount(); i++) {
+          if (m_captures.psConsts.bConsts.dword(i))
             dst->SetPixelBoolBitfield(i, m_captures.psConsts.bConsts.dword(i), src->psConsts.bConsts[i]);
         }
       }
@@ -358,6 +342,45 @@ namespace dxvk {
 
   private:
 
+    /**
+     * \brief Iterates over contiguous ranges of set bits
+     *
+     * Lets constants be applied with one call per register range
+     * rather than one call per register, since each call into
+     * the device has to take the lock and validate the range.
+     * \param [in] mask Bit mask
+     * \param [in] fn Callback taking the first index and count
+     */
+    template <size_t Bits, typename Fn>
+    static void ForEachRange(const bit::bitset<Bits>& mask, const Fn& fn) {
+      uint32_t start = 0;
+      uint32_t count = 0;
+
+      for (uint32_t i = 0; i < mask.dwordCount(); i++) {
+        uint32_t dword = mask.dword(i);
+
+        if (!dword)
+          continue;
+
+        for (uint32_t bit : bit::BitMask(dword)) {
+          uint32_t idx = i * 32 + bit;
+
+          if (count && start + count == idx) {
+            count += 1;
+          } else {
+            if (count)
+              fn(start, count);
+
+            start = idx;
+            count = 1;
+          }
+        }
+      }
+
+      if (count)
+        fn(start, count);
+    }
+
     void CapturePixelRenderStates();
     void CapturePixelSamplerStates();
     void CapturePixelShaderStates();
@@ -132,6 +132,8 @@ namespace dxvk {
 
     if (message == WM_DESTROY)
       ResetWindowProc(window);
+    else if (message == WM_DISPLAYCHANGE)
+      InvalidateMonitorDisplayModes();
     else if (message == WM_ACTIVATEAPP) {
       D3DDEVICE_CREATION_PARAMETERS create_parms;
       windowData.swapchain->GetDevice()->GetCreationParameters(&create_parms);
@@ -192,6 +194,7 @@ namespace dxvk {
     , m_device           (pDevice->GetDXVKDevice())
     , m_context          (m_device->createContext(DxvkContextType::Supplementary))
     , m_frameLatencyCap  (pDevice->GetOptions()->maxFrameLatency)
+    , m_lowLatencyMode   (pDevice->GetOptions()->lowLatencyMode)
     , m_frameLatencySignal(new sync::Fence(m_frameId))
     , m_dialog           (pDevice->GetOptions()->enableDialogMode) {
     this->NormalizePresentParameters(pPresentParams);
@@ -250,6 +253,8 @@ namespace dxvk {
           HWND     hDestWindowOverride,
     const RGNDATA* pDirtyRegion,
           DWORD    dwFlags) {
+    DXVK_TRACE_SCOPE("D3D9SwapChainEx::Present");
+
     D3D9DeviceLock lock = m_parent->LockDevice();
 
     uint32_t presentInterval = m_presentParams.PresentationInterval;
@@ -303,6 +308,8 @@ namespace dxvk {
       if (!m_presenter->hasSwapChain())
         return D3D_OK;
 
+      UpdateDirtyRegion(pDirtyRegion);
+
       PresentImage(presentInterval);
       return D3D_OK;
     } catch (const DxvkError& e) {
@@ -318,8 +325,9 @@ namespace dxvk {
     // This function can do absolutely everything!
     // Copies the front buffer between formats with an implicit resolve.
     // Oh, and the dest is systemmem...
-    // This is a slow function anyway, it waits for the copy to finish.
-    // so there's no reason to not just make and throwaway temp images.
+    // The copy is only waited for once the surface gets locked, but
+    // this is a slow function anyway, so there's no reason to not
+    // just make and throwaway temp images.
 
     // If extent of dst > src, then we blit to a subrect of the size
     // of src onto a temp image of dst's extents,
@@ -484,6 +492,7 @@ namespace dxvk {
     dstTexInfo->SetNeedsReadback(dst->GetSubresource(), true);
     m_parent->TrackTextureMappingBufferSequenceNumber(dstTexInfo, dst->GetSubresource());
 
+    m_parent->FlushReadback();
     return D3D_OK;
   }
 
@@ -674,6 +683,22 @@ namespace dxvk {
     return D3D_OK;
   }
 
+  static VkRect2D UnionRect(VkRect2D a, VkRect2D b) {
+    if (!a.extent.width || !a.extent.height)
+      return b;
+
+    if (!b.extent.width || !b.extent.height)
+      return a;
+
+    int32_t x0 = std::min(a.offset.x, b.offset.x);
+    int32_t y0 = std::min(a.offset.y, b.offset.y);
+    int32_t x1 = std::max(a.offset.x + int32_t(a.extent.width),  b.offset.x + int32_t(b.extent.width));
+    int32_t y1 = std::max(a.offset.y + int32_t(a.extent.height), b.offset.y + int32_t(b.extent.height));
+
+    return VkRect2D { { x0, y0 }, { uint32_t(x1 - x0), uint32_t(y1 - y0) } };
+  }
+
+
   static bool validateGammaRamp(const WORD (&ramp)[256]) {
     if (ramp[0] >= ramp[std::size(ramp) - 1]) {
       Logger::err("validateGammaRamp: ramp inverted or flat");
@@ -731,6 +756,8 @@ namespace dxvk {
       m_blitter->setGammaRamp(NumControlPoints, cp.data());
     else
       m_blitter->setGammaRamp(0, nullptr);
+
+    InvalidateSwapImages();
   }
 
 
@@ -790,9 +817,24 @@ namespace dxvk {
     }
 
     if (pPresentParams->Windowed) {
+      bool implicitWidth  = !pPresentParams->BackBufferWidth;
+      bool implicitHeight = !pPresentParams->BackBufferHeight;
+
       GetWindowClientSize(pPresentParams->hDeviceWindow,
-        pPresentParams->BackBufferWidth  ? nullptr : &pPresentParams->BackBufferWidth,
-        pPresentParams->BackBufferHeight ? nullptr : &pPresentParams->BackBufferHeight);
+        implicitWidth  ? &pPresentParams->BackBufferWidth  : nullptr,
+        implicitHeight ? &pPresentParams->BackBufferHeight : nullptr);
+
+      // The application has to query the back buffer size anyway
+      // in this case, so we are free to render at a lower resolution
+      // and let the swap chain blitter scale the image up to the window
+      const int32_t renderScale = m_parent->GetOptions()->renderScale;
+
+      if (renderScale < 100) {
+        if (implicitWidth)
+          pPresentParams->BackBufferWidth  = std::max(pPresentParams->BackBufferWidth  * renderScale / 100, 1u);
+        if (implicitHeight)
+          pPresentParams->BackBufferHeight = std::max(pPresentParams->BackBufferHeight * renderScale / 100, 1u);
+      }
     }
     else {
       GetMonitorClientSize(GetDefaultMonitor(),
@@ -809,6 +851,8 @@ namespace dxvk {
 
 
   void D3D9SwapChainEx::PresentImage(UINT SyncInterval) {
+    auto presentTime = dxvk::high_resolution_clock::now();
+
     m_parent->EndFrame();
     m_parent->Flush();
 
@@ -819,6 +863,14 @@ namespace dxvk {
     // Bump our frame id.
     ++m_frameId;
 
+    // Swap chain images are only partially updated if the app
+    // passed a dirty region, so every image needs to accumulate
+    // the changes made since it was last presented.
+    VkRect2D dirtyBounds = GetDirtyBounds(m_presenter->info().imageExtent);
+
+    for (auto& damage : m_imageDamage)
+      damage = UnionRect(damage, dirtyBounds);
+
     for (uint32_t i = 0; i < SyncInterval || i < 1; i++) {
       SynchronizePresent();
 
@@ -848,21 +900,38 @@ namespace dxvk {
         {  int32_t(m_dstRect.left),                    int32_t(m_dstRect.top)                    },
         { uint32_t(m_dstRect.right - m_dstRect.left), uint32_t(m_dstRect.bottom - m_dstRect.top) } };
 
-      m_blitter->presentImage(m_context.ptr(),
-        m_imageViews.at(imageIndex), dstRect,
-        swapImageView, srcRect);
+      VkRect2D updateRect = std::exchange(m_imageDamage.at(imageIndex), VkRect2D());
+
+      if (updateRect.extent.width && updateRect.extent.height) {
+        m_blitter->presentImage(m_context.ptr(),
+          m_imageViews.at(imageIndex), dstRect,
+          swapImageView, srcRect, updateRect);
+      }
 
       if (m_hud != nullptr)
         m_hud->render(m_context, info.format, info.imageExtent);
 
-      if (i + 1 >= SyncInterval)
-        m_context->signal(m_frameLatencySignal, m_frameId);
+      // With present wait, the presenter signals the frame once it
+      // has actually been displayed rather than when the GPU is done
+      uint64_t displayFrameId = 0;
+
+      if (i + 1 >= SyncInterval) {
+        if (m_presenter->hasPresentWait())
+          displayFrameId = m_frameId;
+        else
+          m_context->signal(m_frameLatencySignal, m_frameId);
+      }
 
-      SubmitPresent(sync, i);
+      SubmitPresent(sync, i, displayFrameId, presentTime);
     }
 
     SyncFrameLatency();
 
+    // In low latency mode, start the next frame as late as possible
+    // without starving the GPU, based on measured GPU completion
+    if (m_lowLatencyMode)
+      m_presenter->delayFrameStart(m_device->getLatencyTracker().getFrameStartDelay());
+
     // Rotate swap chain buffers so that the back
     // buffer at index 0 becomes the front buffer.
     for (uint32_t i = 1; i < m_backBuffers.size(); i++)
@@ -872,15 +941,18 @@ namespace dxvk {
   }
 
 
-  void D3D9SwapChainEx::SubmitPresent(const vk::PresenterSync& Sync, uint32_t FrameId) {
+  void D3D9SwapChainEx::SubmitPresent(const vk::PresenterSync& Sync, uint32_t FrameId, uint64_t DisplayFrameId, dxvk::high_resolution_clock::time_point PresentTime) {
     // Present from CS thread so that we don't
     // have to synchronize with it first.
     m_presentStatus.result = VK_NOT_READY;
 
     m_parent->EmitCs([this,
       cFrameId     = FrameId,
+      cDisplayId   = DisplayFrameId,
+      cPresentTime = PresentTime,
       cSync        = Sync,
       cHud         = m_hud,
+      cRegions     = m_dirtyRects,
       cCommandList = m_context->endRecording()
     ] (DxvkContext* ctx) {
       m_device->submitCommandList(cCommandList,
@@ -889,7 +961,10 @@ namespace dxvk {
       if (cHud != nullptr && !cFrameId)
         cHud->update();
 
-      m_device->presentImage(m_presenter, &m_presentStatus);
+      if (!cFrameId)
+        ctx->defragmentMemory();
+
+      m_device->presentImage(m_presenter, cPresentTime, cDisplayId, &m_presentStatus, cRegions);
     });
 
     m_parent->FlushCsChunk();
@@ -906,9 +981,10 @@ namespace dxvk {
 
 
   void D3D9SwapChainEx::RecreateSwapChain(BOOL Vsync) {
-    // Ensure that we can safely destroy the swap chain
+    // Ensure that the previous present has been executed. The
+    // presenter retires the old swap chain and frees it once the
+    // GPU is done with it, so we don't have to wait for idle.
     m_device->waitForSubmission(&m_presentStatus);
-    m_device->waitForIdle();
 
     m_presentStatus.result = VK_SUCCESS;
 
@@ -919,7 +995,11 @@ namespace dxvk {
     presenterDesc.numPresentModes = PickPresentModes(Vsync, presenterDesc.presentModes);
     presenterDesc.fullScreenExclusive = PickFullscreenMode();
 
-    if (m_presenter->recreateSwapChain(presenterDesc) != VK_SUCCESS)
+    m_device->lockSubmission();
+    VkResult status = m_presenter->recreateSwapChain(presenterDesc);
+    m_device->unlockSubmission();
+
+    if (status != VK_SUCCESS)
       throw DxvkError("D3D9SwapChainEx: Failed to recreate swap chain");
     
     CreateRenderTargetViews();
@@ -939,6 +1019,8 @@ namespace dxvk {
     presenterDevice.queueFamily   = graphicsQueue.queueFamily;
     presenterDevice.queue         = graphicsQueue.queueHandle;
     presenterDevice.adapter       = m_device->adapter()->handle();
+    presenterDevice.features.presentWait = m_device->features().khrPresentWait.presentWait;
+    presenterDevice.features.incrementalPresent = m_device->extensions().khrIncrementalPresent;
 
     vk::PresenterDesc presenterDesc;
     presenterDesc.imageExtent     = GetPresentExtent();
@@ -953,8 +1035,10 @@ namespace dxvk {
       presenterDevice,
       presenterDesc);
 
+    m_presenter->setFrameSignal(m_frameLatencySignal);
     m_presenter->setFrameRateLimit(m_parent->GetOptions()->maxFrameRate);
     m_presenter->setFrameRateLimiterRefreshRate(m_displayRefreshRate);
+    m_presenter->setFrameRateLimiterVblankAlignment(m_parent->GetOptions()->alignFrameRateToVblank);
 
     CreateRenderTargetViews();
   }
@@ -974,7 +1058,8 @@ namespace dxvk {
     imageInfo.extent      = { info.imageExtent.width, info.imageExtent.height, 1 };
     imageInfo.numLayers   = 1;
     imageInfo.mipLevels   = 1;
-    imageInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageInfo.usage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                          | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     imageInfo.stages      = 0;
     imageInfo.access      = 0;
     imageInfo.tiling      = VK_IMAGE_TILING_OPTIMAL;
@@ -1000,6 +1085,9 @@ namespace dxvk {
       m_imageViews[i] = new DxvkImageView(
         m_device->vkd(), image, viewInfo);
     }
+
+    m_imageDamage.resize(info.imageCount);
+    InvalidateSwapImages();
   }
 
 
@@ -1103,6 +1191,9 @@ namespace dxvk {
     if (m_frameLatencyCap)
       maxFrameLatency = std::min(maxFrameLatency, m_frameLatencyCap);
 
+    if (m_lowLatencyMode)
+      maxFrameLatency = 1;
+
     maxFrameLatency = std::min(maxFrameLatency, m_presentParams.BackBufferCount + 1);
     return maxFrameLatency;
   }
@@ -1320,6 +1411,8 @@ namespace dxvk {
   }
 
   bool    D3D9SwapChainEx::UpdatePresentRegion(const RECT* pSourceRect, const RECT* pDestRect) {
+    RECT srcRect = m_srcRect;
+
     if (pSourceRect == nullptr) {
       m_srcRect.top    = 0;
       m_srcRect.left   = 0;
@@ -1329,6 +1422,12 @@ namespace dxvk {
     else
       m_srcRect = *pSourceRect;
 
+    if (m_srcRect.left   != srcRect.left
+     || m_srcRect.top    != srcRect.top
+     || m_srcRect.right  != srcRect.right
+     || m_srcRect.bottom != srcRect.bottom)
+      InvalidateSwapImages();
+
     RECT dstRect;
     if (pDestRect == nullptr) {
       // TODO: Should we hook WM_SIZE message for this?
@@ -1354,6 +1453,91 @@ namespace dxvk {
     return recreate;
   }
 
+  void    D3D9SwapChainEx::UpdateDirtyRegion(const RGNDATA* pDirtyRegion) {
+    m_dirtyRects.clear();
+    m_hasDirtyRegion = false;
+
+    // The back buffer contents are only preserved with the copy
+    // swap effect, and the HUD may be drawn anywhere on the image
+    if (pDirtyRegion == nullptr
+     || pDirtyRegion->rdh.iType != RDH_RECTANGLES
+     || m_presentParams.SwapEffect != D3DSWAPEFFECT_COPY
+     || m_hud != nullptr)
+      return;
+
+    int32_t srcW = m_srcRect.right  - m_srcRect.left;
+    int32_t srcH = m_srcRect.bottom - m_srcRect.top;
+    int32_t dstW = m_dstRect.right  - m_dstRect.left;
+    int32_t dstH = m_dstRect.bottom - m_dstRect.top;
+
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0)
+      return;
+
+    // Scaled blits sample neighbouring pixels, so grow each
+    // rect by one pixel in order to not miss any changes
+    int32_t margin = (srcW != dstW || srcH != dstH) ? 1 : 0;
+
+    VkExtent2D extent = m_presenter->info().imageExtent;
+
+    auto rects = reinterpret_cast<const RECT*>(pDirtyRegion->Buffer);
+
+    for (uint32_t i = 0; i < pDirtyRegion->rdh.nCount; i++) {
+      int32_t l = std::max<int32_t>(rects[i].left,   m_srcRect.left)   - m_srcRect.left;
+      int32_t t = std::max<int32_t>(rects[i].top,    m_srcRect.top)    - m_srcRect.top;
+      int32_t r = std::min<int32_t>(rects[i].right,  m_srcRect.right)  - m_srcRect.left;
+      int32_t b = std::min<int32_t>(rects[i].bottom, m_srcRect.bottom) - m_srcRect.top;
+
+      if (l >= r || t >= b)
+        continue;
+
+      // Map to swap image coordinates, rounding outwards
+      int64_t x0 = int64_t(l) * dstW / srcW + m_dstRect.left - margin;
+      int64_t y0 = int64_t(t) * dstH / srcH + m_dstRect.top  - margin;
+      int64_t x1 = (int64_t(r) * dstW + srcW - 1) / srcW + m_dstRect.left + margin;
+      int64_t y1 = (int64_t(b) * dstH + srcH - 1) / srcH + m_dstRect.top  + margin;
+
+      x0 = std::clamp<int64_t>(x0, 0, extent.width);
+      y0 = std::clamp<int64_t>(y0, 0, extent.height);
+      x1 = std::clamp<int64_t>(x1, 0, extent.width);
+      y1 = std::clamp<int64_t>(y1, 0, extent.height);
+
+      if (x0 >= x1 || y0 >= y1)
+        continue;
+
+      VkRectLayerKHR rect;
+      rect.offset = { int32_t(x0), int32_t(y0) };
+      rect.extent = { uint32_t(x1 - x0), uint32_t(y1 - y0) };
+      rect.layer  = 0;
+      m_dirtyRects.push_back(rect);
+    }
+
+    m_hasDirtyRegion = true;
+  }
+
+
+  VkRect2D D3D9SwapChainEx::GetDirtyBounds(VkExtent2D Extent) const {
+    if (!m_hasDirtyRegion)
+      return VkRect2D { { 0, 0 }, Extent };
+
+    VkRect2D bounds = { };
+
+    for (const auto& rect : m_dirtyRects)
+      bounds = UnionRect(bounds, VkRect2D { rect.offset, rect.extent });
+
+    return bounds;
+  }
+
+
+  void    D3D9SwapChainEx::InvalidateSwapImages() {
+    VkExtent2D extent = m_presenter != nullptr
+      ? m_presenter->info().imageExtent
+      : VkExtent2D();
+
+    for (auto& damage : m_imageDamage)
+      damage = VkRect2D { { 0, 0 }, extent };
+  }
+
+
   VkExtent2D D3D9SwapChainEx::GetPresentExtent() {
     return VkExtent2D {
       std::max<uint32_t>(m_dstRect.right  - m_dstRect.left, 1u),
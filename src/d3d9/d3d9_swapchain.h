@@ -105,16 +105,21 @@ namespace dxvk {
 
     std::vector<Com<D3D9Surface, false>> m_backBuffers;
     
-    RECT                      m_srcRect;
+    RECT                      m_srcRect = { };
     RECT                      m_dstRect;
 
     DxvkSubmitStatus          m_presentStatus;
 
     std::vector<Rc<DxvkImageView>> m_imageViews;
+    std::vector<VkRect2D>     m_imageDamage;
+
+    std::vector<VkRectLayerKHR> m_dirtyRects;
+    bool                      m_hasDirtyRegion    = false;
 
 
     uint64_t                  m_frameId           = D3D9DeviceEx::MaxFrameLatency;
     uint32_t                  m_frameLatencyCap   = 0;
+    bool                      m_lowLatencyMode    = false;
     Rc<sync::Fence>           m_frameLatencySignal;
 
     bool                      m_dirty    = true;
@@ -132,7 +137,7 @@ namespace dxvk {
 
     void PresentImage(UINT PresentInterval);
 
-    void SubmitPresent(const vk::PresenterSync& Sync, uint32_t FrameId);
+    void SubmitPresent(const vk::PresenterSync& Sync, uint32_t FrameId, uint64_t DisplayFrameId, dxvk::high_resolution_clock::time_point PresentTime);
 
     void SynchronizePresent();
 
@@ -186,6 +191,12 @@ namespace dxvk {
 
     bool    UpdatePresentRegion(const RECT* pSourceRect, const RECT* pDestRect);
 
+    void    UpdateDirtyRegion(const RGNDATA* pDirtyRegion);
+
+    VkRect2D GetDirtyBounds(VkExtent2D Extent) const;
+
+    void    InvalidateSwapImages();
+
     VkExtent2D GetPresentExtent();
 
     VkFullScreenExclusiveEXT PickFullscreenMode();
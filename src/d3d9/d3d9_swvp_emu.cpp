@@ -302,15 +302,21 @@ namespace dxvk {
 
   };
 
-  Rc<DxvkShader> D3D9SWVPEmulator::GetShaderModule(D3D9DeviceEx* pDevice, const D3D9VertexDecl* pDecl) {
+  Rc<DxvkShader> D3D9SWVPEmulator::GetShaderModule(D3D9DeviceEx* pDevice, D3D9VertexDecl* pDecl) {
+    // Fast path for declarations that were used before
+    if (pDecl->GetSWVPShader() != nullptr)
+      return pDecl->GetSWVPShader();
+
     auto& elements = pDecl->GetElements();
 
     // Use the shader's unique key for the lookup
     { std::unique_lock<dxvk::mutex> lock(m_mutex);
       
       auto entry = m_modules.find(elements);
-      if (entry != m_modules.end())
+      if (entry != m_modules.end()) {
+        pDecl->SetSWVPShader(entry->second);
         return entry->second;
+      }
     }
 
     Sha1Hash hash = Sha1Hash::compute(
@@ -345,9 +351,10 @@ namespace dxvk {
       
       auto status = m_modules.insert({ elements, shader });
       if (!status.second)
-        return status.first->second;
+        shader = status.first->second;
     }
 
+    pDecl->SetSWVPShader(shader);
     return shader;
   }
 
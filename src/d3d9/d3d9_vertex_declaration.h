@@ -3,6 +3,8 @@
 #include "d3d9_device_child.h"
 #include "d3d9_util.h"
 
+#include "../dxvk/dxvk_shader.h"
+
 #include <vector>
 
 namespace dxvk {
@@ -66,6 +68,23 @@ namespace dxvk {
       return m_texcoordMask;
     }
 
+    /**
+     * \brief SWVP emulation shader
+     *
+     * Caches the shader used by \c ProcessVertices for this
+     * declaration, so that repeated calls do not need to hash
+     * the vertex elements. Must only be accessed from the CS
+     * thread.
+     * \returns Cached shader, may be \c nullptr
+     */
+    const Rc<DxvkShader>& GetSWVPShader() const {
+      return m_swvpShader;
+    }
+
+    void SetSWVPShader(const Rc<DxvkShader>& Shader) {
+      m_swvpShader = Shader;
+    }
+
   private:
 
     void Classify();
@@ -81,6 +100,8 @@ namespace dxvk {
     // The size of Stream 0. That's all we care about.
     uint32_t                       m_size = 0;
 
+    Rc<DxvkShader>                 m_swvpShader;
+
   };
 
 }
\ No newline at end of file
@@ -27,6 +27,8 @@ namespace dxvk {
   
   
   void DxbcAnalyzer::processInstruction(const DxbcShaderInstruction& ins) {
+    m_analysis->instructionCount += 1;
+
     switch (ins.opClass) {
       case DxbcInstClass::Atomic: {
         const uint32_t operandId = ins.dstCount - 1;
@@ -76,6 +78,17 @@ namespace dxvk {
         const uint32_t registerId = ins.dst[0].idx[0].offset;
         m_analysis->uavInfos[registerId].accessFlags |= VK_ACCESS_SHADER_WRITE_BIT;
       } break;
+
+      case DxbcInstClass::Declaration: {
+        if (ins.op == DxbcOpcode::DclIndexableTemp) {
+          const uint32_t registerId = ins.imm[0].u32;
+
+          if (registerId >= m_xRegLengths.size())
+            m_xRegLengths.resize(registerId + 1);
+
+          m_xRegLengths[registerId] = ins.imm[1].u32;
+        }
+      } break;
       
       default:
         break;
@@ -87,9 +100,60 @@ namespace dxvk {
         m_analysis->xRegMasks[index] |= ins.dst[0].mask;
       }
     }
+
+    for (uint32_t i = 0; i < ins.dstCount; i++)
+      analyzeOperand(ins.dst[i]);
+
+    for (uint32_t i = 0; i < ins.srcCount; i++)
+      analyzeOperand(ins.src[i]);
+  }
+
+
+  void DxbcAnalyzer::analyzeOperand(const DxbcRegister& reg) {
+    for (uint32_t i = 0; i < reg.idxDim; i++) {
+      if (reg.idx[i].relReg != nullptr)
+        analyzeOperand(*reg.idx[i].relReg);
+    }
+
+    if (reg.type == DxbcOperandType::ConstantBuffer)
+      analyzeConstantBufferAccess(reg);
+
+    if (reg.type != DxbcOperandType::IndexableTemp)
+      return;
+    
+    // Arrays that are accessed with a relative or out-of-bounds
+    // index have to stay arrays, all others can be promoted to
+    // one plain register per array element by the compiler.
+    const uint32_t registerId = reg.idx[0].offset;
+
+    if (registerId >= m_analysis->xRegDynamicIndex.size())
+      return;
+
+    if (reg.idx[1].relReg != nullptr
+     || registerId >= m_xRegLengths.size()
+     || uint32_t(reg.idx[1].offset) >= m_xRegLengths[registerId])
+      m_analysis->xRegDynamicIndex[registerId] = true;
   }
   
   
+  void DxbcAnalyzer::analyzeConstantBufferAccess(const DxbcRegister& reg) {
+    // cb# regs are indexed as follows:
+    //    (0) register index (immediate)
+    //    (1) constant index (relative)
+    const uint32_t registerId = reg.idx[0].offset;
+
+    if (registerId >= m_analysis->cbInfos.size())
+      return;
+
+    DxbcConstantBufferInfo& info = m_analysis->cbInfos[registerId];
+
+    if (reg.idx[1].relReg != nullptr)
+      info.dynamicIndex = true;
+    else
+      info.usedCount = std::max(info.usedCount, uint32_t(reg.idx[1].offset) + 1);
+  }
+
+
   DxbcClipCullInfo DxbcAnalyzer::getClipCullInfo(const Rc<DxbcIsgn>& sgn) const {
     DxbcClipCullInfo result;
     
@@ -22,6 +22,18 @@ namespace dxvk {
     VkAccessFlags accessFlags = 0;
   };
   
+  /**
+   * \brief Info about constant buffers
+   * 
+   * Stores the number of constants that are accessed
+   * with static indices. If the buffer is indexed
+   * dynamically, the entire buffer may be accessed.
+   */
+  struct DxbcConstantBufferInfo {
+    uint32_t usedCount    = 0;
+    bool     dynamicIndex = false;
+  };
+  
   /**
    * \brief Counts cull and clip distances
    */
@@ -35,13 +47,17 @@ namespace dxvk {
    */
   struct DxbcAnalysisInfo {
     std::array<DxbcUavInfo, 64> uavInfos;
+    std::array<DxbcConstantBufferInfo, 16> cbInfos;
     std::array<DxbcRegMask, 4096> xRegMasks;
+    std::array<bool,        4096> xRegDynamicIndex = { };
     
     DxbcClipCullInfo clipCullIn;
     DxbcClipCullInfo clipCullOut;
     
     bool usesDerivatives  = false;
     bool usesKill         = false;
+
+    uint32_t instructionCount = 0;
   };
   
   /**
@@ -79,6 +95,14 @@ namespace dxvk {
     Rc<DxbcIsgn> m_psgn;
     
     DxbcAnalysisInfo* m_analysis = nullptr;
+
+    std::vector<uint32_t> m_xRegLengths;
+    
+    void analyzeOperand(
+      const DxbcRegister&       reg);
+    
+    void analyzeConstantBufferAccess(
+      const DxbcRegister&       reg);
     
     DxbcClipCullInfo getClipCullInfo(
       const Rc<DxbcIsgn>& sgn) const;
@@ -23,10 +23,26 @@ namespace dxvk {
     m_isgn       (isgn),
     m_osgn       (osgn),
     m_psgn       (psgn),
-    m_analysis   (&analysis) {
+    m_analysis   (&analysis),
+    m_bindings   (&m_arena),
+    m_rRegs      (&m_arena),
+    m_xRegs      (&m_arena),
+    m_gRegs      (&m_arena),
+    m_vMappings  (&m_arena),
+    m_oMappings  (&m_arena),
+    m_xfbVars    (&m_arena),
+    m_controlFlowBlocks(&m_arena),
+    m_immConstData(&m_arena),
+    m_subroutines(&m_arena),
+    m_entryPointInterfaces(&m_arena) {
     // Declare an entry point ID. We'll need it during the
     // initialization phase where the execution mode is set.
     m_entryPointId = m_module.allocateId();
+
+    // Most DXBC instructions translate to a handful of SPIR-V
+    // instructions, so reserve enough memory up front to avoid
+    // reallocating the code buffer for large shaders.
+    m_module.reserveCode(m_analysis->instructionCount * 16);
     
     // Set the shader name so that we recognize it in renderdoc
     m_module.setDebugSource(
@@ -268,7 +284,18 @@ namespace dxvk {
         info.xfbStrides[i] = m_moduleInfo.xfb->strides[i];
     }
 
-    return new DxvkShader(info, m_module.compile());
+    SpirvCodeBuffer code = m_module.compile();
+
+    if (m_moduleInfo.options.optimizeSpirv) {
+      SpirvOptimizer optimizer(code);
+      code = optimizer.optimize();
+
+      SpirvOptimizerStats stats = optimizer.getStats();
+      Logger::debug(str::format("SPIR-V optimizer: ", stats.insCountBefore, " -> ", stats.insCountAfter,
+        " instructions, ", stats.forwardedLoads, " loads forwarded, ", stats.foldedConstants, " constants folded"));
+    }
+
+    return new DxvkShader(info, std::move(code));
   }
   
   
@@ -397,12 +424,31 @@ namespace dxvk {
     if (regId >= m_xRegs.size())
       m_xRegs.resize(regId + 1);
     
-    m_xRegs.at(regId).ccount = info.type.ccount;
-    m_xRegs.at(regId).alength = info.type.alength;
-    m_xRegs.at(regId).varId  = emitNewVariable(info);
-    
-    m_module.setDebugName(m_xRegs.at(regId).varId,
-      str::format("x", regId).c_str());
+    DxbcXreg& xReg = m_xRegs.at(regId);
+    xReg.ccount  = info.type.ccount;
+    xReg.alength = info.type.alength;
+    xReg.varId   = 0;
+    xReg.elementIds.clear();
+
+    // Arrays that are only ever accessed with literal indices
+    // are promoted to one variable per element. Drivers tend to
+    // put private arrays into scratch memory otherwise.
+    if (!m_analysis->xRegDynamicIndex.at(regId)) {
+      info.type.alength = 0;
+
+      for (uint32_t i = 0; i < xReg.alength; i++) {
+        uint32_t varId = emitNewVariable(info);
+        xReg.elementIds.push_back(varId);
+
+        m_module.setDebugName(varId,
+          str::format("x", regId, "_", i).c_str());
+      }
+    } else {
+      xReg.varId = emitNewVariable(info);
+
+      m_module.setDebugName(xReg.varId,
+        str::format("x", regId).c_str());
+    }
   }
   
   
@@ -779,6 +825,14 @@ namespace dxvk {
     
     this->emitDclConstantBufferVar(bufferId, elementCount,
       str::format("cb", bufferId).c_str(), asSsbo);
+
+    // Record the range that the shader actually reads, so that
+    // only that part of the buffer needs to be bound. Buffers
+    // accessed with a dynamic index may be read entirely.
+    const DxbcConstantBufferInfo& cbInfo = m_analysis->cbInfos.at(bufferId);
+
+    if (!cbInfo.dynamicIndex)
+      m_bindings.back().uniformSize = 16 * std::min(cbInfo.usedCount, elementCount);
   }
   
   
@@ -3845,7 +3899,7 @@ namespace dxvk {
     label.desc.literal = ins.src[0].imm.u32_1;
     label.desc.labelId = block->labelCase;
     label.next         = block->labelCases;
-    block->labelCases = new DxbcSwitchLabel(label);
+    block->labelCases = m_arena.create<DxbcSwitchLabel>(label);
   }
   
   
@@ -3895,7 +3949,7 @@ namespace dxvk {
       spv::SelectionControlMaskNone);
     
     // We'll restore the original order of the case labels here
-    std::vector<SpirvSwitchCaseLabel> jumpTargets;
+    arena_vector<SpirvSwitchCaseLabel> jumpTargets(&m_arena);
     for (auto i = block.b_switch.labelCases; i != nullptr; i = i->next)
       jumpTargets.insert(jumpTargets.begin(), i->desc);
     
@@ -3905,13 +3959,6 @@ namespace dxvk {
       jumpTargets.size(),
       jumpTargets.data());
     m_module.endInsertion();
-    
-    // Destroy the list of case labels
-    // FIXME we're leaking memory if compilation fails.
-    DxbcSwitchLabel* caseLabel = block.b_switch.labelCases;
-    
-    while (caseLabel != nullptr)
-      delete std::exchange(caseLabel, caseLabel->next);
   }
   
     
@@ -7794,6 +7841,16 @@ namespace dxvk {
     DxbcRegisterPointer result;
     result.type.ctype  = info.type.ctype;
     result.type.ccount = info.type.ccount;
+
+    // Promoted arrays are only accessed with literal indices
+    // that are known to be in bounds, see the analyzer.
+    const auto& elementIds = m_xRegs[regId].elementIds;
+
+    if (!elementIds.empty()) {
+      result.id = elementIds.at(operand.idx[1].offset);
+      return result;
+    }
+
     result.id = m_module.opAccessChain(
       getPointerTypeId(info),
       m_xRegs.at(regId).varId,
@@ -4,6 +4,9 @@
 #include <vector>
 
 #include "../spirv/spirv_module.h"
+#include "../spirv/spirv_optimizer.h"
+
+#include "../util/util_arena.h"
 
 #include "dxbc_analysis.h"
 #include "dxbc_chunk_isgn.h"
@@ -86,6 +89,7 @@ namespace dxvk {
     uint32_t ccount  = 0;
     uint32_t alength = 0;
     uint32_t varId   = 0;
+    std::vector<uint32_t> elementIds;
   };
   
   
@@ -419,21 +423,27 @@ namespace dxvk {
     Rc<DxbcIsgn>        m_psgn;
     
     const DxbcAnalysisInfo* m_analysis;
+
+    ///////////////////////////////////////////////////////
+    // Backing memory for compiler-internal containers. All
+    // of it gets released at once when the compiler is
+    // destroyed, so it must be declared before its users.
+    Arena m_arena;
     
     ///////////////////////////////////////////////////////
     // Resource slot description for the shader. This will
     // be used to map D3D11 bindings to DXVK bindings.
-    std::vector<DxvkBindingInfo> m_bindings;
+    arena_vector<DxvkBindingInfo> m_bindings;
     
     ////////////////////////////////////////////////
     // Temporary r# vector registers with immediate
     // indexing, and x# vector array registers.
-    std::vector<uint32_t> m_rRegs;
-    std::vector<DxbcXreg> m_xRegs;
+    arena_vector<uint32_t> m_rRegs;
+    arena_vector<DxbcXreg> m_xRegs;
     
     /////////////////////////////////////////////
     // Thread group shared memory (g#) registers
-    std::vector<DxbcGreg> m_gRegs;
+    arena_vector<DxbcGreg> m_gRegs;
     
     ///////////////////////////////////////////////////////////
     // v# registers as defined by the shader. The type of each
@@ -441,7 +451,7 @@ namespace dxvk {
     std::array<
       DxbcRegisterPointer,
       DxbcMaxInterfaceRegs>     m_vRegs;
-    std::vector<DxbcSvMapping>  m_vMappings;
+    arena_vector<DxbcSvMapping> m_vMappings;
     
     //////////////////////////////////////////////////////////
     // o# registers as defined by the shader. In the fragment
@@ -450,11 +460,11 @@ namespace dxvk {
     std::array<
       DxbcRegisterPointer,
       DxbcMaxInterfaceRegs>     m_oRegs;
-    std::vector<DxbcSvMapping>  m_oMappings;
+    arena_vector<DxbcSvMapping> m_oMappings;
 
     /////////////////////////////////////////////
     // xfb output registers for geometry shaders
-    std::vector<DxbcXfbVar> m_xfbVars;
+    arena_vector<DxbcXfbVar> m_xfbVars;
     
     //////////////////////////////////////////////////////
     // Shader resource variables. These provide access to
@@ -467,7 +477,7 @@ namespace dxvk {
     ///////////////////////////////////////////////
     // Control flow information. Stores labels for
     // currently active if-else blocks and loops.
-    std::vector<DxbcCfgBlock> m_controlFlowBlocks;
+    arena_vector<DxbcCfgBlock> m_controlFlowBlocks;
     
     //////////////////////////////////////////////
     // Function state tracking. Required in order
@@ -498,7 +508,7 @@ namespace dxvk {
     // Immediate constant buffer. If defined, this is
     // an array of four-component uint32 vectors.
     uint32_t m_immConstBuf = 0;
-    std::vector<char> m_immConstData;
+    arena_vector<char> m_immConstData;
     
     ///////////////////////////////////////////////////
     // Sample pos array. If defined, this iis an array
@@ -512,13 +522,13 @@ namespace dxvk {
     
     ////////////////////////////////
     // Function IDs for subroutines
-    std::unordered_map<uint32_t, uint32_t> m_subroutines;
+    arena_unordered_map<uint32_t, uint32_t> m_subroutines;
     
     ///////////////////////////////////////////////////
     // Entry point description - we'll need to declare
     // the function ID and all input/output variables.
-    std::vector<uint32_t> m_entryPointInterfaces;
-    uint32_t              m_entryPointId = 0;
+    arena_vector<uint32_t> m_entryPointInterfaces;
+    uint32_t               m_entryPointId = 0;
     
     ////////////////////////////////////////////
     // Inter-stage shader interface slots. Also
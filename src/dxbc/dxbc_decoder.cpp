@@ -23,6 +23,16 @@ namespace dxvk {
   }
   
   
+  const uint32_t* DxbcCodeSlice::read(uint32_t n) {
+    if (m_ptr + n > m_end)
+      throw DxvkError("DxbcCodeSlice: End of stream");
+    
+    const uint32_t* ptr = m_ptr;
+    m_ptr += n;
+    return ptr;
+  }
+  
+  
   DxbcCodeSlice DxbcCodeSlice::take(uint32_t n) const {
     if (m_ptr + n > m_end)
       throw DxvkError("DxbcCodeSlice: End of stream");
@@ -148,7 +158,7 @@ namespace dxvk {
     // Retrieve the instruction format in order to parse the
     // operands. Doing this mostly automatically means that
     // the compiler can rely on the operands being valid.
-    const DxbcInstFormat format = dxbcInstructionFormat(m_instruction.op);
+    const DxbcInstFormat& format = dxbcInstructionFormat(m_instruction.op);
     m_instruction.opClass = format.instructionClass;
     
     for (uint32_t i = 0; i < format.operandCount; i++)
@@ -324,6 +334,24 @@ namespace dxvk {
     }
     
     this->decodeComponentSelection(reg, token);
+    
+    // Fast path for the most common encoding, which has no
+    // extended operand tokens, no immediate values and only
+    // uses immediate indices. If all of the bits above the
+    // index dimension are zero, all index representations
+    // are Imm32 and we can read the indices in one go.
+    if (likely(!(token >> 22)
+     && reg.type != DxbcOperandType::Imm32
+     && reg.type != DxbcOperandType::Imm64)) {
+      reg.idxDim = bit::extract(token, 20, 21);
+      
+      const uint32_t* indices = code.read(reg.idxDim);
+      
+      for (uint32_t i = 0; i < reg.idxDim; i++)
+        reg.idx[i].offset = static_cast<int32_t>(indices[i]);
+      return;
+    }
+    
     this->decodeOperandExtensions(code, reg, token);
     this->decodeOperandImmediates(code, reg);
     this->decodeOperandIndex(code, reg, token);
@@ -428,6 +428,16 @@ namespace dxvk {
     uint32_t at(uint32_t id) const;
     uint32_t read();
     
+    /**
+     * \brief Reads multiple words at once
+     * 
+     * Only checks the bounds once for the
+     * entire range of words that is read.
+     * \param [in] n Number of words to read
+     * \returns Pointer to the first word
+     */
+    const uint32_t* read(uint32_t n);
+    
     DxbcCodeSlice take(uint32_t n) const;
     DxbcCodeSlice skip(uint32_t n) const;
     
@@ -435,6 +445,10 @@ namespace dxvk {
       return m_ptr == m_end;
     }
     
+    size_t size() const {
+      return m_end - m_ptr;
+    }
+    
   private:
     
     const uint32_t* m_ptr = nullptr;
@@ -1106,12 +1106,15 @@ namespace dxvk {
   }};
   
   
-  DxbcInstFormat dxbcInstructionFormat(DxbcOpcode opcode) {
+  const DxbcInstFormat g_undefinedFormat = { };
+  
+  
+  const DxbcInstFormat& dxbcInstructionFormat(DxbcOpcode opcode) {
     const uint32_t idx = static_cast<uint32_t>(opcode);
     
-    return (idx < g_instructionFormats.size())
-      ? g_instructionFormats.at(idx)
-      : DxbcInstFormat();
+    return likely(idx < g_instructionFormats.size())
+      ? g_instructionFormats[idx]
+      : g_undefinedFormat;
   }
   
 }
\ No newline at end of file
@@ -95,9 +95,13 @@ namespace dxvk {
   /**
    * \brief Retrieves instruction format info
    * 
+   * Returns a reference into a static table, so
+   * that decoding an instruction does not have to
+   * copy the format. Unknown opcodes return an
+   * empty format of the \c Undefined class.
    * \param [in] opcode The opcode to retrieve
    * \returns Instruction format info
    */
-  DxbcInstFormat dxbcInstructionFormat(DxbcOpcode opcode);
+  const DxbcInstFormat& dxbcInstructionFormat(DxbcOpcode opcode);
   
 }
\ No newline at end of file
@@ -43,6 +43,8 @@ namespace dxvk {
   Rc<DxvkShader> DxbcModule::compile(
     const DxbcModuleInfo& moduleInfo,
     const std::string&    fileName) const {
+    DXVK_TRACE_SCOPE("DxbcModule::compile");
+
     if (m_shexChunk == nullptr)
       throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
     
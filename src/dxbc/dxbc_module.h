@@ -48,6 +48,14 @@ namespace dxvk {
     Rc<DxbcIsgn> isgn() const { return m_isgnChunk; }
     Rc<DxbcIsgn> osgn() const { return m_osgnChunk; }
     
+    /**
+     * \brief Shader code
+     * \returns Instruction stream of the shader
+     */
+    DxbcCodeSlice code() const {
+      return m_shexChunk->slice();
+    }
+    
     /**
      * \brief Compiles DXBC shader to SPIR-V module
      * 
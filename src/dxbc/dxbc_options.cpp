@@ -42,6 +42,7 @@ namespace dxvk {
     zeroInitWorkgroupMemory  = options.zeroInitWorkgroupMemory;
     forceTgsmBarriers        = options.forceTgsmBarriers;
     disableMsaa              = options.disableMsaa;
+    optimizeSpirv            = device->config().optimizeSpirv;
     dynamicIndexedConstantBufferAsSsbo = options.constantBufferRangeCheck;
 
     // Disable subgroup early discard on Nvidia because it may hurt performance
@@ -68,4 +69,30 @@ namespace dxvk {
       enableRtOutputNanFixup = true;
   }
   
-}
\ No newline at end of file
+
+
+  Sha1Hash DxbcOptions::hash() const {
+    // Pack options explicitly so that padding
+    // bytes do not end up affecting the hash
+    std::array<uint32_t, 16> data = {
+      uint32_t(useDepthClipWorkaround),
+      uint32_t(useStorageImageReadWithoutFormat),
+      uint32_t(useSubgroupOpsForAtomicCounters),
+      uint32_t(useDemoteToHelperInvocation),
+      uint32_t(useSubgroupOpsForEarlyDiscard),
+      uint32_t(useSdivForBufferIndex),
+      uint32_t(enableRtOutputNanFixup),
+      uint32_t(dynamicIndexedConstantBufferAsSsbo),
+      uint32_t(zeroInitWorkgroupMemory),
+      uint32_t(invariantPosition),
+      uint32_t(forceTgsmBarriers),
+      uint32_t(disableMsaa),
+      uint32_t(optimizeSpirv),
+      uint32_t(floatControl.raw()),
+      uint32_t(minSsboAlignment),
+      uint32_t(minSsboAlignment >> 32) };
+
+    return Sha1Hash::compute(data.data(), data.size() * sizeof(uint32_t));
+  }
+
+}
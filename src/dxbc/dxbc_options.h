@@ -2,6 +2,8 @@
 
 #include "../dxvk/dxvk_device.h"
 
+#include "../util/sha1/sha1_util.h"
+
 namespace dxvk {
 
   struct D3D11Options;
@@ -19,6 +21,16 @@ namespace dxvk {
     DxbcOptions();
     DxbcOptions(const Rc<DxvkDevice>& device, const D3D11Options& options);
 
+    /**
+     * \brief Computes hash of all options
+     *
+     * Used to identify translated shaders in the
+     * persistent shader cache. Must be updated
+     * whenever a new option is added.
+     * \returns Hash of all option values
+     */
+    Sha1Hash hash() const;
+
     // Clamp oDepth in fragment shaders if the depth
     // clip device feature is not supported
     bool useDepthClipWorkaround = false;
@@ -60,6 +72,9 @@ namespace dxvk {
     /// Replace ld_ms with ld
     bool disableMsaa = false;
 
+    /// Run the SPIR-V optimizer on translated shaders
+    bool optimizeSpirv = false;
+
     /// Float control flags
     DxbcFloatControlFlags floatControl;
 
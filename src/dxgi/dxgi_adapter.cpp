@@ -452,8 +452,16 @@ namespace dxvk {
     std::unique_lock<dxvk::mutex> lock(m_mutex);
     DxvkAdapterMemoryInfo memoryInfoOld = m_adapter->getMemoryHeapInfo();
 
+    uint32_t pressureMaskOld = getMemoryPressureMask(memoryInfoOld);
+
     while (true) {
-      m_cond.wait_for(lock, std::chrono::milliseconds(1500),
+      // Poll more frequently while any heap is close to its budget,
+      // so that applications can react before the driver starts paging
+      auto interval = pressureMaskOld
+        ? std::chrono::milliseconds(250)
+        : std::chrono::milliseconds(1500);
+
+      m_cond.wait_for(lock, interval,
         [this] { return m_eventCookie == ~0u; });
 
       if (m_eventCookie == ~0u)
@@ -467,14 +475,36 @@ namespace dxvk {
                       != memoryInfoOld.heaps[i].memoryBudget;
       }
 
+      // Also notify the application when a heap starts or stops
+      // being close to its budget, even if the budget is static
+      uint32_t pressureMaskNew = getMemoryPressureMask(memoryInfoNew);
+      budgetChanged |= pressureMaskNew != pressureMaskOld;
+
       if (budgetChanged) {
         memoryInfoOld = memoryInfoNew;
+        pressureMaskOld = pressureMaskNew;
 
         for (const auto& pair : m_eventMap)
           SetEvent(pair.second);
       }
     }
   }
+
+
+  uint32_t DxgiAdapter::getMemoryPressureMask(
+    const DxvkAdapterMemoryInfo&        memoryInfo) {
+    uint32_t mask = 0;
+
+    for (uint32_t i = 0; i < memoryInfo.heapCount; i++) {
+      VkDeviceSize budget = memoryInfo.heaps[i].memoryBudget;
+      VkDeviceSize usage  = memoryInfo.heaps[i].memoryAllocated;
+
+      if (usage > budget - budget / MemoryPressureThreshold)
+        mask |= 1u << i;
+    }
+
+    return mask;
+  }
   
   
   BOOL CALLBACK DxgiAdapter::MonitorEnumProc(
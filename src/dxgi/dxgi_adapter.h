@@ -40,7 +40,9 @@ namespace dxvk {
 
   
   class DxgiAdapter : public DxgiObject<IDXGIDXVKAdapter> {
-    
+    /// A heap is considered under pressure once its usage
+    /// exceeds the budget minus 1/n of the budget
+    constexpr static VkDeviceSize MemoryPressureThreshold = 8;
   public:
     
     DxgiAdapter(
@@ -123,6 +125,9 @@ namespace dxvk {
     dxvk::thread                      m_eventThread;
 
     void runEventThread();
+
+    static uint32_t getMemoryPressureMask(
+      const DxvkAdapterMemoryInfo&        memoryInfo);
     
     struct MonitorEnumInfo {
       UINT      iMonitorId;
@@ -47,6 +47,18 @@ namespace dxvk {
      || opcode == DxsoOpcode::TexDepth)
       m_analysis->usesDerivatives = true;
 
+    for (uint32_t i = 0; i < ctx.srcCount; i++) {
+      const DxsoRegister& reg = ctx.src[i];
+
+      if (reg.id.type != DxsoRegisterType::Const)
+        continue;
+
+      if (reg.hasRelative || reg.id.num >= 256)
+        m_analysis->relativeConstantsF = true;
+      else
+        m_analysis->usedConstantsF.set(reg.id.num, true);
+    }
+
     m_parentOpcode = ctx.instruction.opcode;
   }
 
@@ -11,6 +11,11 @@ namespace dxvk {
     bool usesDerivatives = false;
     bool usesKill        = false;
 
+    // Float constants read with a static index, and whether
+    // any float constant is read with a relative index.
+    bit::bitset<256> usedConstantsF;
+    bool             relativeConstantsF = false;
+
     std::vector<DxsoInstructionContext> coissues;
   };
 
@@ -50,6 +50,21 @@ namespace dxvk {
     for (uint32_t i = 0; i < m_cFloat.size(); i++)
       m_cFloat.at(i) = 0;
 
+    // If float constants are only ever read with static indices,
+    // store the used ones densely so that uploads only need to
+    // copy those instead of the entire range of registers.
+    if (!isSwvp() && !analysis.relativeConstantsF) {
+      m_meta.packedConstantsF = true;
+      m_constantSlotsF.resize(layout.floatCount, layout.floatCount);
+
+      for (uint32_t i = 0; i < layout.floatCount && i < 256; i++) {
+        if (analysis.usedConstantsF.get(i)) {
+          m_constantSlotsF[i] = uint32_t(m_packedConstantsF.size());
+          m_packedConstantsF.push_back(i);
+        }
+      }
+    }
+
     for (uint32_t i = 0; i < m_cInt.size(); i++)
       m_cInt.at(i)   = 0;
 
@@ -255,7 +270,18 @@ namespace dxvk {
     info.pushConstOffset = m_pushConstOffset;
     info.pushConstSize = m_pushConstSize;
 
-    return new DxvkShader(info, m_module.compile());
+    SpirvCodeBuffer code = m_module.compile();
+
+    if (m_moduleInfo.options.optimizeSpirv) {
+      SpirvOptimizer optimizer(code);
+      code = optimizer.optimize();
+
+      SpirvOptimizerStats stats = optimizer.getStats();
+      Logger::debug(str::format("SPIR-V optimizer: ", stats.insCountBefore, " -> ", stats.insCountAfter,
+        " instructions, ", stats.forwardedLoads, " loads forwarded, ", stats.foldedConstants, " constants folded"));
+    }
+
+    return new DxvkShader(info, std::move(code));
   }
 
   void DxsoCompiler::emitInit() {
@@ -271,14 +297,6 @@ namespace dxvk {
       this->emitDclConstantBuffer();
     }
 
-    m_nullSpecConstant = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.decorateSpecId(m_nullSpecConstant, getSpecId(D3D9SpecConstantId::SamplerNull));
-    m_module.setDebugName(m_nullSpecConstant, "nullSamplers");
-
-    m_depthSpecConstant = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.decorateSpecId(m_depthSpecConstant, getSpecId(D3D9SpecConstantId::SamplerDepthMode));
-    m_module.setDebugName(m_depthSpecConstant, "depthSamplers");
-
     this->emitDclInputArray();
 
     // Initialize the shader module with capabilities
@@ -339,13 +357,6 @@ namespace dxvk {
     binding.viewType        = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
     binding.access          = VK_ACCESS_UNIFORM_READ_BIT;
     m_bindings.push_back(binding);
-
-    m_boolSpecConstant = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.decorateSpecId(m_boolSpecConstant, getSpecId(
-      m_programInfo.type() == DxsoProgramType::VertexShader
-      ? D3D9SpecConstantId::VertexShaderBools
-      : D3D9SpecConstantId::PixelShaderBools));
-    m_module.setDebugName(m_boolSpecConstant, "boolConstants");
   }
 
   template<DxsoConstantBufferType ConstantBufferType>
@@ -534,22 +545,6 @@ namespace dxvk {
     m_ps.functionId = m_module.allocateId();
     m_module.setDebugName(m_ps.functionId, "ps_main");
 
-    if (m_programInfo.majorVersion() < 2 || m_moduleInfo.options.forceSamplerTypeSpecConstants) {
-      m_ps.samplerTypeSpec = m_module.specConst32(m_module.defIntType(32, 0), 0);
-      m_module.decorateSpecId(m_ps.samplerTypeSpec, getSpecId(D3D9SpecConstantId::SamplerType));
-      m_module.setDebugName(m_ps.samplerTypeSpec, "s_sampler_types");
-
-      if (m_programInfo.majorVersion() < 2) {
-        m_ps.projectionSpec = m_module.specConst32(m_module.defIntType(32, 0), 0);
-        m_module.decorateSpecId(m_ps.projectionSpec, getSpecId(D3D9SpecConstantId::ProjectionType));
-        m_module.setDebugName(m_ps.projectionSpec, "s_projections");
-      }
-    }
-
-    m_ps.fetch4Spec = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.decorateSpecId(m_ps.fetch4Spec, getSpecId(D3D9SpecConstantId::Fetch4));
-    m_module.setDebugName(m_ps.fetch4Spec, "s_fetch4");
-
     this->setupRenderStateInfo();
     this->emitPsSharedConstants();
 
@@ -993,7 +988,15 @@ namespace dxvk {
       default: break;
     }
 
-    uint32_t relativeIdx = this->emitArrayIndex(reg.id.num, relative);
+    uint32_t constIdx = reg.id.num;
+
+    if (reg.id.type == DxsoRegisterType::Const && m_meta.packedConstantsF) {
+      constIdx = constIdx < m_constantSlotsF.size()
+        ? m_constantSlotsF[constIdx]
+        : m_layout->floatCount;
+    }
+
+    uint32_t relativeIdx = this->emitArrayIndex(constIdx, relative);
 
     if (reg.id.type != DxsoRegisterType::ConstBool) {
       uint32_t structIdx;
@@ -1062,7 +1065,10 @@ namespace dxvk {
         bitfield = m_module.opLoad(accessType, ptrId);
       }
       else
-        bitfield = m_boolSpecConstant;
+        bitfield = m_spec.get(m_module, m_specUbo,
+          m_programInfo.type() == DxsoProgramType::VertexShader
+            ? D3D9SpecConstantId::VertexShaderBools
+            : D3D9SpecConstantId::PixelShaderBools);
 
       uint32_t bitIdx = m_module.consti32(reg.id.num % 32);
 
@@ -2795,7 +2801,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       uint32_t bool_t = m_module.defBoolType();
 
       uint32_t shouldProj = m_module.opBitFieldUExtract(
-        m_module.defIntType(32, 0), m_ps.projectionSpec,
+        m_module.defIntType(32, 0), m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::ProjectionType),
         m_module.consti32(samplerIdx), m_module.consti32(1));
 
       shouldProj = m_module.opIEqual(bool_t, shouldProj, m_module.constu32(1));
@@ -2962,7 +2968,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       uint32_t fetch4 = 0;
       if (m_programInfo.type() == DxsoProgramType::PixelShader && samplerType != SamplerTypeTexture3D) {
         fetch4 = m_module.opBitFieldUExtract(
-          m_module.defIntType(32, 0), m_ps.fetch4Spec,
+          m_module.defIntType(32, 0), m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::Fetch4),
           m_module.consti32(samplerIdx), m_module.consti32(1));
 
         uint32_t bool_t = m_module.defBoolType();
@@ -2995,7 +3001,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
           imageOperands);
 
         uint32_t shouldProj = m_module.opBitFieldUExtract(
-          m_module.defIntType(32, 0), m_ps.projectionSpec,
+          m_module.defIntType(32, 0), m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::ProjectionType),
           m_module.consti32(samplerIdx), m_module.consti32(1));
 
         shouldProj = m_module.opIEqual(m_module.defBoolType(), shouldProj, m_module.constu32(1));
@@ -3058,7 +3064,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       uint32_t offset  = m_module.consti32(m_programInfo.type() == DxsoProgramTypes::VertexShader ? samplerIdx + 17 : samplerIdx);
       uint32_t bitCnt  = m_module.consti32(1);
 
-      uint32_t isNull = m_module.opBitFieldUExtract(typeId, m_nullSpecConstant, offset, bitCnt);
+      uint32_t isNull = m_module.opBitFieldUExtract(typeId, m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::SamplerNull), offset, bitCnt);
       isNull = m_module.opIEqual(m_module.defBoolType(), isNull, m_module.constu32(1));
 
       // Only do the check for depth comp. samplers
@@ -3068,7 +3074,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
         uint32_t depthLabel  = m_module.allocateId();
         uint32_t endLabel    = m_module.allocateId();
 
-        uint32_t isDepth = m_module.opBitFieldUExtract(typeId, m_depthSpecConstant, offset, bitCnt);
+        uint32_t isDepth = m_module.opBitFieldUExtract(typeId, m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::SamplerDepthMode), offset, bitCnt);
         isDepth = m_module.opIEqual(m_module.defBoolType(), isDepth, m_module.constu32(1));
 
         m_module.opSelectionMerge(endLabel, spv::SelectionControlMaskNone);
@@ -3108,7 +3114,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
 
       uint32_t offset  = m_module.consti32(samplerIdx * 2);
       uint32_t bitCnt  = m_module.consti32(2);
-      uint32_t type    = m_module.opBitFieldUExtract(typeId, m_ps.samplerTypeSpec, offset, bitCnt);
+      uint32_t type    = m_module.opBitFieldUExtract(typeId, m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::SamplerType), offset, bitCnt);
 
       m_module.opSelectionMerge(switchEndLabel, spv::SelectionControlMaskNone);
       m_module.opSwitch(type,
@@ -3372,7 +3378,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
 
     if (m_programInfo.type() == DxsoProgramType::PixelShader) {
       pointCoord = GetPointCoord(m_module, m_entryPointInterfaces);
-      pointInfo  = GetPointSizeInfoPS(m_module, m_rsBlock);
+      pointInfo  = GetPointSizeInfoPS(m_spec, m_module, m_rsBlock, m_specUbo);
     }
 
     for (uint32_t i = 0; i < m_isgn.elemCount; i++) {
@@ -3607,7 +3613,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     if (!outputtedColor1)
       OutputDefault(DxsoSemantic{ DxsoUsage::Color, 1 });
 
-    auto pointInfo = GetPointSizeInfoVS(m_module, m_vs.oPos.id, 0, 0, m_rsBlock, false);
+    auto pointInfo = GetPointSizeInfoVS(m_spec, m_module, m_vs.oPos.id, 0, 0, m_rsBlock, m_specUbo, false);
 
     if (m_vs.oPSize.id == 0) {
       m_vs.oPSize = this->emitRegisterPtr(
@@ -3654,10 +3660,17 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     m_module.decorateDescriptorSet(clipPlaneBlock, 0);
     m_module.decorateBinding      (clipPlaneBlock, bindingId);
     
+    // Inline uniform blocks use the same SPIR-V declaration
+    // as uniform buffers, only the descriptor type differs
     DxvkBindingInfo binding = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
     binding.resourceBinding = bindingId;
     binding.viewType        = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
     binding.access          = VK_ACCESS_UNIFORM_READ_BIT;
+    binding.uniformSize     = caps::MaxClipPlanes * 4 * sizeof(float);
+
+    if (m_moduleInfo.options.inlineClipPlanes)
+      binding.descriptorType = VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT;
+
     m_bindings.push_back(binding);
 
     // Declare output array for clip distances
@@ -3732,6 +3745,8 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     }
 
     m_rsBlock = SetupRenderStateBlock(m_module, count);
+    m_specUbo = SetupSpecUBO(m_module, m_bindings);
+    m_spec.declareFallback(m_module);
   }
 
 
@@ -3752,6 +3767,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     fogCtx.IsPixel     = true;
     fogCtx.RangeFog    = false;
     fogCtx.RenderState = m_rsBlock;
+    fogCtx.SpecUBO     = m_specUbo;
     fogCtx.vPos        = m_module.opLoad(getVectorTypeId(vPosPtr.type),    vPosPtr.id);
     fogCtx.vFog        = m_module.opLoad(getVectorTypeId(vFogPtr.type),    vFogPtr.id);
     fogCtx.oColor      = m_module.opLoad(getVectorTypeId(oColor0Ptr.type), oColor0Ptr.id);
@@ -3760,7 +3776,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     fogCtx.HasSpecular = false;
     fogCtx.Specular    = 0;
 
-    m_module.opStore(oColor0Ptr.id, DoFixedFunctionFog(m_module, fogCtx));
+    m_module.opStore(oColor0Ptr.id, DoFixedFunctionFog(m_spec, m_module, fogCtx));
   }
 
   
@@ -3769,9 +3785,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     uint32_t floatType = m_module.defFloatType(32);
     uint32_t floatPtr  = m_module.defPointerType(floatType, spv::StorageClassPushConstant);
     
-    uint32_t alphaFuncId = m_module.specConst32(m_module.defIntType(32, 0), 0);
-    m_module.setDebugName   (alphaFuncId, "alpha_func");
-    m_module.decorateSpecId (alphaFuncId, getSpecId(D3D9SpecConstantId::AlphaCompareOp));
+    uint32_t alphaFuncId = m_spec.get(m_module, m_specUbo, D3D9SpecConstantId::AlphaCompareOp);
 
     // Implement alpha test and fog
     DxsoRegister color0;
@@ -8,7 +8,9 @@
 
 #include "../d3d9/d3d9_constant_layout.h"
 #include "../d3d9/d3d9_shader_permutations.h"
+#include "../d3d9/d3d9_spec_constants.h"
 #include "../spirv/spirv_module.h"
+#include "../spirv/spirv_optimizer.h"
 
 namespace dxvk {
 
@@ -155,9 +157,6 @@ namespace dxvk {
    */
   struct DxsoCompilerPsPart {
     uint32_t functionId         = 0;
-    uint32_t samplerTypeSpec    = 0;
-    uint32_t projectionSpec     = 0;
-    uint32_t fetch4Spec         = 0;
 
     //////////////
     // Misc Types
@@ -255,6 +254,7 @@ namespace dxvk {
     uint32_t usedSamplers() const { return m_usedSamplers; }
     uint32_t usedRTs() const { return m_usedRTs; }
     uint32_t maxDefinedConstant() const { return m_maxDefinedConstant; }
+    const DxsoPackedConstants& packedConstantsF() { return m_packedConstantsF; }
 
   private:
 
@@ -267,11 +267,16 @@ namespace dxvk {
     DxsoDefinedConstants       m_constants;
     uint32_t                   m_maxDefinedConstant;
 
+    // Float constant buffer slot for each c# register,
+    // only used if float constants are packed.
+    DxsoPackedConstants        m_packedConstantsF;
+    std::vector<uint32_t>      m_constantSlotsF;
+
     SpirvModule                m_module;
 
-    uint32_t                   m_boolSpecConstant;
-    uint32_t                   m_nullSpecConstant;
-    uint32_t                   m_depthSpecConstant;
+    uint32_t                   m_specUbo = 0;
+
+    D3D9ShaderSpecConstantManager m_spec;
 
     ///////////////////////////////////////////////////////
     // Resource slot description for the shader. This will
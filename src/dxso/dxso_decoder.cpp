@@ -139,6 +139,8 @@ namespace dxvk {
 
     uint32_t token = iter.read();
 
+    m_ctx.srcCount = i + 1;
+
     this->decodeGenericRegister(m_ctx.src[i], token);
 
     m_ctx.src[i].swizzle = DxsoRegSwizzle(
@@ -176,6 +178,7 @@ namespace dxvk {
     uint32_t token = iter.read();
 
     m_ctx.instructionIdx++;
+    m_ctx.srcCount = 0;
 
     m_ctx.instruction.opcode = static_cast<DxsoOpcode>(
       token & 0x0000ffff);
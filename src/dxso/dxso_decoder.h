@@ -203,6 +203,7 @@ namespace dxvk {
     std::array<
       DxsoRegister,
       DxsoMaxOperandCount>      src;
+    uint32_t                    srcCount;
 
     DxsoDefinition              def;
 
@@ -29,8 +29,13 @@ namespace dxvk {
 
   using DxsoDefinedConstants = std::vector<DxsoDefinedConstant>;
 
+  // Float constant registers in the order in which they
+  // are stored in a compacted constant buffer.
+  using DxsoPackedConstants = std::vector<uint32_t>;
+
   struct DxsoShaderMetaInfo {
     bool needsConstantCopies = false;
+    bool packedConstantsF = false;
     uint32_t maxConstIndexF = 0;
     uint32_t maxConstIndexI = 0;
     uint32_t maxConstIndexB = 0;
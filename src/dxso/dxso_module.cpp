@@ -26,6 +26,8 @@ namespace dxvk {
     const std::string&        fileName,
     const DxsoAnalysisInfo&   analysis,
     const D3D9ConstantLayout& layout) {
+    DXVK_TRACE_SCOPE("DxsoModule::compile");
+
     auto compiler = std::make_unique<DxsoCompiler>(
       fileName, moduleInfo,
       m_header.info(), analysis,
@@ -37,6 +39,7 @@ namespace dxvk {
     m_meta            = compiler->meta();
     m_constants       = compiler->constants();
     m_maxDefinedConst = compiler->maxDefinedConstant();
+    m_packedConstsF   = compiler->packedConstantsF();
     m_usedSamplers    = compiler->usedSamplers();
     m_usedRTs         = compiler->usedRTs();
 
@@ -47,14 +50,19 @@ namespace dxvk {
 
   void DxsoModule::runAnalyzer(
           DxsoAnalyzer&       analyzer,
-          DxsoCodeIter        iter) const {
+          DxsoCodeIter        iter) {
     DxsoCodeIter start = iter;
 
     DxsoDecodeContext decoder(m_header.info());
 
-    while (decoder.decodeInstruction(iter))
-      analyzer.processInstruction(
-        decoder.getInstructionContext());
+    m_instructions.clear();
+
+    while (decoder.decodeInstruction(iter)) {
+      const DxsoInstructionContext& ctx = decoder.getInstructionContext();
+      analyzer.processInstruction(ctx);
+
+      m_instructions.push_back(ctx);
+    }
 
     size_t tokenCount = size_t(iter.ptrAt(0) - start.ptrAt(0));
 
@@ -77,6 +85,13 @@ namespace dxvk {
   void DxsoModule::runCompiler(
           DxsoCompiler&       compiler,
           DxsoCodeIter        iter) const {
+    // Reuse the instruction stream decoded during analysis
+    if (!m_instructions.empty()) {
+      for (const auto& ins : m_instructions)
+        compiler.processInstruction(ins);
+      return;
+    }
+
     DxsoDecodeContext decoder(m_header.info());
 
     while (decoder.decodeInstruction(iter))
@@ -32,11 +32,21 @@ namespace dxvk {
       return m_header.info();
     }
 
+    /**
+     * \brief Analyzes the shader
+     *
+     * Also keeps the decoded instruction stream around, so
+     * that subsequent compilation does not have to decode
+     * the bytecode again.
+     * \returns Analysis info
+     */
     DxsoAnalysisInfo analyze();
 
     /**
      * \brief Compiles DXSO shader to SPIR-V module
      * 
+     * Uses the instructions decoded by \c analyze. All shader
+     * permutations are emitted by the same compiler instance.
      * \param [in] moduleInfo DXSO module info
      * \param [in] fileName File name, will be added to
      *        the compiled SPIR-V for debugging purposes.
@@ -62,6 +72,8 @@ namespace dxvk {
 
     uint32_t maxDefinedConstant() { return m_maxDefinedConst; }
 
+    const DxsoPackedConstants& packedConstantsF() { return m_packedConstsF; }
+
   private:
 
     void runCompiler(
@@ -70,11 +82,13 @@ namespace dxvk {
 
     void runAnalyzer(
             DxsoAnalyzer&       analyzer,
-            DxsoCodeIter        iter) const;
+            DxsoCodeIter        iter);
 
     DxsoHeader      m_header;
     DxsoCode        m_code;
 
+    std::vector<DxsoInstructionContext> m_instructions;
+
     DxsoIsgn        m_isgn;
     uint32_t        m_usedSamplers;
     uint32_t        m_usedRTs;
@@ -82,6 +96,7 @@ namespace dxvk {
     DxsoShaderMetaInfo   m_meta;
     uint32_t             m_maxDefinedConst;
     DxsoDefinedConstants m_constants;
+    DxsoPackedConstants  m_packedConstsF;
 
   };
 
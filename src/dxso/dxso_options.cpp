@@ -45,6 +45,10 @@ namespace dxvk {
     alphaTestWiggleRoom = options.alphaTestWiggleRoom;
 
     robustness2Supported = devFeatures.extRobustness2.robustBufferAccess2;
+
+    optimizeSpirv = device->config().optimizeSpirv;
+
+    inlineClipPlanes = options.inlineClipPlanes;
   }
 
 }
\ No newline at end of file
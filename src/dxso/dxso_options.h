@@ -57,6 +57,12 @@ namespace dxvk {
 
     /// Whether or not we can rely on robustness2 to handle oob constant access
     bool robustness2Supported;
+
+    /// Run the SPIR-V optimizer on translated shaders
+    bool optimizeSpirv = false;
+
+    /// Declare clip planes as an inline uniform block
+    bool inlineClipPlanes = false;
   };
 
 }
\ No newline at end of file
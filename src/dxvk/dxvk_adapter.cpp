@@ -65,8 +65,19 @@ namespace dxvk {
   
   
   VkFormatProperties DxvkAdapter::formatProperties(VkFormat format) const {
+    // Format support is queried a lot during device and resource
+    // creation, and it cannot change, so only query each format once
+    std::lock_guard<dxvk::mutex> lock(m_formatMutex);
+
+    auto entry = m_formatProperties.find(format);
+
+    if (entry != m_formatProperties.end())
+      return entry->second;
+
     VkFormatProperties formatProperties;
     m_vki->vkGetPhysicalDeviceFormatProperties(m_handle, format, &formatProperties);
+
+    m_formatProperties.insert({ format, formatProperties });
     return formatProperties;
   }
   
@@ -78,8 +89,22 @@ namespace dxvk {
     VkImageUsageFlags         usage,
     VkImageCreateFlags        flags,
     VkImageFormatProperties&  properties) const {
-    return m_vki->vkGetPhysicalDeviceImageFormatProperties(
-      m_handle, format, type, tiling, usage, flags, &properties);
+    DxvkImageFormatQuery query = { format, type, tiling, usage, flags };
+
+    std::lock_guard<dxvk::mutex> lock(m_formatMutex);
+
+    auto entry = m_imageFormatProperties.find(query);
+
+    if (entry == m_imageFormatProperties.end()) {
+      DxvkImageFormatResult result;
+      result.status = m_vki->vkGetPhysicalDeviceImageFormatProperties(
+        m_handle, format, type, tiling, usage, flags, &result.properties);
+
+      entry = m_imageFormatProperties.insert({ query, result }).first;
+    }
+
+    properties = entry->second.properties;
+    return entry->second.status;
   }
   
     
@@ -234,10 +259,20 @@ namespace dxvk {
                 || !required.extDepthClipEnable.depthClipEnable)
         && (m_deviceFeatures.extExtendedDynamicState.extendedDynamicState
                 || !required.extExtendedDynamicState.extendedDynamicState)
+        && (m_deviceFeatures.extExtendedDynamicState2.extendedDynamicState2
+                || !required.extExtendedDynamicState2.extendedDynamicState2)
+        && (m_deviceFeatures.extExtendedDynamicState2.extendedDynamicState2LogicOp
+                || !required.extExtendedDynamicState2.extendedDynamicState2LogicOp)
+        && (m_deviceFeatures.extGraphicsPipelineLibrary.graphicsPipelineLibrary
+                || !required.extGraphicsPipelineLibrary.graphicsPipelineLibrary)
         && (m_deviceFeatures.extHostQueryReset.hostQueryReset
                 || !required.extHostQueryReset.hostQueryReset)
+        && (m_deviceFeatures.extInlineUniformBlock.inlineUniformBlock
+                || !required.extInlineUniformBlock.inlineUniformBlock)
         && (m_deviceFeatures.extMemoryPriority.memoryPriority
                 || !required.extMemoryPriority.memoryPriority)
+        && (m_deviceFeatures.extMultiDraw.multiDraw
+                || !required.extMultiDraw.multiDraw)
         && (m_deviceFeatures.extNonSeamlessCubeMap.nonSeamlessCubeMap
                 || !required.extNonSeamlessCubeMap.nonSeamlessCubeMap)
         && (m_deviceFeatures.extRobustness2.robustBufferAccess2
@@ -251,7 +286,13 @@ namespace dxvk {
         && (m_deviceFeatures.extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor
                 || !required.extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor)
         && (m_deviceFeatures.extVertexAttributeDivisor.vertexAttributeInstanceRateZeroDivisor
-                || !required.extVertexAttributeDivisor.vertexAttributeInstanceRateZeroDivisor);
+                || !required.extVertexAttributeDivisor.vertexAttributeInstanceRateZeroDivisor)
+        && (m_deviceFeatures.extVertexInputDynamicState.vertexInputDynamicState
+                || !required.extVertexInputDynamicState.vertexInputDynamicState)
+        && (m_deviceFeatures.khrPresentId.presentId
+                || !required.khrPresentId.presentId)
+        && (m_deviceFeatures.khrPresentWait.presentWait
+                || !required.khrPresentWait.presentWait);
   }
   
   
@@ -265,18 +306,23 @@ namespace dxvk {
           DxvkDeviceFeatures  enabledFeatures) {
     DxvkDeviceExtensions devExtensions;
 
-    std::array<DxvkExt*, 31> devExtensionList = {{
+    std::array<DxvkExt*, 43> devExtensionList = {{
       &devExtensions.amdMemoryOverallocationBehaviour,
       &devExtensions.amdShaderFragmentMask,
       &devExtensions.ext4444Formats,
+      &devExtensions.extCalibratedTimestamps,
       &devExtensions.extConservativeRasterization,
       &devExtensions.extCustomBorderColor,
       &devExtensions.extDepthClipEnable,
       &devExtensions.extExtendedDynamicState,
+      &devExtensions.extExtendedDynamicState2,
       &devExtensions.extFullScreenExclusive,
+      &devExtensions.extGraphicsPipelineLibrary,
       &devExtensions.extHostQueryReset,
+      &devExtensions.extInlineUniformBlock,
       &devExtensions.extMemoryBudget,
       &devExtensions.extMemoryPriority,
+      &devExtensions.extMultiDraw,
       &devExtensions.extNonSeamlessCubeMap,
       &devExtensions.extRobustness2,
       &devExtensions.extShaderDemoteToHelperInvocation,
@@ -284,6 +330,7 @@ namespace dxvk {
       &devExtensions.extShaderViewportIndexLayer,
       &devExtensions.extTransformFeedback,
       &devExtensions.extVertexAttributeDivisor,
+      &devExtensions.extVertexInputDynamicState,
       &devExtensions.khrBufferDeviceAddress,
       &devExtensions.khrCreateRenderPass2,
       &devExtensions.khrDepthStencilResolve,
@@ -291,10 +338,18 @@ namespace dxvk {
       &devExtensions.khrDriverProperties,
       &devExtensions.khrDynamicRendering,
       &devExtensions.khrExternalMemoryWin32,
+      &devExtensions.khrExternalSemaphoreWin32,
       &devExtensions.khrImageFormatList,
+      &devExtensions.khrIncrementalPresent,
+      &devExtensions.khrPipelineLibrary,
+      &devExtensions.khrPresentId,
+      &devExtensions.khrPresentWait,
+      &devExtensions.khrPushDescriptor,
       &devExtensions.khrSamplerMirrorClampToEdge,
       &devExtensions.khrShaderFloatControls,
       &devExtensions.khrSwapchain,
+      &devExtensions.khrSynchronization2,
+      &devExtensions.khrTimelineSemaphore,
       &devExtensions.nvxBinaryImport,
       &devExtensions.nvxImageViewHandle,
     }};
@@ -315,6 +370,18 @@ namespace dxvk {
       enabledFeatures.khrBufferDeviceAddress.bufferDeviceAddress = VK_TRUE;
     }
 
+    // Buffer device addresses for shaders are opt-in for the same reason
+    if (instance->options().enableBufferDeviceAddress
+     && m_deviceFeatures.khrBufferDeviceAddress.bufferDeviceAddress) {
+      devExtensions.khrBufferDeviceAddress.setMode(DxvkExtMode::Optional);
+
+      enabledFeatures.khrBufferDeviceAddress.bufferDeviceAddress = VK_TRUE;
+    }
+
+    // Graphics pipeline libraries depend on VK_KHR_pipeline_library
+    if (!m_deviceExtensions.supports(devExtensions.khrPipelineLibrary.name()))
+      devExtensions.extGraphicsPipelineLibrary.setMode(DxvkExtMode::Disabled);
+
     DxvkNameSet extensionsEnabled;
 
     if (!m_deviceExtensions.enableExtensions(
@@ -330,13 +397,51 @@ namespace dxvk {
     // Enable additional device features if supported
     enabledFeatures.extExtendedDynamicState.extendedDynamicState = VK_TRUE;
 
+    enabledFeatures.extExtendedDynamicState2.extendedDynamicState2 =
+      devExtensions.extExtendedDynamicState2 &&
+      m_deviceFeatures.extExtendedDynamicState2.extendedDynamicState2;
+
+    enabledFeatures.extExtendedDynamicState2.extendedDynamicState2LogicOp =
+      devExtensions.extExtendedDynamicState2 &&
+      m_deviceFeatures.extExtendedDynamicState2.extendedDynamicState2LogicOp;
+
     enabledFeatures.ext4444Formats.formatA4B4G4R4 = m_deviceFeatures.ext4444Formats.formatA4B4G4R4;
     enabledFeatures.ext4444Formats.formatA4R4G4B4 = m_deviceFeatures.ext4444Formats.formatA4R4G4B4;
     
+    enabledFeatures.extGraphicsPipelineLibrary.graphicsPipelineLibrary =
+      devExtensions.extGraphicsPipelineLibrary &&
+      m_deviceFeatures.extGraphicsPipelineLibrary.graphicsPipelineLibrary;
+
+    enabledFeatures.extInlineUniformBlock.inlineUniformBlock =
+      devExtensions.extInlineUniformBlock &&
+      m_deviceFeatures.extInlineUniformBlock.inlineUniformBlock;
+
     enabledFeatures.extRobustness2.nullDescriptor = VK_TRUE;
 
+    enabledFeatures.extVertexInputDynamicState.vertexInputDynamicState =
+      devExtensions.extVertexInputDynamicState &&
+      m_deviceFeatures.extVertexInputDynamicState.vertexInputDynamicState;
+
     enabledFeatures.khrDynamicRendering.dynamicRendering = VK_TRUE;
 
+    // Present wait requires present IDs, so only
+    // enable the features if both are supported
+    enabledFeatures.khrPresentId.presentId =
+      devExtensions.khrPresentId && devExtensions.khrPresentWait &&
+      m_deviceFeatures.khrPresentId.presentId &&
+      m_deviceFeatures.khrPresentWait.presentWait;
+
+    enabledFeatures.khrPresentWait.presentWait =
+      enabledFeatures.khrPresentId.presentId;
+
+    enabledFeatures.khrSynchronization2.synchronization2 =
+      devExtensions.khrSynchronization2 &&
+      m_deviceFeatures.khrSynchronization2.synchronization2;
+
+    enabledFeatures.khrTimelineSemaphore.timelineSemaphore =
+      devExtensions.khrTimelineSemaphore &&
+      m_deviceFeatures.khrTimelineSemaphore.timelineSemaphore;
+
     Logger::info(str::format("Device properties:"
       "\n  Device name:     : ", m_deviceInfo.core.properties.deviceName,
       "\n  Driver version   : ",
@@ -375,16 +480,36 @@ namespace dxvk {
       enabledFeatures.extExtendedDynamicState.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extExtendedDynamicState);
     }
 
+    if (devExtensions.extExtendedDynamicState2) {
+      enabledFeatures.extExtendedDynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+      enabledFeatures.extExtendedDynamicState2.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extExtendedDynamicState2);
+    }
+
+    if (devExtensions.extGraphicsPipelineLibrary) {
+      enabledFeatures.extGraphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+      enabledFeatures.extGraphicsPipelineLibrary.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extGraphicsPipelineLibrary);
+    }
+
     if (devExtensions.extHostQueryReset) {
       enabledFeatures.extHostQueryReset.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT;
       enabledFeatures.extHostQueryReset.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extHostQueryReset);
     }
 
+    if (devExtensions.extInlineUniformBlock) {
+      enabledFeatures.extInlineUniformBlock.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INLINE_UNIFORM_BLOCK_FEATURES_EXT;
+      enabledFeatures.extInlineUniformBlock.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extInlineUniformBlock);
+    }
+
     if (devExtensions.extMemoryPriority) {
       enabledFeatures.extMemoryPriority.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT;
       enabledFeatures.extMemoryPriority.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extMemoryPriority);
     }
 
+    if (devExtensions.extMultiDraw) {
+      enabledFeatures.extMultiDraw.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_FEATURES_EXT;
+      enabledFeatures.extMultiDraw.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extMultiDraw);
+    }
+
     if (devExtensions.extNonSeamlessCubeMap) {
       enabledFeatures.extNonSeamlessCubeMap.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_NON_SEAMLESS_CUBE_MAP_FEATURES_EXT;
       enabledFeatures.extNonSeamlessCubeMap.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extNonSeamlessCubeMap);
@@ -410,6 +535,11 @@ namespace dxvk {
       enabledFeatures.extVertexAttributeDivisor.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extVertexAttributeDivisor);
     }
 
+    if (devExtensions.extVertexInputDynamicState) {
+      enabledFeatures.extVertexInputDynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_INPUT_DYNAMIC_STATE_FEATURES_EXT;
+      enabledFeatures.extVertexInputDynamicState.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.extVertexInputDynamicState);
+    }
+
     if (devExtensions.khrBufferDeviceAddress) {
       enabledFeatures.khrBufferDeviceAddress.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
       enabledFeatures.khrBufferDeviceAddress.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrBufferDeviceAddress);
@@ -420,6 +550,26 @@ namespace dxvk {
       enabledFeatures.khrDynamicRendering.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrDynamicRendering);
     }
 
+    if (devExtensions.khrPresentId) {
+      enabledFeatures.khrPresentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+      enabledFeatures.khrPresentId.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrPresentId);
+    }
+
+    if (devExtensions.khrPresentWait) {
+      enabledFeatures.khrPresentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+      enabledFeatures.khrPresentWait.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrPresentWait);
+    }
+
+    if (devExtensions.khrSynchronization2) {
+      enabledFeatures.khrSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+      enabledFeatures.khrSynchronization2.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrSynchronization2);
+    }
+
+    if (devExtensions.khrTimelineSemaphore) {
+      enabledFeatures.khrTimelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+      enabledFeatures.khrTimelineSemaphore.pNext = std::exchange(enabledFeatures.core.pNext, &enabledFeatures.khrTimelineSemaphore);
+    }
+
     // Report the desired overallocation behaviour to the driver
     VkDeviceMemoryOverallocationCreateInfoAMD overallocInfo;
     overallocInfo.sType = VK_STRUCTURE_TYPE_DEVICE_MEMORY_OVERALLOCATION_CREATE_INFO_AMD;
@@ -572,6 +722,19 @@ namespace dxvk {
 
     return result;
   }
+
+
+  bool DxvkAdapter::hasLazilyAllocatedMemory(uint32_t memoryTypeBits) const {
+    auto memory = this->memoryProperties();
+
+    for (uint32_t i = 0; i < memory.memoryTypeCount; i++) {
+      if ((memoryTypeBits & (1u << i))
+       && (memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+        return true;
+    }
+
+    return false;
+  }
   
   
   void DxvkAdapter::initHeapAllocInfo() {
@@ -609,6 +772,21 @@ namespace dxvk {
       m_deviceInfo.extCustomBorderColor.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.extCustomBorderColor);
     }
 
+    if (m_deviceExtensions.supports(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+      m_deviceInfo.extGraphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+      m_deviceInfo.extGraphicsPipelineLibrary.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.extGraphicsPipelineLibrary);
+    }
+
+    if (m_deviceExtensions.supports(VK_EXT_INLINE_UNIFORM_BLOCK_EXTENSION_NAME)) {
+      m_deviceInfo.extInlineUniformBlock.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INLINE_UNIFORM_BLOCK_PROPERTIES_EXT;
+      m_deviceInfo.extInlineUniformBlock.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.extInlineUniformBlock);
+    }
+
+    if (m_deviceExtensions.supports(VK_EXT_MULTI_DRAW_EXTENSION_NAME)) {
+      m_deviceInfo.extMultiDraw.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_PROPERTIES_EXT;
+      m_deviceInfo.extMultiDraw.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.extMultiDraw);
+    }
+
     if (m_deviceExtensions.supports(VK_EXT_ROBUSTNESS_2_EXTENSION_NAME)) {
       m_deviceInfo.extRobustness2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_PROPERTIES_EXT;
       m_deviceInfo.extRobustness2.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.extRobustness2);
@@ -634,6 +812,11 @@ namespace dxvk {
       m_deviceInfo.khrDeviceDriverProperties.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.khrDeviceDriverProperties);
     }
 
+    if (m_deviceExtensions.supports(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+      m_deviceInfo.khrPushDescriptor.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+      m_deviceInfo.khrPushDescriptor.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.khrPushDescriptor);
+    }
+
     if (m_deviceExtensions.supports(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME)) {
       m_deviceInfo.khrShaderFloatControls.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FLOAT_CONTROLS_PROPERTIES_KHR;
       m_deviceInfo.khrShaderFloatControls.pNext = std::exchange(m_deviceInfo.core.pNext, &m_deviceInfo.khrShaderFloatControls);
@@ -690,16 +873,36 @@ namespace dxvk {
       m_deviceFeatures.extExtendedDynamicState.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extExtendedDynamicState);
     }
 
+    if (m_deviceExtensions.supports(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+      m_deviceFeatures.extExtendedDynamicState2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+      m_deviceFeatures.extExtendedDynamicState2.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extExtendedDynamicState2);
+    }
+
+    if (m_deviceExtensions.supports(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+      m_deviceFeatures.extGraphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+      m_deviceFeatures.extGraphicsPipelineLibrary.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extGraphicsPipelineLibrary);
+    }
+
     if (m_deviceExtensions.supports(VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME)) {
       m_deviceFeatures.extHostQueryReset.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT;
       m_deviceFeatures.extHostQueryReset.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extHostQueryReset);
     }
 
+    if (m_deviceExtensions.supports(VK_EXT_INLINE_UNIFORM_BLOCK_EXTENSION_NAME)) {
+      m_deviceFeatures.extInlineUniformBlock.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INLINE_UNIFORM_BLOCK_FEATURES_EXT;
+      m_deviceFeatures.extInlineUniformBlock.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extInlineUniformBlock);
+    }
+
     if (m_deviceExtensions.supports(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME)) {
       m_deviceFeatures.extMemoryPriority.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT;
       m_deviceFeatures.extMemoryPriority.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extMemoryPriority);
     }
 
+    if (m_deviceExtensions.supports(VK_EXT_MULTI_DRAW_EXTENSION_NAME)) {
+      m_deviceFeatures.extMultiDraw.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_FEATURES_EXT;
+      m_deviceFeatures.extMultiDraw.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extMultiDraw);
+    }
+
     if (m_deviceExtensions.supports(VK_EXT_NON_SEAMLESS_CUBE_MAP_EXTENSION_NAME)) {
       m_deviceFeatures.extNonSeamlessCubeMap.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_NON_SEAMLESS_CUBE_MAP_FEATURES_EXT;
       m_deviceFeatures.extNonSeamlessCubeMap.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extNonSeamlessCubeMap);
@@ -725,6 +928,11 @@ namespace dxvk {
       m_deviceFeatures.extVertexAttributeDivisor.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extVertexAttributeDivisor);
     }
 
+    if (m_deviceExtensions.supports(VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME)) {
+      m_deviceFeatures.extVertexInputDynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_INPUT_DYNAMIC_STATE_FEATURES_EXT;
+      m_deviceFeatures.extVertexInputDynamicState.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.extVertexInputDynamicState);
+    }
+
     if (m_deviceExtensions.supports(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)) {
       m_deviceFeatures.khrBufferDeviceAddress.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
       m_deviceFeatures.khrBufferDeviceAddress.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrBufferDeviceAddress);
@@ -735,6 +943,26 @@ namespace dxvk {
       m_deviceFeatures.khrDynamicRendering.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrDynamicRendering);
     }
 
+    if (m_deviceExtensions.supports(VK_KHR_PRESENT_ID_EXTENSION_NAME)) {
+      m_deviceFeatures.khrPresentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+      m_deviceFeatures.khrPresentId.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrPresentId);
+    }
+
+    if (m_deviceExtensions.supports(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+      m_deviceFeatures.khrPresentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+      m_deviceFeatures.khrPresentWait.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrPresentWait);
+    }
+
+    if (m_deviceExtensions.supports(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+      m_deviceFeatures.khrSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+      m_deviceFeatures.khrSynchronization2.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrSynchronization2);
+    }
+
+    if (m_deviceExtensions.supports(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+      m_deviceFeatures.khrTimelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+      m_deviceFeatures.khrTimelineSemaphore.pNext = std::exchange(m_deviceFeatures.core.pNext, &m_deviceFeatures.khrTimelineSemaphore);
+    }
+
     m_vki->vkGetPhysicalDeviceFeatures2(m_handle, &m_deviceFeatures.core);
   }
 
@@ -811,10 +1039,19 @@ namespace dxvk {
       "\n  depthClipEnable                        : ", features.extDepthClipEnable.depthClipEnable ? "1" : "0",
       "\n", VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
       "\n  extendedDynamicState                   : ", features.extExtendedDynamicState.extendedDynamicState ? "1" : "0",
+      "\n", VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME,
+      "\n  extendedDynamicState2                  : ", features.extExtendedDynamicState2.extendedDynamicState2 ? "1" : "0",
+      "\n  extendedDynamicState2LogicOp           : ", features.extExtendedDynamicState2.extendedDynamicState2LogicOp ? "1" : "0",
+      "\n", VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+      "\n  graphicsPipelineLibrary                : ", features.extGraphicsPipelineLibrary.graphicsPipelineLibrary ? "1" : "0",
       "\n", VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME,
       "\n  hostQueryReset                         : ", features.extHostQueryReset.hostQueryReset ? "1" : "0",
+      "\n", VK_EXT_INLINE_UNIFORM_BLOCK_EXTENSION_NAME,
+      "\n  inlineUniformBlock                     : ", features.extInlineUniformBlock.inlineUniformBlock ? "1" : "0",
       "\n", VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME,
       "\n  memoryPriority                         : ", features.extMemoryPriority.memoryPriority ? "1" : "0",
+      "\n", VK_EXT_MULTI_DRAW_EXTENSION_NAME,
+      "\n  multiDraw                              : ", features.extMultiDraw.multiDraw ? "1" : "0",
       "\n", VK_EXT_NON_SEAMLESS_CUBE_MAP_EXTENSION_NAME,
       "\n  nonSeamlessCubeMap                     : ", features.extNonSeamlessCubeMap.nonSeamlessCubeMap ? "1" : "0",
       "\n", VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
@@ -829,10 +1066,20 @@ namespace dxvk {
       "\n", VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME,
       "\n  vertexAttributeInstanceRateDivisor     : ", features.extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor ? "1" : "0",
       "\n  vertexAttributeInstanceRateZeroDivisor : ", features.extVertexAttributeDivisor.vertexAttributeInstanceRateZeroDivisor ? "1" : "0",
+      "\n", VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME,
+      "\n  vertexInputDynamicState                : ", features.extVertexInputDynamicState.vertexInputDynamicState ? "1" : "0",
       "\n", VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
       "\n  bufferDeviceAddress                    : ", features.khrBufferDeviceAddress.bufferDeviceAddress ? "1" : "0",
       "\n", VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
-      "\n  dynamicRendering                       : ", features.khrDynamicRendering.dynamicRendering ? "1" : "0"));
+      "\n  dynamicRendering                       : ", features.khrDynamicRendering.dynamicRendering ? "1" : "0",
+      "\n", VK_KHR_PRESENT_ID_EXTENSION_NAME,
+      "\n  presentId                              : ", features.khrPresentId.presentId ? "1" : "0",
+      "\n", VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+      "\n  presentWait                            : ", features.khrPresentWait.presentWait ? "1" : "0",
+      "\n", VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+      "\n  synchronization2                       : ", features.khrSynchronization2.synchronization2 ? "1" : "0",
+      "\n", VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+      "\n  timelineSemaphore                      : ", features.khrTimelineSemaphore.timelineSemaphore ? "1" : "0"));
   }
 
 
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <unordered_map>
+
+#include "../util/thread.h"
+
 #include "dxvk_device_info.h"
 #include "dxvk_extensions.h"
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 
 namespace dxvk {
@@ -9,6 +14,46 @@ namespace dxvk {
   class DxvkDevice;
   class DxvkInstance;
   
+  /**
+   * \brief Image format query
+   *
+   * Parameters passed to an image format
+   * query, used to cache query results.
+   */
+  struct DxvkImageFormatQuery {
+    VkFormat                  format;
+    VkImageType               type;
+    VkImageTiling             tiling;
+    VkImageUsageFlags         usage;
+    VkImageCreateFlags        flags;
+
+    bool eq(const DxvkImageFormatQuery& other) const {
+      return format == other.format
+          && type   == other.type
+          && tiling == other.tiling
+          && usage  == other.usage
+          && flags  == other.flags;
+    }
+
+    size_t hash() const {
+      DxvkHashState hash;
+      hash.add(uint32_t(format));
+      hash.add(uint32_t(type));
+      hash.add(uint32_t(tiling));
+      hash.add(usage);
+      hash.add(flags);
+      return hash;
+    }
+  };
+
+  /**
+   * \brief Image format query result
+   */
+  struct DxvkImageFormatResult {
+    VkResult                  status;
+    VkImageFormatProperties   properties;
+  };
+
   /**
    * \brief GPU vendors
    * Based on PCIe IDs.
@@ -138,6 +183,7 @@ namespace dxvk {
     /**
      * \brief Queries format support
      * 
+     * Results are cached for the lifetime of the adapter.
      * \param [in] format The format to query
      * \returns Format support info
      */
@@ -147,6 +193,7 @@ namespace dxvk {
     /**
      * \brief Queries image format support
      * 
+     * Results are cached for the lifetime of the adapter.
      * \param [in] format Format to query
      * \param [in] type Image type
      * \param [in] tiling Image tiling
@@ -255,6 +302,18 @@ namespace dxvk {
      * \returns \c true if the system has unified memory.
      */
     bool isUnifiedMemoryArchitecture() const;
+
+    /**
+     * \brief Checks for lazily allocated memory
+     *
+     * Lazily allocated memory is typically only exposed
+     * by tiling GPUs, and can back transient attachments
+     * that never need to be written out to memory.
+     * \param [in] memoryTypeBits Memory types to consider
+     * \returns \c true if any of the given memory types
+     *    supports lazy allocation.
+     */
+    bool hasLazilyAllocatedMemory(uint32_t memoryTypeBits) const;
     
   private:
     
@@ -272,6 +331,13 @@ namespace dxvk {
 
     std::array<std::atomic<VkDeviceSize>, VK_MAX_MEMORY_HEAPS> m_heapAlloc;
 
+    mutable dxvk::mutex m_formatMutex;
+
+    mutable std::unordered_map<VkFormat, VkFormatProperties> m_formatProperties;
+
+    mutable std::unordered_map<DxvkImageFormatQuery,
+      DxvkImageFormatResult, DxvkHash, DxvkEq> m_imageFormatProperties;
+
     void initHeapAllocInfo();
     void queryExtensions();
     void queryDeviceInfo();
@@ -0,0 +1,336 @@
+#include <algorithm>
+
+#include "dxvk_allocator.h"
+
+#include "../util/util_bit.h"
+
+namespace dxvk {
+
+  DxvkTlsfAllocator::DxvkTlsfAllocator(VkDeviceSize capacity)
+  : m_capacity(capacity) {
+    m_freeLists.fill(InvalidBlock);
+
+    // Mark the entire range as free
+    if (capacity)
+      insertFreeBlock(createBlock(0, capacity));
+  }
+
+
+  DxvkTlsfAllocator::~DxvkTlsfAllocator() {
+
+  }
+
+
+  VkDeviceSize DxvkTlsfAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align,
+          uint32_t              tag) {
+    if (!size || size > m_capacity)
+      return InvalidOffset;
+
+    uint32_t blockIndex = findFreeBlock(size, align);
+
+    if (blockIndex == InvalidBlock)
+      return InvalidOffset;
+
+    removeFreeBlock(blockIndex);
+
+    Block block = m_blocks[blockIndex];
+
+    VkDeviceSize allocStart = dxvk::align(block.offset, align);
+    VkDeviceSize allocEnd   = allocStart + size;
+    VkDeviceSize blockEnd   = block.offset + block.length;
+
+    // Return the padding required for alignment to the
+    // free lists as a separate block so it can be reused
+    if (allocStart != block.offset) {
+      uint32_t padIndex = createBlock(block.offset, allocStart - block.offset);
+
+      Block& pad = m_blocks[padIndex];
+      pad.prevPhys = block.prevPhys;
+      pad.nextPhys = blockIndex;
+
+      if (pad.prevPhys != InvalidBlock)
+        m_blocks[pad.prevPhys].nextPhys = padIndex;
+
+      m_blocks[blockIndex].prevPhys = padIndex;
+      insertFreeBlock(padIndex);
+    }
+
+    // Same for the unused part at the end of the block
+    if (allocEnd != blockEnd) {
+      uint32_t tailIndex = createBlock(allocEnd, blockEnd - allocEnd);
+
+      Block& tail = m_blocks[tailIndex];
+      tail.prevPhys = blockIndex;
+      tail.nextPhys = block.nextPhys;
+
+      if (tail.nextPhys != InvalidBlock)
+        m_blocks[tail.nextPhys].prevPhys = tailIndex;
+
+      m_blocks[blockIndex].nextPhys = tailIndex;
+      insertFreeBlock(tailIndex);
+    }
+
+    Block& result = m_blocks[blockIndex];
+    result.offset = allocStart;
+    result.length = size;
+    result.tag    = tag;
+    result.isFree = false;
+
+    m_allocated.insert({ allocStart, blockIndex });
+    m_used += size;
+    return allocStart;
+  }
+
+
+  void DxvkTlsfAllocator::free(
+          VkDeviceSize          offset) {
+    auto entry = m_allocated.find(offset);
+
+    if (unlikely(entry == m_allocated.end())) {
+      Logger::err(str::format("DxvkTlsfAllocator: Invalid free at offset ", offset));
+      return;
+    }
+
+    uint32_t blockIndex = entry->second;
+    m_allocated.erase(entry);
+
+    m_used -= m_blocks[blockIndex].length;
+
+    // Merge with the following block if it is free
+    uint32_t nextIndex = m_blocks[blockIndex].nextPhys;
+
+    if (nextIndex != InvalidBlock && m_blocks[nextIndex].isFree) {
+      removeFreeBlock(nextIndex);
+
+      Block& block = m_blocks[blockIndex];
+      Block& next  = m_blocks[nextIndex];
+
+      block.length  += next.length;
+      block.nextPhys = next.nextPhys;
+
+      if (block.nextPhys != InvalidBlock)
+        m_blocks[block.nextPhys].prevPhys = blockIndex;
+
+      destroyBlock(nextIndex);
+    }
+
+    // Merge into the preceding block if it is free
+    uint32_t prevIndex = m_blocks[blockIndex].prevPhys;
+
+    if (prevIndex != InvalidBlock && m_blocks[prevIndex].isFree) {
+      removeFreeBlock(prevIndex);
+
+      Block& block = m_blocks[blockIndex];
+      Block& prev  = m_blocks[prevIndex];
+
+      prev.length  += block.length;
+      prev.nextPhys = block.nextPhys;
+
+      if (prev.nextPhys != InvalidBlock)
+        m_blocks[prev.nextPhys].prevPhys = prevIndex;
+
+      destroyBlock(blockIndex);
+      blockIndex = prevIndex;
+    }
+
+    insertFreeBlock(blockIndex);
+  }
+
+
+  std::vector<DxvkTlsfAllocator::Range> DxvkTlsfAllocator::getRanges() const {
+    std::vector<bool> unused(m_blocks.size(), false);
+
+    for (uint32_t index : m_unusedBlocks)
+      unused[index] = true;
+
+    std::vector<Range> result;
+    result.reserve(m_blocks.size() - m_unusedBlocks.size());
+
+    for (uint32_t i = 0; i < m_blocks.size(); i++) {
+      if (unused[i])
+        continue;
+
+      const Block& block = m_blocks[i];
+      result.push_back({ block.offset, block.length,
+        block.isFree ? 0u : block.tag, block.isFree });
+    }
+
+    std::sort(result.begin(), result.end(),
+      [] (const Range& a, const Range& b) { return a.offset < b.offset; });
+    return result;
+  }
+
+
+  uint32_t DxvkTlsfAllocator::createBlock(
+          VkDeviceSize          offset,
+          VkDeviceSize          length) {
+    Block block;
+    block.offset   = offset;
+    block.length   = length;
+    block.prevPhys = InvalidBlock;
+    block.nextPhys = InvalidBlock;
+    block.prevFree = InvalidBlock;
+    block.nextFree = InvalidBlock;
+    block.tag      = 0;
+    block.isFree   = false;
+
+    if (!m_unusedBlocks.empty()) {
+      uint32_t index = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+
+      m_blocks[index] = block;
+      return index;
+    } else {
+      m_blocks.push_back(block);
+      return uint32_t(m_blocks.size() - 1);
+    }
+  }
+
+
+  void DxvkTlsfAllocator::destroyBlock(
+          uint32_t              block) {
+    m_unusedBlocks.push_back(block);
+  }
+
+
+  void DxvkTlsfAllocator::insertFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    computeIndex(m_blocks[block].length, fl, sl);
+
+    uint32_t& head = m_freeLists[fl * SlCount + sl];
+
+    Block& entry = m_blocks[block];
+    entry.isFree   = true;
+    entry.prevFree = InvalidBlock;
+    entry.nextFree = head;
+
+    if (head != InvalidBlock)
+      m_blocks[head].prevFree = block;
+
+    head = block;
+
+    m_flMask     |= uint64_t(1) << fl;
+    m_slMasks[fl] |= 1u << sl;
+  }
+
+
+  void DxvkTlsfAllocator::removeFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    computeIndex(m_blocks[block].length, fl, sl);
+
+    Block& entry = m_blocks[block];
+    entry.isFree = false;
+
+    if (entry.prevFree != InvalidBlock)
+      m_blocks[entry.prevFree].nextFree = entry.nextFree;
+    else
+      m_freeLists[fl * SlCount + sl] = entry.nextFree;
+
+    if (entry.nextFree != InvalidBlock)
+      m_blocks[entry.nextFree].prevFree = entry.prevFree;
+
+    entry.prevFree = InvalidBlock;
+    entry.nextFree = InvalidBlock;
+
+    if (m_freeLists[fl * SlCount + sl] == InvalidBlock) {
+      m_slMasks[fl] &= ~(1u << sl);
+
+      if (!m_slMasks[fl])
+        m_flMask &= ~(uint64_t(1) << fl);
+    }
+  }
+
+
+  uint32_t DxvkTlsfAllocator::findFreeBlock(
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    uint32_t fl, sl;
+
+    // Any block in a size class at least as large as the rounded-up
+    // padded size is guaranteed to fit the allocation, so we can
+    // just take the first block of the first non-empty free list.
+    VkDeviceSize paddedSize = align > 1 ? size + align - 1 : size;
+
+    if (paddedSize <= m_capacity) {
+      computeIndex(roundUpSize(paddedSize), fl, sl);
+
+      uint32_t block = findFreeList(fl, sl);
+
+      if (block != InvalidBlock)
+        return block;
+    }
+
+    // If that failed, check the first block of each free list that
+    // may contain suitable blocks. This is bounded by the number of
+    // size classes and only happens when the chunk is nearly full.
+    computeIndex(size, fl, sl);
+
+    for (uint32_t i = fl * SlCount + sl; i < FlCount * SlCount; i++) {
+      uint32_t block = m_freeLists[i];
+
+      if (block == InvalidBlock)
+        continue;
+
+      const Block& entry = m_blocks[block];
+
+      VkDeviceSize allocStart = dxvk::align(entry.offset, align);
+
+      if (allocStart + size <= entry.offset + entry.length)
+        return block;
+    }
+
+    return InvalidBlock;
+  }
+
+
+  uint32_t DxvkTlsfAllocator::findFreeList(
+          uint32_t              fl,
+          uint32_t              sl) const {
+    uint32_t slMask = m_slMasks[fl] & (~0u << sl);
+
+    if (!slMask) {
+      uint64_t flMask = fl + 1 < 64
+        ? m_flMask & (~uint64_t(0) << (fl + 1))
+        : uint64_t(0);
+
+      if (!flMask)
+        return InvalidBlock;
+
+      fl = bit::tzcnt(flMask);
+      slMask = m_slMasks[fl];
+    }
+
+    sl = bit::tzcnt(slMask);
+    return m_freeLists[fl * SlCount + sl];
+  }
+
+
+  void DxvkTlsfAllocator::computeIndex(
+          VkDeviceSize          size,
+          uint32_t&             fl,
+          uint32_t&             sl) {
+    if (size < SlCount) {
+      fl = 0;
+      sl = uint32_t(size);
+    } else {
+      uint32_t msb = 63 - bit::lzcnt(uint64_t(size));
+      fl = msb - SlLog2 + 1;
+      sl = uint32_t(size >> (msb - SlLog2)) - SlCount;
+    }
+  }
+
+
+  VkDeviceSize DxvkTlsfAllocator::roundUpSize(
+          VkDeviceSize          size) {
+    if (size < SlCount)
+      return size;
+
+    uint32_t msb = 63 - bit::lzcnt(uint64_t(size));
+    return size + (VkDeviceSize(1) << (msb - SlLog2)) - 1;
+  }
+
+}
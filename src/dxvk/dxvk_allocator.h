@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief TLSF range allocator
+   *
+   * Two-level segregated fit allocator that manages
+   * a linear address range, such as a memory chunk.
+   * Free blocks are sorted into size classes, with
+   * the first level being a power of two and the
+   * second level subdividing it linearly, so that
+   * both allocations and frees run in constant time.
+   *
+   * Adjacent free blocks are merged immediately.
+   * This class is not thread-safe.
+   */
+  class DxvkTlsfAllocator {
+    constexpr static uint32_t SlLog2  = 4;
+    constexpr static uint32_t SlCount = 1u << SlLog2;
+    constexpr static uint32_t FlCount = 64 - SlLog2 + 1;
+
+    constexpr static uint32_t InvalidBlock = ~0u;
+  public:
+
+    constexpr static VkDeviceSize InvalidOffset = ~VkDeviceSize(0);
+
+    /**
+     * \brief Range info
+     *
+     * Describes a free or allocated range. The
+     * tag is only meaningful for allocated ranges.
+     */
+    struct Range {
+      VkDeviceSize  offset;
+      VkDeviceSize  length;
+      uint32_t      tag;
+      bool          isFree;
+    };
+
+    DxvkTlsfAllocator(VkDeviceSize capacity);
+
+    ~DxvkTlsfAllocator();
+
+    /**
+     * \brief Queries total capacity
+     * \returns Size of the managed range
+     */
+    VkDeviceSize capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * \brief Queries number of allocated bytes
+     * \returns Number of bytes currently in use
+     */
+    VkDeviceSize used() const {
+      return m_used;
+    }
+
+    /**
+     * \brief Checks whether any range is allocated
+     * \returns \c true if there are no allocations
+     */
+    bool isEmpty() const {
+      return m_used == 0;
+    }
+
+    /**
+     * \brief Allocates a range
+     *
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment, must be a power of two
+     * \param [in] tag User-defined tag, reported by \c getRanges
+     * \returns Offset of the allocated range, or
+     *    \c InvalidOffset if the allocation failed
+     */
+    VkDeviceSize alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align,
+            uint32_t              tag = 0);
+
+    /**
+     * \brief Frees a range
+     *
+     * \param [in] offset Offset of a range previously
+     *    returned by \c alloc.
+     */
+    void free(
+            VkDeviceSize          offset);
+
+    /**
+     * \brief Retrieves all free and allocated ranges
+     *
+     * Ranges are sorted by offset and cover the entire
+     * capacity. This is slow and meant for debugging.
+     * \returns List of ranges
+     */
+    std::vector<Range> getRanges() const;
+
+  private:
+
+    struct Block {
+      VkDeviceSize  offset;
+      VkDeviceSize  length;
+      uint32_t      prevPhys;
+      uint32_t      nextPhys;
+      uint32_t      prevFree;
+      uint32_t      nextFree;
+      uint32_t      tag;
+      bool          isFree;
+    };
+
+    VkDeviceSize  m_capacity;
+    VkDeviceSize  m_used = 0;
+
+    std::vector<Block>    m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+
+    std::unordered_map<VkDeviceSize, uint32_t> m_allocated;
+
+    uint64_t                                m_flMask = 0;
+    std::array<uint32_t, FlCount>           m_slMasks = { };
+    std::array<uint32_t, FlCount * SlCount> m_freeLists;
+
+    uint32_t createBlock(
+            VkDeviceSize          offset,
+            VkDeviceSize          length);
+
+    void destroyBlock(
+            uint32_t              block);
+
+    void insertFreeBlock(
+            uint32_t              block);
+
+    void removeFreeBlock(
+            uint32_t              block);
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    uint32_t findFreeList(
+            uint32_t              fl,
+            uint32_t              sl) const;
+
+    static void computeIndex(
+            VkDeviceSize          size,
+            uint32_t&             fl,
+            uint32_t&             sl);
+
+    static VkDeviceSize roundUpSize(
+            VkDeviceSize          size);
+
+  };
+
+}
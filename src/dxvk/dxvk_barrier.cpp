@@ -46,6 +46,9 @@ namespace dxvk {
 
     m_srcStages |= srcStages;
     m_dstStages |= dstStages;
+
+    m_memSrcStages |= srcStages;
+    m_memDstStages |= dstStages;
     
     m_srcAccess |= srcAccess & AccessWriteMask;
 
@@ -68,6 +71,9 @@ namespace dxvk {
     
     m_srcStages |= srcStages;
     m_dstStages |= dstStages;
+
+    m_memSrcStages |= srcStages;
+    m_memDstStages |= dstStages;
     
     m_srcAccess |= srcAccess & AccessWriteMask;
 
@@ -88,6 +94,10 @@ namespace dxvk {
           VkImageLayout             dstLayout,
           VkPipelineStageFlags      dstStages,
           VkAccessFlags             dstAccess) {
+    // Any command that accesses the image is
+    // preceded by a barrier, so bind memory here
+    image->ensureMemory();
+
     DxvkAccessFlags access = this->getAccessTypes(srcAccess);
 
     if (srcStages == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
@@ -99,15 +109,20 @@ namespace dxvk {
     m_dstStages |= dstStages;
     
     if (srcLayout == dstLayout) {
+      m_memSrcStages |= srcStages;
+      m_memDstStages |= dstStages;
+
       m_srcAccess |= srcAccess & AccessWriteMask;
 
       if (access.test(DxvkAccess::Write))
         m_dstAccess |= dstAccess;
     } else {
-      VkImageMemoryBarrier barrier;
-      barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      VkImageMemoryBarrier2KHR barrier;
+      barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
       barrier.pNext                       = nullptr;
+      barrier.srcStageMask                = srcStages;
       barrier.srcAccessMask               = srcAccess & AccessWriteMask;
+      barrier.dstStageMask                = dstStages;
       barrier.dstAccessMask               = dstAccess;
       barrier.oldLayout                   = srcLayout;
       barrier.newLayout                   = dstLayout;
@@ -138,10 +153,12 @@ namespace dxvk {
     release.m_srcStages |= srcStages;
     acquire.m_dstStages |= dstStages;
 
-    VkBufferMemoryBarrier barrier;
-    barrier.sType                       = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    VkBufferMemoryBarrier2KHR barrier;
+    barrier.sType                       = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
     barrier.pNext                       = nullptr;
+    barrier.srcStageMask                = srcStages;
     barrier.srcAccessMask               = srcAccess & AccessWriteMask;
+    barrier.dstStageMask                = 0;
     barrier.dstAccessMask               = 0;
     barrier.srcQueueFamilyIndex         = srcQueue;
     barrier.dstQueueFamilyIndex         = dstQueue;
@@ -150,7 +167,9 @@ namespace dxvk {
     barrier.size                        = bufSlice.length;
     release.m_bufBarriers.push_back(barrier);
 
+    barrier.srcStageMask                = 0;
     barrier.srcAccessMask               = 0;
+    barrier.dstStageMask                = dstStages;
     barrier.dstAccessMask               = dstAccess;
     acquire.m_bufBarriers.push_back(barrier);
 
@@ -179,10 +198,12 @@ namespace dxvk {
     release.m_srcStages |= srcStages;
     acquire.m_dstStages |= dstStages;
 
-    VkImageMemoryBarrier barrier;
-    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    VkImageMemoryBarrier2KHR barrier;
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
     barrier.pNext                       = nullptr;
+    barrier.srcStageMask                = srcStages;
     barrier.srcAccessMask               = srcAccess & AccessWriteMask;
+    barrier.dstStageMask                = 0;
     barrier.dstAccessMask               = 0;
     barrier.oldLayout                   = srcLayout;
     barrier.newLayout                   = dstLayout;
@@ -196,7 +217,9 @@ namespace dxvk {
     if (srcQueue == dstQueue)
       barrier.oldLayout = dstLayout;
 
+    barrier.srcStageMask                = 0;
     barrier.srcAccessMask               = 0;
+    barrier.dstStageMask                = dstStages;
     barrier.dstAccessMask               = dstAccess;
     acquire.m_imgBarriers.push_back(barrier);
 
@@ -248,23 +271,10 @@ namespace dxvk {
       if (!srcFlags) srcFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
       if (!dstFlags) dstFlags = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 
-      VkMemoryBarrier memBarrier;
-      memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-      memBarrier.pNext = nullptr;
-      memBarrier.srcAccessMask = m_srcAccess;
-      memBarrier.dstAccessMask = m_dstAccess;
-
-      VkMemoryBarrier* pMemBarrier = nullptr;
-      if (m_srcAccess | m_dstAccess)
-        pMemBarrier = &memBarrier;
-      
-      commandList->cmdPipelineBarrier(
-        m_cmdBuffer, srcFlags, dstFlags, 0,
-        pMemBarrier ? 1 : 0, pMemBarrier,
-        m_bufBarriers.size(),
-        m_bufBarriers.data(),
-        m_imgBarriers.size(),
-        m_imgBarriers.data());
+      if (commandList->hasSynchronization2())
+        this->recordBarriers2(commandList, srcFlags, dstFlags);
+      else
+        this->recordBarriersLegacy(commandList, srcFlags, dstFlags);
       
       commandList->addStatCtr(DxvkStatCounter::CmdBarrierCount, 1);
 
@@ -277,6 +287,9 @@ namespace dxvk {
     m_srcStages = 0;
     m_dstStages = 0;
 
+    m_memSrcStages = 0;
+    m_memDstStages = 0;
+
     m_srcAccess = 0;
     m_dstAccess = 0;
     
@@ -294,5 +307,108 @@ namespace dxvk {
     if (flags & AccessWriteMask) result.set(DxvkAccess::Write);
     return result;
   }
+
+
+
+  void DxvkBarrierSet::recordBarriers2(
+    const Rc<DxvkCommandList>&      commandList,
+          VkPipelineStageFlags      srcStages,
+          VkPipelineStageFlags      dstStages) {
+    // Queue ownership transfers only define one half of the
+    // dependency, use the merged stage masks for the other
+    // half so that the behaviour matches legacy barriers.
+    for (auto& barrier : m_bufBarriers) {
+      if (!barrier.srcStageMask) barrier.srcStageMask = srcStages;
+      if (!barrier.dstStageMask) barrier.dstStageMask = dstStages;
+    }
+
+    for (auto& barrier : m_imgBarriers) {
+      if (!barrier.srcStageMask) barrier.srcStageMask = srcStages;
+      if (!barrier.dstStageMask) barrier.dstStageMask = dstStages;
+    }
+
+    VkMemoryBarrier2KHR memBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR };
+    memBarrier.srcStageMask  = m_memSrcStages;
+    memBarrier.srcAccessMask = m_srcAccess;
+    memBarrier.dstStageMask  = m_memDstStages;
+    memBarrier.dstAccessMask = m_dstAccess;
+
+    VkDependencyInfoKHR depInfo = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR };
+
+    if (m_memSrcStages | m_memDstStages) {
+      depInfo.memoryBarrierCount = 1;
+      depInfo.pMemoryBarriers = &memBarrier;
+    }
+
+    if (!m_bufBarriers.empty()) {
+      depInfo.bufferMemoryBarrierCount = m_bufBarriers.size();
+      depInfo.pBufferMemoryBarriers = m_bufBarriers.data();
+    }
+
+    if (!m_imgBarriers.empty()) {
+      depInfo.imageMemoryBarrierCount = m_imgBarriers.size();
+      depInfo.pImageMemoryBarriers = m_imgBarriers.data();
+    }
+
+    commandList->cmdPipelineBarrier2(m_cmdBuffer, &depInfo);
+  }
+
+
+  void DxvkBarrierSet::recordBarriersLegacy(
+    const Rc<DxvkCommandList>&      commandList,
+          VkPipelineStageFlags      srcStages,
+          VkPipelineStageFlags      dstStages) {
+    m_legacyBufBarriers.resize(m_bufBarriers.size());
+    m_legacyImgBarriers.resize(m_imgBarriers.size());
+
+    for (size_t i = 0; i < m_bufBarriers.size(); i++) {
+      const auto& src = m_bufBarriers[i];
+
+      VkBufferMemoryBarrier& dst = m_legacyBufBarriers[i];
+      dst.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      dst.pNext               = nullptr;
+      dst.srcAccessMask       = VkAccessFlags(src.srcAccessMask);
+      dst.dstAccessMask       = VkAccessFlags(src.dstAccessMask);
+      dst.srcQueueFamilyIndex = src.srcQueueFamilyIndex;
+      dst.dstQueueFamilyIndex = src.dstQueueFamilyIndex;
+      dst.buffer              = src.buffer;
+      dst.offset              = src.offset;
+      dst.size                = src.size;
+    }
+
+    for (size_t i = 0; i < m_imgBarriers.size(); i++) {
+      const auto& src = m_imgBarriers[i];
+
+      VkImageMemoryBarrier& dst = m_legacyImgBarriers[i];
+      dst.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      dst.pNext               = nullptr;
+      dst.srcAccessMask       = VkAccessFlags(src.srcAccessMask);
+      dst.dstAccessMask       = VkAccessFlags(src.dstAccessMask);
+      dst.oldLayout           = src.oldLayout;
+      dst.newLayout           = src.newLayout;
+      dst.srcQueueFamilyIndex = src.srcQueueFamilyIndex;
+      dst.dstQueueFamilyIndex = src.dstQueueFamilyIndex;
+      dst.image               = src.image;
+      dst.subresourceRange    = src.subresourceRange;
+    }
+
+    VkMemoryBarrier memBarrier;
+    memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarrier.pNext = nullptr;
+    memBarrier.srcAccessMask = m_srcAccess;
+    memBarrier.dstAccessMask = m_dstAccess;
+
+    VkMemoryBarrier* pMemBarrier = nullptr;
+    if (m_srcAccess | m_dstAccess)
+      pMemBarrier = &memBarrier;
+    
+    commandList->cmdPipelineBarrier(
+      m_cmdBuffer, srcStages, dstStages, 0,
+      pMemBarrier ? 1 : 0, pMemBarrier,
+      m_legacyBufBarriers.size(),
+      m_legacyBufBarriers.data(),
+      m_legacyImgBarriers.size(),
+      m_legacyImgBarriers.data());
+  }
   
 }
\ No newline at end of file
@@ -143,18 +143,40 @@ namespace dxvk {
     /**
      * \brief Checks whether two slices can be merged
      *
-     * This is a simplified implementation that does not check for
-     * adjacent or overlapping layers or levels, and instead only
-     * returns \c true if both slices contain the same mip levels
-     * and array layers. Access flags and image aspects may differ.
+     * Slices that contain the same mip levels and array layers can
+     * always be merged, even if access flags and aspects differ.
+     * Otherwise, the slices must have the same access flags and
+     * aspects, and either cover the same mip levels with adjacent
+     * or overlapping array layers, or vice versa, so that the union
+     * of both slices is exactly representable. This keeps the number
+     * of tracked slices low when array layers or mips of large images
+     * are accessed one at a time.
      * \param [in] slice The other image slice to check
      * \returns \c true if the slices can be merged.
      */
     bool canMerge(const DxvkBarrierImageSlice& slice) const {
-      return m_range.baseMipLevel   == slice.m_range.baseMipLevel
-          && m_range.levelCount     == slice.m_range.levelCount
-          && m_range.baseArrayLayer == slice.m_range.baseArrayLayer
-          && m_range.layerCount     == slice.m_range.layerCount;
+      bool sameLayers = m_range.baseArrayLayer == slice.m_range.baseArrayLayer
+                     && m_range.layerCount     == slice.m_range.layerCount;
+      bool sameLevels = m_range.baseMipLevel   == slice.m_range.baseMipLevel
+                     && m_range.levelCount     == slice.m_range.levelCount;
+
+      if (sameLayers && sameLevels)
+        return true;
+
+      if (m_access != slice.m_access || m_range.aspectMask != slice.m_range.aspectMask)
+        return false;
+
+      if (sameLevels) {
+        return m_range.baseArrayLayer <= slice.m_range.baseArrayLayer + slice.m_range.layerCount
+            && m_range.baseArrayLayer +       m_range.layerCount     >= slice.m_range.baseArrayLayer;
+      }
+
+      if (sameLayers) {
+        return m_range.baseMipLevel   <= slice.m_range.baseMipLevel   + slice.m_range.levelCount
+            && m_range.baseMipLevel   +       m_range.levelCount     >= slice.m_range.baseMipLevel;
+      }
+
+      return false;
     }
 
     /**
@@ -173,7 +195,7 @@ namespace dxvk {
       m_range.aspectMask     |= slice.m_range.aspectMask;
       m_range.baseMipLevel    = std::min(m_range.baseMipLevel, slice.m_range.baseMipLevel);
       m_range.levelCount      = maxMipLevel - m_range.baseMipLevel;
-      m_range.baseArrayLayer  = std::min(m_range.baseMipLevel, slice.m_range.baseArrayLayer);
+      m_range.baseArrayLayer  = std::min(m_range.baseArrayLayer, slice.m_range.baseArrayLayer);
       m_range.layerCount      = maxArrayLayer - m_range.baseArrayLayer;
       m_access.set(slice.m_access);
     }
@@ -467,6 +489,11 @@ namespace dxvk {
    * Accumulates memory barriers and provides a
    * method to record all those barriers into a
    * command buffer at once.
+   *
+   * If synchronization2 is supported, image and buffer
+   * barriers keep their own stage masks, and only the
+   * global memory barrier uses merged stage masks.
+   * Otherwise, all barriers share the same stages.
    */
   class DxvkBarrierSet {
     
@@ -571,14 +598,30 @@ namespace dxvk {
     VkPipelineStageFlags m_srcStages = 0;
     VkPipelineStageFlags m_dstStages = 0;
 
+    VkPipelineStageFlags m_memSrcStages = 0;
+    VkPipelineStageFlags m_memDstStages = 0;
+
     VkAccessFlags m_srcAccess = 0;
     VkAccessFlags m_dstAccess = 0;
     
-    std::vector<VkBufferMemoryBarrier> m_bufBarriers;
-    std::vector<VkImageMemoryBarrier>  m_imgBarriers;
+    std::vector<VkBufferMemoryBarrier2KHR> m_bufBarriers;
+    std::vector<VkImageMemoryBarrier2KHR>  m_imgBarriers;
+
+    std::vector<VkBufferMemoryBarrier> m_legacyBufBarriers;
+    std::vector<VkImageMemoryBarrier>  m_legacyImgBarriers;
 
     DxvkBarrierSubresourceSet<VkBuffer, DxvkBarrierBufferSlice> m_bufSlices;
     DxvkBarrierSubresourceSet<VkImage,  DxvkBarrierImageSlice>  m_imgSlices;
+
+    void recordBarriers2(
+      const Rc<DxvkCommandList>&      commandList,
+            VkPipelineStageFlags      srcStages,
+            VkPipelineStageFlags      dstStages);
+
+    void recordBarriersLegacy(
+      const Rc<DxvkCommandList>&      commandList,
+            VkPipelineStageFlags      srcStages,
+            VkPipelineStageFlags      dstStages);
     
   };
   
@@ -194,5 +194,20 @@ namespace dxvk {
     Rc<DxvkBufferView> bufferView;
     DxvkBufferSlice    bufferSlice;
   };
+
+
+  /**
+   * \brief Inline uniform block data
+   *
+   * Stores constant data for one inline uniform block
+   * binding. The version changes whenever the data does,
+   * so that descriptor sets can be cached by version.
+   */
+  struct DxvkInlineUniformBlock {
+    uint32_t slot     = ~0u;
+    uint32_t size     = 0u;
+    uint32_t version  = 0u;
+    std::array<uint32_t, MaxInlineUniformBlockSize / sizeof(uint32_t)> data = { };
+  };
   
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "dxvk_barrier.h"
 #include "dxvk_buffer.h"
+#include "dxvk_buffer_ring.h"
+#include "dxvk_buffer_suballoc.h"
+#include "dxvk_defrag.h"
 #include "dxvk_device.h"
 
 #include <algorithm>
@@ -10,17 +13,23 @@ namespace dxvk {
           DxvkDevice*           device,
     const DxvkBufferCreateInfo& createInfo,
           DxvkMemoryAllocator&  memAlloc,
+          DxvkBufferRing&       ring,
+          DxvkBufferSuballocator& suballoc,
           VkMemoryPropertyFlags memFlags)
   : m_device        (device),
     m_info          (createInfo),
     m_memAlloc      (&memAlloc),
     m_memFlags      (memFlags),
     m_shaderStages  (util::shaderStages(createInfo.stages)) {
+    sync::setLockName(m_freeMutex, "DxvkBuffer::free");
+    sync::setLockName(m_swapMutex, "DxvkBuffer::swap");
+
     // Align slices so that we don't violate any alignment
     // requirements imposed by the Vulkan device/driver
     VkDeviceSize sliceAlignment = computeSliceAlignment();
     m_physSliceLength = createInfo.size;
     m_physSliceStride = align(createInfo.size, sliceAlignment);
+    m_physSliceAlign  = sliceAlignment;
     m_physSliceCount  = std::max<VkDeviceSize>(1, 256 / m_physSliceStride);
 
     // Limit size of multi-slice buffers to reduce fragmentation
@@ -30,43 +39,183 @@ namespace dxvk {
       ? MaxBufferSize / m_physSliceStride
       : 1;
 
-    // Allocate the initial set of buffer slices. Only clear
-    // buffer memory if there is more than one slice, since
-    // we expect the client api to initialize the first slice.
-    m_buffer = allocBuffer(m_physSliceCount, m_physSliceCount > 1);
+    // Page mappings of sparse buffers are tied to a
+    // single Vulkan buffer, so never create more slices
+    if (isSparse()) {
+      m_physSliceCount    = 1;
+      m_physSliceMaxCount = 1;
+    }
 
+    // Small read-only buffers share a large Vulkan buffer with
+    // other buffers of the same kind, which saves memory lost
+    // to alignment as well as buffer handles. Additional slices
+    // are allocated lazily if the buffer ever gets renamed.
     DxvkBufferSliceHandle slice;
-    slice.handle = m_buffer.buffer;
-    slice.offset = 0;
-    slice.length = m_physSliceLength;
-    slice.mapPtr = m_buffer.memory.mapPtr(0);
+
+    if (DxvkBufferSuballocator::supportsBuffer(m_info, m_memFlags, m_physSliceStride)
+     && suballoc.allocSlice(m_info.usage, m_memFlags, determineMemoryCategory(),
+          m_physSliceLength, m_physSliceAlign, slice)) {
+      m_suballoc      = &suballoc;
+      m_suballocSlice = slice;
+    } else {
+      // Allocate the initial set of buffer slices. Only clear
+      // buffer memory if there is more than one slice, since
+      // we expect the client api to initialize the first slice.
+      m_buffer = allocBuffer(m_physSliceCount, m_physSliceCount > 1);
+
+      slice.handle = m_buffer.buffer;
+      slice.offset = 0;
+      slice.length = m_physSliceLength;
+      slice.mapPtr = m_buffer.memory.mapPtr(0);
+
+      m_lazyAlloc = m_physSliceCount > 1;
+    }
 
     m_physSlice = slice;
-    m_lazyAlloc = m_physSliceCount > 1;
+
+    // Small dynamic buffers allocate additional slices from
+    // the device-wide ring instead of creating new buffers
+    if (!isSparse() && DxvkBufferRing::supportsBuffer(m_info.usage, m_memFlags, m_physSliceStride))
+      m_ring = &ring;
   }
 
 
   DxvkBuffer::~DxvkBuffer() {
+    if (m_defrag)
+      m_defrag->unregisterBuffer(this);
+
+    if (m_ring)
+      freeRingSlice(m_physSlice);
+
+    // No command list references the buffer anymore,
+    // so the shared range can be reused right away
+    if (m_suballoc)
+      m_suballoc->freeSlice(m_suballocSlice);
+
     auto vkd = m_device->vkd();
 
+    for (const auto& view : m_viewCache)
+      vkd->vkDestroyBufferView(vkd->device(), view.second, nullptr);
+
     for (const auto& buffer : m_buffers)
       vkd->vkDestroyBuffer(vkd->device(), buffer.buffer, nullptr);
     vkd->vkDestroyBuffer(vkd->device(), m_buffer.buffer, nullptr);
   }
   
   
-  DxvkBufferHandle DxvkBuffer::allocBuffer(VkDeviceSize sliceCount, bool clear) const {
+  bool DxvkBuffer::canRelocateStorage() const {
+    VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                 | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    return !isSparse() && !m_suballoc
+        && (m_memFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        && !(m_memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        && (m_info.usage & copyUsage) == copyUsage
+        && m_physSliceMaxCount == 1;
+  }
+
+
+  bool DxvkBuffer::isRelocatable(
+          DxvkBufferRelocation  mode) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+
+    if (!m_buffers.empty() || m_lazyAlloc)
+      return false;
+
+    bool isResident = (m_buffer.memory.propertyFlags()
+      & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+
+    switch (mode) {
+      case DxvkBufferRelocation::Defragment:
+        return isResident && m_memAlloc->canRelocate(m_buffer.memory);
+
+      case DxvkBufferRelocation::Evict:
+        return isResident;
+
+      case DxvkBufferRelocation::Restore:
+        return !isResident;
+    }
+
+    return false;
+  }
+
+
+  Rc<DxvkBufferStorage> DxvkBuffer::relocateStorage(
+          DxvkBufferRelocation  mode) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+
+    DxvkMemoryFlags relocHints;
+
+    if (mode == DxvkBufferRelocation::Defragment)
+      relocHints.set(DxvkMemoryFlag::Relocate);
+
+    if (mode == DxvkBufferRelocation::Evict)
+      relocHints.set(DxvkMemoryFlag::Evict);
+
+    DxvkBufferHandle handle = allocBuffer(1, false, relocHints);
+
+    if (!handle.buffer)
+      return nullptr;
+
+    if (mode == DxvkBufferRelocation::Defragment)
+      m_memAlloc->notifyRelocation(m_buffer.memory);
+
+    Rc<DxvkBufferStorage> storage = new DxvkBufferStorage(
+      m_device->vkd(), std::exchange(m_buffer, std::move(handle)));
+
+    DxvkBufferSliceHandle slice;
+    slice.handle = m_buffer.buffer;
+    slice.offset = 0;
+    slice.length = m_physSliceLength;
+    slice.mapPtr = nullptr;
+
+    m_physSlice = slice;
+    return storage;
+  }
+
+
+  VkDeviceAddress DxvkBuffer::getDeviceAddress(VkDeviceSize offset) const {
+    if (!hasDeviceAddressUsage(m_device, m_info.usage))
+      return 0;
+
+    auto vkd = m_device->vkd();
+
+    VkBufferDeviceAddressInfoKHR info = { VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR };
+    info.buffer = m_physSlice.handle;
+
+    VkDeviceAddress base = vkd->vkGetBufferDeviceAddressKHR(vkd->device(), &info);
+    return base + m_physSlice.offset + offset;
+  }
+
+
+  bool DxvkBuffer::hasDeviceAddressUsage(
+          DxvkDevice*           device,
+          VkBufferUsageFlags    usage) {
+    constexpr VkBufferUsageFlags shaderUsage =
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+      VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+    return device->canUseBufferDeviceAddress()
+        && (usage & shaderUsage);
+  }
+
+
+  DxvkBufferHandle DxvkBuffer::allocBuffer(VkDeviceSize sliceCount, bool clear, DxvkMemoryFlags relocHints) const {
     auto vkd = m_device->vkd();
 
     VkBufferCreateInfo info;
     info.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     info.pNext                 = nullptr;
-    info.flags                 = 0;
+    info.flags                 = m_info.flags;
     info.size                  = m_physSliceStride * sliceCount;
     info.usage                 = m_info.usage;
     info.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
     info.queueFamilyIndexCount = 0;
     info.pQueueFamilyIndices   = nullptr;
+
+    if (hasDeviceAddressUsage(m_device, info.usage))
+      info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
     
     DxvkBufferHandle handle;
 
@@ -77,6 +226,10 @@ namespace dxvk {
         "\n  size:  ", info.size,
         "\n  usage: ", info.usage));
     }
+
+    // Memory for sparse buffers is bound page by page later
+    if (info.flags & VK_BUFFER_CREATE_SPARSE_BINDING_BIT)
+      return handle;
     
     VkMemoryDedicatedRequirements dedicatedRequirements;
     dedicatedRequirements.sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
@@ -112,6 +265,15 @@ namespace dxvk {
     if (isGpuWritable)
       hints.set(DxvkMemoryFlag::GpuWritable);
 
+    if (!relocHints.isClear()) {
+      if (dedicatedRequirements.requiresDedicatedAllocation) {
+        vkd->vkDestroyBuffer(vkd->device(), handle.buffer, nullptr);
+        return DxvkBufferHandle();
+      }
+
+      hints.set(relocHints);
+    }
+
     // Staging buffers that can't even be used as a transfer destinations
     // are likely short-lived, so we should put them on a separate memory
     // pool in order to avoid fragmentation
@@ -121,7 +283,14 @@ namespace dxvk {
 
     // Ask driver whether we should be using a dedicated allocation
     handle.memory = m_memAlloc->alloc(&memReq.memoryRequirements,
-      dedicatedRequirements, dedMemoryAllocInfo, m_memFlags, hints);
+      dedicatedRequirements, dedMemoryAllocInfo, m_memFlags, hints,
+      determineMemoryCategory());
+
+    // Relocation is allowed to fail if there is no suitable memory
+    if (!handle.memory) {
+      vkd->vkDestroyBuffer(vkd->device(), handle.buffer, nullptr);
+      return DxvkBufferHandle();
+    }
     
     if (vkd->vkBindBufferMemory(vkd->device(), handle.buffer,
         handle.memory.memory(), handle.memory.offset()) != VK_SUCCESS)
@@ -134,6 +303,26 @@ namespace dxvk {
   }
 
 
+  DxvkMemoryCategory DxvkBuffer::determineMemoryCategory() const {
+    if (m_info.category != DxvkMemoryCategory::Auto)
+      return m_info.category;
+
+    if (m_info.usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+      return DxvkMemoryCategory::VertexIndex;
+
+    if (m_info.usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+      return DxvkMemoryCategory::Constant;
+
+    VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                 | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    if (!(m_info.usage & ~copyUsage))
+      return DxvkMemoryCategory::Staging;
+
+    return DxvkMemoryCategory::ShaderInternal;
+  }
+
+
   VkDeviceSize DxvkBuffer::computeSliceAlignment() const {
     const auto& devInfo = m_device->properties().core.properties;
 
@@ -167,46 +356,78 @@ namespace dxvk {
   }
 
 
+  bool DxvkBuffer::allocRingSlice(DxvkBufferSliceHandle& slice) {
+    return m_ring->allocSlice(m_memFlags,
+      m_physSliceLength, m_physSliceAlign, slice);
+  }
 
-  
-  DxvkBufferView::DxvkBufferView(
-    const Rc<vk::DeviceFn>&         vkd,
-    const Rc<DxvkBuffer>&           buffer,
-    const DxvkBufferViewCreateInfo& info)
-  : m_vkd(vkd), m_info(info), m_buffer(buffer),
-    m_bufferSlice (getSliceHandle()),
-    m_bufferView  (createBufferView(m_bufferSlice)) {
-    
+
+  bool DxvkBuffer::freeRingSlice(const DxvkBufferSliceHandle& slice) {
+    // Slices of the buffer's own backing storage are never
+    // owned by the ring, skip the lookup for those
+    if (slice.handle == m_buffer.buffer)
+      return false;
+
+    return m_ring->freeSlice(slice);
   }
-  
-  
-  DxvkBufferView::~DxvkBufferView() {
-    if (m_views.empty()) {
-      m_vkd->vkDestroyBufferView(
-        m_vkd->device(), m_bufferView, nullptr);
-    } else {
-      for (const auto& pair : m_views) {
-        m_vkd->vkDestroyBufferView(
-          m_vkd->device(), pair.second, nullptr);
-      }
-    }
+
+
+  void DxvkBuffer::setMemoryFlags(VkMemoryPropertyFlags memFlags) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+    std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+
+    m_memFlags = memFlags;
+
+    // Slices of the old storage may still be in use and will
+    // be returned to the free list later, filter those out
+    m_retiredBuffers.push_back(m_buffer.buffer);
+
+    if (m_suballoc)
+      m_retiredBuffers.push_back(m_suballocSlice.handle);
+
+    for (const auto& buffer : m_buffers)
+      m_retiredBuffers.push_back(buffer.buffer);
+
+    m_freeSlices.clear();
+    m_nextSlices.clear();
+    m_lazyAlloc = false;
   }
-  
-  
-  VkBufferView DxvkBufferView::createBufferView(
-    const DxvkBufferSliceHandle& slice) {
+
+
+  void DxvkBuffer::dropRetiredSlices() {
+    auto end = std::remove_if(m_freeSlices.begin(), m_freeSlices.end(),
+      [this] (const DxvkBufferSliceHandle& slice) {
+        return std::find(m_retiredBuffers.begin(), m_retiredBuffers.end(),
+          slice.handle) != m_retiredBuffers.end();
+      });
+
+    m_freeSlices.erase(end, m_freeSlices.end());
+  }
+
+
+  VkBufferView DxvkBuffer::getView(
+    const DxvkBufferViewKey&  key) {
+    std::lock_guard<dxvk::mutex> lock(m_viewMutex);
+
+    auto entry = m_viewCache.find(key);
+
+    if (entry != m_viewCache.end())
+      return entry->second;
+
     VkBufferViewCreateInfo viewInfo;
     viewInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
     viewInfo.pNext  = nullptr;
     viewInfo.flags  = 0;
-    viewInfo.buffer = slice.handle;
-    viewInfo.format = m_info.format;
-    viewInfo.offset = slice.offset;
-    viewInfo.range  = slice.length;
-    
+    viewInfo.buffer = key.handle;
+    viewInfo.format = key.format;
+    viewInfo.offset = key.offset;
+    viewInfo.range  = key.length;
+
+    auto vkd = m_device->vkd();
+
     VkBufferView result = VK_NULL_HANDLE;
 
-    if (m_vkd->vkCreateBufferView(m_vkd->device(),
+    if (vkd->vkCreateBufferView(vkd->device(),
           &viewInfo, nullptr, &result) != VK_SUCCESS) {
       throw DxvkError(str::format(
         "DxvkBufferView: Failed to create buffer view:",
@@ -215,24 +436,62 @@ namespace dxvk {
         "\n  Format: ", viewInfo.format));
     }
 
+    m_viewCache.insert({ key, result });
     return result;
   }
 
 
+
+
+  DxvkBufferStorage::DxvkBufferStorage(
+    const Rc<vk::DeviceFn>&     vkd,
+          DxvkBufferHandle&&    handle)
+  : m_vkd(vkd), m_handle(std::move(handle)) {
+
+  }
+
+
+  DxvkBufferStorage::~DxvkBufferStorage() {
+    m_vkd->vkDestroyBuffer(m_vkd->device(), m_handle.buffer, nullptr);
+  }
+
+
+
+  DxvkBufferView::DxvkBufferView(
+    const Rc<DxvkBuffer>&           buffer,
+    const DxvkBufferViewCreateInfo& info)
+  : m_info(info), m_buffer(buffer),
+    m_bufferSlice (getSliceHandle()),
+    m_bufferView  (lookupBufferView(m_bufferSlice)) {
+    
+  }
+  
+  
+  DxvkBufferView::~DxvkBufferView() {
+    // View handles are owned by the buffer
+  }
+  
+  
+  VkBufferView DxvkBufferView::lookupBufferView(
+    const DxvkBufferSliceHandle& slice) const {
+    // Views are cached per physical slice by the buffer
+    // itself, so that views created for a renamed slice
+    // are reused once the slice comes around again, and
+    // other views with the same properties can share them.
+    DxvkBufferViewKey key;
+    key.format = m_info.format;
+    key.handle = slice.handle;
+    key.offset = slice.offset;
+    key.length = slice.length;
+
+    return m_buffer->getView(key);
+  }
+
+
   void DxvkBufferView::updateBufferView(
     const DxvkBufferSliceHandle& slice) {
-    if (m_views.empty())
-      m_views.insert({ m_bufferSlice, m_bufferView });
-    
     m_bufferSlice = slice;
-    
-    auto entry = m_views.find(slice);
-    if (entry != m_views.end()) {
-      m_bufferView = entry->second;
-    } else {
-      m_bufferView = createBufferView(m_bufferSlice);
-      m_views.insert({ m_bufferSlice, m_bufferView });
-    }
+    m_bufferView  = lookupBufferView(slice);
   }
   
   
@@ -11,6 +11,23 @@
 
 namespace dxvk {
 
+  class DxvkBufferRing;
+  class DxvkBufferSuballocator;
+  class DxvkMemoryDefragmenter;
+
+  /**
+   * \brief Buffer relocation mode
+   *
+   * Determines where the backing storage
+   * of a buffer gets moved to.
+   */
+  enum class DxvkBufferRelocation : uint32_t {
+    Defragment  = 0, ///< Move to densely used chunks
+    Evict       = 1, ///< Move to system memory
+    Restore     = 2, ///< Move back to device-local memory
+  };
+
+
   /**
    * \brief Buffer create info
    * 
@@ -30,6 +47,13 @@ namespace dxvk {
     
     /// Allowed access patterns
     VkAccessFlags access;
+
+    /// Memory category used for memory accounting
+    DxvkMemoryCategory category = DxvkMemoryCategory::Auto;
+
+    /// Buffer create flags. If sparse binding is enabled,
+    /// no memory is bound to the buffer on creation.
+    VkBufferCreateFlags flags = 0;
   };
   
   
@@ -63,6 +87,40 @@ namespace dxvk {
   };
   
 
+  /**
+   * \brief Retired buffer storage
+   *
+   * Owns a buffer handle and its memory after the buffer
+   * was moved to a different memory location, so that
+   * the old storage can be kept alive until the GPU
+   * has finished copying its contents.
+   */
+  class DxvkBufferStorage : public DxvkResource {
+
+  public:
+
+    DxvkBufferStorage(
+      const Rc<vk::DeviceFn>&     vkd,
+            DxvkBufferHandle&&    handle);
+
+    ~DxvkBufferStorage();
+
+    /**
+     * \brief Buffer handle
+     * \returns Buffer handle
+     */
+    VkBuffer handle() const {
+      return m_handle.buffer;
+    }
+
+  private:
+
+    Rc<vk::DeviceFn>  m_vkd;
+    DxvkBufferHandle  m_handle;
+
+  };
+
+
   /**
    * \brief Buffer slice info
    * 
@@ -91,6 +149,37 @@ namespace dxvk {
     }
   };
 
+
+  /**
+   * \brief Buffer view handle key
+   *
+   * Stores the properties of a single Vulkan buffer
+   * view that was created for a physical buffer slice.
+   * Used to look up view handles in the buffer's cache.
+   */
+  struct DxvkBufferViewKey {
+    VkFormat      format;
+    VkBuffer      handle;
+    VkDeviceSize  offset;
+    VkDeviceSize  length;
+
+    bool eq(const DxvkBufferViewKey& other) const {
+      return format == other.format
+          && handle == other.handle
+          && offset == other.offset
+          && length == other.length;
+    }
+
+    size_t hash() const {
+      DxvkHashState result;
+      result.add(uint32_t(format));
+      result.add(std::hash<VkBuffer>()(handle));
+      result.add(std::hash<VkDeviceSize>()(offset));
+      result.add(std::hash<VkDeviceSize>()(length));
+      return result;
+    }
+  };
+
   
   /**
    * \brief Virtual buffer resource
@@ -101,12 +190,15 @@ namespace dxvk {
    */
   class DxvkBuffer : public DxvkResource {
     friend class DxvkBufferView;
+    friend class DxvkMemoryDefragmenter;
   public:
     
     DxvkBuffer(
             DxvkDevice*           device,
       const DxvkBufferCreateInfo& createInfo,
             DxvkMemoryAllocator&  memAlloc,
+            DxvkBufferRing&       ring,
+            DxvkBufferSuballocator& suballoc,
             VkMemoryPropertyFlags memFlags);
     
     ~DxvkBuffer();
@@ -129,6 +221,18 @@ namespace dxvk {
     VkMemoryPropertyFlags memFlags() const {
       return m_memFlags;
     }
+
+    /**
+     * \brief Changes memory type of future slices
+     *
+     * Slices allocated after this call will use memory with
+     * the given property flags. Existing backing storage is
+     * kept alive since the GPU may still use it, but its
+     * slices will no longer be handed out. The caller must
+     * rename the buffer in order to move the current slice.
+     * \param [in] memFlags New memory property flags
+     */
+    void setMemoryFlags(VkMemoryPropertyFlags memFlags);
     
     /**
      * \brief Map pointer
@@ -177,6 +281,17 @@ namespace dxvk {
       return result;
     }
 
+    /**
+     * \brief Queries device address of the current slice
+     *
+     * Only valid for shader-visible buffers on devices that
+     * support buffer device addresses. The address changes
+     * whenever the buffer gets renamed.
+     * \param [in] offset Offset into the current slice
+     * \returns Device address, or 0 if not supported
+     */
+    VkDeviceAddress getDeviceAddress(VkDeviceSize offset = 0) const;
+
     /**
      * \brief Retrieves descriptor info
      * 
@@ -216,6 +331,46 @@ namespace dxvk {
       return std::exchange(m_physSlice, slice);
     }
     
+    /**
+     * \brief Checks whether storage can ever be relocated
+     *
+     * Only device-local buffers with a single backing slice
+     * can be moved, since other buffers may be mapped, or
+     * have multiple slices in flight at the same time.
+     * \returns \c true if the buffer can be registered
+     *    with the memory defragmenter
+     */
+    bool canRelocateStorage() const;
+
+    /**
+     * \brief Checks whether storage should be relocated
+     *
+     * Returns \c true if the buffer has never been renamed
+     * and its memory is a useful source for the given mode,
+     * i.e. a sparsely used device-local chunk for defragmentation,
+     * any device-local memory for eviction, or system memory
+     * for restoring a previously evicted buffer.
+     * \param [in] mode Relocation mode
+     * \returns \c true if the buffer should be relocated
+     */
+    bool isRelocatable(
+            DxvkBufferRelocation  mode);
+
+    /**
+     * \brief Relocates backing storage
+     *
+     * Allocates a new backing buffer as determined by the
+     * relocation mode and makes it the current buffer slice.
+     * Do not call this directly as this is called implicitly
+     * by the context's \c relocateBuffer method, which also
+     * copies the buffer contents to the new location.
+     * \param [in] mode Relocation mode
+     * \returns The previous storage, or \c nullptr if
+     *    no suitable memory could be allocated.
+     */
+    Rc<DxvkBufferStorage> relocateStorage(
+            DxvkBufferRelocation  mode);
+    
     /**
      * \brief Transform feedback vertex stride
      * 
@@ -237,6 +392,18 @@ namespace dxvk {
     void setXfbVertexStride(uint32_t stride) {
       m_vertexStride = stride;
     }
+
+    /**
+     * \brief Checks whether the buffer is sparse
+     *
+     * Sparse buffers have no memory bound on creation,
+     * and cannot be renamed since page mappings are
+     * tied to the Vulkan buffer object.
+     * \returns \c true if the buffer uses sparse binding
+     */
+    bool isSparse() const {
+      return (m_info.flags & VK_BUFFER_CREATE_SPARSE_BINDING_BIT) != 0;
+    }
     
     /**
      * \brief Allocates new buffer slice
@@ -249,11 +416,19 @@ namespace dxvk {
       if (unlikely(m_freeSlices.empty())) {
         std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
         std::swap(m_freeSlices, m_nextSlices);
+
+        if (unlikely(!m_retiredBuffers.empty()))
+          dropRetiredSlices();
       }
 
       // If there are still no slices available, create a new
       // backing buffer and add all slices to the free list.
       if (unlikely(m_freeSlices.empty())) {
+        DxvkBufferSliceHandle slice;
+
+        if (m_ring && allocRingSlice(slice))
+          return slice;
+
         if (likely(!m_lazyAlloc)) {
           DxvkBufferHandle handle = allocBuffer(m_physSliceCount, true);
 
@@ -285,6 +460,9 @@ namespace dxvk {
      * \param [in] slice The buffer slice to free
      */
     void freeSlice(const DxvkBufferSliceHandle& slice) {
+      if (m_ring && freeRingSlice(slice))
+        return;
+
       // Add slice to a separate free list to reduce lock contention.
       std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
       m_nextSlices.push_back(slice);
@@ -295,29 +473,43 @@ namespace dxvk {
     DxvkDevice*             m_device;
     DxvkBufferCreateInfo    m_info;
     DxvkMemoryAllocator*    m_memAlloc;
+    DxvkBufferRing*         m_ring = nullptr;
+    DxvkBufferSuballocator* m_suballoc = nullptr;
     VkMemoryPropertyFlags   m_memFlags;
     VkShaderStageFlags      m_shaderStages;
     
     DxvkBufferHandle        m_buffer;
     DxvkBufferSliceHandle   m_physSlice;
+    DxvkBufferSliceHandle   m_suballocSlice;
     uint32_t                m_vertexStride = 0;
 
+    DxvkMemoryDefragmenter* m_defrag      = nullptr;
+    size_t                  m_defragIndex = 0;
+
     alignas(CACHE_LINE_SIZE)
     sync::Spinlock          m_freeMutex;
 
     uint32_t                m_lazyAlloc = false;
     VkDeviceSize            m_physSliceLength   = 0;
     VkDeviceSize            m_physSliceStride   = 0;
+    VkDeviceSize            m_physSliceAlign    = 0;
     VkDeviceSize            m_physSliceCount    = 1;
     VkDeviceSize            m_physSliceMaxCount = 1;
 
     std::vector<DxvkBufferHandle>       m_buffers;
     std::vector<DxvkBufferSliceHandle>  m_freeSlices;
+    std::vector<VkBuffer>               m_retiredBuffers;
 
     alignas(CACHE_LINE_SIZE)
     sync::Spinlock                      m_swapMutex;
     std::vector<DxvkBufferSliceHandle>  m_nextSlices;
 
+    dxvk::mutex                         m_viewMutex;
+    std::unordered_map<
+      DxvkBufferViewKey,
+      VkBufferView,
+      DxvkHash, DxvkEq>                 m_viewCache;
+
     void pushSlice(const DxvkBufferHandle& handle, uint32_t index) {
       DxvkBufferSliceHandle slice;
       slice.handle = handle.buffer;
@@ -329,9 +521,25 @@ namespace dxvk {
 
     DxvkBufferHandle allocBuffer(
             VkDeviceSize          sliceCount,
-            bool                  clear) const;
+            bool                  clear,
+            DxvkMemoryFlags       relocHints = DxvkMemoryFlags()) const;
 
     VkDeviceSize computeSliceAlignment() const;
+
+    DxvkMemoryCategory determineMemoryCategory() const;
+
+    static bool hasDeviceAddressUsage(
+            DxvkDevice*           device,
+            VkBufferUsageFlags    usage);
+
+    bool allocRingSlice(DxvkBufferSliceHandle& slice);
+
+    bool freeRingSlice(const DxvkBufferSliceHandle& slice);
+
+    void dropRetiredSlices();
+
+    VkBufferView getView(
+      const DxvkBufferViewKey&  key);
     
   };
   
@@ -540,7 +748,6 @@ namespace dxvk {
   public:
     
     DxvkBufferView(
-      const Rc<vk::DeviceFn>&         vkd,
       const Rc<DxvkBuffer>&           buffer,
       const DxvkBufferViewCreateInfo& info);
     
@@ -636,20 +843,14 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>          m_vkd;
     DxvkBufferViewCreateInfo  m_info;
     Rc<DxvkBuffer>            m_buffer;
 
     DxvkBufferSliceHandle     m_bufferSlice;
     VkBufferView              m_bufferView;
 
-    std::unordered_map<
-      DxvkBufferSliceHandle,
-      VkBufferView,
-      DxvkHash, DxvkEq> m_views;
-    
-    VkBufferView createBufferView(
-      const DxvkBufferSliceHandle& slice);
+    VkBufferView lookupBufferView(
+      const DxvkBufferSliceHandle& slice) const;
     
     void updateBufferView(
       const DxvkBufferSliceHandle& slice);
@@ -0,0 +1,195 @@
+#include "dxvk_buffer_ring.h"
+#include "dxvk_device.h"
+
+namespace dxvk {
+
+  DxvkBufferRing::DxvkBufferRing(
+          DxvkDevice*           device,
+          DxvkMemoryAllocator&  memAlloc)
+  : m_device(device), m_memAlloc(&memAlloc) {
+
+  }
+
+
+  DxvkBufferRing::~DxvkBufferRing() {
+    auto vkd = m_device->vkd();
+
+    for (const auto& page : m_pages)
+      vkd->vkDestroyBuffer(vkd->device(), page.second->handle.buffer, nullptr);
+  }
+
+
+  bool DxvkBufferRing::supportsBuffer(
+          VkBufferUsageFlags    usage,
+          VkMemoryPropertyFlags memFlags,
+          VkDeviceSize          sliceStride) {
+    return (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        && !(usage & ~PageUsage)
+        && sliceStride <= MaxSliceSize;
+  }
+
+
+  bool DxvkBufferRing::allocSlice(
+          VkMemoryPropertyFlags   memFlags,
+          VkDeviceSize            length,
+          VkDeviceSize            align,
+          DxvkBufferSliceHandle&  slice) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    uint32_t poolIndex = getPoolIndex(memFlags);
+    Pool& pool = m_pools[poolIndex];
+
+    Page* page = pool.current;
+    VkDeviceSize offset = page ? dxvk::align(page->offset, align) : 0;
+
+    if (!page || offset + length > PageSize) {
+      // Retire the current page. If all of its slices have
+      // already been returned, we can reuse it right away,
+      // otherwise it gets recycled once the last slice is
+      // freed.
+      if (page && !page->liveCount) {
+        page->offset = 0;
+      } else {
+        pool.current = nullptr;
+
+        if (!pool.freePages.empty()) {
+          page = pool.freePages.back();
+          pool.freePages.pop_back();
+        } else {
+          page = createPage(poolIndex);
+
+          if (!page)
+            return false;
+        }
+
+        pool.current = page;
+      }
+
+      offset = 0;
+    }
+
+    page->offset = offset + length;
+    page->liveCount += 1;
+
+    slice.handle = page->handle.buffer;
+    slice.offset = offset;
+    slice.length = length;
+    slice.mapPtr = page->handle.memory.mapPtr(offset);
+    return true;
+  }
+
+
+  bool DxvkBufferRing::freeSlice(
+    const DxvkBufferSliceHandle&  slice) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_pages.find(slice.handle);
+
+    if (entry == m_pages.end())
+      return false;
+
+    Page* page = entry->second.get();
+
+    if (!(--page->liveCount) && m_pools[page->poolIndex].current != page)
+      recyclePage(page);
+
+    return true;
+  }
+
+
+  DxvkBufferRing::Page* DxvkBufferRing::createPage(
+          uint32_t              poolIndex) {
+    auto vkd = m_device->vkd();
+
+    VkBufferCreateInfo info;
+    info.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext                 = nullptr;
+    info.flags                 = 0;
+    info.size                  = PageSize;
+    info.usage                 = PageUsage;
+
+    if (m_device->canUseBufferDeviceAddress())
+      info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    info.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices   = nullptr;
+
+    auto page = std::make_unique<Page>();
+    page->poolIndex = poolIndex;
+
+    if (vkd->vkCreateBuffer(vkd->device(),
+          &info, nullptr, &page->handle.buffer) != VK_SUCCESS) {
+      Logger::err("DxvkBufferRing: Failed to create buffer");
+      return nullptr;
+    }
+
+    VkMemoryRequirements memReq;
+    vkd->vkGetBufferMemoryRequirements(vkd->device(),
+      page->handle.buffer, &memReq);
+
+    VkMemoryDedicatedRequirements dedicatedRequirements;
+    dedicatedRequirements.sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    dedicatedRequirements.pNext                       = VK_NULL_HANDLE;
+    dedicatedRequirements.prefersDedicatedAllocation  = VK_FALSE;
+    dedicatedRequirements.requiresDedicatedAllocation = VK_FALSE;
+
+    VkMemoryDedicatedAllocateInfo dedMemoryAllocInfo;
+    dedMemoryAllocInfo.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedMemoryAllocInfo.pNext  = VK_NULL_HANDLE;
+    dedMemoryAllocInfo.buffer = page->handle.buffer;
+    dedMemoryAllocInfo.image  = VK_NULL_HANDLE;
+
+    page->handle.memory = m_memAlloc->alloc(&memReq,
+      dedicatedRequirements, dedMemoryAllocInfo,
+      m_pools[poolIndex].memFlags,
+      DxvkMemoryFlag::GpuReadable,
+      DxvkMemoryCategory::Constant);
+
+    if (!page->handle.memory || vkd->vkBindBufferMemory(vkd->device(), page->handle.buffer,
+          page->handle.memory.memory(), page->handle.memory.offset()) != VK_SUCCESS) {
+      Logger::err("DxvkBufferRing: Failed to allocate page memory");
+      vkd->vkDestroyBuffer(vkd->device(), page->handle.buffer, nullptr);
+      return nullptr;
+    }
+
+    std::memset(page->handle.memory.mapPtr(0), 0, PageSize);
+
+    Page* result = page.get();
+    m_pages.insert({ result->handle.buffer, std::move(page) });
+    return result;
+  }
+
+
+  void DxvkBufferRing::recyclePage(
+          Page*                 page) {
+    Pool& pool = m_pools[page->poolIndex];
+
+    if (pool.freePages.size() < MaxFreePages) {
+      page->offset = 0;
+      pool.freePages.push_back(page);
+    } else {
+      VkBuffer handle = page->handle.buffer;
+
+      auto vkd = m_device->vkd();
+      vkd->vkDestroyBuffer(vkd->device(), handle, nullptr);
+
+      m_pages.erase(handle);
+    }
+  }
+
+
+  uint32_t DxvkBufferRing::getPoolIndex(
+          VkMemoryPropertyFlags memFlags) {
+    for (uint32_t i = 0; i < m_pools.size(); i++) {
+      if (m_pools[i].memFlags == memFlags)
+        return i;
+    }
+
+    Pool pool;
+    pool.memFlags = memFlags;
+
+    m_pools.push_back(std::move(pool));
+    return uint32_t(m_pools.size() - 1);
+  }
+
+}
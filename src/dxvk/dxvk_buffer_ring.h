@@ -0,0 +1,122 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Buffer ring allocator
+   *
+   * Device-wide linear allocator for small, host-visible
+   * buffer slices, used when a dynamic buffer runs out of
+   * free slices. Slices are allocated from large pages with
+   * a bump pointer. Each page counts the slices still in use,
+   * and gets recycled in its entirety once it has been filled
+   * up and all of its slices have been returned, i.e. once
+   * the GPU is done with them and their buffers got renamed.
+   */
+  class DxvkBufferRing {
+    /// Size of a single page
+    constexpr static VkDeviceSize PageSize = 1 << 20;
+    /// Maximum slice size to allocate from pages
+    constexpr static VkDeviceSize MaxSliceSize = 16 << 10;
+    /// Number of empty pages to keep around per memory type
+    constexpr static size_t MaxFreePages = 2;
+    /// Buffer usage supported by ring pages
+    constexpr static VkBufferUsageFlags PageUsage =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+      VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  public:
+
+    DxvkBufferRing(
+            DxvkDevice*           device,
+            DxvkMemoryAllocator&  memAlloc);
+
+    ~DxvkBufferRing();
+
+    /**
+     * \brief Checks whether a buffer can use the ring
+     *
+     * Texel buffers are not supported since buffer views
+     * cache one Vulkan view per slice, and ring slices are
+     * not reused at the same offsets.
+     * \param [in] usage Buffer usage flags
+     * \param [in] memFlags Buffer memory flags
+     * \param [in] sliceStride Aligned slice size
+     * \returns \c true if slices can be allocated
+     */
+    static bool supportsBuffer(
+            VkBufferUsageFlags    usage,
+            VkMemoryPropertyFlags memFlags,
+            VkDeviceSize          sliceStride);
+
+    /**
+     * \brief Allocates a buffer slice
+     *
+     * \param [in] memFlags Memory property flags
+     * \param [in] length Slice length, in bytes
+     * \param [in] align Required slice alignment
+     * \param [out] slice The allocated slice
+     * \returns \c true on success, \c false if no
+     *    page could be created for the allocation
+     */
+    bool allocSlice(
+            VkMemoryPropertyFlags   memFlags,
+            VkDeviceSize            length,
+            VkDeviceSize            align,
+            DxvkBufferSliceHandle&  slice);
+
+    /**
+     * \brief Frees a buffer slice
+     *
+     * \param [in] slice The slice to free
+     * \returns \c true if the slice was allocated
+     *    from the ring, \c false otherwise.
+     */
+    bool freeSlice(
+      const DxvkBufferSliceHandle&  slice);
+
+  private:
+
+    struct Page {
+      DxvkBufferHandle      handle;
+      uint32_t              poolIndex = 0;
+      uint32_t              liveCount = 0;
+      VkDeviceSize          offset    = 0;
+    };
+
+    struct Pool {
+      VkMemoryPropertyFlags memFlags  = 0;
+      Page*                 current   = nullptr;
+      std::vector<Page*>    freePages;
+    };
+
+    DxvkDevice*             m_device;
+    DxvkMemoryAllocator*    m_memAlloc;
+
+    dxvk::mutex             m_mutex;
+    std::vector<Pool>       m_pools;
+
+    std::unordered_map<VkBuffer, std::unique_ptr<Page>> m_pages;
+
+    Page* createPage(
+            uint32_t              poolIndex);
+
+    void recyclePage(
+            Page*                 page);
+
+    uint32_t getPoolIndex(
+            VkMemoryPropertyFlags memFlags);
+
+  };
+
+}
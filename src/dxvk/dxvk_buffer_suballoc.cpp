@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cstring>
+
+#include "dxvk_buffer_suballoc.h"
+#include "dxvk_device.h"
+
+namespace dxvk {
+
+  DxvkBufferSuballocator::DxvkBufferSuballocator(
+          DxvkDevice*           device,
+          DxvkMemoryAllocator&  memAlloc)
+  : m_device(device), m_memAlloc(&memAlloc) {
+
+  }
+
+
+  DxvkBufferSuballocator::~DxvkBufferSuballocator() {
+    auto vkd = m_device->vkd();
+
+    for (const auto& chunk : m_chunks)
+      vkd->vkDestroyBuffer(vkd->device(), chunk.second->handle.buffer, nullptr);
+  }
+
+
+  bool DxvkBufferSuballocator::supportsBuffer(
+    const DxvkBufferCreateInfo& info,
+          VkMemoryPropertyFlags memFlags,
+          VkDeviceSize          sliceStride) {
+    constexpr VkAccessFlags writeAccess =
+      VK_ACCESS_SHADER_WRITE_BIT |
+      VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT |
+      VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
+
+    return info.size && !info.flags
+        && !(info.usage & ~ChunkUsage)
+        && !(info.access & writeAccess)
+        && (memFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        && sliceStride <= MaxSliceSize;
+  }
+
+
+  bool DxvkBufferSuballocator::allocSlice(
+          VkBufferUsageFlags      usage,
+          VkMemoryPropertyFlags   memFlags,
+          DxvkMemoryCategory      category,
+          VkDeviceSize            length,
+          VkDeviceSize            align,
+          DxvkBufferSliceHandle&  slice) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    uint32_t poolIndex = getPoolIndex(usage, memFlags, category);
+    Pool& pool = m_pools[poolIndex];
+
+    VkDeviceSize size = dxvk::align(length, align);
+
+    // Newer chunks are more likely to have space left,
+    // so search the list back to front
+    Chunk* chunk = nullptr;
+    VkDeviceSize offset = DxvkTlsfAllocator::InvalidOffset;
+
+    for (auto i = pool.chunks.rbegin(); i != pool.chunks.rend(); i++) {
+      offset = (*i)->allocator.alloc(size, align);
+
+      if (offset != DxvkTlsfAllocator::InvalidOffset) {
+        chunk = *i;
+        break;
+      }
+    }
+
+    if (!chunk) {
+      chunk = createChunk(poolIndex);
+
+      if (!chunk)
+        return false;
+
+      offset = chunk->allocator.alloc(size, align);
+    }
+
+    slice.handle = chunk->handle.buffer;
+    slice.offset = offset;
+    slice.length = length;
+    slice.mapPtr = chunk->handle.memory.mapPtr(offset);
+    return true;
+  }
+
+
+  void DxvkBufferSuballocator::freeSlice(
+    const DxvkBufferSliceHandle&  slice) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_chunks.find(slice.handle);
+
+    if (entry == m_chunks.end())
+      return;
+
+    Chunk* chunk = entry->second.get();
+    chunk->allocator.free(slice.offset);
+
+    if (!chunk->allocator.isEmpty())
+      return;
+
+    // Keep a small number of empty chunks around so that
+    // applications that stream small buffers do not keep
+    // creating and destroying chunks
+    const Pool& pool = m_pools[chunk->poolIndex];
+
+    size_t emptyCount = std::count_if(pool.chunks.begin(), pool.chunks.end(),
+      [] (const Chunk* c) { return c->allocator.isEmpty(); });
+
+    if (emptyCount > MaxFreeChunks)
+      destroyChunk(chunk);
+  }
+
+
+  DxvkBufferSuballocator::Chunk* DxvkBufferSuballocator::createChunk(
+          uint32_t              poolIndex) {
+    auto vkd = m_device->vkd();
+
+    const Pool& pool = m_pools[poolIndex];
+
+    VkBufferCreateInfo info;
+    info.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext                 = nullptr;
+    info.flags                 = 0;
+    info.size                  = ChunkSize;
+    info.usage                 = pool.usage;
+
+    if (m_device->canUseBufferDeviceAddress())
+      info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    info.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices   = nullptr;
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->poolIndex = poolIndex;
+
+    if (vkd->vkCreateBuffer(vkd->device(),
+          &info, nullptr, &chunk->handle.buffer) != VK_SUCCESS) {
+      Logger::err("DxvkBufferSuballocator: Failed to create buffer");
+      return nullptr;
+    }
+
+    VkMemoryRequirements memReq;
+    vkd->vkGetBufferMemoryRequirements(vkd->device(),
+      chunk->handle.buffer, &memReq);
+
+    VkMemoryDedicatedRequirements dedicatedRequirements;
+    dedicatedRequirements.sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    dedicatedRequirements.pNext                       = VK_NULL_HANDLE;
+    dedicatedRequirements.prefersDedicatedAllocation  = VK_FALSE;
+    dedicatedRequirements.requiresDedicatedAllocation = VK_FALSE;
+
+    VkMemoryDedicatedAllocateInfo dedMemoryAllocInfo;
+    dedMemoryAllocInfo.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedMemoryAllocInfo.pNext  = VK_NULL_HANDLE;
+    dedMemoryAllocInfo.buffer = chunk->handle.buffer;
+    dedMemoryAllocInfo.image  = VK_NULL_HANDLE;
+
+    chunk->handle.memory = m_memAlloc->alloc(&memReq,
+      dedicatedRequirements, dedMemoryAllocInfo,
+      pool.memFlags, DxvkMemoryFlag::GpuReadable,
+      pool.category);
+
+    if (!chunk->handle.memory || vkd->vkBindBufferMemory(vkd->device(), chunk->handle.buffer,
+          chunk->handle.memory.memory(), chunk->handle.memory.offset()) != VK_SUCCESS) {
+      Logger::err("DxvkBufferSuballocator: Failed to allocate chunk memory");
+      vkd->vkDestroyBuffer(vkd->device(), chunk->handle.buffer, nullptr);
+      return nullptr;
+    }
+
+    if (pool.memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+      std::memset(chunk->handle.memory.mapPtr(0), 0, ChunkSize);
+
+    Chunk* result = chunk.get();
+    m_pools[poolIndex].chunks.push_back(result);
+    m_chunks.insert({ result->handle.buffer, std::move(chunk) });
+    return result;
+  }
+
+
+  void DxvkBufferSuballocator::destroyChunk(
+          Chunk*                chunk) {
+    Pool& pool = m_pools[chunk->poolIndex];
+
+    auto entry = std::find(pool.chunks.begin(), pool.chunks.end(), chunk);
+
+    if (entry != pool.chunks.end())
+      pool.chunks.erase(entry);
+
+    VkBuffer handle = chunk->handle.buffer;
+
+    auto vkd = m_device->vkd();
+    vkd->vkDestroyBuffer(vkd->device(), handle, nullptr);
+
+    m_chunks.erase(handle);
+  }
+
+
+  uint32_t DxvkBufferSuballocator::getPoolIndex(
+          VkBufferUsageFlags    usage,
+          VkMemoryPropertyFlags memFlags,
+          DxvkMemoryCategory    category) {
+    for (uint32_t i = 0; i < m_pools.size(); i++) {
+      if (m_pools[i].usage    == usage
+       && m_pools[i].memFlags == memFlags
+       && m_pools[i].category == category)
+        return i;
+    }
+
+    Pool pool;
+    pool.usage    = usage;
+    pool.memFlags = memFlags;
+    pool.category = category;
+
+    m_pools.push_back(std::move(pool));
+    return uint32_t(m_pools.size() - 1);
+  }
+
+}
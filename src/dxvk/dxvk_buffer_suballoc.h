@@ -0,0 +1,137 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_allocator.h"
+#include "dxvk_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Buffer suballocator
+   *
+   * Device-wide allocator that places the initial slice of
+   * small, read-only buffers into large shared Vulkan buffers,
+   * so that applications creating thousands of tiny vertex,
+   * index or constant buffers do not need one Vulkan buffer
+   * and one memory allocation each. Buffers are grouped into
+   * pools by usage, memory type and memory category, and each
+   * chunk manages its range with a TLSF allocator.
+   *
+   * Slices are only returned when the owning \c DxvkBuffer
+   * is destroyed, i.e. once no command list references it.
+   */
+  class DxvkBufferSuballocator {
+    /// Size of a single chunk
+    constexpr static VkDeviceSize ChunkSize = 2 << 20;
+    /// Maximum slice size to suballocate
+    constexpr static VkDeviceSize MaxSliceSize = 64 << 10;
+    /// Number of empty chunks to keep around per pool
+    constexpr static size_t MaxFreeChunks = 1;
+    /// Buffer usage supported by shared chunks
+    constexpr static VkBufferUsageFlags ChunkUsage =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+      VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
+      VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  public:
+
+    DxvkBufferSuballocator(
+            DxvkDevice*           device,
+            DxvkMemoryAllocator&  memAlloc);
+
+    ~DxvkBufferSuballocator();
+
+    /**
+     * \brief Checks whether a buffer can be suballocated
+     *
+     * Buffers that the GPU can write outside of transfer
+     * operations are not supported since memory priority
+     * is tracked per allocation. Sparse buffers are never
+     * suballocated.
+     * \param [in] info Buffer create info
+     * \param [in] memFlags Buffer memory flags
+     * \param [in] sliceStride Aligned slice size
+     * \returns \c true if the buffer can be suballocated
+     */
+    static bool supportsBuffer(
+      const DxvkBufferCreateInfo& info,
+            VkMemoryPropertyFlags memFlags,
+            VkDeviceSize          sliceStride);
+
+    /**
+     * \brief Allocates a buffer slice
+     *
+     * \param [in] usage Buffer usage flags
+     * \param [in] memFlags Memory property flags
+     * \param [in] category Memory category
+     * \param [in] length Slice length, in bytes
+     * \param [in] align Required slice alignment
+     * \param [out] slice The allocated slice
+     * \returns \c true on success, \c false if no
+     *    chunk could be created for the allocation
+     */
+    bool allocSlice(
+            VkBufferUsageFlags      usage,
+            VkMemoryPropertyFlags   memFlags,
+            DxvkMemoryCategory      category,
+            VkDeviceSize            length,
+            VkDeviceSize            align,
+            DxvkBufferSliceHandle&  slice);
+
+    /**
+     * \brief Frees a buffer slice
+     *
+     * Must only be called once the GPU no longer
+     * accesses the slice, since the range can be
+     * handed out to another buffer right away.
+     * \param [in] slice Slice returned by \c allocSlice
+     */
+    void freeSlice(
+      const DxvkBufferSliceHandle&  slice);
+
+  private:
+
+    struct Chunk {
+      Chunk() : allocator(ChunkSize) { }
+
+      DxvkBufferHandle      handle;
+      DxvkTlsfAllocator     allocator;
+      uint32_t              poolIndex = 0;
+    };
+
+    struct Pool {
+      VkBufferUsageFlags    usage     = 0;
+      VkMemoryPropertyFlags memFlags  = 0;
+      DxvkMemoryCategory    category  = DxvkMemoryCategory::Auto;
+      std::vector<Chunk*>   chunks;
+    };
+
+    DxvkDevice*             m_device;
+    DxvkMemoryAllocator*    m_memAlloc;
+
+    dxvk::mutex             m_mutex;
+    std::vector<Pool>       m_pools;
+
+    std::unordered_map<VkBuffer, std::unique_ptr<Chunk>> m_chunks;
+
+    Chunk* createChunk(
+            uint32_t              poolIndex);
+
+    void destroyChunk(
+            Chunk*                chunk);
+
+    uint32_t getPoolIndex(
+            VkBufferUsageFlags    usage,
+            VkMemoryPropertyFlags memFlags,
+            DxvkMemoryCategory    category);
+
+  };
+
+}
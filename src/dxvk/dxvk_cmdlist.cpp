@@ -7,6 +7,7 @@ namespace dxvk {
   : m_device        (device),
     m_vkd           (device->vkd()),
     m_vki           (device->instance()->vki()),
+    m_hasSync2      (device->canUseSynchronization2()),
     m_cmdBuffersUsed(0) {
     const auto& graphicsQueue = m_device->queues().graphics;
     const auto& transferQueue = m_device->queues().transfer;
@@ -54,12 +55,12 @@ namespace dxvk {
      || m_vkd->vkAllocateCommandBuffers(m_vkd->device(), &cmdInfoDma, &m_sdmaBuffer) != VK_SUCCESS)
       throw DxvkError("DxvkCommandList: Failed to allocate command buffer");
     
-    if (m_device->hasDedicatedTransferQueue()) {
-      VkSemaphoreCreateInfo semInfo;
-      semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-      semInfo.pNext = nullptr;
-      semInfo.flags = 0;
+    VkSemaphoreCreateInfo semInfo;
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semInfo.pNext = nullptr;
+    semInfo.flags = 0;
 
+    if (m_device->hasDedicatedTransferQueue()) {
       if (m_vkd->vkCreateSemaphore(m_vkd->device(), &semInfo, nullptr, &m_sdmaSemaphore) != VK_SUCCESS)
         throw DxvkError("DxvkCommandList: Failed to create semaphore");
     }
@@ -80,7 +81,9 @@ namespace dxvk {
   
   VkResult DxvkCommandList::submit(
           VkSemaphore     waitSemaphore,
-          VkSemaphore     wakeSemaphore) {
+          VkSemaphore     wakeSemaphore,
+          VkSemaphore     timelineSemaphore,
+          uint64_t        timelineValue) {
     const auto& graphics = m_device->queues().graphics;
     const auto& transfer = m_device->queues().transfer;
 
@@ -103,21 +106,41 @@ namespace dxvk {
       }
     }
 
-    if (m_cmdBuffersUsed.test(DxvkCmdBuffer::InitBuffer))
-      info.cmdBuffers[info.cmdBufferCount++] = m_initBuffer;
-    if (m_cmdBuffersUsed.test(DxvkCmdBuffer::ExecBuffer))
-      info.cmdBuffers[info.cmdBufferCount++] = m_execBuffer;
-    
-    if (waitSemaphore) {
-      info.waitSync[info.waitCount] = waitSemaphore;
-      info.waitMask[info.waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-      info.waitCount += 1;
-    }
+    appendGraphicsSubmission(info, waitSemaphore,
+      wakeSemaphore, timelineSemaphore, timelineValue);
 
-    if (wakeSemaphore)
-      info.wakeSync[info.wakeCount++] = wakeSemaphore;
-    
-    return submitToQueue(graphics.queueHandle, m_fence, info);
+    VkFence fence = timelineSemaphore ? VK_NULL_HANDLE : m_fence;
+
+    if (unlikely(!m_fenceSignals.empty() || !m_fenceWaits.empty()))
+      return submitToQueueWithFences(graphics.queueHandle, fence, info);
+
+    return submitToQueue(graphics.queueHandle, fence, info);
+  }
+  
+  
+  bool DxvkCommandList::canBatchSubmission() const {
+    return m_fenceSignals.empty()
+        && m_fenceWaits.empty()
+        && !(m_cmdBuffersUsed.test(DxvkCmdBuffer::SdmaBuffer)
+          && m_device->hasDedicatedTransferQueue());
+  }
+
+
+  DxvkQueueSubmission DxvkCommandList::getBatchSubmission(
+          VkSemaphore     waitSemaphore,
+          VkSemaphore     wakeSemaphore,
+          VkSemaphore     timelineSemaphore,
+          uint64_t        timelineValue) const {
+    DxvkQueueSubmission info = DxvkQueueSubmission();
+
+    // Without a dedicated transfer queue, the
+    // SDMA buffer goes to the graphics queue
+    if (m_cmdBuffersUsed.test(DxvkCmdBuffer::SdmaBuffer))
+      info.cmdBuffers[info.cmdBufferCount++] = m_sdmaBuffer;
+
+    appendGraphicsSubmission(info, waitSemaphore,
+      wakeSemaphore, timelineSemaphore, timelineValue);
+    return info;
   }
   
   
@@ -141,8 +164,16 @@ namespace dxvk {
     info.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     info.pInheritanceInfo = nullptr;
     
-    if ((m_graphicsPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_graphicsPool, 0) != VK_SUCCESS)
-     || (m_transferPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_transferPool, 0) != VK_SUCCESS))
+    // Command pools keep their memory across resets, which is what
+    // we want most of the time. Periodically release it so that a
+    // single large submission does not pin memory indefinitely.
+    VkCommandPoolResetFlags resetFlags = 0;
+
+    if (!((++m_resetCount) % ReleaseInterval))
+      resetFlags |= VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT;
+
+    if ((m_graphicsPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_graphicsPool, resetFlags) != VK_SUCCESS)
+     || (m_transferPool && m_vkd->vkResetCommandPool(m_vkd->device(), m_transferPool, resetFlags) != VK_SUCCESS))
       Logger::err("DxvkCommandList: Failed to reset command buffer");
     
     if (m_vkd->vkBeginCommandBuffer(m_execBuffer, &info) != VK_SUCCESS
@@ -160,6 +191,9 @@ namespace dxvk {
   
   
   void DxvkCommandList::endRecording() {
+    if (m_pendingCopy.type != DxvkPendingCopyType::None)
+      recordPendingCopy();
+
     if (m_vkd->vkEndCommandBuffer(m_execBuffer) != VK_SUCCESS
      || m_vkd->vkEndCommandBuffer(m_initBuffer) != VK_SUCCESS
      || m_vkd->vkEndCommandBuffer(m_sdmaBuffer) != VK_SUCCESS)
@@ -168,6 +202,11 @@ namespace dxvk {
   
   
   void DxvkCommandList::reset() {
+    // Mark query results as available and return query
+    // handles first, since releasing query objects may
+    // recycle handles whose results we still track
+    m_gpuQueryTracker.reset();
+
     // Free resources and other objects
     // that are no longer in use
     m_resources.reset();
@@ -175,10 +214,13 @@ namespace dxvk {
     // Return buffer memory slices
     m_bufferTracker.reset();
 
-    // Return query and event handles
-    m_gpuQueryTracker.reset();
+    // Return event handles
     m_gpuEventTracker.reset();
 
+    // Fence operations have been executed on submission
+    m_fenceSignals.clear();
+    m_fenceWaits.clear();
+
     // Less important stuff
     m_signalTracker.reset();
     m_statCounters.reset();
@@ -190,6 +232,34 @@ namespace dxvk {
   }
 
 
+  void DxvkCommandList::appendGraphicsSubmission(
+          DxvkQueueSubmission&  info,
+          VkSemaphore           waitSemaphore,
+          VkSemaphore           wakeSemaphore,
+          VkSemaphore           timelineSemaphore,
+          uint64_t              timelineValue) const {
+    if (m_cmdBuffersUsed.test(DxvkCmdBuffer::InitBuffer))
+      info.cmdBuffers[info.cmdBufferCount++] = m_initBuffer;
+    if (m_cmdBuffersUsed.test(DxvkCmdBuffer::ExecBuffer))
+      info.cmdBuffers[info.cmdBufferCount++] = m_execBuffer;
+    
+    if (waitSemaphore) {
+      info.waitSync[info.waitCount] = waitSemaphore;
+      info.waitMask[info.waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      info.waitCount += 1;
+    }
+
+    if (wakeSemaphore)
+      info.wakeSync[info.wakeCount++] = wakeSemaphore;
+
+    if (timelineSemaphore) {
+      info.wakeSync[info.wakeCount] = timelineSemaphore;
+      info.wakeValue[info.wakeCount] = timelineValue;
+      info.wakeCount += 1;
+    }
+  }
+
+
   VkResult DxvkCommandList::submitToQueue(
           VkQueue               queue,
           VkFence               fence,
@@ -204,19 +274,196 @@ namespace dxvk {
     submitInfo.pCommandBuffers      = info.cmdBuffers;
     submitInfo.signalSemaphoreCount = info.wakeCount;
     submitInfo.pSignalSemaphores    = info.wakeSync;
+
+    // Signal values are ignored for binary semaphores, but if any
+    // timeline semaphore is signaled, all values must be provided
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+
+    for (uint32_t i = 0; i < info.wakeCount; i++) {
+      if (info.wakeValue[i]) {
+        timelineInfo.signalSemaphoreValueCount = info.wakeCount;
+        timelineInfo.pSignalSemaphoreValues    = info.wakeValue;
+        submitInfo.pNext = &timelineInfo;
+        break;
+      }
+    }
     
     return m_vkd->vkQueueSubmit(queue, 1, &submitInfo, fence);
   }
+
+
+  VkResult DxvkCommandList::submitToQueueWithFences(
+          VkQueue               queue,
+          VkFence               fence,
+    const DxvkQueueSubmission&  info) {
+    std::vector<VkSemaphore>          waitSync(info.waitSync, info.waitSync + info.waitCount);
+    std::vector<VkPipelineStageFlags> waitMask(info.waitMask, info.waitMask + info.waitCount);
+    std::vector<uint64_t>             waitValue(info.waitCount, 0);
+
+    std::vector<VkSemaphore>          wakeSync(info.wakeSync, info.wakeSync + info.wakeCount);
+    std::vector<uint64_t>             wakeValue(info.wakeValue, info.wakeValue + info.wakeCount);
+
+    for (const auto& entry : m_fenceWaits) {
+      waitSync.push_back(entry.fence->handle());
+      waitMask.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+      waitValue.push_back(entry.value);
+    }
+
+    for (const auto& entry : m_fenceSignals) {
+      wakeSync.push_back(entry.fence->handle());
+      wakeValue.push_back(entry.value);
+    }
+
+    // Values for binary semaphores are ignored
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+    timelineInfo.waitSemaphoreValueCount   = waitValue.size();
+    timelineInfo.pWaitSemaphoreValues      = waitValue.data();
+    timelineInfo.signalSemaphoreValueCount = wakeValue.size();
+    timelineInfo.pSignalSemaphoreValues    = wakeValue.data();
+
+    VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO, &timelineInfo };
+    submitInfo.waitSemaphoreCount   = waitSync.size();
+    submitInfo.pWaitSemaphores      = waitSync.data();
+    submitInfo.pWaitDstStageMask    = waitMask.data();
+    submitInfo.commandBufferCount   = info.cmdBufferCount;
+    submitInfo.pCommandBuffers      = info.cmdBuffers;
+    submitInfo.signalSemaphoreCount = wakeSync.size();
+    submitInfo.pSignalSemaphores    = wakeSync.data();
+
+    return m_vkd->vkQueueSubmit(queue, 1, &submitInfo, fence);
+  }
   
   void DxvkCommandList::cmdBeginDebugUtilsLabel(VkDebugUtilsLabelEXT *pLabelInfo) {
+    flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
     m_vki->vkCmdBeginDebugUtilsLabelEXT(m_execBuffer, pLabelInfo);
   }
 
   void DxvkCommandList::cmdEndDebugUtilsLabel() {
+    flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
     m_vki->vkCmdEndDebugUtilsLabelEXT(m_execBuffer);
   }
 
   void DxvkCommandList::cmdInsertDebugUtilsLabel(VkDebugUtilsLabelEXT *pLabelInfo) {
+    flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
     m_vki->vkCmdInsertDebugUtilsLabelEXT(m_execBuffer, pLabelInfo);
   }
+
+
+  void DxvkCommandList::recordPendingCopy() {
+    VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+
+    switch (m_pendingCopy.cmdBuffer) {
+      case DxvkCmdBuffer::ExecBuffer: cmdBuffer = m_execBuffer; break;
+      case DxvkCmdBuffer::InitBuffer: cmdBuffer = m_initBuffer; break;
+      case DxvkCmdBuffer::SdmaBuffer: cmdBuffer = m_sdmaBuffer; break;
+    }
+
+    switch (m_pendingCopy.type) {
+      case DxvkPendingCopyType::None:
+        return;
+
+      case DxvkPendingCopyType::Buffer:
+        m_vkd->vkCmdCopyBuffer(cmdBuffer,
+          m_pendingCopy.srcBuffer, m_pendingCopy.dstBuffer,
+          m_pendingBufferCopies.size(), m_pendingBufferCopies.data());
+        m_pendingBufferCopies.clear();
+        break;
+
+      case DxvkPendingCopyType::BufferToImage:
+        m_vkd->vkCmdCopyBufferToImage(cmdBuffer,
+          m_pendingCopy.srcBuffer, m_pendingCopy.dstImage, m_pendingCopy.dstLayout,
+          m_pendingBufferImageCopies.size(), m_pendingBufferImageCopies.data());
+        m_pendingBufferImageCopies.clear();
+        break;
+
+      case DxvkPendingCopyType::Image:
+        m_vkd->vkCmdCopyImage(cmdBuffer,
+          m_pendingCopy.srcImage, m_pendingCopy.srcLayout,
+          m_pendingCopy.dstImage, m_pendingCopy.dstLayout,
+          m_pendingImageCopies.size(), m_pendingImageCopies.data());
+        m_pendingImageCopies.clear();
+        break;
+    }
+
+    m_pendingCopy = DxvkPendingCopy();
+  }
+
+
+  DxvkCommandListPool::DxvkCommandListPool(DxvkDevice* device)
+  : m_device(device) {
+
+  }
+
+
+  DxvkCommandListPool::~DxvkCommandListPool() {
+
+  }
+
+
+  Rc<DxvkCommandList> DxvkCommandListPool::allocCommandList() {
+    std::vector<Rc<DxvkCommandList>> trimmed;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (!m_freeLists.empty()) {
+        Rc<DxvkCommandList> cmdList = std::move(m_freeLists.back());
+        m_freeLists.pop_back();
+
+        m_minFree = std::min(m_minFree, uint32_t(m_freeLists.size()));
+
+        // If some lists sat in the pool for the entire interval,
+        // they are not needed to sustain the current workload
+        if (++m_allocCount == TrimInterval) {
+          uint32_t excess = std::min(m_minFree, m_capacity - MinCapacity);
+
+          for (uint32_t i = 0; i < excess; i++) {
+            trimmed.push_back(std::move(m_freeLists.back()));
+            m_freeLists.pop_back();
+          }
+
+          m_capacity -= excess;
+          m_liveCount -= excess;
+
+          m_allocCount = 0;
+          m_minFree = uint32_t(m_freeLists.size());
+        }
+
+        return cmdList;
+      }
+
+      // Lists are allocated faster than they are retired,
+      // so make sure to keep the new one around later on
+      m_liveCount += 1;
+      m_capacity = std::max(m_capacity, std::min(m_liveCount, MaxCapacity));
+      m_minFree = 0;
+    }
+
+    return new DxvkCommandList(m_device);
+  }
+
+
+  void DxvkCommandListPool::recycleCommandList(
+    const Rc<DxvkCommandList>&  cmdList) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_freeLists.size() < m_capacity)
+      m_freeLists.push_back(cmdList);
+    else
+      m_liveCount -= 1;
+  }
+
+
+  DxvkCommandListPoolStats DxvkCommandListPool::getStats() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    DxvkCommandListPoolStats result;
+    result.liveCount = m_liveCount;
+    result.freeCount = uint32_t(m_freeLists.size());
+    result.capacity  = m_capacity;
+    return result;
+  }
+
 }
@@ -5,6 +5,7 @@
 #include "dxvk_bind_mask.h"
 #include "dxvk_buffer.h"
 #include "dxvk_descriptor.h"
+#include "dxvk_fence.h"
 #include "dxvk_gpu_event.h"
 #include "dxvk_gpu_query.h"
 #include "dxvk_lifetime.h"
@@ -29,6 +30,47 @@ namespace dxvk {
   };
   
   using DxvkCmdBufferFlags = Flags<DxvkCmdBuffer>;
+
+
+  /**
+   * \brief Pending copy type
+   */
+  enum class DxvkPendingCopyType : uint32_t {
+    None,
+    Buffer,
+    BufferToImage,
+    Image,
+  };
+
+
+  /**
+   * \brief Pending copy
+   *
+   * Identifies the resources of a copy command that has
+   * not been recorded yet. Consecutive copies with the
+   * same resources are recorded as one command.
+   */
+  struct DxvkPendingCopy {
+    DxvkPendingCopyType type      = DxvkPendingCopyType::None;
+    DxvkCmdBuffer       cmdBuffer = DxvkCmdBuffer::ExecBuffer;
+    VkBuffer            srcBuffer = VK_NULL_HANDLE;
+    VkImage             srcImage  = VK_NULL_HANDLE;
+    VkImageLayout       srcLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkBuffer            dstBuffer = VK_NULL_HANDLE;
+    VkImage             dstImage  = VK_NULL_HANDLE;
+    VkImageLayout       dstLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    bool eq(const DxvkPendingCopy& other) const {
+      return type      == other.type
+          && cmdBuffer == other.cmdBuffer
+          && srcBuffer == other.srcBuffer
+          && srcImage  == other.srcImage
+          && srcLayout == other.srcLayout
+          && dstBuffer == other.dstBuffer
+          && dstImage  == other.dstImage
+          && dstLayout == other.dstLayout;
+    }
+  };
   
   /**
    * \brief Queue submission info
@@ -42,7 +84,8 @@ namespace dxvk {
     VkSemaphore           waitSync[2];
     VkPipelineStageFlags  waitMask[2];
     uint32_t              wakeCount;
-    VkSemaphore           wakeSync[2];
+    VkSemaphore           wakeSync[3];
+    uint64_t              wakeValue[3];
     uint32_t              cmdBufferCount;
     VkCommandBuffer       cmdBuffers[4];
   };
@@ -57,7 +100,9 @@ namespace dxvk {
    * are no longer used may get destroyed.
    */
   class DxvkCommandList : public RcObject {
-    
+    /// Number of command pool resets between resets
+    /// that release memory back to the driver
+    constexpr static uint32_t ReleaseInterval = 256;
   public:
     
     DxvkCommandList(DxvkDevice* device);
@@ -66,20 +111,58 @@ namespace dxvk {
     /**
      * \brief Submits command list
      * 
-     * \param [in] queue Device queue
+     * If a timeline semaphore is specified, it will be
+     * signaled to the given value once the command list
+     * completes execution, and the fence is not used.
      * \param [in] waitSemaphore Semaphore to wait on
      * \param [in] wakeSemaphore Semaphore to signal
+     * \param [in] timelineSemaphore Timeline semaphore to signal
+     * \param [in] timelineValue Timeline semaphore value
      * \returns Submission status
      */
     VkResult submit(
             VkSemaphore     waitSemaphore,
-            VkSemaphore     wakeSemaphore);
+            VkSemaphore     wakeSemaphore,
+            VkSemaphore     timelineSemaphore,
+            uint64_t        timelineValue);
+    
+    /**
+     * \brief Checks whether the command list can be batched
+     *
+     * Command lists that need to submit work to the
+     * dedicated transfer queue require more than
+     * one queue operation and must be submitted on their own.
+     * The same goes for command lists with fence operations.
+     * \returns \c true if the command list can be submitted
+     *    together with other command lists in one call
+     */
+    bool canBatchSubmission() const;
+    
+    /**
+     * \brief Retrieves submission info for batched submission
+     *
+     * Only valid if \ref canBatchSubmission returns \c true.
+     * The command list will signal the given timeline value
+     * upon completion, so that no fence is required.
+     * \param [in] waitSemaphore Semaphore to wait on
+     * \param [in] wakeSemaphore Semaphore to signal
+     * \param [in] timelineSemaphore Timeline semaphore to signal
+     * \param [in] timelineValue Timeline semaphore value
+     * \returns Queue submission info
+     */
+    DxvkQueueSubmission getBatchSubmission(
+            VkSemaphore     waitSemaphore,
+            VkSemaphore     wakeSemaphore,
+            VkSemaphore     timelineSemaphore,
+            uint64_t        timelineValue) const;
     
     /**
      * \brief Synchronizes command buffer execution
      * 
      * Waits for the fence associated with
      * this command buffer to get signaled.
+     * Must not be used if the command list
+     * was submitted with a timeline semaphore.
      * \returns Synchronization status
      */
     VkResult synchronize();
@@ -105,6 +188,14 @@ namespace dxvk {
     void addStatCtr(DxvkStatCounter ctr, uint64_t val) {
       m_statCounters.addCtr(ctr, val);
     }
+
+    /**
+     * \brief Checks whether sync2 barriers can be used
+     * \returns \c true if \c cmdPipelineBarrier2 is supported
+     */
+    bool hasSynchronization2() const {
+      return m_hasSync2;
+    }
     
     /**
      * \brief Begins recording
@@ -172,6 +263,17 @@ namespace dxvk {
     void trackGpuQuery(DxvkGpuQueryHandle handle) {
       m_gpuQueryTracker.trackQuery(handle);
     }
+
+    /**
+     * \brief Tracks a copied GPU query result
+     *
+     * The result will be marked as available once
+     * the command buffer has finished executing.
+     * \param [in] handle The query handle
+     */
+    void trackGpuQueryResult(DxvkGpuQueryHandle handle) {
+      m_gpuQueryTracker.trackResult(handle);
+    }
     
     /**
      * \brief Queues signal
@@ -185,6 +287,32 @@ namespace dxvk {
       m_signalTracker.add(signal, value);
     }
 
+    /**
+     * \brief Signals a fence on submission
+     *
+     * The fence will be signaled to the given value
+     * once all commands in this command list have
+     * completed execution.
+     * \param [in] fence The fence
+     * \param [in] value Value to signal
+     */
+    void signalFence(const Rc<DxvkFence>& fence, uint64_t value) {
+      m_fenceSignals.push_back({ fence, value });
+    }
+
+    /**
+     * \brief Waits for a fence on submission
+     *
+     * None of the commands in this command list will
+     * start executing before the fence reaches the
+     * given value.
+     * \param [in] fence The fence
+     * \param [in] value Value to wait for
+     */
+    void waitFence(const Rc<DxvkFence>& fence, uint64_t value) {
+      m_fenceWaits.push_back({ fence, value });
+    }
+
     /**
      * \brief Notifies resources and signals
      */
@@ -223,12 +351,16 @@ namespace dxvk {
 
     void cmdBeginConditionalRendering(
       const VkConditionalRenderingBeginInfoEXT* pConditionalRenderingBegin) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdBeginConditionalRenderingEXT(
         m_execBuffer, pConditionalRenderingBegin);
     }
 
 
     void cmdEndConditionalRendering() {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdEndConditionalRenderingEXT(m_execBuffer);
     }
 
@@ -238,6 +370,8 @@ namespace dxvk {
             VkQueryPool             queryPool,
             uint32_t                query,
             VkQueryControlFlags     flags) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdBeginQuery(m_execBuffer,
         queryPool, query, flags);
     }
@@ -248,6 +382,8 @@ namespace dxvk {
             uint32_t                query,
             VkQueryControlFlags     flags,
             uint32_t                index) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdBeginQueryIndexedEXT(
         m_execBuffer, queryPool, query, flags, index);
     }
@@ -255,6 +391,8 @@ namespace dxvk {
 
     void cmdBeginRendering(
       const VkRenderingInfoKHR*     pRenderingInfo) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdBeginRenderingKHR(m_execBuffer, pRenderingInfo);
     }
 
@@ -295,6 +433,18 @@ namespace dxvk {
     }
 
 
+    void cmdPushDescriptorSet(
+            VkPipelineBindPoint       pipeline,
+            VkPipelineLayout          pipelineLayout,
+            uint32_t                  set,
+            uint32_t                  descriptorWriteCount,
+      const VkWriteDescriptorSet*     descriptorWrites) {
+      m_vkd->vkCmdPushDescriptorSetKHR(m_execBuffer,
+        pipeline, pipelineLayout, set,
+        descriptorWriteCount, descriptorWrites);
+    }
+
+
     void cmdBindIndexBuffer(
             VkBuffer                buffer,
             VkDeviceSize            offset,
@@ -346,6 +496,8 @@ namespace dxvk {
     }
     
     void cmdLaunchCuKernel(VkCuLaunchInfoNVX launchInfo) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdCuLaunchKernelNVX(m_execBuffer, &launchInfo);
     }
     
@@ -357,6 +509,8 @@ namespace dxvk {
             uint32_t                regionCount,
       const VkImageBlit*            pRegions,
             VkFilter                filter) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdBlitImage(m_execBuffer,
         srcImage, srcImageLayout,
         dstImage, dstImageLayout,
@@ -381,6 +535,8 @@ namespace dxvk {
       const VkClearColorValue*      pColor,
             uint32_t                rangeCount,
       const VkImageSubresourceRange* pRanges) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdClearColorImage(m_execBuffer,
         image, imageLayout, pColor,
         rangeCount, pRanges);
@@ -393,12 +549,22 @@ namespace dxvk {
       const VkClearDepthStencilValue* pDepthStencil,
             uint32_t                rangeCount,
       const VkImageSubresourceRange* pRanges) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdClearDepthStencilImage(m_execBuffer,
         image, imageLayout, pDepthStencil,
         rangeCount, pRanges);
     }
     
     
+    /**
+     * \brief Records a buffer copy
+     *
+     * The copy is recorded lazily so that it can be merged
+     * with subsequent copies between the same buffers. The
+     * context inserts a barrier between copies that depend
+     * on each other, which records the pending copy.
+     */
     void cmdCopyBuffer(
             DxvkCmdBuffer           cmdBuffer,
             VkBuffer                srcBuffer,
@@ -407,12 +573,23 @@ namespace dxvk {
       const VkBufferCopy*           pRegions) {
       m_cmdBuffersUsed.set(cmdBuffer);
 
-      m_vkd->vkCmdCopyBuffer(getCmdBuffer(cmdBuffer),
-        srcBuffer, dstBuffer,
-        regionCount, pRegions);
+      DxvkPendingCopy copy;
+      copy.type      = DxvkPendingCopyType::Buffer;
+      copy.cmdBuffer = cmdBuffer;
+      copy.srcBuffer = srcBuffer;
+      copy.dstBuffer = dstBuffer;
+
+      beginPendingCopy(copy);
+
+      m_pendingBufferCopies.insert(m_pendingBufferCopies.end(),
+        pRegions, pRegions + regionCount);
     }
     
     
+    /**
+     * \brief Records a buffer to image copy
+     * \see cmdCopyBuffer
+     */
     void cmdCopyBufferToImage(
             DxvkCmdBuffer           cmdBuffer,
             VkBuffer                srcBuffer,
@@ -422,12 +599,24 @@ namespace dxvk {
       const VkBufferImageCopy*      pRegions) {
       m_cmdBuffersUsed.set(cmdBuffer);
 
-      m_vkd->vkCmdCopyBufferToImage(getCmdBuffer(cmdBuffer),
-        srcBuffer, dstImage, dstImageLayout,
-        regionCount, pRegions);
+      DxvkPendingCopy copy;
+      copy.type      = DxvkPendingCopyType::BufferToImage;
+      copy.cmdBuffer = cmdBuffer;
+      copy.srcBuffer = srcBuffer;
+      copy.dstImage  = dstImage;
+      copy.dstLayout = dstImageLayout;
+
+      beginPendingCopy(copy);
+
+      m_pendingBufferImageCopies.insert(m_pendingBufferImageCopies.end(),
+        pRegions, pRegions + regionCount);
     }
     
     
+    /**
+     * \brief Records an image copy
+     * \see cmdCopyBuffer
+     */
     void cmdCopyImage(
             DxvkCmdBuffer           cmdBuffer,
             VkImage                 srcImage,
@@ -438,10 +627,18 @@ namespace dxvk {
       const VkImageCopy*            pRegions) {
       m_cmdBuffersUsed.set(cmdBuffer);
 
-      m_vkd->vkCmdCopyImage(getCmdBuffer(cmdBuffer),
-        srcImage, srcImageLayout,
-        dstImage, dstImageLayout,
-        regionCount, pRegions);
+      DxvkPendingCopy copy;
+      copy.type      = DxvkPendingCopyType::Image;
+      copy.cmdBuffer = cmdBuffer;
+      copy.srcImage  = srcImage;
+      copy.srcLayout = srcImageLayout;
+      copy.dstImage  = dstImage;
+      copy.dstLayout = dstImageLayout;
+
+      beginPendingCopy(copy);
+
+      m_pendingImageCopies.insert(m_pendingImageCopies.end(),
+        pRegions, pRegions + regionCount);
     }
     
     
@@ -468,6 +665,8 @@ namespace dxvk {
             VkDeviceSize            dstOffset,
             VkDeviceSize            stride,
             VkQueryResultFlags      flags) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdCopyQueryPoolResults(m_execBuffer,
         queryPool, firstQuery, queryCount,
         dstBuffer, dstOffset, stride, flags);
@@ -478,6 +677,8 @@ namespace dxvk {
             uint32_t                x,
             uint32_t                y,
             uint32_t                z) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdDispatch(m_execBuffer, x, y, z);
     }
     
@@ -485,6 +686,8 @@ namespace dxvk {
     void cmdDispatchIndirect(
             VkBuffer                buffer,
             VkDeviceSize            offset) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdDispatchIndirect(
         m_execBuffer, buffer, offset);
     }
@@ -534,6 +737,28 @@ namespace dxvk {
         firstIndex, vertexOffset,
         firstInstance);
     }
+
+
+    void cmdDrawMulti(
+            uint32_t                drawCount,
+      const VkMultiDrawInfoEXT*     pVertexInfo,
+            uint32_t                instanceCount,
+            uint32_t                firstInstance) {
+      m_vkd->vkCmdDrawMultiEXT(m_execBuffer,
+        drawCount, pVertexInfo, instanceCount, firstInstance,
+        sizeof(VkMultiDrawInfoEXT));
+    }
+
+
+    void cmdDrawMultiIndexed(
+            uint32_t                drawCount,
+      const VkMultiDrawIndexedInfoEXT* pIndexInfo,
+            uint32_t                instanceCount,
+            uint32_t                firstInstance) {
+      m_vkd->vkCmdDrawMultiIndexedEXT(m_execBuffer,
+        drawCount, pIndexInfo, instanceCount, firstInstance,
+        sizeof(VkMultiDrawIndexedInfoEXT), nullptr);
+    }
     
     
     void cmdDrawIndexedIndirect(
@@ -574,6 +799,8 @@ namespace dxvk {
     void cmdEndQuery(
             VkQueryPool             queryPool,
             uint32_t                query) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdEndQuery(m_execBuffer, queryPool, query);
     }
 
@@ -582,6 +809,8 @@ namespace dxvk {
             VkQueryPool             queryPool,
             uint32_t                query,
             uint32_t                index) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdEndQueryIndexedEXT(
         m_execBuffer, queryPool, query, index);
     }
@@ -634,6 +863,15 @@ namespace dxvk {
         bufferMemoryBarrierCount, pBufferMemoryBarriers,
         imageMemoryBarrierCount,  pImageMemoryBarriers);
     }
+
+
+    void cmdPipelineBarrier2(
+            DxvkCmdBuffer           cmdBuffer,
+      const VkDependencyInfoKHR*    pDependencyInfo) {
+      m_cmdBuffersUsed.set(cmdBuffer);
+
+      m_vkd->vkCmdPipelineBarrier2KHR(getCmdBuffer(cmdBuffer), pDependencyInfo);
+    }
     
     
     void cmdPushConstants(
@@ -654,6 +892,8 @@ namespace dxvk {
             VkImageLayout           dstImageLayout,
             uint32_t                regionCount,
       const VkImageResolve*         pRegions) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdResolveImage(m_execBuffer,
         srcImage, srcImageLayout,
         dstImage, dstImageLayout,
@@ -679,6 +919,12 @@ namespace dxvk {
     }
     
 
+    void cmdSetCullMode(
+            VkCullModeFlags         cullMode) {
+      m_vkd->vkCmdSetCullModeEXT(m_execBuffer, cullMode);
+    }
+
+
     void cmdSetDepthBias(
             float                   depthBiasConstantFactor,
             float                   depthBiasClamp,
@@ -690,6 +936,12 @@ namespace dxvk {
     }
 
 
+    void cmdSetDepthBiasEnable(
+            VkBool32                depthBiasEnable) {
+      m_vkd->vkCmdSetDepthBiasEnableEXT(m_execBuffer, depthBiasEnable);
+    }
+
+
     void cmdSetDepthBounds(
             float                   minDepthBounds,
             float                   maxDepthBounds) {
@@ -699,13 +951,45 @@ namespace dxvk {
     }
 
 
+    void cmdSetDepthState(
+            VkBool32                depthTestEnable,
+            VkBool32                depthWriteEnable,
+            VkCompareOp             depthCompareOp,
+            VkBool32                depthBoundsTestEnable) {
+      m_vkd->vkCmdSetDepthTestEnableEXT(m_execBuffer, depthTestEnable);
+      m_vkd->vkCmdSetDepthWriteEnableEXT(m_execBuffer, depthWriteEnable);
+      m_vkd->vkCmdSetDepthCompareOpEXT(m_execBuffer, depthCompareOp);
+      m_vkd->vkCmdSetDepthBoundsTestEnableEXT(m_execBuffer, depthBoundsTestEnable);
+    }
+
+
     void cmdSetEvent(
             VkEvent                 event,
             VkPipelineStageFlags    stages) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdSetEvent(m_execBuffer, event, stages);
     }
 
     
+    void cmdSetFrontFace(
+            VkFrontFace             frontFace) {
+      m_vkd->vkCmdSetFrontFaceEXT(m_execBuffer, frontFace);
+    }
+
+
+    void cmdSetLogicOp(
+            VkLogicOp               logicOp) {
+      m_vkd->vkCmdSetLogicOpEXT(m_execBuffer, logicOp);
+    }
+
+
+    void cmdSetPrimitiveRestartEnable(
+            VkBool32                primitiveRestartEnable) {
+      m_vkd->vkCmdSetPrimitiveRestartEnableEXT(m_execBuffer, primitiveRestartEnable);
+    }
+
+
     void cmdSetScissor(
             uint32_t                scissorCount,
       const VkRect2D*               scissors) {
@@ -714,6 +998,22 @@ namespace dxvk {
     }
 
 
+    void cmdSetStencilState(
+            VkStencilFaceFlags      faceMask,
+      const VkStencilOpState&       state) {
+      m_vkd->vkCmdSetStencilOpEXT(m_execBuffer, faceMask,
+        state.failOp, state.passOp, state.depthFailOp, state.compareOp);
+      m_vkd->vkCmdSetStencilCompareMask(m_execBuffer, faceMask, state.compareMask);
+      m_vkd->vkCmdSetStencilWriteMask(m_execBuffer, faceMask, state.writeMask);
+    }
+
+
+    void cmdSetStencilTestEnable(
+            VkBool32                stencilTestEnable) {
+      m_vkd->vkCmdSetStencilTestEnableEXT(m_execBuffer, stencilTestEnable);
+    }
+
+
     void cmdSetStencilReference(
             VkStencilFaceFlags      faceMask,
             uint32_t                reference) {
@@ -722,6 +1022,16 @@ namespace dxvk {
     }
     
     
+    void cmdSetVertexInput(
+            uint32_t                bindingCount,
+      const VkVertexInputBindingDescription2EXT* pBindings,
+            uint32_t                attributeCount,
+      const VkVertexInputAttributeDescription2EXT* pAttributes) {
+      m_vkd->vkCmdSetVertexInputEXT(m_execBuffer,
+        bindingCount, pBindings, attributeCount, pAttributes);
+    }
+
+
     void cmdSetViewport(
             uint32_t                viewportCount,
       const VkViewport*             viewports) {
@@ -734,6 +1044,8 @@ namespace dxvk {
             VkPipelineStageFlagBits pipelineStage,
             VkQueryPool             queryPool,
             uint32_t                query) {
+      flushPendingCopy(DxvkCmdBuffer::ExecBuffer);
+
       m_vkd->vkCmdWriteTimestamp(m_execBuffer,
         pipelineStage, queryPool, query);
     }
@@ -774,6 +1086,9 @@ namespace dxvk {
     VkCommandBuffer     m_sdmaBuffer = VK_NULL_HANDLE;
 
     VkSemaphore         m_sdmaSemaphore = VK_NULL_HANDLE;
+
+    bool                m_hasSync2 = false;
+    uint32_t            m_resetCount = 0;
     
     DxvkCmdBufferFlags  m_cmdBuffersUsed;
     DxvkLifetimeTracker m_resources;
@@ -783,22 +1098,136 @@ namespace dxvk {
     DxvkBufferTracker   m_bufferTracker;
     DxvkStatCounters    m_statCounters;
 
+    std::vector<DxvkFenceValuePair> m_fenceSignals;
+    std::vector<DxvkFenceValuePair> m_fenceWaits;
+
     std::vector<std::pair<
       Rc<DxvkDescriptorPool>,
       Rc<DxvkDescriptorManager>>> m_descriptorPools;
 
-    VkCommandBuffer getCmdBuffer(DxvkCmdBuffer cmdBuffer) const {
+    DxvkPendingCopy                 m_pendingCopy;
+    std::vector<VkBufferCopy>       m_pendingBufferCopies;
+    std::vector<VkBufferImageCopy>  m_pendingBufferImageCopies;
+    std::vector<VkImageCopy>        m_pendingImageCopies;
+
+    VkCommandBuffer getCmdBuffer(DxvkCmdBuffer cmdBuffer) {
+      // Any other command may depend on the pending copy
+      flushPendingCopy(cmdBuffer);
+
       if (cmdBuffer == DxvkCmdBuffer::ExecBuffer) return m_execBuffer;
       if (cmdBuffer == DxvkCmdBuffer::InitBuffer) return m_initBuffer;
       if (cmdBuffer == DxvkCmdBuffer::SdmaBuffer) return m_sdmaBuffer;
       return VK_NULL_HANDLE;
     }
 
+    void flushPendingCopy(DxvkCmdBuffer cmdBuffer) {
+      if (unlikely(m_pendingCopy.type != DxvkPendingCopyType::None)
+       && m_pendingCopy.cmdBuffer == cmdBuffer)
+        recordPendingCopy();
+    }
+
+    void beginPendingCopy(
+      const DxvkPendingCopy&      copy) {
+      if (!m_pendingCopy.eq(copy)) {
+        if (m_pendingCopy.type != DxvkPendingCopyType::None)
+          recordPendingCopy();
+
+        m_pendingCopy = copy;
+      }
+    }
+
+    void recordPendingCopy();
+
+    void appendGraphicsSubmission(
+            DxvkQueueSubmission&  info,
+            VkSemaphore           waitSemaphore,
+            VkSemaphore           wakeSemaphore,
+            VkSemaphore           timelineSemaphore,
+            uint64_t              timelineValue) const;
+
     VkResult submitToQueue(
             VkQueue               queue,
             VkFence               fence,
       const DxvkQueueSubmission&  info);
+
+    VkResult submitToQueueWithFences(
+            VkQueue               queue,
+            VkFence               fence,
+      const DxvkQueueSubmission&  info);
     
   };
+
+
+  /**
+   * \brief Command list pool statistics
+   */
+  struct DxvkCommandListPoolStats {
+    uint32_t liveCount;
+    uint32_t freeCount;
+    uint32_t capacity;
+  };
+
+
+  /**
+   * \brief Command list pool
+   *
+   * Recycles command lists once they have finished execution.
+   * Unlike a fixed-size recycler, the pool grows when lists
+   * are allocated faster than the GPU retires them, so that
+   * submission spikes do not keep creating and destroying
+   * command lists, and slowly shrinks again once lists sit
+   * unused in the pool for a while.
+   */
+  class DxvkCommandListPool {
+    /// Minimum number of command lists to keep around
+    constexpr static uint32_t MinCapacity = 8;
+    /// Maximum number of command lists to keep around
+    constexpr static uint32_t MaxCapacity = 64;
+    /// Number of allocations after which to consider shrinking
+    constexpr static uint32_t TrimInterval = 256;
+  public:
+
+    DxvkCommandListPool(DxvkDevice* device);
+
+    ~DxvkCommandListPool();
+
+    /**
+     * \brief Retrieves a command list
+     *
+     * Returns a recycled command list if possible,
+     * and creates a new command list otherwise.
+     * \returns Command list
+     */
+    Rc<DxvkCommandList> allocCommandList();
+
+    /**
+     * \brief Returns a command list to the pool
+     *
+     * The command list must have been reset. If the
+     * pool is at capacity, the list gets destroyed.
+     * \param [in] cmdList The command list
+     */
+    void recycleCommandList(
+      const Rc<DxvkCommandList>&  cmdList);
+
+    /**
+     * \brief Queries command list pool statistics
+     * \returns Current pool statistics
+     */
+    DxvkCommandListPoolStats getStats();
+
+  private:
+
+    DxvkDevice*                       m_device;
+
+    dxvk::mutex                       m_mutex;
+    std::vector<Rc<DxvkCommandList>>  m_freeLists;
+
+    uint32_t                          m_liveCount   = 0;
+    uint32_t                          m_capacity    = MinCapacity;
+    uint32_t                          m_allocCount  = 0;
+    uint32_t                          m_minFree     = 0;
+
+  };
   
 }
@@ -75,6 +75,8 @@ namespace dxvk {
   
   VkPipeline DxvkComputePipeline::createPipeline(
     const DxvkComputePipelineStateInfo& state) const {
+    DXVK_TRACE_SCOPE("DxvkComputePipeline::createPipeline");
+
     std::vector<VkDescriptorSetLayoutBinding> bindings;
 
     if (Logger::logLevel() <= LogLevel::Debug) {
@@ -94,12 +96,15 @@ namespace dxvk {
 
     auto csm = m_shaders.cs->createShaderModule(m_vkd, m_bindings, moduleInfo);
 
+    if (!csm)
+      return VK_NULL_HANDLE;
+
     VkComputePipelineCreateInfo info;
     info.sType                = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     info.pNext                = nullptr;
     info.flags                = 0;
     info.stage                = csm.stageInfo(&specInfo);
-    info.layout               = m_bindings->getPipelineLayout();
+    info.layout               = m_bindings->getPipelineLayout(false);
     info.basePipelineHandle   = VK_NULL_HANDLE;
     info.basePipelineIndex    = -1;
     
@@ -22,6 +22,9 @@ namespace dxvk {
     // the app does not explicitly bind any render targets
     m_state.om.framebufferInfo = makeFramebufferInfo(m_state.om.renderTargets);
 
+    if (device->getGpuProfiler().isEnabled())
+      m_profiler = &device->getGpuProfiler();
+
     for (uint32_t i = 0; i < MaxNumActiveBindings; i++) {
       m_descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
       m_descriptorWrites[i].pNext = nullptr;
@@ -33,10 +36,27 @@ namespace dxvk {
       m_descriptorWrites[i].pImageInfo = &m_descriptors[i].image;
       m_descriptorWrites[i].pBufferInfo = &m_descriptors[i].buffer;
       m_descriptorWrites[i].pTexelBufferView = &m_descriptors[i].texelBuffer;
+
+      m_inlineWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_INLINE_UNIFORM_BLOCK_EXT;
+      m_inlineWrites[i].pNext = nullptr;
+      m_inlineWrites[i].dataSize = 0;
+      m_inlineWrites[i].pData = nullptr;
     }
 
     m_descriptorManager = new DxvkDescriptorManager(device.ptr(), type);
 
+    // Determine which pipeline state can be set dynamically
+    const auto& features = m_device->features();
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2)
+      m_features.set(DxvkContextFeature::ExtendedDynamicState2);
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2LogicOp)
+      m_features.set(DxvkContextFeature::ExtendedDynamicState2LogicOp);
+
+    if (features.extVertexInputDynamicState.vertexInputDynamicState)
+      m_features.set(DxvkContextFeature::VertexInputDynamicState);
+
     // Default destination barriers for graphics pipelines
     m_globalRoGraphicsBarrier.stages = m_device->getShaderPipelineStages()
                                      | VK_PIPELINE_STAGE_TRANSFER_BIT
@@ -122,9 +142,15 @@ namespace dxvk {
     m_initBarriers.recordCommands(m_cmd);
     m_execBarriers.recordCommands(m_cmd);
 
+    m_queryManager.copyQueryResults(m_cmd);
+
     if (m_descriptorPool->shouldSubmit(false)) {
       m_cmd->trackDescriptorPool(m_descriptorPool, m_descriptorManager);
       m_descriptorPool = m_descriptorManager->getDescriptorPool();
+    } else {
+      // Resources written to cached sets are only kept
+      // alive by the command list we're about to submit
+      m_descriptorPool->clearSetCache();
     }
 
     m_cmd->endRecording();
@@ -190,6 +216,41 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::bindInlineUniformData(
+          VkShaderStageFlags    stages,
+          uint32_t              slot,
+          uint32_t              size,
+    const void*                 data) {
+    DxvkInlineUniformBlock* block = nullptr;
+
+    for (auto& b : m_inlineBlocks) {
+      if (b.slot == slot || b.slot == ~0u) {
+        block = &b;
+        break;
+      }
+    }
+
+    if (unlikely(!block || size > sizeof(block->data))) {
+      Logger::err(str::format("DxvkContext: Cannot bind inline uniform data to slot ", slot));
+      return;
+    }
+
+    // Skip the descriptor update if the data did not
+    // change, which is common for constant state
+    if (block->slot == slot && block->size == size
+     && !std::memcmp(block->data.data(), data, size))
+      return;
+
+    block->slot = slot;
+    block->size = size;
+    block->version = ++m_inlineVersion;
+    block->data = { };
+    std::memcpy(block->data.data(), data, size);
+
+    m_descriptorState.dirtyBuffers(stages);
+  }
+
+
   void DxvkContext::blitImage(
     const Rc<DxvkImage>&        dstImage,
     const VkComponentMapping&   dstMapping,
@@ -252,12 +313,25 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::prepareStorageImage(
+    const Rc<DxvkImage>&        image) {
+    // Images with storage usage may start out in a layout that is
+    // optimal for their other uses, which allows drivers to keep
+    // them compressed until they are accessed as a storage image
+    // for the first time. Storage images, however, require the
+    // GENERAL layout, and descriptors assume the default layout.
+    if (image->info().layout != VK_IMAGE_LAYOUT_GENERAL)
+      this->changeImageLayout(image, VK_IMAGE_LAYOUT_GENERAL);
+  }
+
+
   void DxvkContext::clearBuffer(
     const Rc<DxvkBuffer>&       buffer,
           VkDeviceSize          offset,
           VkDeviceSize          length,
           uint32_t              value) {
-    bool replaceBuffer = this->tryInvalidateDeviceLocalBuffer(buffer, length);
+    bool replaceBuffer = this->tryInvalidateDeviceLocalBuffer(buffer, length)
+                      || this->tryHoistBufferTransfer(buffer, nullptr);
     auto bufferSlice = buffer->getSliceHandle(offset, align(length, sizeof(uint32_t)));
 
     if (!replaceBuffer) {
@@ -304,6 +378,22 @@ namespace dxvk {
           VkDeviceSize          offset,
           VkDeviceSize          length,
           VkClearColorValue     value) {
+    DxvkClearRect range;
+    range.offset = VkOffset3D {  int32_t(offset), 0, 0 };
+    range.extent = VkExtent3D { uint32_t(length), 1, 1 };
+
+    this->clearBufferViewRanges(bufferView, 1, &range, value);
+  }
+
+
+  void DxvkContext::clearBufferViewRanges(
+    const Rc<DxvkBufferView>&   bufferView,
+          uint32_t              rangeCount,
+    const DxvkClearRect*        ranges,
+          VkClearColorValue     value) {
+    if (!rangeCount)
+      return;
+
     this->spillRenderPass(true);
     this->invalidateState();
 
@@ -338,15 +428,6 @@ namespace dxvk {
     descriptorWrite.pTexelBufferView = &viewObject;
     m_cmd->updateDescriptorSets(1, &descriptorWrite);
     
-    // Prepare shader arguments
-    DxvkMetaClearArgs pushArgs = { };
-    pushArgs.clearValue = value;
-    pushArgs.offset = VkOffset3D {  int32_t(offset), 0, 0 };
-    pushArgs.extent = VkExtent3D { uint32_t(length), 1, 1 };
-    
-    VkExtent3D workgroups = util::computeBlockCount(
-      pushArgs.extent, pipeInfo.workgroupSize);
-    
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeline);
@@ -354,14 +435,27 @@ namespace dxvk {
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeLayout, descriptorSet,
       0, nullptr);
-    m_cmd->cmdPushConstants(
-      pipeInfo.pipeLayout,
-      VK_SHADER_STAGE_COMPUTE_BIT,
-      0, sizeof(pushArgs), &pushArgs);
-    m_cmd->cmdDispatch(
-      workgroups.width,
-      workgroups.height,
-      workgroups.depth);
+    
+    // Ranges of the same view can be cleared back to back,
+    // only the push constants differ between dispatches
+    for (uint32_t i = 0; i < rangeCount; i++) {
+      DxvkMetaClearArgs pushArgs = { };
+      pushArgs.clearValue = value;
+      pushArgs.offset = VkOffset3D { ranges[i].offset.x, 0, 0 };
+      pushArgs.extent = VkExtent3D { ranges[i].extent.width, 1, 1 };
+      
+      VkExtent3D workgroups = util::computeBlockCount(
+        pushArgs.extent, pipeInfo.workgroupSize);
+      
+      m_cmd->cmdPushConstants(
+        pipeInfo.pipeLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0, sizeof(pushArgs), &pushArgs);
+      m_cmd->cmdDispatch(
+        workgroups.width,
+        workgroups.height,
+        workgroups.depth);
+    }
     
     m_execBarriers.accessBuffer(bufferSlice,
       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
@@ -383,6 +477,8 @@ namespace dxvk {
       clearValue.color = util::swizzleClearColor(clearValue.color,
         util::invertComponentMapping(imageView->info().swizzle));
     }
+
+    this->discardPendingInit(imageView, clearAspects);
     
     // Check whether the render target view is an attachment
     // of the current framebuffer and is included entirely.
@@ -441,10 +537,37 @@ namespace dxvk {
         util::invertComponentMapping(imageView->info().swizzle));
     }
     
+    DxvkClearRect rect;
+    rect.offset = offset;
+    rect.extent = extent;
+
+    if (viewUsage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+      this->clearImageViewFb(imageView, 1, &rect, aspect, value);
+    else if (viewUsage & VK_IMAGE_USAGE_STORAGE_BIT)
+      this->clearImageViewCs(imageView, 1, &rect, value);
+  }
+  
+  
+  void DxvkContext::clearImageViewRects(
+    const Rc<DxvkImageView>&    imageView,
+          uint32_t              rectCount,
+    const DxvkClearRect*        rects,
+          VkImageAspectFlags    aspect,
+          VkClearValue          value) {
+    if (!rectCount)
+      return;
+
+    const VkImageUsageFlags viewUsage = imageView->info().usage;
+
+    if (aspect & VK_IMAGE_ASPECT_COLOR_BIT) {
+      value.color = util::swizzleClearColor(value.color,
+        util::invertComponentMapping(imageView->info().swizzle));
+    }
+    
     if (viewUsage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
-      this->clearImageViewFb(imageView, offset, extent, aspect, value);
+      this->clearImageViewFb(imageView, rectCount, rects, aspect, value);
     else if (viewUsage & VK_IMAGE_USAGE_STORAGE_BIT)
-      this->clearImageViewCs(imageView, offset, extent, value);
+      this->clearImageViewCs(imageView, rectCount, rects, value);
   }
   
   
@@ -458,7 +581,8 @@ namespace dxvk {
     // avoid suspending the current render pass or inserting barriers. The source
     // buffer must be read-only since otherwise we cannot schedule the copy early.
     bool srcIsReadOnly = DxvkBarrierSet::getAccessTypes(srcBuffer->info().access) == DxvkAccess::Read;
-    bool replaceBuffer = srcIsReadOnly && this->tryInvalidateDeviceLocalBuffer(dstBuffer, numBytes);
+    bool replaceBuffer = (srcIsReadOnly && this->tryInvalidateDeviceLocalBuffer(dstBuffer, numBytes))
+                      || this->tryHoistBufferTransfer(dstBuffer, srcBuffer);
 
     auto srcSlice = srcBuffer->getSliceHandle(srcOffset, numBytes);
     auto dstSlice = dstBuffer->getSliceHandle(dstOffset, numBytes);
@@ -520,6 +644,7 @@ namespace dxvk {
       bufInfo.stages  = VK_PIPELINE_STAGE_TRANSFER_BIT;
       bufInfo.access  = VK_ACCESS_TRANSFER_WRITE_BIT
                       | VK_ACCESS_TRANSFER_READ_BIT;
+      bufInfo.category = DxvkMemoryCategory::Meta;
 
       auto tmpBuffer = m_device->createBuffer(
         bufInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -675,6 +800,7 @@ namespace dxvk {
                             | VK_ACCESS_TRANSFER_READ_BIT;
       imgInfo.tiling        = dstImage->info().tiling;
       imgInfo.layout        = VK_IMAGE_LAYOUT_GENERAL;
+      imgInfo.category      = DxvkMemoryCategory::Meta;
 
       auto tmpImage = m_device->createImage(
         imgInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -944,6 +1070,7 @@ namespace dxvk {
                         | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
       bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT
                         | VK_ACCESS_SHADER_READ_BIT;
+      bufferInfo.category = DxvkMemoryCategory::Meta;
       Rc<DxvkBuffer> tmpBuffer = m_device->createBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
       auto tmpBufferSlice = tmpBuffer->getSliceHandle();
@@ -1107,6 +1234,7 @@ namespace dxvk {
                           | VK_PIPELINE_STAGE_TRANSFER_BIT;
     tmpBufferInfo.access  = VK_ACCESS_SHADER_WRITE_BIT
                           | VK_ACCESS_TRANSFER_READ_BIT;
+    tmpBufferInfo.category = DxvkMemoryCategory::Meta;
     
     auto tmpBuffer = m_device->createBuffer(tmpBufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
@@ -1230,6 +1358,32 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::defragmentMemory() {
+    VkDeviceSize maxSize = VkDeviceSize(m_device->config().memoryDefragRate) << 20;
+    DxvkBufferRelocation mode = DxvkBufferRelocation::Defragment;
+
+    // Keeping device memory within budget is more important
+    // than defragmenting it, so do that first if necessary
+    int64_t pressure = m_device->getMemoryPressure();
+
+    if (pressure) {
+      mode = pressure > 0
+        ? DxvkBufferRelocation::Evict
+        : DxvkBufferRelocation::Restore;
+
+      maxSize = std::min<VkDeviceSize>(std::abs(pressure), MaxEvictionSize);
+    }
+
+    if (!maxSize)
+      return;
+
+    auto buffers = m_common->defragmenter().pickBuffers(maxSize, mode);
+
+    for (const auto& buffer : buffers)
+      this->relocateBuffer(buffer, mode);
+  }
+
+
   void DxvkContext::discardBuffer(
     const Rc<DxvkBuffer>&       buffer) {
     if (buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
@@ -1250,6 +1404,7 @@ namespace dxvk {
     // as a render target, which may have niche use cases for depth buffers.
     if (viewUsage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
       this->spillRenderPass(true);
+      this->discardPendingInit(imageView, discardAspects);
       this->deferDiscard(imageView, discardAspects);
     }
   }
@@ -1264,8 +1419,18 @@ namespace dxvk {
 
       m_queryManager.beginQueries(m_cmd,
         VK_QUERY_TYPE_PIPELINE_STATISTICS);
-      
+
+      DxvkGpuProfilerScope scope;
+
+      if (unlikely(m_profiler != nullptr)) {
+        scope = this->beginProfilerScope(str::format("Dispatch ", x, "x", y, "x", z),
+          DxvkGpuProfilerTrack::Commands);
+      }
+
       m_cmd->cmdDispatch(x, y, z);
+
+      if (unlikely(m_profiler != nullptr))
+        this->endProfilerScope(std::move(scope));
       
       m_queryManager.endQueries(m_cmd,
         VK_QUERY_TYPE_PIPELINE_STATISTICS);
@@ -1290,10 +1455,18 @@ namespace dxvk {
 
       m_queryManager.beginQueries(m_cmd,
         VK_QUERY_TYPE_PIPELINE_STATISTICS);
-      
+
+      DxvkGpuProfilerScope scope;
+
+      if (unlikely(m_profiler != nullptr))
+        scope = this->beginProfilerScope("Dispatch indirect", DxvkGpuProfilerTrack::Commands);
+
       m_cmd->cmdDispatchIndirect(
         bufferSlice.handle,
         bufferSlice.offset);
+
+      if (unlikely(m_profiler != nullptr))
+        this->endProfilerScope(std::move(scope));
       
       m_queryManager.endQueries(m_cmd,
         VK_QUERY_TYPE_PIPELINE_STATISTICS);
@@ -1328,6 +1501,33 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::drawMulti(
+          uint32_t          drawCount,
+    const VkMultiDrawInfoEXT* draws,
+          uint32_t          instanceCount,
+          uint32_t          firstInstance) {
+    if (this->commitGraphicsState<false, false>()) {
+      if (drawCount > 1 && m_device->features().extMultiDraw.multiDraw) {
+        uint32_t maxDrawCount = m_device->properties().extMultiDraw.maxMultiDrawCount;
+
+        for (uint32_t i = 0; i < drawCount; i += maxDrawCount) {
+          m_cmd->cmdDrawMulti(
+            std::min(drawCount - i, maxDrawCount),
+            &draws[i], instanceCount, firstInstance);
+        }
+      } else {
+        for (uint32_t i = 0; i < drawCount; i++) {
+          m_cmd->cmdDraw(
+            draws[i].vertexCount, instanceCount,
+            draws[i].firstVertex, firstInstance);
+        }
+      }
+    }
+    
+    m_cmd->addStatCtr(DxvkStatCounter::CmdDrawCalls, drawCount);
+  }
+  
+  
   void DxvkContext::drawIndirect(
           VkDeviceSize      offset,
           uint32_t          count,
@@ -1383,6 +1583,34 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::drawIndexedMulti(
+          uint32_t          drawCount,
+    const VkMultiDrawIndexedInfoEXT* draws,
+          uint32_t          instanceCount,
+          uint32_t          firstInstance) {
+    if (this->commitGraphicsState<true, false>()) {
+      if (drawCount > 1 && m_device->features().extMultiDraw.multiDraw) {
+        uint32_t maxDrawCount = m_device->properties().extMultiDraw.maxMultiDrawCount;
+
+        for (uint32_t i = 0; i < drawCount; i += maxDrawCount) {
+          m_cmd->cmdDrawMultiIndexed(
+            std::min(drawCount - i, maxDrawCount),
+            &draws[i], instanceCount, firstInstance);
+        }
+      } else {
+        for (uint32_t i = 0; i < drawCount; i++) {
+          m_cmd->cmdDrawIndexed(
+            draws[i].indexCount, instanceCount,
+            draws[i].firstIndex, draws[i].vertexOffset,
+            firstInstance);
+        }
+      }
+    }
+    
+    m_cmd->addStatCtr(DxvkStatCounter::CmdDrawCalls, drawCount);
+  }
+  
+  
   void DxvkContext::drawIndexedIndirect(
           VkDeviceSize      offset,
           uint32_t          count,
@@ -1455,13 +1683,19 @@ namespace dxvk {
     const Rc<DxvkBuffer>&           buffer) {
     auto slice = buffer->getSliceHandle();
 
-    m_cmd->cmdFillBuffer(DxvkCmdBuffer::InitBuffer,
+    // Record the clear on the transfer queue so that it can
+    // overlap with rendering, same as buffer uploads. Filling
+    // buffers is supported on transfer queues in Vulkan 1.1.
+    m_cmd->cmdFillBuffer(DxvkCmdBuffer::SdmaBuffer,
       slice.handle, slice.offset,
       dxvk::align(slice.length, 4), 0);
 
-    m_initBarriers.accessBuffer(slice,
+    m_sdmaBarriers.releaseBuffer(
+      m_initBarriers, slice,
+      m_device->queues().transfer.queueFamily,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       VK_ACCESS_TRANSFER_WRITE_BIT,
+      m_device->queues().graphics.queueFamily,
       buffer->info().stages,
       buffer->info().access);
 
@@ -1481,90 +1715,103 @@ namespace dxvk {
         image->info().access);
 
       m_cmd->trackResource<DxvkAccess::None>(image);
+    } else if (this->canDeferImageInit(image, subresources)) {
+      // Render targets are usually cleared or rendered to right
+      // away, so let the first context that uses the image fold
+      // the clear into a render pass or skip it entirely.
+      image->setPendingInit();
     } else {
-      VkImageLayout clearLayout = image->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+      this->performImageInit(image, subresources, initialLayout);
+    }
+  }
 
-      m_execAcquires.accessImage(image, subresources,
-        initialLayout, 0, 0, clearLayout,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_ACCESS_TRANSFER_WRITE_BIT);
-      m_execAcquires.recordCommands(m_cmd);
 
-      auto formatInfo = image->formatInfo();
+  void DxvkContext::performImageInit(
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceRange&  subresources,
+          VkImageLayout             initialLayout) {
+    VkImageLayout clearLayout = image->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-      if (formatInfo->flags.any(DxvkFormatFlag::BlockCompressed, DxvkFormatFlag::MultiPlane)) {
-        for (auto aspects = formatInfo->aspectMask; aspects; ) {
-          auto aspect = vk::getNextAspect(aspects);
-          auto extent = image->mipLevelExtent(subresources.baseMipLevel);
-          auto elementSize = formatInfo->elementSize;
+    m_execAcquires.accessImage(image, subresources,
+      initialLayout, 0, 0, clearLayout,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT);
+    m_execAcquires.recordCommands(m_cmd);
 
-          if (formatInfo->flags.test(DxvkFormatFlag::MultiPlane)) {
-            auto plane = &formatInfo->planes[vk::getPlaneIndex(aspect)];
-            extent.width  /= plane->blockSize.width;
-            extent.height /= plane->blockSize.height;
-            elementSize = plane->elementSize;
-          }
+    auto formatInfo = image->formatInfo();
+
+    if (formatInfo->flags.any(DxvkFormatFlag::BlockCompressed, DxvkFormatFlag::MultiPlane)) {
+      for (auto aspects = formatInfo->aspectMask; aspects; ) {
+        auto aspect = vk::getNextAspect(aspects);
+        auto extent = image->mipLevelExtent(subresources.baseMipLevel);
+        auto elementSize = formatInfo->elementSize;
 
-          // Allocate enough staging buffer memory to fit one
-          // single subresource, then dispatch multiple copies
-          VkExtent3D blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
-          VkDeviceSize dataSize = util::flattenImageExtent(blockCount) * elementSize;
+        if (formatInfo->flags.test(DxvkFormatFlag::MultiPlane)) {
+          auto plane = &formatInfo->planes[vk::getPlaneIndex(aspect)];
+          extent.width  /= plane->blockSize.width;
+          extent.height /= plane->blockSize.height;
+          elementSize = plane->elementSize;
+        }
 
-          auto zeroBuffer = createZeroBuffer(dataSize);
-          auto zeroHandle = zeroBuffer->getSliceHandle();
+        // Allocate enough staging buffer memory to fit one
+        // single subresource, then dispatch multiple copies
+        VkExtent3D blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
+        VkDeviceSize dataSize = util::flattenImageExtent(blockCount) * elementSize;
 
-          for (uint32_t level = 0; level < subresources.levelCount; level++) {
-            VkOffset3D offset = VkOffset3D { 0, 0, 0 };
-            VkExtent3D extent = image->mipLevelExtent(subresources.baseMipLevel + level);
+        auto zeroBuffer = createZeroBuffer(dataSize);
+        auto zeroHandle = zeroBuffer->getSliceHandle();
 
-            if (formatInfo->flags.test(DxvkFormatFlag::MultiPlane)) {
-              auto plane = &formatInfo->planes[vk::getPlaneIndex(aspect)];
-              extent.width  /= plane->blockSize.width;
-              extent.height /= plane->blockSize.height;
-            }
+        for (uint32_t level = 0; level < subresources.levelCount; level++) {
+          VkOffset3D offset = VkOffset3D { 0, 0, 0 };
+          VkExtent3D extent = image->mipLevelExtent(subresources.baseMipLevel + level);
 
-            for (uint32_t layer = 0; layer < subresources.layerCount; layer++) {
-              VkBufferImageCopy region;
-              region.bufferOffset       = zeroHandle.offset;
-              region.bufferRowLength    = 0;
-              region.bufferImageHeight  = 0;
-              region.imageSubresource   = vk::makeSubresourceLayers(
-                vk::pickSubresource(subresources, level, layer));
-              region.imageSubresource.aspectMask = aspect;
-              region.imageOffset        = offset;
-              region.imageExtent        = extent;
-
-              m_cmd->cmdCopyBufferToImage(DxvkCmdBuffer::ExecBuffer,
-                zeroHandle.handle, image->handle(), clearLayout, 1, &region);
-            }
+          if (formatInfo->flags.test(DxvkFormatFlag::MultiPlane)) {
+            auto plane = &formatInfo->planes[vk::getPlaneIndex(aspect)];
+            extent.width  /= plane->blockSize.width;
+            extent.height /= plane->blockSize.height;
           }
 
-          m_cmd->trackResource<DxvkAccess::Read>(zeroBuffer);
+          for (uint32_t layer = 0; layer < subresources.layerCount; layer++) {
+            VkBufferImageCopy region;
+            region.bufferOffset       = zeroHandle.offset;
+            region.bufferRowLength    = 0;
+            region.bufferImageHeight  = 0;
+            region.imageSubresource   = vk::makeSubresourceLayers(
+              vk::pickSubresource(subresources, level, layer));
+            region.imageSubresource.aspectMask = aspect;
+            region.imageOffset        = offset;
+            region.imageExtent        = extent;
+
+            m_cmd->cmdCopyBufferToImage(DxvkCmdBuffer::ExecBuffer,
+              zeroHandle.handle, image->handle(), clearLayout, 1, &region);
+          }
         }
-      } else {
-        if (subresources.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) {
-          VkClearDepthStencilValue value = { };
-
-          m_cmd->cmdClearDepthStencilImage(image->handle(),
-            clearLayout, &value, 1, &subresources);
-        } else {
-          VkClearColorValue value = { };
 
-          m_cmd->cmdClearColorImage(image->handle(),
-            clearLayout, &value, 1, &subresources);
-        }
+        m_cmd->trackResource<DxvkAccess::Read>(zeroBuffer);
       }
+    } else {
+      if (subresources.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) {
+        VkClearDepthStencilValue value = { };
 
-      m_execBarriers.accessImage(image, subresources,
-        clearLayout,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_ACCESS_TRANSFER_WRITE_BIT,
-        image->info().layout,
-        image->info().stages,
-        image->info().access);
+        m_cmd->cmdClearDepthStencilImage(image->handle(),
+          clearLayout, &value, 1, &subresources);
+      } else {
+        VkClearColorValue value = { };
 
-      m_cmd->trackResource<DxvkAccess::Write>(image);
+        m_cmd->cmdClearColorImage(image->handle(),
+          clearLayout, &value, 1, &subresources);
+      }
     }
+
+    m_execBarriers.accessImage(image, subresources,
+      clearLayout,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      image->info().layout,
+      image->info().stages,
+      image->info().access);
+
+    m_cmd->trackResource<DxvkAccess::Write>(image);
   }
   
   
@@ -1576,7 +1823,145 @@ namespace dxvk {
     
     this->spillRenderPass(false);
     this->invalidateState();
+    this->initPendingImage(imageView->image());
+
+    if (m_common->metaMipGen().canGenerateMipmaps(imageView, filter))
+      this->generateMipmapsCs(imageView);
+    else
+      this->generateMipmapsFb(imageView, filter);
+  }
+
+
+  void DxvkContext::generateMipmapsCs(
+    const Rc<DxvkImageView>&        imageView) {
+    Rc<DxvkMetaMipGenViews> mipViews = new DxvkMetaMipGenViews(m_device->vkd(), imageView);
+
+    DxvkMetaMipGenPipeline pipeInfo = m_common->metaMipGen().getPipeline();
+
+    // Each work group reduces one tile of the top level
+    VkExtent3D workgroups = util::computeBlockCount(imageView->mipLevelExtent(0), VkExtent3D {
+      DxvkMetaMipGenObjects::TileSize, DxvkMetaMipGenObjects::TileSize, 1u });
+    workgroups.depth = imageView->info().numLayers;
+
+    // The shader uses one counter per layer in order to
+    // find the last work group, so reset those first
+    Rc<DxvkBuffer> counterBuffer = createMipGenCounterBuffer(workgroups.depth);
+
+    DxvkBufferSliceHandle counterSlice = counterBuffer->getSliceHandle(
+      0, sizeof(uint32_t) * workgroups.depth);
+
+    if (m_execBarriers.isImageDirty(imageView->image(), imageView->imageSubresources(), DxvkAccess::Write)
+     || m_execBarriers.isBufferDirty(counterSlice, DxvkAccess::Write))
+      m_execBarriers.recordCommands(m_cmd);
+
+    m_cmd->cmdFillBuffer(DxvkCmdBuffer::ExecBuffer,
+      counterSlice.handle,
+      counterSlice.offset,
+      counterSlice.length, 0);
+
+    m_execAcquires.accessBuffer(counterSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    // All levels are accessed as storage images. Only the top
+    // level needs to be preserved, the others get overwritten.
+    VkImageSubresourceRange topLevel = imageView->imageSubresources();
+    topLevel.levelCount = 1;
+
+    VkImageSubresourceRange otherLevels = imageView->imageSubresources();
+    otherLevels.baseMipLevel += 1;
+    otherLevels.levelCount   -= 1;
+
+    m_execAcquires.accessImage(imageView->image(), topLevel,
+      imageView->imageInfo().layout,
+      imageView->imageInfo().stages, 0,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT);
+
+    m_execAcquires.accessImage(imageView->image(), otherLevels,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      imageView->imageInfo().stages, 0,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    m_execAcquires.recordCommands(m_cmd);
+
+    // Unused levels still need valid descriptors,
+    // so simply point them to the last level
+    std::array<VkDescriptorImageInfo, DxvkMetaMipGenObjects::MaxLevels + 1> imageDescriptors;
+
+    for (uint32_t i = 0; i < imageDescriptors.size(); i++) {
+      imageDescriptors[i].sampler     = VK_NULL_HANDLE;
+      imageDescriptors[i].imageView   = mipViews->getView(std::min(i, mipViews->getLevelCount() - 1));
+      imageDescriptors[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    VkDescriptorBufferInfo bufferDescriptor;
+    bufferDescriptor.buffer = counterSlice.handle;
+    bufferDescriptor.offset = counterSlice.offset;
+    bufferDescriptor.range  = counterSlice.length;
+
+    VkDescriptorSet descriptorSet = m_descriptorPool->alloc(pipeInfo.dsetLayout);
+
+    std::array<VkWriteDescriptorSet, 2> descriptorWrites = {{
+      { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+        descriptorSet, 0, 0, uint32_t(imageDescriptors.size()),
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, imageDescriptors.data(), nullptr, nullptr },
+      { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+        descriptorSet, 1, 0, 1,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &bufferDescriptor, nullptr },
+    }};
+
+    m_cmd->updateDescriptorSets(descriptorWrites.size(), descriptorWrites.data());
+
+    DxvkMetaMipGenArgs pushArgs = { };
+    pushArgs.mipCount   = imageView->info().numLevels - 1;
+    pushArgs.groupCount = workgroups.width * workgroups.height;
+
+    m_cmd->cmdBindPipeline(
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      pipeInfo.pipeHandle);
+    m_cmd->cmdBindDescriptorSet(
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      pipeInfo.pipeLayout, descriptorSet,
+      0, nullptr);
+    m_cmd->cmdPushConstants(
+      pipeInfo.pipeLayout,
+      VK_SHADER_STAGE_COMPUTE_BIT,
+      0, sizeof(pushArgs), &pushArgs);
+    m_cmd->cmdDispatch(
+      workgroups.width,
+      workgroups.height,
+      workgroups.depth);
+
+    m_execBarriers.accessImage(imageView->image(),
+      imageView->imageSubresources(),
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      imageView->imageInfo().layout,
+      imageView->imageInfo().stages,
+      imageView->imageInfo().access);
+
+    m_execBarriers.accessBuffer(counterSlice,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      counterBuffer->info().stages,
+      counterBuffer->info().access);
+
+    m_cmd->trackResource<DxvkAccess::None>(mipViews);
+    m_cmd->trackResource<DxvkAccess::Write>(imageView->image());
+    m_cmd->trackResource<DxvkAccess::Write>(counterBuffer);
+  }
+
 
+  void DxvkContext::generateMipmapsFb(
+    const Rc<DxvkImageView>&        imageView,
+          VkFilter                  filter) {
     // Create image views, etc.
     Rc<DxvkMetaMipGenRenderPass> mipGenerator = new DxvkMetaMipGenRenderPass(m_device->vkd(), imageView);
     
@@ -1749,6 +2134,45 @@ namespace dxvk {
     
     // We also need to update all bindings that the buffer
     // may be bound to either directly or through views.
+    this->updateBufferBindings(buffer);
+  }
+
+
+  void DxvkContext::invalidateImage(
+    const Rc<DxvkImage>&            image,
+    const Rc<DxvkImage>&            storage) {
+    // The host has written the new storage before submission,
+    // so it only needs to be transitioned to its default layout.
+    // Storage taken from the resource pool may already be in it.
+    VkImageLayout layout = storage->getUnusedLayout();
+
+    if (layout != storage->info().layout) {
+      m_initBarriers.accessImage(storage,
+        storage->getAvailableSubresources(),
+        layout, 0, 0,
+        storage->info().layout,
+        storage->info().stages,
+        storage->info().access);
+    }
+
+    image->rename(*storage);
+
+    // The storage object now owns the previous Vulkan image. Keep
+    // it alive for this submission and hand it to the resource
+    // pool, which only reuses it once the GPU is done with it.
+    m_cmd->trackResource<DxvkAccess::None>(storage);
+    m_device->recycleImage(Rc<DxvkImage>(storage));
+
+    // Views return new handles from now on, but
+    // descriptors may still refer to the old ones
+    m_descriptorState.dirtyViews(
+      VK_SHADER_STAGE_ALL_GRAPHICS |
+      VK_SHADER_STAGE_COMPUTE_BIT);
+  }
+
+
+  void DxvkContext::updateBufferBindings(
+    const Rc<DxvkBuffer>&           buffer) {
     VkBufferUsageFlags usage = buffer->info().usage &
       ~(VK_BUFFER_USAGE_TRANSFER_DST_BIT |
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
@@ -1807,9 +2231,24 @@ namespace dxvk {
             && (srcImage->info().usage & VK_IMAGE_USAGE_SAMPLED_BIT);
     }
 
+    // Render passes come with a fixed setup cost and cannot discard
+    // partially written images, so small or partial resolves are
+    // better off in a compute shader. Large full-image resolves
+    // use the render pass path to benefit from compression.
+    bool useCs = useFb && m_common->metaResolve().canResolveCompute(dstImage, srcImage, format);
+
+    if (useCs) {
+      useCs = !dstImage->isFullSubresource(region.dstSubresource, region.extent)
+           || region.extent.width * region.extent.height <= MaxComputeResolveArea;
+    }
+
     if (!useFb) {
       this->resolveImageHw(
         dstImage, srcImage, region);
+    } else if (useCs) {
+      this->resolveImageCs(
+        dstImage, srcImage, region, format,
+        VK_RESOLVE_MODE_AVERAGE_BIT_KHR);
     } else {
       this->resolveImageFb(
         dstImage, srcImage, region, format,
@@ -1878,6 +2317,7 @@ namespace dxvk {
           VkImageLayout             srcLayout,
           VkImageLayout             dstLayout) {
     this->spillRenderPass(false);
+    this->initPendingImage(dstImage);
     
     if (srcLayout != dstLayout) {
       m_execBarriers.recordCommands(m_cmd);
@@ -2068,12 +2508,93 @@ namespace dxvk {
   }
 
 
-  void DxvkContext::deferClear(
-    const Rc<DxvkImageView>&        imageView,
-          VkImageAspectFlags        clearAspects,
-          VkClearValue              clearValue) {
-    for (auto& entry : m_deferredClears) {
-      if (entry.imageView->matchesView(imageView)) {
+  bool DxvkContext::canDeferImageInit(
+    const Rc<DxvkImage>&            image,
+    const VkImageSubresourceRange&  subresources) const {
+    // Only defer clears that can be expressed as a load op on the
+    // entire image. Shared images may be used by other contexts.
+    if (!(image->info().usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)))
+      return false;
+
+    if (image->info().shared || image->info().type == VK_IMAGE_TYPE_3D)
+      return false;
+
+    return subresources == image->getAvailableSubresources();
+  }
+
+
+  void DxvkContext::initPendingImage(
+    const Rc<DxvkImage>&            image) {
+    if (likely(!image->hasPendingInit()) || !image->claimPendingInit())
+      return;
+
+    this->spillRenderPass(true);
+
+    if (image->info().usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) {
+      this->performImageInit(image,
+        image->getAvailableSubresources(),
+        VK_IMAGE_LAYOUT_UNDEFINED);
+    } else {
+      // Transient attachments cannot be cleared with transfer
+      // commands, so clear each mip level in a render pass.
+      DxvkImageViewCreateInfo viewInfo;
+      viewInfo.type = image->info().type == VK_IMAGE_TYPE_1D
+        ? VK_IMAGE_VIEW_TYPE_1D_ARRAY
+        : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+      viewInfo.format = image->info().format;
+      viewInfo.usage = image->info().usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+      viewInfo.aspect = image->formatInfo()->aspectMask;
+      viewInfo.numLevels = 1;
+      viewInfo.minLayer = 0;
+      viewInfo.numLayers = image->info().numLayers;
+
+      for (uint32_t i = 0; i < image->info().mipLevels; i++) {
+        viewInfo.minLevel = i;
+
+        this->performClear(m_device->createImageView(image, viewInfo),
+          -1, 0, viewInfo.aspect, VkClearValue());
+      }
+    }
+  }
+
+
+  void DxvkContext::deferPendingInit(
+    const Rc<DxvkImageView>&        imageView) {
+    if (imageView == nullptr || likely(!imageView->image()->hasPendingInit()))
+      return;
+
+    // If the view covers the entire image, the clear can be
+    // folded into the load op of the upcoming render pass.
+    if (imageView->subresources() == imageView->image()->getAvailableSubresources()) {
+      if (imageView->image()->claimPendingInit())
+        this->deferClear(imageView, imageView->info().aspect, VkClearValue());
+    } else {
+      this->initPendingImage(imageView->image());
+    }
+  }
+
+
+  void DxvkContext::discardPendingInit(
+    const Rc<DxvkImageView>&        imageView,
+          VkImageAspectFlags        aspects) {
+    if (likely(!imageView->image()->hasPendingInit()))
+      return;
+
+    // Overwriting the entire image makes the clear redundant
+    if (aspects == imageView->image()->formatInfo()->aspectMask
+     && imageView->subresources() == imageView->image()->getAvailableSubresources())
+      imageView->image()->claimPendingInit();
+    else
+      this->initPendingImage(imageView->image());
+  }
+
+
+  void DxvkContext::deferClear(
+    const Rc<DxvkImageView>&        imageView,
+          VkImageAspectFlags        clearAspects,
+          VkClearValue              clearValue) {
+    for (auto& entry : m_deferredClears) {
+      if (entry.imageView->matchesView(imageView)) {
         entry.imageView = imageView;
         entry.discardAspects &= ~clearAspects;
         entry.clearAspects |= clearAspects;
@@ -2117,17 +2638,87 @@ namespace dxvk {
 
   void DxvkContext::flushClears(
           bool                      useRenderPass) {
-    for (const auto& clear : m_deferredClears) {
+    size_t keepCount = 0;
+
+    for (size_t i = 0; i < m_deferredClears.size(); i++) {
+      const auto& clear = m_deferredClears[i];
+
       int32_t attachmentIndex = -1;
 
-      if (useRenderPass && m_state.om.framebufferInfo.isFullSize(clear.imageView))
-        attachmentIndex = m_state.om.framebufferInfo.findAttachment(clear.imageView);
+      if (useRenderPass) {
+        if (m_state.om.framebufferInfo.isFullSize(clear.imageView))
+          attachmentIndex = m_state.om.framebufferInfo.findAttachment(clear.imageView);
+
+        // Keep clears for images that the render pass does not use as
+        // attachments, so that they can be folded into the load ops of
+        // a later render pass. Any other access to the image, including
+        // shader reads within this render pass, will flush the clear.
+        if (attachmentIndex < 0 && !m_state.om.framebufferInfo.usesImage(clear.imageView->image())) {
+          if (keepCount != i)
+            m_deferredClears[keepCount] = std::move(m_deferredClears[i]);
+
+          keepCount += 1;
+          continue;
+        }
+      }
 
       this->performClear(clear.imageView, attachmentIndex,
         clear.discardAspects, clear.clearAspects, clear.clearValue);
     }
 
-    m_deferredClears.clear();
+    m_deferredClears.erase(m_deferredClears.begin() + keepCount, m_deferredClears.end());
+  }
+
+
+  DxvkGpuProfilerScope DxvkContext::beginProfilerScope(
+          std::string               name,
+          DxvkGpuProfilerTrack      track) {
+    DxvkGpuProfilerScope scope;
+    scope.name  = std::move(name);
+    scope.track = track;
+    scope.begin = m_profiler->createQuery();
+
+    m_queryManager.writeTimestamp(m_cmd, scope.begin);
+    return scope;
+  }
+
+
+  void DxvkContext::endProfilerScope(
+          DxvkGpuProfilerScope&&    scope) {
+    if (scope.begin == nullptr)
+      return;
+
+    scope.end = m_profiler->createQuery();
+    m_queryManager.writeTimestamp(m_cmd, scope.end);
+
+    m_profiler->addScope(std::move(scope));
+  }
+
+
+  void DxvkContext::flushBoundResourceClears() {
+    const auto& layout = m_state.gp.pipeline->getBindings()->layout();
+
+    for (uint32_t i = 0; i < DxvkDescriptorSets::SetCount && !m_deferredClears.empty(); i++) {
+      for (uint32_t j = 0; j < layout.getBindingCount(i); j++) {
+        const auto& res = m_rc[layout.getBinding(i, j).resourceBinding];
+
+        if (res.imageView == nullptr)
+          continue;
+
+        for (auto c = m_deferredClears.begin(); c != m_deferredClears.end(); ) {
+          if (c->imageView->checkSubresourceOverlap(res.imageView)) {
+            // The image cannot be an attachment of the current render
+            // pass, so we can execute the clear outside of it.
+            this->spillRenderPass(true);
+            this->prepareImage(m_execBarriers, c->imageView->image(), c->imageView->subresources(), false);
+            this->performClear(c->imageView, -1, c->discardAspects, c->clearAspects, c->clearValue);
+            c = m_deferredClears.erase(c);
+          } else {
+            c++;
+          }
+        }
+      }
+    }
   }
 
 
@@ -2150,7 +2741,8 @@ namespace dxvk {
           VkDeviceSize              offset,
           VkDeviceSize              size,
     const void*                     data) {
-    bool replaceBuffer = this->tryInvalidateDeviceLocalBuffer(buffer, size);
+    bool replaceBuffer = this->tryInvalidateDeviceLocalBuffer(buffer, size)
+                      || this->tryHoistBufferTransfer(buffer, nullptr);
     auto bufferSlice = buffer->getSliceHandle(offset, size);
 
     if (!replaceBuffer) {
@@ -2207,6 +2799,7 @@ namespace dxvk {
     tmpBufferInfo.usage     = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     tmpBufferInfo.stages    = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     tmpBufferInfo.access    = VK_ACCESS_SHADER_READ_BIT;
+    tmpBufferInfo.category  = DxvkMemoryCategory::Meta;
 
     auto tmpBuffer = m_device->createBuffer(tmpBufferInfo,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
@@ -2226,11 +2819,18 @@ namespace dxvk {
   void DxvkContext::uploadBuffer(
     const Rc<DxvkBuffer>&           buffer,
     const void*                     data) {
-    auto bufferSlice = buffer->getSliceHandle();
+    auto stagingSlice = m_staging.alloc(CACHE_LINE_SIZE, buffer->info().size);
+    std::memcpy(stagingSlice.mapPtr(0), data, buffer->info().size);
+
+    this->uploadBuffer(buffer, stagingSlice);
+  }
 
-    auto stagingSlice = m_staging.alloc(CACHE_LINE_SIZE, bufferSlice.length);
-    auto stagingHandle = stagingSlice.getSliceHandle();
-    std::memcpy(stagingHandle.mapPtr, data, bufferSlice.length);
+
+  void DxvkContext::uploadBuffer(
+    const Rc<DxvkBuffer>&           buffer,
+    const DxvkBufferSlice&          source) {
+    auto bufferSlice = buffer->getSliceHandle();
+    auto stagingHandle = source.getSliceHandle();
 
     VkBufferCopy region;
     region.srcOffset = stagingHandle.offset;
@@ -2249,7 +2849,7 @@ namespace dxvk {
       buffer->info().stages,
       buffer->info().access);
     
-    m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+    m_cmd->trackResource<DxvkAccess::Read>(source.buffer());
     m_cmd->trackResource<DxvkAccess::Write>(buffer);
   }
 
@@ -2504,6 +3104,9 @@ namespace dxvk {
   
   void DxvkContext::setBarrierControl(DxvkBarrierControlFlags control) {
     m_barrierControl = control;
+
+    m_flags.clr(DxvkContextFlag::GpBarriersRecorded,
+                DxvkContextFlag::GpBarriersClean);
   }
   
   
@@ -2597,7 +3200,27 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::signalFence(const Rc<DxvkFence>& fence, uint64_t value) {
+    m_cmd->signalFence(fence, value);
+  }
+
+
+  void DxvkContext::waitFence(const Rc<DxvkFence>& fence, uint64_t value) {
+    m_cmd->waitFence(fence, value);
+  }
+
+
   void DxvkContext::beginDebugLabel(VkDebugUtilsLabelEXT *label) {
+    if (unlikely(m_profiler != nullptr)) {
+      std::string name = label->pLabelName ? label->pLabelName : "";
+
+      if (m_profiler->isCpuProfilingEnabled())
+        m_profilerCpuLabels.push_back(m_profiler->beginCpuScope(name));
+
+      m_profilerLabels.push_back(this->beginProfilerScope(
+        std::move(name), DxvkGpuProfilerTrack::Labels));
+    }
+
     if (!m_device->instance()->extensions().extDebugUtils)
       return;
 
@@ -2605,6 +3228,16 @@ namespace dxvk {
   }
 
   void DxvkContext::endDebugLabel() {
+    if (unlikely(m_profiler != nullptr) && !m_profilerLabels.empty()) {
+      this->endProfilerScope(std::move(m_profilerLabels.back()));
+      m_profilerLabels.pop_back();
+    }
+
+    if (unlikely(m_profiler != nullptr) && !m_profilerCpuLabels.empty()) {
+      m_profiler->endCpuScope(m_profilerCpuLabels.back(), DxvkCpuProfilerTrack::CsThread);
+      m_profilerCpuLabels.pop_back();
+    }
+
     if (!m_device->instance()->extensions().extDebugUtils)
       return;
 
@@ -3004,11 +3637,12 @@ namespace dxvk {
 
   void DxvkContext::clearImageViewFb(
     const Rc<DxvkImageView>&    imageView,
-          VkOffset3D            offset,
-          VkExtent3D            extent,
+          uint32_t              rectCount,
+    const DxvkClearRect*        rects,
           VkImageAspectFlags    aspect,
           VkClearValue          value) {
     this->updateFramebuffer();
+    this->initPendingImage(imageView->image());
 
     VkPipelineStageFlags clearStages = 0;
     VkAccessFlags clearAccess = 0;
@@ -3093,15 +3727,21 @@ namespace dxvk {
     if ((aspect & VK_IMAGE_ASPECT_COLOR_BIT) && (attachmentIndex >= 0))
       clearInfo.colorAttachment   = m_state.om.framebufferInfo.getColorAttachmentIndex(attachmentIndex);
 
-    VkClearRect clearRect;
-    clearRect.rect.offset.x       = offset.x;
-    clearRect.rect.offset.y       = offset.y;
-    clearRect.rect.extent.width   = extent.width;
-    clearRect.rect.extent.height  = extent.height;
-    clearRect.baseArrayLayer      = 0;
-    clearRect.layerCount          = imageView->info().numLayers;
+    // All rects share the same attachment and clear value,
+    // so they can be cleared with a single command
+    small_vector<VkClearRect, 8> clearRects;
+    clearRects.resize(rectCount);
 
-    m_cmd->cmdClearAttachments(1, &clearInfo, 1, &clearRect);
+    for (uint32_t i = 0; i < rectCount; i++) {
+      clearRects[i].rect.offset.x       = rects[i].offset.x;
+      clearRects[i].rect.offset.y       = rects[i].offset.y;
+      clearRects[i].rect.extent.width   = rects[i].extent.width;
+      clearRects[i].rect.extent.height  = rects[i].extent.height;
+      clearRects[i].baseArrayLayer      = 0;
+      clearRects[i].layerCount          = imageView->info().numLayers;
+    }
+
+    m_cmd->cmdClearAttachments(1, &clearInfo, rectCount, clearRects.data());
 
     // Unbind temporary framebuffer
     if (attachmentIndex < 0) {
@@ -3123,11 +3763,13 @@ namespace dxvk {
   
   void DxvkContext::clearImageViewCs(
     const Rc<DxvkImageView>&    imageView,
-          VkOffset3D            offset,
-          VkExtent3D            extent,
+          uint32_t              rectCount,
+    const DxvkClearRect*        rects,
           VkClearValue          value) {
     this->spillRenderPass(false);
     this->invalidateState();
+    this->initPendingImage(imageView->image());
+    this->prepareStorageImage(imageView->image());
     
     if (m_execBarriers.isImageDirty(
           imageView->image(),
@@ -3160,20 +3802,6 @@ namespace dxvk {
     descriptorWrite.pTexelBufferView = nullptr;
     m_cmd->updateDescriptorSets(1, &descriptorWrite);
     
-    // Prepare shader arguments
-    DxvkMetaClearArgs pushArgs = { };
-    pushArgs.clearValue = value.color;
-    pushArgs.offset = offset;
-    pushArgs.extent = extent;
-    
-    VkExtent3D workgroups = util::computeBlockCount(
-      pushArgs.extent, pipeInfo.workgroupSize);
-    
-    if (imageView->type() == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
-      workgroups.height = imageView->subresources().layerCount;
-    else if (imageView->type() == VK_IMAGE_VIEW_TYPE_2D_ARRAY)
-      workgroups.depth = imageView->subresources().layerCount;
-    
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeline);
@@ -3181,14 +3809,32 @@ namespace dxvk {
       VK_PIPELINE_BIND_POINT_COMPUTE,
       pipeInfo.pipeLayout, descriptorSet,
       0, nullptr);
-    m_cmd->cmdPushConstants(
-      pipeInfo.pipeLayout,
-      VK_SHADER_STAGE_COMPUTE_BIT,
-      0, sizeof(pushArgs), &pushArgs);
-    m_cmd->cmdDispatch(
-      workgroups.width,
-      workgroups.height,
-      workgroups.depth);
+    
+    // Rects of the same view don't need barriers in between,
+    // so just issue one dispatch per rect with new arguments
+    for (uint32_t i = 0; i < rectCount; i++) {
+      DxvkMetaClearArgs pushArgs = { };
+      pushArgs.clearValue = value.color;
+      pushArgs.offset = rects[i].offset;
+      pushArgs.extent = rects[i].extent;
+      
+      VkExtent3D workgroups = util::computeBlockCount(
+        pushArgs.extent, pipeInfo.workgroupSize);
+      
+      if (imageView->type() == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
+        workgroups.height = imageView->subresources().layerCount;
+      else if (imageView->type() == VK_IMAGE_VIEW_TYPE_2D_ARRAY)
+        workgroups.depth = imageView->subresources().layerCount;
+      
+      m_cmd->cmdPushConstants(
+        pipeInfo.pipeLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0, sizeof(pushArgs), &pushArgs);
+      m_cmd->cmdDispatch(
+        workgroups.width,
+        workgroups.height,
+        workgroups.depth);
+    }
     
     m_execBarriers.accessImage(
       imageView->image(),
@@ -3343,6 +3989,7 @@ namespace dxvk {
       imageInfo.mipLevels = 1;
       imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
       imageInfo.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      imageInfo.category = DxvkMemoryCategory::Meta;
       imageInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
       imageInfo.access = VK_ACCESS_TRANSFER_READ_BIT;
       imageInfo.viewFormatCount = 0;
@@ -3801,6 +4448,122 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::resolveImageCs(
+    const Rc<DxvkImage>&            dstImage,
+    const Rc<DxvkImage>&            srcImage,
+    const VkImageResolve&           region,
+          VkFormat                  format,
+          VkResolveModeFlagBitsKHR  mode) {
+    this->invalidateState();
+
+    auto dstSubresourceRange = vk::makeSubresourceRange(region.dstSubresource);
+    auto srcSubresourceRange = vk::makeSubresourceRange(region.srcSubresource);
+
+    if (m_execBarriers.isImageDirty(dstImage, dstSubresourceRange, DxvkAccess::Write)
+     || m_execBarriers.isImageDirty(srcImage, srcSubresourceRange, DxvkAccess::Write))
+      m_execBarriers.recordCommands(m_cmd);
+
+    // Discard the destination image if we're fully writing it
+    bool doDiscard = dstImage->isFullSubresource(region.dstSubresource, region.extent);
+
+    m_execAcquires.accessImage(
+      dstImage, dstSubresourceRange,
+      doDiscard ? VK_IMAGE_LAYOUT_UNDEFINED
+                : dstImage->info().layout,
+      dstImage->info().stages, 0,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT);
+
+    VkImageLayout srcLayout = srcImage->info().layout;
+
+    if (srcLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+      srcLayout = srcImage->pickLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    if (srcImage->info().layout != srcLayout) {
+      m_execAcquires.accessImage(
+        srcImage, srcSubresourceRange,
+        srcImage->info().layout,
+        srcImage->info().stages, 0,
+        srcLayout,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    m_execAcquires.recordCommands(m_cmd);
+
+    Rc<DxvkMetaResolveComputeViews> views = new DxvkMetaResolveComputeViews(m_device->vkd(),
+      dstImage, region.dstSubresource,
+      srcImage, region.srcSubresource, format);
+
+    DxvkMetaResolvePipeline pipeInfo = m_common->metaResolve().getComputePipeline(
+      srcImage->info().sampleCount, mode);
+
+    VkDescriptorSet descriptorSet = m_descriptorPool->alloc(pipeInfo.dsetLayout);
+
+    std::array<VkDescriptorImageInfo, 2> descriptorImages = {{
+      { VK_NULL_HANDLE, views->getSrcView(), srcLayout },
+      { VK_NULL_HANDLE, views->getDstView(), VK_IMAGE_LAYOUT_GENERAL },
+    }};
+
+    std::array<VkWriteDescriptorSet, 2> descriptorWrites = {{
+      { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+        descriptorSet, 0, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        &descriptorImages[0], nullptr, nullptr },
+      { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+        descriptorSet, 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        &descriptorImages[1], nullptr, nullptr },
+    }};
+
+    m_cmd->updateDescriptorSets(
+      descriptorWrites.size(),
+      descriptorWrites.data());
+
+    DxvkMetaResolveComputeArgs pushArgs;
+    pushArgs.srcOffset = { region.srcOffset.x, region.srcOffset.y };
+    pushArgs.dstOffset = { region.dstOffset.x, region.dstOffset.y };
+    pushArgs.extent    = { region.extent.width, region.extent.height };
+
+    // All layers get resolved in a single dispatch
+    VkExtent3D workgroups = util::computeBlockCount(
+      VkExtent3D { region.extent.width, region.extent.height, region.dstSubresource.layerCount },
+      VkExtent3D { 8, 8, 1 });
+
+    m_cmd->cmdBindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, pipeInfo.pipeHandle);
+    m_cmd->cmdBindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE,
+      pipeInfo.pipeLayout, descriptorSet, 0, nullptr);
+    m_cmd->cmdPushConstants(pipeInfo.pipeLayout,
+      VK_SHADER_STAGE_COMPUTE_BIT,
+      0, sizeof(pushArgs), &pushArgs);
+    m_cmd->cmdDispatch(
+      workgroups.width,
+      workgroups.height,
+      workgroups.depth);
+
+    m_execBarriers.accessImage(
+      dstImage, dstSubresourceRange,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT,
+      dstImage->info().layout,
+      dstImage->info().stages,
+      dstImage->info().access);
+
+    if (srcImage->info().layout != srcLayout) {
+      m_execBarriers.accessImage(
+        srcImage, srcSubresourceRange, srcLayout,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        srcImage->info().layout,
+        srcImage->info().stages,
+        srcImage->info().access);
+    }
+
+    m_cmd->trackResource<DxvkAccess::Write>(dstImage);
+    m_cmd->trackResource<DxvkAccess::Read>(srcImage);
+    m_cmd->trackResource<DxvkAccess::None>(views);
+  }
+
+
   void DxvkContext::resolveImageFb(
     const Rc<DxvkImage>&            dstImage,
     const Rc<DxvkImage>&            srcImage,
@@ -4008,6 +4771,18 @@ namespace dxvk {
 
       m_flags.clr(DxvkContextFlag::GpRenderPassSuspended);
 
+      if (unlikely(m_profiler != nullptr)) {
+        DxvkFramebufferSize size = m_state.om.framebufferInfo.size();
+
+        m_profilerPass = this->beginProfilerScope(
+          str::format("Render pass ", size.width, "x", size.height),
+          DxvkGpuProfilerTrack::Commands);
+      }
+
+      this->inferDepthStoreOp(
+        m_state.om.framebufferInfo,
+        m_state.om.renderPassOps);
+
       this->renderPassBindFramebuffer(
         m_state.om.framebufferInfo,
         m_state.om.renderPassOps);
@@ -4030,7 +4805,9 @@ namespace dxvk {
   
   void DxvkContext::spillRenderPass(bool suspend) {
     if (m_flags.test(DxvkContextFlag::GpRenderPassBound)) {
-      m_flags.clr(DxvkContextFlag::GpRenderPassBound);
+      m_flags.clr(DxvkContextFlag::GpRenderPassBound,
+                  DxvkContextFlag::GpBarriersRecorded,
+                  DxvkContextFlag::GpBarriersClean);
 
       this->pauseTransformFeedback();
       
@@ -4039,12 +4816,20 @@ namespace dxvk {
       
       this->renderPassUnbindFramebuffer();
 
+      if (unlikely(m_profiler != nullptr))
+        this->endProfilerScope(std::move(m_profilerPass));
+
       if (suspend)
         m_flags.set(DxvkContextFlag::GpRenderPassSuspended);
       else
         this->transitionRenderTargetLayouts(m_execBarriers, false);
 
       m_execBarriers.recordCommands(m_cmd);
+
+      // Clears for images not used by the render pass may still be
+      // pending, execute them before any other command can access
+      if (!suspend)
+        this->flushClears(false);
     } else if (!suspend) {
       // We may end a previously suspended render pass
       if (m_flags.test(DxvkContextFlag::GpRenderPassSuspended)) {
@@ -4203,6 +4988,74 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::inferDepthStoreOp(
+    const DxvkFramebufferInfo&  framebufferInfo,
+          DxvkRenderPassOps&    ops) {
+    const auto& depthTarget = framebufferInfo.getDepthTarget();
+    ops.depthOps.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+    if (depthTarget.view == nullptr || !m_device->config().inferDepthStoreOps)
+      return;
+
+    // Only consider images whose contents can only be read
+    // by loading them in a render pass or through transfer
+    // operations, which go through prepareImage. Shader
+    // reads may happen at any time while a view is bound.
+    const Rc<DxvkImage>& image = depthTarget.view->image();
+
+    if (image->info().shared || (image->info().usage & (
+          VK_IMAGE_USAGE_SAMPLED_BIT |
+          VK_IMAGE_USAGE_STORAGE_BIT |
+          VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)))
+      return;
+
+    if (depthTarget.view->subresources() != image->getAvailableSubresources()) {
+      this->trackDepthRead(image);
+      return;
+    }
+
+    VkImageAspectFlags aspects = depthTarget.view->info().aspect;
+
+    bool loadsContents = ((aspects & VK_IMAGE_ASPECT_DEPTH_BIT) && ops.depthOps.loadOpD == VK_ATTACHMENT_LOAD_OP_LOAD)
+                      || ((aspects & VK_IMAGE_ASPECT_STENCIL_BIT) && ops.depthOps.loadOpS == VK_ATTACHMENT_LOAD_OP_LOAD);
+
+    DxvkDepthStoreInfo info = image->getDepthStoreInfo();
+
+    if (loadsContents) {
+      // A previously skipped store was needed after all, never
+      // skip stores for this image again to avoid corruption.
+      info.disabled |= info.storeSkipped;
+      info.discardCount = 0;
+    } else if (info.discardCount < MinDepthDiscardCount) {
+      info.discardCount += 1;
+    }
+
+    info.storeSkipped = !info.disabled
+      && info.discardCount >= MinDepthDiscardCount
+      && depthTarget.layout != VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    image->setDepthStoreInfo(info);
+
+    if (info.storeSkipped)
+      ops.depthOps.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  }
+
+
+  void DxvkContext::trackDepthRead(
+    const Rc<DxvkImage>&        image) {
+    DxvkDepthStoreInfo info = image->getDepthStoreInfo();
+
+    if (likely(!info.discardCount && !info.storeSkipped))
+      return;
+
+    info.disabled |= info.storeSkipped;
+    info.discardCount = 0;
+    info.storeSkipped = false;
+
+    image->setDepthStoreInfo(info);
+  }
+
+
   void DxvkContext::renderPassBindFramebuffer(
     const DxvkFramebufferInfo&  framebufferInfo,
     const DxvkRenderPassOps&    ops) {
@@ -4241,7 +5094,7 @@ namespace dxvk {
       depthInfo.imageView = depthTarget.view->handle();
       depthInfo.imageLayout = depthTarget.layout;
       depthInfo.loadOp = ops.depthOps.loadOpD;
-      depthInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+      depthInfo.storeOp = ops.depthOps.storeOp;
 
       if (ops.depthOps.loadOpD == VK_ATTACHMENT_LOAD_OP_CLEAR)
         depthInfo.clearValue.depthStencil.depth = ops.depthOps.clearValue.depth;
@@ -4251,7 +5104,7 @@ namespace dxvk {
 
     if (framebufferInfo.getDepthTarget().view != nullptr) {
       stencilInfo.loadOp = ops.depthOps.loadOpS;
-      stencilInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+      stencilInfo.storeOp = ops.depthOps.storeOp;
 
       if (ops.depthOps.loadOpS == VK_ATTACHMENT_LOAD_OP_CLEAR)
         stencilInfo.clearValue.depthStencil.stencil = ops.depthOps.clearValue.stencil;
@@ -4478,11 +5331,15 @@ namespace dxvk {
     
     // Check which dynamic states need to be active. States that
     // are not dynamic will be invalidated in the command buffer.
+    // Depth bounds and stencil reference are dynamic in all
+    // pipelines, since depth-stencil state is not part of the
+    // pipeline key.
     m_flags.clr(DxvkContextFlag::GpDynamicBlendConstants,
-                DxvkContextFlag::GpDynamicDepthBias,
-                DxvkContextFlag::GpDynamicDepthBounds,
-                DxvkContextFlag::GpDynamicStencilRef);
+                DxvkContextFlag::GpDynamicDepthBias);
     
+    m_flags.set(DxvkContextFlag::GpDynamicDepthBounds,
+                DxvkContextFlag::GpDynamicStencilRef);
+
     m_flags.set(m_state.gp.state.useDynamicBlendConstants()
       ? DxvkContextFlag::GpDynamicBlendConstants
       : DxvkContextFlag::GpDirtyBlendConstants);
@@ -4490,24 +5347,54 @@ namespace dxvk {
     m_flags.set(m_state.gp.state.useDynamicDepthBias()
       ? DxvkContextFlag::GpDynamicDepthBias
       : DxvkContextFlag::GpDirtyDepthBias);
-    
-    m_flags.set(m_state.gp.state.useDynamicDepthBounds()
-      ? DxvkContextFlag::GpDynamicDepthBounds
-      : DxvkContextFlag::GpDirtyDepthBounds);
-    
-    m_flags.set(m_state.gp.state.useDynamicStencilRef()
-      ? DxvkContextFlag::GpDynamicStencilRef
-      : DxvkContextFlag::GpDirtyStencilRef);
+
+    // If depth bias enable is dynamic, depth bias itself is always
+    // dynamic and needs to be re-applied since it is zeroed out
+    // while depth bias is disabled.
+    if (m_features.test(DxvkContextFeature::ExtendedDynamicState2)) {
+      m_flags.set(DxvkContextFlag::GpDynamicDepthBias,
+                  DxvkContextFlag::GpDirtyDepthBias);
+    }
     
     // Retrieve and bind actual Vulkan pipeline handle
-    VkPipeline pipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state);
+    auto pipelineInfo = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state);
 
-    if (unlikely(!pipeline))
+    if (unlikely(!pipelineInfo.first)) {
+      m_cmd->addStatCtr(DxvkStatCounter::PipeSkippedDraws, 1);
       return false;
+    }
 
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_GRAPHICS,
-      pipeline);
+      pipelineInfo.first);
+
+    // For pipelines created from graphics pipeline libraries, depth
+    // bias is always enabled and needs to be applied dynamically
+    if (unlikely(pipelineInfo.second == DxvkGraphicsPipelineType::BasePipeline)) {
+      m_flags.set(
+        DxvkContextFlag::GpDynamicDepthBias,
+        DxvkContextFlag::GpDirtyDepthBias,
+        DxvkContextFlag::GpDirtyDepthBounds,
+        DxvkContextFlag::GpDirtyStencilRef);
+    }
+
+    // State that is not part of the pipeline key must
+    // be applied dynamically for all pipeline types.
+    this->updatePipelineDynamicState(pipelineInfo.second);
+
+    // Descriptor sets are bound with a different pipeline layout
+    // for base pipelines, so we need to re-bind them if the type
+    // of the bound pipeline changes.
+    bool independentSets = pipelineInfo.second == DxvkGraphicsPipelineType::BasePipeline;
+
+    if (independentSets != m_flags.test(DxvkContextFlag::GpIndependentSets)) {
+      if (independentSets)
+        m_flags.set(DxvkContextFlag::GpIndependentSets);
+      else
+        m_flags.clr(DxvkContextFlag::GpIndependentSets);
+
+      m_descriptorState.dirtyStages(VK_SHADER_STAGE_ALL_GRAPHICS);
+    }
 
     // Emit barrier based on pipeline properties, in order to avoid
     // accidental write-after-read hazards after the render pass.
@@ -4529,6 +5416,83 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::updatePipelineDynamicState(DxvkGraphicsPipelineType pipelineType) {
+    const auto& state = m_state.gp.state;
+
+    VkImageAspectFlags rtReadOnlyAspects = state.rt.getDepthStencilReadOnlyAspects();
+
+    m_cmd->cmdSetCullMode(state.rs.cullMode());
+    m_cmd->cmdSetFrontFace(state.rs.frontFace());
+
+    m_cmd->cmdSetDepthState(
+      state.ds.enableDepthTest(),
+      state.ds.enableDepthWrite() && !(rtReadOnlyAspects & VK_IMAGE_ASPECT_DEPTH_BIT),
+      state.ds.depthCompareOp(),
+      state.ds.enableDepthBoundsTest());
+
+    m_cmd->cmdSetStencilTestEnable(state.ds.enableStencilTest());
+    m_cmd->cmdSetStencilState(VK_STENCIL_FACE_FRONT_BIT, state.dsFront.state());
+    m_cmd->cmdSetStencilState(VK_STENCIL_FACE_BACK_BIT, state.dsBack.state());
+
+    if (m_features.test(DxvkContextFeature::ExtendedDynamicState2)) {
+      m_cmd->cmdSetPrimitiveRestartEnable(state.ia.primitiveRestart());
+
+      // Depth bias is statically enabled in base pipelines
+      if (pipelineType == DxvkGraphicsPipelineType::FastPipeline)
+        m_cmd->cmdSetDepthBiasEnable(state.rs.depthBiasEnable());
+    }
+
+    if (m_features.test(DxvkContextFeature::ExtendedDynamicState2LogicOp))
+      m_cmd->cmdSetLogicOp(state.om.logicOp());
+
+    if (m_features.test(DxvkContextFeature::VertexInputDynamicState))
+      this->updateVertexInputState();
+  }
+
+
+  void DxvkContext::updateVertexInputState() {
+    const auto& state = m_state.gp.state;
+
+    bool useDivisors = m_device->features().extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor;
+
+    std::array<VkVertexInputBindingDescription2EXT,   MaxNumVertexBindings>   bindings;
+    std::array<VkVertexInputAttributeDescription2EXT, MaxNumVertexAttributes> attributes;
+
+    // Compact vertex bindings the same way pipelines do, so
+    // that vertex buffers are bound to the right indices
+    std::array<uint32_t, MaxNumVertexBindings> bindingMap = { };
+
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
+      const auto& binding = state.ilBindings[i];
+
+      bindings[i] = { VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT };
+      bindings[i].binding = i;
+      bindings[i].stride = binding.stride();
+      bindings[i].inputRate = binding.inputRate();
+      bindings[i].divisor = 1;
+
+      if (binding.inputRate() == VK_VERTEX_INPUT_RATE_INSTANCE && useDivisors)
+        bindings[i].divisor = binding.divisor();
+
+      bindingMap[binding.binding()] = i;
+    }
+
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++) {
+      const auto& attribute = state.ilAttributes[i];
+
+      attributes[i] = { VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT };
+      attributes[i].location = attribute.location();
+      attributes[i].binding = bindingMap[attribute.binding()];
+      attributes[i].format = attribute.format();
+      attributes[i].offset = attribute.offset();
+    }
+
+    m_cmd->cmdSetVertexInput(
+      state.il.bindingCount(), bindings.data(),
+      state.il.attributeCount(), attributes.data());
+  }
+
+
   void DxvkContext::invalidateState() {
     this->unbindComputePipeline();
     this->unbindGraphicsPipeline();
@@ -4544,7 +5508,13 @@ namespace dxvk {
     // For 64-bit applications, using templates is slower on some drivers.
     constexpr bool useDescriptorTemplates = env::is32BitHostPlatform();
 
+    // Base pipelines linked from pipeline libraries use
+    // a layout that was created with independent sets
+    bool independentSets = BindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+      && m_flags.test(DxvkContextFlag::GpIndependentSets);
+
     uint32_t layoutSetMask = layout->getSetMask();
+    uint32_t pushSetMask = layout->getPushSetMask();
     uint32_t dirtySetMask = BindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
       ? m_descriptorState.getDirtyGraphicsSets()
       : m_descriptorState.getDirtyComputeSets();
@@ -4554,22 +5524,34 @@ namespace dxvk {
     uint32_t k = 0;
 
     std::array<VkDescriptorSet, DxvkDescriptorSets::SetCount> sets;
-    m_descriptorPool->alloc(layout, dirtySetMask, sets.data());
+
+    // Dynamic offsets for all sets bound in the next bind call,
+    // in set order and binding order within each set.
+    std::array<uint32_t, DxvkDescriptorSets::SetCount * MaxNumUniformBuffersDynamic> dynamicOffsets;
+    uint32_t dynamicOffsetCount = 0;
 
     while (dirtySetMask) {
       uint32_t setIndex = bit::tzcnt(dirtySetMask);
 
       // Initialize binding mask for the current set, only
       // clear bits if certain resources are actually unbound.
-      uint32_t bindingCount = bindings.getBindingCount(setIndex);
-      VkDescriptorSet set = sets[setIndex];
+      // Immutable samplers are never written and can be skipped.
+      uint32_t bindingCount = bindings.getDescriptorWriteCount(setIndex);
+      uint32_t firstDescriptor = k;
+
+      bool isPushSet = (pushSetMask >> setIndex) & 1;
+
+      // Sets without an update template are written directly
+      bool useWrites = !useDescriptorTemplates
+        || !layout->getSetUpdateTemplate(setIndex);
 
       for (uint32_t j = 0; j < bindingCount; j++) {
         const auto& binding = bindings.getBinding(setIndex, j);
 
-        if (!useDescriptorTemplates) {
-          m_descriptorWrites[k].dstSet = set;
+        if (useWrites) {
+          m_descriptorWrites[k].pNext = nullptr;
           m_descriptorWrites[k].dstBinding = j;
+          m_descriptorWrites[k].descriptorCount = 1;
           m_descriptorWrites[k].descriptorType = binding.descriptorType;
         }
 
@@ -4626,14 +5608,17 @@ namespace dxvk {
           case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
             const auto& res = m_rc[binding.resourceBinding];
 
-            if (res.sampler != nullptr && res.imageView != nullptr
+            // The sampler is ignored if the binding has an immutable sampler
+            if ((res.sampler != nullptr || binding.sampler) && res.imageView != nullptr
             && res.imageView->handle(binding.viewType) != VK_NULL_HANDLE) {
-              m_descriptors[k].image.sampler     = res.sampler->handle();
+              m_descriptors[k].image.sampler     = binding.sampler ? VK_NULL_HANDLE : res.sampler->handle();
               m_descriptors[k].image.imageView   = res.imageView->handle(binding.viewType);
               m_descriptors[k].image.imageLayout = res.imageView->imageInfo().layout;
 
               if (m_rcTracked.set(binding.resourceBinding)) {
-                m_cmd->trackResource<DxvkAccess::None>(res.sampler);
+                if (!binding.sampler)
+                  m_cmd->trackResource<DxvkAccess::None>(res.sampler);
+
                 m_cmd->trackResource<DxvkAccess::None>(res.imageView);
                 m_cmd->trackResource<DxvkAccess::Read>(res.imageView->image());
               }
@@ -4700,6 +5685,43 @@ namespace dxvk {
             }
           } break;
 
+          case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: {
+            const auto& res = m_rc[binding.resourceBinding];
+
+            // Keep the descriptor itself independent of the slice
+            // offset so that the cached set can be reused after
+            // the buffer got discarded.
+            if (res.bufferSlice.defined()) {
+              m_descriptors[k] = res.bufferSlice.getDescriptor();
+              m_descriptors[k].buffer.offset = 0;
+              dynamicOffsets[dynamicOffsetCount++] = uint32_t(res.bufferSlice.getDynamicOffset());
+
+              if (m_rcTracked.set(binding.resourceBinding))
+                m_cmd->trackResource<DxvkAccess::Read>(res.bufferSlice.buffer());
+            } else {
+              m_descriptors[k].buffer = VkDescriptorBufferInfo();
+              dynamicOffsets[dynamicOffsetCount++] = 0;
+            }
+          } break;
+
+          case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT: {
+            static const std::array<uint32_t, MaxInlineUniformBlockSize / sizeof(uint32_t)> zeroData = { };
+
+            const auto* block = lookupInlineUniformBlock(binding.resourceBinding);
+
+            // The data itself is not part of the descriptor info,
+            // so use the block version to identify cached sets.
+            m_descriptors[k].buffer.buffer = VK_NULL_HANDLE;
+            m_descriptors[k].buffer.offset = block ? block->version : 0u;
+            m_descriptors[k].buffer.range  = binding.uniformSize;
+
+            m_inlineWrites[k].dataSize = binding.uniformSize;
+            m_inlineWrites[k].pData    = block ? block->data.data() : zeroData.data();
+
+            m_descriptorWrites[k].pNext = &m_inlineWrites[k];
+            m_descriptorWrites[k].descriptorCount = binding.uniformSize;
+          } break;
+
           default:
             break;
         }
@@ -4707,18 +5729,52 @@ namespace dxvk {
         k += 1;
       }
 
-      if (useDescriptorTemplates) {
-        m_cmd->updateDescriptorSetWithTemplate(set,
-          layout->getSetUpdateTemplate(setIndex),
-          &m_descriptors[k - bindingCount]);
+      // Push descriptors are written directly into the command
+      // buffer. All lower sets have already been bound at this
+      // point since the push set is always the last set used.
+      if (isPushSet) {
+        if (k > firstDescriptor) {
+          m_cmd->cmdPushDescriptorSet(BindPoint,
+            layout->getPipelineLayout(independentSets),
+            setIndex, k - firstDescriptor,
+            &m_descriptorWrites[firstDescriptor]);
+        }
+
+        k = firstDescriptor;
+        dirtySetMask &= dirtySetMask - 1;
+        continue;
+      }
+
+      // Reuse a set with identical contents if one was already
+      // written in this command list, and skip the update.
+      VkDescriptorSet set = VK_NULL_HANDLE;
+
+      bool needsUpdate = m_descriptorPool->allocCached(layout, setIndex,
+        bindingCount, &m_descriptors[firstDescriptor], set);
+
+      if (needsUpdate) {
+        if (!useWrites) {
+          m_cmd->updateDescriptorSetWithTemplate(set,
+            layout->getSetUpdateTemplate(setIndex),
+            &m_descriptors[firstDescriptor]);
+          k = firstDescriptor;
+        } else {
+          for (uint32_t j = firstDescriptor; j < k; j++)
+            m_descriptorWrites[j].dstSet = set;
+        }
+      } else {
+        k = firstDescriptor;
       }
 
+      sets[setIndex] = set;
       bindCount += 1;
 
       // If the next set is not dirty, update and bind all previously
       // updated sets in one go in order to reduce api call overhead.
-      if (!(dirtySetMask & (1u << (setIndex + 1)))) {
-        if (!useDescriptorTemplates) {
+      uint32_t nextSetBit = 1u << (setIndex + 1);
+
+      if (!(dirtySetMask & nextSetBit) || (pushSetMask & nextSetBit)) {
+        if (k) {
           m_cmd->updateDescriptorSets(k, m_descriptorWrites.data());
           k = 0;
         }
@@ -4726,11 +5782,12 @@ namespace dxvk {
         uint32_t firstSet = setIndex + 1 - bindCount;
 
         m_cmd->cmdBindDescriptorSets(BindPoint,
-          layout->getPipelineLayout(),
+          layout->getPipelineLayout(independentSets),
           firstSet, bindCount, &sets[firstSet],
-          0, nullptr);
+          dynamicOffsetCount, dynamicOffsets.data());
 
         bindCount = 0;
+        dynamicOffsetCount = 0;
       }
 
       dirtySetMask &= dirtySetMask - 1;
@@ -4738,6 +5795,17 @@ namespace dxvk {
   }
 
 
+  const DxvkInlineUniformBlock* DxvkContext::lookupInlineUniformBlock(
+          uint32_t              slot) const {
+    for (const auto& b : m_inlineBlocks) {
+      if (b.slot == slot)
+        return &b;
+    }
+
+    return nullptr;
+  }
+
+
   void DxvkContext::updateComputeShaderResources() {
     this->updateResourceBindings<VK_PIPELINE_BIND_POINT_COMPUTE>(m_state.cp.pipeline->getBindings());
 
@@ -4764,6 +5832,13 @@ namespace dxvk {
 
       this->spillRenderPass(true);
 
+      // Fold pending initialization of newly bound render
+      // targets into the load ops of the next render pass
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+        this->deferPendingInit(m_state.om.renderTargets.color[i].view);
+
+      this->deferPendingInit(m_state.om.renderTargets.depth.view);
+
       DxvkFramebufferInfo fbInfo = makeFramebufferInfo(m_state.om.renderTargets);
       this->updateRenderTargetLayouts(fbInfo, m_state.om.framebufferInfo);
 
@@ -4931,6 +6006,12 @@ namespace dxvk {
     if (!(image->info().usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)))
       return;
 
+    // Render targets may not have been initialized yet
+    this->initPendingImage(image);
+
+    // The image may be read, so keep storing its contents
+    this->trackDepthRead(image);
+
     // Flush clears if there are any since they may affect the image
     if (!m_deferredClears.empty() && flushClears)
       this->spillRenderPass(false);
@@ -5092,10 +6173,15 @@ namespace dxvk {
                     DxvkContextFlag::GpDynamicDepthBias)) {
       m_flags.clr(DxvkContextFlag::GpDirtyDepthBias);
 
-      m_cmd->cmdSetDepthBias(
-        m_state.dyn.depthBias.depthBiasConstant,
-        m_state.dyn.depthBias.depthBiasClamp,
-        m_state.dyn.depthBias.depthBiasSlope);
+      // Base pipelines always enable depth bias
+      if (m_state.gp.state.rs.depthBiasEnable()) {
+        m_cmd->cmdSetDepthBias(
+          m_state.dyn.depthBias.depthBiasConstant,
+          m_state.dyn.depthBias.depthBiasClamp,
+          m_state.dyn.depthBias.depthBiasSlope);
+      } else {
+        m_cmd->cmdSetDepthBias(0.0f, 0.0f, 0.0f);
+      }
     }
     
     if (m_flags.all(DxvkContextFlag::GpDirtyDepthBounds,
@@ -5123,7 +6209,7 @@ namespace dxvk {
       return;
     
     m_cmd->cmdPushConstants(
-      bindings->getPipelineLayout(),
+      bindings->getPipelineLayout(false),
       pushConstRange.stageFlags,
       pushConstRange.offset,
       pushConstRange.size,
@@ -5156,15 +6242,94 @@ namespace dxvk {
   
   template<bool Indexed, bool Indirect>
   bool DxvkContext::commitGraphicsState() {
+    DXVK_TRACE_SCOPE("DxvkContext::commitGraphicsState");
+
+    // Gather all dirty flags that are relevant for this type of draw.
+    // Dirty flags for static pipeline state persist until the state
+    // becomes dynamic, and are ignored by the update functions.
+    DxvkContextFlags bindingMask(
+      DxvkContextFlag::GpDirtyPipeline,
+      DxvkContextFlag::GpDirtyVertexBuffers);
+
+    if (Indexed)
+      bindingMask.set(DxvkContextFlag::GpDirtyIndexBuffer);
+
+    if (Indirect)
+      bindingMask.set(DxvkContextFlag::DirtyDrawBuffer);
+
+    DxvkContextFlags dirtyMask = bindingMask;
+    dirtyMask.set(
+      DxvkContextFlag::GpDirtyFramebuffer,
+      DxvkContextFlag::GpDirtyPipelineState,
+      DxvkContextFlag::GpDirtyViewport,
+      DxvkContextFlag::DirtyPushConstants);
+
+    if (m_flags.test(DxvkContextFlag::GpDynamicBlendConstants))
+      dirtyMask.set(DxvkContextFlag::GpDirtyBlendConstants);
+
+    if (m_flags.test(DxvkContextFlag::GpDynamicDepthBias))
+      dirtyMask.set(DxvkContextFlag::GpDirtyDepthBias);
+
+    if (m_flags.test(DxvkContextFlag::GpDynamicDepthBounds))
+      dirtyMask.set(DxvkContextFlag::GpDirtyDepthBounds);
+
+    if (m_flags.test(DxvkContextFlag::GpDynamicStencilRef))
+      dirtyMask.set(DxvkContextFlag::GpDirtyStencilRef);
+
+    bool dirtySets = m_descriptorState.hasDirtyGraphicsSets();
+
+    // Fast path for back-to-back draws that use the exact same
+    // state as the previous draw, where nothing needs updating
+    // and no hazards can occur between the two draws.
+    bool barriersClean = !m_state.gp.flags.test(DxvkGraphicsPipelineFlag::HasStorageDescriptors)
+      || m_flags.test(DxvkContextFlag::GpBarriersClean);
+
+    if (likely(barriersClean && !dirtySets
+     && m_flags.test(DxvkContextFlag::GpRenderPassBound)
+     && (m_flags & dirtyMask).isClear()
+     && !m_state.gp.flags.test(DxvkGraphicsPipelineFlag::HasTransformFeedback)))
+      return true;
+
+    // Any change to the bound resources invalidates the cached
+    // hazard check, as does anything that ended the render pass
+    if (dirtySets || !(m_flags & bindingMask).isClear())
+      m_flags.clr(DxvkContextFlag::GpBarriersRecorded, DxvkContextFlag::GpBarriersClean);
+
     if (m_flags.test(DxvkContextFlag::GpDirtyPipeline)) {
       if (unlikely(!this->updateGraphicsPipeline()))
         return false;
     }
     
+    // Pending clears must be executed before shaders can read
+    // the affected images. Descriptor sets are always dirty if
+    // the pipeline or any of the bound resources have changed.
+    // Clears are only deferred outside of render passes, so any
+    // render pass start must also check them, since the clear
+    // may target an image that is already bound to a shader.
+    if (unlikely(!m_deferredClears.empty())
+     && (m_descriptorState.hasDirtyGraphicsSets()
+      || !m_flags.test(DxvkContextFlag::GpRenderPassBound)))
+      this->flushBoundResourceClears();
+
     if (m_state.gp.flags.any(DxvkGraphicsPipelineFlag::HasStorageDescriptors,
-                             DxvkGraphicsPipelineFlag::HasTransformFeedback)) {
+                             DxvkGraphicsPipelineFlag::HasTransformFeedback)
+     && !m_flags.test(DxvkContextFlag::GpBarriersClean)) {
+      bool recorded = m_flags.all(
+        DxvkContextFlag::GpRenderPassBound,
+        DxvkContextFlag::GpBarriersRecorded);
+
       this->commitGraphicsBarriers<Indexed, Indirect, false>();
       this->commitGraphicsBarriers<Indexed, Indirect, true>();
+
+      // If the accesses of this exact draw state were already recorded
+      // and the check still passed without a barrier, repeating the
+      // draw cannot add any new hazards until the state changes.
+      if (m_flags.test(DxvkContextFlag::GpRenderPassBound)) {
+        if (recorded && !m_state.gp.flags.test(DxvkGraphicsPipelineFlag::HasTransformFeedback))
+          m_flags.set(DxvkContextFlag::GpBarriersClean);
+
+        m_flags.set(DxvkContextFlag::GpBarriersRecorded);
+      }
     }
 
     if (m_flags.test(DxvkContextFlag::GpDirtyFramebuffer))
@@ -5199,6 +6364,11 @@ namespace dxvk {
 
       if (unlikely(!this->updateGraphicsPipelineState(barrier)))
         return false;
+
+      // Binding a base pipeline may require re-binding descriptor
+      // sets since a different pipeline layout will be used
+      if (unlikely(m_descriptorState.hasDirtyGraphicsSets()))
+        this->updateGraphicsShaderResources();
     }
     
     if (m_state.gp.flags.test(DxvkGraphicsPipelineFlag::HasTransformFeedback))
@@ -5602,6 +6772,60 @@ namespace dxvk {
   }
   
 
+  bool DxvkContext::tryHoistBufferTransfer(
+    const Rc<DxvkBuffer>&           dstBuffer,
+    const Rc<DxvkBuffer>&           srcBuffer) {
+    // Only worth it if the transfer would otherwise end the
+    // render pass, which then has to be resumed on the same
+    // attachments, causing an extra store and load.
+    if (!m_flags.test(DxvkContextFlag::GpRenderPassBound))
+      return false;
+
+    // The init command buffer executes before any command recorded
+    // into the current command list, so this is only safe if the
+    // buffers are not used by any recorded or pending command.
+    if (dstBuffer->isInUse() || (srcBuffer != nullptr && srcBuffer->isInUse()))
+      return false;
+
+    m_cmd->addStatCtr(DxvkStatCounter::CmdRenderPassSplitsAvoided, 1);
+    return true;
+  }
+
+
+  void DxvkContext::relocateBuffer(
+    const Rc<DxvkBuffer>&           buffer,
+          DxvkBufferRelocation      mode) {
+    Rc<DxvkBufferStorage> oldStorage = buffer->relocateStorage(mode);
+
+    if (oldStorage == nullptr)
+      return;
+
+    // The buffer is not in use, so we can copy its contents to
+    // the new location on the init command buffer without having
+    // to interrupt the current render pass or insert barriers.
+    DxvkBufferSliceHandle newSlice = buffer->getSliceHandle();
+
+    VkBufferCopy region;
+    region.srcOffset = 0;
+    region.dstOffset = newSlice.offset;
+    region.size      = newSlice.length;
+
+    m_cmd->cmdCopyBuffer(DxvkCmdBuffer::InitBuffer,
+      oldStorage->handle(), newSlice.handle, 1, &region);
+
+    m_initBarriers.accessBuffer(newSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      buffer->info().stages,
+      buffer->info().access);
+
+    m_cmd->trackResource<DxvkAccess::Read>(oldStorage);
+    m_cmd->trackResource<DxvkAccess::Write>(buffer);
+
+    this->updateBufferBindings(buffer);
+  }
+
+
   DxvkGraphicsPipeline* DxvkContext::lookupGraphicsPipeline(
     const DxvkGraphicsPipelineShaders&  shaders) {
     auto idx = shaders.hash() % m_gpLookupCache.size();
@@ -5624,6 +6848,30 @@ namespace dxvk {
   }
 
 
+  Rc<DxvkBuffer> DxvkContext::createMipGenCounterBuffer(
+          uint32_t                  layerCount) {
+    VkDeviceSize size = sizeof(uint32_t) * layerCount;
+
+    if (m_mipGenCounters != nullptr && m_mipGenCounters->info().size >= size)
+      return m_mipGenCounters;
+
+    DxvkBufferCreateInfo bufInfo;
+    bufInfo.size    = align<VkDeviceSize>(size, 4096);
+    bufInfo.usage   = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufInfo.stages  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                    | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    bufInfo.access  = VK_ACCESS_SHADER_READ_BIT
+                    | VK_ACCESS_SHADER_WRITE_BIT
+                    | VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufInfo.category = DxvkMemoryCategory::Meta;
+
+    m_mipGenCounters = m_device->createBuffer(bufInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    return m_mipGenCounters;
+  }
+
+
   Rc<DxvkBuffer> DxvkContext::createZeroBuffer(
           VkDeviceSize              size) {
     if (m_zeroBuffer != nullptr && m_zeroBuffer->info().size >= size)
@@ -5636,6 +6884,7 @@ namespace dxvk {
     bufInfo.stages  = VK_PIPELINE_STAGE_TRANSFER_BIT;
     bufInfo.access  = VK_ACCESS_TRANSFER_WRITE_BIT
                     | VK_ACCESS_TRANSFER_READ_BIT;
+    bufInfo.category = DxvkMemoryCategory::Meta;
 
     m_zeroBuffer = m_device->createBuffer(bufInfo,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -20,6 +20,15 @@ namespace dxvk {
    */
   class DxvkContext : public RcObject {
     constexpr static VkDeviceSize StagingBufferSize = 4ull << 20;
+    /// Maximum number of pixels per layer for which full-image
+    /// resolves prefer the compute path over a render pass
+    constexpr static uint32_t MaxComputeResolveArea = 512 * 512;
+    /// Maximum amount of buffer memory to evict or
+    /// restore per frame when over the memory budget
+    constexpr static VkDeviceSize MaxEvictionSize = 64ull << 20;
+    /// Number of consecutive render passes that must not load
+    /// depth contents before the depth store gets skipped
+    constexpr static uint32_t MinDepthDiscardCount = 16;
   public:
     
     DxvkContext(const Rc<DxvkDevice>& device, DxvkContextType type);
@@ -96,8 +105,8 @@ namespace dxvk {
         m_state.om.renderPassOps);
 
       if (!m_state.om.framebufferInfo.hasTargets(targets)) {
-        // Create a new framebuffer object next
-        // time we start rendering something
+        // Update framebuffer info next time
+        // we start rendering something
         m_flags.set(DxvkContextFlag::GpDirtyFramebuffer);
       } else {
         // Don't redundantly spill the render pass if
@@ -171,6 +180,8 @@ namespace dxvk {
      * Can be used for sampled images with a dedicated
      * sampler and for storage images, as well as for
      * uniform texel buffers and storage texel buffers.
+     * Binding a storage image view will move the image
+     * to \c VK_IMAGE_LAYOUT_GENERAL if necessary.
      * \param [in] stages Shader stages that access the binding
      * \param [in] slot Resource binding slot
      * \param [in] imageView Image view to bind
@@ -181,6 +192,12 @@ namespace dxvk {
             uint32_t              slot,
       const Rc<DxvkImageView>&    imageView,
       const Rc<DxvkBufferView>&   bufferView) {
+      if (imageView != nullptr && unlikely(imageView->image()->hasPendingInit()))
+        this->initPendingImage(imageView->image());
+
+      if (imageView != nullptr && (imageView->info().usage & VK_IMAGE_USAGE_STORAGE_BIT))
+        this->prepareStorageImage(imageView->image());
+
       m_rc[slot].imageView   = imageView;
       m_rc[slot].bufferView  = bufferView;
       m_rc[slot].bufferSlice = bufferView != nullptr
@@ -209,6 +226,24 @@ namespace dxvk {
 
       m_descriptorState.dirtyViews(stages);
     }
+
+    /**
+     * \brief Sets inline uniform block data
+     *
+     * Data is written directly into the descriptor set, so
+     * this avoids buffer updates for small, frequently changing
+     * constants. Must only be used for inline uniform block
+     * bindings, see \c DxvkDevice::canUseInlineUniformBlocks.
+     * \param [in] stages Shader stages that access the binding
+     * \param [in] slot Resource binding slot
+     * \param [in] size Data size, in bytes
+     * \param [in] data Block data
+     */
+    void bindInlineUniformData(
+            VkShaderStageFlags    stages,
+            uint32_t              slot,
+            uint32_t              size,
+      const void*                 data);
     
     /**
      * \brief Binds a shader to a given state
@@ -327,6 +362,22 @@ namespace dxvk {
             VkDeviceSize          length,
             VkClearColorValue     value);
     
+    /**
+     * \brief Clears multiple ranges of a buffer view
+     * 
+     * Equivalent to calling \c clearBufferView for each
+     * range, but only binds the clear pipeline once.
+     * \param [in] bufferView The buffer view
+     * \param [in] rangeCount Number of ranges to clear
+     * \param [in] ranges Ranges to clear, in elements
+     * \param [in] value The clear value
+     */
+    void clearBufferViewRanges(
+      const Rc<DxvkBufferView>&   bufferView,
+            uint32_t              rangeCount,
+      const DxvkClearRect*        ranges,
+            VkClearColorValue     value);
+    
     /**
      * \brief Clears an active render target
      * 
@@ -358,6 +409,26 @@ namespace dxvk {
             VkImageAspectFlags    aspect,
             VkClearValue          value);
     
+    /**
+     * \brief Clears multiple rects of an image view
+     * 
+     * Equivalent to calling \c clearImageView for each
+     * rect, but records all clears in one go, so that
+     * barriers and descriptor updates are only needed
+     * once per view rather than per rect.
+     * \param [in] imageView The image view
+     * \param [in] rectCount Number of rects to clear
+     * \param [in] rects Rects to clear
+     * \param [in] aspect Aspect mask to clear
+     * \param [in] value The clear value
+     */
+    void clearImageViewRects(
+      const Rc<DxvkImageView>&    imageView,
+            uint32_t              rectCount,
+      const DxvkClearRect*        rects,
+            VkImageAspectFlags    aspect,
+            VkClearValue          value);
+    
     /**
      * \brief Copies data from one buffer to another
      * 
@@ -557,6 +628,20 @@ namespace dxvk {
             VkExtent2D            srcExtent,
             VkFormat              format);
     
+    /**
+     * \brief Defragments device memory
+     *
+     * Moves some idle buffers out of sparsely used memory
+     * chunks, up to the per-frame limit set in the config.
+     * If device-local memory is over the eviction threshold,
+     * idle buffers are moved to system memory instead, and
+     * moved back once enough memory is available again.
+     * Should be called once per frame by the context that
+     * owns most resources, since relocating a buffer that is
+     * used by another context results in undefined behaviour.
+     */
+    void defragmentMemory();
+
     /**
      * \brief Discards a buffer
      * 
@@ -632,6 +717,24 @@ namespace dxvk {
             uint32_t          count,
             uint32_t          stride);
     
+    /**
+     * \brief Draws multiple primitive ranges
+     * 
+     * Equivalent to a sequence of \ref draw calls
+     * with the same instance parameters, but only commits
+     * graphics state once. Uses \c VK_EXT_multi_draw if
+     * supported by the device.
+     * \param [in] drawCount Number of draws
+     * \param [in] draws Vertex ranges
+     * \param [in] instanceCount Number of instances to render
+     * \param [in] firstInstance First instance ID
+     */
+    void drawMulti(
+            uint32_t          drawCount,
+      const VkMultiDrawInfoEXT* draws,
+            uint32_t          instanceCount,
+            uint32_t          firstInstance);
+    
     /**
      * \brief Indirect draw call
      * 
@@ -664,6 +767,24 @@ namespace dxvk {
             uint32_t vertexOffset,
             uint32_t firstInstance);
     
+    /**
+     * \brief Draws multiple indexed primitive ranges
+     * 
+     * Equivalent to a sequence of \ref drawIndexed calls
+     * with the same instance parameters, but only commits
+     * graphics state once. Uses \c VK_EXT_multi_draw if
+     * supported by the device.
+     * \param [in] drawCount Number of draws
+     * \param [in] draws Index ranges and vertex offsets
+     * \param [in] instanceCount Number of instances to render
+     * \param [in] firstInstance First instance ID
+     */
+    void drawIndexedMulti(
+            uint32_t          drawCount,
+      const VkMultiDrawIndexedInfoEXT* draws,
+            uint32_t          instanceCount,
+            uint32_t          firstInstance);
+    
     /**
      * \brief Indirect indexed draw call
      * 
@@ -731,6 +852,7 @@ namespace dxvk {
      *
      * Clears the given buffer to zero. Only safe to call
      * if the buffer is not currently in use by the GPU.
+     * The clear is executed on the transfer queue.
      * \param [in] buffer Buffer to clear
      */
     void initBuffer(
@@ -741,6 +863,8 @@ namespace dxvk {
      * 
      * Transitions the image into its default layout, and clears
      * it to black unless the initial layout is preinitialized.
+     * For render targets, the clear is deferred until the image
+     * is first used by any context, see \ref DxvkImage::hasPendingInit.
      * Only safe to call if the image is not in use by the GPU.
      * \param [in] image The image to initialize
      * \param [in] subresources Image subresources
@@ -767,6 +891,24 @@ namespace dxvk {
     void invalidateBuffer(
       const Rc<DxvkBuffer>&           buffer,
       const DxvkBufferSliceHandle&    slice);
+
+    /**
+     * \brief Invalidates an image's contents
+     * 
+     * Discards an image's contents by replacing its backing
+     * storage with that of another image with identical
+     * properties, whose memory the host may already have
+     * written to. The previous storage is kept alive until
+     * the GPU is done with it.
+     * 
+     * \warning If the image is used by another context,
+     * invalidating it will result in undefined behaviour.
+     * \param [in] image The image to invalidate
+     * \param [in] storage Image providing the new storage
+     */
+    void invalidateImage(
+      const Rc<DxvkImage>&            image,
+      const Rc<DxvkImage>&            storage);
     
     /**
      * \brief Updates push constants
@@ -879,6 +1021,19 @@ namespace dxvk {
       const Rc<DxvkBuffer>&           buffer,
       const void*                     data);
     
+    /**
+     * \brief Uses transfer queue to initialize buffer
+     * 
+     * Copies data from a host-visible buffer that was already
+     * filled by the caller, e.g. a shared staging buffer. Only
+     * safe to use if the buffer is not in use by the GPU.
+     * \param [in] buffer The buffer to initialize
+     * \param [in] source Source buffer slice
+     */
+    void uploadBuffer(
+      const Rc<DxvkBuffer>&           buffer,
+      const DxvkBufferSlice&          source);
+    
     /**
      * \brief Uses transfer queue to initialize image
      * 
@@ -1075,6 +1230,30 @@ namespace dxvk {
     void signal(
       const Rc<sync::Signal>&   signal,
             uint64_t            value);
+
+    /**
+     * \brief Signals a fence
+     *
+     * The fence is signaled when the current command list
+     * completes, so this should be followed by a flush.
+     * \param [in] fence The fence
+     * \param [in] value Value to signal
+     */
+    void signalFence(
+      const Rc<DxvkFence>&      fence,
+            uint64_t            value);
+
+    /**
+     * \brief Waits for a fence
+     *
+     * All commands in the current command list will wait
+     * for the fence, so this should be preceded by a flush.
+     * \param [in] fence The fence
+     * \param [in] value Value to wait for
+     */
+    void waitFence(
+      const Rc<DxvkFence>&      fence,
+            uint64_t            value);
     
     /**
      * \brief Begins a debug label region
@@ -1123,6 +1302,7 @@ namespace dxvk {
     
     Rc<DxvkCommandList>     m_cmd;
     Rc<DxvkBuffer>          m_zeroBuffer;
+    Rc<DxvkBuffer>          m_mipGenCounters;
 
     DxvkContextFlags        m_flags;
     DxvkContextState        m_state;
@@ -1152,10 +1332,20 @@ namespace dxvk {
 
     std::vector<DxvkDeferredClear> m_deferredClears;
 
+    DxvkGpuProfiler*                  m_profiler = nullptr;
+    DxvkGpuProfilerScope              m_profilerPass;
+    std::vector<DxvkGpuProfilerScope> m_profilerLabels;
+    std::vector<DxvkCpuProfilerScope> m_profilerCpuLabels;
+
     std::array<VkWriteDescriptorSet, MaxNumActiveBindings> m_descriptorWrites;
     std::array<DxvkDescriptorInfo,   MaxNumActiveBindings> m_descriptors;
 
     std::array<DxvkShaderResourceSlot, MaxNumResourceSlots>  m_rc;
+
+    std::array<DxvkInlineUniformBlock, MaxNumInlineUniformBlocks> m_inlineBlocks;
+    std::array<VkWriteDescriptorSetInlineUniformBlockEXT, MaxNumActiveBindings> m_inlineWrites;
+    uint32_t                                                 m_inlineVersion = 0;
+
     std::array<DxvkGraphicsPipeline*, 4096> m_gpLookupCache = { };
     std::array<DxvkComputePipeline*,   256> m_cpLookupCache = { };
 
@@ -1196,15 +1386,22 @@ namespace dxvk {
 
     void clearImageViewFb(
       const Rc<DxvkImageView>&    imageView,
-            VkOffset3D            offset,
-            VkExtent3D            extent,
+            uint32_t              rectCount,
+      const DxvkClearRect*        rects,
             VkImageAspectFlags    aspect,
             VkClearValue          value);
     
+    void generateMipmapsCs(
+      const Rc<DxvkImageView>&    imageView);
+
+    void generateMipmapsFb(
+      const Rc<DxvkImageView>&    imageView,
+            VkFilter              filter);
+
     void clearImageViewCs(
       const Rc<DxvkImageView>&    imageView,
-            VkOffset3D            offset,
-            VkExtent3D            extent,
+            uint32_t              rectCount,
+      const DxvkClearRect*        rects,
             VkClearValue          value);
     
     void copyImageHw(
@@ -1255,6 +1452,13 @@ namespace dxvk {
             VkResolveModeFlagBitsKHR  depthMode,
             VkResolveModeFlagBitsKHR  stencilMode);
     
+    void resolveImageCs(
+      const Rc<DxvkImage>&            dstImage,
+      const Rc<DxvkImage>&            srcImage,
+      const VkImageResolve&           region,
+            VkFormat                  format,
+            VkResolveModeFlagBitsKHR  mode);
+
     void resolveImageFb(
       const Rc<DxvkImage>&            dstImage,
       const Rc<DxvkImage>&            srcImage,
@@ -1263,6 +1467,25 @@ namespace dxvk {
             VkResolveModeFlagBitsKHR  depthMode,
             VkResolveModeFlagBitsKHR  stencilMode);
     
+    void performImageInit(
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceRange&  subresources,
+            VkImageLayout             initialLayout);
+
+    bool canDeferImageInit(
+      const Rc<DxvkImage>&            image,
+      const VkImageSubresourceRange&  subresources) const;
+
+    void initPendingImage(
+      const Rc<DxvkImage>&            image);
+
+    void deferPendingInit(
+      const Rc<DxvkImageView>&        imageView);
+
+    void discardPendingInit(
+      const Rc<DxvkImageView>&        imageView,
+            VkImageAspectFlags        aspects);
+
     void performClear(
       const Rc<DxvkImageView>&        imageView,
             int32_t                   attachmentIndex,
@@ -1282,9 +1505,21 @@ namespace dxvk {
     void flushClears(
             bool                      useRenderPass);
 
+    void flushBoundResourceClears();
+
+    DxvkGpuProfilerScope beginProfilerScope(
+            std::string               name,
+            DxvkGpuProfilerTrack      track);
+
+    void endProfilerScope(
+            DxvkGpuProfilerScope&&    scope);
+
     void flushSharedImages();
 
     void startRenderPass();
+    void prepareStorageImage(
+      const Rc<DxvkImage>&        image);
+
     void spillRenderPass(bool suspend);
     
     void renderPassEmitInitBarriers(
@@ -1295,6 +1530,13 @@ namespace dxvk {
       const DxvkFramebufferInfo&  framebufferInfo,
       const DxvkRenderPassOps&    ops);
 
+    void inferDepthStoreOp(
+      const DxvkFramebufferInfo&  framebufferInfo,
+            DxvkRenderPassOps&    ops);
+
+    void trackDepthRead(
+      const Rc<DxvkImage>&        image);
+
     void renderPassBindFramebuffer(
       const DxvkFramebufferInfo&  framebufferInfo,
       const DxvkRenderPassOps&    ops);
@@ -1316,12 +1558,20 @@ namespace dxvk {
     bool updateGraphicsPipeline();
     bool updateGraphicsPipelineState(DxvkGlobalPipelineBarrier srcBarrier);
     
+    void updatePipelineDynamicState(
+            DxvkGraphicsPipelineType    pipelineType);
+
+    void updateVertexInputState();
+
     void invalidateState();
 
     template<VkPipelineBindPoint BindPoint>
     void updateResourceBindings(const DxvkBindingLayoutObjects* layout);
 
     void updateComputeShaderResources();
+
+    const DxvkInlineUniformBlock* lookupInlineUniformBlock(
+            uint32_t              slot) const;
     void updateGraphicsShaderResources();
 
     DxvkFramebufferInfo makeFramebufferInfo(
@@ -1404,12 +1654,26 @@ namespace dxvk {
       const Rc<DxvkBuffer>&           buffer,
             VkDeviceSize              copySize);
 
+    bool tryHoistBufferTransfer(
+      const Rc<DxvkBuffer>&           dstBuffer,
+      const Rc<DxvkBuffer>&           srcBuffer);
+
+    void relocateBuffer(
+      const Rc<DxvkBuffer>&           buffer,
+            DxvkBufferRelocation      mode);
+
+    void updateBufferBindings(
+      const Rc<DxvkBuffer>&           buffer);
+
     DxvkGraphicsPipeline* lookupGraphicsPipeline(
       const DxvkGraphicsPipelineShaders&  shaders);
 
     DxvkComputePipeline* lookupComputePipeline(
       const DxvkComputePipelineShaders&   shaders);
     
+    Rc<DxvkBuffer> createMipGenCounterBuffer(
+            uint32_t                  layerCount);
+
     Rc<DxvkBuffer> createZeroBuffer(
             VkDeviceSize              size);
 
@@ -39,6 +39,9 @@ namespace dxvk {
     GpDynamicDepthBias,         ///< Depth bias is dynamic
     GpDynamicDepthBounds,       ///< Depth bounds are dynamic
     GpDynamicStencilRef,        ///< Stencil reference is dynamic
+    GpIndependentSets,          ///< Graphics pipeline layout was created with independent sets
+    GpBarriersRecorded,         ///< Accesses of the current draw state are recorded
+    GpBarriersClean,            ///< Current draw state cannot introduce new hazards
     
     CpDirtyPipeline,            ///< Compute pipeline binding are out of date
     CpDirtyPipelineState,       ///< Compute pipeline needs to be recompiled
@@ -54,6 +57,9 @@ namespace dxvk {
    * \brief Context feature bits
    */
   enum class DxvkContextFeature {
+    ExtendedDynamicState2,        ///< Depth bias enable and primitive restart are dynamic
+    ExtendedDynamicState2LogicOp, ///< Logic op is dynamic
+    VertexInputDynamicState,      ///< Vertex input state is dynamic
     FeatureCount
   };
 
@@ -65,6 +71,12 @@ namespace dxvk {
    * 
    * These flags specify what (not) to
    * synchronize implicitly.
+   *
+   * Hazards are tracked per bound buffer range and image
+   * subresource range, so accesses to disjoint views of
+   * the same resource never require a barrier. Ignoring
+   * write-after-write hazards is only useful if shaders
+   * write disjoint regions within the same bound view.
    */
   enum class DxvkBarrierControl : uint32_t {
     IgnoreWriteAfterWrite       = 1,
@@ -2,13 +2,18 @@
 
 namespace dxvk {
   
-  DxvkCsChunk::DxvkCsChunk() {
+  DxvkCsChunk::DxvkCsChunk(uint32_t sizeClass)
+  : m_sizeClass (sizeClass),
+    m_capacity  (getBlockSize(sizeClass)),
+    m_data      (static_cast<char*>(::operator new(m_capacity, std::align_val_t(64)))) {
     
   }
   
   
   DxvkCsChunk::~DxvkCsChunk() {
     this->reset();
+
+    ::operator delete(m_data, std::align_val_t(64));
   }
   
   
@@ -17,6 +22,39 @@ namespace dxvk {
   }
 
 
+  uint32_t DxvkCsChunk::optimize() {
+    if (m_optimized)
+      return 0;
+
+    std::array<DxvkCsCmd*, MaxStateKeys> pending;
+    uint32_t pendingMask = 0;
+    uint32_t count = 0;
+
+    for (auto cmd = m_head; cmd != nullptr; cmd = cmd->next()) {
+      uint32_t key = cmd->stateKey();
+
+      // Any other command may observe the current state
+      if (!key) {
+        pendingMask = 0;
+        continue;
+      }
+
+      uint32_t bit = 1u << (key - 1);
+
+      if (pendingMask & bit) {
+        pending[key - 1]->markRedundant();
+        count += 1;
+      }
+
+      pending[key - 1] = cmd;
+      pendingMask |= bit;
+    }
+
+    m_optimized = true;
+    return count;
+  }
+
+
   void DxvkCsChunk::executeAll(DxvkContext* ctx) {
     auto cmd = m_head;
     
@@ -54,34 +92,55 @@ namespace dxvk {
     m_tail = nullptr;
 
     m_commandOffset = 0;
+    m_optimized = false;
   }
   
   
-  DxvkCsChunkPool::DxvkCsChunkPool() {
+  DxvkCsChunkPool::DxvkCsChunkPool(const Rc<DxvkDevice>& device)
+  : m_device(device) {
     
   }
   
   
   DxvkCsChunkPool::~DxvkCsChunkPool() {
-    for (DxvkCsChunk* chunk : m_chunks)
-      delete chunk;
+    for (const auto& list : m_chunks) {
+      for (DxvkCsChunk* chunk : list)
+        delete chunk;
+    }
   }
   
   
-  DxvkCsChunk* DxvkCsChunkPool::allocChunk(DxvkCsChunkFlags flags) {
+  DxvkCsChunk* DxvkCsChunkPool::allocChunk(
+          DxvkCsChunkFlags  flags,
+          uint32_t          sizeClass) {
     DxvkCsChunk* chunk = nullptr;
+    size_t peakDelta = 0;
 
     { std::lock_guard<dxvk::mutex> lock(m_mutex);
-      
-      if (m_chunks.size() != 0) {
-        chunk = m_chunks.back();
-        m_chunks.pop_back();
+      auto& list = m_chunks[sizeClass];
+
+      if (list.size() != 0) {
+        chunk = list.back();
+        list.pop_back();
+      }
+
+      m_liveBytes += DxvkCsChunk::getBlockSize(sizeClass);
+
+      if (m_liveBytes > m_peakBytes) {
+        peakDelta = m_liveBytes - m_peakBytes;
+        m_peakBytes = m_liveBytes;
       }
     }
     
     if (!chunk)
-      chunk = new DxvkCsChunk();
+      chunk = new DxvkCsChunk(sizeClass);
     
+    m_device->addStatCtr(DxvkStatCounter::CsChunkLiveCount, 1);
+    m_device->addStatCtr(DxvkStatCounter::CsChunkLiveBytes, chunk->capacity());
+
+    if (peakDelta)
+      m_device->addStatCtr(DxvkStatCounter::CsChunkPeakBytes, peakDelta);
+
     chunk->init(flags);
     return chunk;
   }
@@ -89,9 +148,51 @@ namespace dxvk {
   
   void DxvkCsChunkPool::freeChunk(DxvkCsChunk* chunk) {
     chunk->reset();
-    
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-    m_chunks.push_back(chunk);
+
+    // Counters are unsigned, so subtracting relies on wrap-around
+    m_device->addStatCtr(DxvkStatCounter::CsChunkLiveCount, -uint64_t(1));
+    m_device->addStatCtr(DxvkStatCounter::CsChunkLiveBytes, -uint64_t(chunk->capacity()));
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      auto& list = m_chunks[chunk->sizeClass()];
+
+      m_liveBytes -= chunk->capacity();
+
+      // Don't hold on to large chunks indefinitely in case the
+      // context that used them switched to a smaller size class
+      if (!chunk->sizeClass() || list.size() < MaxFreeLargeChunks) {
+        list.push_back(chunk);
+        chunk = nullptr;
+      }
+    }
+
+    delete chunk;
+  }
+
+
+  void DxvkCsChunkSizer::notifyChunk(const DxvkCsChunkRef& chunk) {
+    size_t usedSize = chunk->usedSize();
+    size_t capacity = chunk->capacity();
+
+    if (usedSize + capacity / 8 >= capacity)
+      m_fullCount += 1;
+
+    m_maxUsedSize = std::max(m_maxUsedSize, usedSize);
+
+    if (++m_chunkCount < WindowSize)
+      return;
+
+    if (m_fullCount * 4 >= WindowSize * 3) {
+      if (m_sizeClass + 1 < DxvkCsChunk::SizeClassCount)
+        m_sizeClass += 1;
+    } else if (m_sizeClass) {
+      if (m_maxUsedSize <= DxvkCsChunk::getBlockSize(m_sizeClass - 1) / 2)
+        m_sizeClass -= 1;
+    }
+
+    m_chunkCount  = 0;
+    m_fullCount   = 0;
+    m_maxUsedSize = 0;
   }
   
   
@@ -100,44 +201,76 @@ namespace dxvk {
     const Rc<DxvkContext>&  context)
   : m_device(device), m_context(context),
     m_thread([this] { threadFunc(); }) {
-    
+    m_thread.set_affinity(device->config().csThreadAffinity);
   }
   
   
   DxvkCsThread::~DxvkCsThread() {
+    m_stopped.store(true);
+
     { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      m_stopped.store(true);
+      m_condOnAdd.notify_one();
     }
-    
-    m_condOnAdd.notify_one();
+
     m_thread.join();
   }
   
   
   uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    uint64_t seq;
+    uint64_t seq = m_chunksDispatched.load(std::memory_order_relaxed) + 1;
 
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      seq = ++m_chunksDispatched;
-      m_chunksQueued.push(std::move(chunk));
-    }
-    
-    m_condOnAdd.notify_one();
+    // Wait for the slot to be freed by the consumer. A chunk is
+    // taken out of the queue before it starts executing, so any
+    // slot of a chunk that has been executed can be reused.
+    if (seq > QueueSize)
+      synchronize(seq - QueueSize);
+
+    m_chunksQueued[(seq - 1) % QueueSize] = std::move(chunk);
+    m_chunksDispatched.store(seq);
+
+    notify(m_consumerWaiting, m_condOnAdd);
     return seq;
   }
   
   
+  uint64_t DxvkCsThread::dispatchChunks(
+    const DxvkCsChunkRef*         chunks,
+          size_t                  count) {
+    uint64_t seq = m_chunksDispatched.load(std::memory_order_relaxed);
+
+    while (count) {
+      // Wait until at least one slot is free, then fill
+      // as many slots as possible before publishing them
+      if (seq + 1 > QueueSize)
+        synchronize(seq + 1 - QueueSize);
+
+      uint64_t free = QueueSize - (seq - m_chunksExecuted.load(std::memory_order_acquire));
+      uint64_t batch = std::min<uint64_t>(free, count);
+
+      for (uint64_t i = 0; i < batch; i++)
+        m_chunksQueued[(seq + i) % QueueSize] = chunks[i];
+
+      seq    += batch;
+      chunks += batch;
+      count  -= batch;
+
+      m_chunksDispatched.store(seq);
+      notify(m_consumerWaiting, m_condOnAdd);
+    }
+
+    return seq;
+  }
+
+
   void DxvkCsThread::synchronize(uint64_t seq) {
     // Avoid locking if we know the sync is a no-op, may
     // reduce overhead if this is being called frequently
     if (seq > m_chunksExecuted.load(std::memory_order_acquire)) {
-      std::unique_lock<dxvk::mutex> lock(m_mutex);
-
       if (seq == SynchronizeAll)
         seq = m_chunksDispatched.load();
 
       auto t0 = dxvk::high_resolution_clock::now();
-      m_condOnSync.wait(lock, [this, seq] {
+      waitFor(m_producerWaiting, m_condOnSync, [this, seq] {
         return m_chunksExecuted.load() >= seq;
       });
       auto t1 = dxvk::high_resolution_clock::now();
@@ -152,40 +285,80 @@ namespace dxvk {
   void DxvkCsThread::threadFunc() {
     env::setThreadName("dxvk-cs");
 
-    DxvkCsChunkRef chunk;
+    uint64_t chunksRead = 0;
 
     try {
-      while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
-          if (chunk) {
-            m_chunksExecuted++;
-            m_condOnSync.notify_one();
-            
-            chunk = DxvkCsChunkRef();
-          }
-          
-          if (m_chunksQueued.size() == 0) {
-            m_condOnAdd.wait(lock, [this] {
-              return (m_chunksQueued.size() != 0)
-                  || (m_stopped.load());
-            });
-          }
-          
-          if (m_chunksQueued.size() != 0) {
-            chunk = std::move(m_chunksQueued.front());
-            m_chunksQueued.pop();
-          }
+      while (true) {
+        waitFor(m_consumerWaiting, m_condOnAdd, [this, chunksRead] {
+          return (m_chunksDispatched.load() > chunksRead)
+              || (m_stopped.load());
+        });
+
+        if (m_stopped.load())
+          break;
+
+        DxvkCsChunkRef chunk = std::move(m_chunksQueued[chunksRead % QueueSize]);
+        chunksRead += 1;
+
+        m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
+
+        if (m_device->config().elideRedundantState) {
+          uint32_t redundant = chunk->optimize();
+
+          if (redundant)
+            m_context->addStatCtr(DxvkStatCounter::CsCmdRedundantCount, redundant);
         }
-        
-        if (chunk) {
-          m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
+
+        { DXVK_TRACE_SCOPE("DxvkCsThread::executeChunk");
           chunk->executeAll(m_context.ptr());
         }
+
+        // Release the chunk before signaling the producer so that
+        // resources are no longer referenced after a synchronization
+        chunk = DxvkCsChunkRef();
+
+        m_chunksExecuted.store(chunksRead);
+        notify(m_producerWaiting, m_condOnSync);
       }
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
       Logger::err(e.message());
     }
   }
+
+
+  template<typename Pred>
+  void DxvkCsThread::waitFor(
+          std::atomic<bool>&        waiting,
+          dxvk::condition_variable& cond,
+    const Pred&                     pred) {
+    // Spin for a short while first, since most waits only
+    // last for a few microseconds and sleeping is expensive
+    for (uint32_t i = 0; i < SpinCount; i++) {
+      if (pred())
+        return;
+
+      _mm_pause();
+    }
+
+    // The flag must be set before checking the predicate under
+    // the lock, so that the other thread either sees the flag or
+    // we see the updated state. All accesses are sequentially
+    // consistent for this to work.
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+    waiting.store(true);
+    cond.wait(lock, pred);
+    waiting.store(false);
+  }
+
+
+  void DxvkCsThread::notify(
+          std::atomic<bool>&        waiting,
+          dxvk::condition_variable& cond) {
+    if (waiting.load()) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      cond.notify_one();
+    }
+  }
   
-}
\ No newline at end of file
+}
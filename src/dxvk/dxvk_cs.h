@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
+#include <new>
+#include <vector>
 
 #include "../util/thread.h"
 
@@ -48,6 +50,26 @@ namespace dxvk {
      * \param [in] ctx The target context
      */
     virtual void exec(DxvkContext* ctx) const = 0;
+
+    /**
+     * \brief Queries state key
+     *
+     * Only state commands have a non-zero key,
+     * see \ref DxvkCsStateCmd for details.
+     * \returns State key, or 0 for other commands
+     */
+    virtual uint32_t stateKey() const {
+      return 0;
+    }
+
+    /**
+     * \brief Marks the command as redundant
+     *
+     * Redundant state commands are skipped when
+     * the chunk gets executed. Does nothing for
+     * other commands.
+     */
+    virtual void markRedundant() { }
     
   private:
     
@@ -84,6 +106,50 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief State command
+   *
+   * Typed command that does nothing but overwrite a
+   * piece of context state, identified by a non-zero
+   * key chosen by the frontend. If another command
+   * with the same key follows before any command that
+   * is not a state command, nothing can observe the
+   * state set by this command, so it can be skipped.
+   */
+  template<typename T>
+  class alignas(16) DxvkCsStateCmd : public DxvkCsCmd {
+
+  public:
+
+    DxvkCsStateCmd(T&& cmd, uint32_t key)
+    : m_command (std::move(cmd)),
+      m_key     (key) { }
+
+    DxvkCsStateCmd             (DxvkCsStateCmd&&) = delete;
+    DxvkCsStateCmd& operator = (DxvkCsStateCmd&&) = delete;
+
+    void exec(DxvkContext* ctx) const {
+      if (likely(!m_redundant))
+        m_command(ctx);
+    }
+
+    uint32_t stateKey() const {
+      return m_key;
+    }
+
+    void markRedundant() {
+      m_redundant = true;
+    }
+
+  private:
+
+    T         m_command;
+    uint32_t  m_key;
+    bool      m_redundant = false;
+
+  };
+
+
   /**
    * \brief Typed command with metadata
    * 
@@ -118,6 +184,42 @@ namespace dxvk {
     M m_data;
 
   };
+
+
+  /**
+   * \brief Typed command with inline payload
+   *
+   * Stores a function object followed by a variable-size
+   * block of raw data within the same chunk, so that the
+   * payload is recycled together with the chunk rather
+   * than requiring a separate allocation.
+   */
+  template<typename T>
+  class alignas(16) DxvkCsPayloadCmd : public DxvkCsCmd {
+
+  public:
+
+    DxvkCsPayloadCmd(T&& cmd, size_t size)
+    : m_command (std::move(cmd)),
+      m_size    (size) { }
+
+    DxvkCsPayloadCmd             (DxvkCsPayloadCmd&&) = delete;
+    DxvkCsPayloadCmd& operator = (DxvkCsPayloadCmd&&) = delete;
+
+    void exec(DxvkContext* ctx) const {
+      m_command(ctx, payload(), m_size);
+    }
+
+    void* payload() const {
+      return const_cast<char*>(reinterpret_cast<const char*>(this)) + sizeof(*this);
+    }
+
+  private:
+
+    T      m_command;
+    size_t m_size;
+
+  };
   
   
   /**
@@ -135,15 +237,69 @@ namespace dxvk {
   /**
    * \brief Command chunk
    * 
-   * Stores a list of commands.
+   * Stores a list of commands. Chunks come in
+   * a few different size classes so that the
+   * frontend can trade memory usage against
+   * the number of chunks to submit.
    */
   class DxvkCsChunk : public RcObject {
-    constexpr static size_t MaxBlockSize = 16384;
   public:
+
+    /// Number of supported chunk size classes
+    constexpr static uint32_t SizeClassCount = 3;
+
+    /// Size of the smallest size class. Any single
+    /// command must fit into a chunk of this size.
+    constexpr static size_t MinBlockSize = 16384;
+
+    /// Maximum size of inline command payloads. Larger
+    /// payloads must be allocated by the caller.
+    constexpr static size_t MaxPayloadSize = 4096;
+
+    /// Number of distinct state command keys. Valid
+    /// keys are in the range of 1 to this number.
+    constexpr static uint32_t MaxStateKeys = 32;
     
-    DxvkCsChunk();
+    DxvkCsChunk(uint32_t sizeClass);
     ~DxvkCsChunk();
+
+    DxvkCsChunk             (const DxvkCsChunk&) = delete;
+    DxvkCsChunk& operator = (const DxvkCsChunk&) = delete;
     
+    /**
+     * \brief Computes capacity of a size class
+     *
+     * \param [in] sizeClass Size class index
+     * \returns Chunk capacity, in bytes
+     */
+    static constexpr size_t getBlockSize(uint32_t sizeClass) {
+      return MinBlockSize << (2 * sizeClass);
+    }
+
+    /**
+     * \brief Size class of the chunk
+     * \returns Size class index
+     */
+    uint32_t sizeClass() const {
+      return m_sizeClass;
+    }
+
+    /**
+     * \brief Chunk capacity
+     * \returns Capacity, in bytes
+     */
+    size_t capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * \brief Number of bytes used by commands
+     * \returns Used size, in bytes
+     */
+    size_t usedSize() const {
+      return m_commandOffset;
+    }
+
     /**
      * \brief Checks whether the chunk is empty
      * \returns \c true if the chunk is empty
@@ -166,7 +322,7 @@ namespace dxvk {
     bool push(T& command) {
       using FuncType = DxvkCsTypedCmd<T>;
       
-      if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
+      if (unlikely(m_commandOffset > m_capacity - sizeof(FuncType)))
         return false;
       
       DxvkCsCmd* tail = m_tail;
@@ -183,6 +339,38 @@ namespace dxvk {
       return true;
     }
 
+    /**
+     * \brief Tries to add a state command to the chunk
+     *
+     * Behaves like \c push, but allows the command to
+     * be skipped if it is made redundant by a later
+     * command with the same key.
+     * \param [in] command The command to add
+     * \param [in] key State key, between 1 and
+     *    \ref MaxStateKeys.
+     * \returns \c true on success, \c false if
+     *          a new chunk needs to be allocated
+     */
+    template<typename T>
+    bool pushState(T& command, uint32_t key) {
+      using FuncType = DxvkCsStateCmd<T>;
+
+      if (unlikely(m_commandOffset > m_capacity - sizeof(FuncType)))
+        return false;
+
+      FuncType* func = new (m_data + m_commandOffset)
+        FuncType(std::move(command), key);
+
+      if (likely(m_tail != nullptr))
+        m_tail->setNext(func);
+      else
+        m_head = func;
+      m_tail = func;
+
+      m_commandOffset += sizeof(FuncType);
+      return true;
+    }
+
     /**
      * \brief Adds a command with data to the chunk 
      * 
@@ -194,7 +382,7 @@ namespace dxvk {
     M* pushCmd(T& command, Args&&... args) {
       using FuncType = DxvkCsDataCmd<T, M>;
       
-      if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
+      if (unlikely(m_commandOffset > m_capacity - sizeof(FuncType)))
         return nullptr;
       
       FuncType* func = new (m_data + m_commandOffset)
@@ -209,6 +397,39 @@ namespace dxvk {
       m_commandOffset += sizeof(FuncType);
       return func->data();
     }
+
+    /**
+     * \brief Adds a command with inline payload to the chunk
+     *
+     * The payload is stored directly after the command and
+     * remains valid for as long as the chunk is alive. The
+     * command is invoked with the payload pointer and size.
+     * \param [in] command The command to add
+     * \param [in] size Payload size, in bytes. Must not
+     *    be larger than \ref MaxPayloadSize.
+     * \returns Pointer to the payload, or \c nullptr
+     */
+    template<typename T>
+    void* pushCmdWithPayload(T& command, size_t size) {
+      using FuncType = DxvkCsPayloadCmd<T>;
+
+      size_t cmdSize = align(sizeof(FuncType) + size, alignof(FuncType));
+
+      if (unlikely(m_commandOffset > m_capacity - cmdSize))
+        return nullptr;
+
+      FuncType* func = new (m_data + m_commandOffset)
+        FuncType(std::move(command), size);
+
+      if (likely(m_tail != nullptr))
+        m_tail->setNext(func);
+      else
+        m_head = func;
+      m_tail = func;
+
+      m_commandOffset += cmdSize;
+      return func->payload();
+    }
     
     /**
      * \brief Initializes chunk for recording
@@ -216,6 +437,19 @@ namespace dxvk {
      */
     void init(DxvkCsChunkFlags flags);
     
+    /**
+     * \brief Marks redundant state commands
+     *
+     * Looks ahead through the entire chunk and marks state
+     * commands that get overwritten by a command with the
+     * same key before any other command gets executed. The
+     * result only depends on the chunk itself, so chunks
+     * that are executed multiple times are only scanned
+     * once.
+     * \returns Number of commands marked as redundant
+     */
+    uint32_t optimize();
+
     /**
      * \brief Executes all commands
      * 
@@ -242,9 +476,11 @@ namespace dxvk {
     DxvkCsCmd* m_tail = nullptr;
 
     DxvkCsChunkFlags m_flags;
-    
-    alignas(64)
-    char m_data[MaxBlockSize];
+    bool             m_optimized = false;
+
+    uint32_t m_sizeClass;
+    size_t   m_capacity;
+    char*    m_data;
     
   };
   
@@ -254,13 +490,16 @@ namespace dxvk {
    * 
    * Implements a pool of CS chunks which can be
    * recycled. The goal is to reduce the number
-   * of dynamic memory allocations.
+   * of dynamic memory allocations. Also reports
+   * the number of chunks and bytes currently
+   * handed out to the device's stat counters.
    */
   class DxvkCsChunkPool {
-    
+    /// Free chunks to keep around for larger size classes
+    constexpr static size_t MaxFreeLargeChunks = 16;
   public:
     
-    DxvkCsChunkPool();
+    DxvkCsChunkPool(const Rc<DxvkDevice>& device);
     ~DxvkCsChunkPool();
     
     DxvkCsChunkPool             (const DxvkCsChunkPool&) = delete;
@@ -272,9 +511,12 @@ namespace dxvk {
      * Takes an existing chunk from the pool,
      * or creates a new one if necessary.
      * \param [in] flags Chunk flags
+     * \param [in] sizeClass Chunk size class
      * \returns Allocated chunk object
      */
-    DxvkCsChunk* allocChunk(DxvkCsChunkFlags flags);
+    DxvkCsChunk* allocChunk(
+            DxvkCsChunkFlags  flags,
+            uint32_t          sizeClass = 0);
     
     /**
      * \brief Releases a chunk
@@ -286,8 +528,14 @@ namespace dxvk {
     
   private:
     
+    Rc<DxvkDevice>            m_device;
+
     dxvk::mutex               m_mutex;
-    std::vector<DxvkCsChunk*> m_chunks;
+    std::array<std::vector<DxvkCsChunk*>,
+      DxvkCsChunk::SizeClassCount> m_chunks;
+
+    size_t                    m_liveBytes = 0;
+    size_t                    m_peakBytes = 0;
     
   };
   
@@ -372,14 +620,60 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Chunk size heuristic
+   *
+   * Tracks how full the chunks emitted by a context
+   * are. If most chunks get submitted because they
+   * ran out of space, a larger size class is used
+   * to reduce the number of submissions. If no chunk
+   * would have filled up half of a smaller chunk,
+   * the size class is reduced to save memory.
+   */
+  class DxvkCsChunkSizer {
+    /// Number of chunks to look at before adjusting the size
+    constexpr static uint32_t WindowSize = 64;
+  public:
+
+    /**
+     * \brief Size class for new chunks
+     * \returns Size class index
+     */
+    uint32_t sizeClass() const {
+      return m_sizeClass;
+    }
+
+    /**
+     * \brief Records a chunk that is about to be emitted
+     * \param [in] chunk The chunk
+     */
+    void notifyChunk(const DxvkCsChunkRef& chunk);
+
+  private:
+
+    uint32_t  m_sizeClass   = 0;
+    uint32_t  m_chunkCount  = 0;
+    uint32_t  m_fullCount   = 0;
+    size_t    m_maxUsedSize = 0;
+
+  };
+
+
   /**
    * \brief Command stream thread
    * 
    * Spawns a thread that will execute
-   * commands on a DXVK context. 
+   * commands on a DXVK context. Chunks are passed
+   * to the thread through a single-producer,
+   * single-consumer ring buffer, so calls to
+   * \c dispatchChunk and \c synchronize must
+   * be externally synchronized.
    */
   class DxvkCsThread {
-    
+    /// Maximum number of chunks queued at any given time
+    constexpr static uint64_t QueueSize = 4096;
+    /// Number of probes before a waiting thread goes to sleep
+    constexpr static uint32_t SpinCount = 1024;
   public:
 
     constexpr static uint64_t SynchronizeAll = ~0ull;
@@ -394,10 +688,28 @@ namespace dxvk {
      * 
      * Can be used to efficiently play back large
      * command lists recorded on another thread.
+     * If the queue is full, this will wait for
+     * the thread to process pending chunks.
      * \param [in] chunk The chunk to dispatch
      * \returns Sequence number of the submission
      */
     uint64_t dispatchChunk(DxvkCsChunkRef&& chunk);
+
+    /**
+     * \brief Dispatches multiple chunks
+     *
+     * Equivalent to calling \c dispatchChunk for each
+     * chunk, but publishes all chunks that fit into the
+     * queue at once, so that the consumer only needs to
+     * be notified once per batch. The chunks themselves
+     * are not modified, so they can be dispatched again.
+     * \param [in] chunks Chunks to dispatch
+     * \param [in] count Number of chunks
+     * \returns Sequence number of the last submission
+     */
+    uint64_t dispatchChunks(
+      const DxvkCsChunkRef*         chunks,
+            size_t                  count);
     
     /**
      * \brief Synchronizes with the thread
@@ -425,17 +737,34 @@ namespace dxvk {
     Rc<DxvkDevice>              m_device;
     Rc<DxvkContext>             m_context;
 
+    alignas(CACHE_LINE_SIZE)
     std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    std::atomic<bool>           m_consumerWaiting  = { false };
+
+    alignas(CACHE_LINE_SIZE)
     std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
+    std::atomic<bool>           m_producerWaiting  = { false };
     
     std::atomic<bool>           m_stopped = { false };
     dxvk::mutex                 m_mutex;
     dxvk::condition_variable    m_condOnAdd;
     dxvk::condition_variable    m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
+
+    std::array<DxvkCsChunkRef, QueueSize> m_chunksQueued;
+
     dxvk::thread                m_thread;
     
     void threadFunc();
+
+    template<typename Pred>
+    void waitFor(
+            std::atomic<bool>&        waiting,
+            dxvk::condition_variable& cond,
+      const Pred&                     pred);
+
+    void notify(
+            std::atomic<bool>&        waiting,
+            dxvk::condition_variable& cond);
     
   };
   
@@ -0,0 +1,92 @@
+#include "dxvk_defrag.h"
+
+namespace dxvk {
+
+  DxvkMemoryDefragmenter::DxvkMemoryDefragmenter() {
+
+  }
+
+
+  DxvkMemoryDefragmenter::~DxvkMemoryDefragmenter() {
+
+  }
+
+
+  void DxvkMemoryDefragmenter::registerBuffer(
+          DxvkBuffer*           buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    buffer->m_defrag      = this;
+    buffer->m_defragIndex = m_buffers.size();
+
+    m_buffers.push_back({ buffer, m_tick });
+  }
+
+
+  std::vector<Rc<DxvkBuffer>> DxvkMemoryDefragmenter::pickBuffers(
+          VkDeviceSize          maxSize,
+          DxvkBufferRelocation  mode) {
+    std::vector<Rc<DxvkBuffer>> candidates;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_tick += 1;
+
+      uint32_t count = std::min<size_t>(m_buffers.size(), MaxScanCount);
+
+      for (uint32_t i = 0; i < count; i++) {
+        if (m_cursor >= m_buffers.size())
+          m_cursor = 0;
+
+        const Entry& entry = m_buffers[m_cursor++];
+
+        // Skip recently created buffers, those may still
+        // be initialized by a context other than ours
+        if (entry.tick + MinBufferAge > m_tick)
+          continue;
+
+        // The buffer may be in the process of being destroyed,
+        // in which case it will be unregistered shortly.
+        if (entry.buffer->tryIncRef()) {
+          candidates.emplace_back(entry.buffer);
+          entry.buffer->decRef();
+        }
+      }
+    }
+
+    // Filter candidates outside the lock since releasing the last
+    // reference to a buffer will call back into unregisterBuffer.
+    std::vector<Rc<DxvkBuffer>> result;
+    VkDeviceSize totalSize = 0;
+
+    for (auto& buffer : candidates) {
+      VkDeviceSize size = buffer->info().size;
+
+      if (totalSize + size > maxSize)
+        continue;
+
+      if (buffer->isInUse() || !buffer->isRelocatable(mode))
+        continue;
+
+      totalSize += size;
+      result.push_back(std::move(buffer));
+    }
+
+    return result;
+  }
+
+
+  void DxvkMemoryDefragmenter::unregisterBuffer(
+          DxvkBuffer*           buffer) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    size_t index = buffer->m_defragIndex;
+
+    if (index + 1 < m_buffers.size()) {
+      m_buffers[index] = m_buffers.back();
+      m_buffers[index].buffer->m_defragIndex = index;
+    }
+
+    m_buffers.pop_back();
+  }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "dxvk_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Memory defragmenter
+   *
+   * Keeps track of buffers whose backing storage can
+   * be moved to a different memory location, and picks
+   * idle buffers that live in sparsely used memory
+   * chunks so that the context can relocate them into
+   * more densely used chunks. Once all allocations have
+   * been moved out of a chunk, it can be freed. The same
+   * set of buffers is used to evict idle buffers to system
+   * memory when device-local heaps are over budget.
+   */
+  class DxvkMemoryDefragmenter {
+    friend class DxvkBuffer;
+
+    /// Number of registered buffers to look at per call
+    constexpr static uint32_t MaxScanCount = 256;
+    /// Minimum number of calls before a buffer can be moved
+    constexpr static uint64_t MinBufferAge = 16;
+  public:
+
+    DxvkMemoryDefragmenter();
+
+    ~DxvkMemoryDefragmenter();
+
+    /**
+     * \brief Registers a buffer
+     *
+     * Only buffers which return \c true for
+     * \c DxvkBuffer::canRelocateStorage should
+     * be registered. The buffer is unregistered
+     * automatically when it gets destroyed.
+     * \param [in] buffer The buffer
+     */
+    void registerBuffer(
+            DxvkBuffer*           buffer);
+
+    /**
+     * \brief Picks buffers to relocate
+     *
+     * Scans a subset of registered buffers in a round-robin
+     * fashion and returns idle buffers that are suitable
+     * for relocation, up to the given total size.
+     * \param [in] maxSize Maximum number of bytes to move
+     * \param [in] mode Relocation mode
+     * \returns Buffers to relocate
+     */
+    std::vector<Rc<DxvkBuffer>> pickBuffers(
+            VkDeviceSize          maxSize,
+            DxvkBufferRelocation  mode);
+
+  private:
+
+    struct Entry {
+      DxvkBuffer* buffer;
+      uint64_t    tick;
+    };
+
+    dxvk::mutex         m_mutex;
+    std::vector<Entry>  m_buffers;
+    uint32_t            m_cursor  = 0;
+    uint64_t            m_tick    = 0;
+
+    void unregisterBuffer(
+            DxvkBuffer*           buffer);
+
+  };
+
+}
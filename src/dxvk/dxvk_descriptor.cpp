@@ -21,9 +21,8 @@ namespace dxvk {
   }
 
 
-  void DxvkDescriptorSetList::addSet(VkDescriptorSet set) {
-    m_sets.push_back(set);
-    m_next = m_sets.size();
+  void DxvkDescriptorSetList::addSets(uint32_t count, const VkDescriptorSet* sets) {
+    m_sets.insert(m_sets.end(), sets, sets + count);
   }
 
 
@@ -102,6 +101,57 @@ namespace dxvk {
   }
 
 
+  bool DxvkDescriptorPool::allocCached(
+    const DxvkBindingLayoutObjects* layout,
+          uint32_t                  setIndex,
+          uint32_t                  descriptorCount,
+    const DxvkDescriptorInfo*       descriptors,
+          VkDescriptorSet&          set) {
+    VkDescriptorSetLayout setLayout = layout->getSetLayout(setIndex);
+    size_t hash = hashDescriptors(layout, setIndex, descriptorCount, descriptors);
+
+    // The descriptor info must match exactly since the set
+    // layout determines how each descriptor gets interpreted
+    auto range = m_setCache.equal_range(hash);
+
+    for (auto i = range.first; i != range.second; i++) {
+      const CachedSet& entry = i->second;
+
+      if (entry.layout == setLayout && entry.dataCount == descriptorCount
+       && eqDescriptors(layout, setIndex, descriptorCount,
+            &m_setCacheData[entry.dataIndex], descriptors)) {
+        m_setCacheHits += 1;
+
+        set = entry.set;
+        return false;
+      }
+    }
+
+    auto setMap = getSetMapCached(layout);
+    set = allocSet(setMap->sets[setIndex], setLayout);
+
+    m_setsUsed += 1;
+    m_setCacheMisses += 1;
+
+    CachedSet entry;
+    entry.layout    = setLayout;
+    entry.set       = set;
+    entry.dataIndex = m_setCacheData.size();
+    entry.dataCount = descriptorCount;
+
+    m_setCacheData.insert(m_setCacheData.end(),
+      descriptors, descriptors + descriptorCount);
+    m_setCache.insert({ hash, entry });
+    return true;
+  }
+
+
+  void DxvkDescriptorPool::clearSetCache() {
+    m_setCache.clear();
+    m_setCacheData.clear();
+  }
+
+
   void DxvkDescriptorPool::reset() {
     // As a heuristic to save memory, check how many descriptors
     // have actively been used in the past couple of submissions.
@@ -138,6 +188,8 @@ namespace dxvk {
     }
 
     m_cachedEntry = { nullptr, nullptr };
+
+    clearSetCache();
   }
 
 
@@ -147,7 +199,13 @@ namespace dxvk {
         uint64_t(int64_t(m_setsAllocated) - int64_t(m_prevSetsAllocated)));
     }
 
+    counters.addCtr(DxvkStatCounter::DescriptorCacheHits,   m_setCacheHits);
+    counters.addCtr(DxvkStatCounter::DescriptorCacheMisses, m_setCacheMisses);
+
     m_prevSetsAllocated = m_setsAllocated;
+
+    m_setCacheHits   = 0;
+    m_setCacheMisses = 0;
   }
 
 
@@ -164,18 +222,20 @@ namespace dxvk {
 
   DxvkDescriptorSetMap* DxvkDescriptorPool::getSetMap(
     const DxvkBindingLayoutObjects*           layout) {
-    auto pair = m_setMaps.find(layout->getPipelineLayout());
+    auto pair = m_setMaps.find(layout->getPipelineLayout(false));
     if (likely(pair != m_setMaps.end())) {
       return &pair->second;
     }
 
     auto iter = m_setMaps.emplace(
       std::piecewise_construct,
-      std::tuple(layout->getPipelineLayout()),
+      std::tuple(layout->getPipelineLayout(false)),
       std::tuple());
 
     for (uint32_t i = 0; i < DxvkDescriptorSets::SetCount; i++) {
-      iter.first->second.sets[i] = (layout->getSetMask() & (1u << i))
+      uint32_t setMask = layout->getSetMask() & ~layout->getPushSetMask();
+
+      iter.first->second.sets[i] = (setMask & (1u << i))
         ? getSetList(layout->getSetLayout(i))
         : nullptr;
     }
@@ -204,36 +264,69 @@ namespace dxvk {
     VkDescriptorSet set = list->alloc();
 
     if (unlikely(!set)) {
-      if (!m_descriptorPools.empty())
-        set = allocSetFromPool(m_descriptorPools.back(), layout);
+      // Allocate sets in batches to reduce the number of calls into
+      // the driver. Scale the batch size with the number of sets
+      // already allocated for this layout, so that rarely used
+      // layouts do not waste descriptor pool memory.
+      uint32_t count = uint32_t(std::clamp<size_t>(
+        list->size() / 4, 1, MaxSetBatchSize));
+
+      std::array<VkDescriptorSet, MaxSetBatchSize> sets;
+      bool success = false;
+
+      // The pool may not have enough space left for the whole batch,
+      // or may not be able to fit a full batch of large sets at all,
+      // so fall back to allocating a single set before giving up.
+      if (!m_descriptorPools.empty()) {
+        success = allocSetsFromPool(m_descriptorPools.back(), layout, count, sets.data());
+
+        if (!success && count > 1) {
+          count = 1;
+          success = allocSetsFromPool(m_descriptorPools.back(), layout, count, sets.data());
+        }
+      }
+
+      if (!success) {
+        VkDescriptorPool pool = addPool();
+        success = allocSetsFromPool(pool, layout, count, sets.data());
 
-      if (!set)
-        set = allocSetFromPool(addPool(), layout);
+        if (!success && count > 1) {
+          count = 1;
+          success = allocSetsFromPool(pool, layout, count, sets.data());
+        }
+      }
 
-      list->addSet(set);
-      m_setsAllocated += 1;
+      if (unlikely(!success))
+        throw DxvkError("DxvkDescriptorPool: Failed to allocate descriptor set");
+
+      list->addSets(count, sets.data());
+      m_setsAllocated += count;
+
+      set = list->alloc();
     }
 
     return set;
   }
 
 
-  VkDescriptorSet DxvkDescriptorPool::allocSetFromPool(
+  bool DxvkDescriptorPool::allocSetsFromPool(
           VkDescriptorPool                    pool,
-          VkDescriptorSetLayout               layout) {
+          VkDescriptorSetLayout               layout,
+          uint32_t                            count,
+          VkDescriptorSet*                    sets) {
     auto vk = m_device->vkd();
 
+    std::array<VkDescriptorSetLayout, MaxSetBatchSize> layouts;
+
+    for (uint32_t i = 0; i < count; i++)
+      layouts[i] = layout;
+
     VkDescriptorSetAllocateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
     info.descriptorPool = pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &layout;
-
-    VkDescriptorSet set = VK_NULL_HANDLE;
-    
-    if (vk->vkAllocateDescriptorSets(vk->device(), &info, &set) != VK_SUCCESS)
-      return VK_NULL_HANDLE;
+    info.descriptorSetCount = count;
+    info.pSetLayouts = layouts.data();
 
-    return set;
+    return vk->vkAllocateDescriptorSets(vk->device(), &info, sets) == VK_SUCCESS;
   }
 
 
@@ -243,12 +336,109 @@ namespace dxvk {
     return pool;
   }
 
+
+  size_t DxvkDescriptorPool::hashDescriptors(
+    const DxvkBindingLayoutObjects*           layout,
+          uint32_t                            setIndex,
+          uint32_t                            descriptorCount,
+    const DxvkDescriptorInfo*                 descriptors) {
+    const auto& bindings = layout->layout();
+
+    DxvkHashState hash;
+    hash.add(std::hash<VkDescriptorSetLayout>()(layout->getSetLayout(setIndex)));
+
+    // Only hash the members that are used by each descriptor
+    // type, since the remaining bytes of the union as well as
+    // struct padding may contain arbitrary data
+    for (uint32_t i = 0; i < descriptorCount; i++) {
+      const auto& info = descriptors[i];
+
+      switch (getDescriptorClass(bindings.getBinding(setIndex, i).descriptorType)) {
+        case DescriptorClass::Image:
+          hash.add(std::hash<VkSampler>()(info.image.sampler));
+          hash.add(std::hash<VkImageView>()(info.image.imageView));
+          hash.add(uint32_t(info.image.imageLayout));
+          break;
+
+        case DescriptorClass::Buffer:
+          hash.add(std::hash<VkBuffer>()(info.buffer.buffer));
+          hash.add(std::hash<VkDeviceSize>()(info.buffer.offset));
+          hash.add(std::hash<VkDeviceSize>()(info.buffer.range));
+          break;
+
+        case DescriptorClass::TexelBuffer:
+          hash.add(std::hash<VkBufferView>()(info.texelBuffer));
+          break;
+      }
+    }
+
+    return hash;
+  }
+
+
+  bool DxvkDescriptorPool::eqDescriptors(
+    const DxvkBindingLayoutObjects*           layout,
+          uint32_t                            setIndex,
+          uint32_t                            descriptorCount,
+    const DxvkDescriptorInfo*                 a,
+    const DxvkDescriptorInfo*                 b) {
+    const auto& bindings = layout->layout();
+
+    for (uint32_t i = 0; i < descriptorCount; i++) {
+      bool eq = false;
+
+      switch (getDescriptorClass(bindings.getBinding(setIndex, i).descriptorType)) {
+        case DescriptorClass::Image:
+          eq = a[i].image.sampler     == b[i].image.sampler
+            && a[i].image.imageView   == b[i].image.imageView
+            && a[i].image.imageLayout == b[i].image.imageLayout;
+          break;
+
+        case DescriptorClass::Buffer:
+          eq = a[i].buffer.buffer == b[i].buffer.buffer
+            && a[i].buffer.offset == b[i].buffer.offset
+            && a[i].buffer.range  == b[i].buffer.range;
+          break;
+
+        case DescriptorClass::TexelBuffer:
+          eq = a[i].texelBuffer == b[i].texelBuffer;
+          break;
+      }
+
+      if (!eq)
+        return false;
+    }
+
+    return true;
+  }
+
+
+  DxvkDescriptorPool::DescriptorClass DxvkDescriptorPool::getDescriptorClass(
+          VkDescriptorType                    type) {
+    switch (type) {
+      case VK_DESCRIPTOR_TYPE_SAMPLER:
+      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        return DescriptorClass::Image;
+
+      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        return DescriptorClass::TexelBuffer;
+
+      default:
+        // Inline uniform blocks store their version
+        // and size in the buffer info as well
+        return DescriptorClass::Buffer;
+    }
+  }
+
   
   DxvkDescriptorManager::DxvkDescriptorManager(
           DxvkDevice*                 device,
           DxvkContextType             contextType)
   : m_device(device), m_contextType(contextType) {
-
+    sync::setLockName(m_mutex, "DxvkDescriptorManager");
   }
 
 
@@ -295,22 +485,31 @@ namespace dxvk {
     uint32_t maxSets = m_contextType == DxvkContextType::Primary
       ? 8192 : 256;
 
-    std::array<VkDescriptorPoolSize, 8> pools = {{
+    // Inline uniform block pool sizes are in bytes. Blocks are usually
+    // small, so reserve enough space for one 128-byte block per set.
+    bool useInlineUniformBlocks = m_device->canUseInlineUniformBlocks();
+
+    std::array<VkDescriptorPoolSize, 10> pools = {{
       { VK_DESCRIPTOR_TYPE_SAMPLER,                maxSets * 2  },
       { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          maxSets * 2  },
       { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          maxSets / 64 },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         maxSets * 4  },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         maxSets * 1  },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, maxSets * 4  },
       { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         maxSets * 1  },
       { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   maxSets * 1  },
       { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   maxSets / 64 },
-      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * 1  } }};
-    
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * 1  },
+      { VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT, maxSets * 128 } }};
+
+    VkDescriptorPoolInlineUniformBlockCreateInfoEXT inlineInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_INLINE_UNIFORM_BLOCK_CREATE_INFO_EXT };
+    inlineInfo.maxInlineUniformBlockBindings = maxSets;
+
     VkDescriptorPoolCreateInfo info;
     info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    info.pNext         = nullptr;
+    info.pNext         = useInlineUniformBlocks ? &inlineInfo : nullptr;
     info.flags         = 0;
     info.maxSets       = maxSets;
-    info.poolSizeCount = pools.size();
+    info.poolSizeCount = pools.size() - (useInlineUniformBlocks ? 0 : 1);
     info.pPoolSizes    = pools.data();
     
     VkDescriptorPool pool = VK_NULL_HANDLE;
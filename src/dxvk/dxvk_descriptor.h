@@ -2,6 +2,7 @@
 
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 #include "dxvk_pipelayout.h"
 #include "dxvk_recycler.h"
@@ -47,7 +48,11 @@ namespace dxvk {
 
     VkDescriptorSet alloc();
 
-    void addSet(VkDescriptorSet set);
+    void addSets(uint32_t count, const VkDescriptorSet* sets);
+
+    size_t size() const {
+      return m_sets.size();
+    }
 
     void reset();
 
@@ -80,7 +85,8 @@ namespace dxvk {
    * to be updated.
    */
   class DxvkDescriptorPool : public RcObject {
-
+    /// Maximum number of sets to allocate at once
+    constexpr static uint32_t MaxSetBatchSize = 64;
   public:
 
     DxvkDescriptorPool(
@@ -119,6 +125,38 @@ namespace dxvk {
     VkDescriptorSet alloc(
             VkDescriptorSetLayout     layout);
 
+    /**
+     * \brief Looks up or allocates a descriptor set
+     *
+     * Returns a set that has previously been written with
+     * the exact same descriptors if one is available in the
+     * set cache. Otherwise, allocates a new set and adds it
+     * to the cache, in which case the caller must write the
+     * given descriptors to the set before using it.
+     * \param [in] layout Binding layout
+     * \param [in] setIndex Descriptor set index
+     * \param [in] descriptorCount Number of descriptors in the set
+     * \param [in] descriptors Resolved descriptor infos
+     * \param [out] set Descriptor set
+     * \returns \c true if the set needs to be written
+     */
+    bool allocCached(
+      const DxvkBindingLayoutObjects* layout,
+            uint32_t                  setIndex,
+            uint32_t                  descriptorCount,
+      const DxvkDescriptorInfo*       descriptors,
+            VkDescriptorSet&          set);
+
+    /**
+     * \brief Clears descriptor set cache
+     *
+     * Must be called whenever resources referenced by cached
+     * sets may get destroyed, i.e. when the command list that
+     * keeps those resources alive gets submitted. Sets remain
+     * allocated until the pool itself is reset.
+     */
+    void clearSetCache();
+
     /**
      * \brief Resets pool
      */
@@ -132,6 +170,19 @@ namespace dxvk {
 
   private:
 
+    enum class DescriptorClass : uint32_t {
+      Image,
+      Buffer,
+      TexelBuffer,
+    };
+
+    struct CachedSet {
+      VkDescriptorSetLayout layout;
+      VkDescriptorSet       set;
+      size_t                dataIndex;
+      uint32_t              dataCount;
+    };
+
     DxvkDevice*               m_device;
     DxvkDescriptorManager*    m_manager;
     DxvkContextType           m_contextType;
@@ -141,6 +192,9 @@ namespace dxvk {
     std::unordered_map<VkPipelineLayout,      DxvkDescriptorSetMap>   m_setMaps;
     std::pair<const DxvkBindingLayoutObjects*, DxvkDescriptorSetMap*> m_cachedEntry;
 
+    std::unordered_multimap<size_t, CachedSet>                        m_setCache;
+    std::vector<DxvkDescriptorInfo>                                   m_setCacheData;
+
     uint32_t m_setsAllocated  = 0;
     uint32_t m_setsUsed       = 0;
 
@@ -148,6 +202,9 @@ namespace dxvk {
 
     uint32_t m_lowUsageFrames = 0;
 
+    uint32_t m_setCacheHits   = 0;
+    uint32_t m_setCacheMisses = 0;
+
     DxvkDescriptorSetMap* getSetMapCached(
       const DxvkBindingLayoutObjects*           layout);
 
@@ -161,12 +218,30 @@ namespace dxvk {
             DxvkDescriptorSetList*    list,
             VkDescriptorSetLayout               layout);
 
-    VkDescriptorSet allocSetFromPool(
+    bool allocSetsFromPool(
             VkDescriptorPool                    pool,
-            VkDescriptorSetLayout               layout);
+            VkDescriptorSetLayout               layout,
+            uint32_t                            count,
+            VkDescriptorSet*                    sets);
 
     VkDescriptorPool addPool();
 
+    static size_t hashDescriptors(
+      const DxvkBindingLayoutObjects*           layout,
+            uint32_t                            setIndex,
+            uint32_t                            descriptorCount,
+      const DxvkDescriptorInfo*                 descriptors);
+
+    static bool eqDescriptors(
+      const DxvkBindingLayoutObjects*           layout,
+            uint32_t                            setIndex,
+            uint32_t                            descriptorCount,
+      const DxvkDescriptorInfo*                 a,
+      const DxvkDescriptorInfo*                 b);
+
+    static DescriptorClass getDescriptorClass(
+            VkDescriptorType                    type);
+
   };
   
   /*
@@ -1,3 +1,7 @@
+#ifndef _WIN32
+#include <time.h>
+#endif
+
 #include "dxvk_device.h"
 #include "dxvk_instance.h"
 
@@ -18,10 +22,22 @@ namespace dxvk {
     m_properties        (adapter->devicePropertiesExt()),
     m_perfHints         (getPerfHints()),
     m_objects           (this),
+    m_commandListPool   (this),
     m_submissionQueue   (this) {
     auto queueFamilies = m_adapter->findQueueFamilies();
     m_queues.graphics = getQueue(queueFamilies.graphics, 0);
     m_queues.transfer = getQueue(queueFamilies.transfer, 0);
+
+    m_cpuTimeDomain = getCpuTimeDomain();
+
+    if (hasCalibratedTimestamps())
+      calibrateTimestamps();
+
+    // Compile meta pipelines for common formats in the background
+    // so that the first copy or mip generation does not stall
+    m_objects.pipelineManager().compileTask([this] {
+      precompileMetaPipelines();
+    });
   }
   
   
@@ -41,6 +57,40 @@ namespace dxvk {
   }
 
 
+  bool DxvkDevice::canUseGraphicsPipelineLibrary() const {
+    if (!m_features.extGraphicsPipelineLibrary.graphicsPipelineLibrary
+     || m_options.enableGraphicsPipelineLibrary == Tristate::False)
+      return false;
+
+    // Linking pipelines must be cheap for this to be useful
+    return m_options.enableGraphicsPipelineLibrary == Tristate::True
+        || m_properties.extGraphicsPipelineLibrary.graphicsPipelineLibraryFastLinking;
+  }
+
+
+  bool DxvkDevice::canUseInlineUniformBlocks() const {
+    if (!m_features.extInlineUniformBlock.inlineUniformBlock)
+      return false;
+
+    const auto& limits = m_properties.extInlineUniformBlock;
+
+    return limits.maxInlineUniformBlockSize                    >= MaxInlineUniformBlockSize
+        && limits.maxPerStageDescriptorInlineUniformBlocks     >= MaxNumInlineUniformBlocks
+        && limits.maxDescriptorSetInlineUniformBlocks          >= MaxNumInlineUniformBlocks;
+  }
+
+
+  bool DxvkDevice::canUseSynchronization2() const {
+    return m_features.khrSynchronization2.synchronization2
+        && m_options.enableSynchronization2;
+  }
+
+
+  bool DxvkDevice::canUseBufferDeviceAddress() const {
+    return m_features.khrBufferDeviceAddress.bufferDeviceAddress;
+  }
+
+
   DxvkFramebufferSize DxvkDevice::getDefaultFramebufferSize() const {
     return DxvkFramebufferSize {
       m_properties.core.properties.limits.maxFramebufferWidth,
@@ -75,12 +125,7 @@ namespace dxvk {
   
   
   Rc<DxvkCommandList> DxvkDevice::createCommandList() {
-    Rc<DxvkCommandList> cmdList = m_recycledCommandLists.retrieveObject();
-    
-    if (cmdList == nullptr)
-      cmdList = new DxvkCommandList(this);
-    
-    return cmdList;
+    return m_commandListPool.allocCommandList();
   }
 
 
@@ -94,6 +139,15 @@ namespace dxvk {
   }
 
 
+  Rc<DxvkFence> DxvkDevice::createFence(
+    const DxvkFenceCreateInfo&  info) {
+    if (!m_features.khrTimelineSemaphore.timelineSemaphore)
+      throw DxvkError("DxvkDevice: Timeline semaphores not supported");
+
+    return new DxvkFence(this, info);
+  }
+
+
   Rc<DxvkGpuQuery> DxvkDevice::createGpuQuery(
           VkQueryType           type,
           VkQueryControlFlags   flags,
@@ -102,25 +156,63 @@ namespace dxvk {
   }
   
   
+  Rc<DxvkBuffer> DxvkDevice::allocStagingBuffer(
+          VkDeviceSize          size) {
+    return m_objects.stagingPool().alloc(size);
+  }
+
+
   Rc<DxvkBuffer> DxvkDevice::createBuffer(
     const DxvkBufferCreateInfo& createInfo,
           VkMemoryPropertyFlags memoryType) {
-    return new DxvkBuffer(this, createInfo, m_objects.memoryManager(), memoryType);
+    Rc<DxvkBuffer> buffer = m_objects.resourcePool().findBuffer(createInfo, memoryType);
+
+    if (buffer != nullptr)
+      return buffer;
+
+    buffer = new DxvkBuffer(this, createInfo,
+      m_objects.memoryManager(), m_objects.bufferRing(),
+      m_objects.bufferSuballocator(), memoryType);
+
+    bool isRelocatable = m_options.memoryDefragRate > 0
+                      || m_options.memoryEvictThreshold > 0;
+
+    if (isRelocatable && buffer->canRelocateStorage())
+      m_objects.defragmenter().registerBuffer(buffer.ptr());
+
+    return buffer;
+  }
+
+
+  void DxvkDevice::recycleBuffer(
+          Rc<DxvkBuffer>&&      buffer) {
+    m_objects.resourcePool().recycleBuffer(std::move(buffer));
   }
   
   
   Rc<DxvkBufferView> DxvkDevice::createBufferView(
     const Rc<DxvkBuffer>&           buffer,
     const DxvkBufferViewCreateInfo& createInfo) {
-    return new DxvkBufferView(m_vkd, buffer, createInfo);
+    return new DxvkBufferView(buffer, createInfo);
   }
   
   
   Rc<DxvkImage> DxvkDevice::createImage(
     const DxvkImageCreateInfo&  createInfo,
           VkMemoryPropertyFlags memoryType) {
+    Rc<DxvkImage> image = m_objects.resourcePool().findImage(createInfo, memoryType);
+
+    if (image != nullptr)
+      return image;
+
     return new DxvkImage(this, createInfo, m_objects.memoryManager(), memoryType);
   }
+
+
+  void DxvkDevice::recycleImage(
+          Rc<DxvkImage>&&       image) {
+    m_objects.resourcePool().recycleImage(std::move(image));
+  }
   
   
   Rc<DxvkImage> DxvkDevice::createImageFromVkImage(
@@ -138,30 +230,142 @@ namespace dxvk {
   
   Rc<DxvkSampler> DxvkDevice::createSampler(
     const DxvkSamplerCreateInfo&  createInfo) {
-    return new DxvkSampler(this, createInfo);
+    return m_objects.samplerPool().createSampler(createInfo);
+  }
+
+
+  DxvkSamplerStats DxvkDevice::getSamplerStats() {
+    return m_objects.samplerPool().getStats();
   }
   
   
+  high_resolution_clock::time_point DxvkDevice::convertGpuTimestamp(
+          uint64_t                  timestamp) {
+    DxvkTimestampCalibration calibration;
+
+    { std::lock_guard<sync::Spinlock> lock(m_calibrationLock);
+      calibration = m_calibration;
+    }
+
+    double period = double(m_properties.core.properties.limits.timestampPeriod);
+    double ns = double(int64_t(timestamp - calibration.gpuTimestamp)) * period;
+
+    return calibration.cpuTime + std::chrono::nanoseconds(int64_t(ns));
+  }
+
+
   DxvkStatCounters DxvkDevice::getStatCounters() {
     DxvkPipelineCount pipe = m_objects.pipelineManager().getPipelineCount();
+    DxvkMemoryCacheStats mem = m_objects.memoryManager().getCacheStats();
+    DxvkStagingStats staging = m_objects.stagingPool().getStats();
+    DxvkSamplerStats samplers = m_objects.samplerPool().getStats();
+    DxvkMappedMemoryStats mapped = m_objects.memoryManager().getMappedStats();
+    DxvkCommandListPoolStats cmdLists = m_commandListPool.getStats();
     
     DxvkStatCounters result;
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_objects.pipelineManager().isCompilingShaders());
+    result.setCtr(DxvkStatCounter::PipeCountPending,  pipe.numPendingPipelines);
+
+    for (uint32_t i = 0; i < DxvkPipelinePriorityCount; i++) {
+      result.setCtr(DxvkStatCounter(uint32_t(DxvkStatCounter::PipeQueueHigh)   + i), pipe.queues[i].numPending);
+      result.setCtr(DxvkStatCounter(uint32_t(DxvkStatCounter::PipeLatencyHigh) + i), pipe.queues[i].latency);
+    }
+
+    const std::array<DxvkStatCounter, DxvkPipelineCompileTypeCount> compileCounters = {
+      DxvkStatCounter::PipeBlockingCount,
+      DxvkStatCounter::PipeBackgroundCount,
+    };
+
+    for (uint32_t i = 0; i < DxvkPipelineCompileTypeCount; i++) {
+      uint32_t base = uint32_t(compileCounters[i]);
+
+      result.setCtr(DxvkStatCounter(base + 0), pipe.compiles[i].numCompiles);
+      result.setCtr(DxvkStatCounter(base + 1), pipe.compiles[i].totalTime);
+
+      for (uint32_t j = 0; j < DxvkPipelineHistogramSize; j++)
+        result.setCtr(DxvkStatCounter(base + 2 + j), pipe.compiles[i].histogram[j]);
+    }
+
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
 
+    DxvkLatencyStats latency = m_objects.latencyTracker().getStats();
+    result.setCtr(DxvkStatCounter::LatencyApp,        latency.app);
+    result.setCtr(DxvkStatCounter::LatencyCs,         latency.cs);
+    result.setCtr(DxvkStatCounter::LatencyQueue,      latency.queue);
+    result.setCtr(DxvkStatCounter::LatencyGpu,        latency.gpu);
+    result.setCtr(DxvkStatCounter::LatencyPresent,    latency.present);
+    result.setCtr(DxvkStatCounter::LatencyTotal,      latency.total);
+
+    result.setCtr(DxvkStatCounter::MemCacheHits,      mem.cacheHits);
+    result.setCtr(DxvkStatCounter::MemCacheMisses,    mem.cacheMisses);
+    result.setCtr(DxvkStatCounter::MemCacheContention, mem.cacheLockContention);
+    result.setCtr(DxvkStatCounter::MemAllocContention, mem.allocLockContention);
+    result.setCtr(DxvkStatCounter::StagingMemoryAllocated, staging.memoryAllocated);
+    result.setCtr(DxvkStatCounter::StagingMemoryUsed, staging.memoryUsed);
+    result.setCtr(DxvkStatCounter::MappedMemoryBar,   mapped.barUsed);
+    result.setCtr(DxvkStatCounter::MappedMemorySysmem, mapped.sysmemUsed);
+    result.setCtr(DxvkStatCounter::SamplerCount,      samplers.liveCount);
+    result.setCtr(DxvkStatCounter::SamplerEvictions,  samplers.evictedCount);
+    result.setCtr(DxvkStatCounter::CmdListCount,      cmdLists.liveCount);
+    result.setCtr(DxvkStatCounter::CmdListFree,       cmdLists.freeCount);
+    result.setCtr(DxvkStatCounter::CmdListCapacity,   cmdLists.capacity);
+
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
     return result;
   }
   
   
+  std::vector<DxvkPipelineStallInfo> DxvkDevice::getPipelineStalls(uint32_t count) {
+    return m_objects.pipelineManager().getWorstStalls(count);
+  }
+
+
   DxvkMemoryStats DxvkDevice::getMemoryStats(uint32_t heap) {
     return m_objects.memoryManager().getMemoryStats(heap);
   }
 
 
+  DxvkMemoryCategoryStats DxvkDevice::getMemoryCategoryStats(uint32_t heap) {
+    return m_objects.memoryManager().getHeapCategoryStats(heap);
+  }
+
+
+  int64_t DxvkDevice::getMemoryPressure() const {
+    if (m_options.memoryEvictThreshold <= 0)
+      return 0;
+
+    DxvkAdapterMemoryInfo info = m_adapter->getMemoryHeapInfo();
+
+    // Eviction is pointless if there is no system memory heap,
+    // otherwise only look at the largest device-local heap
+    // since smaller ones are typically only used for BAR.
+    uint32_t heapIndex = info.heapCount;
+    bool hasSystemHeap = false;
+
+    for (uint32_t i = 0; i < info.heapCount; i++) {
+      if (!(info.heaps[i].heapFlags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        hasSystemHeap = true;
+      else if (heapIndex == info.heapCount || info.heaps[i].memoryBudget > info.heaps[heapIndex].memoryBudget)
+        heapIndex = i;
+    }
+
+    if (!hasSystemHeap || heapIndex == info.heapCount)
+      return 0;
+
+    int64_t budget    = int64_t(info.heaps[heapIndex].memoryBudget);
+    int64_t used      = int64_t(info.heaps[heapIndex].memoryAllocated);
+    int64_t threshold = budget * std::min(m_options.memoryEvictThreshold, 100) / 100;
+
+    if (used > threshold)
+      return used - threshold;
+
+    return std::min<int64_t>(used - threshold + budget / 16, 0);
+  }
+
+
   uint32_t DxvkDevice::getCurrentFrameId() const {
     return m_statCounters.getCtr(DxvkStatCounter::QueuePresentCount);
   }
@@ -175,19 +379,57 @@ namespace dxvk {
   void DxvkDevice::registerShader(const Rc<DxvkShader>& shader) {
     m_objects.pipelineManager().registerShader(shader);
   }
+
+
+  void DxvkDevice::runShaderTask(std::function<void ()>&& task) {
+    m_objects.pipelineManager().runShaderTask(std::move(task));
+  }
+
+
+  DxvkShaderCache& DxvkDevice::getShaderCache() {
+    return m_objects.shaderCache();
+  }
+
+
+  DxvkGpuProfiler& DxvkDevice::getGpuProfiler() {
+    return m_objects.gpuProfiler();
+  }
+
+
+  DxvkLatencyTracker& DxvkDevice::getLatencyTracker() {
+    return m_objects.latencyTracker();
+  }
   
   
   void DxvkDevice::presentImage(
     const Rc<vk::Presenter>&        presenter,
-          DxvkSubmitStatus*         status) {
+          high_resolution_clock::time_point presentTime,
+          uint64_t                  displayFrameId,
+          DxvkSubmitStatus*         status,
+          std::vector<VkRectLayerKHR> regions) {
     status->result = VK_NOT_READY;
 
     DxvkPresentInfo presentInfo;
     presentInfo.presenter = presenter;
+    presentInfo.frameId   = getLatencyTracker().beginFrame(presentTime);
+    presentInfo.displayFrameId = displayFrameId;
+    presentInfo.regions   = std::move(regions);
     m_submissionQueue.present(presentInfo, status);
     
-    std::lock_guard<sync::Spinlock> statLock(m_statLock);
-    m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
+    uint64_t frameId;
+
+    { std::lock_guard<sync::Spinlock> statLock(m_statLock);
+      m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
+      frameId = m_statCounters.getCtr(DxvkStatCounter::QueuePresentCount);
+    }
+
+    m_objects.statsExporter().exportFrame(frameId);
+    m_objects.memoryDumper().processFrame(frameId);
+    m_objects.resourcePool().trim();
+    m_objects.shaderCache().trimShaderCode();
+
+    if (hasCalibratedTimestamps())
+      calibrateTimestamps();
   }
 
 
@@ -245,6 +487,89 @@ namespace dxvk {
   }
   
   
+  VkTimeDomainEXT DxvkDevice::getCpuTimeDomain() const {
+    if (!m_extensions.extCalibratedTimestamps)
+      return VK_TIME_DOMAIN_MAX_ENUM_EXT;
+
+    // Use the time domain that our own clock is based on
+#if defined(_WIN32) && !defined(__WINE__)
+    VkTimeDomainEXT cpuDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+    VkTimeDomainEXT cpuDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+    auto vki = m_adapter->vki();
+
+    uint32_t domainCount = 0;
+
+    if (vki->vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(m_adapter->handle(), &domainCount, nullptr))
+      return VK_TIME_DOMAIN_MAX_ENUM_EXT;
+
+    std::vector<VkTimeDomainEXT> domains(domainCount);
+
+    if (vki->vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(m_adapter->handle(), &domainCount, domains.data()))
+      return VK_TIME_DOMAIN_MAX_ENUM_EXT;
+
+    bool hasDevice = false;
+    bool hasCpu = false;
+
+    for (auto domain : domains) {
+      hasDevice |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+      hasCpu |= domain == cpuDomain;
+    }
+
+    return hasDevice && hasCpu ? cpuDomain : VK_TIME_DOMAIN_MAX_ENUM_EXT;
+  }
+
+
+  void DxvkDevice::calibrateTimestamps() {
+    auto now = high_resolution_clock::now();
+
+    // Clocks drift apart slowly, so recalibrating
+    // once per second is more than enough
+    { std::lock_guard<sync::Spinlock> lock(m_calibrationLock);
+
+      if (m_calibration.gpuTimestamp && now - m_calibration.cpuTime < std::chrono::seconds(1))
+        return;
+    }
+
+    std::array<VkCalibratedTimestampInfoEXT, 2> infos;
+    infos[0] = { VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT };
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1] = { VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT };
+    infos[1].timeDomain = m_cpuTimeDomain;
+
+    std::array<uint64_t, 2> timestamps = { };
+    uint64_t maxDeviation = 0;
+
+    if (m_vkd->vkGetCalibratedTimestampsEXT(m_vkd->device(),
+        infos.size(), infos.data(), timestamps.data(), &maxDeviation)) {
+      Logger::warn("DxvkDevice: Failed to calibrate timestamps");
+      return;
+    }
+
+    DxvkTimestampCalibration calibration;
+    calibration.gpuTimestamp = timestamps[0];
+
+#if defined(_WIN32) && !defined(__WINE__)
+    calibration.cpuTime = high_resolution_clock::fromCounter(int64_t(timestamps[1]));
+#else
+    // Our clock may not be based on the monotonic clock,
+    // so measure the offset between the two right away
+    struct timespec ts = { };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    auto cpuNow = high_resolution_clock::now();
+    int64_t monotonicNow = int64_t(ts.tv_sec) * 1000000000ll + int64_t(ts.tv_nsec);
+
+    calibration.cpuTime = cpuNow - std::chrono::nanoseconds(monotonicNow - int64_t(timestamps[1]));
+#endif
+
+    std::lock_guard<sync::Spinlock> lock(m_calibrationLock);
+    m_calibration = calibration;
+  }
+
+
   DxvkDevicePerfHints DxvkDevice::getPerfHints() {
     DxvkDevicePerfHints hints;
     hints.preferFbDepthStencilCopy = m_extensions.extShaderStencilExport
@@ -258,8 +583,72 @@ namespace dxvk {
   }
 
 
+  void DxvkDevice::precompileMetaPipelines() {
+    static const std::array<VkFormat, 8> colorFormats = {{
+      VK_FORMAT_R8G8B8A8_UNORM,
+      VK_FORMAT_R8G8B8A8_SRGB,
+      VK_FORMAT_B8G8R8A8_UNORM,
+      VK_FORMAT_B8G8R8A8_SRGB,
+      VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+      VK_FORMAT_B10G11R11_UFLOAT_PACK32,
+      VK_FORMAT_R16G16B16A16_SFLOAT,
+      VK_FORMAT_R32G32B32A32_SFLOAT,
+    }};
+
+    // Formats that depth-to-color and color-to-depth copies use
+    static const std::array<VkFormat, 6> copyFormats = {{
+      VK_FORMAT_R16_UNORM,
+      VK_FORMAT_R32_SFLOAT,
+      VK_FORMAT_D16_UNORM,
+      VK_FORMAT_D32_SFLOAT,
+      VK_FORMAT_D24_UNORM_S8_UINT,
+      VK_FORMAT_D32_SFLOAT_S8_UINT,
+    }};
+
+    auto isRenderable = [this] (VkFormat format) {
+      VkFormatFeatureFlags features = m_adapter->formatProperties(format).optimalTilingFeatures;
+
+      return (imageFormatInfo(format)->aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+        ? bool(features & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)
+        : bool(features & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    };
+
+    try {
+      for (auto format : colorFormats) {
+        if (!isRenderable(format))
+          continue;
+
+        // Used for mip map generation
+        m_objects.metaBlit().compilePipeline(
+          VK_IMAGE_VIEW_TYPE_2D_ARRAY, format, VK_SAMPLE_COUNT_1_BIT);
+
+        if (m_perfHints.preferFbResolve) {
+          m_objects.metaResolve().compilePipeline(format, VK_SAMPLE_COUNT_4_BIT,
+            VK_RESOLVE_MODE_NONE_KHR, VK_RESOLVE_MODE_NONE_KHR);
+        }
+      }
+
+      for (auto format : copyFormats) {
+        // Depth-stencil copies need stencil export
+        if (!isRenderable(format) || ((imageFormatInfo(format)->aspectMask
+            & VK_IMAGE_ASPECT_STENCIL_BIT) && !m_extensions.extShaderStencilExport))
+          continue;
+
+        m_objects.metaCopy().compilePipeline(
+          VK_IMAGE_VIEW_TYPE_2D_ARRAY, format, VK_SAMPLE_COUNT_1_BIT);
+      }
+
+      m_objects.metaCopy().getCopyBufferImagePipeline();
+      m_objects.metaMipGen();
+      m_objects.metaPack();
+    } catch (const DxvkError& e) {
+      Logger::warn(str::format("DXVK: Failed to precompile meta pipelines: ", e.message()));
+    }
+  }
+
+
   void DxvkDevice::recycleCommandList(const Rc<DxvkCommandList>& cmdList) {
-    m_recycledCommandLists.returnObject(cmdList);
+    m_commandListPool.recycleCommandList(cmdList);
   }
   
 
@@ -16,7 +16,6 @@
 #include "dxvk_pipecache.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_queue.h"
-#include "dxvk_recycler.h"
 #include "dxvk_renderpass.h"
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
@@ -65,6 +64,17 @@ namespace dxvk {
     DxvkDeviceQueue transfer;
   };
   
+  /**
+   * \brief Timestamp calibration
+   *
+   * Pair of GPU timestamp and CPU time that
+   * were sampled at the same point in time.
+   */
+  struct DxvkTimestampCalibration {
+    uint64_t                          gpuTimestamp = 0;
+    high_resolution_clock::time_point cpuTime;
+  };
+  
   /**
    * \brief DXVK device
    * 
@@ -197,6 +207,44 @@ namespace dxvk {
      */
     bool isUnifiedMemoryArchitecture() const;
 
+    /**
+     * \brief Checks whether graphics pipeline libraries can be used
+     *
+     * Requires the device to support fast-linking graphics
+     * pipeline libraries, unless explicitly enabled by the user.
+     * \returns \c true if pipeline libraries can be used
+     */
+    bool canUseGraphicsPipelineLibrary() const;
+
+    /**
+     * \brief Checks whether inline uniform blocks can be used
+     *
+     * Requires the device to support the feature with at least
+     * \c MaxNumInlineUniformBlocks blocks per set of up to
+     * \c MaxInlineUniformBlockSize bytes each.
+     * \returns \c true if inline uniform blocks can be used
+     */
+    bool canUseInlineUniformBlocks() const;
+
+    /**
+     * \brief Checks whether synchronization2 can be used
+     *
+     * Requires the device to support the feature, and
+     * the feature to not be disabled by the user.
+     * \returns \c true if sync2 barriers can be used
+     */
+    bool canUseSynchronization2() const;
+
+    /**
+     * \brief Checks whether buffer device addresses can be used
+     *
+     * If enabled, all memory is allocated with device address
+     * support, and shader-visible buffers can be queried for
+     * their device address.
+     * \returns \c true if buffer device addresses can be used
+     */
+    bool canUseBufferDeviceAddress() const;
+
     /**
      * \brief Queries default framebuffer size
      * \returns Default framebuffer size
@@ -245,6 +293,16 @@ namespace dxvk {
      */
     Rc<DxvkGpuEvent> createGpuEvent();
 
+    /**
+     * \brief Creates a fence
+     *
+     * Requires timeline semaphore support.
+     * \param [in] info Fence create info
+     * \returns New fence
+     */
+    Rc<DxvkFence> createFence(
+      const DxvkFenceCreateInfo&  info);
+
     /**
      * \brief Creates a query
      * 
@@ -258,9 +316,22 @@ namespace dxvk {
             VkQueryControlFlags   flags,
             uint32_t              index);
     
+    /**
+     * \brief Allocates a staging buffer
+     *
+     * Takes an idle buffer from the device-wide staging
+     * pool, or creates a new one if none is available.
+     * \param [in] size Buffer size
+     * \returns Host-visible staging buffer
+     */
+    Rc<DxvkBuffer> allocStagingBuffer(
+            VkDeviceSize          size);
+
     /**
      * \brief Creates a buffer object
      * 
+     * Reuses a recycled buffer with the same
+     * properties if one is no longer in use.
      * \param [in] createInfo Buffer create info
      * \param [in] memoryType Memory type flags
      * \returns The buffer object
@@ -268,6 +339,19 @@ namespace dxvk {
     Rc<DxvkBuffer> createBuffer(
       const DxvkBufferCreateInfo& createInfo,
             VkMemoryPropertyFlags memoryType);
+
+    /**
+     * \brief Recycles a buffer object
+     *
+     * Hands a buffer that its owner no longer needs over
+     * to the resource pool, so that a subsequent call to
+     * \ref createBuffer with identical properties can
+     * reuse it. The buffer contents are undefined when
+     * the buffer gets handed out again.
+     * \param [in] buffer The buffer
+     */
+    void recycleBuffer(
+            Rc<DxvkBuffer>&&      buffer);
     
     /**
      * \brief Creates a buffer view
@@ -283,6 +367,8 @@ namespace dxvk {
     /**
      * \brief Creates an image object
      * 
+     * Reuses a recycled image with the same
+     * properties if one is no longer in use.
      * \param [in] createInfo Image create info
      * \param [in] memoryType Memory type flags
      * \returns The image object
@@ -291,6 +377,16 @@ namespace dxvk {
       const DxvkImageCreateInfo&  createInfo,
             VkMemoryPropertyFlags memoryType);
 
+    /**
+     * \brief Recycles an image object
+     *
+     * Same as \ref recycleBuffer, but for images.
+     * Shared and sparse images are not recycled.
+     * \param [in] image The image
+     */
+    void recycleImage(
+            Rc<DxvkImage>&&       image);
+
     /**
      * \brief Creates an image object for an existing VkImage
      * 
@@ -316,12 +412,44 @@ namespace dxvk {
     /**
      * \brief Creates a sampler object
      * 
+     * Samplers are deduplicated, so this may return
+     * an existing sampler with the same properties.
      * \param [in] createInfo Sampler parameters
-     * \returns Newly created sampler object
+     * \returns Sampler object
      */
     Rc<DxvkSampler> createSampler(
       const DxvkSamplerCreateInfo&  createInfo);
+
+    /**
+     * \brief Queries sampler pool statistics
+     * \returns Number of live and evicted samplers
+     */
+    DxvkSamplerStats getSamplerStats();
     
+    /**
+     * \brief Checks whether GPU timestamps can be converted
+     *
+     * Requires \c VK_EXT_calibrated_timestamps with support
+     * for both the device and the matching CPU time domain.
+     * \returns \c true if \ref convertGpuTimestamp works
+     */
+    bool hasCalibratedTimestamps() const {
+      return m_cpuTimeDomain != VK_TIME_DOMAIN_MAX_ENUM_EXT;
+    }
+
+    /**
+     * \brief Converts a GPU timestamp to CPU time
+     *
+     * Uses the most recent calibration, which is refreshed
+     * periodically on present so that clock drift does not
+     * accumulate. Must only be used if calibrated timestamps
+     * are supported.
+     * \param [in] timestamp Raw GPU timestamp query value
+     * \returns Corresponding point in CPU time
+     */
+    high_resolution_clock::time_point convertGpuTimestamp(
+            uint64_t                  timestamp);
+
     /**
      * \brief Retrieves stat counters
      * 
@@ -331,6 +459,15 @@ namespace dxvk {
      */
     DxvkStatCounters getStatCounters();
 
+    /**
+     * \brief Retrieves worst pipeline stalls
+     *
+     * \param [in] count Maximum number of entries
+     * \returns Graphics pipelines that spent the most
+     *    time in compiles that blocked rendering
+     */
+    std::vector<DxvkPipelineStallInfo> getPipelineStalls(uint32_t count);
+
     /**
      * \brief Retrieves memors statistics
      *
@@ -339,6 +476,28 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap);
 
+    /**
+     * \brief Retrieves per-category memory statistics
+     *
+     * \param [in] heap Memory heap index
+     * \returns Memory used by each resource category
+     */
+    DxvkMemoryCategoryStats getMemoryCategoryStats(uint32_t heap);
+
+    /**
+     * \brief Queries device memory pressure
+     *
+     * Compares the driver-reported usage of the main
+     * device-local heap against the eviction threshold
+     * set in the config. Usage must drop a bit below the
+     * threshold before evicted resources are restored,
+     * so that they do not move back and forth every frame.
+     * \returns Number of bytes that should be evicted if
+     *    positive, or that can be restored if negative.
+     *    Always zero if eviction is disabled.
+     */
+    int64_t getMemoryPressure() const;
+
     /**
      * \brief Retreves current frame ID
      * \returns Current frame ID
@@ -360,6 +519,42 @@ namespace dxvk {
      */
     void registerShader(
       const Rc<DxvkShader>&         shader);
+
+    /**
+     * \brief Runs a shader translation task
+     *
+     * Executes the given task on a pipeline worker
+     * thread. Used by front-ends to translate shaders
+     * in the background.
+     * \param [in] task Function to execute
+     */
+    void runShaderTask(
+            std::function<void ()>&&  task);
+
+    /**
+     * \brief Retrieves persistent shader cache
+     *
+     * Front-ends can use this to store translated
+     * shaders so that they do not need to translate
+     * the same shader again on subsequent runs.
+     * \returns Shader cache
+     */
+    DxvkShaderCache& getShaderCache();
+
+    /**
+     * \brief Retrieves GPU profiler
+     *
+     * Contexts use this to report GPU timings
+     * if profiling is enabled via the environment.
+     * \returns GPU profiler
+     */
+    DxvkGpuProfiler& getGpuProfiler();
+
+    /**
+     * \brief Retrieves frame latency tracker
+     * \returns Frame latency tracker
+     */
+    DxvkLatencyTracker& getLatencyTracker();
     
     /**
      * \brief Presents a swap chain image
@@ -368,11 +563,19 @@ namespace dxvk {
      * the submission thread. The status of this operation
      * can be retrieved with \ref waitForSubmission.
      * \param [in] presenter The presenter
+     * \param [in] presentTime Time the app called Present
+     * \param [in] displayFrameId Frame ID that the presenter
+     *    signals once the image is displayed, or 0
      * \param [out] status Present status
+     * \param [in] regions Changed image regions, or empty
+     *    if the entire image has changed
      */
     void presentImage(
       const Rc<vk::Presenter>&        presenter,
-            DxvkSubmitStatus*         status);
+            high_resolution_clock::time_point presentTime,
+            uint64_t                  displayFrameId,
+            DxvkSubmitStatus*         status,
+            std::vector<VkRectLayerKHR> regions = { });
     
     /**
      * \brief Submits a command list
@@ -421,6 +624,17 @@ namespace dxvk {
       return m_submissionQueue.pendingSubmissions();
     }
 
+    /**
+     * \brief Retrieves estimated GPU idle time
+     *
+     * Monotonically increasing counter. Cheaper to
+     * query than the full set of stat counters.
+     * \returns Accumulated GPU idle time, in us
+     */
+    uint64_t gpuIdleTicks() const {
+      return m_submissionQueue.gpuIdleTicks();
+    }
+
     /**
      * \brief Increments a given stat counter
      *
@@ -478,11 +692,21 @@ namespace dxvk {
     
     DxvkDeviceQueueSet          m_queues;
     
-    DxvkRecycler<DxvkCommandList, 16> m_recycledCommandLists;
+    DxvkCommandListPool         m_commandListPool;
     
     DxvkSubmissionQueue m_submissionQueue;
 
+    VkTimeDomainEXT             m_cpuTimeDomain = VK_TIME_DOMAIN_MAX_ENUM_EXT;
+    sync::Spinlock              m_calibrationLock;
+    DxvkTimestampCalibration    m_calibration;
+
     DxvkDevicePerfHints getPerfHints();
+
+    VkTimeDomainEXT getCpuTimeDomain() const;
+
+    void calibrateTimestamps();
+
+    void precompileMetaPipelines();
     
     void recycleCommandList(
       const Rc<DxvkCommandList>& cmdList);
@@ -0,0 +1,178 @@
+#include "dxvk_device.h"
+#include "dxvk_fence.h"
+
+namespace dxvk {
+
+  DxvkFence::DxvkFence(
+          DxvkDevice*           device,
+    const DxvkFenceCreateInfo&  info)
+  : m_vkd(device->vkd()), m_info(info) {
+    if (info.sharingMode != DxvkSharedHandleMode::None && !device->extensions().khrExternalSemaphoreWin32)
+      throw DxvkError("DxvkFence: VK_KHR_external_semaphore_win32 not supported");
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR };
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = info.initialValue;
+
+    VkExportSemaphoreCreateInfo exportInfo = { VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO };
+    exportInfo.handleTypes = info.sharingType;
+
+    if (info.sharingMode == DxvkSharedHandleMode::Export)
+      typeInfo.pNext = &exportInfo;
+
+    VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &typeInfo };
+
+    if (m_vkd->vkCreateSemaphore(m_vkd->device(), &semaphoreInfo, nullptr, &m_semaphore) != VK_SUCCESS)
+      throw DxvkError("DxvkFence: Failed to create timeline semaphore");
+
+    if (info.sharingMode == DxvkSharedHandleMode::Import) {
+#ifdef _WIN32
+      VkImportSemaphoreWin32HandleInfoKHR importInfo = { VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_WIN32_HANDLE_INFO_KHR };
+      importInfo.semaphore = m_semaphore;
+      importInfo.handleType = info.sharingType;
+      importInfo.handle = info.sharedHandle;
+
+      if (m_vkd->vkImportSemaphoreWin32HandleKHR(m_vkd->device(), &importInfo) != VK_SUCCESS) {
+        m_vkd->vkDestroySemaphore(m_vkd->device(), m_semaphore, nullptr);
+        throw DxvkError("DxvkFence: Failed to import timeline semaphore");
+      }
+#else
+      m_vkd->vkDestroySemaphore(m_vkd->device(), m_semaphore, nullptr);
+      throw DxvkError("DxvkFence: Shared semaphores not supported on this platform");
+#endif
+    }
+  }
+
+
+  DxvkFence::~DxvkFence() {
+    if (m_thread.joinable()) {
+      { std::unique_lock<dxvk::mutex> lock(m_mutex);
+        m_running = false;
+      }
+
+      m_cond.notify_one();
+      m_thread.join();
+    }
+
+    m_vkd->vkDestroySemaphore(m_vkd->device(), m_semaphore, nullptr);
+  }
+
+
+  uint64_t DxvkFence::getValue() {
+    uint64_t value = 0;
+
+    if (m_vkd->vkGetSemaphoreCounterValueKHR(m_vkd->device(), m_semaphore, &value) != VK_SUCCESS)
+      Logger::err("DxvkFence: Failed to query semaphore value");
+
+    return value;
+  }
+
+
+  void DxvkFence::enqueueWait(uint64_t value, std::function<void ()>&& event) {
+    if (value <= getValue()) {
+      event();
+      return;
+    }
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+    m_queue.push({ value, std::move(event) });
+
+    // Only spawn the worker once somebody actually waits on
+    // the fence, most fences are only ever signaled by us
+    if (!m_running) {
+      // A previous worker may have given up after an error
+      if (m_thread.joinable())
+        m_thread.join();
+
+      m_running = true;
+      m_thread = dxvk::thread([this] () { run(); });
+    }
+
+    m_cond.notify_one();
+  }
+
+
+  HANDLE DxvkFence::sharedHandle() const {
+    HANDLE handle = INVALID_HANDLE_VALUE;
+
+    if (m_info.sharingMode == DxvkSharedHandleMode::None)
+      return INVALID_HANDLE_VALUE;
+
+#ifdef _WIN32
+    VkSemaphoreGetWin32HandleInfoKHR handleInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR };
+    handleInfo.semaphore = m_semaphore;
+    handleInfo.handleType = m_info.sharingType;
+
+    if (m_vkd->vkGetSemaphoreWin32HandleKHR(m_vkd->device(), &handleInfo, &handle) != VK_SUCCESS)
+      Logger::warn("DxvkFence: Failed to get shared handle for semaphore");
+#endif
+
+    return handle;
+  }
+
+
+  void DxvkFence::run() {
+    env::setThreadName("dxvk-fence");
+
+    while (true) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+      m_cond.wait(lock, [this] {
+        return !m_queue.empty() || !m_running;
+      });
+
+      if (!m_running)
+        return;
+
+      uint64_t value = m_queue.top().value;
+      lock.unlock();
+
+      // Wait with a timeout so that we can notice the fence
+      // being destroyed while the semaphore never reaches
+      // the requested value, e.g. if the app never signals it
+      VkSemaphoreWaitInfoKHR waitInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR };
+      waitInfo.semaphoreCount = 1;
+      waitInfo.pSemaphores = &m_semaphore;
+      waitInfo.pValues = &value;
+
+      VkResult vr = m_vkd->vkWaitSemaphoresKHR(
+        m_vkd->device(), &waitInfo, 10'000'000ull);
+
+      if (vr != VK_SUCCESS && vr != VK_TIMEOUT) {
+        Logger::err(str::format("DxvkFence: Failed to wait for semaphore: ", vr));
+
+        // The device is most likely lost. Run all pending callbacks
+        // so that nothing waits on them forever, and mark the worker
+        // as stopped so that the next wait can spawn a new one.
+        lock.lock();
+
+        while (!m_queue.empty()) {
+          auto event = std::move(const_cast<QueueItem&>(m_queue.top()).event);
+          m_queue.pop();
+
+          lock.unlock();
+          event();
+          lock.lock();
+        }
+
+        m_running = false;
+        return;
+      }
+
+      // Execute all callbacks whose value has been reached,
+      // including ones that were added in the meantime
+      uint64_t current = getValue();
+      lock.lock();
+
+      while (!m_queue.empty() && m_queue.top().value <= current) {
+        auto event = std::move(const_cast<QueueItem&>(m_queue.top()).event);
+        m_queue.pop();
+
+        lock.unlock();
+        event();
+        lock.lock();
+      }
+    }
+  }
+
+}
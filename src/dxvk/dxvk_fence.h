@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <queue>
+
+#include "../util/thread.h"
+
+#include "dxvk_memory.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Fence create info
+   */
+  struct DxvkFenceCreateInfo {
+    uint64_t                                initialValue = 0;
+    DxvkSharedHandleMode                    sharingMode  = DxvkSharedHandleMode::None;
+    VkExternalSemaphoreHandleTypeFlagBits   sharingType  = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_FLAG_BITS_MAX_ENUM;
+#ifdef _WIN32
+    HANDLE                                  sharedHandle = INVALID_HANDLE_VALUE;
+#endif
+  };
+
+
+  /**
+   * \brief Fence
+   *
+   * Wrapper around a Vulkan timeline semaphore
+   * which can be signaled or waited on by queue
+   * submissions, and optionally be shared with
+   * other processes or APIs.
+   */
+  class DxvkFence : public RcObject {
+
+  public:
+
+    DxvkFence(
+            DxvkDevice*           device,
+      const DxvkFenceCreateInfo&  info);
+
+    ~DxvkFence();
+
+    /**
+     * \brief Semaphore handle
+     * \returns The timeline semaphore
+     */
+    VkSemaphore handle() const {
+      return m_semaphore;
+    }
+
+    /**
+     * \brief Retrieves current semaphore value
+     * \returns Last completed semaphore value
+     */
+    uint64_t getValue();
+
+    /**
+     * \brief Enqueues a callback
+     *
+     * The callback will be executed on a worker thread
+     * once the semaphore reaches the given value, or
+     * immediately if it already has.
+     * \param [in] value Value to wait for
+     * \param [in] event Callback
+     */
+    void enqueueWait(uint64_t value, std::function<void ()>&& event);
+
+    /**
+     * \brief Creates a shared handle to the semaphore
+     * \returns The shared handle with the type given by
+     *    \c DxvkFenceCreateInfo::sharingType, or an invalid
+     *    handle if the semaphore is not shared.
+     */
+    HANDLE sharedHandle() const;
+
+  private:
+
+    struct QueueItem {
+      uint64_t                value;
+      std::function<void ()>  event;
+
+      bool operator < (const QueueItem& other) const {
+        return value > other.value;
+      }
+    };
+
+    Rc<vk::DeviceFn>            m_vkd;
+    DxvkFenceCreateInfo         m_info;
+    VkSemaphore                 m_semaphore = VK_NULL_HANDLE;
+
+    dxvk::mutex                 m_mutex;
+    dxvk::condition_variable    m_cond;
+    std::priority_queue<QueueItem> m_queue;
+    bool                        m_running = false;
+
+    dxvk::thread                m_thread;
+
+    void run();
+
+  };
+
+
+  /**
+   * \brief Fence-value pair
+   *
+   * Used to track fence operations
+   * that are part of a submission.
+   */
+  struct DxvkFenceValuePair {
+    Rc<DxvkFence> fence;
+    uint64_t      value;
+  };
+
+}
@@ -0,0 +1,76 @@
+#include "dxvk_device.h"
+#include "dxvk_flush.h"
+
+namespace dxvk {
+
+  bool DxvkFlushTracker::considerFlush(
+          DxvkDevice*               device,
+          DxvkFlushHint             hint,
+          uint64_t                  chunkId) {
+    m_reason = DxvkStatCounter::QueueFlushExplicit;
+
+    uint32_t pending = device->pendingSubmissions();
+    uint64_t idleTicks = device->gpuIdleTicks();
+
+    // If the GPU is idle, or has been idle at any point since
+    // we last checked, the CPU is not submitting work quickly
+    // enough, so flush as soon as possible.
+    bool gpuStarved = !pending || idleTicks != m_lastIdleTicks;
+    m_lastIdleTicks = idleTicks;
+
+    auto now = high_resolution_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastFlush);
+
+    if (gpuStarved && elapsed >= std::chrono::microseconds(MinIdleFlushIntervalUs)) {
+      m_reason = DxvkStatCounter::QueueFlushIdle;
+      return true;
+    }
+
+    // Do not pile up submissions for weak flush points while
+    // the GPU is busy, batching them is more efficient.
+    if (hint == DxvkFlushHint::Weak && pending > MaxPendingSubmits) {
+      m_skippedCount += 1;
+      return false;
+    }
+
+    uint32_t delay = MinFlushIntervalUs;
+
+    if (hint != DxvkFlushHint::Readback)
+      delay += IncFlushIntervalUs * pending;
+
+    if (elapsed >= std::chrono::microseconds(delay)) {
+      m_reason = DxvkStatCounter::QueueFlushInterval;
+      return true;
+    }
+
+    // Submit unusually large batches early so that the GPU
+    // does not have to wait for the entire batch to be recorded
+    uint64_t batchChunks = chunkId - m_lastFlushChunk;
+
+    if (batchChunks >= MinLargeBatchChunks && batchChunks >= 2 * m_avgBatchChunks) {
+      m_reason = DxvkStatCounter::QueueFlushSize;
+      return true;
+    }
+
+    m_skippedCount += 1;
+    return false;
+  }
+
+
+  void DxvkFlushTracker::notifyFlush(
+          DxvkDevice*               device,
+          uint64_t                  chunkId) {
+    // Keep a moving average of recent batch sizes
+    uint64_t batchChunks = chunkId - m_lastFlushChunk;
+    m_avgBatchChunks = (3 * m_avgBatchChunks + batchChunks) / 4;
+
+    device->addStatCtr(std::exchange(m_reason, DxvkStatCounter::QueueFlushExplicit), 1);
+
+    if (m_skippedCount)
+      device->addStatCtr(DxvkStatCounter::QueueFlushSkipped, std::exchange(m_skippedCount, 0));
+
+    m_lastFlush = high_resolution_clock::now();
+    m_lastFlushChunk = chunkId;
+  }
+
+}
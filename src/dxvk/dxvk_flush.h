@@ -0,0 +1,98 @@
+#pragma once
+
+#include "dxvk_include.h"
+#include "dxvk_stats.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Implicit flush hint
+   *
+   * Describes how urgently the application is
+   * likely going to need the results of work
+   * recorded up to the flush point.
+   */
+  enum class DxvkFlushHint : uint32_t {
+    Weak,       ///< Regular flush point, e.g. after a draw
+    Strong,     ///< Results likely needed soon, e.g. query end
+    Readback,   ///< Application is about to read back data
+  };
+
+
+  /**
+   * \brief Implicit flush heuristic
+   *
+   * Decides whether the front-end should submit its pending
+   * commands at an implicit flush point. Flushes early when
+   * the GPU is idle or went idle since the last decision,
+   * since the GPU is otherwise starved while the CPU keeps
+   * batching. When the GPU is busy, flushes are rate-limited
+   * based on the number of pending submissions, unless the
+   * current batch grows well beyond recent batch sizes.
+   *
+   * Decisions are reported via stat counters.
+   */
+  class DxvkFlushTracker {
+    /// Minimum interval between flushes if the GPU is idle
+    constexpr static uint32_t MinIdleFlushIntervalUs = 250;
+    /// Minimum interval between flushes if the GPU is busy
+    constexpr static uint32_t MinFlushIntervalUs = 750;
+    /// Additional delay per pending submission
+    constexpr static uint32_t IncFlushIntervalUs = 250;
+    /// Maximum pending submissions for weak flush points
+    constexpr static uint32_t MaxPendingSubmits = 6;
+    /// Minimum number of CS chunks for size-based flushes
+    constexpr static uint32_t MinLargeBatchChunks = 16;
+  public:
+
+    /**
+     * \brief Checks whether to flush at a flush point
+     *
+     * \param [in] device DXVK device
+     * \param [in] hint Flush hint
+     * \param [in] chunkId Current CS chunk sequence number
+     * \returns \c true if the caller should flush
+     */
+    bool considerFlush(
+            DxvkDevice*               device,
+            DxvkFlushHint             hint,
+            uint64_t                  chunkId);
+
+    /**
+     * \brief Notifies the tracker of a flush
+     *
+     * Must be called on every flush, implicit or not.
+     * \param [in] device DXVK device
+     * \param [in] chunkId Current CS chunk sequence number
+     */
+    void notifyFlush(
+            DxvkDevice*               device,
+            uint64_t                  chunkId);
+
+    /**
+     * \brief Time of the last flush
+     * \returns Time point of last flush
+     */
+    high_resolution_clock::time_point lastFlush() const {
+      return m_lastFlush;
+    }
+
+  private:
+
+    high_resolution_clock::time_point m_lastFlush
+      = high_resolution_clock::now();
+
+    uint64_t      m_lastFlushChunk  = 0ull;
+    uint64_t      m_lastIdleTicks   = 0ull;
+    uint64_t      m_avgBatchChunks  = 0ull;
+    uint64_t      m_skippedCount    = 0ull;
+
+    DxvkStatCounter m_reason = DxvkStatCounter::QueueFlushExplicit;
+
+  };
+
+}
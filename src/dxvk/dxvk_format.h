@@ -54,7 +54,26 @@ namespace dxvk {
   };
   
   
+  /// Format info for all formats in the core format range,
+  /// i.e. \c VK_FORMAT_UNDEFINED to \c VK_FORMAT_BC7_SRGB_BLOCK,
+  /// followed by formats from extensions.
+  extern const std::array<DxvkFormatInfo, 152> g_formatInfos;
   
-  const DxvkFormatInfo* imageFormatInfo(VkFormat format);
+  const DxvkFormatInfo* lookupExtFormatInfo(VkFormat format);
+  
+  /**
+   * \brief Looks up format info
+   * 
+   * Core formats are looked up directly by their enum
+   * value, without having to iterate over format ranges.
+   * \param [in] format The format to look up
+   * \returns Format info, or \c nullptr if unknown
+   */
+  inline const DxvkFormatInfo* imageFormatInfo(VkFormat format) {
+    if (likely(uint32_t(format) <= uint32_t(VK_FORMAT_BC7_SRGB_BLOCK)))
+      return &g_formatInfos[uint32_t(format)];
+
+    return lookupExtFormatInfo(format);
+  }
   
 }
\ No newline at end of file
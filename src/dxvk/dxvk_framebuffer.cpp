@@ -42,6 +42,16 @@ namespace dxvk {
   }
 
 
+  bool DxvkFramebufferInfo::usesImage(const Rc<DxvkImage>& image) const {
+    for (uint32_t i = 0; i < m_attachmentCount; i++) {
+      if (getAttachment(i).view->image() == image)
+        return true;
+    }
+
+    return false;
+  }
+
+
   bool DxvkFramebufferInfo::hasTargets(const DxvkRenderTargets& renderTargets) {
     bool eq = m_renderTargets.depth.view   == renderTargets.depth.view
            && m_renderTargets.depth.layout == renderTargets.depth.layout;
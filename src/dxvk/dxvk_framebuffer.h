@@ -53,33 +53,6 @@ namespace dxvk {
   };
 
 
-  /**
-   * \brief Framebuffer key
-   */
-  struct DxvkFramebufferKey {
-    uint64_t            colorViews[MaxNumRenderTargets];
-    uint64_t            depthView;
-    VkRenderPass        renderPass;
-
-    size_t hash() const {
-      DxvkHashState state;
-      state.add(depthView);
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
-        state.add(colorViews[i]);
-      state.add(uint64_t(renderPass));
-      return state;
-    }
-
-    bool eq(const DxvkFramebufferKey& other) const {
-      bool eq = depthView   == other.depthView
-             && renderPass  == other.renderPass;
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
-        eq &= colorViews[i] == other.colorViews[i];
-      return eq;
-    }
-  };
-
-
   /**
    * \brief Framebuffer info
    *
@@ -180,12 +153,20 @@ namespace dxvk {
      */
     int32_t findAttachment(const Rc<DxvkImageView>& view) const;
 
+    /**
+     * \brief Checks whether an image is used as an attachment
+     *
+     * \param [in] image Image to check
+     * \returns \c true if any attachment view uses the image
+     */
+    bool usesImage(const Rc<DxvkImage>& image) const;
+
     /**
      * \brief Checks whether the framebuffer's targets match
      *
      * \param [in] renderTargets Render targets to check
      * \returns \c true if the render targets are the same
-     *          as the ones used for this framebuffer object.
+     *          as the ones used for this framebuffer.
      */
     bool hasTargets(const DxvkRenderTargets& renderTargets);
 
@@ -0,0 +1,202 @@
+#include "dxvk_device.h"
+#include "dxvk_gpu_profiler.h"
+
+namespace dxvk {
+
+  constexpr uint32_t GpuProcessId = 1;
+  constexpr uint32_t CpuProcessId = 2;
+
+  DxvkGpuProfiler::DxvkGpuProfiler(DxvkDevice* device)
+  : m_device(device) {
+    if (env::getEnvVar("DXVK_GPU_PROFILE") != "1")
+      return;
+
+    const auto& limits = device->properties().core.properties.limits;
+
+    if (!limits.timestampComputeAndGraphics) {
+      Logger::warn("DXVK: GPU profiler not supported, timestamps not available");
+      return;
+    }
+
+    m_file.open(getTraceFileName().c_str(), std::ios_base::trunc);
+
+    if (!m_file) {
+      Logger::warn("DXVK: Failed to open GPU profiler trace file");
+      return;
+    }
+
+    Logger::info("DXVK: GPU profiler enabled");
+
+    m_enabled = true;
+    m_cpuEnabled = device->config().profileAnnotations;
+    m_timestampPeriod = double(limits.timestampPeriod);
+    m_cpuBaseTime = high_resolution_clock::now();
+
+    m_file << "{\"traceEvents\":[" << std::endl;
+
+    writeMetadata("process_name", GpuProcessId, 0, "GPU");
+    writeMetadata("thread_name", GpuProcessId, uint32_t(DxvkGpuProfilerTrack::Commands), "Commands");
+    writeMetadata("thread_name", GpuProcessId, uint32_t(DxvkGpuProfilerTrack::Labels), "Markers");
+
+    if (m_cpuEnabled) {
+      writeMetadata("process_name", CpuProcessId, 0, "CPU");
+      writeMetadata("thread_name", CpuProcessId, uint32_t(DxvkCpuProfilerTrack::AppThread), "Application");
+      writeMetadata("thread_name", CpuProcessId, uint32_t(DxvkCpuProfilerTrack::CsThread), "CS thread");
+    }
+  }
+
+
+  DxvkGpuProfiler::~DxvkGpuProfiler() {
+    if (!m_enabled)
+      return;
+
+    // The device is idle at this point, so all remaining
+    // scopes that were actually submitted are available
+    processScopes();
+
+    m_file << "]}" << std::endl;
+  }
+
+
+  Rc<DxvkGpuQuery> DxvkGpuProfiler::createQuery() const {
+    return m_device->createGpuQuery(VK_QUERY_TYPE_TIMESTAMP, 0, 0);
+  }
+
+
+  void DxvkGpuProfiler::addScope(
+          DxvkGpuProfilerScope&&  scope) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_scopes.push(std::move(scope));
+
+    processScopes();
+  }
+
+
+  DxvkCpuProfilerScope DxvkGpuProfiler::beginCpuScope(
+          std::string             name) const {
+    DxvkCpuProfilerScope scope;
+    scope.name  = std::move(name);
+    scope.begin = high_resolution_clock::now();
+    return scope;
+  }
+
+
+  void DxvkGpuProfiler::endCpuScope(
+    const DxvkCpuProfilerScope&   scope,
+          DxvkCpuProfilerTrack    track) {
+    auto end = high_resolution_clock::now();
+
+    // Trace event timestamps are in microseconds
+    double ts  = double(std::chrono::duration_cast<std::chrono::nanoseconds>(scope.begin - m_cpuBaseTime).count()) / 1000.0;
+    double dur = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - scope.begin).count()) / 1000.0;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    writeEvent(scope.name, CpuProcessId, uint32_t(track), ts, dur);
+  }
+
+
+  void DxvkGpuProfiler::processScopes() {
+    // Scopes are added roughly in submission order, so stop at the
+    // first one that is still pending rather than polling everything
+    while (!m_scopes.empty()) {
+      const DxvkGpuProfilerScope& scope = m_scopes.front();
+
+      DxvkQueryData beginData = { };
+      DxvkQueryData endData = { };
+
+      DxvkGpuQueryStatus beginStatus = scope.begin->getData(beginData);
+      DxvkGpuQueryStatus endStatus = scope.end->getData(endData);
+
+      if (beginStatus == DxvkGpuQueryStatus::Pending
+       || endStatus == DxvkGpuQueryStatus::Pending)
+        return;
+
+      if (beginStatus == DxvkGpuQueryStatus::Available
+       && endStatus == DxvkGpuQueryStatus::Available)
+        writeScope(scope, beginData.timestamp.time, endData.timestamp.time);
+
+      m_scopes.pop();
+    }
+  }
+
+
+  void DxvkGpuProfiler::writeScope(
+    const DxvkGpuProfilerScope&   scope,
+          uint64_t                begin,
+          uint64_t                end) {
+    if (!(m_scopeCount++))
+      m_baseTimestamp = begin;
+
+    // Trace event timestamps are in microseconds. With calibrated
+    // timestamps, place GPU scopes on the same timeline as CPU scopes.
+    double ts  = double(int64_t(begin - m_baseTimestamp)) * m_timestampPeriod / 1000.0;
+    double dur = double(end > begin ? end - begin : 0) * m_timestampPeriod / 1000.0;
+
+    if (m_device->hasCalibratedTimestamps()) {
+      auto cpuBegin = m_device->convertGpuTimestamp(begin);
+      ts = double(std::chrono::duration_cast<std::chrono::nanoseconds>(cpuBegin - m_cpuBaseTime).count()) / 1000.0;
+    }
+
+    writeEvent(scope.name, GpuProcessId, uint32_t(scope.track), ts, dur);
+  }
+
+
+  void DxvkGpuProfiler::writeEvent(
+    const std::string&            name,
+          uint32_t                pid,
+          uint32_t                tid,
+          double                  ts,
+          double                  dur) {
+    m_file << (m_eventCount++ ? "," : " ")
+      << "{\"name\":\"" << escapeString(name) << "\","
+      << "\"ph\":\"X\",\"pid\":" << pid << ","
+      << "\"tid\":" << tid << ","
+      << "\"ts\":" << ts << ","
+      << "\"dur\":" << dur << "}\n";
+  }
+
+
+  void DxvkGpuProfiler::writeMetadata(
+    const char*                   type,
+          uint32_t                pid,
+          uint32_t                tid,
+    const char*                   name) {
+    m_file << (m_eventCount++ ? "," : " ")
+      << "{\"name\":\"" << type << "\","
+      << "\"ph\":\"M\",\"pid\":" << pid << ","
+      << "\"tid\":" << tid << ","
+      << "\"args\":{\"name\":\"" << name << "\"}}\n";
+  }
+
+
+  std::string DxvkGpuProfiler::escapeString(
+    const std::string&            str) {
+    std::string result;
+    result.reserve(str.size());
+
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        result += '\\';
+        result += c;
+      } else if (uint8_t(c) >= 0x20) {
+        result += c;
+      }
+    }
+
+    return result;
+  }
+
+
+  std::wstring DxvkGpuProfiler::getTraceFileName() {
+    std::string path = env::getExePath();
+    size_t dirEnd = path.find_last_of("/\\");
+
+    path = dirEnd != std::string::npos
+      ? path.substr(0, dirEnd + 1)
+      : std::string();
+
+    path += env::getExeBaseName() + ".dxvk-trace.json";
+    return str::tows(path.c_str());
+  }
+
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <fstream>
+#include <queue>
+#include <string>
+
+#include "dxvk_gpu_query.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Profiler track
+   *
+   * Scopes on different tracks are not required
+   * to be properly nested with each other, so
+   * they are shown as separate threads.
+   */
+  enum class DxvkGpuProfilerTrack : uint32_t {
+    Commands  = 1,
+    Labels    = 2,
+  };
+
+
+  /**
+   * \brief CPU profiler track
+   *
+   * Application markers are timed both when the
+   * application issues them and when the CS thread
+   * executes them, which are shown as two threads.
+   */
+  enum class DxvkCpuProfilerTrack : uint32_t {
+    AppThread = 1,
+    CsThread  = 2,
+  };
+
+
+  /**
+   * \brief Timed GPU scope
+   *
+   * Stores the timestamp queries written
+   * at the start and end of the scope.
+   */
+  struct DxvkGpuProfilerScope {
+    std::string           name;
+    DxvkGpuProfilerTrack  track;
+    Rc<DxvkGpuQuery>      begin;
+    Rc<DxvkGpuQuery>      end;
+  };
+
+
+  /**
+   * \brief Timed CPU scope
+   *
+   * Stores the name and start time of a CPU scope
+   * until the matching end marker is reached.
+   */
+  struct DxvkCpuProfilerScope {
+    std::string                       name;
+    high_resolution_clock::time_point begin;
+  };
+
+
+  /**
+   * \brief GPU profiler
+   *
+   * Collects GPU timestamps written by contexts at render
+   * pass, dispatch and debug label boundaries, and writes
+   * them to a trace file in the Chrome trace event format
+   * which can be loaded in Perfetto or chrome://tracing.
+   *
+   * Optionally, application markers are also timed on the
+   * CPU, so that the time DXVK spends processing commands
+   * can be attributed to the application's render passes.
+   * CPU scopes are written as a separate process. If the
+   * device supports calibrated timestamps, GPU scopes are
+   * converted to CPU time so that both line up.
+   * This class is thread-safe.
+   */
+  class DxvkGpuProfiler {
+
+  public:
+
+    DxvkGpuProfiler(DxvkDevice* device);
+
+    ~DxvkGpuProfiler();
+
+    /**
+     * \brief Checks whether profiling is enabled
+     * \returns \c true if profiling is enabled
+     */
+    bool isEnabled() const {
+      return m_enabled;
+    }
+
+    /**
+     * \brief Checks whether CPU markers are profiled
+     * \returns \c true if CPU scopes should be recorded
+     */
+    bool isCpuProfilingEnabled() const {
+      return m_cpuEnabled;
+    }
+
+    /**
+     * \brief Creates a timestamp query
+     * \returns New timestamp query
+     */
+    Rc<DxvkGpuQuery> createQuery() const;
+
+    /**
+     * \brief Adds a finished scope
+     *
+     * Both queries must have been written to a command
+     * list. The scope will be written to the trace file
+     * once the timestamps become available.
+     * \param [in] scope The scope
+     */
+    void addScope(
+            DxvkGpuProfilerScope&&  scope);
+
+    /**
+     * \brief Begins a CPU scope
+     *
+     * \param [in] name Scope name
+     * \returns Scope with the current time as its start
+     */
+    DxvkCpuProfilerScope beginCpuScope(
+            std::string             name) const;
+
+    /**
+     * \brief Ends a CPU scope
+     *
+     * Writes the scope to the trace file, using
+     * the current time as the end of the scope.
+     * \param [in] scope The scope
+     * \param [in] track The thread the scope ran on
+     */
+    void endCpuScope(
+      const DxvkCpuProfilerScope&   scope,
+            DxvkCpuProfilerTrack    track);
+
+  private:
+
+    DxvkDevice*                       m_device;
+    bool                              m_enabled         = false;
+    bool                              m_cpuEnabled      = false;
+    double                            m_timestampPeriod = 1.0;
+
+    dxvk::mutex                       m_mutex;
+    std::ofstream                     m_file;
+    std::queue<DxvkGpuProfilerScope>  m_scopes;
+    uint64_t                          m_baseTimestamp   = 0;
+    uint64_t                          m_scopeCount      = 0;
+    uint64_t                          m_eventCount      = 0;
+
+    high_resolution_clock::time_point m_cpuBaseTime;
+
+    void processScopes();
+
+    void writeScope(
+      const DxvkGpuProfilerScope&   scope,
+            uint64_t                begin,
+            uint64_t                end);
+
+    void writeEvent(
+      const std::string&            name,
+            uint32_t                pid,
+            uint32_t                tid,
+            double                  ts,
+            double                  dur);
+
+    void writeMetadata(
+      const char*                   type,
+            uint32_t                pid,
+            uint32_t                tid,
+      const char*                   name);
+
+    static std::string escapeString(
+      const std::string&            str);
+
+    static std::wstring getTraceFileName();
+
+  };
+
+}
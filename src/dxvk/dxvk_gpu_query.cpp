@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 #include "dxvk_cmdlist.h"
 #include "dxvk_device.h"
@@ -88,18 +90,21 @@ namespace dxvk {
   DxvkGpuQueryStatus DxvkGpuQuery::getDataForHandle(
           DxvkQueryData&      queryData,
     const DxvkGpuQueryHandle& handle) const {
-    DxvkQueryData tmpData;
+    DxvkQueryData tmpData = { };
 
-    // Try to copy query data to temporary structure
-    VkResult result = m_vkd->vkGetQueryPoolResults(m_vkd->device(),
-      handle.queryPool, handle.queryId, 1,
-      sizeof(DxvkQueryData), &tmpData,
-      sizeof(DxvkQueryData), VK_QUERY_RESULT_64_BIT);
-    
-    if (result == VK_NOT_READY)
-      return DxvkGpuQueryStatus::Pending;
-    else if (result != VK_SUCCESS)
+    if (!handle.resultData)
       return DxvkGpuQueryStatus::Failed;
+
+    // Results are copied to the result buffer at submission,
+    // and the availability value is written on the host once
+    // the command list has finished executing on the GPU.
+    uint32_t resultCount = DxvkGpuQueryAllocator::getResultCount(m_type);
+
+    if (!reinterpret_cast<const volatile uint64_t*>(handle.resultData)[resultCount])
+      return DxvkGpuQueryStatus::Pending;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::memcpy(&tmpData, handle.resultData, resultCount * sizeof(uint64_t));
     
     // Add numbers to the destination structure
     switch (m_type) {
@@ -154,9 +159,9 @@ namespace dxvk {
 
   
   DxvkGpuQueryAllocator::~DxvkGpuQueryAllocator() {
-    for (VkQueryPool pool : m_pools) {
+    for (const auto& pool : m_pools) {
       m_vkd->vkDestroyQueryPool(
-        m_vkd->device(), pool, nullptr);
+        m_vkd->device(), pool.queryPool, nullptr);
     }
   }
 
@@ -164,21 +169,111 @@ namespace dxvk {
   DxvkGpuQueryHandle DxvkGpuQueryAllocator::allocQuery() {
     std::lock_guard<dxvk::mutex> lock(m_mutex);
 
-    if (m_handles.size() == 0)
+    if (m_freeRanges.empty())
       this->createQueryPool();
 
-    if (m_handles.size() == 0)
+    if (m_freeRanges.empty())
       return DxvkGpuQueryHandle();
     
-    DxvkGpuQueryHandle result = m_handles.back();
-    m_handles.pop_back();
+    // Take queries from the front of the most recently
+    // freed range, so that consecutive allocations
+    // return consecutive queries within the same pool
+    FreeRange& range = m_freeRanges.back();
+    const Pool& pool = m_pools[range.pool];
+
+    DxvkGpuQueryHandle result;
+    result.allocator    = this;
+    result.queryPool    = pool.queryPool;
+    result.queryId      = range.first;
+    result.resultBuffer = pool.slice.handle;
+    result.resultOffset = pool.slice.offset + range.first * ResultStride;
+    result.resultData   = reinterpret_cast<uint64_t*>(
+      reinterpret_cast<char*>(pool.slice.mapPtr) + range.first * ResultStride);
+
+    range.first += 1;
+
+    if (!(--range.count))
+      m_freeRanges.pop_back();
+
+    m_device->addStatCtr(DxvkStatCounter::QueryCountUsed, 1);
     return result;
   }
 
 
   void DxvkGpuQueryAllocator::freeQuery(DxvkGpuQueryHandle handle) {
+    freeQueries(1, &handle);
+  }
+
+
+  void DxvkGpuQueryAllocator::freeQueries(
+          size_t              count,
+          DxvkGpuQueryHandle* handles) {
+    std::sort(handles, handles + count, [] (
+        const DxvkGpuQueryHandle& a,
+        const DxvkGpuQueryHandle& b) {
+      if (a.queryPool != b.queryPool)
+        return a.queryPool < b.queryPool;
+      return a.queryId < b.queryId;
+    });
+
+    // Reset runs of consecutive queries with a single call,
+    // and clear the result so that it reads as unavailable
+    size_t first = 0;
+
     std::lock_guard<dxvk::mutex> lock(m_mutex);
-    m_handles.push_back(handle);
+
+    for (size_t i = 0; i < count; i++) {
+      std::memset(handles[i].resultData, 0, ResultStride);
+
+      if (i + 1 == count
+       || handles[i + 1].queryPool != handles[i].queryPool
+       || handles[i + 1].queryId   != handles[i].queryId + 1) {
+        FreeRange range;
+        range.pool  = findPool(handles[first].queryPool);
+        range.first = handles[first].queryId;
+        range.count = handles[i].queryId - handles[first].queryId + 1;
+
+        resetQueries(handles[first].queryPool, range.first, range.count);
+
+        // Merge with the most recently freed range if possible
+        // so that the free list does not fragment needlessly
+        if (!m_freeRanges.empty()
+         && m_freeRanges.back().pool == range.pool
+         && m_freeRanges.back().first + m_freeRanges.back().count == range.first) {
+          m_freeRanges.back().count += range.count;
+        } else if (!m_freeRanges.empty()
+         && m_freeRanges.back().pool == range.pool
+         && m_freeRanges.back().first == range.first + range.count) {
+          m_freeRanges.back().first = range.first;
+          m_freeRanges.back().count += range.count;
+        } else {
+          m_freeRanges.push_back(range);
+        }
+
+        first = i + 1;
+      }
+    }
+
+    m_device->addStatCtr(DxvkStatCounter::QueryCountUsed, uint64_t(-int64_t(count)));
+  }
+
+
+  uint32_t DxvkGpuQueryAllocator::getResultCount(VkQueryType type) {
+    switch (type) {
+      case VK_QUERY_TYPE_OCCLUSION:                     return 1;
+      case VK_QUERY_TYPE_PIPELINE_STATISTICS:           return 11;
+      case VK_QUERY_TYPE_TIMESTAMP:                     return 1;
+      case VK_QUERY_TYPE_TRANSFORM_FEEDBACK_STREAM_EXT: return 2;
+      default:                                          return 0;
+    }
+  }
+
+
+  void DxvkGpuQueryAllocator::resetQueries(
+          VkQueryPool         pool,
+          uint32_t            first,
+          uint32_t            count) {
+    m_vkd->vkResetQueryPoolEXT(m_vkd->device(), pool, first, count);
   }
 
   
@@ -213,10 +308,52 @@ namespace dxvk {
       return;
     }
 
-    m_pools.push_back(queryPool);
+    DxvkBufferCreateInfo bufferInfo;
+    bufferInfo.size   = m_queryPoolSize * ResultStride;
+    bufferInfo.usage  = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT
+                      | VK_PIPELINE_STAGE_HOST_BIT;
+    bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT
+                      | VK_ACCESS_HOST_READ_BIT;
+
+    Rc<DxvkBuffer> buffer = m_device->createBuffer(bufferInfo,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+      VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+    // Reset the entire pool up front so that queries
+    // never have to be reset inside a command buffer
+    resetQueries(queryPool, 0, m_queryPoolSize);
+
+    Pool pool;
+    pool.queryPool = queryPool;
+    pool.buffer    = buffer;
+    pool.slice     = buffer->getSliceHandle();
+
+    std::memset(pool.slice.mapPtr, 0, pool.slice.length);
+
+    FreeRange range;
+    range.pool  = uint32_t(m_pools.size());
+    range.first = 0;
+    range.count = m_queryPoolSize;
+
+    m_pools.push_back(std::move(pool));
+    m_freeRanges.push_back(range);
+
+    m_device->addStatCtr(DxvkStatCounter::QueryPoolCount, 1);
+    m_device->addStatCtr(DxvkStatCounter::QueryCountAllocated, m_queryPoolSize);
+  }
+
 
-    for (uint32_t i = 0; i < m_queryPoolSize; i++)
-      m_handles.push_back({ this, queryPool, i });
+  uint32_t DxvkGpuQueryAllocator::findPool(
+          VkQueryPool         queryPool) const {
+    // There are only ever a handful of pools per query type
+    for (uint32_t i = 0; i < m_pools.size(); i++) {
+      if (m_pools[i].queryPool == queryPool)
+        return i;
+    }
+
+    return 0;
   }
 
 
@@ -305,16 +442,15 @@ namespace dxvk {
     query->addQueryHandle(handle);
     query->end();
 
-    cmd->resetQuery(
-      handle.queryPool,
-      handle.queryId);
-    
     cmd->cmdWriteTimestamp(
       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
       handle.queryPool,
       handle.queryId);
     
     cmd->trackResource<DxvkAccess::None>(query);
+
+    if (handle.queryPool)
+      m_pendingCopies.push_back(handle);
   }
 
 
@@ -347,10 +483,6 @@ namespace dxvk {
     const Rc<DxvkGpuQuery>&     query) {
     DxvkGpuQueryHandle handle = m_pool->allocQuery(query->type());
     
-    cmd->resetQuery(
-      handle.queryPool,
-      handle.queryId);
-    
     if (query->isIndexed()) {
       cmd->cmdBeginQueryIndexed(
         handle.queryPool,
@@ -385,6 +517,62 @@ namespace dxvk {
     }
 
     cmd->trackResource<DxvkAccess::None>(query);
+
+    if (handle.queryPool)
+      m_pendingCopies.push_back(handle);
+  }
+
+
+  void DxvkGpuQueryManager::copyQueryResults(
+    const Rc<DxvkCommandList>&  cmd) {
+    if (m_pendingCopies.empty())
+      return;
+
+    std::sort(m_pendingCopies.begin(), m_pendingCopies.end(), [] (
+        const DxvkGpuQueryHandle& a,
+        const DxvkGpuQueryHandle& b) {
+      if (a.queryPool != b.queryPool)
+        return a.queryPool < b.queryPool;
+      return a.queryId < b.queryId;
+    });
+
+    // Copy runs of consecutive queries with a single command.
+    // Queries from the same pool share one result buffer.
+    size_t first = 0;
+
+    for (size_t i = 0; i < m_pendingCopies.size(); i++) {
+      const DxvkGpuQueryHandle& handle = m_pendingCopies[i];
+
+      if (i + 1 == m_pendingCopies.size()
+       || m_pendingCopies[i + 1].queryPool != handle.queryPool
+       || m_pendingCopies[i + 1].queryId   != handle.queryId + 1) {
+        const DxvkGpuQueryHandle& base = m_pendingCopies[first];
+
+        cmd->cmdCopyQueryPoolResults(
+          base.queryPool, base.queryId,
+          handle.queryId - base.queryId + 1,
+          base.resultBuffer, base.resultOffset,
+          DxvkGpuQueryAllocator::ResultStride,
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+        first = i + 1;
+      }
+
+      cmd->trackGpuQueryResult(handle);
+    }
+
+    VkMemoryBarrier barrier;
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext         = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    cmd->cmdPipelineBarrier(DxvkCmdBuffer::ExecBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    m_pendingCopies.clear();
   }
   
   
@@ -412,9 +600,41 @@ namespace dxvk {
   }
 
 
+  void DxvkGpuQueryTracker::trackResult(DxvkGpuQueryHandle handle) {
+    m_results.push_back(handle);
+  }
+
+
   void DxvkGpuQueryTracker::reset() {
-    for (DxvkGpuQueryHandle handle : m_handles)
-      handle.allocator->freeQuery(handle);
+    // Mark results as available before any handle gets
+    // recycled, since recycling clears the result data
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (const DxvkGpuQueryHandle& handle : m_results) {
+      uint32_t resultCount = DxvkGpuQueryAllocator::getResultCount(
+        handle.allocator->queryType());
+      reinterpret_cast<volatile uint64_t*>(handle.resultData)[resultCount] = 1;
+    }
+
+    m_results.clear();
+
+    // Return handles to their allocators in batches so that
+    // consecutive queries can be reset with a single call
+    std::sort(m_handles.begin(), m_handles.end(), [] (
+        const DxvkGpuQueryHandle& a,
+        const DxvkGpuQueryHandle& b) {
+      return a.allocator < b.allocator;
+    });
+
+    size_t first = 0;
+
+    for (size_t i = 0; i < m_handles.size(); i++) {
+      if (i + 1 == m_handles.size()
+       || m_handles[i + 1].allocator != m_handles[i].allocator) {
+        m_handles[first].allocator->freeQueries(i - first + 1, &m_handles[first]);
+        first = i + 1;
+      }
+    }
     
     m_handles.clear();
   }
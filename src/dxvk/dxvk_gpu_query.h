@@ -3,6 +3,7 @@
 #include <mutex>
 #include <vector>
 
+#include "dxvk_buffer.h"
 #include "dxvk_resource.h"
 
 namespace dxvk {
@@ -96,14 +97,18 @@ namespace dxvk {
    * \brief Query handle
    * 
    * Stores the query allocator, as well as
-   * the actual pool and query index. Since
-   * query pools have to be reset on the GPU,
-   * this also comes with a reset event.
+   * the actual pool and query index. Query
+   * results get copied to a host-visible
+   * buffer, so that they can be read back
+   * without calling into the driver.
    */
   struct DxvkGpuQueryHandle {
-    DxvkGpuQueryAllocator* allocator  = nullptr;
-    VkQueryPool            queryPool  = VK_NULL_HANDLE;
-    uint32_t               queryId    = 0;
+    DxvkGpuQueryAllocator* allocator    = nullptr;
+    VkQueryPool            queryPool    = VK_NULL_HANDLE;
+    uint32_t               queryId      = 0;
+    VkBuffer               resultBuffer = VK_NULL_HANDLE;
+    VkDeviceSize           resultOffset = 0;
+    uint64_t*              resultData   = nullptr;
   };
 
 
@@ -239,12 +244,20 @@ namespace dxvk {
    * \brief Query allocator
    * 
    * Creates query pools and allocates
-   * queries for a single query type. 
+   * queries for a single query type. Each
+   * query pool comes with a result buffer
+   * that query results get copied to.
    */
   class DxvkGpuQueryAllocator {
 
   public:
 
+    /// Size of a single query result in the result buffer,
+    /// including the availability value after the result.
+    /// The availability value is written on the host once
+    /// the command list that copied the result completes.
+    constexpr static VkDeviceSize ResultStride = sizeof(DxvkQueryData) + sizeof(uint64_t);
+
     DxvkGpuQueryAllocator(
             DxvkDevice*         device,
             VkQueryType         queryType,
@@ -257,7 +270,11 @@ namespace dxvk {
      * 
      * If possible, this returns a free query
      * from an existing query pool. Otherwise,
-     * a new query pool will be created.
+     * a new query pool will be created. Free
+     * queries are tracked as ranges, so that
+     * queries allocated in sequence are likely
+     * to be consecutive and can be reset with
+     * a single call when they are recycled.
      * \returns Query handle
      */
     DxvkGpuQueryHandle allocQuery();
@@ -272,19 +289,70 @@ namespace dxvk {
      */
     void freeQuery(DxvkGpuQueryHandle handle);
 
+    /**
+     * \brief Recycles multiple queries
+     *
+     * Resets consecutive queries from the same
+     * pool with a single call. The handle array
+     * will be sorted.
+     * \param [in] count Number of queries
+     * \param [in] handles Queries to reset
+     */
+    void freeQueries(
+            size_t              count,
+            DxvkGpuQueryHandle* handles);
+
+    /**
+     * \brief Number of result values for a query type
+     *
+     * The availability value is stored right after
+     * the result values in the result buffer.
+     * \param [in] type Query type
+     * \returns Number of 64-bit result values
+     */
+    static uint32_t getResultCount(VkQueryType type);
+
+    /**
+     * \brief Query type
+     * \returns Query type
+     */
+    VkQueryType queryType() const {
+      return m_queryType;
+    }
+
   private:
 
+    struct Pool {
+      VkQueryPool           queryPool;
+      Rc<DxvkBuffer>        buffer;
+      DxvkBufferSliceHandle slice;
+    };
+
+    struct FreeRange {
+      uint32_t pool;
+      uint32_t first;
+      uint32_t count;
+    };
+
     DxvkDevice*       m_device;
     Rc<vk::DeviceFn>  m_vkd;
     VkQueryType       m_queryType;
     uint32_t          m_queryPoolSize;
     
     dxvk::mutex                     m_mutex;
-    std::vector<DxvkGpuQueryHandle> m_handles;
-    std::vector<VkQueryPool>        m_pools;
+    std::vector<Pool>               m_pools;
+    std::vector<FreeRange>          m_freeRanges;
 
     void createQueryPool();
 
+    uint32_t findPool(
+            VkQueryPool         queryPool) const;
+
+    void resetQueries(
+            VkQueryPool         pool,
+            uint32_t            first,
+            uint32_t            count);
+
   };
 
 
@@ -393,11 +461,24 @@ namespace dxvk {
       const Rc<DxvkCommandList>&  cmd,
             VkQueryType           type);
 
+    /**
+     * \brief Copies query results to result buffers
+     *
+     * Must be called outside of a render pass before
+     * submitting the command list. Copies the results
+     * of all queries that ended in this command list,
+     * so that they can be read from host memory.
+     * \param [in] cmd Command list
+     */
+    void copyQueryResults(
+      const Rc<DxvkCommandList>&  cmd);
+
   private:
 
     DxvkGpuQueryPool*             m_pool;
     uint32_t                      m_activeTypes;
     std::vector<Rc<DxvkGpuQuery>> m_activeQueries;
+    std::vector<DxvkGpuQueryHandle> m_pendingCopies;
 
     void beginSingleQuery(
       const Rc<DxvkCommandList>&  cmd,
@@ -432,17 +513,28 @@ namespace dxvk {
      */
     void trackQuery(DxvkGpuQueryHandle handle);
 
+    /**
+     * \brief Tracks a copied query result
+     *
+     * The result will be marked as available
+     * once the command list has finished.
+     * \param [in] handle Query handle
+     */
+    void trackResult(DxvkGpuQueryHandle handle);
+
     /**
      * \brief Recycles all tracked handles
      * 
-     * Releases all tracked query handles
-     * to their respective query allocator.
+     * Marks all copied query results as available,
+     * and releases all tracked query handles to
+     * their respective query allocator.
      */
     void reset();
 
   private:
 
     std::vector<DxvkGpuQueryHandle> m_handles;
+    std::vector<DxvkGpuQueryHandle> m_results;
 
   };
 }
\ No newline at end of file
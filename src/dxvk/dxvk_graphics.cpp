@@ -8,13 +8,296 @@
 
 namespace dxvk {
 
+  DxvkGraphicsPipelineVertexInputState::DxvkGraphicsPipelineVertexInputState(
+    const DxvkDevice*                       device,
+    const DxvkGraphicsPipelineStateInfo&    state) {
+    // Generate per-instance attribute divisors
+    uint32_t viDivisorCount = 0;
+
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
+      if (state.ilBindings[i].inputRate() == VK_VERTEX_INPUT_RATE_INSTANCE
+       && state.ilBindings[i].divisor()   != 1) {
+        const uint32_t id = viDivisorCount++;
+        
+        viDivisors[id].binding = i; /* see below */
+        viDivisors[id].divisor = state.ilBindings[i].divisor();
+      }
+    }
+
+    // Compact vertex bindings so that we can more easily update vertex buffers
+    std::array<uint32_t, MaxNumVertexBindings> viBindingMap = { };
+
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
+      viBindings[i] = state.ilBindings[i].description();
+      viBindings[i].binding = i;
+      viBindingMap[state.ilBindings[i].binding()] = i;
+    }
+
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++) {
+      viAttributes[i] = state.ilAttributes[i].description();
+      viAttributes[i].binding = viBindingMap[state.ilAttributes[i].binding()];
+    }
+
+    viDivisorInfo.vertexBindingDivisorCount = viDivisorCount;
+    viDivisorInfo.pVertexBindingDivisors    = viDivisors.data();
+    
+    viInfo.vertexBindingDescriptionCount    = state.il.bindingCount();
+    viInfo.pVertexBindingDescriptions       = viBindings.data();
+    viInfo.vertexAttributeDescriptionCount  = state.il.attributeCount();
+    viInfo.pVertexAttributeDescriptions     = viAttributes.data();
+
+    // TODO remove this once the extension is widely supported
+    if (viDivisorCount && device->features().extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor)
+      viInfo.pNext = &viDivisorInfo;
+
+    iaInfo.topology               = state.ia.primitiveTopology();
+    iaInfo.primitiveRestartEnable = state.ia.primitiveRestart();
+  }
+
+
+  DxvkGraphicsPipelineFragmentOutputState::DxvkGraphicsPipelineFragmentOutputState(
+    const DxvkDevice*                       device,
+    const DxvkGraphicsPipelineStateInfo&    state,
+          uint32_t                          fsOutputMask,
+          bool                              fsSampleShading) {
+    // Fix up color write masks using the component mappings
+    VkFormat rtDepthFormat = state.rt.getDepthStencilFormat();
+    auto rtDepthFormatInfo = imageFormatInfo(rtDepthFormat);
+
+    uint32_t rtColorFormatCount = 0;
+
+    const VkColorComponentFlags fullMask
+      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+      | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      rtColorFormats[i] = state.rt.getColorFormat(i);
+
+      if (rtColorFormats[i]) {
+        rtColorFormatCount = i + 1;
+
+        auto formatInfo = imageFormatInfo(rtColorFormats[i]);
+        cbAttachments[i] = state.omBlend[i].state();
+
+        if (!(fsOutputMask & (1 << i)) || !formatInfo) {
+          cbAttachments[i].colorWriteMask = 0;
+        } else {
+          if (cbAttachments[i].colorWriteMask != fullMask) {
+            cbAttachments[i].colorWriteMask = util::remapComponentMask(
+              state.omBlend[i].colorWriteMask(), state.omSwizzle[i].mapping());
+          }
+
+          cbAttachments[i].colorWriteMask &= formatInfo->componentMask;
+
+          if (cbAttachments[i].colorWriteMask == formatInfo->componentMask)
+            cbAttachments[i].colorWriteMask = fullMask;
+        }
+      }
+    }
+
+    if (rtColorFormatCount) {
+      rtInfo.colorAttachmentCount = rtColorFormatCount;
+      rtInfo.pColorAttachmentFormats = rtColorFormats.data();
+    }
+
+    if (rtDepthFormat) {
+      if (rtDepthFormatInfo->aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
+        rtInfo.depthAttachmentFormat = rtDepthFormat;
+
+      if (rtDepthFormatInfo->aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
+        rtInfo.stencilAttachmentFormat = rtDepthFormat;
+    }
+
+    cbInfo.logicOpEnable          = state.om.enableLogicOp();
+    cbInfo.logicOp                = state.om.logicOp();
+    cbInfo.attachmentCount        = rtColorFormatCount;
+    cbInfo.pAttachments           = cbAttachments.data();
+
+    // Figure out the actual sample count to use
+    VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+
+    if (state.ms.sampleCount())
+      sampleCount = VkSampleCountFlagBits(state.ms.sampleCount());
+    else if (state.rs.sampleCount())
+      sampleCount = VkSampleCountFlagBits(state.rs.sampleCount());
+
+    msSampleMask = state.ms.sampleMask();
+
+    msInfo.rasterizationSamples   = sampleCount;
+    msInfo.sampleShadingEnable    = fsSampleShading;
+    msInfo.minSampleShading       = 1.0f;
+    msInfo.pSampleMask            = &msSampleMask;
+    msInfo.alphaToCoverageEnable  = state.ms.enableAlphaToCoverage();
+    msInfo.alphaToOneEnable       = VK_FALSE;
+  }
+
+
+  DxvkGraphicsPipelineVertexInputKey::DxvkGraphicsPipelineVertexInputKey(
+    const DxvkGraphicsPipelineStateInfo&    state) {
+    this->state.ia = state.ia;
+    this->state.il = state.il;
+
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++)
+      this->state.ilAttributes[i] = state.ilAttributes[i];
+
+    for (uint32_t i = 0; i < state.il.bindingCount(); i++)
+      this->state.ilBindings[i] = state.ilBindings[i];
+  }
+
+
+  size_t DxvkGraphicsPipelineVertexInputKey::hash() const {
+    DxvkHashState hash;
+
+    std::array<uint32_t, sizeof(state) / sizeof(uint32_t)> dwords;
+    std::memcpy(dwords.data(), &state, sizeof(state));
+
+    for (uint32_t dword : dwords)
+      hash.add(dword);
+
+    return hash;
+  }
+
+
+  DxvkGraphicsPipelineFragmentOutputKey::DxvkGraphicsPipelineFragmentOutputKey(
+    const DxvkGraphicsPipelineStateInfo&    state,
+          uint32_t                          fsOutputMask)
+  : fsOutputMask(fsOutputMask) {
+    this->state.rs = DxvkRsInfo(VK_FALSE, VK_FALSE,
+      VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
+      VK_FRONT_FACE_COUNTER_CLOCKWISE, state.rs.sampleCount(),
+      VK_CONSERVATIVE_RASTERIZATION_MODE_DISABLED_EXT);
+    this->state.ms = state.ms;
+    this->state.om = state.om;
+    this->state.rt = state.rt;
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      if (state.rt.getColorFormat(i)) {
+        this->state.omBlend[i] = state.omBlend[i];
+        this->state.omSwizzle[i] = state.omSwizzle[i];
+      }
+    }
+  }
+
+
+  size_t DxvkGraphicsPipelineFragmentOutputKey::hash() const {
+    DxvkHashState hash;
+
+    std::array<uint32_t, sizeof(state) / sizeof(uint32_t)> dwords;
+    std::memcpy(dwords.data(), &state, sizeof(state));
+
+    for (uint32_t dword : dwords)
+      hash.add(dword);
+
+    hash.add(fsOutputMask);
+    return hash;
+  }
+
+
+  DxvkGraphicsPipelineVertexInputLibrary::DxvkGraphicsPipelineVertexInputLibrary(
+          DxvkDevice*                         device,
+          VkPipelineCache                     cache,
+    const DxvkGraphicsPipelineVertexInputKey& key)
+  : m_device(device) {
+    auto vk = m_device->vkd();
+
+    DxvkGraphicsPipelineVertexInputState viState(device, key.state);
+
+    // Set up dynamic vertex input state if supported
+    std::array<VkDynamicState, 2> dynamicStates;
+    uint32_t                      dynamicStateCount = 0;
+
+    if (device->features().extExtendedDynamicState2.extendedDynamicState2)
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT;
+
+    if (device->features().extVertexInputDynamicState.vertexInputDynamicState)
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_VERTEX_INPUT_EXT;
+
+    VkPipelineDynamicStateCreateInfo dyInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dyInfo.dynamicStateCount      = dynamicStateCount;
+    dyInfo.pDynamicStates         = dynamicStates.data();
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT };
+    libInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &libInfo };
+    info.flags                    = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    info.pVertexInputState        = &viState.viInfo;
+    info.pInputAssemblyState      = &viState.iaInfo;
+    info.pDynamicState            = &dyInfo;
+    info.basePipelineIndex        = -1;
+
+    if (device->features().extVertexInputDynamicState.vertexInputDynamicState)
+      info.pVertexInputState = nullptr;
+
+    if (vk->vkCreateGraphicsPipelines(vk->device(), cache, 1, &info, nullptr, &m_pipeline))
+      Logger::err("DxvkGraphicsPipelineVertexInputLibrary: Failed to create vertex input pipeline library");
+  }
+
+
+  DxvkGraphicsPipelineVertexInputLibrary::~DxvkGraphicsPipelineVertexInputLibrary() {
+    auto vk = m_device->vkd();
+
+    vk->vkDestroyPipeline(vk->device(), m_pipeline, nullptr);
+  }
+
+
+  DxvkGraphicsPipelineFragmentOutputLibrary::DxvkGraphicsPipelineFragmentOutputLibrary(
+          DxvkDevice*                             device,
+          VkPipelineCache                         cache,
+    const DxvkGraphicsPipelineFragmentOutputKey&  key)
+  : m_device(device) {
+    auto vk = m_device->vkd();
+
+    DxvkGraphicsPipelineFragmentOutputState foState(device, key.state, key.fsOutputMask, false);
+
+    // Blend constants and the logic op are the only dynamic fragment output state
+    std::array<VkDynamicState, 2> dynamicStates;
+    uint32_t                      dynamicStateCount = 0;
+
+    if (key.state.useDynamicBlendConstants())
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_BLEND_CONSTANTS;
+
+    if (device->features().extExtendedDynamicState2.extendedDynamicState2LogicOp)
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_LOGIC_OP_EXT;
+
+    VkPipelineDynamicStateCreateInfo dyInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dyInfo.dynamicStateCount      = dynamicStateCount;
+    dyInfo.pDynamicStates         = dynamicStates.data();
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, &foState.rtInfo };
+    libInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &libInfo };
+    info.flags                    = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    info.pColorBlendState         = &foState.cbInfo;
+    info.pMultisampleState        = &foState.msInfo;
+    info.pDynamicState            = &dyInfo;
+    info.basePipelineIndex        = -1;
+
+    if (vk->vkCreateGraphicsPipelines(vk->device(), cache, 1, &info, nullptr, &m_pipeline))
+      Logger::err("DxvkGraphicsPipelineFragmentOutputLibrary: Failed to create fragment output pipeline library");
+  }
+
+
+  DxvkGraphicsPipelineFragmentOutputLibrary::~DxvkGraphicsPipelineFragmentOutputLibrary() {
+    auto vk = m_device->vkd();
+
+    vk->vkDestroyPipeline(vk->device(), m_pipeline, nullptr);
+  }
+
+
   DxvkGraphicsPipeline::DxvkGraphicsPipeline(
           DxvkPipelineManager*        pipeMgr,
           DxvkGraphicsPipelineShaders shaders,
-          DxvkBindingLayoutObjects*   layout)
+          DxvkBindingLayoutObjects*   layout,
+          DxvkShaderPipelineLibrary*  vsLibrary,
+          DxvkShaderPipelineLibrary*  fsLibrary)
   : m_vkd(pipeMgr->m_device->vkd()), m_pipeMgr(pipeMgr),
     m_shaders(std::move(shaders)), m_bindings(layout),
+    m_vsLibrary(vsLibrary), m_fsLibrary(fsLibrary),
     m_barrier(layout->getGlobalBarrier()) {
+    sync::setLockName(m_mutex, "DxvkGraphicsPipeline");
+
     m_vsIn  = m_shaders.vs != nullptr ? m_shaders.vs->info().inputMask  : 0;
     m_fsOut = m_shaders.fs != nullptr ? m_shaders.fs->info().outputMask : 0;
 
@@ -37,8 +320,13 @@ namespace dxvk {
   
   
   DxvkGraphicsPipeline::~DxvkGraphicsPipeline() {
-    for (const auto& instance : m_pipelines)
-      this->destroyPipeline(instance.pipeline());
+    for (const auto& instance : m_pipelines) {
+      this->destroyPipeline(instance.baseHandle());
+      this->destroyPipeline(instance.fastHandle());
+    }
+
+    for (const auto& pair : m_genericPipelines)
+      this->destroyPipeline(pair.second);
   }
   
   
@@ -69,100 +357,388 @@ namespace dxvk {
   }
 
 
-  VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
-    const DxvkGraphicsPipelineStateInfo& state) {
-    DxvkGraphicsPipelineInstance* instance = this->findInstance(state);
+  std::pair<VkPipeline, DxvkGraphicsPipelineType> DxvkGraphicsPipeline::getPipelineHandle(
+    const DxvkGraphicsPipelineStateInfo& appState) {
+    DxvkGraphicsPipelineStateInfo state = this->normalizePipelineState(appState);
+    size_t stateHash = state.hash();
+
+    DxvkGraphicsPipelineInstance* instance = this->findInstance(state, stateHash);
 
     if (unlikely(!instance)) {
       // Exit early if the state vector is invalid
       if (!this->validatePipelineState(state, true))
-        return VK_NULL_HANDLE;
+        return std::make_pair(VK_NULL_HANDLE, DxvkGraphicsPipelineType::FastPipeline);
 
       // Prevent other threads from adding new instances and check again
       std::lock_guard<dxvk::mutex> lock(m_mutex);
-      instance = this->findInstance(state);
+      instance = this->findInstance(state, stateHash);
 
       if (!instance) {
         // Keep pipeline object locked, at worst we're going to stall
         // a state cache worker and the current thread needs priority.
-        instance = this->createInstance(state);
+        bool canCreateBasePipeline = this->canCreateBasePipeline(state);
+        VkPipeline genericHandle = VK_NULL_HANDLE;
+
+        if (!canCreateBasePipeline && this->canUseGenericPipeline(state))
+          genericHandle = this->getGenericPipeline(state);
+
+        if (genericHandle) {
+          // Draw using the unspecialized pipeline, which reads spec
+          // constants from memory, until the optimized one is ready
+          m_pipeMgr->m_numGraphicsPipelines += 1;
+          instance = this->insertInstance(state, stateHash, VK_NULL_HANDLE, VK_NULL_HANDLE, genericHandle);
+          m_pipeMgr->m_workers.compileGraphicsPipeline(this, state, DxvkPipelinePriority::Normal);
+        } else if (!canCreateBasePipeline && m_pipeMgr->m_device->config().enableAsync) {
+          // Add an instance without any pipeline handles, draws using
+          // it will be skipped until the pipeline workers compiled it
+          m_pipeMgr->m_numGraphicsPipelines += 1;
+          instance = this->insertInstance(state, stateHash, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE);
+          m_pipeMgr->m_workers.compileGraphicsPipeline(this, state, DxvkPipelinePriority::High);
+        } else {
+          // Let background work yield while the calling
+          // thread is stalled on a full pipeline compile
+          if (!canCreateBasePipeline)
+            m_pipeMgr->m_workers.beginBlockingCompile();
+
+          auto t0 = dxvk::high_resolution_clock::now();
+          instance = this->createInstance(state, stateHash, canCreateBasePipeline);
+          auto t1 = dxvk::high_resolution_clock::now();
+
+          if (!canCreateBasePipeline)
+            m_pipeMgr->m_workers.endBlockingCompile();
+
+          m_pipeMgr->recordCompile(this, DxvkPipelineCompileType::Blocking,
+            std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+
+          // Unlike base pipelines, fast pipelines can be compiled in
+          // the background, so defer them to the pipeline workers
+          if (instance->baseHandle())
+            m_pipeMgr->m_workers.compileGraphicsPipeline(this, state, DxvkPipelinePriority::Normal);
+        }
+
         this->writePipelineStateToCache(state);
       }
     }
 
-    return instance->pipeline();
+    // Use the optimized pipeline as soon as it becomes available
+    VkPipeline fastHandle = instance->fastHandle();
+
+    if (likely(fastHandle != VK_NULL_HANDLE))
+      return std::make_pair(fastHandle, DxvkGraphicsPipelineType::FastPipeline);
+
+    // Generic pipelines are monolithic and use the same
+    // pipeline layout and dynamic state as fast pipelines
+    VkPipeline genericHandle = instance->genericHandle();
+
+    if (genericHandle != VK_NULL_HANDLE)
+      return std::make_pair(genericHandle, DxvkGraphicsPipelineType::FastPipeline);
+
+    return std::make_pair(instance->baseHandle(), DxvkGraphicsPipelineType::BasePipeline);
   }
 
 
   void DxvkGraphicsPipeline::compilePipeline(
-    const DxvkGraphicsPipelineStateInfo& state) {
+    const DxvkGraphicsPipelineStateInfo& appState) {
     // Exit early if the state vector is invalid
-    if (!this->validatePipelineState(state, false))
+    if (!this->validatePipelineState(appState, false))
       return;
 
-    // Keep the object locked while compiling a pipeline since compiling
-    // similar pipelines concurrently is fragile on some drivers
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    // State coming from the state cache may not be normalized yet
+    DxvkGraphicsPipelineStateInfo state = this->normalizePipelineState(appState);
+    size_t stateHash = state.hash();
+
+    DxvkGraphicsPipelineInstance* instance = this->findInstance(state, stateHash);
 
-    if (!this->findInstance(state))
-      this->createInstance(state);
+    if (!instance) {
+      // Keep the object locked while compiling a pipeline since compiling
+      // similar pipelines concurrently is fragile on some drivers
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (!this->findInstance(state, stateHash)) {
+        auto t0 = dxvk::high_resolution_clock::now();
+        this->createInstance(state, stateHash, false);
+        auto t1 = dxvk::high_resolution_clock::now();
+
+        m_pipeMgr->recordCompile(this, DxvkPipelineCompileType::Background,
+          std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+      }
+
+      return;
+    }
+
+    // An instance with a linked pipeline already exists, so compile
+    // the optimized pipeline without blocking the rendering thread
+    if (!instance->beginCompile())
+      return;
+
+    auto t0 = dxvk::high_resolution_clock::now();
+    VkPipeline pipeline = this->createOptimizedPipeline(state);
+    auto t1 = dxvk::high_resolution_clock::now();
+
+    instance->setFastHandle(pipeline);
+
+    m_pipeMgr->recordCompile(this, DxvkPipelineCompileType::Background,
+      std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
   }
 
 
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
-    const DxvkGraphicsPipelineStateInfo& state) {
-    VkPipeline pipeline = this->createPipeline(state);
+    const DxvkGraphicsPipelineStateInfo& state,
+          size_t                         stateHash,
+          bool                           doCreateBasePipeline) {
+    VkPipeline baseHandle = VK_NULL_HANDLE;
+    VkPipeline fastHandle = VK_NULL_HANDLE;
+
+    if (doCreateBasePipeline)
+      baseHandle = this->createBasePipeline(state);
+
+    // Fall back to compiling an optimized pipeline right
+    // away if linking the base pipeline is not possible
+    if (!baseHandle)
+      fastHandle = this->createOptimizedPipeline(state);
 
     m_pipeMgr->m_numGraphicsPipelines += 1;
-    return &(*m_pipelines.emplace(state, pipeline));
+    return this->insertInstance(state, stateHash, baseHandle, fastHandle, VK_NULL_HANDLE);
   }
   
   
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::insertInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+          size_t                         stateHash,
+          VkPipeline                     baseHandle,
+          VkPipeline                     fastHandle,
+          VkPipeline                     genericHandle) {
+    DxvkGraphicsPipelineInstance* instance = &(*m_pipelines.emplace(
+      state, stateHash, baseHandle, fastHandle, genericHandle));
+
+    // Only called with the pipeline lock held, so we do not need
+    // to worry about concurrent insertions into the same bucket
+    auto& bucket = m_buckets[stateHash % InstanceBucketCount];
+
+    instance->setNext(bucket.load(std::memory_order_relaxed));
+    bucket.store(instance, std::memory_order_release);
+    return instance;
+  }
+
+
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
-    const DxvkGraphicsPipelineStateInfo& state) {
-    for (auto& instance : m_pipelines) {
-      if (instance.isCompatible(state))
-        return &instance;
+    const DxvkGraphicsPipelineStateInfo& state,
+          size_t                         stateHash) const {
+    auto& bucket = m_buckets[stateHash % InstanceBucketCount];
+
+    for (auto instance = bucket.load(std::memory_order_acquire); instance; instance = instance->next()) {
+      if (instance->isCompatible(state, stateHash))
+        return instance;
     }
     
     return nullptr;
   }
   
   
-  VkPipeline DxvkGraphicsPipeline::createPipeline(
+  bool DxvkGraphicsPipeline::canCreateBasePipeline(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    if (!m_vsLibrary || !m_fsLibrary)
+      return false;
+
+    // Vertex input must be compatible with the vertex shader,
+    // since we cannot eliminate undefined inputs at link time
+    uint32_t providedInputs = 0;
+
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++)
+      providedInputs |= 1u << state.ilAttributes[i].location();
+
+    if ((providedInputs & m_vsIn) != m_vsIn)
+      return false;
+
+    // Rasterization state that is not dynamic in the
+    // pre-rasterization library must use the defaults
+    if (state.rs.polygonMode() != VK_POLYGON_MODE_FILL
+     || state.rs.conservativeMode() != VK_CONSERVATIVE_RASTERIZATION_MODE_DISABLED_EXT
+     || !state.rs.depthClipEnable())
+      return false;
+
+    // Dual-source blending requires patching the fragment shader
+    if (state.omBlend[0].blendEnable() && (
+        util::isDualSourceBlendFactor(state.omBlend[0].srcColorBlendFactor()) ||
+        util::isDualSourceBlendFactor(state.omBlend[0].dstColorBlendFactor()) ||
+        util::isDualSourceBlendFactor(state.omBlend[0].srcAlphaBlendFactor()) ||
+        util::isDualSourceBlendFactor(state.omBlend[0].dstAlphaBlendFactor())))
+      return false;
+
+    // Libraries are compiled without specialization constants,
+    // so all spec constants must use their default values unless
+    // the shaders can read them from a uniform buffer instead
+    bool hasSpecConstantFallback =
+      m_shaders.vs->flags().test(DxvkShaderFlag::HasSpecConstantFallback) &&
+      m_shaders.fs->flags().test(DxvkShaderFlag::HasSpecConstantFallback);
+
+    if (!hasSpecConstantFallback) {
+      for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
+        if (state.sc.specConstants[i])
+          return false;
+      }
+    }
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      if ((m_fsOut & (1u << i)) && state.rt.getColorFormat(i)) {
+        const auto& swizzle = state.omSwizzle[i];
+
+        if (swizzle.rIndex() != 0 || swizzle.gIndex() != 1
+         || swizzle.bIndex() != 2 || swizzle.aIndex() != 3)
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  bool DxvkGraphicsPipeline::canUseGenericPipeline(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    if (!m_shaders.vs || !m_shaders.fs)
+      return false;
+
+    if (!m_shaders.vs->flags().test(DxvkShaderFlag::HasSpecConstantFallback)
+     || !m_shaders.fs->flags().test(DxvkShaderFlag::HasSpecConstantFallback))
+      return false;
+
+    // Other stages would be compiled without specialization
+    // and cannot read spec constants from memory
+    if (m_shaders.tcs || m_shaders.tes || m_shaders.gs)
+      return false;
+
+    // If all spec constants use their default value, the
+    // optimized pipeline is no more expensive to compile
+    for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
+      if (state.sc.specConstants[i])
+        return true;
+    }
+
+    return false;
+  }
+
+
+  VkPipeline DxvkGraphicsPipeline::getGenericPipeline(
+    const DxvkGraphicsPipelineStateInfo& state) {
+    DxvkGraphicsPipelineStateInfo genericState = state;
+    genericState.sc = DxvkScInfo();
+
+    auto entry = m_genericPipelines.find(genericState);
+
+    if (entry != m_genericPipelines.end())
+      return entry->second;
+
+    m_pipeMgr->m_workers.beginBlockingCompile();
+
+    auto t0 = dxvk::high_resolution_clock::now();
+    VkPipeline pipeline = this->createOptimizedPipeline(genericState, false);
+    auto t1 = dxvk::high_resolution_clock::now();
+
+    m_pipeMgr->m_workers.endBlockingCompile();
+
+    m_pipeMgr->recordCompile(this, DxvkPipelineCompileType::Blocking,
+      std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+
+    if (pipeline)
+      m_genericPipelines.insert({ genericState, pipeline });
+
+    return pipeline;
+  }
+
+
+  VkPipeline DxvkGraphicsPipeline::createBasePipeline(
     const DxvkGraphicsPipelineStateInfo& state) const {
+    DXVK_TRACE_SCOPE("DxvkGraphicsPipeline::createBasePipeline");
+
+    VkPipeline vsLibrary = m_vsLibrary->getPipelineHandle();
+    VkPipeline fsLibrary = m_fsLibrary->getPipelineHandle();
+
+    if (!vsLibrary || !fsLibrary)
+      return VK_NULL_HANDLE;
+
+    auto viLibrary = m_pipeMgr->createVertexInputLibrary(
+      DxvkGraphicsPipelineVertexInputKey(state));
+    auto foLibrary = m_pipeMgr->createFragmentOutputLibrary(
+      DxvkGraphicsPipelineFragmentOutputKey(state, m_fsOut));
+
+    if (!viLibrary->getHandle() || !foLibrary->getHandle())
+      return VK_NULL_HANDLE;
+
+    std::array<VkPipeline, 4> libraries = {{
+      viLibrary->getHandle(), vsLibrary,
+      fsLibrary, foLibrary->getHandle(),
+    }};
+
+    VkPipelineLibraryCreateInfoKHR libInfo = { VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR };
+    libInfo.libraryCount          = libraries.size();
+    libInfo.pLibraries            = libraries.data();
+
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &libInfo };
+    info.layout                   = m_bindings->getPipelineLayout(true);
+    info.basePipelineIndex        = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
+      Logger::err("DxvkGraphicsPipeline: Failed to link pipeline");
+      this->logPipelineState(LogLevel::Error, state);
+      return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+  }
+
+
+  VkPipeline DxvkGraphicsPipeline::createOptimizedPipeline(
+    const DxvkGraphicsPipelineStateInfo& state,
+          bool                           specialize) const {
+    DXVK_TRACE_SCOPE("DxvkGraphicsPipeline::createOptimizedPipeline");
+
     if (Logger::logLevel() <= LogLevel::Debug) {
       Logger::debug("Compiling graphics pipeline...");
       this->logPipelineState(LogLevel::Debug, state);
     }
 
-    // Set up dynamic states as needed
-    std::array<VkDynamicState, 6> dynamicStates;
-    uint32_t                      dynamicStateCount = 0;
+    const auto& features = m_pipeMgr->m_device->features();
+
+    // Set up dynamic states as needed. Rasterizer and depth-stencil
+    // state that was normalized away is always dynamic, so that the
+    // same pipeline can be used regardless of its values.
+    std::array<VkDynamicState, 20> dynamicStates;
+    uint32_t                       dynamicStateCount = 0;
     
     dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT;
     dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_CULL_MODE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_FRONT_FACE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BOUNDS;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_OP_EXT;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_WRITE_MASK;
+    dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_REFERENCE;
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2) {
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT;
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT;
+    }
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2LogicOp)
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_LOGIC_OP_EXT;
 
-    if (state.useDynamicDepthBias())
+    if (features.extVertexInputDynamicState.vertexInputDynamicState)
+      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_VERTEX_INPUT_EXT;
+
+    if (state.useDynamicDepthBias() || features.extExtendedDynamicState2.extendedDynamicState2)
       dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS;
     
-    if (state.useDynamicDepthBounds())
-      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BOUNDS;
-    
     if (state.useDynamicBlendConstants())
       dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_BLEND_CONSTANTS;
-    
-    if (state.useDynamicStencilRef())
-      dynamicStates[dynamicStateCount++] = VK_DYNAMIC_STATE_STENCIL_REFERENCE;
-
-    // Figure out the actual sample count to use
-    VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
 
-    if (state.ms.sampleCount())
-      sampleCount = VkSampleCountFlagBits(state.ms.sampleCount());
-    else if (state.rs.sampleCount())
-      sampleCount = VkSampleCountFlagBits(state.rs.sampleCount());
-    
     // Set up some specialization constants
     DxvkSpecConstants specData;
 
@@ -176,6 +752,9 @@ namespace dxvk {
 
     for (uint32_t i = 0; i < MaxNumSpecConstants; i++)
       specData.set(getSpecId(i), state.sc.specConstants[i], 0u);
+
+    // Unspecialized pipelines read spec constants from memory
+    specData.set(uint32_t(DxvkSpecConstantId::SpecConstantsOptimized), specialize ? 1u : 0u, 0u);
     
     VkSpecializationInfo specInfo = specData.getSpecInfo();
     
@@ -185,6 +764,13 @@ namespace dxvk {
     auto gsm  = createShaderModule(m_shaders.gs,  state);
     auto fsm  = createShaderModule(m_shaders.fs,  state);
 
+    if ((m_shaders.vs  != nullptr && !vsm)
+     || (m_shaders.tcs != nullptr && !tcsm)
+     || (m_shaders.tes != nullptr && !tesm)
+     || (m_shaders.gs  != nullptr && !gsm)
+     || (m_shaders.fs  != nullptr && !fsm))
+      return VK_NULL_HANDLE;
+
     std::vector<VkPipelineShaderStageCreateInfo> stages;
     if (vsm)  stages.push_back(vsm.stageInfo(&specInfo));
     if (tcsm) stages.push_back(tcsm.stageInfo(&specInfo));
@@ -192,101 +778,16 @@ namespace dxvk {
     if (gsm)  stages.push_back(gsm.stageInfo(&specInfo));
     if (fsm)  stages.push_back(fsm.stageInfo(&specInfo));
 
-    // Fix up color write masks using the component mappings
-    VkImageAspectFlags rtReadOnlyAspects = state.rt.getDepthStencilReadOnlyAspects();
-    VkFormat rtDepthFormat = state.rt.getDepthStencilFormat();
-    auto rtDepthFormatInfo = imageFormatInfo(rtDepthFormat);
-
-    std::array<VkPipelineColorBlendAttachmentState, MaxNumRenderTargets> omBlendAttachments = { };
-    std::array<VkFormat, DxvkLimits::MaxNumRenderTargets> rtColorFormats;
-    uint32_t rtColorFormatCount = 0;
-
-    const VkColorComponentFlags fullMask
-      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
-      | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-      rtColorFormats[i] = state.rt.getColorFormat(i);
-
-      if (rtColorFormats[i]) {
-        rtColorFormatCount = i + 1;
-
-        auto formatInfo = imageFormatInfo(rtColorFormats[i]);
-        omBlendAttachments[i] = state.omBlend[i].state();
-
-        if (!(m_fsOut & (1 << i)) || !formatInfo) {
-          omBlendAttachments[i].colorWriteMask = 0;
-        } else {
-          if (omBlendAttachments[i].colorWriteMask != fullMask) {
-            omBlendAttachments[i].colorWriteMask = util::remapComponentMask(
-              state.omBlend[i].colorWriteMask(), state.omSwizzle[i].mapping());
-          }
-
-          omBlendAttachments[i].colorWriteMask &= formatInfo->componentMask;
-
-          if (omBlendAttachments[i].colorWriteMask == formatInfo->componentMask) {
-            omBlendAttachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
-                                                 | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-          }
-        }
-      }
-    }
-
-    // Generate per-instance attribute divisors
-    std::array<VkVertexInputBindingDivisorDescriptionEXT, MaxNumVertexBindings> viDivisorDesc;
-    uint32_t                                                                    viDivisorCount = 0;
+    DxvkGraphicsPipelineVertexInputState viState(m_pipeMgr->m_device, state);
+    DxvkGraphicsPipelineFragmentOutputState foState(m_pipeMgr->m_device, state,
+      m_fsOut, m_common.msSampleShadingEnable);
 
-    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
-      if (state.ilBindings[i].inputRate() == VK_VERTEX_INPUT_RATE_INSTANCE
-       && state.ilBindings[i].divisor()   != 1) {
-        const uint32_t id = viDivisorCount++;
-        
-        viDivisorDesc[id].binding = i; /* see below */
-        viDivisorDesc[id].divisor = state.ilBindings[i].divisor();
-      }
-    }
+    VkImageAspectFlags rtReadOnlyAspects = state.rt.getDepthStencilReadOnlyAspects();
 
     int32_t rasterizedStream = m_shaders.gs != nullptr
       ? m_shaders.gs->info().xfbRasterizedStream
       : 0;
     
-    // Compact vertex bindings so that we can more easily update vertex buffers
-    std::array<VkVertexInputAttributeDescription, MaxNumVertexAttributes> viAttribs;
-    std::array<VkVertexInputBindingDescription,   MaxNumVertexBindings>   viBindings;
-    std::array<uint32_t,                          MaxNumVertexBindings>   viBindingMap = { };
-
-    for (uint32_t i = 0; i < state.il.bindingCount(); i++) {
-      viBindings[i] = state.ilBindings[i].description();
-      viBindings[i].binding = i;
-      viBindingMap[state.ilBindings[i].binding()] = i;
-    }
-
-    for (uint32_t i = 0; i < state.il.attributeCount(); i++) {
-      viAttribs[i] = state.ilAttributes[i].description();
-      viAttribs[i].binding = viBindingMap[state.ilAttributes[i].binding()];
-    }
-
-    VkPipelineVertexInputDivisorStateCreateInfoEXT viDivisorInfo = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT };
-    viDivisorInfo.vertexBindingDivisorCount = viDivisorCount;
-    viDivisorInfo.pVertexBindingDivisors    = viDivisorDesc.data();
-    
-    VkPipelineVertexInputStateCreateInfo viInfo = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO, &viDivisorInfo };
-    viInfo.vertexBindingDescriptionCount    = state.il.bindingCount();
-    viInfo.pVertexBindingDescriptions       = viBindings.data();
-    viInfo.vertexAttributeDescriptionCount  = state.il.attributeCount();
-    viInfo.pVertexAttributeDescriptions     = viAttribs.data();
-    
-    if (viDivisorCount == 0)
-      viInfo.pNext = viDivisorInfo.pNext;
-    
-    // TODO remove this once the extension is widely supported
-    if (!m_pipeMgr->m_device->features().extVertexAttributeDivisor.vertexAttributeInstanceRateDivisor)
-      viInfo.pNext = viDivisorInfo.pNext;
-    
-    VkPipelineInputAssemblyStateCreateInfo iaInfo = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
-    iaInfo.topology               = state.ia.primitiveTopology();
-    iaInfo.primitiveRestartEnable = state.ia.primitiveRestart();
-    
     VkPipelineTessellationStateCreateInfo tsInfo = { VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO };
     tsInfo.patchControlPoints     = state.ia.patchVertexCount();
     
@@ -322,16 +823,6 @@ namespace dxvk {
     else
       rsInfo.depthClampEnable = !state.rs.depthClipEnable();
 
-    uint32_t sampleMask = state.ms.sampleMask();
-
-    VkPipelineMultisampleStateCreateInfo msInfo = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
-    msInfo.rasterizationSamples   = sampleCount;
-    msInfo.sampleShadingEnable    = m_common.msSampleShadingEnable;
-    msInfo.minSampleShading       = m_common.msSampleShadingFactor;
-    msInfo.pSampleMask            = &sampleMask;
-    msInfo.alphaToCoverageEnable  = state.ms.enableAlphaToCoverage();
-    msInfo.alphaToOneEnable       = VK_FALSE;
-    
     VkPipelineDepthStencilStateCreateInfo dsInfo = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
     dsInfo.depthTestEnable        = state.ds.enableDepthTest();
     dsInfo.depthWriteEnable       = state.ds.enableDepthWrite() && !(rtReadOnlyAspects & VK_IMAGE_ASPECT_DEPTH_BIT);
@@ -341,48 +832,30 @@ namespace dxvk {
     dsInfo.front                  = state.dsFront.state();
     dsInfo.back                   = state.dsBack.state();
     
-    VkPipelineColorBlendStateCreateInfo cbInfo = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
-    cbInfo.logicOpEnable          = state.om.enableLogicOp();
-    cbInfo.logicOp                = state.om.logicOp();
-    cbInfo.attachmentCount        = rtColorFormatCount;
-    cbInfo.pAttachments           = omBlendAttachments.data();
-    
     VkPipelineDynamicStateCreateInfo dyInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
     dyInfo.dynamicStateCount      = dynamicStateCount;
     dyInfo.pDynamicStates         = dynamicStates.data();
 
-    VkPipelineRenderingCreateInfoKHR rtInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR };
-
-    if (rtColorFormatCount) {
-      rtInfo.colorAttachmentCount = rtColorFormatCount;
-      rtInfo.pColorAttachmentFormats = rtColorFormats.data();
-    }
-
-    if (rtDepthFormat) {
-      if (rtDepthFormatInfo->aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
-        rtInfo.depthAttachmentFormat = rtDepthFormat;
-
-      if (rtDepthFormatInfo->aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
-        rtInfo.stencilAttachmentFormat = rtDepthFormat;
-    }
-
-    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &rtInfo };
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &foState.rtInfo };
     info.stageCount               = stages.size();
     info.pStages                  = stages.data();
-    info.pVertexInputState        = &viInfo;
-    info.pInputAssemblyState      = &iaInfo;
+    info.pVertexInputState        = &viState.viInfo;
+    info.pInputAssemblyState      = &viState.iaInfo;
     info.pTessellationState       = &tsInfo;
     info.pViewportState           = &vpInfo;
     info.pRasterizationState      = &rsInfo;
-    info.pMultisampleState        = &msInfo;
+    info.pMultisampleState        = &foState.msInfo;
     info.pDepthStencilState       = &dsInfo;
-    info.pColorBlendState         = &cbInfo;
+    info.pColorBlendState         = &foState.cbInfo;
     info.pDynamicState            = &dyInfo;
-    info.layout                   = m_bindings->getPipelineLayout();
+    info.layout                   = m_bindings->getPipelineLayout(false);
     info.basePipelineIndex        = -1;
     
     if (!tsInfo.patchControlPoints)
       info.pTessellationState = nullptr;
+
+    if (features.extVertexInputDynamicState.vertexInputDynamicState)
+      info.pVertexInputState = nullptr;
     
     // Time pipeline compilation for debugging purposes
     dxvk::high_resolution_clock::time_point t0, t1;
@@ -448,6 +921,22 @@ namespace dxvk {
     }
 
     info.undefinedInputs = (providedInputs & consumedInputs) ^ consumedInputs;
+
+    // Deal with outputs that the next stage does not read. Tessellation
+    // control shaders can access the outputs of any invocation, so only
+    // link stages that feed the geometry shader or the rasterizer.
+    if ((shaderInfo.stage == VK_SHADER_STAGE_VERTEX_BIT
+      || shaderInfo.stage == VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT
+      || shaderInfo.stage == VK_SHADER_STAGE_GEOMETRY_BIT)
+     && !shader->flags().test(DxvkShaderFlag::HasTransformFeedback)) {
+      auto nextStage = getNextStageShader(shaderInfo.stage);
+
+      if (nextStage == nullptr || nextStage->info().stage != VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT) {
+        uint32_t readInputs = nextStage != nullptr ? nextStage->info().inputMask : 0u;
+        info.unusedOutputs = shaderInfo.outputMask & ~readInputs;
+      }
+    }
+
     return shader->createShaderModule(m_vkd, m_bindings, info);
   }
 
@@ -477,6 +966,86 @@ namespace dxvk {
   }
 
 
+  Rc<DxvkShader> DxvkGraphicsPipeline::getNextStageShader(VkShaderStageFlagBits stage) const {
+    if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
+      if (m_shaders.tcs != nullptr)
+        return m_shaders.tcs;
+    }
+
+    if (stage == VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT)
+      return m_shaders.tes;
+
+    if (stage != VK_SHADER_STAGE_GEOMETRY_BIT
+     && stage != VK_SHADER_STAGE_FRAGMENT_BIT) {
+      if (m_shaders.gs != nullptr)
+        return m_shaders.gs;
+    }
+
+    if (stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      return nullptr;
+
+    return m_shaders.fs;
+  }
+
+
+  DxvkGraphicsPipelineStateInfo DxvkGraphicsPipeline::normalizePipelineState(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    const auto& features = m_pipeMgr->m_device->features();
+
+    DxvkGraphicsPipelineStateInfo result = state;
+
+    // Cull mode, front face and all depth-stencil state are
+    // covered by VK_EXT_extended_dynamic_state, which we require
+    result.rs = DxvkRsInfo(
+      state.rs.depthClipEnable(),
+      features.extExtendedDynamicState2.extendedDynamicState2
+        ? VK_FALSE : state.rs.depthBiasEnable(),
+      state.rs.polygonMode(),
+      VK_CULL_MODE_NONE,
+      VK_FRONT_FACE_COUNTER_CLOCKWISE,
+      state.rs.sampleCount(),
+      state.rs.conservativeMode());
+
+    result.ds = DxvkDsInfo(VK_FALSE, VK_FALSE, VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+    result.dsFront = DxvkDsStencilOp(VkStencilOpState());
+    result.dsBack = DxvkDsStencilOp(VkStencilOpState());
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2) {
+      result.ia = DxvkIaInfo(
+        state.ia.primitiveTopology(), VK_FALSE,
+        state.ia.patchVertexCount());
+    }
+
+    if (features.extExtendedDynamicState2.extendedDynamicState2LogicOp)
+      result.om = DxvkOmInfo(state.om.enableLogicOp(), VK_LOGIC_OP_NO_OP);
+
+    // With dynamic vertex input, only the set of attribute locations
+    // affects the pipeline since it determines which vertex shader
+    // inputs are undefined. Store them in a canonical order.
+    if (features.extVertexInputDynamicState.vertexInputDynamicState) {
+      uint32_t locationMask = 0;
+
+      for (uint32_t i = 0; i < state.il.attributeCount(); i++)
+        locationMask |= 1u << state.ilAttributes[i].location();
+
+      uint32_t attributeCount = 0;
+
+      for (uint32_t location : bit::BitMask(locationMask))
+        result.ilAttributes[attributeCount++] = DxvkIlAttribute(location, 0, VK_FORMAT_UNDEFINED, 0);
+
+      for (uint32_t i = attributeCount; i < MaxNumVertexAttributes; i++)
+        result.ilAttributes[i] = DxvkIlAttribute(0, 0, VK_FORMAT_UNDEFINED, 0);
+
+      for (uint32_t i = 0; i < MaxNumVertexBindings; i++)
+        result.ilBindings[i] = DxvkIlBinding(0, 0, VK_VERTEX_INPUT_RATE_VERTEX, 0);
+
+      result.il = DxvkIlInfo(attributeCount, 0);
+    }
+
+    return result;
+  }
+
+
   bool DxvkGraphicsPipeline::validatePipelineState(
     const DxvkGraphicsPipelineStateInfo&  state,
           bool                            trusted) const {
@@ -509,8 +1078,12 @@ namespace dxvk {
       return false;
     }
 
-    // Validate vertex input layout
+    // Validate vertex input layout. With dynamic vertex input, the
+    // state cache only stores attribute locations, so only check
+    // that no location is defined twice.
     const DxvkDevice* device = m_pipeMgr->m_device;
+    bool dynamicVertexInput = device->features().extVertexInputDynamicState.vertexInputDynamicState;
+
     uint32_t ilLocationMask = 0;
     uint32_t ilBindingMask = 0;
 
@@ -525,6 +1098,11 @@ namespace dxvk {
         return false;
       }
 
+      if (dynamicVertexInput) {
+        ilLocationMask |= 1u << attribute.location();
+        continue;
+      }
+
       if (!(ilBindingMask & (1u << attribute.binding()))) {
         Logger::err(str::format("Invalid pipeline: Vertex binding ", attribute.binding(), " not defined"));
         return false;
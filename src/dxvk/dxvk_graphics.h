@@ -1,12 +1,16 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 
 #include "../util/sync/sync_list.h"
 
 #include "dxvk_bind_mask.h"
 #include "dxvk_constant_state.h"
 #include "dxvk_graphics_state.h"
+#include "dxvk_hash.h"
 #include "dxvk_pipecache.h"
 #include "dxvk_pipelayout.h"
 #include "dxvk_renderpass.h"
@@ -82,11 +86,196 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Vertex input state
+   *
+   * Stores vertex input and input assembly state
+   * in a form that can directly be passed to Vulkan.
+   * Used for both monolithic pipelines and vertex
+   * input pipeline libraries.
+   */
+  struct DxvkGraphicsPipelineVertexInputState {
+    DxvkGraphicsPipelineVertexInputState(
+      const DxvkDevice*                       device,
+      const DxvkGraphicsPipelineStateInfo&    state);
+
+    DxvkGraphicsPipelineVertexInputState             (const DxvkGraphicsPipelineVertexInputState&) = delete;
+    DxvkGraphicsPipelineVertexInputState& operator = (const DxvkGraphicsPipelineVertexInputState&) = delete;
+
+    VkPipelineInputAssemblyStateCreateInfo          iaInfo        = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    VkPipelineVertexInputStateCreateInfo            viInfo        = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineVertexInputDivisorStateCreateInfoEXT  viDivisorInfo = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT };
+
+    std::array<VkVertexInputBindingDescription,           MaxNumVertexBindings>   viBindings    = { };
+    std::array<VkVertexInputBindingDivisorDescriptionEXT, MaxNumVertexBindings>   viDivisors    = { };
+    std::array<VkVertexInputAttributeDescription,         MaxNumVertexAttributes> viAttributes  = { };
+  };
+
+
+  /**
+   * \brief Fragment output state
+   *
+   * Stores color blend, multisample and render target
+   * state in a form that can directly be passed to
+   * Vulkan. Used for both monolithic pipelines and
+   * fragment output pipeline libraries.
+   */
+  struct DxvkGraphicsPipelineFragmentOutputState {
+    DxvkGraphicsPipelineFragmentOutputState(
+      const DxvkDevice*                       device,
+      const DxvkGraphicsPipelineStateInfo&    state,
+            uint32_t                          fsOutputMask,
+            bool                              fsSampleShading);
+
+    DxvkGraphicsPipelineFragmentOutputState             (const DxvkGraphicsPipelineFragmentOutputState&) = delete;
+    DxvkGraphicsPipelineFragmentOutputState& operator = (const DxvkGraphicsPipelineFragmentOutputState&) = delete;
+
+    VkPipelineRenderingCreateInfoKHR                rtInfo        = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR };
+    VkPipelineColorBlendStateCreateInfo             cbInfo        = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    VkPipelineMultisampleStateCreateInfo            msInfo        = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+
+    uint32_t                                        msSampleMask  = 0u;
+
+    std::array<VkPipelineColorBlendAttachmentState, MaxNumRenderTargets> cbAttachments  = { };
+    std::array<VkFormat,                            MaxNumRenderTargets> rtColorFormats = { };
+  };
+
+
+  /**
+   * \brief Vertex input pipeline library key
+   *
+   * Stores a copy of the pipeline state vector where
+   * all state that is not part of the vertex input
+   * library is zeroed out, so that it can be used
+   * for lookups.
+   */
+  struct DxvkGraphicsPipelineVertexInputKey {
+    DxvkGraphicsPipelineVertexInputKey(
+      const DxvkGraphicsPipelineStateInfo&    state);
+
+    DxvkGraphicsPipelineStateInfo state;
+
+    bool eq(const DxvkGraphicsPipelineVertexInputKey& other) const {
+      return state == other.state;
+    }
+
+    size_t hash() const;
+  };
+
+
+  /**
+   * \brief Fragment output pipeline library key
+   *
+   * Stores a copy of the pipeline state vector where
+   * all state that is not part of the fragment output
+   * library is zeroed out, as well as the mask of
+   * render targets written by the fragment shader.
+   */
+  struct DxvkGraphicsPipelineFragmentOutputKey {
+    DxvkGraphicsPipelineFragmentOutputKey(
+      const DxvkGraphicsPipelineStateInfo&    state,
+            uint32_t                          fsOutputMask);
+
+    DxvkGraphicsPipelineStateInfo state;
+    uint32_t                      fsOutputMask;
+
+    bool eq(const DxvkGraphicsPipelineFragmentOutputKey& other) const {
+      return state == other.state && fsOutputMask == other.fsOutputMask;
+    }
+
+    size_t hash() const;
+  };
+
+
+  /**
+   * \brief Vertex input pipeline library
+   *
+   * Vertex input state is cheap to compile, so these
+   * libraries are created on demand and cached in the
+   * pipeline manager, where they are shared between
+   * all graphics pipelines.
+   */
+  class DxvkGraphicsPipelineVertexInputLibrary {
+
+  public:
+
+    DxvkGraphicsPipelineVertexInputLibrary(
+            DxvkDevice*                         device,
+            VkPipelineCache                     cache,
+      const DxvkGraphicsPipelineVertexInputKey& key);
+
+    ~DxvkGraphicsPipelineVertexInputLibrary();
+
+    /**
+     * \brief Queries pipeline handle
+     * \returns Pipeline handle
+     */
+    VkPipeline getHandle() const {
+      return m_pipeline;
+    }
+
+  private:
+
+    DxvkDevice* m_device;
+    VkPipeline  m_pipeline = VK_NULL_HANDLE;
+
+  };
+
+
+  /**
+   * \brief Fragment output pipeline library
+   *
+   * Like vertex input libraries, these are created
+   * on demand and shared between graphics pipelines.
+   */
+  class DxvkGraphicsPipelineFragmentOutputLibrary {
+
+  public:
+
+    DxvkGraphicsPipelineFragmentOutputLibrary(
+            DxvkDevice*                             device,
+            VkPipelineCache                         cache,
+      const DxvkGraphicsPipelineFragmentOutputKey&  key);
+
+    ~DxvkGraphicsPipelineFragmentOutputLibrary();
+
+    /**
+     * \brief Queries pipeline handle
+     * \returns Pipeline handle
+     */
+    VkPipeline getHandle() const {
+      return m_pipeline;
+    }
+
+  private:
+
+    DxvkDevice* m_device;
+    VkPipeline  m_pipeline = VK_NULL_HANDLE;
+
+  };
+
+
+  /**
+   * \brief Graphics pipeline type
+   *
+   * Fast pipelines are fully optimized monolithic
+   * pipelines, whereas base pipelines are linked
+   * from pipeline libraries and require the context
+   * to set the remaining pipeline state dynamically.
+   */
+  enum class DxvkGraphicsPipelineType : uint32_t {
+    FastPipeline,
+    BasePipeline,
+  };
+
+
   /**
    * \brief Graphics pipeline instance
    * 
-   * Stores a state vector and the
-   * corresponding pipeline handle.
+   * Stores a state vector and the corresponding
+   * pipeline handles. The optimized pipeline may
+   * be compiled on a worker thread and will only
+   * be used once it becomes available.
    */
   class DxvkGraphicsPipelineInstance {
 
@@ -94,37 +283,129 @@ namespace dxvk {
 
     DxvkGraphicsPipelineInstance()
     : m_stateVector (),
-      m_pipeline    (VK_NULL_HANDLE) { }
+      m_stateHash   (0),
+      m_baseHandle  (VK_NULL_HANDLE),
+      m_genericHandle(VK_NULL_HANDLE),
+      m_fastHandle  (VK_NULL_HANDLE),
+      m_isCompiling (false) { }
 
     DxvkGraphicsPipelineInstance(
       const DxvkGraphicsPipelineStateInfo&  state,
-            VkPipeline                      pipe)
+            size_t                          stateHash,
+            VkPipeline                      baseHandle,
+            VkPipeline                      fastHandle,
+            VkPipeline                      genericHandle)
     : m_stateVector (state),
-      m_pipeline    (pipe) { }
+      m_stateHash   (stateHash),
+      m_baseHandle  (baseHandle),
+      m_genericHandle(genericHandle),
+      m_fastHandle  (fastHandle),
+      m_isCompiling (fastHandle != VK_NULL_HANDLE) { }
 
     /**
      * \brief Checks for matching pipeline state
      * 
+     * Compares the precomputed hashes first so that
+     * the full state vector only needs to be compared
+     * for the instance that is most likely a match.
      * \param [in] stateVector Graphics pipeline state
+     * \param [in] stateHash Hash of the state vector
      * \returns \c true if the specialization is compatible
      */
     bool isCompatible(
-      const DxvkGraphicsPipelineStateInfo&  state) {
-      return m_stateVector == state;
+      const DxvkGraphicsPipelineStateInfo&  state,
+            size_t                          stateHash) const {
+      return m_stateHash == stateHash
+          && m_stateVector == state;
     }
 
     /**
-     * \brief Retrieves pipeline
-     * \returns The pipeline handle
+     * \brief Precomputed state vector hash
+     * \returns Hash of the state vector
      */
-    VkPipeline pipeline() const {
-      return m_pipeline;
+    size_t stateHash() const {
+      return m_stateHash;
+    }
+
+    /**
+     * \brief Next instance in the same hash bucket
+     * \returns Next instance, or \c nullptr
+     */
+    DxvkGraphicsPipelineInstance* next() const {
+      return m_next;
+    }
+
+    /**
+     * \brief Sets next instance in the hash bucket
+     *
+     * Must only be called before the instance
+     * is made visible to other threads.
+     * \param [in] next Next instance
+     */
+    void setNext(DxvkGraphicsPipelineInstance* next) {
+      m_next = next;
+    }
+
+    /**
+     * \brief Retrieves linked pipeline
+     * \returns The base pipeline handle
+     */
+    VkPipeline baseHandle() const {
+      return m_baseHandle;
+    }
+
+    /**
+     * \brief Retrieves unspecialized pipeline
+     *
+     * Monolithic pipeline compiled without spec constants,
+     * shared between all instances that only differ in
+     * spec constant values. Only used until the optimized
+     * pipeline becomes available.
+     * \returns The generic pipeline handle
+     */
+    VkPipeline genericHandle() const {
+      return m_genericHandle;
+    }
+
+    /**
+     * \brief Retrieves optimized pipeline
+     *
+     * May return \c VK_NULL_HANDLE if the optimized
+     * pipeline has not finished compiling yet.
+     * \returns The fast pipeline handle
+     */
+    VkPipeline fastHandle() const {
+      return m_fastHandle.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Sets optimized pipeline
+     * \param [in] pipeline The fast pipeline handle
+     */
+    void setFastHandle(VkPipeline pipeline) {
+      m_fastHandle.store(pipeline, std::memory_order_release);
+    }
+
+    /**
+     * \brief Marks optimized pipeline as compiling
+     *
+     * \returns \c true if the calling thread is responsible
+     *    for compiling the optimized pipeline, \c false if
+     *    it is being compiled or has already been compiled.
+     */
+    bool beginCompile() {
+      return !m_isCompiling.exchange(true, std::memory_order_acquire);
     }
 
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
-    VkPipeline                    m_pipeline;
+    size_t                        m_stateHash;
+    VkPipeline                    m_baseHandle;
+    VkPipeline                    m_genericHandle;
+    std::atomic<VkPipeline>       m_fastHandle;
+    std::atomic<bool>             m_isCompiling;
+    DxvkGraphicsPipelineInstance* m_next = nullptr;
 
   };
 
@@ -137,13 +418,16 @@ namespace dxvk {
    * pipeline state vector.
    */
   class DxvkGraphicsPipeline {
-    
+    /// Number of hash buckets for pipeline instances
+    constexpr static uint32_t InstanceBucketCount = 64;
   public:
     
     DxvkGraphicsPipeline(
             DxvkPipelineManager*        pipeMgr,
             DxvkGraphicsPipelineShaders shaders,
-            DxvkBindingLayoutObjects*   layout);
+            DxvkBindingLayoutObjects*   layout,
+            DxvkShaderPipelineLibrary*  vsLibrary,
+            DxvkShaderPipelineLibrary*  fsLibrary);
 
     ~DxvkGraphicsPipeline();
 
@@ -204,21 +488,28 @@ namespace dxvk {
      * 
      * Retrieves a pipeline handle for the given pipeline
      * state. If necessary, a new pipeline will be created.
-     * \param [in] state Pipeline state vector
-     * \returns Pipeline handle
+     * If the pipeline can be linked from pipeline libraries,
+     * this will return a base pipeline until the optimized
+     * pipeline has been compiled on a worker thread. State
+     * that is dynamic in all pipelines is ignored, and must
+     * be set by the caller after binding the pipeline.
+     * \param [in] appState Pipeline state vector
+     * \returns Pipeline handle and type
      */
-    VkPipeline getPipelineHandle(
-      const DxvkGraphicsPipelineStateInfo&    state);
+    std::pair<VkPipeline, DxvkGraphicsPipelineType> getPipelineHandle(
+      const DxvkGraphicsPipelineStateInfo&    appState);
     
     /**
      * \brief Compiles a pipeline
      * 
      * Asynchronously compiles the given pipeline
-     * and stores the result for future use.
-     * \param [in] state Pipeline state vector
+     * and stores the result for future use. If
+     * the pipeline instance already exists, this
+     * will compile the optimized pipeline for it.
+     * \param [in] appState Pipeline state vector
      */
     void compilePipeline(
-      const DxvkGraphicsPipelineStateInfo&    state);
+      const DxvkGraphicsPipelineStateInfo&    appState);
     
   private:
     
@@ -227,6 +518,9 @@ namespace dxvk {
 
     DxvkGraphicsPipelineShaders m_shaders;
     DxvkBindingLayoutObjects*   m_bindings;
+
+    DxvkShaderPipelineLibrary*  m_vsLibrary;
+    DxvkShaderPipelineLibrary*  m_fsLibrary;
     
     uint32_t m_vsIn  = 0;
     uint32_t m_fsOut = 0;
@@ -235,19 +529,54 @@ namespace dxvk {
     DxvkGraphicsPipelineFlags           m_flags;
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    // List of pipeline instances, shared between threads
+    // List of pipeline instances, shared between threads. Instances
+    // are only added while holding the lock, but the hash buckets
+    // can be traversed without locking since instances in a bucket
+    // are immutable as far as the bucket links are concerned.
     alignas(CACHE_LINE_SIZE)
     dxvk::mutex                               m_mutex;
     sync::List<DxvkGraphicsPipelineInstance>  m_pipelines;
+
+    std::array<std::atomic<DxvkGraphicsPipelineInstance*>,
+      InstanceBucketCount>                    m_buckets = { };
+
+    // Unspecialized pipelines, keyed by the state vector with all
+    // spec constants cleared. Only accessed with the lock held.
+    std::unordered_map<
+      DxvkGraphicsPipelineStateInfo, VkPipeline,
+      DxvkHash, DxvkEq>                       m_genericPipelines;
     
     DxvkGraphicsPipelineInstance* createInstance(
-      const DxvkGraphicsPipelineStateInfo& state);
+      const DxvkGraphicsPipelineStateInfo& state,
+            size_t                         stateHash,
+            bool                           doCreateBasePipeline);
     
+    DxvkGraphicsPipelineInstance* insertInstance(
+      const DxvkGraphicsPipelineStateInfo& state,
+            size_t                         stateHash,
+            VkPipeline                     baseHandle,
+            VkPipeline                     fastHandle,
+            VkPipeline                     genericHandle);
+
     DxvkGraphicsPipelineInstance* findInstance(
-      const DxvkGraphicsPipelineStateInfo& state);
+      const DxvkGraphicsPipelineStateInfo& state,
+            size_t                         stateHash) const;
     
-    VkPipeline createPipeline(
+    bool canCreateBasePipeline(
+      const DxvkGraphicsPipelineStateInfo& state) const;
+
+    VkPipeline createBasePipeline(
+      const DxvkGraphicsPipelineStateInfo& state) const;
+
+    bool canUseGenericPipeline(
       const DxvkGraphicsPipelineStateInfo& state) const;
+
+    VkPipeline getGenericPipeline(
+      const DxvkGraphicsPipelineStateInfo& state);
+
+    VkPipeline createOptimizedPipeline(
+      const DxvkGraphicsPipelineStateInfo& state,
+            bool                           specialize = true) const;
     
     void destroyPipeline(
             VkPipeline                     pipeline) const;
@@ -259,6 +588,12 @@ namespace dxvk {
     Rc<DxvkShader> getPrevStageShader(
             VkShaderStageFlagBits          stage) const;
 
+    Rc<DxvkShader> getNextStageShader(
+            VkShaderStageFlagBits          stage) const;
+
+    DxvkGraphicsPipelineStateInfo normalizePipelineState(
+      const DxvkGraphicsPipelineStateInfo& state) const;
+
     bool validatePipelineState(
       const DxvkGraphicsPipelineStateInfo& state,
             bool                           trusted) const;
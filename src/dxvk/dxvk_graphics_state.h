@@ -733,6 +733,14 @@ namespace dxvk {
       return !bit::bcmpeq(this, &other);
     }
 
+    bool eq(const DxvkGraphicsPipelineStateInfo& other) const {
+      return bit::bcmpeq(this, &other);
+    }
+
+    size_t hash() const {
+      return bit::bhash(this);
+    }
+
     bool useDynamicStencilRef() const {
       return ds.enableStencilTest();
     }
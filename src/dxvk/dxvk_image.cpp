@@ -20,6 +20,8 @@ namespace dxvk {
       m_viewFormats[i] = createInfo.viewFormats[i];
     m_info.viewFormats = m_viewFormats.data();
 
+    m_unusedLayout = createInfo.initialLayout;
+
     // If defined, we should provide a format list, which
     // allows some drivers to enable image compression
     VkImageFormatListCreateInfoKHR formatList;
@@ -71,11 +73,14 @@ namespace dxvk {
         "\n  Usage:           ", info.usage,
         "\n  Tiling:          ", info.tiling));
     }
+
+    // Memory for sparse images is bound page by page later
+    if (isSparse())
+      return;
     
-    // Get memory requirements for the image. We may enforce strict
-    // alignment on non-linear images in order not to violate the
-    // bufferImageGranularity limit, which may be greater than the
-    // required resource memory alignment on some GPUs.
+    // Get memory requirements for the image. Non-linear images are
+    // kept in separate chunks if the bufferImageGranularity limit
+    // requires it, so that small images can be packed tightly.
     VkMemoryDedicatedRequirements dedicatedRequirements;
     dedicatedRequirements.sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
     dedicatedRequirements.pNext                       = VK_NULL_HANDLE;
@@ -122,10 +127,6 @@ namespace dxvk {
     m_vkd->vkGetImageMemoryRequirements2(
       m_vkd->device(), &memReqInfo, &memReq);
 
-    if (info.tiling != VK_IMAGE_TILING_LINEAR && !dedicatedRequirements.prefersDedicatedAllocation) {
-      memReq.memoryRequirements.size      = align(memReq.memoryRequirements.size,       memAlloc.bufferImageGranularity());
-      memReq.memoryRequirements.alignment = align(memReq.memoryRequirements.alignment , memAlloc.bufferImageGranularity());
-    }
 
     // Use high memory priority for GPU-writable resources
     bool isGpuWritable = (m_info.access & (
@@ -140,14 +141,44 @@ namespace dxvk {
     if (isGpuWritable)
       hints.set(DxvkMemoryFlag::GpuWritable);
 
+    if (info.tiling != VK_IMAGE_TILING_LINEAR && memAlloc.bufferImageGranularity() > 1)
+      hints.set(DxvkMemoryFlag::ImageOptimal);
+
     if (m_shared) {
       dedicatedRequirements.prefersDedicatedAllocation  = VK_TRUE;
       dedicatedRequirements.requiresDedicatedAllocation = VK_TRUE;
     }
 
+    // Back transient attachments with lazily allocated memory if
+    // possible, so that tiling GPUs do not need to commit physical
+    // memory for them. Such memory cannot be suballocated.
+    if ((m_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+     && device->adapter()->hasLazilyAllocatedMemory(memReq.memoryRequirements.memoryTypeBits)) {
+      memFlags   |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+      m_memFlags |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+      dedicatedRequirements.prefersDedicatedAllocation  = VK_TRUE;
+      dedicatedRequirements.requiresDedicatedAllocation = VK_TRUE;
+    }
+
+    // With lazy allocation enabled, defer allocating memory until
+    // the image is first used, so that resources which are never
+    // used do not occupy any memory at all.
+    if (device->config().lazyImageAllocation && !m_shared) {
+      m_memAlloc      = &memAlloc;
+      m_memHints      = hints;
+      m_memReq        = memReq.memoryRequirements;
+      m_dedicatedReq  = dedicatedRequirements;
+      m_dedicatedReq.pNext = nullptr;
+
+      m_allocPending.store(true, std::memory_order_release);
+      return;
+    }
+
     // Ask driver whether we should be using a dedicated allocation
     m_image.memory = memAlloc.alloc(&memReq.memoryRequirements,
-      dedicatedRequirements, dedMemoryAllocInfo, memFlags, hints);
+      dedicatedRequirements, dedMemoryAllocInfo, memFlags, hints,
+      determineMemoryCategory());
     
     // Try to bind the allocated memory slice to the image
     if (m_vkd->vkBindImageMemory(m_vkd->device(), m_image.image,
@@ -160,7 +191,7 @@ namespace dxvk {
     const DxvkDevice*           device,
     const DxvkImageCreateInfo&  info,
           VkImage               image)
-  : m_vkd(device->vkd()), m_device(device), m_info(info), m_image({ image }) {
+  : m_vkd(device->vkd()), m_device(device), m_info(info), m_image({ image }), m_implManaged(true) {
     
     m_viewFormats.resize(info.viewFormatCount);
     for (uint32_t i = 0; i < info.viewFormatCount; i++)
@@ -170,9 +201,17 @@ namespace dxvk {
   
   
   DxvkImage::~DxvkImage() {
+    // Views created through this image can only be destroyed
+    // after all DxvkImageView objects referencing it are gone
+    for (const auto& entry : m_viewCache)
+      m_vkd->vkDestroyImageView(m_vkd->device(), entry.second, nullptr);
+
+    for (auto view : m_retiredViews)
+      m_vkd->vkDestroyImageView(m_vkd->device(), view, nullptr);
+
     // This is a bit of a hack to determine whether
     // the image is implementation-handled or not
-    if (m_image.memory.memory() != VK_NULL_HANDLE)
+    if (m_image.memory.memory() != VK_NULL_HANDLE || isSparse() || !isAllocated())
       m_vkd->vkDestroyImage(m_vkd->device(), m_image.image, nullptr);
   }
 
@@ -236,6 +275,70 @@ namespace dxvk {
   }
 
 
+  DxvkMemoryCategory DxvkImage::determineMemoryCategory() const {
+    if (m_info.category != DxvkMemoryCategory::Auto)
+      return m_info.category;
+
+    if (m_info.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+      return DxvkMemoryCategory::RenderTarget;
+
+    VkImageUsageFlags copyUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                                | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    if (!(m_info.usage & ~copyUsage))
+      return DxvkMemoryCategory::Staging;
+
+    return DxvkMemoryCategory::Texture;
+  }
+
+
+  void DxvkImage::allocateMemory() {
+    std::lock_guard<dxvk::mutex> lock(m_allocMutex);
+
+    // Another thread may have allocated memory already
+    if (!m_allocPending.load(std::memory_order_relaxed))
+      return;
+
+    VkMemoryDedicatedAllocateInfo dedMemoryAllocInfo;
+    dedMemoryAllocInfo.sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedMemoryAllocInfo.pNext  = VK_NULL_HANDLE;
+    dedMemoryAllocInfo.buffer = VK_NULL_HANDLE;
+    dedMemoryAllocInfo.image  = m_image.image;
+
+    m_image.memory = m_memAlloc->alloc(&m_memReq,
+      m_dedicatedReq, dedMemoryAllocInfo, m_memFlags, m_memHints,
+      determineMemoryCategory());
+
+    if (m_vkd->vkBindImageMemory(m_vkd->device(), m_image.image,
+          m_image.memory.memory(), m_image.memory.offset()) != VK_SUCCESS)
+      throw DxvkError("DxvkImage::allocateMemory: Failed to bind device memory");
+
+    m_allocPending.store(false, std::memory_order_release);
+  }
+
+
+  void DxvkImage::rename(DxvkImage& storage) {
+    // Allocation state is not swapped, so make
+    // sure that both images have memory bound
+    ensureMemory();
+    storage.ensureMemory();
+
+    std::lock_guard<dxvk::mutex> lock(m_viewMutex);
+    std::lock_guard<dxvk::mutex> storageLock(storage.m_viewMutex);
+
+    std::swap(m_image, storage.m_image);
+    std::swap(m_viewCache, storage.m_viewCache);
+
+    // Views retired since the last rename may still be in use
+    // by the GPU, so destroy them with the previous storage
+    storage.m_retiredViews.insert(storage.m_retiredViews.end(),
+      m_retiredViews.begin(), m_retiredViews.end());
+    m_retiredViews.clear();
+
+    m_version.fetch_add(1, std::memory_order_release);
+  }
+
+
   HANDLE DxvkImage::sharedHandle() const {
     HANDLE handle = INVALID_HANDLE_VALUE;
 
@@ -256,14 +359,74 @@ namespace dxvk {
   }
 
 
+  VkImageView DxvkImage::lookupView(
+    const DxvkImageViewKey&       key) {
+    std::lock_guard<dxvk::mutex> lock(m_viewMutex);
+
+    for (const auto& entry : m_viewCache) {
+      if (entry.first.eq(key))
+        return entry.second;
+    }
+
+    return VK_NULL_HANDLE;
+  }
+
+
+  bool DxvkImage::insertView(
+    const DxvkImageViewKey&       key,
+          VkImageView             view,
+          VkImage                 image) {
+    std::lock_guard<dxvk::mutex> lock(m_viewMutex);
+
+    // Keep the cache small, views that do not fit are
+    // owned and destroyed by the DxvkImageView object.
+    // Another thread may also have created the same view,
+    // or the image may have been renamed in the meantime.
+    if (m_viewCache.size() >= MaxCachedViews || m_image.image != image)
+      return false;
+
+    for (const auto& entry : m_viewCache) {
+      if (entry.first.eq(key))
+        return false;
+    }
+
+    m_viewCache.push_back({ key, view });
+    return true;
+  }
+
+
+  void DxvkImage::retireView(
+          VkImageView             view) {
+    std::lock_guard<dxvk::mutex> lock(m_viewMutex);
+    m_retiredViews.push_back(view);
+  }
+
+
   DxvkImageView::DxvkImageView(
     const Rc<vk::DeviceFn>&         vkd,
     const Rc<DxvkImage>&            image,
     const DxvkImageViewCreateInfo&  info)
   : m_vkd(vkd), m_image(image), m_info(info), m_cookie(++s_cookie) {
+    // Creating views requires the image to be bound to memory
+    m_image->ensureMemory();
+
     for (uint32_t i = 0; i < ViewCount; i++)
       m_views[i] = VK_NULL_HANDLE;
-    
+
+    m_version = m_image->m_version.load(std::memory_order_acquire);
+    createViews();
+  }
+  
+  
+  DxvkImageView::~DxvkImageView() {
+    for (uint32_t i = 0; i < ViewCount; i++) {
+      if (m_ownedViews & (1u << i))
+        m_vkd->vkDestroyImageView(m_vkd->device(), m_views[i], nullptr);
+    }
+  }
+
+
+  void DxvkImageView::createViews() const {
     switch (m_info.type) {
       case VK_IMAGE_VIEW_TYPE_1D:
       case VK_IMAGE_VIEW_TYPE_1D_ARRAY: {
@@ -303,15 +466,9 @@ namespace dxvk {
         throw DxvkError(str::format("DxvkImageView: Invalid view type: ", m_info.type));
     }
   }
-  
-  
-  DxvkImageView::~DxvkImageView() {
-    for (uint32_t i = 0; i < ViewCount; i++)
-      m_vkd->vkDestroyImageView(m_vkd->device(), m_views[i], nullptr);
-  }
 
   
-  void DxvkImageView::createView(VkImageViewType type, uint32_t numLayers) {
+  void DxvkImageView::createView(VkImageViewType type, uint32_t numLayers) const {
     VkImageSubresourceRange subresourceRange;
     subresourceRange.aspectMask     = m_info.aspect;
     subresourceRange.baseMipLevel   = m_info.minLevel;
@@ -339,6 +496,21 @@ namespace dxvk {
         VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
         VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
     }
+
+    // Reuse an existing view handle with the same properties
+    // if possible. Frontends tend to create temporary views
+    // for the same subresources over and over again.
+    DxvkImageViewKey key;
+    key.type         = viewInfo.viewType;
+    key.format       = viewInfo.format;
+    key.usage        = m_info.usage;
+    key.swizzle      = viewInfo.components;
+    key.subresources = viewInfo.subresourceRange;
+
+    m_views[type] = m_image->lookupView(key);
+
+    if (m_views[type])
+      return;
     
     if (m_vkd->vkCreateImageView(m_vkd->device(),
           &viewInfo, nullptr, &m_views[type]) != VK_SUCCESS) {
@@ -364,6 +536,26 @@ namespace dxvk {
         "\n    Usage:         ", std::hex, m_image->info().usage,
         "\n    Tiling:        ", m_image->info().tiling));
     }
+
+    if (!m_image->insertView(key, m_views[type], viewInfo.image))
+      m_ownedViews |= 1u << type;
+  }
+
+
+  void DxvkImageView::updateViews() const {
+    // Handles owned by the view may still be in use by the
+    // GPU, so let the image destroy them at the right time.
+    // Cached handles are owned by the previous storage.
+    for (uint32_t i = 0; i < ViewCount; i++) {
+      if (m_ownedViews & (1u << i))
+        m_image->retireView(m_views[i]);
+
+      m_views[i] = VK_NULL_HANDLE;
+    }
+
+    m_ownedViews = 0;
+    m_version = m_image->m_version.load(std::memory_order_acquire);
+    createViews();
   }
   
 }
@@ -68,6 +68,9 @@ namespace dxvk {
 
     // Shared handle info
     DxvkSharedHandleInfo sharing;
+
+    // Memory category used for memory accounting
+    DxvkMemoryCategory category = DxvkMemoryCategory::Auto;
   };
   
   
@@ -105,6 +108,54 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Image view handle key
+   *
+   * Stores the properties of a single Vulkan image
+   * view that was created for a given image. Used
+   * to look up view handles in the image's cache.
+   */
+  struct DxvkImageViewKey {
+    VkImageViewType         type;
+    VkFormat                format;
+    VkImageUsageFlags       usage;
+    VkComponentMapping      swizzle;
+    VkImageSubresourceRange subresources;
+
+    bool eq(const DxvkImageViewKey& other) const {
+      return type   == other.type
+          && format == other.format
+          && usage  == other.usage
+          && swizzle.r == other.swizzle.r
+          && swizzle.g == other.swizzle.g
+          && swizzle.b == other.swizzle.b
+          && swizzle.a == other.swizzle.a
+          && subresources.aspectMask     == other.subresources.aspectMask
+          && subresources.baseMipLevel   == other.subresources.baseMipLevel
+          && subresources.levelCount     == other.subresources.levelCount
+          && subresources.baseArrayLayer == other.subresources.baseArrayLayer
+          && subresources.layerCount     == other.subresources.layerCount;
+    }
+  };
+
+
+  /**
+   * \brief Depth store tracking info
+   *
+   * Used by the context to infer whether depth-stencil
+   * contents written by a render pass are ever read.
+   */
+  struct DxvkDepthStoreInfo {
+    /// Number of consecutive render passes that
+    /// did not load the previous depth contents
+    uint32_t discardCount = 0;
+    /// Whether the last render pass skipped the store
+    bool     storeSkipped = false;
+    /// Set once a skipped store would have been needed
+    bool     disabled     = false;
+  };
+
+
   /**
    * \brief Stores an image and its memory slice.
    */
@@ -124,6 +175,8 @@ namespace dxvk {
   class DxvkImage : public DxvkResource {
     friend class DxvkContext;
     friend class DxvkImageView;
+    /// Maximum number of cached view handles
+    constexpr static uint32_t MaxCachedViews = 16;
   public:
     
     DxvkImage(
@@ -193,10 +246,152 @@ namespace dxvk {
      * \param [in] offset Byte offset into mapped region
      * \returns Pointer to mapped memory region
      */
-    void* mapPtr(VkDeviceSize offset) const {
+    void* mapPtr(VkDeviceSize offset) {
+      ensureMemory();
       return m_image.memory.mapPtr(offset);
     }
+
+    /**
+     * \brief Checks whether memory is bound to the image
+     *
+     * Images created while lazy allocation is enabled
+     * only get their memory allocated on first use.
+     * \returns \c false if allocation is still pending
+     */
+    bool isAllocated() const {
+      return !m_allocPending.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Allocates and binds memory if necessary
+     *
+     * Must be called before the image is used in any
+     * Vulkan command or view creation. Views, mapping
+     * and image barriers already take care of this.
+     */
+    void ensureMemory() {
+      if (unlikely(m_allocPending.load(std::memory_order_acquire)))
+        allocateMemory();
+    }
+
+    /**
+     * \brief Checks whether initialization is pending
+     *
+     * Render targets created without initial data get
+     * their initial clear deferred to their first use,
+     * so that it can be folded into a render pass or
+     * skipped if the image gets overwritten entirely.
+     * \returns \c true if the image needs to be cleared
+     */
+    bool hasPendingInit() const {
+      return m_initPending.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Marks initialization as pending
+     */
+    void setPendingInit() {
+      m_initPending.store(true, std::memory_order_release);
+    }
+
+    /**
+     * \brief Claims pending initialization
+     *
+     * \returns \c true if initialization was pending and
+     *    the caller must now clear or overwrite the image
+     */
+    bool claimPendingInit() {
+      return m_initPending.exchange(false, std::memory_order_acq_rel);
+    }
+
+    /**
+     * \brief Queries layout of an unused image
+     *
+     * Newly created images are in their initial layout, while
+     * images handed out by the resource pool have already been
+     * transitioned to their default layout by a previous owner.
+     * \returns Layout of the image before its first use
+     */
+    VkImageLayout getUnusedLayout() const {
+      return m_unusedLayout;
+    }
+
+    /**
+     * \brief Sets layout of an unused image
+     * \param [in] layout Current image layout
+     */
+    void setUnusedLayout(VkImageLayout layout) {
+      m_unusedLayout = layout;
+    }
+
+    /**
+     * \brief Queries depth store tracking info
+     * \returns Depth store tracking info
+     */
+    DxvkDepthStoreInfo getDepthStoreInfo() const {
+      return m_depthStore;
+    }
+
+    /**
+     * \brief Updates depth store tracking info
+     *
+     * Must only be called from the context that
+     * renders to the image.
+     * \param [in] info New tracking info
+     */
+    void setDepthStoreInfo(const DxvkDepthStoreInfo& info) {
+      m_depthStore = info;
+    }
+
+    /**
+     * \brief Checks whether the image is sparse
+     *
+     * Sparse images have no memory bound on creation.
+     * \returns \c true if the image uses sparse binding
+     */
+    bool isSparse() const {
+      return (m_info.flags & VK_IMAGE_CREATE_SPARSE_BINDING_BIT) != 0;
+    }
     
+    /**
+     * \brief Checks whether the image can be recycled
+     *
+     * Shared, sparse and implementation-managed images
+     * must not be handed out to another resource.
+     * \returns \c true if the image can be recycled
+     */
+    bool canRecycle() const {
+      return !m_implManaged && !m_shared && !isSparse()
+          && !m_info.shared && m_info.sharing.mode == DxvkSharedHandleMode::None;
+    }
+
+    /**
+     * \brief Checks whether the image can be renamed
+     *
+     * Images that can be bound as attachments must keep
+     * their storage, since framebuffers and render pass
+     * state refer to the Vulkan image directly.
+     * \returns \c true if \ref rename can be used
+     */
+    bool canRename() const {
+      return canRecycle() && !(m_info.usage & (
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
+    }
+
+    /**
+     * \brief Replaces backing storage
+     *
+     * Swaps the Vulkan image, its memory and all cached
+     * views with those of another image with identical
+     * properties, which then owns the previous storage.
+     * Existing views pick up the new storage the next
+     * time their handles are queried. Must only be
+     * called from the context that uses the image.
+     * \param [in,out] storage Image providing the new storage
+     */
+    void rename(DxvkImage& storage);
+
     /**
      * \brief Image format info
      * \returns Image format info
@@ -331,11 +526,46 @@ namespace dxvk {
     VkMemoryPropertyFlags m_memFlags;
     DxvkPhysicalImage     m_image;
     bool m_shared = false;
+    bool m_implManaged = false;
+
+    DxvkMemoryAllocator*          m_memAlloc = nullptr;
+    DxvkMemoryFlags               m_memHints;
+    VkMemoryRequirements          m_memReq = { };
+    VkMemoryDedicatedRequirements m_dedicatedReq = { };
+
+    dxvk::mutex                   m_allocMutex;
+    std::atomic<bool>             m_allocPending = { false };
+    std::atomic<bool>             m_initPending = { false };
+
+    VkImageLayout                 m_unusedLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    DxvkDepthStoreInfo            m_depthStore;
 
     small_vector<VkFormat, 4> m_viewFormats;
+
+    dxvk::mutex               m_viewMutex;
+    std::vector<std::pair<DxvkImageViewKey, VkImageView>> m_viewCache;
+    std::vector<VkImageView>  m_retiredViews;
+
+    std::atomic<uint32_t>     m_version = { 0u };
     
     bool canShareImage(const VkImageCreateInfo&  createInfo, const DxvkSharedHandleInfo& sharingInfo) const;
 
+    DxvkMemoryCategory determineMemoryCategory() const;
+
+    void allocateMemory();
+
+    VkImageView lookupView(
+      const DxvkImageViewKey&       key);
+
+    bool insertView(
+      const DxvkImageViewKey&       key,
+            VkImageView             view,
+            VkImage                 image);
+
+    void retireView(
+            VkImageView             view);
+
   };
   
   
@@ -377,6 +607,8 @@ namespace dxvk {
     VkImageView handle(VkImageViewType viewType) const {
       if (unlikely(viewType == VK_IMAGE_VIEW_TYPE_MAX_ENUM))
         viewType = m_info.type;
+      if (unlikely(m_version != m_image->m_version.load(std::memory_order_acquire)))
+        updateViews();
       return m_views[viewType];
     }
     
@@ -558,13 +790,19 @@ namespace dxvk {
     Rc<DxvkImage>     m_image;
     
     DxvkImageViewCreateInfo m_info;
-    VkImageView             m_views[ViewCount];
+    mutable VkImageView     m_views[ViewCount];
+    mutable uint32_t        m_ownedViews = 0;
+    mutable uint32_t        m_version    = 0;
 
     uint64_t          m_cookie;
 
     static std::atomic<uint64_t> s_cookie;
 
-    void createView(VkImageViewType type, uint32_t numLayers);
+    void createViews() const;
+
+    void createView(VkImageViewType type, uint32_t numLayers) const;
+
+    void updateViews() const;
     
   };
   
@@ -10,6 +10,7 @@
 #include "../util/util_math.h"
 #include "../util/util_small_vector.h"
 #include "../util/util_string.h"
+#include "../util/util_trace.h"
 
 #include "../util/rc/util_rc.h"
 #include "../util/rc/util_rc_ptr.h"
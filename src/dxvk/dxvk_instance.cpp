@@ -48,7 +48,8 @@ namespace dxvk {
   
   
   DxvkInstance::~DxvkInstance() {
-    
+    sync::logLockStats();
+    trace::flush();
   }
   
   
@@ -0,0 +1,170 @@
+#include "dxvk_latency.h"
+
+namespace dxvk {
+
+  DxvkLatencyTracker::DxvkLatencyTracker(DxvkDevice* device) {
+
+  }
+
+
+  DxvkLatencyTracker::~DxvkLatencyTracker() {
+
+  }
+
+
+  uint64_t DxvkLatencyTracker::beginFrame(
+          high_resolution_clock::time_point presentTime) {
+    auto now = high_resolution_clock::now();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    // Frames that never retired, e.g. because presentation
+    // failed, will simply be overwritten by newer frames
+    uint64_t frameId = ++m_nextFrameId;
+
+    Frame& frame = m_frames[frameId % MaxFrames];
+    frame = Frame();
+    frame.frameId = frameId;
+
+    recordStage(frame, DxvkLatencyStage::AppPresent, presentTime);
+    recordStage(frame, DxvkLatencyStage::CsPresent, now);
+    return frameId;
+  }
+
+
+  void DxvkLatencyTracker::setSubmission(
+          uint64_t              frameId,
+          uint64_t              submissionId,
+          uint64_t              completedId) {
+    auto now = high_resolution_clock::now();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    Frame* frame = findFrame(frameId);
+
+    if (!frame)
+      return;
+
+    frame->submissionId  = submissionId;
+    frame->hasSubmission = true;
+
+    if (completedId >= submissionId)
+      recordStage(*frame, DxvkLatencyStage::GpuComplete, now);
+  }
+
+
+  void DxvkLatencyTracker::notifyStage(
+          uint64_t              frameId,
+          DxvkLatencyStage      stage) {
+    auto now = high_resolution_clock::now();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    Frame* frame = findFrame(frameId);
+
+    if (frame)
+      recordStage(*frame, stage, now);
+  }
+
+
+  void DxvkLatencyTracker::notifySubmissionComplete(
+          uint64_t              completedId) {
+    auto now = high_resolution_clock::now();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (auto& frame : m_frames) {
+      uint32_t stageBit = 1u << uint32_t(DxvkLatencyStage::GpuComplete);
+
+      if (frame.frameId && frame.hasSubmission
+       && !(frame.stageMask & stageBit)
+       && frame.submissionId <= completedId)
+        recordStage(frame, DxvkLatencyStage::GpuComplete, now);
+    }
+  }
+
+
+  DxvkLatencyStats DxvkLatencyTracker::getStats() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return m_stats;
+  }
+
+
+  std::chrono::microseconds DxvkLatencyTracker::getFrameStartDelay() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    return std::chrono::microseconds(m_frameDelay);
+  }
+
+
+  DxvkLatencyTracker::Frame* DxvkLatencyTracker::findFrame(
+          uint64_t              frameId) {
+    Frame& frame = m_frames[frameId % MaxFrames];
+
+    return frame.frameId == frameId
+      ? &frame : nullptr;
+  }
+
+
+  void DxvkLatencyTracker::recordStage(
+          Frame&                frame,
+          DxvkLatencyStage      stage,
+          high_resolution_clock::time_point time) {
+    frame.timestamps[uint32_t(stage)] = time;
+    frame.stageMask |= 1u << uint32_t(stage);
+
+    if (frame.stageMask == (1u << DxvkLatencyStageCount) - 1) {
+      finishFrame(frame);
+      frame.frameId = 0;
+    }
+  }
+
+
+  void DxvkLatencyTracker::finishFrame(
+    const Frame&                frame) {
+    auto delta = [&frame] (DxvkLatencyStage a, DxvkLatencyStage b) {
+      auto ta = frame.timestamps[uint32_t(a)];
+      auto tb = frame.timestamps[uint32_t(b)];
+
+      // The GPU may finish before the submission thread gets
+      // to the present, in which case there is no GPU time
+      return tb > ta ? uint64_t(std::chrono::duration_cast<
+        std::chrono::microseconds>(tb - ta).count()) : uint64_t(0);
+    };
+
+    auto presentTime = frame.timestamps[uint32_t(DxvkLatencyStage::AppPresent)];
+
+    if (m_lastPresentTime != high_resolution_clock::time_point()) {
+      m_stats.app = presentTime > m_lastPresentTime
+        ? uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(presentTime - m_lastPresentTime).count())
+        : uint64_t(0);
+    }
+
+    m_lastPresentTime = presentTime;
+
+    m_stats.cs      = delta(DxvkLatencyStage::AppPresent,  DxvkLatencyStage::CsPresent);
+    m_stats.queue   = delta(DxvkLatencyStage::CsPresent,   DxvkLatencyStage::QueueSubmit);
+    m_stats.gpu     = delta(DxvkLatencyStage::QueueSubmit, DxvkLatencyStage::GpuComplete);
+    m_stats.present = delta(DxvkLatencyStage::QueueSubmit, DxvkLatencyStage::QueuePresent);
+    m_stats.total   = std::max(
+      delta(DxvkLatencyStage::AppPresent, DxvkLatencyStage::GpuComplete),
+      delta(DxvkLatencyStage::AppPresent, DxvkLatencyStage::QueuePresent));
+
+    // Interval between GPU completions, which is the GPU frame
+    // time if we are GPU-bound, and an upper bound for the delay
+    auto gpuTime = frame.timestamps[uint32_t(DxvkLatencyStage::GpuComplete)];
+
+    if (m_lastGpuTime != high_resolution_clock::time_point() && gpuTime > m_lastGpuTime)
+      m_gpuInterval = std::chrono::duration_cast<std::chrono::microseconds>(gpuTime - m_lastGpuTime).count();
+
+    m_lastGpuTime = gpuTime;
+
+    // Grow the delay slowly while the GPU has plenty of work left,
+    // but back off quickly so that the GPU never goes idle for long
+    int64_t error = int64_t(m_stats.gpu) - LowLatencyMargin;
+
+    m_frameDelay += error > 0 ? error / 8 : error / 2;
+    m_frameDelay = std::max<int64_t>(m_frameDelay, 0);
+    m_frameDelay = std::min<int64_t>(m_frameDelay, std::max<int64_t>(m_gpuInterval - LowLatencyMargin, 0));
+  }
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+
+#include "dxvk_include.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Frame latency stage
+   *
+   * Points in time which are recorded for each
+   * presented frame, in the order in which they
+   * normally occur. GPU completion may happen
+   * after the present call returns.
+   */
+  enum class DxvkLatencyStage : uint32_t {
+    AppPresent    = 0,  ///< Application called Present
+    CsPresent     = 1,  ///< CS thread reached the present command
+    QueueSubmit   = 2,  ///< All prior command lists were submitted
+    QueuePresent  = 3,  ///< vkQueuePresentKHR returned
+    GpuComplete   = 4,  ///< GPU finished all prior command lists
+  };
+
+  constexpr uint32_t DxvkLatencyStageCount = 5;
+
+
+  /**
+   * \brief Frame latency breakdown
+   *
+   * All values are in microseconds. The app time is the
+   * interval between two consecutive Present calls, the
+   * other values are the time spent between two stages.
+   */
+  struct DxvkLatencyStats {
+    uint64_t app     = 0;
+    uint64_t cs      = 0;
+    uint64_t queue   = 0;
+    uint64_t gpu     = 0;
+    uint64_t present = 0;
+    uint64_t total   = 0;
+  };
+
+
+  /**
+   * \brief Frame latency tracker
+   *
+   * Records timestamps for each present as it moves
+   * from the application thread through the CS thread
+   * and the submission queue to the GPU, and computes
+   * a latency breakdown once a frame has fully retired.
+   * This class is thread-safe.
+   */
+  class DxvkLatencyTracker {
+    /// Maximum number of frames in flight that are tracked
+    constexpr static uint32_t MaxFrames = 16;
+    /// GPU work that should be left after the final
+    /// submission of a frame in low latency mode, in us
+    constexpr static int64_t LowLatencyMargin = 1000;
+  public:
+
+    DxvkLatencyTracker(DxvkDevice* device);
+
+    ~DxvkLatencyTracker();
+
+    /**
+     * \brief Begins tracking a frame
+     *
+     * Must be called when the CS thread executes the
+     * present command. Records the CS stage as well
+     * as the time the application called Present.
+     * \param [in] presentTime Time of the Present call
+     * \returns Frame ID to pass to subsequent calls
+     */
+    uint64_t beginFrame(
+            high_resolution_clock::time_point presentTime);
+
+    /**
+     * \brief Sets the last submission of a frame
+     *
+     * The frame is considered complete on the GPU
+     * once the given submission has completed.
+     * \param [in] frameId Frame ID
+     * \param [in] submissionId Last submission ID
+     * \param [in] completedId Last completed submission ID
+     */
+    void setSubmission(
+            uint64_t              frameId,
+            uint64_t              submissionId,
+            uint64_t              completedId);
+
+    /**
+     * \brief Records a stage for a frame
+     *
+     * \param [in] frameId Frame ID
+     * \param [in] stage The stage that was reached
+     */
+    void notifyStage(
+            uint64_t              frameId,
+            DxvkLatencyStage      stage);
+
+    /**
+     * \brief Notifies tracker of completed submissions
+     *
+     * Records GPU completion for all frames whose
+     * last submission has completed.
+     * \param [in] completedId Last completed submission ID
+     */
+    void notifySubmissionComplete(
+            uint64_t              completedId);
+
+    /**
+     * \brief Queries latency of the last completed frame
+     * \returns Latency breakdown
+     */
+    DxvkLatencyStats getStats();
+
+    /**
+     * \brief Computes frame start delay for low latency mode
+     *
+     * If the GPU still has work left to do by the time a frame's
+     * final submission arrives, anything the application did
+     * after that work was submitted only adds latency, so the
+     * next frame can start later by roughly that amount. The
+     * delay adapts slowly and decreases as soon as the GPU
+     * would otherwise run out of work.
+     * \returns Time to delay the next frame by
+     */
+    std::chrono::microseconds getFrameStartDelay();
+
+  private:
+
+    struct Frame {
+      uint64_t frameId      = 0;
+      uint64_t submissionId = 0;
+      bool     hasSubmission = false;
+      uint32_t stageMask    = 0;
+      std::array<high_resolution_clock::time_point, DxvkLatencyStageCount> timestamps;
+    };
+
+    dxvk::mutex                       m_mutex;
+    std::array<Frame, MaxFrames>      m_frames;
+    uint64_t                          m_nextFrameId = 0;
+
+    high_resolution_clock::time_point m_lastPresentTime;
+    high_resolution_clock::time_point m_lastGpuTime;
+    DxvkLatencyStats                  m_stats;
+
+    int64_t                           m_gpuInterval = 0;
+    int64_t                           m_frameDelay  = 0;
+
+    Frame* findFrame(
+            uint64_t              frameId);
+
+    void recordStage(
+            Frame&                frame,
+            DxvkLatencyStage      stage,
+            high_resolution_clock::time_point time);
+
+    void finishFrame(
+      const Frame&                frame);
+
+  };
+
+}
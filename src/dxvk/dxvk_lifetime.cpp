@@ -1,18 +1,22 @@
 #include "dxvk_lifetime.h"
 
 namespace dxvk {
-  
+
+  std::atomic<uint64_t> DxvkLifetimeTracker::s_epochCounter = { 0ull };
+
   DxvkLifetimeTracker:: DxvkLifetimeTracker() { }
   DxvkLifetimeTracker::~DxvkLifetimeTracker() { }
   
   
   void DxvkLifetimeTracker::notify() {
     m_resources.clear();
+    m_epoch = nextEpoch();
   }
 
 
   void DxvkLifetimeTracker::reset() {
     m_resources.clear();
+    m_epoch = nextEpoch();
   }
   
 }
\ No newline at end of file
@@ -87,6 +87,10 @@ namespace dxvk {
    * used to guarantee that resources are not destroyed
    * or otherwise accessed in an unsafe manner until the
    * device has finished using them.
+   *
+   * Each tracker uses a unique epoch that changes whenever
+   * its references are dropped, so that resources used many
+   * times within one command list only get acquired once.
    */
   class DxvkLifetimeTracker {
     
@@ -101,7 +105,8 @@ namespace dxvk {
      */
     template<DxvkAccess Access>
     void trackResource(DxvkResource* rc) {
-      m_resources.emplace_back(rc, Access);
+      if (rc->trackEpoch(Access, m_epoch))
+        m_resources.emplace_back(rc, Access);
     }
 
     /**
@@ -120,8 +125,15 @@ namespace dxvk {
     void reset();
     
   private:
-    
+
+    static std::atomic<uint64_t> s_epochCounter;
+
+    uint64_t                  m_epoch = nextEpoch();
     std::vector<DxvkLifetime> m_resources;
+
+    static uint64_t nextEpoch() {
+      return ++s_epochCounter;
+    }
     
   };
   
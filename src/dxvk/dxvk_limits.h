@@ -19,6 +19,10 @@ namespace dxvk {
     MaxUniformBufferSize        = 65536,
     MaxVertexBindingStride      =  2048,
     MaxPushConstantSize         =   128,
+    MaxNumUniformBuffersDynamic =     8,
+    MaxNumPushDescriptors       =     8,
+    MaxNumInlineUniformBlocks   =     4,
+    MaxInlineUniformBlockSize   =   256,
   };
   
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <iomanip>
 
 #include "dxvk_device.h"
 #include "dxvk_memory.h"
 
+#include "../util/util_bit.h"
+
 namespace dxvk {
   
   DxvkMemory::DxvkMemory() { }
@@ -13,14 +16,16 @@ namespace dxvk {
           VkDeviceMemory        memory,
           VkDeviceSize          offset,
           VkDeviceSize          length,
-          void*                 mapPtr)
+          void*                 mapPtr,
+          uint64_t              cacheKey)
   : m_alloc   (alloc),
     m_chunk   (chunk),
     m_type    (type),
     m_memory  (memory),
     m_offset  (offset),
     m_length  (length),
-    m_mapPtr  (mapPtr) { }
+    m_mapPtr  (mapPtr),
+    m_cacheKey(cacheKey) { }
   
   
   DxvkMemory::DxvkMemory(DxvkMemory&& other)
@@ -30,7 +35,9 @@ namespace dxvk {
     m_memory  (std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE))),
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
-    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)) { }
+    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)),
+    m_cacheKey(std::exchange(other.m_cacheKey, 0)),
+    m_category(other.m_category) { }
   
   
   DxvkMemory& DxvkMemory::operator = (DxvkMemory&& other) {
@@ -42,6 +49,8 @@ namespace dxvk {
     m_offset  = std::exchange(other.m_offset, 0);
     m_length  = std::exchange(other.m_length, 0);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
+    m_cacheKey = std::exchange(other.m_cacheKey, 0);
+    m_category = other.m_category;
     return *this;
   }
   
@@ -62,13 +71,16 @@ namespace dxvk {
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory,
           DxvkMemoryFlags       hints)
-  : m_alloc(alloc), m_type(type), m_memory(memory), m_hints(hints) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory), m_hints(hints),
+    m_allocator(memory.memSize) {
+
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
+    if (m_relocated)
+      m_type->heap->stats.memoryReclaimed += m_memory.memSize;
+
     // This call is technically not thread-safe, but it
     // doesn't need to be since we don't free chunks
     m_alloc->freeDeviceMemory(m_type, m_memory);
@@ -79,52 +91,24 @@ namespace dxvk {
           VkMemoryPropertyFlags flags,
           VkDeviceSize          size,
           VkDeviceSize          align,
-          DxvkMemoryFlags       hints) {
+          DxvkMemoryFlags       hints,
+          uint32_t              tag) {
     // Property flags must be compatible. This could
     // be refined a bit in the future if necessary.
     if (m_memory.memFlags != flags || !checkHints(hints))
       return DxvkMemory();
     
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
-      return DxvkMemory();
-    
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
+    // Pad the allocation size to the requested alignment
+    // so that the slice can be bound to aligned resources
+    const VkDeviceSize allocSize  = dxvk::align(size, align);
+    const VkDeviceSize allocStart = m_allocator.alloc(allocSize, align, tag);
     
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    if (allocStart == DxvkTlsfAllocator::InvalidOffset)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
     // Create the memory object with the aligned slice
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
+      m_memory.memHandle, allocStart, allocSize,
       reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
   }
   
@@ -132,31 +116,19 @@ namespace dxvk {
   void DxvkMemoryChunk::free(
           VkDeviceSize  offset,
           VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+    // Adjacent free ranges are merged by the allocator
+    // so that they can be reused for larger allocations
+    m_allocator.free(offset);
   }
   
   
   bool DxvkMemoryChunk::isEmpty() const {
-    return m_freeList.size() == 1
-        && m_freeList[0].length == m_memory.memSize;
+    return m_allocator.isEmpty();
+  }
+
+
+  bool DxvkMemoryChunk::isSparse() const {
+    return 2 * m_allocator.used() < m_allocator.capacity();
   }
 
 
@@ -175,6 +147,10 @@ namespace dxvk {
     if (hints.test(DxvkMemoryFlag::IgnoreConstraints))
       mask = DxvkMemoryFlags();
 
+    // Never mix linear and non-linear resources within a chunk,
+    // otherwise we would have to respect bufferImageGranularity
+    mask.set(DxvkMemoryFlag::ImageOptimal);
+
     return (m_hints & mask) == (hints & mask);
   }
 
@@ -184,6 +160,11 @@ namespace dxvk {
     m_device          (device),
     m_devProps        (device->adapter()->deviceProperties()),
     m_memProps        (device->adapter()->memoryProperties()) {
+    sync::setLockName(m_mutex, "DxvkMemoryAllocator");
+
+    for (auto& shard : m_cacheShards)
+      sync::setLockName(shard.mutex, "DxvkMemoryAllocator::cacheShard");
+
     for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
       m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
@@ -232,6 +213,34 @@ namespace dxvk {
         }
       }
     }
+
+    /* CPU-written resources such as dynamic and constant buffers
+     * request device-local, host-visible memory. Only let them use
+     * a portion of that memory so that they cannot crowd out other
+     * resources, or exhaust small 256 MB BAR heaps entirely. */
+    VkMemoryPropertyFlags barFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !m_barHeap; i++) {
+      if ((m_memTypes[i].memType.propertyFlags & barFlags) == barFlags)
+        m_barHeap = m_memTypes[i].heap;
+    }
+
+    if (m_barHeap) {
+      bool isLargeBar = m_barHeap->properties.size >= largestDeviceLocalHeap;
+
+      if (m_device->isUnifiedMemoryArchitecture())
+        m_barBudget = m_barHeap->properties.size;
+      else if (isLargeBar)
+        m_barBudget = m_barHeap->properties.size / 4;
+      else
+        m_barBudget = (m_barHeap->properties.size * 3) / 4;
+
+      if (m_device->config().maxBarMemory >= 0)
+        m_barBudget = std::min(m_barBudget, VkDeviceSize(m_device->config().maxBarMemory) << 20);
+
+      if (m_barHeap->budget)
+        m_barBudget = std::min(m_barBudget, m_barHeap->budget);
+    }
   }
   
   
@@ -245,9 +254,27 @@ namespace dxvk {
     const VkMemoryDedicatedRequirements&    dedAllocReq,
     const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
-          DxvkMemoryFlags                   hints) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
+          DxvkMemoryFlags                   hints,
+          DxvkMemoryCategory                category) {
+    DxvkMemory result = this->allocMemory(
+      req, dedAllocReq, dedAllocInfo, flags, hints, category);
+
+    if (result) {
+      result.m_category = category;
+      result.m_type->categoryUsed[uint32_t(category)] += result.m_length;
+    }
 
+    return result;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::allocMemory(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedRequirements&    dedAllocReq,
+    const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+          VkMemoryPropertyFlags             flags,
+          DxvkMemoryFlags                   hints,
+          DxvkMemoryCategory                category) {
     // Keep small allocations together to avoid fragmenting
     // chunks for larger resources with lots of small gaps,
     // as well as resources with potentially weird lifetimes
@@ -259,22 +286,63 @@ namespace dxvk {
     // Ignore most hints for host-visible allocations since they
     // usually don't make much sense for those resources
     if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
-      hints = hints & DxvkMemoryFlag::Transient;
+      hints = hints & DxvkMemoryFlags(DxvkMemoryFlag::Transient, DxvkMemoryFlag::ImageOptimal);
+
+    // Decide whether to use a dedicated allocation based on the
+    // resource size rather than only on what the driver prefers
+    bool useDedicated = shouldUseDedicatedAllocation(req, dedAllocReq);
+
+    // Only place CPU-written resources in BAR memory while it is
+    // under budget, otherwise write to system memory directly.
+    VkMemoryPropertyFlags barFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                   | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    if ((flags & barFlags) == barFlags
+     && !hints.test(DxvkMemoryFlag::Relocate)
+     && !this->checkBarBudget(req->size))
+      flags &= ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    // Try to serve small allocations from the per-thread caches
+    // first so that we do not have to lock the entire allocator
+    if (req->size <= SmallAllocationThreshold
+     && req->alignment <= CacheBlockAlignment
+     && !useDedicated
+     && !hints.test(DxvkMemoryFlag::ImageOptimal)
+     && !hints.test(DxvkMemoryFlag::Relocate)
+     && !hints.test(DxvkMemoryFlag::Evict)) {
+      DxvkMemory result = this->tryAllocFromCache(req, flags, hints);
+
+      if (result)
+        return result;
+    }
+
+    auto lock = this->lockAllocator();
+    uint32_t tag = uint32_t(category);
+
+    // Relocated resources must be moved into existing chunks
+    // without any fallback, or defragmentation would be useless
+    if (hints.test(DxvkMemoryFlag::Relocate))
+      return this->tryAlloc(req, nullptr, flags, hints, tag);
+
+    // Evicted resources must not end up in device-local
+    // memory, or eviction would not free up anything
+    if (hints.test(DxvkMemoryFlag::Evict))
+      return this->tryAlloc(req, nullptr, flags & ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, hints, tag);
 
     // Try to allocate from a memory type which supports the given flags exactly
-    auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
-    DxvkMemory result = this->tryAlloc(req, dedAllocPtr, flags, hints);
+    auto dedAllocPtr = useDedicated ? &dedAllocInfo : nullptr;
+    DxvkMemory result = this->tryAlloc(req, dedAllocPtr, flags, hints, tag);
 
     // If the first attempt failed, try ignoring the dedicated allocation
     if (!result && dedAllocPtr && !dedAllocReq.requiresDedicatedAllocation) {
-      result = this->tryAlloc(req, nullptr, flags, hints);
+      result = this->tryAlloc(req, nullptr, flags, hints, tag);
       dedAllocPtr = nullptr;
     }
 
     // Retry without the hint constraints
     if (!result) {
       hints.set(DxvkMemoryFlag::IgnoreConstraints);
-      result = this->tryAlloc(req, nullptr, flags, hints);
+      result = this->tryAlloc(req, nullptr, flags, hints, tag);
     }
 
     // If that still didn't work, probe slower memory types as well
@@ -286,7 +354,7 @@ namespace dxvk {
       remFlags |= optFlags & -optFlags;
       optFlags &= ~remFlags;
 
-      result = this->tryAlloc(req, dedAllocPtr, flags & ~remFlags, hints);
+      result = this->tryAlloc(req, dedAllocPtr, flags & ~remFlags, hints, tag);
     }
     
     if (!result) {
@@ -323,16 +391,19 @@ namespace dxvk {
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
-          DxvkMemoryFlags                   hints) {
+          DxvkMemoryFlags                   hints,
+          uint32_t                          tag) {
     DxvkMemory result;
 
     for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !result; i++) {
       const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
       const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+      const bool evictable = !hints.test(DxvkMemoryFlag::Evict)
+        || !(m_memTypes[i].memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
       
-      if (supported && adequate) {
+      if (supported && adequate && evictable) {
         result = this->tryAllocFromType(&m_memTypes[i],
-          flags, req->size, req->alignment, hints, dedAllocInfo);
+          flags, req->size, req->alignment, hints, tag, dedAllocInfo);
       }
     }
     
@@ -346,12 +417,20 @@ namespace dxvk {
           VkDeviceSize                      size,
           VkDeviceSize                      align,
           DxvkMemoryFlags                   hints,
+          uint32_t                          tag,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo) {
     VkDeviceSize chunkSize = pickChunkSize(type->memTypeId, hints);
 
     DxvkMemory memory;
 
-    if (size >= chunkSize || dedAllocInfo) {
+    if (hints.test(DxvkMemoryFlag::Relocate)) {
+      // Skip sparse chunks since those are the ones we want
+      // to free, and do not allocate any new device memory
+      for (uint32_t i = 0; i < type->chunks.size() && !memory; i++) {
+        if (!type->chunks[i]->isSparse())
+          memory = type->chunks[i]->alloc(flags, size, align, hints, tag);
+      }
+    } else if (size >= chunkSize || dedAllocInfo) {
       if (this->shouldFreeEmptyChunks(type->heap, size))
         this->freeEmptyChunks(type->heap);
 
@@ -362,7 +441,7 @@ namespace dxvk {
         memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
     } else {
       for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
-        memory = type->chunks[i]->alloc(flags, size, align, hints);
+        memory = type->chunks[i]->alloc(flags, size, align, hints, tag);
       
       if (!memory) {
         DxvkDeviceMemory devMem;
@@ -375,15 +454,17 @@ namespace dxvk {
 
         if (devMem.memHandle) {
           Rc<DxvkMemoryChunk> chunk = new DxvkMemoryChunk(this, type, devMem, hints);
-          memory = chunk->alloc(flags, size, align, hints);
+          memory = chunk->alloc(flags, size, align, hints, tag);
 
           type->chunks.push_back(std::move(chunk));
         }
       }
     }
 
-    if (memory)
+    if (memory) {
       type->heap->stats.memoryUsed += memory.m_length;
+      trackMappedMemory(type, memory.m_mapPtr, memory.m_length);
+    }
 
     return memory;
   }
@@ -413,9 +494,15 @@ namespace dxvk {
     result.memFlags = flags;
     result.priority = priority;
 
+    // Memory bound to buffers with device address
+    // usage must support device addresses as well
+    VkMemoryAllocateFlagsInfo flagsInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO };
+    flagsInfo.pNext       = dedAllocInfo;
+    flagsInfo.flags       = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
     VkMemoryPriorityAllocateInfoEXT prio;
     prio.sType            = VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT;
-    prio.pNext            = dedAllocInfo;
+    prio.pNext            = m_device->canUseBufferDeviceAddress() ? &flagsInfo : flagsInfo.pNext;
     prio.priority         = priority;
 
     VkMemoryAllocateInfo info;
@@ -443,10 +530,207 @@ namespace dxvk {
   }
 
 
-  void DxvkMemoryAllocator::free(
+  DxvkMemoryCategoryStats DxvkMemoryAllocator::getTypeCategoryStats(uint32_t type) const {
+    DxvkMemoryCategoryStats result;
+
+    for (uint32_t i = 0; i < DxvkMemoryCategoryCount; i++)
+      result.memoryUsed[i] = m_memTypes[type].categoryUsed[i].load();
+
+    return result;
+  }
+
+
+  DxvkMemoryCategoryStats DxvkMemoryAllocator::getHeapCategoryStats(uint32_t heap) const {
+    DxvkMemoryCategoryStats result;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      if (m_memTypes[i].heapId != heap)
+        continue;
+
+      for (uint32_t j = 0; j < DxvkMemoryCategoryCount; j++)
+        result.memoryUsed[j] += m_memTypes[i].categoryUsed[j].load();
+    }
+
+    return result;
+  }
+
+
+  const char* DxvkMemoryAllocator::getCategoryName(
+          DxvkMemoryCategory    category) {
+    switch (category) {
+      case DxvkMemoryCategory::RenderTarget:    return "render_targets";
+      case DxvkMemoryCategory::Texture:         return "textures";
+      case DxvkMemoryCategory::VertexIndex:     return "vertex_index_buffers";
+      case DxvkMemoryCategory::Constant:        return "constant_buffers";
+      case DxvkMemoryCategory::Staging:         return "staging";
+      case DxvkMemoryCategory::ShaderInternal:  return "shader_internal";
+      case DxvkMemoryCategory::Meta:            return "meta";
+      default:                                  return "unknown";
+    }
+  }
+
+
+  DxvkMemoryCacheStats DxvkMemoryAllocator::getCacheStats() const {
+    DxvkMemoryCacheStats result;
+    result.cacheHits            = m_cacheHits.load();
+    result.cacheMisses          = m_cacheMisses.load();
+    result.cacheLockContention  = m_cacheLockContention.load();
+    result.allocLockContention  = m_allocLockContention.load();
+    return result;
+  }
+
+
+  DxvkMappedMemoryStats DxvkMemoryAllocator::getMappedStats() const {
+    DxvkMappedMemoryStats result;
+    result.barUsed    = m_barUsed.load();
+    result.barBudget  = m_barBudget;
+    result.sysmemUsed = m_sysmemUsed.load();
+    return result;
+  }
+
+
+  bool DxvkMemoryAllocator::canRelocate(
+    const DxvkMemory&           memory) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    // Cached blocks would not be returned to the chunk on free
+    return memory.m_chunk != nullptr
+        && memory.m_cacheKey == 0
+        && memory.m_chunk->isSparse();
+  }
+
+
+  void DxvkMemoryAllocator::notifyRelocation(
     const DxvkMemory&           memory) {
     std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (memory.m_chunk != nullptr)
+      memory.m_chunk->markRelocated();
+  }
+
+
+  void DxvkMemoryAllocator::writeMemoryMap(
+          std::ostream&         stream) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+      const DxvkMemoryHeap& heap = m_memHeaps[i];
+
+      stream << "Heap " << i << ": "
+        << formatSize(heap.properties.size) << " total, "
+        << formatSize(heap.stats.memoryAllocated) << " allocated, "
+        << formatSize(heap.stats.memoryUsed) << " used" << std::endl;
+
+      VkDeviceSize heapChunkUsed = 0;
+      VkDeviceSize heapFree = 0;
+      VkDeviceSize heapLargestFree = 0;
+
+      for (uint32_t j = 0; j < m_memProps.memoryTypeCount; j++) {
+        const DxvkMemoryType& type = m_memTypes[j];
+
+        if (type.heapId != i)
+          continue;
+
+        stream << "  Memory type " << j << " (flags 0x" << std::hex
+          << type.memType.propertyFlags << std::dec << "): "
+          << type.chunks.size() << " chunks" << std::endl;
+
+        for (size_t k = 0; k < type.chunks.size(); k++) {
+          const DxvkMemoryChunk& chunk = *type.chunks[k];
+          auto ranges = chunk.getRanges();
+
+          VkDeviceSize totalFree = 0;
+          VkDeviceSize largestFree = 0;
+          uint32_t freeCount = 0;
+
+          for (const auto& range : ranges) {
+            if (range.isFree) {
+              totalFree += range.length;
+              largestFree = std::max(largestFree, range.length);
+              freeCount += 1;
+            }
+          }
+
+          // 0 if all free memory is in one block, close to 1
+          // if it is scattered across many small blocks
+          double fragmentation = totalFree
+            ? 1.0 - double(largestFree) / double(totalFree)
+            : 0.0;
+
+          stream << "    Chunk " << k << ": "
+            << formatSize(chunk.size()) << ", "
+            << formatSize(chunk.used()) << " used, "
+            << getChunkOwnerName(chunk.hints()) << ", "
+            << freeCount << " free ranges, largest "
+            << formatSize(largestFree) << ", fragmentation "
+            << str::format(std::fixed, std::setprecision(2), fragmentation) << std::endl;
+
+          // Merge adjacent allocations of the same category,
+          // chunks may contain many thousands of small ones
+          for (size_t r = 0; r < ranges.size(); ) {
+            const auto& first = ranges[r];
+
+            VkDeviceSize length = 0;
+            uint32_t count = 0;
+
+            while (r < ranges.size()
+                && ranges[r].isFree == first.isFree
+                && ranges[r].tag == first.tag) {
+              length += ranges[r++].length;
+              count += 1;
+            }
+
+            stream << "      0x" << std::hex << std::setfill('0') << std::setw(10)
+              << first.offset << std::dec << std::setfill(' ') << ' '
+              << std::setw(12) << formatSize(length) << ' ';
+
+            if (first.isFree)
+              stream << "free";
+            else if (first.tag == CacheBlockTag)
+              stream << "cache";
+            else
+              stream << getCategoryName(DxvkMemoryCategory(first.tag));
+
+            if (!first.isFree && count > 1)
+              stream << " (" << count << " allocations)";
+
+            stream << std::endl;
+          }
+
+          heapChunkUsed += chunk.used();
+          heapFree += totalFree;
+          heapLargestFree = std::max(heapLargestFree, largestFree);
+        }
+      }
+
+      double heapFragmentation = heapFree
+        ? 1.0 - double(heapLargestFree) / double(heapFree)
+        : 0.0;
+
+      stream << "  Free in chunks: " << formatSize(heapFree)
+        << ", largest free block " << formatSize(heapLargestFree)
+        << ", fragmentation " << str::format(std::fixed, std::setprecision(2), heapFragmentation) << std::endl;
+
+      // Everything not in a chunk is a dedicated allocation
+      stream << "  Dedicated allocations: "
+        << formatSize(heap.stats.memoryUsed - heapChunkUsed) << std::endl;
+      stream << std::endl;
+    }
+  }
+
+
+  void DxvkMemoryAllocator::free(
+    const DxvkMemory&           memory) {
+    memory.m_type->categoryUsed[uint32_t(memory.m_category)] -= memory.m_length;
+
+    if (memory.m_cacheKey) {
+      this->freeCachedMemory(memory);
+      return;
+    }
+
+    auto lock = this->lockAllocator();
     memory.m_type->heap->stats.memoryUsed -= memory.m_length;
+    trackMappedMemory(memory.m_type, memory.m_mapPtr, -int64_t(memory.m_length));
 
     if (memory.m_chunk != nullptr) {
       this->freeChunkMemory(
@@ -494,6 +778,20 @@ namespace dxvk {
   }
 
 
+  bool DxvkMemoryAllocator::shouldUseDedicatedAllocation(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedRequirements&    dedAllocReq) const {
+    if (dedAllocReq.requiresDedicatedAllocation)
+      return true;
+
+    // Drivers tend to prefer dedicated allocations for all render
+    // targets, even tiny ones. Honour that only for large resources,
+    // since allocation count limits are easily exceeded otherwise.
+    return dedAllocReq.prefersDedicatedAllocation
+        && req->size >= MinDedicatedAllocationSize;
+  }
+
+
   VkDeviceSize DxvkMemoryAllocator::pickChunkSize(uint32_t memTypeId, DxvkMemoryFlags hints) const {
     VkMemoryType type = m_memProps.memoryTypes[memTypeId];
     VkMemoryHeap heap = m_memProps.memoryHeaps[type.heapIndex];
@@ -550,6 +848,10 @@ namespace dxvk {
 
   void DxvkMemoryAllocator::freeEmptyChunks(
     const DxvkMemoryHeap*       heap) {
+    // Cached blocks keep their chunks alive, so return
+    // them first in order to actually free some memory
+    this->drainCaches();
+
     for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
       DxvkMemoryType* type = &m_memTypes[i];
 
@@ -563,4 +865,275 @@ namespace dxvk {
     }
   }
 
+
+  std::string DxvkMemoryAllocator::getChunkOwnerName(
+          DxvkMemoryFlags       hints) {
+    std::string result = hints.test(DxvkMemoryFlag::ImageOptimal) ? "images" : "buffers";
+
+    if (hints.test(DxvkMemoryFlag::Small))
+      result += " (small)";
+    if (hints.test(DxvkMemoryFlag::Transient))
+      result += " (transient)";
+
+    return result;
+  }
+
+
+  std::string DxvkMemoryAllocator::formatSize(
+          VkDeviceSize          size) {
+    if (size >= (VkDeviceSize(1) << 20))
+      return str::format(std::fixed, std::setprecision(2), double(size) / double(1 << 20), " MiB");
+    if (size >= (VkDeviceSize(1) << 10))
+      return str::format(std::fixed, std::setprecision(2), double(size) / double(1 << 10), " KiB");
+
+    return str::format(size, " B");
+  }
+
+
+  std::unique_lock<dxvk::mutex> DxvkMemoryAllocator::lockAllocator() {
+    std::unique_lock<dxvk::mutex> lock(m_mutex, std::try_to_lock);
+
+    if (unlikely(!lock.owns_lock())) {
+      m_allocLockContention += 1;
+      lock.lock();
+    }
+
+    return lock;
+  }
+
+
+  bool DxvkMemoryAllocator::checkBarBudget(
+          VkDeviceSize          size) const {
+    return m_barUsed.load() + size <= m_barBudget;
+  }
+
+
+  void DxvkMemoryAllocator::trackMappedMemory(
+    const DxvkMemoryType*       type,
+    const void*                 mapPtr,
+          int64_t               size) {
+    // Only memory allocated with the host-visible
+    // property flag is persistently mapped
+    if (!mapPtr)
+      return;
+
+    if (type->memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+      m_barUsed += size;
+    else
+      m_sysmemUsed += size;
+  }
+
+
+  DxvkMemoryAllocator::CacheShard& DxvkMemoryAllocator::getCacheShard() {
+    // Thread IDs on Windows are multiples of four, so using them
+    // directly would only ever hit a fraction of the shards. Mix
+    // the bits with a multiplicative hash and use the top bits.
+    static_assert((CacheShardCount & (CacheShardCount - 1)) == 0);
+
+    uint32_t hash = dxvk::this_thread::get_id() * 0x9E3779B1u;
+    return m_cacheShards[hash >> (32 - bit::tzcnt(CacheShardCount))];
+  }
+
+
+  std::unique_lock<sync::Spinlock> DxvkMemoryAllocator::lockCacheShard(
+          CacheShard&           shard) {
+    std::unique_lock<sync::Spinlock> lock(shard.mutex, std::try_to_lock);
+
+    if (unlikely(!lock.owns_lock())) {
+      m_cacheLockContention += 1;
+      lock.lock();
+    }
+
+    return lock;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::tryAllocFromCache(
+    const VkMemoryRequirements*             req,
+          VkMemoryPropertyFlags             flags,
+          DxvkMemoryFlags                   hints) {
+    // Only use the memory type that a regular allocation would
+    // use first, since the cache cannot handle any fallbacks
+    DxvkMemoryType* type = nullptr;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !type; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+
+      if (supported && adequate)
+        type = &m_memTypes[i];
+    }
+
+    if (!type)
+      return DxvkMemory();
+
+    uint32_t     cacheClass = getCacheClass(req->size);
+    VkDeviceSize cacheSize  = getCacheClassSize(cacheClass);
+    uint64_t     cacheKey   = getCacheKey(type->memTypeId, flags, hints, cacheClass);
+
+    // Pick a shard based on the calling thread, so that threads
+    // allocating at the same time rarely contend for the same lock
+    CacheShard& shard = this->getCacheShard();
+
+    { auto lock = this->lockCacheShard(shard);
+      auto entry = shard.lists.find(cacheKey);
+
+      if (entry != shard.lists.end() && !entry->second.empty()) {
+        CacheBlock block = entry->second.back();
+        entry->second.pop_back();
+
+        m_cacheHits += 1;
+
+        return DxvkMemory(this, block.chunk, block.type,
+          block.memory, block.offset, cacheSize, block.mapPtr, cacheKey);
+      }
+    }
+
+    m_cacheMisses += 1;
+
+    // Refill the cache with a batch of blocks. Do this without
+    // holding the shard lock to keep the lock order consistent.
+    uint32_t refillCount = uint32_t(std::max<VkDeviceSize>(1,
+      std::min<VkDeviceSize>(CacheRefillMaxCount, CacheRefillSize / cacheSize)));
+
+    std::vector<CacheBlock> blocks;
+    blocks.reserve(refillCount);
+
+    DxvkMemory result;
+
+    { auto lock = this->lockAllocator();
+
+      for (uint32_t i = 0; i < refillCount && !result; i++) {
+        DxvkMemory memory = this->tryAllocFromType(type,
+          flags, cacheSize, CacheBlockAlignment, hints, CacheBlockTag, nullptr);
+
+        if (!memory)
+          break;
+
+        // Only sub-allocated memory can be reused this way, return
+        // anything else to the caller as a regular allocation
+        if (!memory.m_chunk) {
+          result = std::move(memory);
+          break;
+        }
+
+        blocks.push_back({ memory.m_chunk, memory.m_type,
+          memory.m_memory, memory.m_offset, memory.m_mapPtr });
+
+        // Ownership of the block is now with the cache
+        memory.m_alloc = nullptr;
+      }
+    }
+
+    if (!result && !blocks.empty()) {
+      CacheBlock block = blocks.back();
+      blocks.pop_back();
+
+      result = DxvkMemory(this, block.chunk, block.type,
+        block.memory, block.offset, cacheSize, block.mapPtr, cacheKey);
+    }
+
+    if (!blocks.empty()) {
+      auto lock = this->lockCacheShard(shard);
+      auto& list = shard.lists[cacheKey];
+      list.insert(list.end(), blocks.begin(), blocks.end());
+    }
+
+    return result;
+  }
+
+
+  void DxvkMemoryAllocator::freeCachedMemory(
+    const DxvkMemory&           memory) {
+    CacheShard& shard = this->getCacheShard();
+
+    uint32_t refillCount = uint32_t(std::max<VkDeviceSize>(1,
+      std::min<VkDeviceSize>(CacheRefillMaxCount, CacheRefillSize / memory.m_length)));
+
+    std::vector<CacheBlock> blocks;
+
+    { auto lock = this->lockCacheShard(shard);
+      auto& list = shard.lists[memory.m_cacheKey];
+
+      list.push_back({ memory.m_chunk, memory.m_type,
+        memory.m_memory, memory.m_offset, memory.m_mapPtr });
+
+      // Return excess blocks to their chunks so that
+      // the cache does not grow without bounds
+      if (list.size() > 2 * refillCount) {
+        blocks.assign(list.begin() + refillCount, list.end());
+        list.resize(refillCount);
+      }
+    }
+
+    if (!blocks.empty()) {
+      auto lock = this->lockAllocator();
+      this->freeCacheBlocks(blocks, memory.m_length);
+    }
+  }
+
+
+  void DxvkMemoryAllocator::freeCacheBlocks(
+    const std::vector<CacheBlock>& blocks,
+          VkDeviceSize          size) {
+    for (const auto& block : blocks) {
+      block.type->heap->stats.memoryUsed -= size;
+      trackMappedMemory(block.type, block.mapPtr, -int64_t(size));
+      this->freeChunkMemory(block.type, block.chunk, block.offset, size);
+    }
+  }
+
+
+  void DxvkMemoryAllocator::drainCaches() {
+    for (auto& shard : m_cacheShards) {
+      auto lock = this->lockCacheShard(shard);
+
+      for (auto& list : shard.lists) {
+        VkDeviceSize size = getCacheClassSize(uint32_t(list.first >> 32) & 0xff);
+
+        this->freeCacheBlocks(list.second, size);
+        list.second.clear();
+      }
+    }
+  }
+
+
+  uint32_t DxvkMemoryAllocator::getCacheClass(
+          VkDeviceSize          size) {
+    // Two size classes per power of two, starting at the block
+    // alignment, which limits the amount of wasted memory
+    if (size <= CacheBlockAlignment)
+      return 0;
+
+    uint32_t msb = 63 - bit::lzcnt(uint64_t(size - 1));
+    uint32_t octave = msb - bit::tzcnt(uint64_t(CacheBlockAlignment));
+
+    return 2 * octave + (size <= (VkDeviceSize(3) << (msb - 1)) ? 1 : 2);
+  }
+
+
+  VkDeviceSize DxvkMemoryAllocator::getCacheClassSize(
+          uint32_t              cacheClass) {
+    return (cacheClass & 1)
+      ? (3 * CacheBlockAlignment / 2) << (cacheClass >> 1)
+      : (CacheBlockAlignment) << (cacheClass >> 1);
+  }
+
+
+  uint64_t DxvkMemoryAllocator::getCacheKey(
+          uint32_t              memTypeId,
+          VkMemoryPropertyFlags flags,
+          DxvkMemoryFlags       hints,
+          uint32_t              cacheClass) {
+    // Chunks only serve allocations with matching property
+    // flags and hints, so both need to be part of the key.
+    // The top bit is set so that valid keys are non-zero.
+    uint64_t key = uint64_t(1) << 63;
+    key |= uint64_t(cacheClass) << 32;
+    key |= uint64_t(memTypeId)  << 24;
+    key |= uint64_t(hints.test(DxvkMemoryFlag::Transient)) << 23;
+    key |= uint64_t(flags & 0x7fffff);
+    return key;
+  }
+
 }
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <ostream>
+#include <unordered_map>
+
 #include "dxvk_adapter.h"
+#include "dxvk_allocator.h"
 
 namespace dxvk {
   
@@ -16,6 +21,68 @@ namespace dxvk {
   struct DxvkMemoryStats {
     VkDeviceSize memoryAllocated = 0;
     VkDeviceSize memoryUsed      = 0;
+    VkDeviceSize memoryReclaimed = 0;
+  };
+
+
+  /**
+   * \brief Allocation cache stats
+   *
+   * Reports how often small allocations could be
+   * served from the per-thread allocation caches,
+   * and how often threads had to wait for a lock.
+   */
+  struct DxvkMemoryCacheStats {
+    uint64_t cacheHits            = 0;
+    uint64_t cacheMisses          = 0;
+    uint64_t cacheLockContention  = 0;
+    uint64_t allocLockContention  = 0;
+  };
+
+
+  /**
+   * \brief Mapped memory stats
+   *
+   * Reports where memory that is written by the CPU and
+   * read by the GPU ended up. BAR memory is device-local
+   * memory that the CPU can write to directly.
+   */
+  struct DxvkMappedMemoryStats {
+    VkDeviceSize barUsed     = 0;
+    VkDeviceSize barBudget   = 0;
+    VkDeviceSize sysmemUsed  = 0;
+  };
+
+
+  /**
+   * \brief Memory category
+   *
+   * Describes what a memory allocation is used
+   * for. Only used for memory accounting.
+   */
+  enum class DxvkMemoryCategory : uint32_t {
+    RenderTarget    = 0,  ///< Color and depth-stencil images
+    Texture         = 1,  ///< Other images
+    VertexIndex     = 2,  ///< Vertex and index buffers
+    Constant        = 3,  ///< Uniform buffers
+    Staging         = 4,  ///< Buffers only used for copies
+    ShaderInternal  = 5,  ///< Storage, texel and indirect buffers
+    Meta            = 6,  ///< Internal resources
+
+    Auto            = ~0u,  ///< Derive category from resource usage
+  };
+
+  constexpr uint32_t DxvkMemoryCategoryCount = 7;
+
+
+  /**
+   * \brief Memory category stats
+   *
+   * Reports the amount of memory used by
+   * each category, indexed by category.
+   */
+  struct DxvkMemoryCategoryStats {
+    std::array<VkDeviceSize, DxvkMemoryCategoryCount> memoryUsed = { };
   };
 
 
@@ -88,6 +155,9 @@ namespace dxvk {
     uint32_t          memTypeId;
 
     std::vector<Rc<DxvkMemoryChunk>> chunks;
+
+    std::array<std::atomic<VkDeviceSize>,
+      DxvkMemoryCategoryCount> categoryUsed = { };
   };
   
   
@@ -109,7 +179,8 @@ namespace dxvk {
       VkDeviceMemory        memory,
       VkDeviceSize          offset,
       VkDeviceSize          length,
-      void*                 mapPtr);
+      void*                 mapPtr,
+      uint64_t              cacheKey = 0);
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
     ~DxvkMemory();
@@ -155,6 +226,18 @@ namespace dxvk {
       return m_length;
     }
 
+    /**
+     * \brief Queries properties of the memory type
+     *
+     * May differ from the flags requested at allocation
+     * time if the allocation had to fall back to a
+     * different memory type, or was evicted.
+     * \returns Memory property flags
+     */
+    VkMemoryPropertyFlags propertyFlags() const {
+      return m_type ? m_type->memType.propertyFlags : 0;
+    }
+
     /**
      * \brief Checks whether the memory slice is defined
      * 
@@ -174,6 +257,8 @@ namespace dxvk {
     VkDeviceSize          m_offset = 0;
     VkDeviceSize          m_length = 0;
     void*                 m_mapPtr = nullptr;
+    uint64_t              m_cacheKey = 0;
+    DxvkMemoryCategory    m_category = DxvkMemoryCategory::Meta;
     
     void free();
     
@@ -192,6 +277,9 @@ namespace dxvk {
     GpuWritable       = 2,  ///< High-priority resource
     Transient         = 3,  ///< Resource is short-lived
     IgnoreConstraints = 4,  ///< Ignore most allocation flags
+    Relocate          = 5,  ///< Only allocate from densely used chunks
+    Evict             = 6,  ///< Only allocate from system memory
+    ImageOptimal      = 7,  ///< Non-linear image resource
   };
 
   using DxvkMemoryFlags = Flags<DxvkMemoryFlag>;
@@ -224,13 +312,15 @@ namespace dxvk {
      * \param [in] size Number of bytes to allocate
      * \param [in] align Required alignment
      * \param [in] hints Memory category
+     * \param [in] tag Allocation tag for memory reports
      * \returns The allocated memory slice
      */
     DxvkMemory alloc(
             VkMemoryPropertyFlags flags,
             VkDeviceSize          size,
             VkDeviceSize          align,
-            DxvkMemoryFlags       hints);
+            DxvkMemoryFlags       hints,
+            uint32_t              tag);
     
     /**
      * \brief Frees memory
@@ -251,25 +341,73 @@ namespace dxvk {
      */
     bool isEmpty() const;
 
+    /**
+     * \brief Checks whether the chunk is sparsely used
+     *
+     * Allocations from sparse chunks are candidates for
+     * relocation, so that the chunk can be freed later.
+     * \returns \c true if less than half the chunk is used
+     */
+    bool isSparse() const;
+
     /**
      * \brief Checks whether hints and flags of another chunk match
      * \param [in] other The chunk to compare to
      */
     bool isCompatible(const Rc<DxvkMemoryChunk>& other) const;
 
+    /**
+     * \brief Marks chunk as defragmented
+     *
+     * Called when an allocation has been moved out of
+     * the chunk, so that the memory freed when the
+     * chunk is destroyed can be reported as reclaimed.
+     */
+    void markRelocated() {
+      m_relocated = true;
+    }
+
+    /**
+     * \brief Queries chunk size
+     * \returns Size of the device memory object
+     */
+    VkDeviceSize size() const {
+      return m_memory.memSize;
+    }
+
+    /**
+     * \brief Queries number of allocated bytes
+     * \returns Number of bytes currently in use
+     */
+    VkDeviceSize used() const {
+      return m_allocator.used();
+    }
+
+    /**
+     * \brief Queries allocation hints of the chunk
+     * \returns Hints the chunk was created with
+     */
+    DxvkMemoryFlags hints() const {
+      return m_hints;
+    }
+
+    /**
+     * \brief Retrieves free and allocated ranges
+     * \returns Ranges sorted by offset
+     */
+    std::vector<DxvkTlsfAllocator::Range> getRanges() const {
+      return m_allocator.getRanges();
+    }
+
   private:
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
-    
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     DxvkMemoryFlags       m_hints;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkTlsfAllocator     m_allocator;
+    bool                  m_relocated = false;
 
     bool checkHints(DxvkMemoryFlags hints) const;
     
@@ -287,6 +425,20 @@ namespace dxvk {
     friend class DxvkMemoryChunk;
 
     constexpr static VkDeviceSize SmallAllocationThreshold = 256 << 10;
+
+    /// Smallest allocation for which a driver preference for a
+    /// dedicated allocation is honoured. Smaller resources are
+    /// suballocated in order not to waste allocation slots.
+    constexpr static VkDeviceSize MinDedicatedAllocationSize = 4 << 20;
+
+    constexpr static VkDeviceSize CacheBlockAlignment = 256;
+    constexpr static VkDeviceSize CacheRefillSize     = 256 << 10;
+    constexpr static uint32_t     CacheRefillMaxCount = 16;
+    constexpr static uint32_t     CacheShardCount     = 8;
+
+    /// Chunk allocation tag for blocks owned by the allocation
+    /// cache, other allocations are tagged with their category
+    constexpr static uint32_t     CacheBlockTag       = DxvkMemoryCategoryCount;
   public:
     
     DxvkMemoryAllocator(const DxvkDevice* device);
@@ -312,6 +464,7 @@ namespace dxvk {
      * \param [in] dedAllocInfo Dedicated allocation info
      * \param [in] flags Memory type flags
      * \param [in] hints Memory hints
+     * \param [in] category Memory category
      * \returns Allocated memory slice
      */
     DxvkMemory alloc(
@@ -319,7 +472,8 @@ namespace dxvk {
       const VkMemoryDedicatedRequirements&    dedAllocReq,
       const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
             VkMemoryPropertyFlags             flags,
-            DxvkMemoryFlags                   hints);
+            DxvkMemoryFlags                   hints,
+            DxvkMemoryCategory                category);
     
     /**
      * \brief Queries memory stats
@@ -332,9 +486,96 @@ namespace dxvk {
     DxvkMemoryStats getMemoryStats(uint32_t heap) const {
       return m_memHeaps[heap].stats;
     }
+
+    /**
+     * \brief Queries memory category stats for a memory type
+     *
+     * \param [in] type Memory type index
+     * \returns Memory used by each category
+     */
+    DxvkMemoryCategoryStats getTypeCategoryStats(uint32_t type) const;
+
+    /**
+     * \brief Queries memory category stats for a heap
+     *
+     * Accumulates stats of all memory types on the heap.
+     * \param [in] heap Heap index
+     * \returns Memory used by each category
+     */
+    DxvkMemoryCategoryStats getHeapCategoryStats(uint32_t heap) const;
+
+    /**
+     * \brief Queries allocation cache stats
+     * \returns Allocation cache stats
+     */
+    DxvkMemoryCacheStats getCacheStats() const;
+
+    /**
+     * \brief Retrieves name of a memory category
+     *
+     * \param [in] category Memory category
+     * \returns Short name for stat exports
+     */
+    static const char* getCategoryName(
+            DxvkMemoryCategory    category);
+
+    /**
+     * \brief Queries mapped memory stats
+     * \returns Placement of CPU-written memory
+     */
+    DxvkMappedMemoryStats getMappedStats() const;
+
+    /**
+     * \brief Checks whether memory should be relocated
+     *
+     * \param [in] memory Memory slice to check
+     * \returns \c true if the slice was allocated from
+     *    a sparsely used chunk and should be moved.
+     */
+    bool canRelocate(
+      const DxvkMemory&           memory);
+
+    /**
+     * \brief Notifies allocator of a relocation
+     *
+     * Must be called after the contents of the given memory
+     * slice were moved to a new allocation made with the
+     * \c Relocate flag, before the old slice is freed.
+     * \param [in] memory The old memory slice
+     */
+    void notifyRelocation(
+      const DxvkMemory&           memory);
+
+    /**
+     * \brief Writes a memory map
+     *
+     * Lists every chunk of every memory type along with
+     * its free and allocated ranges, the category of each
+     * allocation, and fragmentation metrics. Allocations
+     * served by the allocation cache are reported as such,
+     * since cached blocks may be reused by any category.
+     * Locks the allocator while the report is generated.
+     * \param [in] stream Output stream
+     */
+    void writeMemoryMap(
+            std::ostream&         stream);
     
   private:
 
+    struct CacheBlock {
+      DxvkMemoryChunk*  chunk;
+      DxvkMemoryType*   type;
+      VkDeviceMemory    memory;
+      VkDeviceSize      offset;
+      void*             mapPtr;
+    };
+
+    struct CacheShard {
+      alignas(CACHE_LINE_SIZE)
+      sync::Spinlock                                    mutex;
+      std::unordered_map<uint64_t, std::vector<CacheBlock>> lists;
+    };
+
     const Rc<vk::DeviceFn>                 m_vkd;
     const DxvkDevice*                      m_device;
     const VkPhysicalDeviceProperties       m_devProps;
@@ -344,11 +585,74 @@ namespace dxvk {
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
 
+    std::array<CacheShard, CacheShardCount>         m_cacheShards;
+
+    std::atomic<uint64_t>                           m_cacheHits           = { 0ull };
+    std::atomic<uint64_t>                           m_cacheMisses         = { 0ull };
+    std::atomic<uint64_t>                           m_cacheLockContention = { 0ull };
+    std::atomic<uint64_t>                           m_allocLockContention = { 0ull };
+
+    DxvkMemoryHeap*                                 m_barHeap   = nullptr;
+    VkDeviceSize                                    m_barBudget = 0;
+
+    std::atomic<VkDeviceSize>                       m_barUsed    = { 0ull };
+    std::atomic<VkDeviceSize>                       m_sysmemUsed = { 0ull };
+
+    std::unique_lock<dxvk::mutex> lockAllocator();
+
+    DxvkMemory allocMemory(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedRequirements&    dedAllocReq,
+      const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+            VkMemoryPropertyFlags             flags,
+            DxvkMemoryFlags                   hints,
+            DxvkMemoryCategory                category);
+
+    bool checkBarBudget(
+            VkDeviceSize          size) const;
+
+    void trackMappedMemory(
+      const DxvkMemoryType*       type,
+      const void*                 mapPtr,
+            int64_t               size);
+
+    CacheShard& getCacheShard();
+
+    std::unique_lock<sync::Spinlock> lockCacheShard(
+            CacheShard&           shard);
+
+    DxvkMemory tryAllocFromCache(
+      const VkMemoryRequirements*             req,
+            VkMemoryPropertyFlags             flags,
+            DxvkMemoryFlags                   hints);
+
+    void freeCachedMemory(
+      const DxvkMemory&           memory);
+
+    void freeCacheBlocks(
+      const std::vector<CacheBlock>& blocks,
+            VkDeviceSize          size);
+
+    void drainCaches();
+
+    static uint32_t getCacheClass(
+            VkDeviceSize          size);
+
+    static VkDeviceSize getCacheClassSize(
+            uint32_t              cacheClass);
+
+    static uint64_t getCacheKey(
+            uint32_t              memTypeId,
+            VkMemoryPropertyFlags flags,
+            DxvkMemoryFlags       hints,
+            uint32_t              cacheClass);
+
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
             VkMemoryPropertyFlags             flags,
-            DxvkMemoryFlags                   hints);
+            DxvkMemoryFlags                   hints,
+            uint32_t                          tag);
     
     DxvkMemory tryAllocFromType(
             DxvkMemoryType*                   type,
@@ -356,6 +660,7 @@ namespace dxvk {
             VkDeviceSize                      size,
             VkDeviceSize                      align,
             DxvkMemoryFlags                   hints,
+            uint32_t                          tag,
       const VkMemoryDedicatedAllocateInfo*    dedAllocInfo);
     
     DxvkDeviceMemory tryAllocDeviceMemory(
@@ -382,6 +687,10 @@ namespace dxvk {
             uint32_t              memTypeId,
             DxvkMemoryFlags       hints) const;
 
+    bool shouldUseDedicatedAllocation(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedRequirements&    dedAllocReq) const;
+
     bool shouldFreeChunk(
       const DxvkMemoryType*       type,
       const Rc<DxvkMemoryChunk>&  chunk) const;
@@ -393,6 +702,12 @@ namespace dxvk {
     void freeEmptyChunks(
       const DxvkMemoryHeap*       heap);
 
+    static std::string getChunkOwnerName(
+            DxvkMemoryFlags       hints);
+
+    static std::string formatSize(
+            VkDeviceSize          size);
+
   };
   
 }
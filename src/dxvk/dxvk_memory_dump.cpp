@@ -0,0 +1,96 @@
+#include <charconv>
+#include <fstream>
+
+#include "dxvk_memory_dump.h"
+
+namespace dxvk {
+
+  DxvkMemoryDumper::DxvkMemoryDumper(
+          DxvkMemoryAllocator*  memAlloc)
+  : m_memAlloc(memAlloc) {
+    std::string mode = env::getEnvVar("DXVK_MEMORY_DUMP");
+
+    if (mode.empty())
+      return;
+
+    if (mode == "hotkey") {
+#ifdef _WIN32
+      m_hotkey = true;
+#else
+      Logger::warn("DXVK: Memory dump hotkey not supported on this platform");
+#endif
+    } else {
+      uint64_t interval = 0;
+
+      auto result = std::from_chars(mode.data(), mode.data() + mode.size(), interval);
+
+      if (result.ec != std::errc() || result.ptr != mode.data() + mode.size() || !interval) {
+        Logger::warn(str::format("DXVK: Invalid DXVK_MEMORY_DUMP value: ", mode));
+        return;
+      }
+
+      m_interval = interval;
+    }
+
+    m_path = env::getEnvVar("DXVK_MEMORY_DUMP_PATH");
+
+    if (!m_path.empty() && *m_path.rbegin() != '/')
+      m_path += '/';
+
+    m_path += env::getExeBaseName() + "_memory_";
+  }
+
+
+  DxvkMemoryDumper::~DxvkMemoryDumper() {
+
+  }
+
+
+  void DxvkMemoryDumper::processFrame(
+          uint64_t              frameId) {
+    if (!isEnabled())
+      return;
+
+    bool dump = m_interval && !(frameId % m_interval);
+
+    if (m_hotkey && checkHotkey())
+      dump = true;
+
+    if (dump)
+      writeDump(frameId);
+  }
+
+
+  bool DxvkMemoryDumper::checkHotkey() {
+#ifdef _WIN32
+    bool keyDown = (::GetAsyncKeyState(VK_CONTROL) & 0x8000)
+                && (::GetAsyncKeyState(VK_SHIFT)   & 0x8000)
+                && (::GetAsyncKeyState(VK_F11)     & 0x8000);
+
+    // Only dump once per key press
+    bool pressed = keyDown && !m_keyDown;
+    m_keyDown = keyDown;
+    return pressed;
+#else
+    return false;
+#endif
+  }
+
+
+  void DxvkMemoryDumper::writeDump(
+          uint64_t              frameId) {
+    std::string path = str::format(m_path, frameId, ".txt");
+    std::ofstream file(str::tows(path.c_str()).c_str(), std::ios_base::trunc);
+
+    if (!file) {
+      Logger::warn(str::format("DXVK: Failed to open memory dump file ", path));
+      return;
+    }
+
+    file << "Frame " << frameId << std::endl << std::endl;
+    m_memAlloc->writeMemoryMap(file);
+
+    Logger::info(str::format("DXVK: Wrote memory map to ", path));
+  }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+
+#include "dxvk_memory.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Memory map dumper
+   *
+   * Writes the allocator's memory map, including every
+   * chunk's free and allocated ranges and fragmentation
+   * metrics, to \c <exe>_memory_<frame>.txt in
+   * \c DXVK_MEMORY_DUMP_PATH, or in the working directory
+   * if that is not set. Dumps are controlled through
+   * \c DXVK_MEMORY_DUMP, which can either be a number
+   * \c N to dump every \c N frames, or \c hotkey to dump
+   * whenever Ctrl+Shift+F11 is pressed. The hotkey is
+   * only supported on Windows.
+   */
+  class DxvkMemoryDumper {
+
+  public:
+
+    DxvkMemoryDumper(
+            DxvkMemoryAllocator*  memAlloc);
+
+    ~DxvkMemoryDumper();
+
+    /**
+     * \brief Checks whether memory dumps are enabled
+     * \returns \c true if any trigger is enabled
+     */
+    bool isEnabled() const {
+      return m_interval || m_hotkey;
+    }
+
+    /**
+     * \brief Checks triggers for the current frame
+     *
+     * Writes a memory map if the frame interval has
+     * been reached or the hotkey has been pressed
+     * since the last call. Must only be called from
+     * one thread at a time.
+     * \param [in] frameId Current frame number
+     */
+    void processFrame(
+            uint64_t              frameId);
+
+  private:
+
+    DxvkMemoryAllocator*  m_memAlloc;
+
+    std::string           m_path;
+    uint64_t              m_interval  = 0;
+    bool                  m_hotkey    = false;
+    bool                  m_keyDown   = false;
+
+    bool checkHotkey();
+
+    void writeDump(
+            uint64_t              frameId);
+
+  };
+
+}
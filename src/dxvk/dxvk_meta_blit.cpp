@@ -126,8 +126,12 @@ namespace dxvk {
 
 
 
-  DxvkMetaBlitObjects::DxvkMetaBlitObjects(const DxvkDevice* device)
-  : m_vkd         (device->vkd()),
+  DxvkMetaBlitObjects::DxvkMetaBlitObjects(
+          DxvkDevice*           device,
+    const DxvkPipelineCache*    cache)
+  : m_device      (device),
+    m_vkd         (device->vkd()),
+    m_cache       (cache),
     m_samplerCopy (createSampler(VK_FILTER_NEAREST)),
     m_samplerBlit (createSampler(VK_FILTER_LINEAR)),
     m_shaderFrag1D(createShaderModule(dxvk_blit_frag_1d)),
@@ -164,20 +168,25 @@ namespace dxvk {
           VkImageViewType       viewType,
           VkFormat              viewFormat,
           VkSampleCountFlagBits samples) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-    
     DxvkMetaBlitPipelineKey key;
     key.viewType   = viewType;
     key.viewFormat = viewFormat;
     key.samples    = samples;
     
-    auto entry = m_pipelines.find(key);
-    if (entry != m_pipelines.end())
-      return entry->second;
-    
-    DxvkMetaBlitPipeline pipeline = this->createPipeline(key);
-    m_pipelines.insert({ key, pipeline });
-    return pipeline;
+    return this->getOrCreatePipeline(key, true);
+  }
+
+
+  void DxvkMetaBlitObjects::compilePipeline(
+          VkImageViewType       viewType,
+          VkFormat              viewFormat,
+          VkSampleCountFlagBits samples) {
+    DxvkMetaBlitPipelineKey key;
+    key.viewType   = viewType;
+    key.viewFormat = viewFormat;
+    key.samples    = samples;
+
+    this->getOrCreatePipeline(key, false);
   }
   
   
@@ -231,6 +240,24 @@ namespace dxvk {
   }
   
   
+  DxvkMetaBlitPipeline DxvkMetaBlitObjects::getOrCreatePipeline(
+    const DxvkMetaBlitPipelineKey&    key,
+          bool                        countMiss) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_pipelines.find(key);
+    if (entry != m_pipelines.end())
+      return entry->second;
+
+    if (countMiss)
+      m_device->addStatCtr(DxvkStatCounter::MetaPipelineMisses, 1);
+
+    DxvkMetaBlitPipeline pipeline = this->createPipeline(key);
+    m_pipelines.insert({ key, pipeline });
+    return pipeline;
+  }
+
+
   DxvkMetaBlitPipeline DxvkMetaBlitObjects::createPipeline(
     const DxvkMetaBlitPipelineKey& key) {
     DxvkMetaBlitPipeline pipe;
@@ -363,7 +390,7 @@ namespace dxvk {
     info.basePipelineIndex      = -1;
     
     VkPipeline result = VK_NULL_HANDLE;
-    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), VK_NULL_HANDLE, 1, &info, nullptr, &result) != VK_SUCCESS)
+    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), m_cache->handle(), 1, &info, nullptr, &result) != VK_SUCCESS)
       throw DxvkError("DxvkMetaBlitObjects: Failed to create graphics pipeline");
     return result;
   }
@@ -10,6 +10,9 @@
 
 namespace dxvk {
 
+  class DxvkDevice;
+  class DxvkPipelineCache;
+
   /**
    * \brief Texture coordinates
    */
@@ -143,7 +146,9 @@ namespace dxvk {
     
   public:
     
-    DxvkMetaBlitObjects(const DxvkDevice* device);
+    DxvkMetaBlitObjects(
+            DxvkDevice*           device,
+      const DxvkPipelineCache*    cache);
     ~DxvkMetaBlitObjects();
     
     /**
@@ -158,6 +163,20 @@ namespace dxvk {
             VkImageViewType       viewType,
             VkFormat              viewFormat,
             VkSampleCountFlagBits samples);
+
+    /**
+     * \brief Compiles pipeline ahead of time
+     *
+     * Creates the same pipeline as \ref getPipeline
+     * would, but does not count as a pipeline miss.
+     * \param [in] viewType Source image view type
+     * \param [in] viewFormat Image view format
+     * \param [in] samples Target sample count
+     */
+    void compilePipeline(
+            VkImageViewType       viewType,
+            VkFormat              viewFormat,
+            VkSampleCountFlagBits samples);
     
     /**
      * \brief Retrieves sampler with a given filter
@@ -170,7 +189,9 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>  m_vkd;
+    DxvkDevice*               m_device;
+    Rc<vk::DeviceFn>          m_vkd;
+    const DxvkPipelineCache*  m_cache;
     
     VkSampler m_samplerCopy;
     VkSampler m_samplerBlit;
@@ -194,6 +215,10 @@ namespace dxvk {
     VkShaderModule createShaderModule(
       const SpirvCodeBuffer&            code) const;
     
+    DxvkMetaBlitPipeline getOrCreatePipeline(
+      const DxvkMetaBlitPipelineKey&    key,
+            bool                        countMiss);
+
     DxvkMetaBlitPipeline createPipeline(
       const DxvkMetaBlitPipelineKey&    key);
     
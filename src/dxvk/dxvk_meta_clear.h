@@ -22,6 +22,18 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Clear rect
+   * 
+   * Region of a view to clear. For buffer views,
+   * only the x offset and the width are used.
+   */
+  struct DxvkClearRect {
+    VkOffset3D offset;
+    VkExtent3D extent;
+  };
+  
+  
   /**
    * \brief Pipeline-related objects
    * 
@@ -79,8 +79,12 @@ namespace dxvk {
   }
 
   
-  DxvkMetaCopyObjects::DxvkMetaCopyObjects(const DxvkDevice* device)
-  : m_vkd         (device->vkd()),
+  DxvkMetaCopyObjects::DxvkMetaCopyObjects(
+          DxvkDevice*               device,
+    const DxvkPipelineCache*        cache)
+  : m_device      (device),
+    m_vkd         (device->vkd()),
+    m_cache       (cache),
     m_color {
       createShaderModule(dxvk_copy_color_1d),
       createShaderModule(dxvk_copy_color_2d),
@@ -163,20 +167,25 @@ namespace dxvk {
           VkImageViewType       viewType,
           VkFormat              dstFormat,
           VkSampleCountFlagBits dstSamples) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-
     DxvkMetaCopyPipelineKey key;
     key.viewType = viewType;
     key.format   = dstFormat;
     key.samples  = dstSamples;
     
-    auto entry = m_pipelines.find(key);
-    if (entry != m_pipelines.end())
-      return entry->second;
+    return getOrCreatePipeline(key, true);
+  }
 
-    DxvkMetaCopyPipeline pipeline = createPipeline(key);
-    m_pipelines.insert({ key, pipeline });
-    return pipeline;
+
+  void DxvkMetaCopyObjects::compilePipeline(
+          VkImageViewType       viewType,
+          VkFormat              dstFormat,
+          VkSampleCountFlagBits dstSamples) {
+    DxvkMetaCopyPipelineKey key;
+    key.viewType = viewType;
+    key.format   = dstFormat;
+    key.samples  = dstSamples;
+
+    getOrCreatePipeline(key, false);
   }
 
 
@@ -242,7 +251,7 @@ namespace dxvk {
     pipelineInfo.stage.pName = "main";
     pipelineInfo.basePipelineIndex = -1;
 
-    if (m_vkd->vkCreateComputePipelines(m_vkd->device(), VK_NULL_HANDLE,
+    if (m_vkd->vkCreateComputePipelines(m_vkd->device(), m_cache->handle(),
         1, &pipelineInfo, nullptr, &pipeline.pipeHandle) != VK_SUCCESS)
       throw DxvkError("DxvkMetaCopyObjects: Failed to create compute pipeline");
 
@@ -251,6 +260,24 @@ namespace dxvk {
   }
 
 
+  DxvkMetaCopyPipeline DxvkMetaCopyObjects::getOrCreatePipeline(
+    const DxvkMetaCopyPipelineKey&  key,
+          bool                      countMiss) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_pipelines.find(key);
+    if (entry != m_pipelines.end())
+      return entry->second;
+
+    if (countMiss)
+      m_device->addStatCtr(DxvkStatCounter::MetaPipelineMisses, 1);
+
+    DxvkMetaCopyPipeline pipeline = createPipeline(key);
+    m_pipelines.insert({ key, pipeline });
+    return pipeline;
+  }
+
+
   DxvkMetaCopyPipeline DxvkMetaCopyObjects::createPipeline(
     const DxvkMetaCopyPipelineKey&  key) {
     DxvkMetaCopyPipeline pipeline;
@@ -427,7 +454,7 @@ namespace dxvk {
     info.basePipelineIndex      = -1;
     
     VkPipeline result = VK_NULL_HANDLE;
-    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), VK_NULL_HANDLE, 1, &info, nullptr, &result) != VK_SUCCESS)
+    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), m_cache->handle(), 1, &info, nullptr, &result) != VK_SUCCESS)
       throw DxvkError("DxvkMetaCopyObjects: Failed to create graphics pipeline");
     return result;
   }
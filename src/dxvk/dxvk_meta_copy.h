@@ -13,6 +13,7 @@
 namespace dxvk {
 
   class DxvkDevice;
+  class DxvkPipelineCache;
 
   /**
    * \brief Push constants for buffer image copies
@@ -113,7 +114,9 @@ namespace dxvk {
 
   public:
 
-    DxvkMetaCopyObjects(const DxvkDevice* device);
+    DxvkMetaCopyObjects(
+            DxvkDevice*               device,
+      const DxvkPipelineCache*        cache);
     ~DxvkMetaCopyObjects();
 
     /**
@@ -143,6 +146,20 @@ namespace dxvk {
             VkFormat              dstFormat,
             VkSampleCountFlagBits dstSamples);
 
+    /**
+     * \brief Compiles pipeline ahead of time
+     *
+     * Creates the same pipeline as \ref getPipeline
+     * would, but does not count as a pipeline miss.
+     * \param [in] viewType Image view type
+     * \param [in] dstFormat Destination image format
+     * \param [in] dstSamples Destination sample count
+     */
+    void compilePipeline(
+            VkImageViewType       viewType,
+            VkFormat              dstFormat,
+            VkSampleCountFlagBits dstSamples);
+
     /**
      * \brief Creates pipeline for buffer image copy
      * \returns Compute pipeline for buffer image copies
@@ -157,7 +174,9 @@ namespace dxvk {
       VkShaderModule fragMs = VK_NULL_HANDLE;
     };
 
-    Rc<vk::DeviceFn> m_vkd;
+    DxvkDevice*              m_device;
+    Rc<vk::DeviceFn>         m_vkd;
+    const DxvkPipelineCache* m_cache;
 
     VkShaderModule m_shaderVert = VK_NULL_HANDLE;
     VkShaderModule m_shaderGeom = VK_NULL_HANDLE;
@@ -180,6 +199,10 @@ namespace dxvk {
     
     DxvkMetaCopyPipeline createCopyBufferImagePipeline();
 
+    DxvkMetaCopyPipeline getOrCreatePipeline(
+      const DxvkMetaCopyPipelineKey&  key,
+            bool                      countMiss);
+
     DxvkMetaCopyPipeline createPipeline(
       const DxvkMetaCopyPipelineKey&  key);
 
@@ -1,5 +1,8 @@
+#include "dxvk_device.h"
 #include "dxvk_meta_mipgen.h"
 
+#include <dxvk_mipgen_2d.h>
+
 namespace dxvk {
 
   DxvkMetaMipGenRenderPass::DxvkMetaMipGenRenderPass(
@@ -94,4 +97,179 @@ namespace dxvk {
     return result;
   }
   
+
+
+  DxvkMetaMipGenViews::DxvkMetaMipGenViews(
+    const Rc<vk::DeviceFn>&   vkd,
+    const Rc<DxvkImageView>&  view)
+  : m_vkd(vkd) {
+    VkImageViewUsageCreateInfo usageInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO };
+    usageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+
+    VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, &usageInfo };
+    viewInfo.image = view->imageHandle();
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.format = view->info().format;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.baseArrayLayer = view->info().minLayer;
+    viewInfo.subresourceRange.layerCount     = view->info().numLayers;
+
+    m_views.resize(view->info().numLevels, VK_NULL_HANDLE);
+
+    for (uint32_t i = 0; i < m_views.size(); i++) {
+      viewInfo.subresourceRange.baseMipLevel = view->info().minLevel + i;
+
+      if (m_vkd->vkCreateImageView(m_vkd->device(), &viewInfo, nullptr, &m_views[i]) != VK_SUCCESS)
+        throw DxvkError("DxvkMetaMipGenViews: Failed to create storage image view");
+    }
+  }
+
+
+  DxvkMetaMipGenViews::~DxvkMetaMipGenViews() {
+    for (auto view : m_views)
+      m_vkd->vkDestroyImageView(m_vkd->device(), view, nullptr);
+  }
+
+
+  DxvkMetaMipGenObjects::DxvkMetaMipGenObjects(
+          DxvkDevice*               device,
+    const DxvkPipelineCache*        cache)
+  : m_device  (device),
+    m_vkd     (device->vkd()),
+    m_cache   (cache) {
+    m_pipeline.dsetLayout = createDescriptorSetLayout();
+    m_pipeline.pipeLayout = createPipelineLayout(m_pipeline.dsetLayout);
+    m_pipeline.pipeHandle = createPipeline(m_pipeline.pipeLayout);
+  }
+
+
+  DxvkMetaMipGenObjects::~DxvkMetaMipGenObjects() {
+    m_vkd->vkDestroyPipeline(m_vkd->device(), m_pipeline.pipeHandle, nullptr);
+    m_vkd->vkDestroyPipelineLayout(m_vkd->device(), m_pipeline.pipeLayout, nullptr);
+    m_vkd->vkDestroyDescriptorSetLayout(m_vkd->device(), m_pipeline.dsetLayout, nullptr);
+  }
+
+
+  bool DxvkMetaMipGenObjects::canGenerateMipmaps(
+    const Rc<DxvkImageView>&        view,
+          VkFilter                  filter) const {
+    const auto& features = m_device->features().core.features;
+
+    if (!features.shaderStorageImageReadWithoutFormat
+     || !features.shaderStorageImageWriteWithoutFormat)
+      return false;
+
+    // The shader uses a box filter, which only
+    // matches linear filtering for even sizes
+    if (filter != VK_FILTER_LINEAR)
+      return false;
+
+    const auto& imageInfo = view->imageInfo();
+
+    if (imageInfo.type != VK_IMAGE_TYPE_2D
+     || imageInfo.tiling != VK_IMAGE_TILING_OPTIMAL
+     || imageInfo.sampleCount != VK_SAMPLE_COUNT_1_BIT
+     || !(imageInfo.usage & VK_IMAGE_USAGE_STORAGE_BIT))
+      return false;
+
+    if (view->info().aspect != VK_IMAGE_ASPECT_COLOR_BIT
+     || view->info().numLevels - 1 > MaxLevels)
+      return false;
+
+    auto formatInfo = imageFormatInfo(view->info().format);
+
+    if (formatInfo->flags.any(DxvkFormatFlag::SampledUInt, DxvkFormatFlag::SampledSInt))
+      return false;
+
+    VkFormatProperties formatProperties = m_device->adapter()->formatProperties(view->info().format);
+
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT))
+      return false;
+
+    // The last work group reduces the remaining levels
+    // on its own, so those must fit into a single tile
+    VkExtent3D extent = view->mipLevelExtent(0);
+
+    if (extent.width > TileSize << 6 || extent.height > TileSize << 6)
+      return false;
+
+    for (uint32_t i = 0; i + 1 < view->info().numLevels; i++) {
+      extent = view->mipLevelExtent(i);
+
+      if ((extent.width  > 1 && (extent.width  & 1))
+       || (extent.height > 1 && (extent.height & 1)))
+        return false;
+    }
+
+    return true;
+  }
+
+
+  VkDescriptorSetLayout DxvkMetaMipGenObjects::createDescriptorSetLayout() const {
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {{
+      { 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,  MaxLevels + 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+      { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,             VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+    }};
+
+    VkDescriptorSetLayoutCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    info.bindingCount = bindings.size();
+    info.pBindings    = bindings.data();
+
+    VkDescriptorSetLayout result = VK_NULL_HANDLE;
+    if (m_vkd->vkCreateDescriptorSetLayout(m_vkd->device(), &info, nullptr, &result) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaMipGenObjects: Failed to create descriptor set layout");
+    return result;
+  }
+
+
+  VkPipelineLayout DxvkMetaMipGenObjects::createPipelineLayout(
+          VkDescriptorSetLayout     dsetLayout) const {
+    VkPushConstantRange pushRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DxvkMetaMipGenArgs) };
+
+    VkPipelineLayoutCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    info.setLayoutCount         = 1;
+    info.pSetLayouts            = &dsetLayout;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges    = &pushRange;
+
+    VkPipelineLayout result = VK_NULL_HANDLE;
+    if (m_vkd->vkCreatePipelineLayout(m_vkd->device(), &info, nullptr, &result) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaMipGenObjects: Failed to create pipeline layout");
+    return result;
+  }
+
+
+  VkPipeline DxvkMetaMipGenObjects::createPipeline(
+          VkPipelineLayout          pipeLayout) const {
+    SpirvCodeBuffer code(dxvk_mipgen_2d);
+
+    VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode    = code.data();
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (m_vkd->vkCreateShaderModule(m_vkd->device(), &moduleInfo, nullptr, &module) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaMipGenObjects: Failed to create shader module");
+
+    VkComputePipelineCreateInfo pipeInfo = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipeInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeInfo.stage.module = module;
+    pipeInfo.stage.pName  = "main";
+    pipeInfo.layout       = pipeLayout;
+    pipeInfo.basePipelineIndex = -1;
+
+    VkPipeline result = VK_NULL_HANDLE;
+
+    VkResult status = m_vkd->vkCreateComputePipelines(
+      m_vkd->device(), m_cache->handle(), 1, &pipeInfo, nullptr, &result);
+
+    m_vkd->vkDestroyShaderModule(m_vkd->device(), module, nullptr);
+
+    if (status != VK_SUCCESS)
+      throw DxvkError("DxvkMetaMipGenObjects: Failed to create compute pipeline");
+    return result;
+  }
+
 }
@@ -5,6 +5,8 @@
 #include "dxvk_meta_blit.h"
 
 namespace dxvk {
+
+  class DxvkPipelineCache;
   
   /**
    * \brief Mip map generation render pass
@@ -146,4 +148,136 @@ namespace dxvk {
     
   };
   
+
+
+  /**
+   * \brief Compute mip generation arguments
+   *
+   * Passed to the compute shader as push constants.
+   */
+  struct DxvkMetaMipGenArgs {
+    uint32_t mipCount;
+    uint32_t groupCount;
+  };
+
+
+  /**
+   * \brief Compute mip generation pipeline
+   */
+  struct DxvkMetaMipGenPipeline {
+    VkDescriptorSetLayout dsetLayout;
+    VkPipelineLayout      pipeLayout;
+    VkPipeline            pipeHandle;
+  };
+
+
+  /**
+   * \brief Compute mip generation views
+   *
+   * Stores one storage image view per mip
+   * level of the given image view, including
+   * the top level that is read from.
+   */
+  class DxvkMetaMipGenViews : public DxvkResource {
+
+  public:
+
+    DxvkMetaMipGenViews(
+      const Rc<vk::DeviceFn>&   vkd,
+      const Rc<DxvkImageView>&  view);
+
+    ~DxvkMetaMipGenViews();
+
+    /**
+     * \brief Number of mip levels
+     * \returns Mip level count, including the top level
+     */
+    uint32_t getLevelCount() const {
+      return m_views.size();
+    }
+
+    /**
+     * \brief Storage view for a given mip level
+     *
+     * \param [in] level Mip level, relative to the view
+     * \returns Storage image view handle
+     */
+    VkImageView getView(uint32_t level) const {
+      return m_views.at(level);
+    }
+
+  private:
+
+    Rc<vk::DeviceFn>          m_vkd;
+    std::vector<VkImageView>  m_views;
+
+  };
+
+
+  /**
+   * \brief Compute mip generation objects
+   *
+   * Generates up to twelve mip levels of a 2D image
+   * in a single dispatch. Each work group reduces one
+   * tile of the top level, and the last work group to
+   * finish a layer reduces the remaining levels, which
+   * is tracked via a counter buffer.
+   */
+  class DxvkMetaMipGenObjects {
+
+  public:
+
+    /// Maximum number of levels generated per dispatch
+    constexpr static uint32_t MaxLevels = 12;
+    /// Size of the top-level tile each work group reduces
+    constexpr static uint32_t TileSize = 64;
+
+    DxvkMetaMipGenObjects(
+            DxvkDevice*               device,
+      const DxvkPipelineCache*        cache);
+
+    ~DxvkMetaMipGenObjects();
+
+    /**
+     * \brief Checks whether compute mip generation can be used
+     *
+     * Requires a 2D color image that supports storage
+     * image access with the view format, and a mip chain
+     * in which each level is exactly half the size of the
+     * previous one, so that the box filter produces the
+     * same results as linear filtering.
+     * \param [in] view The image view to generate mips for
+     * \param [in] filter The filter to use for generation
+     * \returns \c true if the compute path can be used
+     */
+    bool canGenerateMipmaps(
+      const Rc<DxvkImageView>&        view,
+            VkFilter                  filter) const;
+
+    /**
+     * \brief Retrieves mip generation pipeline
+     * \returns Compute pipeline for mip generation
+     */
+    DxvkMetaMipGenPipeline getPipeline() const {
+      return m_pipeline;
+    }
+
+  private:
+
+    DxvkDevice*              m_device;
+    Rc<vk::DeviceFn>         m_vkd;
+    const DxvkPipelineCache* m_cache;
+
+    DxvkMetaMipGenPipeline   m_pipeline = { };
+
+    VkDescriptorSetLayout createDescriptorSetLayout() const;
+
+    VkPipelineLayout createPipelineLayout(
+            VkDescriptorSetLayout     dsetLayout) const;
+
+    VkPipeline createPipeline(
+            VkPipelineLayout          pipeLayout) const;
+
+  };
+  
 }
@@ -10,8 +10,11 @@
 
 namespace dxvk {
 
-  DxvkMetaPackObjects::DxvkMetaPackObjects(const DxvkDevice* device)
+  DxvkMetaPackObjects::DxvkMetaPackObjects(
+    const DxvkDevice*               device,
+    const DxvkPipelineCache*        cache)
   : m_vkd             (device->vkd()),
+    m_cache           (cache),
     m_sampler         (createSampler()),
     m_dsetLayoutPack  (createPackDescriptorSetLayout()),
     m_dsetLayoutUnpack(createUnpackDescriptorSetLayout()),
@@ -275,7 +278,7 @@ namespace dxvk {
     VkPipeline result = VK_NULL_HANDLE;
 
     VkResult status = m_vkd->vkCreateComputePipelines(
-      m_vkd->device(), VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &result);
+      m_vkd->device(), m_cache->handle(), 1, &pipeInfo, nullptr, &result);
     
     m_vkd->vkDestroyShaderModule(m_vkd->device(), module, nullptr);
 
@@ -7,6 +7,8 @@
 
 namespace dxvk {
 
+  class DxvkPipelineCache;
+
   /**
    * \brief Packing arguments
    * 
@@ -66,7 +68,9 @@ namespace dxvk {
 
   public:
 
-    DxvkMetaPackObjects(const DxvkDevice* device);
+    DxvkMetaPackObjects(
+      const DxvkDevice*               device,
+      const DxvkPipelineCache*        cache);
     ~DxvkMetaPackObjects();
 
     /**
@@ -91,6 +95,7 @@ namespace dxvk {
   private:
 
     Rc<vk::DeviceFn>      m_vkd;
+    const DxvkPipelineCache* m_cache;
 
     VkSampler             m_sampler;
 
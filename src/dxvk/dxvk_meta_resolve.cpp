@@ -5,6 +5,8 @@
 #include <dxvk_fullscreen_vert.h>
 #include <dxvk_fullscreen_layer_vert.h>
 
+#include <dxvk_resolve_comp_f.h>
+
 #include <dxvk_resolve_frag_d.h>
 #include <dxvk_resolve_frag_ds.h>
 #include <dxvk_resolve_frag_f.h>
@@ -52,8 +54,50 @@ namespace dxvk {
 
 
 
-  DxvkMetaResolveObjects::DxvkMetaResolveObjects(const DxvkDevice* device)
-  : m_vkd         (device->vkd()),
+  DxvkMetaResolveComputeViews::DxvkMetaResolveComputeViews(
+    const Rc<vk::DeviceFn>&         vkd,
+    const Rc<DxvkImage>&            dstImage,
+    const VkImageSubresourceLayers& dstSubresources,
+    const Rc<DxvkImage>&            srcImage,
+    const VkImageSubresourceLayers& srcSubresources,
+          VkFormat                  format)
+  : m_vkd(vkd) {
+    VkImageViewUsageCreateInfo usageInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO };
+    usageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+
+    VkImageViewCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, &usageInfo };
+    info.image = dstImage->handle();
+    info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    info.format = format;
+    info.subresourceRange = vk::makeSubresourceRange(dstSubresources);
+
+    if (m_vkd->vkCreateImageView(m_vkd->device(), &info, nullptr, &m_dstImageView))
+      throw DxvkError("DxvkMetaResolveComputeViews: Failed to create destination view");
+
+    usageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    info.image = srcImage->handle();
+    info.subresourceRange = vk::makeSubresourceRange(srcSubresources);
+
+    if (m_vkd->vkCreateImageView(m_vkd->device(), &info, nullptr, &m_srcImageView))
+      throw DxvkError("DxvkMetaResolveComputeViews: Failed to create source view");
+  }
+
+
+  DxvkMetaResolveComputeViews::~DxvkMetaResolveComputeViews() {
+    m_vkd->vkDestroyImageView(m_vkd->device(), m_srcImageView, nullptr);
+    m_vkd->vkDestroyImageView(m_vkd->device(), m_dstImageView, nullptr);
+  }
+
+
+
+
+  DxvkMetaResolveObjects::DxvkMetaResolveObjects(
+          DxvkDevice*               device,
+    const DxvkPipelineCache*        cache)
+  : m_device      (device),
+    m_vkd         (device->vkd()),
+    m_cache       (cache),
     m_sampler     (createSampler()),
     m_shaderFragF (device->extensions().amdShaderFragmentMask
       ? createShaderModule(dxvk_resolve_frag_f_amd)
@@ -64,6 +108,9 @@ namespace dxvk {
     if (device->extensions().extShaderStencilExport)
       m_shaderFragDS = createShaderModule(dxvk_resolve_frag_ds);
 
+    if (device->features().core.features.shaderStorageImageWriteWithoutFormat)
+      m_shaderCompF = createShaderModule(dxvk_resolve_comp_f);
+
     if (device->extensions().extShaderViewportIndexLayer) {
       m_shaderVert = createShaderModule(dxvk_fullscreen_layer_vert);
     } else {
@@ -80,6 +127,13 @@ namespace dxvk {
       m_vkd->vkDestroyDescriptorSetLayout(m_vkd->device(), pair.second.dsetLayout, nullptr);
     }
 
+    for (const auto& pair : m_computePipelines) {
+      m_vkd->vkDestroyPipeline(m_vkd->device(), pair.second.pipeHandle, nullptr);
+      m_vkd->vkDestroyPipelineLayout(m_vkd->device(), pair.second.pipeLayout, nullptr);
+      m_vkd->vkDestroyDescriptorSetLayout(m_vkd->device(), pair.second.dsetLayout, nullptr);
+    }
+
+    m_vkd->vkDestroyShaderModule(m_vkd->device(), m_shaderCompF, nullptr);
     m_vkd->vkDestroyShaderModule(m_vkd->device(), m_shaderFragDS, nullptr);
     m_vkd->vkDestroyShaderModule(m_vkd->device(), m_shaderFragD, nullptr);
     m_vkd->vkDestroyShaderModule(m_vkd->device(), m_shaderFragF, nullptr);
@@ -97,20 +151,77 @@ namespace dxvk {
           VkSampleCountFlagBits     samples,
           VkResolveModeFlagBitsKHR  depthResolveMode,
           VkResolveModeFlagBitsKHR  stencilResolveMode) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-
     DxvkMetaResolvePipelineKey key;
     key.format  = format;
     key.samples = samples;
     key.modeD   = depthResolveMode;
     key.modeS   = stencilResolveMode;
     
-    auto entry = m_pipelines.find(key);
-    if (entry != m_pipelines.end())
+    return getOrCreatePipeline(key, true);
+  }
+
+
+  void DxvkMetaResolveObjects::compilePipeline(
+          VkFormat                  format,
+          VkSampleCountFlagBits     samples,
+          VkResolveModeFlagBitsKHR  depthResolveMode,
+          VkResolveModeFlagBitsKHR  stencilResolveMode) {
+    DxvkMetaResolvePipelineKey key;
+    key.format  = format;
+    key.samples = samples;
+    key.modeD   = depthResolveMode;
+    key.modeS   = stencilResolveMode;
+
+    getOrCreatePipeline(key, false);
+  }
+
+
+  bool DxvkMetaResolveObjects::canResolveCompute(
+    const Rc<DxvkImage>&            dstImage,
+    const Rc<DxvkImage>&            srcImage,
+          VkFormat                  format) const {
+    if (!m_shaderCompF)
+      return false;
+
+    if (!(dstImage->info().usage & VK_IMAGE_USAGE_STORAGE_BIT)
+     || !(srcImage->info().usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+     || dstImage->info().type != VK_IMAGE_TYPE_2D)
+      return false;
+
+    auto formatInfo = imageFormatInfo(format);
+
+    if (formatInfo->aspectMask != VK_IMAGE_ASPECT_COLOR_BIT
+     || formatInfo->flags.any(DxvkFormatFlag::SampledUInt, DxvkFormatFlag::SampledSInt))
+      return false;
+
+    VkFormatProperties formatProperties = m_device->adapter()->formatProperties(format);
+
+    VkFormatFeatureFlags dstFeatures = dstImage->info().tiling == VK_IMAGE_TILING_OPTIMAL
+      ? formatProperties.optimalTilingFeatures
+      : formatProperties.linearTilingFeatures;
+
+    return (dstFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+        && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+  }
+
+
+  DxvkMetaResolvePipeline DxvkMetaResolveObjects::getComputePipeline(
+          VkSampleCountFlagBits     samples,
+          VkResolveModeFlagBitsKHR  mode) {
+    DxvkMetaResolveComputeKey key;
+    key.samples = samples;
+    key.mode    = mode;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_computePipelines.find(key);
+    if (entry != m_computePipelines.end())
       return entry->second;
 
-    DxvkMetaResolvePipeline pipeline = createPipeline(key);
-    m_pipelines.insert({ key, pipeline });
+    m_device->addStatCtr(DxvkStatCounter::MetaPipelineMisses, 1);
+
+    DxvkMetaResolvePipeline pipeline = createComputePipeline(key);
+    m_computePipelines.insert({ key, pipeline });
     return pipeline;
   }
   
@@ -159,6 +270,24 @@ namespace dxvk {
   }
 
   
+  DxvkMetaResolvePipeline DxvkMetaResolveObjects::getOrCreatePipeline(
+    const DxvkMetaResolvePipelineKey& key,
+          bool                   countMiss) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_pipelines.find(key);
+    if (entry != m_pipelines.end())
+      return entry->second;
+
+    if (countMiss)
+      m_device->addStatCtr(DxvkStatCounter::MetaPipelineMisses, 1);
+
+    DxvkMetaResolvePipeline pipeline = createPipeline(key);
+    m_pipelines.insert({ key, pipeline });
+    return pipeline;
+  }
+
+
   DxvkMetaResolvePipeline DxvkMetaResolveObjects::createPipeline(
     const DxvkMetaResolvePipelineKey& key) {
     DxvkMetaResolvePipeline pipeline;
@@ -338,9 +467,62 @@ namespace dxvk {
     info.basePipelineIndex      = -1;
     
     VkPipeline result = VK_NULL_HANDLE;
-    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), VK_NULL_HANDLE, 1, &info, nullptr, &result) != VK_SUCCESS)
+    if (m_vkd->vkCreateGraphicsPipelines(m_vkd->device(), m_cache->handle(), 1, &info, nullptr, &result) != VK_SUCCESS)
       throw DxvkError("DxvkMetaCopyObjects: Failed to create graphics pipeline");
     return result;
   }
 
+
+  DxvkMetaResolvePipeline DxvkMetaResolveObjects::createComputePipeline(
+    const DxvkMetaResolveComputeKey& key) {
+    DxvkMetaResolvePipeline pipeline;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {{
+      { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler },
+      { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr    },
+    }};
+
+    VkDescriptorSetLayoutCreateInfo setInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    setInfo.bindingCount = bindings.size();
+    setInfo.pBindings = bindings.data();
+
+    if (m_vkd->vkCreateDescriptorSetLayout(m_vkd->device(), &setInfo, nullptr, &pipeline.dsetLayout) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaResolveObjects: Failed to create descriptor set layout");
+
+    VkPushConstantRange push = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DxvkMetaResolveComputeArgs) };
+
+    VkPipelineLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layoutInfo.setLayoutCount         = 1;
+    layoutInfo.pSetLayouts            = &pipeline.dsetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges    = &push;
+
+    if (m_vkd->vkCreatePipelineLayout(m_vkd->device(), &layoutInfo, nullptr, &pipeline.pipeLayout) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaResolveObjects: Failed to create pipeline layout");
+
+    std::array<VkSpecializationMapEntry, 2> specEntries = {{
+      { 0, offsetof(DxvkMetaResolveComputeKey, samples), sizeof(VkSampleCountFlagBits) },
+      { 1, offsetof(DxvkMetaResolveComputeKey, mode),    sizeof(VkResolveModeFlagBitsKHR) },
+    }};
+
+    VkSpecializationInfo specInfo;
+    specInfo.mapEntryCount      = specEntries.size();
+    specInfo.pMapEntries        = specEntries.data();
+    specInfo.dataSize           = sizeof(key);
+    specInfo.pData              = &key;
+
+    VkComputePipelineCreateInfo info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    info.stage.sType            = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    info.stage.stage            = VK_SHADER_STAGE_COMPUTE_BIT;
+    info.stage.module           = m_shaderCompF;
+    info.stage.pName            = "main";
+    info.stage.pSpecializationInfo = &specInfo;
+    info.layout                 = pipeline.pipeLayout;
+    info.basePipelineIndex      = -1;
+
+    if (m_vkd->vkCreateComputePipelines(m_vkd->device(), m_cache->handle(), 1, &info, nullptr, &pipeline.pipeHandle) != VK_SUCCESS)
+      throw DxvkError("DxvkMetaResolveObjects: Failed to create compute pipeline");
+    return pipeline;
+  }
+
 }
@@ -11,6 +11,9 @@
 
 namespace dxvk {
 
+  class DxvkDevice;
+  class DxvkPipelineCache;
+
   /**
    * \brief Resolve pipeline
    * 
@@ -50,6 +53,39 @@ namespace dxvk {
     }
   };
 
+  /**
+   * \brief Compute resolve pipeline key
+   *
+   * Compute resolve pipelines write the destination
+   * image without a format qualifier, so they only
+   * depend on the sample count and resolve mode.
+   */
+  struct DxvkMetaResolveComputeKey {
+    VkSampleCountFlagBits     samples;
+    VkResolveModeFlagBitsKHR  mode;
+
+    bool eq(const DxvkMetaResolveComputeKey& other) const {
+      return this->samples == other.samples
+          && this->mode    == other.mode;
+    }
+
+    size_t hash() const {
+      return (uint32_t(samples) << 0)
+           ^ (uint32_t(mode)    << 8);
+    }
+  };
+
+  /**
+   * \brief Compute resolve arguments
+   *
+   * Passed to the compute shader as push constants.
+   */
+  struct DxvkMetaResolveComputeArgs {
+    VkOffset2D srcOffset;
+    VkOffset2D dstOffset;
+    VkExtent2D extent;
+  };
+
   /**
    * \brief Meta resolve views for attachment-based resolves
    */
@@ -80,6 +116,39 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Meta resolve views for compute resolves
+   *
+   * Creates a storage view for the destination
+   * image and a sampled view for the source image.
+   */
+  class DxvkMetaResolveComputeViews : public DxvkResource {
+
+  public:
+
+    DxvkMetaResolveComputeViews(
+      const Rc<vk::DeviceFn>&         vkd,
+      const Rc<DxvkImage>&            dstImage,
+      const VkImageSubresourceLayers& dstSubresources,
+      const Rc<DxvkImage>&            srcImage,
+      const VkImageSubresourceLayers& srcSubresources,
+            VkFormat                  format);
+
+    ~DxvkMetaResolveComputeViews();
+
+    VkImageView getDstView() const { return m_dstImageView; }
+    VkImageView getSrcView() const { return m_srcImageView; }
+
+  private:
+
+    Rc<vk::DeviceFn> m_vkd;
+
+    VkImageView m_dstImageView = VK_NULL_HANDLE;
+    VkImageView m_srcImageView = VK_NULL_HANDLE;
+
+  };
+
+
   /**
    * \brief Meta resolve objects
    * 
@@ -90,7 +159,9 @@ namespace dxvk {
 
   public:
 
-    DxvkMetaResolveObjects(const DxvkDevice* device);
+    DxvkMetaResolveObjects(
+            DxvkDevice*               device,
+      const DxvkPipelineCache*        cache);
     ~DxvkMetaResolveObjects();
 
     /**
@@ -108,9 +179,54 @@ namespace dxvk {
             VkResolveModeFlagBitsKHR  depthResolveMode,
             VkResolveModeFlagBitsKHR  stencilResolveMode);
 
+    /**
+     * \brief Compiles pipeline ahead of time
+     *
+     * Creates the same pipeline as \ref getPipeline
+     * would, but does not count as a pipeline miss.
+     * \param [in] format Destination image format
+     * \param [in] samples Destination sample count
+     * \param [in] depthResolveMode Depth resolve mode
+     * \param [in] stencilResolveMode Stencil resolve mode
+     */
+    void compilePipeline(
+            VkFormat                  format,
+            VkSampleCountFlagBits     samples,
+            VkResolveModeFlagBitsKHR  depthResolveMode,
+            VkResolveModeFlagBitsKHR  stencilResolveMode);
+
+    /**
+     * \brief Checks whether a compute resolve is possible
+     *
+     * Compute resolves require the destination image to
+     * support storage image writes in the given format,
+     * and only support float and normalized formats.
+     * \param [in] dstImage Destination image
+     * \param [in] srcImage Source image
+     * \param [in] format Format to resolve in
+     * \returns \c true if \ref getComputePipeline can be used
+     */
+    bool canResolveCompute(
+      const Rc<DxvkImage>&            dstImage,
+      const Rc<DxvkImage>&            srcImage,
+            VkFormat                  format) const;
+
+    /**
+     * \brief Creates pipeline for compute resolve
+     *
+     * \param [in] samples Source sample count
+     * \param [in] mode Color resolve mode
+     * \returns Compute pipeline for the operation
+     */
+    DxvkMetaResolvePipeline getComputePipeline(
+            VkSampleCountFlagBits     samples,
+            VkResolveModeFlagBitsKHR  mode);
+
   private:
 
-    Rc<vk::DeviceFn> m_vkd;
+    DxvkDevice*              m_device;
+    Rc<vk::DeviceFn>         m_vkd;
+    const DxvkPipelineCache* m_cache;
 
     VkSampler m_sampler;
 
@@ -121,6 +237,7 @@ namespace dxvk {
     VkShaderModule m_shaderFragI = VK_NULL_HANDLE;
     VkShaderModule m_shaderFragD = VK_NULL_HANDLE;
     VkShaderModule m_shaderFragDS = VK_NULL_HANDLE;
+    VkShaderModule m_shaderCompF  = VK_NULL_HANDLE;
 
     dxvk::mutex m_mutex;
 
@@ -128,12 +245,21 @@ namespace dxvk {
       DxvkMetaResolvePipelineKey,
       DxvkMetaResolvePipeline,
       DxvkHash, DxvkEq> m_pipelines;
+
+    std::unordered_map<
+      DxvkMetaResolveComputeKey,
+      DxvkMetaResolvePipeline,
+      DxvkHash, DxvkEq> m_computePipelines;
     
     VkSampler createSampler() const;
     
     VkShaderModule createShaderModule(
       const SpirvCodeBuffer&          code) const;
     
+    DxvkMetaResolvePipeline getOrCreatePipeline(
+      const DxvkMetaResolvePipelineKey& key,
+            bool                   countMiss);
+
     DxvkMetaResolvePipeline createPipeline(
       const DxvkMetaResolvePipelineKey& key);
 
@@ -146,6 +272,9 @@ namespace dxvk {
     VkPipeline createPipelineObject(
       const DxvkMetaResolvePipelineKey& key,
             VkPipelineLayout       pipelineLayout);
+
+    DxvkMetaResolvePipeline createComputePipeline(
+      const DxvkMetaResolveComputeKey& key);
     
   };
 
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "dxvk_buffer_ring.h"
+#include "dxvk_buffer_suballoc.h"
+#include "dxvk_defrag.h"
 #include "dxvk_gpu_event.h"
+#include "dxvk_gpu_profiler.h"
 #include "dxvk_gpu_query.h"
+#include "dxvk_latency.h"
 #include "dxvk_memory.h"
+#include "dxvk_memory_dump.h"
 #include "dxvk_meta_blit.h"
 #include "dxvk_meta_clear.h"
 #include "dxvk_meta_copy.h"
@@ -11,6 +17,10 @@
 #include "dxvk_meta_resolve.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_renderpass.h"
+#include "dxvk_resource_pool.h"
+#include "dxvk_shader_cache.h"
+#include "dxvk_staging.h"
+#include "dxvk_stats_export.h"
 #include "dxvk_unbound.h"
 
 #include "../util/util_lazy.h"
@@ -24,9 +34,14 @@ namespace dxvk {
     DxvkObjects(DxvkDevice* device)
     : m_device          (device),
       m_memoryManager   (device),
+      m_bufferRing      (device, m_memoryManager),
+      m_bufferSuballoc  (device, m_memoryManager),
+      m_stagingPool     (device),
+      m_resourcePool    (device),
       m_pipelineManager (device),
       m_eventPool       (device),
       m_queryPool       (device),
+      m_samplerPool     (device),
       m_dummyResources  (device) {
 
     }
@@ -35,6 +50,26 @@ namespace dxvk {
       return m_memoryManager;
     }
 
+    DxvkBufferRing& bufferRing() {
+      return m_bufferRing;
+    }
+
+    DxvkBufferSuballocator& bufferSuballocator() {
+      return m_bufferSuballoc;
+    }
+
+    DxvkMemoryDefragmenter& defragmenter() {
+      return m_defragmenter;
+    }
+
+    DxvkStagingPool& stagingPool() {
+      return m_stagingPool;
+    }
+
+    DxvkResourcePool& resourcePool() {
+      return m_resourcePool;
+    }
+
     DxvkPipelineManager& pipelineManager() {
       return m_pipelineManager;
     }
@@ -47,12 +82,16 @@ namespace dxvk {
       return m_queryPool;
     }
 
+    DxvkSamplerPool& samplerPool() {
+      return m_samplerPool;
+    }
+
     DxvkUnboundResources& dummyResources() {
       return m_dummyResources;
     }
 
     DxvkMetaBlitObjects& metaBlit() {
-      return m_metaBlit.get(m_device);
+      return m_metaBlit.get(m_device, m_pipelineManager.getPipelineCache());
     }
 
     DxvkMetaClearObjects& metaClear() {
@@ -60,15 +99,39 @@ namespace dxvk {
     }
 
     DxvkMetaCopyObjects& metaCopy() {
-      return m_metaCopy.get(m_device);
+      return m_metaCopy.get(m_device, m_pipelineManager.getPipelineCache());
+    }
+
+    DxvkMetaMipGenObjects& metaMipGen() {
+      return m_metaMipGen.get(m_device, m_pipelineManager.getPipelineCache());
     }
 
     DxvkMetaResolveObjects& metaResolve() {
-      return m_metaResolve.get(m_device);
+      return m_metaResolve.get(m_device, m_pipelineManager.getPipelineCache());
     }
     
     DxvkMetaPackObjects& metaPack() {
-      return m_metaPack.get(m_device);
+      return m_metaPack.get(m_device, m_pipelineManager.getPipelineCache());
+    }
+
+    DxvkShaderCache& shaderCache() {
+      return m_shaderCache.get(m_device);
+    }
+
+    DxvkGpuProfiler& gpuProfiler() {
+      return m_gpuProfiler.get(m_device);
+    }
+
+    DxvkLatencyTracker& latencyTracker() {
+      return m_latencyTracker.get(m_device);
+    }
+
+    DxvkStatsExporter& statsExporter() {
+      return m_statsExporter.get(m_device);
+    }
+
+    DxvkMemoryDumper& memoryDumper() {
+      return m_memoryDumper.get(&m_memoryManager);
     }
 
   private:
@@ -76,19 +139,35 @@ namespace dxvk {
     DxvkDevice*                   m_device;
 
     DxvkMemoryAllocator           m_memoryManager;
+    DxvkBufferRing                m_bufferRing;
+    DxvkBufferSuballocator        m_bufferSuballoc;
+    DxvkMemoryDefragmenter        m_defragmenter;
+    DxvkStagingPool               m_stagingPool;
+    DxvkResourcePool              m_resourcePool;
+
+    // Pipelines keep shaders alive, and shaders
+    // unregister themselves from the shader cache
+    Lazy<DxvkShaderCache>         m_shaderCache;
     DxvkPipelineManager           m_pipelineManager;
 
     DxvkGpuEventPool              m_eventPool;
     DxvkGpuQueryPool              m_queryPool;
+    DxvkSamplerPool               m_samplerPool;
 
     DxvkUnboundResources          m_dummyResources;
 
     Lazy<DxvkMetaBlitObjects>     m_metaBlit;
     Lazy<DxvkMetaClearObjects>    m_metaClear;
     Lazy<DxvkMetaCopyObjects>     m_metaCopy;
+    Lazy<DxvkMetaMipGenObjects>   m_metaMipGen;
     Lazy<DxvkMetaResolveObjects>  m_metaResolve;
     Lazy<DxvkMetaPackObjects>     m_metaPack;
 
+    Lazy<DxvkGpuProfiler>         m_gpuProfiler;
+    Lazy<DxvkLatencyTracker>      m_latencyTracker;
+    Lazy<DxvkStatsExporter>       m_statsExporter;
+    Lazy<DxvkMemoryDumper>        m_memoryDumper;
+
   };
 
 }
\ No newline at end of file
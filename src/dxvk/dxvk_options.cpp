@@ -1,13 +1,65 @@
+#include <algorithm>
+#include <cstdlib>
+
 #include "dxvk_options.h"
 
+#include "../util/log/log.h"
+#include "../util/thread.h"
+#include "../util/util_string.h"
+
 namespace dxvk {
 
+  static uint64_t parseThreadAffinity(const Config& config, const char* option) {
+    std::string value = config.getOption<std::string>(option, "");
+
+    if (value.empty() || value == "any")
+      return 0;
+
+    if (value == "performance")
+      return dxvk::thread::core_mask(ThreadCoreClass::Performance);
+
+    if (value == "efficiency")
+      return dxvk::thread::core_mask(ThreadCoreClass::Efficiency);
+
+    char* end = nullptr;
+    uint64_t mask = std::strtoull(value.c_str(), &end, 0);
+
+    if (!end || *end) {
+      Logger::warn(str::format("Invalid value for ", option, ": ", value));
+      return 0;
+    }
+
+    return mask;
+  }
+
+
   DxvkOptions::DxvkOptions(const Config& config) {
     enableDebugUtils      = config.getOption<bool>    ("dxvk.enableDebugUtils",       false);
     enableStateCache      = config.getOption<bool>    ("dxvk.enableStateCache",       true);
+    enableShaderCache     = config.getOption<bool>    ("dxvk.enableShaderCache",      true);
+    enablePipelineCache   = config.getOption<bool>    ("dxvk.enablePipelineCache",    true);
+    shareStateCache       = config.getOption<bool>    ("dxvk.shareStateCache",        true);
+    stateCacheMaxSize     = config.getOption<int32_t> ("dxvk.stateCacheMaxSize",      0);
     numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
+    enableGraphicsPipelineLibrary = config.getOption<Tristate>("dxvk.enableGraphicsPipelineLibrary", Tristate::Auto);
+    enableSynchronization2 = config.getOption<bool>   ("dxvk.enableSynchronization2", true);
+    enableAsync           = config.getOption<bool>    ("dxvk.enableAsync",            false);
     useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
+    enableBufferDeviceAddress = config.getOption<bool>("dxvk.enableBufferDeviceAddress", false);
+    optimizeSpirv         = config.getOption<bool>    ("dxvk.optimizeSpirv",          false);
     shrinkNvidiaHvvHeap   = config.getOption<Tristate>("dxvk.shrinkNvidiaHvvHeap",    Tristate::Auto);
+    memoryDefragRate      = std::max(config.getOption<int32_t>("dxvk.memoryDefragRate", 0), 0);
+    maxBarMemory          = config.getOption<int32_t> ("dxvk.maxBarMemory",           -1);
+    memoryEvictThreshold  = config.getOption<int32_t> ("dxvk.memoryEvictThreshold",   0);
+    lazyImageAllocation   = config.getOption<bool>    ("dxvk.lazyImageAllocation",    false);
+    inferDepthStoreOps    = config.getOption<bool>    ("dxvk.inferDepthStoreOps",     false);
+    elideRedundantState   = config.getOption<bool>    ("dxvk.elideRedundantState",    false);
+    csThreadAffinity      = parseThreadAffinity(config, "dxvk.csThreadAffinity");
+    submitThreadAffinity  = parseThreadAffinity(config, "dxvk.submitThreadAffinity");
+    workerThreadAffinity  = parseThreadAffinity(config, "dxvk.workerThreadAffinity");
+    adaptiveUpscale       = config.getOption<bool>    ("dxvk.adaptiveUpscale",        false);
+    upscaleSharpness      = config.getOption<int32_t> ("dxvk.upscaleSharpness",       50);
+    profileAnnotations    = config.getOption<bool>    ("dxvk.profileAnnotations",     false);
     hud                   = config.getOption<std::string>("dxvk.hud", "");
   }
 
@@ -14,16 +14,93 @@ namespace dxvk {
     /// Enable state cache
     bool enableStateCache;
 
+    /// Enable persistent SPIR-V shader cache
+    bool enableShaderCache;
+
+    /// Store Vulkan pipeline cache on disk
+    bool enablePipelineCache;
+
+    /// Pick up state cache entries written by
+    /// other processes while the game is running
+    bool shareStateCache;
+
+    /// Maximum state cache file size, in MiB.
+    /// Zero means that the size is not limited.
+    int32_t stateCacheMaxSize;
+
     /// Number of compiler threads
     /// when using the state cache
     int32_t numCompilerThreads;
 
+    /// Enable graphics pipeline library
+    Tristate enableGraphicsPipelineLibrary;
+
+    /// Use synchronization2 for pipeline
+    /// barriers if supported by the device
+    bool enableSynchronization2;
+
+    /// Compile pipelines asynchronously and
+    /// skip draws until they are available
+    bool enableAsync;
+
     /// Shader-related options
     Tristate useRawSsbo;
 
+    /// Enable buffer device addresses for
+    /// shader-visible buffers if supported
+    bool enableBufferDeviceAddress;
+
+    /// Run the built-in SPIR-V optimizer
+    /// on translated shaders
+    bool optimizeSpirv;
+
     /// Workaround for NVIDIA driver bug 3114283
     Tristate shrinkNvidiaHvvHeap;
 
+    /// Maximum amount of buffer memory, in MiB,
+    /// to relocate per frame. 0 disables defrag.
+    int32_t memoryDefragRate;
+
+    /// Maximum amount of device-local, host-visible
+    /// memory, in MiB, to use for CPU-written resources.
+    /// Negative values select a default based on heap size.
+    int32_t maxBarMemory;
+
+    /// Usage of the device-local heap, in percent of
+    /// the budget, above which idle resources get
+    /// evicted to system memory. 0 disables eviction.
+    int32_t memoryEvictThreshold;
+
+    /// Defer allocating image memory until
+    /// the image is first used or mapped
+    bool lazyImageAllocation;
+
+    /// Skip storing depth buffers whose contents
+    /// are consistently not read after a render pass
+    bool inferDepthStoreOps;
+
+    /// Let the CS thread skip state commands that
+    /// are overwritten before they can take effect
+    bool elideRedundantState;
+
+    /// CPU affinity masks for the CS thread, the
+    /// submission thread and worker threads. A
+    /// mask of 0 lets threads run on any core.
+    uint64_t csThreadAffinity;
+    uint64_t submitThreadAffinity;
+    uint64_t workerThreadAffinity;
+
+    /// Magnify back buffers that are smaller than the
+    /// window with an edge-adaptive sharpening filter
+    bool adaptiveUpscale;
+
+    /// Sharpening strength of the upscaler, in percent
+    int32_t upscaleSharpness;
+
+    /// Time application markers on the CPU
+    /// when the GPU profiler is enabled
+    bool profileAnnotations;
+
     /// HUD elements
     std::string hud;
   };
@@ -1,26 +1,231 @@
+#include "dxvk_device.h"
 #include "dxvk_pipecache.h"
 
 namespace dxvk {
   
   DxvkPipelineCache::DxvkPipelineCache(
-    const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
+          DxvkDevice*             device)
+  : m_device(device), m_vkd(device->vkd()) {
+    std::string usePipelineCache = env::getEnvVar("DXVK_PIPELINE_CACHE");
+
+    m_persistent = usePipelineCache != "0"
+      && device->config().enablePipelineCache;
+
+    std::vector<char> data;
+
+    if (m_persistent) {
+      sync::FileLock fileLock(getLockFileName());
+      std::lock_guard<sync::FileLock> lock(fileLock);
+
+      data = readCacheFile();
+    }
+
+    // Every cache starts out with the stored data since we
+    // do not know which thread will need which pipelines
+    for (uint32_t i = 0; i < ThreadCacheCount; i++)
+      m_handles[i] = createCache(data);
+  }
+  
+  
+  DxvkPipelineCache::~DxvkPipelineCache() {
+    // Failing to store the cache is not fatal, and
+    // destructors must not let exceptions escape
+    if (m_persistent) {
+      try {
+        writeCacheFile();
+      } catch (const DxvkError& e) {
+        Logger::err(e.message());
+      }
+    }
+
+    for (auto handle : m_handles) {
+      m_vkd->vkDestroyPipelineCache(
+        m_vkd->device(), handle, nullptr);
+    }
+  }
+
+
+  VkPipelineCache DxvkPipelineCache::handle() const {
+    return m_handles[getThreadIndex() % ThreadCacheCount];
+  }
+
+
+  VkPipelineCache DxvkPipelineCache::createCache(
+    const std::vector<char>&    data) const {
     VkPipelineCacheCreateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     info.pNext            = nullptr;
     info.flags            = 0;
-    info.initialDataSize  = 0;
-    info.pInitialData     = nullptr;
+    info.initialDataSize  = data.size();
+    info.pInitialData     = data.data();
     
+    VkPipelineCache handle = VK_NULL_HANDLE;
+
     if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
-        &info, nullptr, &m_handle) != VK_SUCCESS)
+        &info, nullptr, &handle) != VK_SUCCESS)
       throw DxvkError("DxvkPipelineCache: Failed to create cache");
+
+    return handle;
   }
-  
-  
-  DxvkPipelineCache::~DxvkPipelineCache() {
-    m_vkd->vkDestroyPipelineCache(
-      m_vkd->device(), m_handle, nullptr);
+
+
+  std::vector<char> DxvkPipelineCache::readCacheFile() const {
+    std::ifstream file(getCacheFileName().c_str(), std::ios_base::binary);
+
+    if (!file)
+      return std::vector<char>();
+
+    DxvkPipelineCacheHeader expected = getCacheHeader();
+    DxvkPipelineCacheHeader header;
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+     || header.version       != expected.version
+     || header.vendorId      != expected.vendorId
+     || header.deviceId      != expected.deviceId
+     || header.driverVersion != expected.driverVersion
+     || std::memcmp(header.uuid, expected.uuid, sizeof(header.uuid))) {
+      Logger::warn("DXVK: Pipeline cache outdated, discarding");
+      return std::vector<char>();
+    }
+
+    // Do not trust the size stored in the header before
+    // checking it against the amount of data in the file
+    std::streampos dataOffset = file.tellg();
+    file.seekg(0, std::ios_base::end);
+    std::streampos fileSize = file.tellg();
+    file.seekg(dataOffset);
+
+    if (!file || fileSize - dataOffset != std::streamoff(header.dataSize)) {
+      Logger::warn("DXVK: Pipeline cache corrupted, discarding");
+      return std::vector<char>();
+    }
+
+    std::vector<char> data(header.dataSize);
+
+    if (!file.read(data.data(), data.size())
+     || Hash128::compute(data.data(), data.size()) != header.dataHash) {
+      Logger::warn("DXVK: Pipeline cache corrupted, discarding");
+      return std::vector<char>();
+    }
+
+    Logger::info(str::format("DXVK: Read ", data.size(), " bytes of pipeline cache data"));
+    return data;
+  }
+
+
+  void DxvkPipelineCache::writeCacheFile() const {
+    auto fileLock = std::make_unique<sync::FileLock>(getLockFileName());
+
+    if (!fileLock->isValid() && env::createDirectory(getCacheDir()))
+      fileLock = std::make_unique<sync::FileLock>(getLockFileName());
+
+    std::lock_guard<sync::FileLock> lock(*fileLock);
+
+    // Other instances of the game may have written the file
+    // since we read it, so merge their data with ours rather
+    // than throwing away the pipelines they compiled
+    std::vector<VkPipelineCache> handles(m_handles.begin(), m_handles.end());
+    std::vector<char> diskData = readCacheFile();
+
+    if (!diskData.empty()) {
+      try {
+        handles.push_back(createCache(diskData));
+      } catch (const DxvkError& e) {
+        Logger::warn("DXVK: Failed to load stored pipeline cache, overwriting");
+      }
+    }
+
+    // A cache cannot be merged into itself, so merge all
+    // per-thread caches into a new one and store that
+    VkPipelineCache merged = createCache(std::vector<char>());
+    std::vector<char> data;
+
+    if (m_vkd->vkMergePipelineCaches(m_vkd->device(), merged,
+        handles.size(), handles.data()) == VK_SUCCESS) {
+      size_t size = 0;
+
+      if (m_vkd->vkGetPipelineCacheData(m_vkd->device(), merged, &size, nullptr) == VK_SUCCESS) {
+        data.resize(size);
+
+        if (m_vkd->vkGetPipelineCacheData(m_vkd->device(), merged, &size, data.data()) != VK_SUCCESS)
+          data.clear();
+        else
+          data.resize(size);
+      }
+    }
+
+    m_vkd->vkDestroyPipelineCache(m_vkd->device(), merged, nullptr);
+
+    if (handles.size() > m_handles.size())
+      m_vkd->vkDestroyPipelineCache(m_vkd->device(), handles.back(), nullptr);
+
+    if (data.empty()) {
+      Logger::warn("DXVK: Failed to retrieve pipeline cache data");
+      return;
+    }
+
+    DxvkPipelineCacheHeader header = getCacheHeader();
+    header.dataSize = uint32_t(data.size());
+    header.dataHash = Hash128::compute(data.data(), data.size());
+
+    std::ofstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(getCacheFileName().c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), data.size());
+  }
+
+
+  DxvkPipelineCacheHeader DxvkPipelineCache::getCacheHeader() const {
+    const auto& properties = m_device->properties().core.properties;
+
+    DxvkPipelineCacheHeader header;
+    header.vendorId       = properties.vendorID;
+    header.deviceId       = properties.deviceID;
+    header.driverVersion  = properties.driverVersion;
+    std::memcpy(header.uuid, properties.pipelineCacheUUID, sizeof(header.uuid));
+    return header;
+  }
+
+
+  std::wstring DxvkPipelineCache::getCacheFileName() const {
+    const auto& properties = m_device->properties().core.properties;
+
+    std::string path = getCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    // Use one file per adapter so that systems with
+    // multiple GPUs do not keep discarding the data
+    path += str::format(env::getExeBaseName(), "_",
+      properties.vendorID, "_", properties.deviceID, ".dxvk-pipecache");
+    return str::tows(path.c_str());
+  }
+
+
+  std::wstring DxvkPipelineCache::getLockFileName() const {
+    return getCacheFileName() + L".lock";
+  }
+
+
+  std::string DxvkPipelineCache::getCacheDir() const {
+    return env::getEnvVar("DXVK_STATE_CACHE_PATH");
+  }
+
+
+  uint32_t DxvkPipelineCache::getThreadIndex() {
+    static std::atomic<uint32_t> s_threadCount = { 0u };
+    static thread_local uint32_t s_threadIndex = s_threadCount++;
+    return s_threadIndex;
   }
   
 }
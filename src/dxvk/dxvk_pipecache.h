@@ -1,42 +1,94 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <fstream>
 
 #include "dxvk_include.h"
 
-#include "../util/sha1/sha1_util.h"
 #include "../util/util_env.h"
+#include "../util/util_hash128.h"
 #include "../util/util_time.h"
 
+#include "../util/sync/sync_file_lock.h"
+
 namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Pipeline cache file header
+   *
+   * Identifies the adapter and driver that the cached
+   * data was created with. The data is discarded if
+   * any of these do not match the current device.
+   */
+  struct DxvkPipelineCacheHeader {
+    char     magic[4]       = { 'D', 'X', 'P', 'C' };
+    uint32_t version        = 2;
+    uint32_t vendorId       = 0;
+    uint32_t deviceId       = 0;
+    uint32_t driverVersion  = 0;
+    uint8_t  uuid[VK_UUID_SIZE] = { };
+    uint32_t dataSize       = 0;
+    Hash128  dataHash;
+  };
   
   /**
    * \brief Pipeline cache
    * 
-   * Allows the Vulkan implementation to
-   * re-use previously compiled pipelines.
+   * Allows the Vulkan implementation to re-use previously
+   * compiled pipelines. Threads are spread across multiple
+   * Vulkan pipeline caches so that they do not serialize
+   * on the driver's cache lock. All caches get merged and
+   * written to disk when the object is destroyed, and the
+   * stored data is used to initialize each cache on the
+   * next run. If another process has written the file in
+   * the meantime, its data is merged rather than replaced.
    */
   class DxvkPipelineCache : public RcObject {
-    
+    /// Number of Vulkan caches to spread threads across
+    constexpr static uint32_t ThreadCacheCount = 4;
   public:
     
-    DxvkPipelineCache(const Rc<vk::DeviceFn>& vkd);
+    DxvkPipelineCache(DxvkDevice* device);
     ~DxvkPipelineCache();
     
     /**
      * \brief Pipeline cache handle
+     *
+     * The returned cache depends on the calling
+     * thread, so the handle should be queried
+     * right before creating pipelines.
      * \returns Pipeline cache handle
      */
-    VkPipelineCache handle() const {
-      return m_handle;
-    }
+    VkPipelineCache handle() const;
     
   private:
     
+    DxvkDevice*             m_device;
     Rc<vk::DeviceFn>        m_vkd;
-    VkPipelineCache         m_handle;
+    bool                    m_persistent = false;
+
+    std::array<VkPipelineCache, ThreadCacheCount> m_handles = { };
+
+    VkPipelineCache createCache(
+      const std::vector<char>&    data) const;
+
+    std::vector<char> readCacheFile() const;
+
+    void writeCacheFile() const;
+
+    DxvkPipelineCacheHeader getCacheHeader() const;
+
+    std::wstring getCacheFileName() const;
+
+    std::wstring getLockFileName() const;
+
+    std::string getCacheDir() const;
+
+    static uint32_t getThreadIndex();
     
   };
   
@@ -11,7 +11,8 @@ namespace dxvk {
     if (stages & (VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT)) {
       // For fragment shaders, create a separate set for UBOs
       if (descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
-       || descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+       || descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+       || descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
         return DxvkDescriptorSets::FsBuffers;
 
       return DxvkDescriptorSets::FsViews;
@@ -30,22 +31,32 @@ namespace dxvk {
 
     return descriptorType    == binding.descriptorType
         && resourceBinding   == binding.resourceBinding
-        && viewType          == binding.viewType;
+        && viewType          == binding.viewType
+        && sampler           == binding.sampler;
   }
 
 
   void DxvkBindingInfo::merge(const DxvkBindingInfo& binding) {
     stages |= binding.stages;
     access |= binding.access;
+
+    uniformSize = (uniformSize && binding.uniformSize)
+      ? std::max(uniformSize, binding.uniformSize)
+      : 0u;
   }
 
 
   bool DxvkBindingInfo::eq(const DxvkBindingInfo& other) const {
+    // The size of inline uniform blocks is part of the set layout
+    if (isInlineUniformBlock() && uniformSize != other.uniformSize)
+      return false;
+
     return descriptorType    == other.descriptorType
         && resourceBinding   == other.resourceBinding
         && viewType          == other.viewType
         && stages            == other.stages
-        && access            == other.access;
+        && access            == other.access
+        && sampler           == other.sampler;
   }
 
 
@@ -56,6 +67,11 @@ namespace dxvk {
     hash.add(viewType);
     hash.add(stages);
     hash.add(access);
+    hash.add(reinterpret_cast<uintptr_t>(sampler));
+
+    if (isInlineUniformBlock())
+      hash.add(uniformSize);
+
     return hash;
   }
 
@@ -78,7 +94,14 @@ namespace dxvk {
       }
     }
 
-    m_bindings.push_back(binding);
+    // Keep immutable samplers at the end of the list
+    // so that they can be skipped for descriptor writes
+    if (binding.isImmutableSampler()) {
+      m_bindings.push_back(binding);
+    } else {
+      m_bindings.insert(m_bindings.begin() + m_writeCount, binding);
+      m_writeCount += 1;
+    }
   }
 
 
@@ -88,6 +111,29 @@ namespace dxvk {
   }
 
 
+  void DxvkBindingList::makeUniformBuffersDynamic(uint32_t maxCount) {
+    for (auto& b : m_bindings) {
+      if (!maxCount)
+        return;
+
+      if (b.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        b.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        maxCount -= 1;
+      }
+    }
+  }
+
+
+  bool DxvkBindingList::hasInlineUniformBlocks() const {
+    for (const auto& b : m_bindings) {
+      if (b.isInlineUniformBlock())
+        return true;
+    }
+
+    return false;
+  }
+
+
   bool DxvkBindingList::eq(const DxvkBindingList& other) const {
     if (getBindingCount() != other.getBindingCount())
       return false;
@@ -111,12 +157,16 @@ namespace dxvk {
   }
 
 
-  DxvkBindingSetLayoutKey::DxvkBindingSetLayoutKey(const DxvkBindingList& list) {
+  DxvkBindingSetLayoutKey::DxvkBindingSetLayoutKey(const DxvkBindingList& list, bool push)
+  : m_push(push) {
     m_bindings.resize(list.getBindingCount());
 
     for (uint32_t i = 0; i < list.getBindingCount(); i++) {
       m_bindings[i].descriptorType = list.getBinding(i).descriptorType;
       m_bindings[i].stages         = list.getBinding(i).stages;
+      m_bindings[i].count          = list.getBinding(i).isInlineUniformBlock()
+        ? list.getBinding(i).uniformSize : 1u;
+      m_bindings[i].sampler        = list.getBinding(i).sampler;
     }
   }
 
@@ -127,12 +177,15 @@ namespace dxvk {
 
 
   bool DxvkBindingSetLayoutKey::eq(const DxvkBindingSetLayoutKey& other) const {
-    if (m_bindings.size() != other.m_bindings.size())
+    if (m_bindings.size() != other.m_bindings.size()
+     || m_push != other.m_push)
       return false;
 
     for (size_t i = 0; i < m_bindings.size(); i++) {
       if (m_bindings[i].descriptorType != other.m_bindings[i].descriptorType
-       || m_bindings[i].stages         != other.m_bindings[i].stages)
+       || m_bindings[i].stages         != other.m_bindings[i].stages
+       || m_bindings[i].count          != other.m_bindings[i].count
+       || m_bindings[i].sampler        != other.m_bindings[i].sampler)
         return false;
     }
 
@@ -142,10 +195,13 @@ namespace dxvk {
 
   size_t DxvkBindingSetLayoutKey::hash() const {
     DxvkHashState hash;
+    hash.add(uint32_t(m_push));
 
     for (size_t i = 0; i < m_bindings.size(); i++) {
       hash.add(m_bindings[i].descriptorType);
       hash.add(m_bindings[i].stages);
+      hash.add(m_bindings[i].count);
+      hash.add(reinterpret_cast<uintptr_t>(m_bindings[i].sampler.ptr()));
     }
 
     return hash;
@@ -155,27 +211,46 @@ namespace dxvk {
   DxvkBindingSetLayout::DxvkBindingSetLayout(
           DxvkDevice*           device,
     const DxvkBindingSetLayoutKey& key)
-  : m_device(device) {
+  : m_device(device), m_push(key.isPushSet()) {
     auto vk = m_device->vkd();
 
     std::array<VkDescriptorSetLayoutBinding, MaxNumActiveBindings> bindingInfos;
     std::array<VkDescriptorUpdateTemplateEntry, MaxNumActiveBindings> templateInfos;
+    std::array<VkSampler, MaxNumActiveBindings> samplers;
 
     VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
     layoutInfo.bindingCount = key.getBindingCount();
     layoutInfo.pBindings = bindingInfos.data();
 
+    if (m_push)
+      layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+
+    bool hasInlineUniformBlocks = false;
+    uint32_t templateEntryCount = 0;
+
     for (uint32_t i = 0; i < key.getBindingCount(); i++) {
-      auto entry = key.getBinding(i);
+      const auto& entry = key.getBinding(i);
 
       VkDescriptorSetLayoutBinding& bindingInfo = bindingInfos[i];
       bindingInfo.binding = i;
       bindingInfo.descriptorType = entry.descriptorType;
-      bindingInfo.descriptorCount = 1;
+      bindingInfo.descriptorCount = entry.count;
       bindingInfo.stageFlags = entry.stages;
       bindingInfo.pImmutableSamplers = nullptr;
 
-      VkDescriptorUpdateTemplateEntry& templateInfo = templateInfos[i];
+      if (entry.sampler != nullptr) {
+        samplers[i] = entry.sampler->handle();
+        bindingInfo.pImmutableSamplers = &samplers[i];
+
+        // Immutable samplers are never written
+        if (entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER)
+          continue;
+      }
+
+      if (entry.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT)
+        hasInlineUniformBlocks = true;
+
+      VkDescriptorUpdateTemplateEntry& templateInfo = templateInfos[templateEntryCount++];
       templateInfo.dstBinding = i;
       templateInfo.dstArrayElement = 0;
       templateInfo.descriptorCount = 1;
@@ -187,9 +262,13 @@ namespace dxvk {
     if (vk->vkCreateDescriptorSetLayout(vk->device(), &layoutInfo, nullptr, &m_layout) != VK_SUCCESS)
       throw DxvkError("DxvkBindingSetLayoutKey: Failed to create descriptor set layout");
 
-    if (layoutInfo.bindingCount) {
+    // Push descriptors are written directly, and templates for
+    // them would have to be created for a specific pipeline layout.
+    // Inline uniform block data cannot be stored in the descriptor
+    // info array, so sets that contain any are written directly too.
+    if (templateEntryCount && !m_push && !hasInlineUniformBlocks) {
       VkDescriptorUpdateTemplateCreateInfo templateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO };
-      templateInfo.descriptorUpdateEntryCount = layoutInfo.bindingCount;
+      templateInfo.descriptorUpdateEntryCount = templateEntryCount;
       templateInfo.pDescriptorUpdateEntries = templateInfos.data();
       templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
       templateInfo.descriptorSetLayout = m_layout;
@@ -243,6 +322,14 @@ namespace dxvk {
   }
 
 
+  void DxvkBindingLayout::makeUniformBuffersDynamic(uint32_t maxCountPerSet, uint32_t setMask) {
+    for (uint32_t i = 0; i < m_bindings.size(); i++) {
+      if (setMask & (1u << i))
+        m_bindings[i].makeUniformBuffersDynamic(maxCountPerSet);
+    }
+  }
+
+
   bool DxvkBindingLayout::eq(const DxvkBindingLayout& other) const {
     for (uint32_t i = 0; i < m_bindings.size(); i++) {
       if (!m_bindings[i].eq(other.m_bindings[i]))
@@ -298,6 +385,9 @@ namespace dxvk {
 
       if (bindingCount)
         m_setMask |= 1u << i;
+
+      if (setObjects[i]->isPushSet())
+        m_pushSetMask |= 1u << i;
     }
 
     VkPushConstantRange pushConst = m_layout.getPushConstantRange();
@@ -311,15 +401,30 @@ namespace dxvk {
       pipelineLayoutInfo.pPushConstantRanges = &pushConst;
     }
 
-    if (vk->vkCreatePipelineLayout(vk->device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout))
+    if (vk->vkCreatePipelineLayout(vk->device(), &pipelineLayoutInfo, nullptr, &m_completeLayout))
       throw DxvkError("DxvkBindingLayoutObjects: Failed to create pipeline layout");
+
+    // Pipeline libraries require a layout with independent sets, and
+    // empty sets must be null so that libraries can be linked together
+    if (m_device->canUseGraphicsPipelineLibrary()) {
+      for (uint32_t i = 0; i < DxvkDescriptorSets::SetCount; i++) {
+        if (!(m_setMask & (1u << i)))
+          setLayouts[i] = VK_NULL_HANDLE;
+      }
+
+      pipelineLayoutInfo.flags = VK_PIPELINE_LAYOUT_CREATE_INDEPENDENT_SETS_BIT_EXT;
+
+      if (vk->vkCreatePipelineLayout(vk->device(), &pipelineLayoutInfo, nullptr, &m_independentLayout))
+        throw DxvkError("DxvkBindingLayoutObjects: Failed to create pipeline layout");
+    }
   }
 
 
   DxvkBindingLayoutObjects::~DxvkBindingLayoutObjects() {
     auto vk = m_device->vkd();
 
-    vk->vkDestroyPipelineLayout(vk->device(), m_pipelineLayout, nullptr);
+    vk->vkDestroyPipelineLayout(vk->device(), m_completeLayout, nullptr);
+    vk->vkDestroyPipelineLayout(vk->device(), m_independentLayout, nullptr);
   }
 
 
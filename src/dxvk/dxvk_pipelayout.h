@@ -6,6 +6,7 @@
 
 #include "dxvk_hash.h"
 #include "dxvk_include.h"
+#include "dxvk_sampler.h"
 
 namespace dxvk {
 
@@ -33,6 +34,30 @@ namespace dxvk {
     VkImageViewType     viewType;         ///< Image view type
     VkShaderStageFlags  stages;           ///< Shader stage mask
     VkAccessFlags       access;           ///< Access mask for the resource
+    uint32_t            uniformSize;      ///< Accessed uniform buffer range in bytes, or 0 if unknown
+    DxvkSampler*        sampler;          ///< Immutable sampler, or \c nullptr
+
+    /**
+     * \brief Checks whether the binding is an inline uniform block
+     *
+     * The block size is stored in \c uniformSize.
+     * \returns \c true for inline uniform blocks
+     */
+    bool isInlineUniformBlock() const {
+      return descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT;
+    }
+
+    /**
+     * \brief Checks whether the binding is an immutable sampler
+     *
+     * Sampler bindings with an immutable sampler are fully
+     * defined by the set layout and never need to be written.
+     * Combined image samplers still need their image written.
+     * \returns \c true for immutable sampler bindings
+     */
+    bool isImmutableSampler() const {
+      return descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER && sampler;
+    }
 
     /**
      * \brief Computes descriptor set index for the given binding
@@ -58,6 +83,7 @@ namespace dxvk {
      *
      * Merges the stage and access flags of two
      * otherwise identical binding declarations.
+     * The uniform range covers both bindings.
      * \param [in] binding The binding to merge
      */
     void merge(const DxvkBindingInfo& binding);
@@ -99,6 +125,18 @@ namespace dxvk {
       return uint32_t(m_bindings.size());
     }
 
+    /**
+     * \brief Number of bindings that need descriptor writes
+     *
+     * Immutable sampler bindings are always stored at the
+     * end of the list, so that all bindings that need to
+     * be written are in the range returned by this.
+     * \returns Number of bindings to write
+     */
+    uint32_t getDescriptorWriteCount() const {
+      return m_writeCount;
+    }
+
     /**
      * \brief Retrieves binding info
      *
@@ -125,6 +163,22 @@ namespace dxvk {
      */
     void merge(const DxvkBindingList& list);
 
+    /**
+     * \brief Converts uniform buffers to dynamic uniform buffers
+     *
+     * Converts up to the given number of uniform buffer bindings,
+     * in binding order, so that identical lists always produce
+     * identical descriptor set layouts.
+     * \param [in] maxCount Maximum number of dynamic buffers
+     */
+    void makeUniformBuffersDynamic(uint32_t maxCount);
+
+    /**
+     * \brief Checks whether the list has inline uniform blocks
+     * \returns \c true if any binding is an inline uniform block
+     */
+    bool hasInlineUniformBlocks() const;
+
     /**
      * \brief Checks for equality
      *
@@ -142,6 +196,7 @@ namespace dxvk {
   private:
 
     std::vector<DxvkBindingInfo> m_bindings;
+    uint32_t                     m_writeCount = 0;
 
   };
 
@@ -154,6 +209,8 @@ namespace dxvk {
   struct DxvkBindingSetLayoutKeyEntry {
     VkDescriptorType    descriptorType;
     VkShaderStageFlags  stages;
+    uint32_t            count;  ///< Byte size for inline uniform blocks
+    Rc<DxvkSampler>     sampler;
   };
 
 
@@ -167,9 +224,17 @@ namespace dxvk {
 
   public:
 
-    DxvkBindingSetLayoutKey(const DxvkBindingList& list);
+    DxvkBindingSetLayoutKey(const DxvkBindingList& list, bool push = false);
     ~DxvkBindingSetLayoutKey();
 
+    /**
+     * \brief Checks whether this is a push descriptor set
+     * \returns \c true for push descriptor set layouts
+     */
+    bool isPushSet() const {
+      return m_push;
+    }
+
     /**
      * \brief Retrieves binding count
      * \returns Binding count
@@ -184,7 +249,7 @@ namespace dxvk {
      * \param [in] index Binding index
      * \returns Binding info
      */
-    DxvkBindingSetLayoutKeyEntry getBinding(uint32_t index) const {
+    const DxvkBindingSetLayoutKeyEntry& getBinding(uint32_t index) const {
       return m_bindings[index];
     }
 
@@ -205,6 +270,7 @@ namespace dxvk {
   private:
 
     std::vector<DxvkBindingSetLayoutKeyEntry> m_bindings;
+    bool                                      m_push = false;
 
   };
 
@@ -235,15 +301,30 @@ namespace dxvk {
 
     /**
      * \brief Queries descriptor template
-     * \returns Descriptor update template
+     *
+     * Push sets and sets containing inline uniform blocks
+     * do not have a template and must be written directly.
+     * \returns Descriptor update template, or \c VK_NULL_HANDLE
      */
     VkDescriptorUpdateTemplate getSetUpdateTemplate() const {
       return m_template;
     }
 
+    /**
+     * \brief Checks whether this is a push descriptor set
+     *
+     * Push descriptor sets cannot be allocated,
+     * and do not have an update template.
+     * \returns \c true for push descriptor set layouts
+     */
+    bool isPushSet() const {
+      return m_push;
+    }
+
   private:
 
     DxvkDevice*                   m_device;
+    bool                          m_push      = false;
     VkDescriptorSetLayout         m_layout    = VK_NULL_HANDLE;
     VkDescriptorUpdateTemplate    m_template  = VK_NULL_HANDLE;
 
@@ -274,6 +355,16 @@ namespace dxvk {
       return m_bindings[set].getBindingCount();
     }
 
+    /**
+     * \brief Number of bindings to write per set
+     *
+     * \param [in] set Descriptor set index
+     * \returns Number of bindings that need descriptor writes
+     */
+    uint32_t getDescriptorWriteCount(uint32_t set) const {
+      return m_bindings[set].getDescriptorWriteCount();
+    }
+
     /**
      * \brief Retrieves binding info
      *
@@ -327,6 +418,19 @@ namespace dxvk {
      */
     void merge(const DxvkBindingLayout& layout);
 
+    /**
+     * \brief Converts uniform buffers to dynamic uniform buffers
+     *
+     * Applied to each descriptor set individually. Dynamic
+     * uniform buffers only require a new dynamic offset when
+     * the underlying buffer slice changes, so that discarding
+     * a constant buffer does not require a descriptor update.
+     * \param [in] maxCountPerSet Maximum number of dynamic
+     *    uniform buffers in each descriptor set
+     * \param [in] setMask Descriptor sets to convert
+     */
+    void makeUniformBuffersDynamic(uint32_t maxCountPerSet, uint32_t setMask);
+
     /**
      * \brief Checks for equality
      *
@@ -402,6 +506,18 @@ namespace dxvk {
       return m_setMask;
     }
 
+    /**
+     * \brief Queries push descriptor set mask
+     *
+     * Sets in this mask must be written with push descriptors
+     * rather than allocated from a descriptor pool. At most
+     * one set per layout can use push descriptors.
+     * \returns Bit mask of push descriptor sets
+     */
+    uint32_t getPushSetMask() const {
+      return m_pushSetMask;
+    }
+
     /**
      * \brief Retrieves descriptor set layout for a given set
      *
@@ -424,10 +540,16 @@ namespace dxvk {
 
     /**
      * \brief Retrieves pipeline layout
+     *
+     * \param [in] independent Whether to return a pipeline
+     *    layout created with independent descriptor sets,
+     *    as required for graphics pipeline libraries.
      * \returns Pipeline layout
      */
-    VkPipelineLayout getPipelineLayout() const {
-      return m_pipelineLayout;
+    VkPipelineLayout getPipelineLayout(bool independent) const {
+      return independent
+        ? m_independentLayout
+        : m_completeLayout;
     }
 
     /**
@@ -459,9 +581,11 @@ namespace dxvk {
 
     DxvkDevice*         m_device;
     DxvkBindingLayout   m_layout;
-    VkPipelineLayout    m_pipelineLayout  = VK_NULL_HANDLE;
+    VkPipelineLayout    m_completeLayout    = VK_NULL_HANDLE;
+    VkPipelineLayout    m_independentLayout = VK_NULL_HANDLE;
 
     uint32_t            m_setMask         = 0;
+    uint32_t            m_pushSetMask     = 0;
 
     std::array<const DxvkBindingSetLayout*, DxvkDescriptorSets::SetCount> m_bindingObjects = { };
 
@@ -4,10 +4,142 @@
 
 namespace dxvk {
   
+  DxvkPipelineWorkers::DxvkPipelineWorkers(
+          DxvkDevice*                     device)
+  : m_device(device),
+    m_pool  ("dxvk-worker", getWorkerCount(device), ThreadPriority::Lowest,
+             device->config().workerThreadAffinity) {
+    Logger::info(str::format("DXVK: Using ", m_pool.threadCount(), " worker threads"));
+  }
+
+
+  DxvkPipelineWorkers::~DxvkPipelineWorkers() {
+    this->stopWorkers();
+  }
+
+
+  void DxvkPipelineWorkers::compilePipelineLibrary(
+          DxvkShaderPipelineLibrary*      library,
+          DxvkPipelinePriority            priority) {
+    this->enqueueTask([library] {
+      library->compilePipeline();
+    }, priority, 0);
+  }
+
+
+  void DxvkPipelineWorkers::compileGraphicsPipeline(
+          DxvkGraphicsPipeline*           pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+          DxvkPipelinePriority            priority) {
+    // Keep compiles for the same pipeline on the same worker
+    // if possible, since they contend on the pipeline's lock
+    uint32_t group = uint32_t(reinterpret_cast<uintptr_t>(pipeline) >> 6) + 1u;
+
+    this->enqueueTask([pipeline, state] {
+      pipeline->compilePipeline(state);
+    }, priority, group);
+  }
+
+
+  void DxvkPipelineWorkers::compileComputePipeline(
+          DxvkComputePipeline*            pipeline,
+    const DxvkComputePipelineStateInfo&   state,
+          DxvkPipelinePriority            priority) {
+    uint32_t group = uint32_t(reinterpret_cast<uintptr_t>(pipeline) >> 6) + 1u;
+
+    this->enqueueTask([pipeline, state] {
+      pipeline->compilePipeline(state);
+    }, priority, group);
+  }
+
+
+  void DxvkPipelineWorkers::compileTask(
+          std::function<void ()>&&        task,
+          DxvkPipelinePriority            priority) {
+    this->enqueueTask(std::move(task), priority, 0);
+  }
+
+
+  DxvkPipelineQueueStats DxvkPipelineWorkers::getQueueStats(
+          DxvkPipelinePriority            priority) const {
+    const QueueStats& stats = m_queueStats[uint32_t(priority)];
+
+    DxvkPipelineQueueStats result;
+    result.numPending = stats.pending.load();
+    result.latency    = stats.latency.load();
+    return result;
+  }
+
+
+  void DxvkPipelineWorkers::stopWorkers() {
+    m_stopped.store(true);
+    m_pool.stop();
+
+    // Workers have exited at this point, so all tasks that are
+    // still accounted for have been discarded and never will run
+    m_pendingTasks.store(0);
+
+    for (auto& stats : m_queueStats)
+      stats.pending.store(0);
+  }
+
+
+  void DxvkPipelineWorkers::enqueueTask(
+          std::function<void ()>&&        task,
+          DxvkPipelinePriority            priority,
+          uint32_t                        group) {
+    // The pool discards tasks once stopped, do not count them
+    if (m_stopped.load())
+      return;
+
+    m_pendingTasks += 1;
+    m_queueStats[uint32_t(priority)].pending += 1;
+
+    m_pool.submit([
+      this,
+      cTask     = std::move(task),
+      cPriority = priority,
+      cQueueTime = dxvk::high_resolution_clock::now()
+    ] {
+      cTask();
+
+      // Track time from submission to completion
+      // as an exponential moving average
+      auto t1 = dxvk::high_resolution_clock::now();
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - cQueueTime);
+
+      QueueStats& stats = m_queueStats[uint32_t(cPriority)];
+      stats.latency.store((stats.latency.load() * 7 + uint64_t(us.count())) / 8);
+      stats.pending -= 1;
+
+      m_pendingTasks -= 1;
+    }, ThreadPoolPriority(uint32_t(priority)), group);
+  }
+
+
+  uint32_t DxvkPipelineWorkers::getWorkerCount(
+          DxvkDevice*                     device) {
+    if (device->config().numCompilerThreads > 0)
+      return device->config().numCompilerThreads;
+
+    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
+    uint32_t numWorkers  = ((std::max(1u, numCpuCores) - 1) * 5) / 7;
+
+    if (numWorkers <  1) numWorkers =  1;
+    if (numWorkers > 32) numWorkers = 32;
+
+    return numWorkers;
+  }
+
+
   DxvkPipelineManager::DxvkPipelineManager(
           DxvkDevice*         device)
   : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+    m_cache     (new DxvkPipelineCache(device)),
+    m_workers   (device) {
+    sync::setLockName(m_mutex,        "DxvkPipelineManager");
+    sync::setLockName(m_libraryMutex, "DxvkPipelineManager::library");
+
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
     
     if (useStateCache != "0" && device->config().enableStateCache)
@@ -16,7 +148,17 @@ namespace dxvk {
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
-    
+    auto stalls = this->getWorstStalls(10);
+
+    if (!stalls.empty()) {
+      Logger::info("DXVK: Pipelines with the longest blocking compile times:");
+
+      for (const auto& stall : stalls) {
+        Logger::info(str::format("  ", stall.numStalls, " stalls, ",
+          stall.totalTime / 1000, " ms total, ", stall.maxTime / 1000,
+          " ms max: ", stall.shaders));
+      }
+    }
   }
   
   
@@ -69,16 +211,59 @@ namespace dxvk {
 
     auto layout = createPipelineLayout(mergedLayout);
 
+    // Only pipelines that consist of a vertex shader and
+    // an optional fragment shader can be linked from
+    // pipeline libraries. All fragment shader inputs
+    // must be written by the vertex shader.
+    DxvkShaderPipelineLibrary* vsLibrary = nullptr;
+    DxvkShaderPipelineLibrary* fsLibrary = nullptr;
+
+    if (shaders.tcs == nullptr && shaders.tes == nullptr && shaders.gs == nullptr
+     && !mergedLayout.getPushConstantRange().size) {
+      vsLibrary = findPipelineLibrary(shaders.vs);
+      fsLibrary = shaders.fs != nullptr
+        ? findPipelineLibrary(shaders.fs)
+        : createNullFsPipelineLibrary();
+
+      if (shaders.fs != nullptr && (shaders.fs->info().inputMask & ~shaders.vs->info().outputMask)) {
+        vsLibrary = nullptr;
+        fsLibrary = nullptr;
+      }
+    }
+
     auto iter = m_graphicsPipelines.emplace(
       std::piecewise_construct,
       std::tuple(shaders),
-      std::tuple(this, shaders, layout));
+      std::tuple(this, shaders, layout, vsLibrary, fsLibrary));
     return &iter.first->second;
   }
 
   
   void DxvkPipelineManager::registerShader(
     const Rc<DxvkShader>&         shader) {
+    if (m_device->canUseGraphicsPipelineLibrary() && shader->canUsePipelineLibrary()) {
+      DxvkShaderPipelineLibrary* library = nullptr;
+
+      { std::lock_guard<dxvk::mutex> lock(m_mutex);
+        library = createPipelineLibrary(shader);
+      }
+
+      m_workers.compilePipelineLibrary(library, DxvkPipelinePriority::Low);
+    }
+
+    // Compute pipeline state only consists of spec constants, which
+    // are rarely used, so the default state is almost certainly the
+    // one that the first dispatch needs. Compile it right away so
+    // that the CS thread does not have to.
+    if (shader->info().stage == VK_SHADER_STAGE_COMPUTE_BIT) {
+      DxvkComputePipelineShaders shaders;
+      shaders.cs = shader;
+
+      DxvkComputePipeline* pipeline = createComputePipeline(shaders);
+      m_workers.compileComputePipeline(pipeline,
+        DxvkComputePipelineStateInfo(), DxvkPipelinePriority::Normal);
+    }
+
     if (m_stateCache != nullptr)
       m_stateCache->registerShader(shader);
   }
@@ -88,22 +273,108 @@ namespace dxvk {
     DxvkPipelineCount result;
     result.numComputePipelines  = m_numComputePipelines.load();
     result.numGraphicsPipelines = m_numGraphicsPipelines.load();
+    result.numPendingPipelines  = m_workers.getPendingTaskCount();
+
+    for (uint32_t i = 0; i < DxvkPipelinePriorityCount; i++)
+      result.queues[i] = m_workers.getQueueStats(DxvkPipelinePriority(i));
+
+    // State cache entries are speculative, so count
+    // them towards the low priority queue
+    if (m_stateCache != nullptr)
+      result.queues[uint32_t(DxvkPipelinePriority::Low)].numPending += m_stateCache->getPendingCount();
+
+    for (uint32_t i = 0; i < DxvkPipelineCompileTypeCount; i++) {
+      result.compiles[i].numCompiles = m_compileStats[i].numCompiles.load();
+      result.compiles[i].totalTime   = m_compileStats[i].totalTime.load();
+
+      for (uint32_t j = 0; j < DxvkPipelineHistogramSize; j++)
+        result.compiles[i].histogram[j] = m_compileStats[i].histogram[j].load();
+    }
+
+    return result;
+  }
+
+
+  std::vector<DxvkPipelineStallInfo> DxvkPipelineManager::getWorstStalls(
+          uint32_t            count) const {
+    std::vector<std::pair<const DxvkGraphicsPipeline*, StallEntry>> entries;
+
+    { std::lock_guard<dxvk::mutex> lock(m_stallMutex);
+      entries.assign(m_stalls.begin(), m_stalls.end());
+    }
+
+    std::sort(entries.begin(), entries.end(), [] (const auto& a, const auto& b) {
+      return a.second.totalTime > b.second.totalTime;
+    });
+
+    if (entries.size() > count)
+      entries.resize(count);
+
+    std::vector<DxvkPipelineStallInfo> result;
+
+    for (const auto& entry : entries) {
+      const DxvkGraphicsPipelineShaders& shaders = entry.first->shaders();
+
+      std::string names;
+
+      for (const auto& shader : { shaders.vs, shaders.tcs, shaders.tes, shaders.gs, shaders.fs }) {
+        if (shader != nullptr)
+          names += (names.empty() ? "" : ", ") + shader->debugName();
+      }
+
+      DxvkPipelineStallInfo& info = result.emplace_back();
+      info.shaders   = std::move(names);
+      info.numStalls = entry.second.numStalls;
+      info.totalTime = entry.second.totalTime;
+      info.maxTime   = entry.second.maxTime;
+    }
+
     return result;
   }
 
 
   bool DxvkPipelineManager::isCompilingShaders() const {
+    if (m_workers.isBusy())
+      return true;
+
     return m_stateCache != nullptr
         && m_stateCache->isCompilingShaders();
   }
 
 
-  void DxvkPipelineManager::stopWorkerThreads() const {
+  void DxvkPipelineManager::stopWorkerThreads() {
+    m_workers.stopWorkers();
+
     if (m_stateCache != nullptr)
       m_stateCache->stopWorkerThreads();
   }
 
 
+  void DxvkPipelineManager::recordCompile(
+    const DxvkGraphicsPipeline*   pipeline,
+          DxvkPipelineCompileType type,
+          uint64_t                time) {
+    uint32_t bucket = 0;
+
+    while (bucket + 1 < DxvkPipelineHistogramSize && time >= (1000ull << (2 * bucket)))
+      bucket += 1;
+
+    CompileStats& stats = m_compileStats[uint32_t(type)];
+    stats.numCompiles += 1;
+    stats.totalTime += time;
+    stats.histogram[bucket] += 1;
+
+    if (type == DxvkPipelineCompileType::Blocking) {
+      std::lock_guard<dxvk::mutex> lock(m_stallMutex);
+
+      StallEntry& entry = m_stalls[pipeline];
+      entry.numStalls += 1;
+      entry.totalTime += time;
+      entry.maxTime = std::max(entry.maxTime, time);
+    }
+  }
+
+
   DxvkBindingSetLayout* DxvkPipelineManager::createDescriptorSetLayout(
     const DxvkBindingSetLayoutKey& key) {
     auto pair = m_descriptorSetLayouts.find(key);
@@ -124,15 +395,136 @@ namespace dxvk {
     if (pair != m_pipelineLayouts.end())
       return &pair->second;
 
+    // Bind uniform buffers as dynamic buffers where possible so that
+    // discarding a buffer only changes the dynamic offset. Uniform
+    // buffers can be used in two sets per pipeline, so split the
+    // device limit evenly between them.
+    uint32_t maxDynamicBuffers = m_device->properties().core.properties.limits.maxDescriptorSetUniformBuffersDynamic;
+    uint32_t maxDynamicBuffersPerSet = std::min<uint32_t>(maxDynamicBuffers / 2, MaxNumUniformBuffersDynamic);
+
+    // Push descriptor sets cannot contain dynamic buffers, but since
+    // they are written on every bind anyway, they don't need them.
+    uint32_t pushSetMask = getPushSetMask(layout);
+
+    DxvkBindingLayout dynamicLayout = layout;
+    dynamicLayout.makeUniformBuffersDynamic(maxDynamicBuffersPerSet, ~pushSetMask);
+
     std::array<const DxvkBindingSetLayout*, DxvkDescriptorSets::SetCount> setLayouts = { };
 
-    for (uint32_t i = 0; i < setLayouts.size(); i++)
-      setLayouts[i] = createDescriptorSetLayout(layout.getBindingList(i));
+    for (uint32_t i = 0; i < setLayouts.size(); i++) {
+      setLayouts[i] = createDescriptorSetLayout(DxvkBindingSetLayoutKey(
+        dynamicLayout.getBindingList(i), (pushSetMask >> i) & 1));
+    }
 
     auto iter = m_pipelineLayouts.emplace(
       std::piecewise_construct,
       std::tuple(layout),
-      std::tuple(m_device, layout, setLayouts.data()));
+      std::tuple(m_device, dynamicLayout, setLayouts.data()));
+    return &iter.first->second;
+  }
+  
+
+
+  uint32_t DxvkPipelineManager::getPushSetMask(
+    const DxvkBindingLayout& layout) const {
+    if (!m_device->extensions().khrPushDescriptor)
+      return 0;
+
+    // Only one set per layout can use push descriptors. For graphics
+    // pipelines, always use the vertex shader set so that the layouts
+    // of pipeline libraries remain compatible with linked pipelines.
+    // Compute shaders only use the fragment shader sets, and their
+    // buffer set typically only contains a few constant buffers.
+    uint32_t set = DxvkDescriptorSets::VsAll;
+
+    if (!layout.getBindingCount(set)) {
+      set = DxvkDescriptorSets::FsBuffers;
+
+      if (!layout.getBindingCount(set)
+       || !(layout.getBinding(set, 0).stages & VK_SHADER_STAGE_COMPUTE_BIT))
+        return 0;
+    }
+
+    // Inline uniform blocks cannot be used with push descriptors
+    if (layout.getBindingList(set).hasInlineUniformBlocks())
+      return 0;
+
+    uint32_t maxCount = std::min<uint32_t>(MaxNumPushDescriptors,
+      m_device->properties().khrPushDescriptor.maxPushDescriptors);
+
+    return layout.getBindingCount(set) <= maxCount
+      ? 1u << set
+      : 0u;
+  }
+
+
+  DxvkShaderPipelineLibrary* DxvkPipelineManager::createPipelineLibrary(
+    const Rc<DxvkShader>&     shader) {
+    auto pair = m_shaderLibraries.find(shader.ptr());
+    if (pair != m_shaderLibraries.end())
+      return &pair->second;
+
+    auto layout = createPipelineLayout(shader->getBindings());
+
+    auto iter = m_shaderLibraries.emplace(
+      std::piecewise_construct,
+      std::tuple(shader.ptr()),
+      std::tuple(m_device, m_cache.ptr(), shader, layout));
+    return &iter.first->second;
+  }
+
+
+  DxvkShaderPipelineLibrary* DxvkPipelineManager::findPipelineLibrary(
+    const Rc<DxvkShader>&     shader) {
+    auto pair = m_shaderLibraries.find(shader.ptr());
+    if (pair == m_shaderLibraries.end())
+      return nullptr;
+
+    return &pair->second;
+  }
+
+
+  DxvkShaderPipelineLibrary* DxvkPipelineManager::createNullFsPipelineLibrary() {
+    if (!m_device->canUseGraphicsPipelineLibrary())
+      return nullptr;
+
+    if (!m_nullFsLibrary) {
+      auto layout = createPipelineLayout(DxvkBindingLayout());
+      m_nullFsLibrary.emplace(m_device, m_cache.ptr(), nullptr, layout);
+    }
+
+    return &(*m_nullFsLibrary);
+  }
+
+
+  DxvkGraphicsPipelineVertexInputLibrary* DxvkPipelineManager::createVertexInputLibrary(
+    const DxvkGraphicsPipelineVertexInputKey& key) {
+    std::lock_guard<dxvk::mutex> lock(m_libraryMutex);
+
+    auto pair = m_vertexInputLibraries.find(key);
+    if (pair != m_vertexInputLibraries.end())
+      return &pair->second;
+
+    auto iter = m_vertexInputLibraries.emplace(
+      std::piecewise_construct,
+      std::tuple(key),
+      std::tuple(m_device, m_cache->handle(), key));
+    return &iter.first->second;
+  }
+
+
+  DxvkGraphicsPipelineFragmentOutputLibrary* DxvkPipelineManager::createFragmentOutputLibrary(
+    const DxvkGraphicsPipelineFragmentOutputKey& key) {
+    std::lock_guard<dxvk::mutex> lock(m_libraryMutex);
+
+    auto pair = m_fragmentOutputLibraries.find(key);
+    if (pair != m_fragmentOutputLibraries.end())
+      return &pair->second;
+
+    auto iter = m_fragmentOutputLibraries.emplace(
+      std::piecewise_construct,
+      std::tuple(key),
+      std::tuple(m_device, m_cache->handle(), key));
     return &iter.first->second;
   }
   
@@ -1,15 +1,87 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 #include "dxvk_compute.h"
 #include "dxvk_graphics.h"
 
+#include "../util/thread_pool.h"
+
 namespace dxvk {
 
   class DxvkStateCache;
+  class DxvkPipelineManager;
+
+  /**
+   * \brief Pipeline compile priority
+   *
+   * Background compile jobs are processed in order of
+   * priority. Jobs of the same priority are processed
+   * roughly in the order in which they were submitted.
+   * Values match the corresponding thread pool priorities.
+   */
+  enum class DxvkPipelinePriority : uint32_t {
+    High    = uint32_t(ThreadPoolPriority::High),   ///< Draws are skipped until the pipeline is ready
+    Normal  = uint32_t(ThreadPoolPriority::Normal), ///< Optimizes a pipeline that is already in use
+    Low     = uint32_t(ThreadPoolPriority::Low),    ///< Speculative work that may be needed later
+  };
+
+  constexpr uint32_t DxvkPipelinePriorityCount = 3;
+
+  /**
+   * \brief Pipeline queue stats
+   */
+  struct DxvkPipelineQueueStats {
+    uint64_t numPending;
+    uint64_t latency;
+  };
+
+  /**
+   * \brief Pipeline compile type
+   *
+   * Blocking compiles happen on the thread that records
+   * the draw, which has to wait for the pipeline. Background
+   * compiles are done by the pipeline worker threads.
+   */
+  enum class DxvkPipelineCompileType : uint32_t {
+    Blocking    = 0,
+    Background  = 1,
+  };
+
+  constexpr uint32_t DxvkPipelineCompileTypeCount = 2;
+
+  /// Number of compile time histogram buckets. Bucket
+  /// \c i counts compiles that took less than 4^i ms,
+  /// the last bucket counts all slower compiles.
+  constexpr uint32_t DxvkPipelineHistogramSize = 6;
+
+  /**
+   * \brief Pipeline compile stats
+   */
+  struct DxvkPipelineCompileStats {
+    uint64_t numCompiles;
+    uint64_t totalTime;
+    std::array<uint64_t, DxvkPipelineHistogramSize> histogram;
+  };
+
+  /**
+   * \brief Blocking pipeline compile info
+   *
+   * Accumulated blocking compile time for a single
+   * set of shaders, used to find pipelines that are
+   * worth adding to a state cache ahead of time.
+   */
+  struct DxvkPipelineStallInfo {
+    std::string shaders;
+    uint64_t    numStalls;
+    uint64_t    totalTime;
+    uint64_t    maxTime;
+  };
 
   /**
    * \brief Pipeline count
@@ -20,9 +92,169 @@ namespace dxvk {
   struct DxvkPipelineCount {
     uint32_t numGraphicsPipelines;
     uint32_t numComputePipelines;
+    uint32_t numPendingPipelines;
+    std::array<DxvkPipelineQueueStats, DxvkPipelinePriorityCount> queues;
+    std::array<DxvkPipelineCompileStats, DxvkPipelineCompileTypeCount> compiles;
   };
   
   
+  /**
+   * \brief Pipeline compiler worker threads
+   *
+   * Compiles shader pipeline libraries and optimized
+   * graphics pipelines in the background. Owns the
+   * device's worker thread pool, which other background
+   * work such as shader translation and state cache
+   * loading runs on as well, so that these subsystems do
+   * not compete with each other for CPU cores.
+   */
+  class DxvkPipelineWorkers {
+
+  public:
+
+    DxvkPipelineWorkers(
+            DxvkDevice*                     device);
+
+    ~DxvkPipelineWorkers();
+
+    /**
+     * \brief Compiles a pipeline library
+     *
+     * Asynchronously compiles a shader pipeline library
+     * so that it is ready to use once a graphics pipeline
+     * using the shader gets linked.
+     * \param [in] library The pipeline library to compile
+     */
+    void compilePipelineLibrary(
+            DxvkShaderPipelineLibrary*      library,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Compiles an optimized graphics pipeline
+     *
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] state The pipeline state vector
+     * \param [in] priority Compile priority
+     */
+    void compileGraphicsPipeline(
+            DxvkGraphicsPipeline*           pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Compiles a compute pipeline
+     *
+     * \param [in] pipeline The compute pipeline
+     * \param [in] state The pipeline state vector
+     * \param [in] priority Compile priority
+     */
+    void compileComputePipeline(
+            DxvkComputePipeline*            pipeline,
+      const DxvkComputePipelineStateInfo&   state,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Runs a generic compile task
+     *
+     * Used for pipelines that are not managed by the
+     * pipeline manager itself, e.g. meta pipelines.
+     * \param [in] task Function to execute
+     * \param [in] priority Compile priority
+     */
+    void compileTask(
+            std::function<void ()>&&        task,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Notifies workers of a blocking compile
+     *
+     * Must be called when a thread that the application
+     * is waiting on, such as the CS thread, has to compile
+     * a pipeline itself. Until the matching call to
+     * \c endBlockingCompile, workers only start high
+     * priority tasks so that the blocked thread gets as
+     * much CPU time as possible. This applies to all
+     * tasks that run on the worker thread pool.
+     */
+    void beginBlockingCompile() {
+      m_pool.suspendBackgroundTasks();
+    }
+
+    /**
+     * \brief Ends a blocking compile
+     */
+    void endBlockingCompile() {
+      m_pool.resumeBackgroundTasks();
+    }
+
+    /**
+     * \brief Retrieves worker thread pool
+     * \returns Thread pool
+     */
+    ThreadPool& getThreadPool() {
+      return m_pool;
+    }
+
+    /**
+     * \brief Queries queue statistics
+     *
+     * \param [in] priority Compile priority
+     * \returns Pending job count and average
+     *    latency, in microseconds
+     */
+    DxvkPipelineQueueStats getQueueStats(
+            DxvkPipelinePriority            priority) const;
+
+    /**
+     * \brief Checks whether workers are busy
+     * \returns \c true if there is unfinished work
+     */
+    bool isBusy() const {
+      return m_pendingTasks.load() != 0ull;
+    }
+
+    /**
+     * \brief Queries number of pending tasks
+     * \returns Number of queued or running jobs
+     */
+    uint64_t getPendingTaskCount() const {
+      return m_pendingTasks.load();
+    }
+
+    /**
+     * \brief Stops all worker threads
+     *
+     * Stops threads and waits for their current work
+     * to complete. Queued work will be discarded.
+     */
+    void stopWorkers();
+
+  private:
+
+    struct QueueStats {
+      std::atomic<uint64_t>         pending = { 0ull };
+      std::atomic<uint64_t>         latency = { 0ull };
+    };
+
+    DxvkDevice*                     m_device;
+
+    std::atomic<uint64_t>           m_pendingTasks = { 0ull };
+    std::atomic<bool>               m_stopped      = { false };
+    std::array<QueueStats, DxvkPipelinePriorityCount> m_queueStats;
+
+    ThreadPool                      m_pool;
+
+    void enqueueTask(
+            std::function<void ()>&&        task,
+            DxvkPipelinePriority            priority,
+            uint32_t                        group);
+
+    static uint32_t getWorkerCount(
+            DxvkDevice*                     device);
+
+  };
+
+
   /**
    * \brief Pipeline manager
    * 
@@ -35,6 +267,7 @@ namespace dxvk {
   class DxvkPipelineManager {
     friend class DxvkComputePipeline;
     friend class DxvkGraphicsPipeline;
+    friend class DxvkPipelineWorkers;
   public:
     
     DxvkPipelineManager(
@@ -71,18 +304,66 @@ namespace dxvk {
      * 
      * Starts compiling pipelines asynchronously
      * in case the state cache contains state
-     * vectors for this shader.
+     * vectors for this shader. For compute shaders,
+     * the default pipeline is compiled as well.
      * \param [in] shader Newly compiled shader
      */
     void registerShader(
       const Rc<DxvkShader>&         shader);
     
+    /**
+     * \brief Compiles pipelines in the background
+     *
+     * Runs the given task on a pipeline worker thread
+     * with low priority, so that it does not delay any
+     * pipelines that the application is waiting for.
+     * \param [in] task Function to execute
+     */
+    void compileTask(
+            std::function<void ()>&&  task) {
+      m_workers.compileTask(std::move(task), DxvkPipelinePriority::Low);
+    }
+
+    /**
+     * \brief Runs a shader translation task
+     *
+     * Runs the given task on a pipeline worker thread
+     * with normal priority, since the application is
+     * likely going to use the shader soon.
+     * \param [in] task Function to execute
+     */
+    void runShaderTask(
+            std::function<void ()>&&  task) {
+      m_workers.compileTask(std::move(task), DxvkPipelinePriority::Normal);
+    }
+
+    /**
+     * \brief Retrieves persistent pipeline cache
+     *
+     * Can be used to create pipelines that are not
+     * managed by the pipeline manager itself.
+     * \returns Pipeline cache
+     */
+    const DxvkPipelineCache* getPipelineCache() const {
+      return m_cache.ptr();
+    }
+
     /**
      * \brief Retrieves total pipeline count
      * \returns Number of compute/graphics pipelines
      */
     DxvkPipelineCount getPipelineCount() const;
 
+    /**
+     * \brief Retrieves pipelines with the longest stalls
+     *
+     * \param [in] count Maximum number of entries
+     * \returns Shader sets that spent the most time in
+     *    blocking compiles, sorted by total time
+     */
+    std::vector<DxvkPipelineStallInfo> getWorstStalls(
+            uint32_t            count) const;
+
     /**
      * \brief Checks whether async compiler is busy
      * \returns \c true if shaders are being compiled
@@ -92,13 +373,22 @@ namespace dxvk {
     /**
      * \brief Stops async compiler threads
      */
-    void stopWorkerThreads() const;
+    void stopWorkerThreads();
+
+    /**
+     * \brief Retrieves worker thread pool
+     * \see DxvkPipelineWorkers::getThreadPool
+     */
+    ThreadPool& getThreadPool() {
+      return m_workers.getThreadPool();
+    }
     
   private:
     
     DxvkDevice*               m_device;
     Rc<DxvkPipelineCache>     m_cache;
     Rc<DxvkStateCache>        m_stateCache;
+    DxvkPipelineWorkers       m_workers;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
     std::atomic<uint32_t>     m_numGraphicsPipelines = { 0 };
@@ -125,12 +415,72 @@ namespace dxvk {
       DxvkGraphicsPipeline,
       DxvkHash, DxvkEq> m_graphicsPipelines;
 
+    std::unordered_map<
+      const DxvkShader*,
+      DxvkShaderPipelineLibrary> m_shaderLibraries;
+
+    std::optional<DxvkShaderPipelineLibrary> m_nullFsLibrary;
+
+    dxvk::mutex m_libraryMutex;
+
+    std::unordered_map<
+      DxvkGraphicsPipelineVertexInputKey,
+      DxvkGraphicsPipelineVertexInputLibrary,
+      DxvkHash, DxvkEq> m_vertexInputLibraries;
+
+    std::unordered_map<
+      DxvkGraphicsPipelineFragmentOutputKey,
+      DxvkGraphicsPipelineFragmentOutputLibrary,
+      DxvkHash, DxvkEq> m_fragmentOutputLibraries;
+
+    struct CompileStats {
+      std::atomic<uint64_t> numCompiles = { 0ull };
+      std::atomic<uint64_t> totalTime   = { 0ull };
+      std::array<std::atomic<uint64_t>, DxvkPipelineHistogramSize> histogram = { };
+    };
+
+    struct StallEntry {
+      uint64_t numStalls = 0;
+      uint64_t totalTime = 0;
+      uint64_t maxTime   = 0;
+    };
+
+    std::array<CompileStats, DxvkPipelineCompileTypeCount> m_compileStats;
+
+    mutable dxvk::mutex m_stallMutex;
+
+    std::unordered_map<
+      const DxvkGraphicsPipeline*,
+      StallEntry> m_stalls;
+
+    void recordCompile(
+      const DxvkGraphicsPipeline*   pipeline,
+            DxvkPipelineCompileType type,
+            uint64_t                time);
+
     DxvkBindingSetLayout* createDescriptorSetLayout(
       const DxvkBindingSetLayoutKey& key);
 
     DxvkBindingLayoutObjects* createPipelineLayout(
       const DxvkBindingLayout& layout);
 
+    uint32_t getPushSetMask(
+      const DxvkBindingLayout& layout) const;
+
+    DxvkShaderPipelineLibrary* createPipelineLibrary(
+      const Rc<DxvkShader>& shader);
+
+    DxvkShaderPipelineLibrary* findPipelineLibrary(
+      const Rc<DxvkShader>& shader);
+
+    DxvkShaderPipelineLibrary* createNullFsPipelineLibrary();
+
+    DxvkGraphicsPipelineVertexInputLibrary* createVertexInputLibrary(
+      const DxvkGraphicsPipelineVertexInputKey& key);
+
+    DxvkGraphicsPipelineFragmentOutputLibrary* createFragmentOutputLibrary(
+      const DxvkGraphicsPipelineFragmentOutputKey& key);
+
   };
   
 }
\ No newline at end of file
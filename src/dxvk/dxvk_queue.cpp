@@ -5,9 +5,10 @@ namespace dxvk {
   
   DxvkSubmissionQueue::DxvkSubmissionQueue(DxvkDevice* device)
   : m_device(device),
+    m_timeline(createTimelineSemaphore()),
     m_submitThread([this] () { submitCmdLists(); }),
     m_finishThread([this] () { finishCmdLists(); }) {
-
+    m_submitThread.set_affinity(device->config().submitThreadAffinity);
   }
   
   
@@ -21,10 +22,15 @@ namespace dxvk {
 
     m_submitThread.join();
     m_finishThread.join();
+
+    if (m_timeline) {
+      auto vk = m_device->vkd();
+      vk->vkDestroySemaphore(vk->device(), m_timeline, nullptr);
+    }
   }
   
   
-  void DxvkSubmissionQueue::submit(DxvkSubmitInfo submitInfo) {
+  uint64_t DxvkSubmissionQueue::submit(DxvkSubmitInfo submitInfo) {
     std::unique_lock<dxvk::mutex> lock(m_mutex);
 
     m_finishCond.wait(lock, [this] {
@@ -33,21 +39,28 @@ namespace dxvk {
 
     DxvkSubmitEntry entry = { };
     entry.submit = std::move(submitInfo);
+    entry.submissionId = ++m_submittedId;
 
     m_pending += 1;
-    m_submitQueue.push(std::move(entry));
+    m_submitQueue.push_back(std::move(entry));
     m_appendCond.notify_all();
+    return m_submittedId;
   }
 
 
   void DxvkSubmissionQueue::present(DxvkPresentInfo presentInfo, DxvkSubmitStatus* status) {
     std::unique_lock<dxvk::mutex> lock(m_mutex);
 
+    // The frame is done on the GPU once the last command
+    // list submitted before the present call has completed
+    m_device->getLatencyTracker().setSubmission(presentInfo.frameId,
+      m_submittedId, m_completedId.load());
+
     DxvkSubmitEntry entry = { };
     entry.status  = status;
     entry.present = std::move(presentInfo);
 
-    m_submitQueue.push(std::move(entry));
+    m_submitQueue.push_back(std::move(entry));
     m_appendCond.notify_all();
   }
 
@@ -94,7 +107,53 @@ namespace dxvk {
       if (m_stopped.load())
         return;
       
-      DxvkSubmitEntry entry = std::move(m_submitQueue.front());
+      // Gather consecutive command lists that can be submitted
+      // in one single call, which is cheaper than submitting
+      // each command list on its own in most drivers
+      std::array<DxvkSubmitEntry, MaxSubmitBatchSize> batch;
+      uint32_t batchSize = 0;
+
+      while (batchSize < m_submitQueue.size()
+          && batchSize < MaxSubmitBatchSize
+          && canBatchSubmission(m_submitQueue[batchSize])) {
+        batch[batchSize] = std::move(m_submitQueue[batchSize]);
+        batchSize += 1;
+      }
+
+      if (batchSize > 1) {
+        lock.unlock();
+
+        VkResult status = VK_ERROR_DEVICE_LOST;
+
+        if (m_lastError != VK_ERROR_DEVICE_LOST) {
+          std::lock_guard<dxvk::mutex> lock(m_mutexQueue);
+          DXVK_TRACE_SCOPE("DxvkSubmissionQueue::submit");
+          status = submitBatch(batchSize, batch.data());
+        }
+
+        m_device->addStatCtr(DxvkStatCounter::QueueSubmitBatched, batchSize);
+
+        lock = std::unique_lock<dxvk::mutex>(m_mutex);
+
+        if (status == VK_SUCCESS) {
+          for (uint32_t i = 0; i < batchSize; i++)
+            m_finishQueue.push(std::move(batch[i]));
+        } else {
+          Logger::err(str::format("DxvkSubmissionQueue: Command submission failed: ", status));
+          m_lastError = status;
+          m_device->waitForIdle();
+        }
+
+        for (uint32_t i = 0; i < batchSize; i++)
+          m_submitQueue.pop_front();
+
+        m_submitCond.notify_all();
+        continue;
+      }
+
+      DxvkSubmitEntry entry = batchSize
+        ? std::move(batch[0])
+        : std::move(m_submitQueue.front());
       lock.unlock();
 
       // Submit command buffer to device
@@ -102,13 +161,21 @@ namespace dxvk {
 
       if (m_lastError != VK_ERROR_DEVICE_LOST) {
         std::lock_guard<dxvk::mutex> lock(m_mutexQueue);
+        DXVK_TRACE_SCOPE("DxvkSubmissionQueue::submit");
 
         if (entry.submit.cmdList != nullptr) {
           status = entry.submit.cmdList->submit(
             entry.submit.waitSync,
-            entry.submit.wakeSync);
+            entry.submit.wakeSync,
+            m_timeline, entry.submissionId);
         } else if (entry.present.presenter != nullptr) {
-          status = entry.present.presenter->presentImage();
+          DxvkLatencyTracker& latency = m_device->getLatencyTracker();
+          latency.notifyStage(entry.present.frameId, DxvkLatencyStage::QueueSubmit);
+
+          status = entry.present.presenter->presentImage(
+            entry.present.displayFrameId, entry.present.regions);
+
+          latency.notifyStage(entry.present.frameId, DxvkLatencyStage::QueuePresent);
         }
       } else {
         // Don't submit anything after device loss
@@ -131,7 +198,7 @@ namespace dxvk {
         m_device->waitForIdle();
       }
 
-      m_submitQueue.pop();
+      m_submitQueue.pop_front();
       m_submitCond.notify_all();
     }
   }
@@ -162,8 +229,10 @@ namespace dxvk {
       
       VkResult status = m_lastError.load();
       
-      if (status != VK_ERROR_DEVICE_LOST)
-        status = entry.submit.cmdList->synchronize();
+      if (status != VK_ERROR_DEVICE_LOST) {
+        DXVK_TRACE_SCOPE("DxvkSubmissionQueue::wait");
+        status = waitForSubmission(entry);
+      }
       
       if (status != VK_SUCCESS) {
         Logger::err(str::format("DxvkSubmissionQueue: Failed to sync fence: ", status));
@@ -171,10 +240,18 @@ namespace dxvk {
         m_device->waitForIdle();
       }
 
+      // Submissions complete in order, so this is monotonic
+      if (m_completedId.load() < entry.submissionId)
+        m_completedId.store(entry.submissionId);
+
+      m_device->getLatencyTracker().notifySubmissionComplete(m_completedId.load());
+
       // Release resources and signal events, then immediately wake
       // up any thread that's currently waiting on a resource in
       // order to reduce delays as much as possible.
-      entry.submit.cmdList->notifyObjects();
+      { DXVK_TRACE_SCOPE("DxvkSubmissionQueue::finish");
+        entry.submit.cmdList->notifyObjects();
+      }
 
       lock.lock();
       m_pending -= 1;
@@ -188,5 +265,114 @@ namespace dxvk {
       m_device->recycleCommandList(entry.submit.cmdList);
     }
   }
-  
-}
\ No newline at end of file
+
+
+  bool DxvkSubmissionQueue::canBatchSubmission(
+    const DxvkSubmitEntry& entry) const {
+    // Without timeline semaphores, each command
+    // list needs to signal its own fence
+    return m_timeline
+        && entry.submit.cmdList != nullptr
+        && entry.submit.cmdList->canBatchSubmission();
+  }
+
+
+  VkResult DxvkSubmissionQueue::submitBatch(
+          uint32_t            entryCount,
+    const DxvkSubmitEntry*    entries) {
+    std::array<DxvkQueueSubmission,              MaxSubmitBatchSize> infos;
+    std::array<VkTimelineSemaphoreSubmitInfoKHR, MaxSubmitBatchSize> timelineInfos;
+    std::array<VkSubmitInfo,                     MaxSubmitBatchSize> submitInfos;
+
+    for (uint32_t i = 0; i < entryCount; i++) {
+      const DxvkSubmitEntry& entry = entries[i];
+
+      infos[i] = entry.submit.cmdList->getBatchSubmission(
+        entry.submit.waitSync, entry.submit.wakeSync,
+        m_timeline, entry.submissionId);
+
+      // Each submission signals the timeline semaphore, so
+      // signal values must be provided for all semaphores
+      timelineInfos[i] = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+      timelineInfos[i].signalSemaphoreValueCount = infos[i].wakeCount;
+      timelineInfos[i].pSignalSemaphoreValues    = infos[i].wakeValue;
+
+      submitInfos[i] = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+      submitInfos[i].pNext                = &timelineInfos[i];
+      submitInfos[i].waitSemaphoreCount   = infos[i].waitCount;
+      submitInfos[i].pWaitSemaphores      = infos[i].waitSync;
+      submitInfos[i].pWaitDstStageMask    = infos[i].waitMask;
+      submitInfos[i].commandBufferCount   = infos[i].cmdBufferCount;
+      submitInfos[i].pCommandBuffers      = infos[i].cmdBuffers;
+      submitInfos[i].signalSemaphoreCount = infos[i].wakeCount;
+      submitInfos[i].pSignalSemaphores    = infos[i].wakeSync;
+    }
+
+    auto vk = m_device->vkd();
+
+    return vk->vkQueueSubmit(m_device->queues().graphics.queueHandle,
+      entryCount, submitInfos.data(), VK_NULL_HANDLE);
+  }
+
+
+  VkResult DxvkSubmissionQueue::waitForSubmission(
+    const DxvkSubmitEntry& entry) {
+    if (!m_timeline)
+      return entry.submit.cmdList->synchronize();
+
+    // A previous wait may have already observed a counter value
+    // that covers this submission, in which case we can skip the
+    // wait entirely and retire multiple command lists at once.
+    if (m_completedId.load() >= entry.submissionId)
+      return VK_SUCCESS;
+
+    auto vk = m_device->vkd();
+
+    VkSemaphoreWaitInfoKHR waitInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR };
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_timeline;
+    waitInfo.pValues = &entry.submissionId;
+
+    VkResult status = VK_TIMEOUT;
+
+    while (status == VK_TIMEOUT) {
+      status = vk->vkWaitSemaphoresKHR(
+        vk->device(), &waitInfo, 1'000'000'000ull);
+    }
+
+    if (status != VK_SUCCESS)
+      return status;
+
+    uint64_t value = 0;
+    status = vk->vkGetSemaphoreCounterValueKHR(vk->device(), m_timeline, &value);
+
+    if (status == VK_SUCCESS)
+      m_completedId.store(std::max(value, entry.submissionId));
+
+    return status;
+  }
+
+
+  VkSemaphore DxvkSubmissionQueue::createTimelineSemaphore() {
+    if (!m_device->features().khrTimelineSemaphore.timelineSemaphore)
+      return VK_NULL_HANDLE;
+
+    auto vk = m_device->vkd();
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR };
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &typeInfo };
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+
+    if (vk->vkCreateSemaphore(vk->device(), &info, nullptr, &semaphore) != VK_SUCCESS) {
+      Logger::warn("DxvkSubmissionQueue: Failed to create timeline semaphore");
+      return VK_NULL_HANDLE;
+    }
+
+    return semaphore;
+  }
+
+}
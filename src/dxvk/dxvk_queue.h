@@ -1,6 +1,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <queue>
 
@@ -46,6 +47,9 @@ namespace dxvk {
    */
   struct DxvkPresentInfo {
     Rc<vk::Presenter>   presenter;
+    uint64_t            frameId;
+    uint64_t            displayFrameId;
+    std::vector<VkRectLayerKHR> regions;
   };
 
 
@@ -56,13 +60,21 @@ namespace dxvk {
     DxvkSubmitStatus*   status;
     DxvkSubmitInfo      submit;
     DxvkPresentInfo     present;
+    uint64_t            submissionId;
   };
 
 
   /**
    * \brief Submission queue
+   *
+   * If timeline semaphores are supported, all command
+   * lists signal one timeline semaphore with their
+   * submission ID, so that tracking GPU progress does
+   * not require waiting on a fence per command list.
    */
   class DxvkSubmissionQueue {
+    /// Maximum number of command lists to submit in one call
+    constexpr static uint32_t MaxSubmitBatchSize = 8;
 
   public:
     
@@ -92,6 +104,29 @@ namespace dxvk {
       return m_gpuIdle.load();
     }
 
+    /**
+     * \brief Queries ID of last completed submission
+     *
+     * Submission IDs are assigned in submission order,
+     * so any submission with an ID less than or equal
+     * to the returned value has completed execution.
+     * This does not need to acquire any locks.
+     * \returns Last completed submission ID
+     */
+    uint64_t completedSubmissionId() const {
+      return m_completedId.load();
+    }
+
+    /**
+     * \brief Checks whether a submission has completed
+     *
+     * \param [in] submissionId Submission ID
+     * \returns \c true if the submission has completed
+     */
+    bool isSubmissionComplete(uint64_t submissionId) const {
+      return m_completedId.load() >= submissionId;
+    }
+
     /**
      * \brief Retrieves last submission error
      * 
@@ -110,8 +145,9 @@ namespace dxvk {
      * dedicated submission thread. Use this to take
      * the submission overhead off the calling thread.
      * \param [in] submitInfo Submission parameters 
+     * \returns Submission ID of the command list
      */
-    void submit(
+    uint64_t submit(
             DxvkSubmitInfo      submitInfo);
     
     /**
@@ -185,6 +221,10 @@ namespace dxvk {
     std::atomic<uint32_t>   m_pending = { 0u };
     std::atomic<uint64_t>   m_gpuIdle = { 0ull };
 
+    VkSemaphore             m_timeline = VK_NULL_HANDLE;
+    uint64_t                m_submittedId = 0ull;
+    std::atomic<uint64_t>   m_completedId = { 0ull };
+
     dxvk::mutex                 m_mutex;
     dxvk::mutex                 m_mutexQueue;
     
@@ -192,17 +232,29 @@ namespace dxvk {
     dxvk::condition_variable    m_submitCond;
     dxvk::condition_variable    m_finishCond;
 
-    std::queue<DxvkSubmitEntry> m_submitQueue;
+    std::deque<DxvkSubmitEntry> m_submitQueue;
     std::queue<DxvkSubmitEntry> m_finishQueue;
 
     dxvk::thread                m_submitThread;
     dxvk::thread                m_finishThread;
 
+    VkSemaphore createTimelineSemaphore();
+
     VkResult submitToQueue(
       const DxvkSubmitInfo& submission);
 
+    bool canBatchSubmission(
+      const DxvkSubmitEntry& entry) const;
+
+    VkResult submitBatch(
+            uint32_t            entryCount,
+      const DxvkSubmitEntry*    entries);
+
     void submitCmdLists();
 
+    VkResult waitForSubmission(
+      const DxvkSubmitEntry& entry);
+
     void finishCmdLists();
     
   };
@@ -40,15 +40,16 @@ namespace dxvk {
     VkImageLayout       loadLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
     VkImageLayout       storeLayout = VK_IMAGE_LAYOUT_GENERAL;
     VkClearDepthStencilValue clearValue = VkClearDepthStencilValue();
+    VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE;
   };
   
   
   /**
    * \brief Render pass transitions
    * 
-   * Stores transitions for all depth and color attachments.
-   * This is used to select a specific render pass object
-   * from a group of render passes with the same format.
+   * Stores transitions for all depth and color attachments,
+   * used to set up load ops and layout transitions when
+   * beginning a dynamic render pass instance.
    */
   struct DxvkRenderPassOps {
     DxvkDepthAttachmentOps depthOps;
@@ -50,6 +50,25 @@ namespace dxvk {
       return release(DxvkAccess::None);
     }
 
+    /**
+     * \brief Increments reference count if the resource is alive
+     *
+     * Used to safely obtain a reference to a resource that
+     * may be destroyed concurrently, e.g. when scanning a
+     * list of registered resources.
+     * \returns \c true if the reference count was non-zero
+     */
+    bool tryIncRef() {
+      uint64_t value = m_useCount.load();
+
+      do {
+        if (!(value & RefcountMask))
+          return false;
+      } while (!m_useCount.compare_exchange_weak(value, value + RefcountInc));
+
+      return true;
+    }
+
     /**
      * \brief Acquires resource with given access
      *
@@ -72,6 +91,18 @@ namespace dxvk {
       return uint32_t((m_useCount -= getIncrement(access)) & RefcountMask);
     }
 
+    /**
+     * \brief Checks whether the caller holds the only reference
+     *
+     * Since command lists and CS chunks hold references as
+     * well, this also implies that the resource is not in
+     * use, and will not be used by any pending commands.
+     * \returns \c true if the reference count is 1
+     */
+    bool isUniquelyReferenced() const {
+      return m_useCount.load() == RefcountInc;
+    }
+
     /**
      * \brief Checks whether resource is in use
      * 
@@ -101,10 +132,43 @@ namespace dxvk {
         return !isInUse(access);
       });
     }
+
+    /**
+     * \brief Marks resource as tracked in a tracking epoch
+     *
+     * Used by lifetime trackers to avoid acquiring the same
+     * resource more than once per command list. Write access
+     * implies read access, and any access keeps the resource
+     * alive. Concurrent trackers may overwrite each other's
+     * epoch, but that only results in a redundant acquire.
+     * \param [in] access Access type to track
+     * \param [in] epoch Unique epoch of the calling tracker
+     * \returns \c true if the resource needs to be acquired
+     */
+    bool trackEpoch(DxvkAccess access, uint64_t epoch) {
+      if (getTrackedEpoch(DxvkAccess::Write) == epoch)
+        return false;
+
+      if (access != DxvkAccess::Write
+       && getTrackedEpoch(DxvkAccess::Read) == epoch)
+        return false;
+
+      if (access == DxvkAccess::None
+       && getTrackedEpoch(DxvkAccess::None) == epoch)
+        return false;
+
+      m_trackedEpochs[uint32_t(access)].store(epoch, std::memory_order_relaxed);
+      return true;
+    }
     
   private:
     
     std::atomic<uint64_t> m_useCount = { 0ull };
+    std::atomic<uint64_t> m_trackedEpochs[3] = { };
+
+    uint64_t getTrackedEpoch(DxvkAccess access) const {
+      return m_trackedEpochs[uint32_t(access)].load(std::memory_order_relaxed);
+    }
 
     static constexpr uint64_t getIncrement(DxvkAccess access) {
       uint64_t increment = RefcountInc;
@@ -0,0 +1,312 @@
+#include <cstring>
+
+#include "dxvk_device.h"
+#include "dxvk_resource_pool.h"
+
+namespace dxvk {
+
+  DxvkResourcePool::DxvkResourcePool(DxvkDevice* device)
+  : m_device(device) {
+
+  }
+
+
+  DxvkResourcePool::~DxvkResourcePool() {
+
+  }
+
+
+  Rc<DxvkBuffer> DxvkResourcePool::findBuffer(
+    const DxvkBufferCreateInfo& createInfo,
+          VkMemoryPropertyFlags memoryType) {
+    size_t hash = hashBuffer(createInfo, memoryType);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto list = m_buffers.find(hash);
+
+    if (list == m_buffers.end())
+      return nullptr;
+
+    // Entries with the same hash usually have the same properties,
+    // so this only ever has to skip buffers that are still in use
+    for (auto i = list->second.begin(); i != list->second.end(); i++) {
+      const Rc<DxvkBuffer>& buffer = i->resource;
+
+      if (buffer->memFlags() != memoryType
+       || !isSameBuffer(buffer->info(), createInfo)
+       || !buffer->isUniquelyReferenced())
+        continue;
+
+      Rc<DxvkBuffer> result = std::move(i->resource);
+      m_idleMemory -= i->size;
+      list->second.erase(i);
+
+      if (list->second.empty())
+        m_buffers.erase(list);
+
+      return result;
+    }
+
+    return nullptr;
+  }
+
+
+  Rc<DxvkImage> DxvkResourcePool::findImage(
+    const DxvkImageCreateInfo&  createInfo,
+          VkMemoryPropertyFlags memoryType) {
+    size_t hash = hashImage(createInfo, memoryType);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto list = m_images.find(hash);
+
+    if (list == m_images.end())
+      return nullptr;
+
+    for (auto i = list->second.begin(); i != list->second.end(); i++) {
+      const Rc<DxvkImage>& image = i->resource;
+
+      // Transient images may have been moved to
+      // lazily allocated memory on creation
+      VkMemoryPropertyFlags memFlags = image->memFlags()
+        & ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+      if (memFlags != memoryType
+       || !isSameImage(image->info(), createInfo)
+       || !image->isUniquelyReferenced())
+        continue;
+
+      Rc<DxvkImage> result = std::move(i->resource);
+      m_idleMemory -= i->size;
+      list->second.erase(i);
+
+      if (list->second.empty())
+        m_images.erase(list);
+
+      // Reset tracking state left behind by the previous
+      // owner, the new owner will initialize the image. If
+      // the image was never used, it is still in its initial
+      // layout, otherwise it is in its default layout.
+      result->setUnusedLayout(result->claimPendingInit()
+        ? result->info().initialLayout
+        : result->info().layout);
+      result->setDepthStoreInfo(DxvkDepthStoreInfo());
+      return result;
+    }
+
+    return nullptr;
+  }
+
+
+  void DxvkResourcePool::recycleBuffer(
+          Rc<DxvkBuffer>&&      buffer) {
+    if (buffer == nullptr || buffer->isSparse())
+      return;
+
+    VkDeviceSize size = buffer->info().size;
+
+    if (size > MaxIdleMemory / 4)
+      return;
+
+    size_t hash = hashBuffer(buffer->info(), buffer->memFlags());
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    trimLocked(size);
+
+    m_buffers[hash].push_back({ std::move(buffer), size,
+      dxvk::high_resolution_clock::now() });
+    m_idleMemory += size;
+  }
+
+
+  void DxvkResourcePool::recycleImage(
+          Rc<DxvkImage>&&       image) {
+    if (image == nullptr || !image->canRecycle())
+      return;
+
+    VkDeviceSize size = image->memSize();
+
+    if (size > MaxIdleMemory / 4)
+      return;
+
+    size_t hash = hashImage(image->info(), image->memFlags()
+      & ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    trimLocked(size);
+
+    m_images[hash].push_back({ std::move(image), size,
+      dxvk::high_resolution_clock::now() });
+    m_idleMemory += size;
+  }
+
+
+  void DxvkResourcePool::trim() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    trimLocked(0);
+  }
+
+
+  void DxvkResourcePool::trimLocked(
+          VkDeviceSize          required) {
+    auto now = dxvk::high_resolution_clock::now();
+
+    trimLists(m_buffers, now - std::chrono::microseconds(MaxIdleTime));
+    trimLists(m_images,  now - std::chrono::microseconds(MaxIdleTime));
+
+    // Entries within each list are sorted by the time they were
+    // added, so evict the oldest resources until the new one fits
+    while (m_idleMemory + required > MaxIdleMemory) {
+      auto buffers = findOldestList(m_buffers);
+      auto images  = findOldestList(m_images);
+
+      bool evictBuffer = buffers != m_buffers.end() && (images == m_images.end()
+        || buffers->second.front().time < images->second.front().time);
+
+      if (evictBuffer) {
+        evictOldest(m_buffers, buffers);
+      } else if (images != m_images.end()) {
+        evictOldest(m_images, images);
+      } else {
+        break;
+      }
+    }
+  }
+
+
+  template<typename T>
+  void DxvkResourcePool::trimLists(
+          EntryMap<T>&          lists,
+          dxvk::high_resolution_clock::time_point time) {
+    for (auto i = lists.begin(); i != lists.end(); ) {
+      auto& entries = i->second;
+      size_t count = 0;
+
+      while (count < entries.size() && entries[count].time < time)
+        m_idleMemory -= entries[count++].size;
+
+      if (count)
+        entries.erase(entries.begin(), entries.begin() + count);
+
+      if (entries.empty())
+        i = lists.erase(i);
+      else
+        i++;
+    }
+  }
+
+
+  template<typename T>
+  typename DxvkResourcePool::EntryMap<T>::iterator DxvkResourcePool::findOldestList(
+          EntryMap<T>&          lists) {
+    auto result = lists.end();
+
+    for (auto i = lists.begin(); i != lists.end(); i++) {
+      if (result == lists.end() || i->second.front().time < result->second.front().time)
+        result = i;
+    }
+
+    return result;
+  }
+
+
+  template<typename T>
+  void DxvkResourcePool::evictOldest(
+          EntryMap<T>&          lists,
+          typename EntryMap<T>::iterator list) {
+    m_idleMemory -= list->second.front().size;
+    list->second.erase(list->second.begin());
+
+    if (list->second.empty())
+      lists.erase(list);
+  }
+
+
+  size_t DxvkResourcePool::hashBuffer(
+    const DxvkBufferCreateInfo& info,
+          VkMemoryPropertyFlags memoryType) {
+    DxvkHashState hash;
+    hash.add(std::hash<VkDeviceSize>()(info.size));
+    hash.add(uint32_t(info.usage));
+    hash.add(uint32_t(info.stages));
+    hash.add(uint32_t(info.access));
+    hash.add(uint32_t(info.category));
+    hash.add(uint32_t(info.flags));
+    hash.add(uint32_t(memoryType));
+    return hash;
+  }
+
+
+  size_t DxvkResourcePool::hashImage(
+    const DxvkImageCreateInfo&  info,
+          VkMemoryPropertyFlags memoryType) {
+    // View formats and sharing info are rarely different for
+    // images with otherwise identical properties, so leave
+    // those to the full comparison
+    DxvkHashState hash;
+    hash.add(uint32_t(info.type));
+    hash.add(uint32_t(info.format));
+    hash.add(uint32_t(info.flags));
+    hash.add(uint32_t(info.sampleCount));
+    hash.add(info.extent.width);
+    hash.add(info.extent.height);
+    hash.add(info.extent.depth);
+    hash.add(info.numLayers);
+    hash.add(info.mipLevels);
+    hash.add(uint32_t(info.usage));
+    hash.add(uint32_t(info.stages));
+    hash.add(uint32_t(info.access));
+    hash.add(uint32_t(info.tiling));
+    hash.add(uint32_t(info.layout));
+    hash.add(uint32_t(info.initialLayout));
+    hash.add(uint32_t(info.category));
+    hash.add(uint32_t(memoryType));
+    return hash;
+  }
+
+
+  bool DxvkResourcePool::isSameBuffer(
+    const DxvkBufferCreateInfo& a,
+    const DxvkBufferCreateInfo& b) {
+    return a.size     == b.size
+        && a.usage    == b.usage
+        && a.stages   == b.stages
+        && a.access   == b.access
+        && a.category == b.category
+        && a.flags    == b.flags;
+  }
+
+
+  bool DxvkResourcePool::isSameImage(
+    const DxvkImageCreateInfo&  a,
+    const DxvkImageCreateInfo&  b) {
+    bool eq = a.type            == b.type
+           && a.format          == b.format
+           && a.flags           == b.flags
+           && a.sampleCount     == b.sampleCount
+           && a.extent.width    == b.extent.width
+           && a.extent.height   == b.extent.height
+           && a.extent.depth    == b.extent.depth
+           && a.numLayers       == b.numLayers
+           && a.mipLevels       == b.mipLevels
+           && a.usage           == b.usage
+           && a.stages          == b.stages
+           && a.access          == b.access
+           && a.tiling          == b.tiling
+           && a.layout          == b.layout
+           && a.initialLayout   == b.initialLayout
+           && a.shared          == b.shared
+           && a.sharing.mode    == b.sharing.mode
+           && a.category        == b.category
+           && a.viewFormatCount == b.viewFormatCount;
+
+    if (eq && a.viewFormatCount) {
+      eq = !std::memcmp(a.viewFormats, b.viewFormats,
+        sizeof(VkFormat) * a.viewFormatCount);
+    }
+
+    return eq;
+  }
+
+}
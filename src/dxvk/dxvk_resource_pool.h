@@ -0,0 +1,145 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_buffer.h"
+#include "dxvk_hash.h"
+#include "dxvk_image.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Resource pool
+   *
+   * Keeps buffers and images released by API-level
+   * resources around for a short while, so that an
+   * application which creates and destroys resources
+   * with identical properties every frame can reuse
+   * them instead of creating new Vulkan objects. A
+   * resource is only handed out again once the pool
+   * holds the only reference to it, which means that
+   * no pending command still uses it.
+   */
+  class DxvkResourcePool {
+    /// Time after which idle resources are destroyed, in us
+    constexpr static int64_t MaxIdleTime = 1'000'000;
+    /// Maximum amount of memory held by idle resources
+    constexpr static VkDeviceSize MaxIdleMemory = 64ull << 20;
+  public:
+
+    DxvkResourcePool(DxvkDevice* device);
+
+    ~DxvkResourcePool();
+
+    /**
+     * \brief Looks up a recycled buffer
+     *
+     * \param [in] createInfo Buffer properties
+     * \param [in] memoryType Memory property flags
+     * \returns Idle buffer with the given properties,
+     *    or \c nullptr if no such buffer exists
+     */
+    Rc<DxvkBuffer> findBuffer(
+      const DxvkBufferCreateInfo& createInfo,
+            VkMemoryPropertyFlags memoryType);
+
+    /**
+     * \brief Looks up a recycled image
+     *
+     * \param [in] createInfo Image properties
+     * \param [in] memoryType Memory property flags
+     * \returns Idle image with the given properties,
+     *    or \c nullptr if no such image exists
+     */
+    Rc<DxvkImage> findImage(
+      const DxvkImageCreateInfo&  createInfo,
+            VkMemoryPropertyFlags memoryType);
+
+    /**
+     * \brief Adds a buffer to the pool
+     *
+     * The buffer may still be in use by the GPU.
+     * \param [in] buffer The buffer
+     */
+    void recycleBuffer(
+            Rc<DxvkBuffer>&&      buffer);
+
+    /**
+     * \brief Adds an image to the pool
+     *
+     * The image may still be in use by the GPU.
+     * \param [in] image The image
+     */
+    void recycleImage(
+            Rc<DxvkImage>&&       image);
+
+    /**
+     * \brief Destroys resources that have been idle for too long
+     *
+     * Should be called periodically so that resources
+     * that are never requested again get freed.
+     */
+    void trim();
+
+  private:
+
+    template<typename T>
+    struct Entry {
+      Rc<T>         resource;
+      VkDeviceSize  size;
+      dxvk::high_resolution_clock::time_point time;
+    };
+
+    /// Idle resources, grouped by a hash of their properties
+    template<typename T>
+    using EntryMap = std::unordered_map<size_t, std::vector<Entry<T>>>;
+
+    DxvkDevice*                   m_device;
+
+    dxvk::mutex                   m_mutex;
+    EntryMap<DxvkBuffer>          m_buffers;
+    EntryMap<DxvkImage>           m_images;
+
+    VkDeviceSize                  m_idleMemory = 0;
+
+    void trimLocked(
+            VkDeviceSize          required);
+
+    template<typename T>
+    void trimLists(
+            EntryMap<T>&          lists,
+            dxvk::high_resolution_clock::time_point time);
+
+    template<typename T>
+    typename EntryMap<T>::iterator findOldestList(
+            EntryMap<T>&          lists);
+
+    template<typename T>
+    void evictOldest(
+            EntryMap<T>&          lists,
+            typename EntryMap<T>::iterator list);
+
+    static size_t hashBuffer(
+      const DxvkBufferCreateInfo& info,
+            VkMemoryPropertyFlags memoryType);
+
+    static size_t hashImage(
+      const DxvkImageCreateInfo&  info,
+            VkMemoryPropertyFlags memoryType);
+
+    static bool isSameBuffer(
+      const DxvkBufferCreateInfo& a,
+      const DxvkBufferCreateInfo& b);
+
+    static bool isSameImage(
+      const DxvkImageCreateInfo&  a,
+      const DxvkImageCreateInfo&  b);
+
+  };
+
+}
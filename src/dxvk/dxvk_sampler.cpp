@@ -81,4 +81,120 @@ namespace dxvk {
     return VK_BORDER_COLOR_FLOAT_CUSTOM_EXT;
   }
 
+
+
+  bool DxvkSamplerCreateInfo::eq(const DxvkSamplerCreateInfo& other) const {
+    return magFilter      == other.magFilter
+        && minFilter      == other.minFilter
+        && mipmapMode     == other.mipmapMode
+        && bit::cast<uint32_t>(mipmapLodBias) == bit::cast<uint32_t>(other.mipmapLodBias)
+        && bit::cast<uint32_t>(mipmapLodMin) == bit::cast<uint32_t>(other.mipmapLodMin)
+        && bit::cast<uint32_t>(mipmapLodMax) == bit::cast<uint32_t>(other.mipmapLodMax)
+        && useAnisotropy  == other.useAnisotropy
+        && bit::cast<uint32_t>(maxAnisotropy) == bit::cast<uint32_t>(other.maxAnisotropy)
+        && addressModeU   == other.addressModeU
+        && addressModeV   == other.addressModeV
+        && addressModeW   == other.addressModeW
+        && compareToDepth == other.compareToDepth
+        && compareOp      == other.compareOp
+        && !std::memcmp(&borderColor, &other.borderColor, sizeof(borderColor))
+        && usePixelCoord  == other.usePixelCoord
+        && nonSeamless    == other.nonSeamless;
+  }
+
+
+  size_t DxvkSamplerCreateInfo::hash() const {
+    DxvkHashState hash;
+    hash.add(uint32_t(magFilter));
+    hash.add(uint32_t(minFilter));
+    hash.add(uint32_t(mipmapMode));
+    hash.add(bit::cast<uint32_t>(mipmapLodBias));
+    hash.add(bit::cast<uint32_t>(mipmapLodMin));
+    hash.add(bit::cast<uint32_t>(mipmapLodMax));
+    hash.add(useAnisotropy);
+    hash.add(bit::cast<uint32_t>(maxAnisotropy));
+    hash.add(uint32_t(addressModeU));
+    hash.add(uint32_t(addressModeV));
+    hash.add(uint32_t(addressModeW));
+    hash.add(compareToDepth);
+    hash.add(uint32_t(compareOp));
+
+    for (uint32_t i = 0; i < 4; i++)
+      hash.add(borderColor.uint32[i]);
+
+    hash.add(usePixelCoord);
+    hash.add(nonSeamless);
+    return hash;
+  }
+
+
+  DxvkSamplerPool::DxvkSamplerPool(DxvkDevice* device)
+  : m_device(device) {
+    // Leave some headroom for samplers created by external
+    // code, and for samplers that are still in use when
+    // we would otherwise evict them.
+    uint32_t maxCount = device->properties().core.properties.limits.maxSamplerAllocationCount;
+    m_softLimit = maxCount - maxCount / 4;
+  }
+
+
+  DxvkSamplerPool::~DxvkSamplerPool() {
+
+  }
+
+
+  Rc<DxvkSampler> DxvkSamplerPool::createSampler(
+    const DxvkSamplerCreateInfo&  info) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_samplers.find(info);
+
+    if (entry != m_samplers.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, entry->second.lruPos);
+      return entry->second.sampler;
+    }
+
+    if (m_samplers.size() >= m_softLimit)
+      evictSamplers();
+
+    Rc<DxvkSampler> sampler = new DxvkSampler(m_device, info);
+
+    auto result = m_samplers.emplace(std::piecewise_construct,
+      std::forward_as_tuple(info), std::forward_as_tuple());
+
+    m_lru.push_front(&(*result.first));
+
+    result.first->second.sampler = sampler;
+    result.first->second.lruPos  = m_lru.begin();
+    return sampler;
+  }
+
+
+  DxvkSamplerStats DxvkSamplerPool::getStats() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    DxvkSamplerStats result;
+    result.liveCount    = uint32_t(m_samplers.size());
+    result.evictedCount = m_evictedCount;
+    return result;
+  }
+
+
+  void DxvkSamplerPool::evictSamplers() {
+    // Samplers only referenced by the pool are not bound to
+    // any state object or context and are not in use by the
+    // GPU, so they can be destroyed safely.
+    auto iter = m_lru.end();
+
+    while (iter != m_lru.begin() && m_samplers.size() >= m_softLimit) {
+      auto entry = *(--iter);
+
+      if (entry->second.sampler->isUniquelyReferenced()) {
+        iter = m_lru.erase(iter);
+        m_samplers.erase(entry->first);
+        m_evictedCount += 1;
+      }
+    }
+  }
+  
 }
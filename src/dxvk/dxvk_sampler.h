@@ -1,5 +1,9 @@
 #pragma once
 
+#include <list>
+#include <unordered_map>
+
+#include "dxvk_hash.h"
 #include "dxvk_resource.h"
 
 namespace dxvk {
@@ -41,6 +45,10 @@ namespace dxvk {
 
     /// Enables non seamless cube map filtering
     VkBool32 nonSeamless;
+
+    bool eq(const DxvkSamplerCreateInfo& other) const;
+
+    size_t hash() const;
   };
   
   
@@ -79,4 +87,76 @@ namespace dxvk {
     
   };
   
+
+
+  /**
+   * \brief Sampler pool statistics
+   */
+  struct DxvkSamplerStats {
+    uint32_t liveCount    = 0;
+    uint32_t evictedCount = 0;
+  };
+
+
+  /**
+   * \brief Sampler pool
+   *
+   * Deduplicates samplers with identical properties across
+   * all users of the device, since drivers typically limit
+   * the number of samplers that can exist at any time. Once
+   * the pool exceeds a soft limit, samplers that are not
+   * referenced by anything else are destroyed, starting
+   * with the least recently requested ones.
+   */
+  class DxvkSamplerPool {
+
+  public:
+
+    DxvkSamplerPool(DxvkDevice* device);
+
+    ~DxvkSamplerPool();
+
+    /**
+     * \brief Retrieves sampler with the given properties
+     *
+     * Returns an existing sampler if one with the same
+     * properties exists, or creates a new one otherwise.
+     * \param [in] info Sampler properties
+     * \returns Sampler object
+     */
+    Rc<DxvkSampler> createSampler(
+      const DxvkSamplerCreateInfo&  info);
+
+    /**
+     * \brief Queries sampler pool statistics
+     * \returns Sampler statistics
+     */
+    DxvkSamplerStats getStats();
+
+  private:
+
+    struct Entry;
+
+    using SamplerMap = std::unordered_map<
+      DxvkSamplerCreateInfo, Entry, DxvkHash, DxvkEq>;
+
+    using LruList = std::list<SamplerMap::value_type*>;
+
+    struct Entry {
+      Rc<DxvkSampler>   sampler;
+      LruList::iterator lruPos;
+    };
+
+    DxvkDevice*       m_device;
+    uint32_t          m_softLimit = 0;
+
+    dxvk::mutex       m_mutex;
+    SamplerMap        m_samplers;
+    LruList           m_lru;
+    uint32_t          m_evictedCount = 0;
+
+    void evictSamplers();
+
+  };
+  
 }
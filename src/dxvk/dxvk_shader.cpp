@@ -1,3 +1,4 @@
+#include "dxvk_device.h"
 #include "dxvk_shader.h"
 
 #include <algorithm>
@@ -60,6 +61,81 @@ namespace dxvk {
   }
 
 
+  DxvkShaderCodeCache::DxvkShaderCodeCache() {
+
+  }
+
+
+  DxvkShaderCodeCache::~DxvkShaderCodeCache() {
+
+  }
+
+
+  bool DxvkShaderCodeCache::lookup(
+    const DxvkShader*               shader,
+          SpirvCodeBuffer&          code) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(shader);
+
+    if (entry == m_entries.end())
+      return false;
+
+    m_lru.splice(m_lru.begin(), m_lru, entry->second.lruPos);
+
+    code = entry->second.code;
+    return true;
+  }
+
+
+  void DxvkShaderCodeCache::insert(
+    const DxvkShader*               shader,
+    const SpirvCodeBuffer&          code) {
+    // Don't let a single huge shader flush the entire cache
+    if (code.size() > MaxCacheSize / 4)
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_entries.find(shader) != m_entries.end())
+      return;
+
+    while (!m_lru.empty() && m_size + code.size() > MaxCacheSize)
+      evictEntry(m_lru.back());
+
+    m_lru.push_front(shader);
+
+    Entry& entry = m_entries[shader];
+    entry.code   = code;
+    entry.lruPos = m_lru.begin();
+
+    m_size += code.size();
+  }
+
+
+  void DxvkShaderCodeCache::evict(
+    const DxvkShader*               shader) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    evictEntry(shader);
+  }
+
+
+  void DxvkShaderCodeCache::evictEntry(
+    const DxvkShader*               shader) {
+    auto entry = m_entries.find(shader);
+
+    if (entry == m_entries.end())
+      return;
+
+    m_size -= entry->second.code.size();
+    m_lru.erase(entry->second.lruPos);
+    m_entries.erase(entry);
+  }
+
+
+  DxvkShaderCodeCache DxvkShader::s_codeCache;
+
+
   DxvkShader::DxvkShader(
     const DxvkShaderCreateInfo&   info,
           SpirvCodeBuffer&&       spirv)
@@ -67,6 +143,8 @@ namespace dxvk {
     m_info.uniformData = nullptr;
     m_info.bindings = nullptr;
 
+    m_codeLastUse.store(getTimestamp(high_resolution_clock::now()));
+
     // Copy resource binding slot infos
     for (uint32_t i = 0; i < info.bindingCount; i++) {
       DxvkBindingInfo binding = info.bindings[i];
@@ -121,6 +199,9 @@ namespace dxvk {
         
         if (ins.arg(2) == spv::DecorationIndex && ins.arg(1) == o1VarId)
           m_o1IdxOffset = ins.offset() + 3;
+
+        if (ins.arg(2) == spv::DecorationSpecId && ins.arg(3) == uint32_t(DxvkSpecConstantId::SpecConstantsOptimized))
+          m_flags.set(DxvkShaderFlag::HasSpecConstantFallback);
       }
 
       if (ins.opCode() == spv::OpExecutionMode) {
@@ -155,7 +236,67 @@ namespace dxvk {
 
 
   DxvkShader::~DxvkShader() {
-    
+    if (m_cache)
+      m_cache->removeShader(this);
+
+    s_codeCache.evict(this);
+  }
+
+
+  SpirvCodeBuffer DxvkShader::getRawCode() const {
+    m_codeLastUse.store(getTimestamp(high_resolution_clock::now()));
+
+    SpirvCodeBuffer code;
+
+    if (!s_codeCache.lookup(this, code)) {
+      std::lock_guard<dxvk::mutex> lock(m_codeMutex);
+
+      if (m_codeEvicted) {
+        // Pipelines using this shader will fail to compile,
+        // but that is better than taking down the process
+        if (m_codeLost || !m_cache->loadCode(getShaderKey(), m_cacheLocation, code)) {
+          if (!std::exchange(m_codeLost, true))
+            Logger::err(str::format("Failed to reload shader code for ", debugName()));
+
+          return SpirvCodeBuffer();
+        }
+
+        m_code = SpirvCompressedBuffer(code);
+        m_codeEvicted = false;
+      } else {
+        code = m_code.decompress();
+      }
+
+      s_codeCache.insert(this, code);
+    }
+
+    return code;
+  }
+
+
+  void DxvkShader::setCacheLocation(
+          DxvkShaderCache*            cache,
+    const DxvkShaderCacheLocation&    location) {
+    std::lock_guard<dxvk::mutex> lock(m_codeMutex);
+    m_cache = cache;
+    m_cacheLocation = location;
+  }
+
+
+  bool DxvkShader::evictCode(
+          high_resolution_clock::time_point deadline) {
+    if (m_codeLastUse.load() > getTimestamp(deadline))
+      return false;
+
+    // Don't stall pipeline compilation on this
+    std::unique_lock<dxvk::mutex> lock(m_codeMutex, std::try_to_lock);
+
+    if (!lock || m_codeEvicted || !m_cache)
+      return false;
+
+    m_code = SpirvCompressedBuffer();
+    m_codeEvicted = true;
+    return true;
   }
   
   
@@ -163,7 +304,11 @@ namespace dxvk {
     const Rc<vk::DeviceFn>&           vkd,
     const DxvkBindingLayoutObjects*   layout,
     const DxvkShaderModuleCreateInfo& info) {
-    SpirvCodeBuffer spirvCode = m_code.decompress();
+    SpirvCodeBuffer spirvCode = getRawCode();
+
+    if (!spirvCode.size())
+      return DxvkShaderModule();
+
     uint32_t* code = spirvCode.data();
     
     // Remap resource binding IDs
@@ -185,18 +330,60 @@ namespace dxvk {
     
     // Replace undefined input variables with zero
     for (uint32_t u : bit::BitMask(info.undefinedInputs))
-      eliminateInput(spirvCode, u);
+      eliminateVariable(spirvCode, spv::StorageClassInput, u);
+
+    // Demote outputs that the next stage does not read to private
+    // variables, so that the driver can remove the code computing
+    // them and does not need to allocate the interpolants
+    for (uint32_t u : bit::BitMask(info.unusedOutputs))
+      eliminateVariable(spirvCode, spv::StorageClassOutput, u);
 
     return DxvkShaderModule(vkd, this, spirvCode);
   }
   
   
+  bool DxvkShader::canUsePipelineLibrary() const {
+    // Push constants are currently not supported since
+    // the merged pipeline layout would be incompatible
+    if (m_info.pushConstSize)
+      return false;
+
+    if (m_info.stage == VK_SHADER_STAGE_VERTEX_BIT)
+      return !m_flags.test(DxvkShaderFlag::HasTransformFeedback);
+
+    // Sample rate shading requires multisample state
+    if (m_info.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      return !m_flags.test(DxvkShaderFlag::HasSampleRateShading);
+
+    return false;
+  }
+
+
+  void DxvkShader::releaseUniformData() {
+    m_info.uniformSize = 0;
+    m_info.uniformData = nullptr;
+
+    m_uniformData.clear();
+    m_uniformData.shrink_to_fit();
+  }
+
+
   void DxvkShader::dump(std::ostream& outputStream) const {
-    m_code.decompress().store(outputStream);
+    getRawCode().store(outputStream);
+  }
+
+
+  int64_t DxvkShader::getTimestamp(
+          high_resolution_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      time.time_since_epoch()).count();
   }
 
 
-  void DxvkShader::eliminateInput(SpirvCodeBuffer& code, uint32_t location) {
+  void DxvkShader::eliminateVariable(
+          SpirvCodeBuffer&          code,
+          spv::StorageClass         storageClass,
+          uint32_t                  location) {
     struct SpirvTypeInfo {
       spv::Op           op            = spv::OpNop;
       uint32_t          baseTypeId    = 0;
@@ -207,17 +394,22 @@ namespace dxvk {
     std::unordered_map<uint32_t, SpirvTypeInfo> types;
     std::unordered_map<uint32_t, uint32_t>      constants;
     std::unordered_set<uint32_t>                candidates;
+    std::unordered_set<uint32_t>                xfbVars;
 
-    // Find the input variable in question
-    size_t   inputVarOffset = 0;
-    uint32_t inputVarTypeId = 0;
-    uint32_t inputVarId     = 0;
+    // Find the variable in question
+    size_t   varOffset = 0;
+    uint32_t varTypeId = 0;
+    uint32_t varId     = 0;
 
     for (auto ins : code) {
       if (ins.opCode() == spv::OpDecorate) {
         if (ins.arg(2) == spv::DecorationLocation
          && ins.arg(3) == location)
           candidates.insert(ins.arg(1));
+
+        // Outputs captured by transform feedback must be kept
+        if (ins.arg(2) == spv::DecorationXfbBuffer)
+          xfbVars.insert(ins.arg(1));
       }
 
       if (ins.opCode() == spv::OpConstant)
@@ -239,25 +431,26 @@ namespace dxvk {
       if (ins.opCode() == spv::OpTypePointer)
         types.insert({ ins.arg(1), { ins.opCode(), ins.arg(3), 0, spv::StorageClass(ins.arg(2)) }});
 
-      if (ins.opCode() == spv::OpVariable && spv::StorageClass(ins.arg(3)) == spv::StorageClassInput) {
-        if (candidates.find(ins.arg(2)) != candidates.end()) {
-          inputVarOffset = ins.offset();
-          inputVarTypeId = ins.arg(1);
-          inputVarId     = ins.arg(2);
+      if (ins.opCode() == spv::OpVariable && spv::StorageClass(ins.arg(3)) == storageClass) {
+        if (candidates.find(ins.arg(2)) != candidates.end()
+         && xfbVars.find(ins.arg(2)) == xfbVars.end()) {
+          varOffset = ins.offset();
+          varTypeId = ins.arg(1);
+          varId     = ins.arg(2);
           break;
         }
       }
     }
 
-    if (!inputVarId)
+    if (!varId)
       return;
 
     // Declare private pointer types
-    auto pointerType = types.find(inputVarTypeId);
+    auto pointerType = types.find(varTypeId);
     if (pointerType == types.end())
       return;
 
-    code.beginInsertion(inputVarOffset);
+    code.beginInsertion(varOffset);
     std::vector<std::pair<uint32_t, SpirvTypeInfo>> privateTypes;
 
     for (auto p  = types.find(pointerType->second.baseTypeId);
@@ -318,7 +511,7 @@ namespace dxvk {
 
     code.putIns(spv::OpVariable, 5);
     code.putWord(privateTypes[0].first);
-    code.putWord(inputVarId);
+    code.putWord(varId);
     code.putWord(spv::StorageClassPrivate);
     code.putWord(constantId);
 
@@ -330,7 +523,7 @@ namespace dxvk {
         uint32_t argIdx = 2 + code.strLen(ins.chr(2));
 
         while (argIdx < ins.length()) {
-          if (ins.arg(argIdx) == inputVarId) {
+          if (ins.arg(argIdx) == varId) {
             ins.setArg(0, spv::OpEntryPoint | ((ins.length() - 1) << spv::WordCountShift));
 
             code.beginInsertion(ins.offset() + argIdx);
@@ -348,11 +541,12 @@ namespace dxvk {
     for (auto iter = code.begin(); iter != code.end(); ) {
       auto ins = *(iter++);
 
-      if (ins.opCode() == spv::OpDecorate && ins.arg(1) == inputVarId) {
+      if (ins.opCode() == spv::OpDecorate && ins.arg(1) == varId) {
         uint32_t numWords;
 
         switch (ins.arg(2)) {
           case spv::DecorationLocation:
+          case spv::DecorationComponent:
           case spv::DecorationFlat:
           case spv::DecorationNoPerspective:
           case spv::DecorationCentroid:
@@ -385,7 +579,7 @@ namespace dxvk {
        || ins.opCode() == spv::OpInBoundsAccessChain) {
         uint32_t depth = ins.length() - 4;
 
-        if (ins.arg(3) == inputVarId) {
+        if (ins.arg(3) == varId) {
           // Access chains accessing the variable directly
           ins.setArg(1, privateTypes.at(depth).first);
           accessChainIds.insert({ ins.arg(2), depth });
@@ -402,4 +596,185 @@ namespace dxvk {
     }
   }
   
-}
\ No newline at end of file
+
+
+  DxvkShaderPipelineLibrary::DxvkShaderPipelineLibrary(
+    const DxvkDevice*               device,
+    const DxvkPipelineCache*        cache,
+    const Rc<DxvkShader>&           shader,
+    const DxvkBindingLayoutObjects* layout)
+  : m_device(device), m_cache(cache),
+    m_shader(shader), m_layout(layout) {
+
+  }
+
+
+  DxvkShaderPipelineLibrary::~DxvkShaderPipelineLibrary() {
+    auto vk = m_device->vkd();
+
+    vk->vkDestroyPipeline(vk->device(), m_pipeline, nullptr);
+  }
+
+
+  VkPipeline DxvkShaderPipelineLibrary::getPipelineHandle() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (!m_compiled) {
+      m_pipeline = compileShaderPipeline();
+      m_compiled = true;
+    }
+
+    return m_pipeline;
+  }
+
+
+  void DxvkShaderPipelineLibrary::compilePipeline() {
+    this->getPipelineHandle();
+  }
+
+
+  VkPipeline DxvkShaderPipelineLibrary::compileShaderPipeline() {
+    DXVK_TRACE_SCOPE("DxvkShaderPipelineLibrary::compileShaderPipeline");
+
+    DxvkShaderModule module;
+
+    if (m_shader != nullptr) {
+      module = m_shader->createShaderModule(m_device->vkd(), m_layout, DxvkShaderModuleCreateInfo());
+
+      if (!module)
+        return VK_NULL_HANDLE;
+    }
+
+    VkPipeline pipeline = m_shader == nullptr
+      || m_shader->info().stage == VK_SHADER_STAGE_FRAGMENT_BIT
+        ? compileFragmentShaderPipeline(module)
+        : compileVertexShaderPipeline(module);
+
+    if (!pipeline) {
+      Logger::err(str::format("DxvkShaderPipelineLibrary: Failed to compile pipeline library",
+        m_shader != nullptr ? str::format(" for ", m_shader->debugName()) : std::string()));
+    }
+
+    return pipeline;
+  }
+
+
+  VkPipeline DxvkShaderPipelineLibrary::compileVertexShaderPipeline(
+    const DxvkShaderModule&         module) {
+    auto vk = m_device->vkd();
+
+    // Set up dynamic state. We do not know any pipeline state
+    // at this time, so make as much state dynamic as we can.
+    std::array<VkDynamicState, 5> dynamicStates = {{
+      VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT,
+      VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT,
+      VK_DYNAMIC_STATE_DEPTH_BIAS,
+      VK_DYNAMIC_STATE_CULL_MODE_EXT,
+      VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+    }};
+
+    VkPipelineDynamicStateCreateInfo dyInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dyInfo.dynamicStateCount      = dynamicStates.size();
+    dyInfo.pDynamicStates         = dynamicStates.data();
+
+    // All viewport state is dynamic, so we do not need to initialize this.
+    VkPipelineViewportStateCreateInfo vpInfo = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+
+    // Set up rasterizer state. Depth bias is always enabled and
+    // needs to be set to zero if the application disables it.
+    VkPipelineRasterizationDepthClipStateCreateInfoEXT rsDepthClipInfo = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_DEPTH_CLIP_STATE_CREATE_INFO_EXT };
+    rsDepthClipInfo.depthClipEnable = VK_TRUE;
+
+    VkPipelineRasterizationStateCreateInfo rsInfo = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    rsInfo.depthClampEnable       = VK_TRUE;
+    rsInfo.rasterizerDiscardEnable = VK_FALSE;
+    rsInfo.polygonMode            = VK_POLYGON_MODE_FILL;
+    rsInfo.depthBiasEnable        = VK_TRUE;
+    rsInfo.lineWidth              = 1.0f;
+
+    if (m_device->features().extDepthClipEnable.depthClipEnable)
+      rsDepthClipInfo.pNext = std::exchange(rsInfo.pNext, &rsDepthClipInfo);
+    else
+      rsInfo.depthClampEnable = VK_FALSE;
+
+    // Only the view mask is used as input, and since we do not use MultiView, it is always 0
+    VkPipelineRenderingCreateInfoKHR rtInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR };
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, &rtInfo };
+    libInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+
+    VkPipelineShaderStageCreateInfo stageInfo = module.stageInfo(nullptr);
+
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &libInfo };
+    info.flags                    = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    info.stageCount               = 1;
+    info.pStages                  = &stageInfo;
+    info.pViewportState           = &vpInfo;
+    info.pRasterizationState      = &rsInfo;
+    info.pDynamicState            = &dyInfo;
+    info.layout                   = m_layout->getPipelineLayout(true);
+    info.basePipelineIndex        = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    if (vk->vkCreateGraphicsPipelines(vk->device(), m_cache->handle(), 1, &info, nullptr, &pipeline))
+      return VK_NULL_HANDLE;
+
+    return pipeline;
+  }
+
+
+  VkPipeline DxvkShaderPipelineLibrary::compileFragmentShaderPipeline(
+    const DxvkShaderModule&         module) {
+    auto vk = m_device->vkd();
+
+    // Set up dynamic state. We do not know any pipeline state
+    // at this time, so make as much state dynamic as we can.
+    std::array<VkDynamicState, 10> dynamicStates = {{
+      VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+      VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+      VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT,
+      VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE_EXT,
+      VK_DYNAMIC_STATE_DEPTH_BOUNDS,
+      VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT,
+      VK_DYNAMIC_STATE_STENCIL_OP_EXT,
+      VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
+      VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
+      VK_DYNAMIC_STATE_STENCIL_REFERENCE,
+    }};
+
+    VkPipelineDynamicStateCreateInfo dyInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dyInfo.dynamicStateCount      = dynamicStates.size();
+    dyInfo.pDynamicStates         = dynamicStates.data();
+
+    // All depth-stencil state is dynamic, so no need to initialize this
+    VkPipelineDepthStencilStateCreateInfo dsInfo = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+
+    // Only the view mask is used as input, and since we do not use MultiView, it is always 0
+    VkPipelineRenderingCreateInfoKHR rtInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR };
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, &rtInfo };
+    libInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+
+    VkPipelineShaderStageCreateInfo stageInfo = module.stageInfo(nullptr);
+
+    // Multisample state is provided by the fragment output library,
+    // which is fine since we do not support sample rate shading here
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, &libInfo };
+    info.flags                    = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    info.stageCount               = module ? 1 : 0;
+    info.pStages                  = module ? &stageInfo : nullptr;
+    info.pDepthStencilState       = &dsInfo;
+    info.pDynamicState            = &dyInfo;
+    info.layout                   = m_layout->getPipelineLayout(true);
+    info.basePipelineIndex        = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    if (vk->vkCreateGraphicsPipelines(vk->device(), m_cache->handle(), 1, &info, nullptr, &pipeline))
+      return VK_NULL_HANDLE;
+
+    return pipeline;
+  }
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <list>
+#include <unordered_map>
 #include <vector>
 
 #include "dxvk_include.h"
@@ -10,9 +13,15 @@
 #include "../spirv/spirv_code_buffer.h"
 #include "../spirv/spirv_compression.h"
 
+#include "../util/util_hash128.h"
+#include "../util/util_time.h"
+
 namespace dxvk {
   
+  class DxvkDevice;
+  class DxvkPipelineCache;
   class DxvkShader;
+  class DxvkShaderCache;
   class DxvkShaderModule;
   
   /**
@@ -28,6 +37,10 @@ namespace dxvk {
     /// Special constant ranges that do not count
     /// towards the spec constant min/max values
     ColorComponentMappings      = DxvkLimits::MaxNumSpecConstants,
+    /// Set to 1 in optimized pipelines only. Shaders that
+    /// use this must read all pipeline spec constant values
+    /// from a uniform buffer if it is 0.
+    SpecConstantsOptimized      = ColorComponentMappings + DxvkLimits::MaxNumRenderTargets,
   };
 
   /**
@@ -41,6 +54,7 @@ namespace dxvk {
     HasTransformFeedback,
     ExportsStencilRef,
     ExportsViewportIndexLayerFromVertexStage,
+    HasSpecConstantFallback,
   };
 
   using DxvkShaderFlags = Flags<DxvkShaderFlag>;
@@ -70,12 +84,101 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Shader cache entry location
+   *
+   * Locates a shader within the shader cache file,
+   * so that its code can be read back on demand. The
+   * options and code hashes are used to verify that
+   * the entry still belongs to the shader on reload.
+   */
+  struct DxvkShaderCacheLocation {
+    Hash128   hash;
+    Hash128   codeHash;
+    Sha1Hash  optionsHash;
+    uint64_t  offset = 0;
+    uint32_t  size   = 0;
+  };
+
+
   /**
    * \brief Shader module create info
    */
   struct DxvkShaderModuleCreateInfo {
     bool      fsDualSrcBlend  = false;
     uint32_t  undefinedInputs = 0;
+    uint32_t  unusedOutputs   = 0;
+  };
+
+
+  /**
+   * \brief Decompressed shader code cache
+   *
+   * Keeps the decompressed code of the most recently
+   * used shaders around, so that compiling many pipelines
+   * with the same shader does not decompress it each time.
+   * The total size of all cached code is bounded.
+   */
+  class DxvkShaderCodeCache {
+    /// Maximum size of all cached code, in bytes
+    constexpr static size_t MaxCacheSize = 16 << 20;
+  public:
+
+    DxvkShaderCodeCache();
+
+    ~DxvkShaderCodeCache();
+
+    /**
+     * \brief Looks up cached code for a shader
+     *
+     * \param [in] shader The shader
+     * \param [out] code Copy of the cached code
+     * \returns \c true if the code was cached
+     */
+    bool lookup(
+      const DxvkShader*               shader,
+            SpirvCodeBuffer&          code);
+
+    /**
+     * \brief Adds code for a shader to the cache
+     *
+     * Evicts the least recently used
+     * entries if the cache is full.
+     * \param [in] shader The shader
+     * \param [in] code Decompressed code
+     */
+    void insert(
+      const DxvkShader*               shader,
+      const SpirvCodeBuffer&          code);
+
+    /**
+     * \brief Removes a shader from the cache
+     *
+     * Must be called when the shader is destroyed.
+     * \param [in] shader The shader
+     */
+    void evict(
+      const DxvkShader*               shader);
+
+  private:
+
+    struct Entry;
+
+    using LruList = std::list<const DxvkShader*>;
+
+    struct Entry {
+      SpirvCodeBuffer   code;
+      LruList::iterator lruPos;
+    };
+
+    dxvk::mutex                                   m_mutex;
+    std::unordered_map<const DxvkShader*, Entry>  m_entries;
+    LruList                                       m_lru;
+    size_t                                        m_size = 0;
+
+    void evictEntry(
+      const DxvkShader*               shader);
+
   };
   
   
@@ -121,6 +224,17 @@ namespace dxvk {
       return m_bindings;
     }
     
+    /**
+     * \brief Retrieves SPIR-V code
+     *
+     * Returns the code without any binding
+     * remapping applied to it. If evicted code
+     * cannot be reloaded from the shader cache,
+     * this returns an empty code buffer.
+     * \returns Decompressed SPIR-V code
+     */
+    SpirvCodeBuffer getRawCode() const;
+
     /**
      * \brief Creates a shader module
      *
@@ -136,6 +250,56 @@ namespace dxvk {
       const DxvkBindingLayoutObjects*   layout,
       const DxvkShaderModuleCreateInfo& info);
 
+    /**
+     * \brief Checks whether a pipeline library can be created
+     *
+     * Pipeline libraries are only supported for vertex and
+     * fragment shaders that do not use push constants, and
+     * that do not depend on any pipeline state other than
+     * dynamic state when compiled.
+     * \returns \c true if a pipeline library can be created
+     */
+    bool canUsePipelineLibrary() const;
+
+    /**
+     * \brief Sets shader cache location
+     *
+     * Called by the shader cache once the shader has
+     * been written to or read from the cache file. The
+     * SPIR-V code of such shaders may be evicted from
+     * memory while unused, and gets reloaded from the
+     * cache file the next time a pipeline needs it.
+     * \param [in] cache The shader cache
+     * \param [in] location Entry location
+     */
+    void setCacheLocation(
+            DxvkShaderCache*            cache,
+      const DxvkShaderCacheLocation&    location);
+
+    /**
+     * \brief Evicts SPIR-V code if unused
+     *
+     * Frees the compressed code if it has not been
+     * needed since the given point in time. Does
+     * nothing if the code cannot be reloaded, or if
+     * another thread is currently accessing it.
+     * \param [in] deadline Time of the last use
+     * \returns \c true if the code was evicted
+     */
+    bool evictCode(
+            high_resolution_clock::time_point deadline);
+
+    /**
+     * \brief Releases uniform buffer data
+     *
+     * Front-ends copy the immediate constant data into
+     * a buffer right after creating the shader, so the
+     * copy stored here is not needed anymore afterwards.
+     * Must not be called before the shader has been
+     * added to the shader cache.
+     */
+    void releaseUniformData();
+
     /**
      * \brief Dumps SPIR-V shader
      * 
@@ -201,8 +365,18 @@ namespace dxvk {
       uint32_t setOffset;
     };
 
+    static DxvkShaderCodeCache    s_codeCache;
+
     DxvkShaderCreateInfo          m_info;
-    SpirvCompressedBuffer         m_code;
+
+    mutable dxvk::mutex           m_codeMutex;
+    mutable SpirvCompressedBuffer m_code;
+    mutable bool                  m_codeEvicted = false;
+    mutable bool                  m_codeLost    = false;
+    mutable std::atomic<int64_t>  m_codeLastUse = { 0 };
+
+    DxvkShaderCache*              m_cache = nullptr;
+    DxvkShaderCacheLocation       m_cacheLocation;
     
     DxvkShaderFlags               m_flags;
     DxvkShaderKey                 m_key;
@@ -216,7 +390,13 @@ namespace dxvk {
 
     DxvkBindingLayout             m_bindings;
 
-    static void eliminateInput(SpirvCodeBuffer& code, uint32_t location);
+    static void eliminateVariable(
+            SpirvCodeBuffer&          code,
+            spv::StorageClass         storageClass,
+            uint32_t                  location);
+
+    static int64_t getTimestamp(
+            high_resolution_clock::time_point time);
 
   };
   
@@ -274,4 +454,68 @@ namespace dxvk {
     
   };
   
-}
\ No newline at end of file
+
+
+  /**
+   * \brief Shader pipeline library
+   *
+   * Stores a pre-compiled pre-rasterization or fragment
+   * shader pipeline library, which can be linked with
+   * vertex input and fragment output libraries in order
+   * to quickly create a usable graphics pipeline. All
+   * state that is part of the library is dynamic.
+   */
+  class DxvkShaderPipelineLibrary {
+
+  public:
+
+    DxvkShaderPipelineLibrary(
+      const DxvkDevice*               device,
+      const DxvkPipelineCache*        cache,
+      const Rc<DxvkShader>&           shader,
+      const DxvkBindingLayoutObjects* layout);
+
+    ~DxvkShaderPipelineLibrary();
+
+    /**
+     * \brief Queries pipeline handle
+     *
+     * Compiles the pipeline library if it has
+     * not been compiled yet. This may stall if
+     * a compiler thread is currently compiling
+     * the library.
+     * \returns Pipeline handle
+     */
+    VkPipeline getPipelineHandle();
+
+    /**
+     * \brief Compiles the pipeline library
+     *
+     * Does nothing if the library has already
+     * been compiled. Use this to compile the
+     * library on a worker thread.
+     */
+    void compilePipeline();
+
+  private:
+
+    const DxvkDevice*               m_device;
+    const DxvkPipelineCache*        m_cache;
+    Rc<DxvkShader>                  m_shader;
+    const DxvkBindingLayoutObjects* m_layout;
+
+    dxvk::mutex                     m_mutex;
+    VkPipeline                      m_pipeline  = VK_NULL_HANDLE;
+    bool                            m_compiled  = false;
+
+    VkPipeline compileShaderPipeline();
+
+    VkPipeline compileVertexShaderPipeline(
+      const DxvkShaderModule&         module);
+
+    VkPipeline compileFragmentShaderPipeline(
+      const DxvkShaderModule&         module);
+
+  };
+  
+}
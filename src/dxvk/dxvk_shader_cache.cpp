@@ -0,0 +1,566 @@
+#include <cstring>
+
+#include <version.h>
+
+#include "dxvk_device.h"
+#include "dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Packed shader info
+   *
+   * Fixed-size part of a shader cache entry. Only
+   * contains 32-bit members so that it has no padding.
+   */
+  struct DxvkShaderCacheEntryInfo {
+    VkShaderStageFlagBits stage;
+    uint32_t              bindingCount;
+    uint32_t              inputMask;
+    uint32_t              outputMask;
+    uint32_t              pushConstOffset;
+    uint32_t              pushConstSize;
+    uint32_t              uniformSize;
+    int32_t               xfbRasterizedStream;
+    uint32_t              xfbStrides[MaxNumXfbBuffers];
+    uint32_t              codeDwords;
+  };
+
+
+  /**
+   * \brief Entry data reader
+   */
+  class DxvkShaderCacheReader {
+
+  public:
+
+    DxvkShaderCacheReader(const char* data, size_t size)
+    : m_data(data), m_size(size) { }
+
+    bool read(void* dst, size_t size) {
+      if (m_read + size > m_size)
+        return false;
+
+      std::memcpy(dst, &m_data[m_read], size);
+      m_read += size;
+      return true;
+    }
+
+    template<typename T>
+    bool read(T& data) {
+      return read(&data, sizeof(data));
+    }
+
+    const char* skip(size_t size) {
+      if (m_read + size > m_size)
+        return nullptr;
+
+      const char* result = &m_data[m_read];
+      m_read += size;
+      return result;
+    }
+
+  private:
+
+    const char* m_data;
+    size_t      m_size;
+    size_t      m_read = 0;
+
+  };
+
+
+  template<typename T>
+  void appendShaderCacheData(std::vector<char>& data, const T* src, size_t count) {
+    auto bytes = reinterpret_cast<const char*>(src);
+    data.insert(data.end(), bytes, bytes + sizeof(T) * count);
+  }
+
+
+  DxvkShaderCache::DxvkShaderCache(DxvkDevice* device) {
+    std::string useShaderCache = env::getEnvVar("DXVK_SHADER_CACHE");
+
+    m_enabled = useShaderCache != "0"
+      && device->config().enableShaderCache;
+
+    if (!m_enabled)
+      return;
+
+    DxvkShaderCacheHeader header;
+    header.build = Sha1Hash::compute(DXVK_VERSION, std::strlen(DXVK_VERSION));
+
+    if (!readCacheFile(header))
+      createCacheFile(header);
+
+    if (m_file) {
+      m_reader.open(getCacheFileName().c_str(),
+        std::ios_base::binary);
+    }
+
+    if (!m_file || !m_reader) {
+      Logger::warn("DXVK: Failed to open shader cache file");
+      m_enabled = false;
+    }
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::findShader(
+    const DxvkShaderKey&        key,
+    const Sha1Hash&             optionsHash) {
+    if (!m_enabled)
+      return nullptr;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto entry = m_entries.find(key);
+
+    if (entry == m_entries.end()
+     || entry->second.optionsHash != optionsHash)
+      return nullptr;
+
+    std::vector<char> data;
+    Rc<DxvkShader> shader;
+
+    if (readEntry(entry->second.location, data))
+      shader = decodeShader(key, data);
+
+    if (shader == nullptr) {
+      Logger::warn(str::format("DXVK: Invalid shader cache entry for ", key.toString()));
+      m_entries.erase(entry);
+    } else {
+      setCodeLocation(entry->second.location, data);
+      addShaderLocation(shader, entry->second.location);
+    }
+
+    return shader;
+  }
+
+
+  std::vector<Rc<DxvkShader>> DxvkShaderCache::findShaders(
+    const Sha1Hash&             optionsHash) {
+    std::vector<Rc<DxvkShader>> result;
+
+    if (!m_enabled)
+      return result;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    for (auto entry = m_entries.begin(); entry != m_entries.end(); ) {
+      if (entry->second.optionsHash != optionsHash) {
+        entry++;
+        continue;
+      }
+
+      std::vector<char> data;
+      Rc<DxvkShader> shader;
+
+      if (readEntry(entry->second.location, data))
+        shader = decodeShader(entry->first, data);
+
+      if (shader == nullptr) {
+        Logger::warn(str::format("DXVK: Invalid shader cache entry for ", entry->first.toString()));
+        entry = m_entries.erase(entry);
+      } else {
+        setCodeLocation(entry->second.location, data);
+        addShaderLocation(shader, entry->second.location);
+        result.push_back(std::move(shader));
+        entry++;
+      }
+    }
+
+    return result;
+  }
+
+
+  void DxvkShaderCache::addShader(
+    const Rc<DxvkShader>&       shader,
+    const Sha1Hash&             optionsHash) {
+    if (!m_enabled)
+      return;
+
+    std::vector<char> data = encodeShader(shader, optionsHash);
+
+    // General layout: size -> hash -> data
+    uint32_t size = uint32_t(data.size());
+    Hash128 hash = Hash128::compute(data.data(), data.size());
+
+    DxvkShaderCacheLocation location;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      m_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      m_file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+      m_file.write(data.data(), data.size());
+      m_file.flush();
+
+      // Don't record entries that may not be in the file
+      if (!m_file)
+        return;
+
+      location.hash   = hash;
+      location.offset = m_fileSize + sizeof(size) + sizeof(hash);
+      location.size   = size;
+      setCodeLocation(location, data);
+
+      m_fileSize = location.offset + size;
+
+      Entry& entry = m_entries[shader->getShaderKey()];
+      entry.optionsHash = optionsHash;
+      entry.location    = location;
+    }
+
+    // Shader code may be accessed by other threads already,
+    // and reloading code requires the shader cache lock
+    addShaderLocation(shader, location);
+  }
+
+
+  bool DxvkShaderCache::loadCode(
+    const DxvkShaderKey&        key,
+    const DxvkShaderCacheLocation& location,
+          SpirvCodeBuffer&      code) {
+    std::vector<char> data;
+    bool valid;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      valid = readEntry(location, data);
+    }
+
+    DxvkShaderKey entryKey;
+    Sha1Hash optionsHash;
+    size_t codeOffset = 0;
+    size_t codeSize = 0;
+
+    // The entry hash only guards against corruption, also make
+    // sure that the entry is actually the one we wrote or read
+    valid = valid
+      && parseEntry(data, entryKey, optionsHash, codeOffset, codeSize)
+      && entryKey.eq(key)
+      && optionsHash == location.optionsHash
+      && location.codeHash == Hash128::compute(data.data() + codeOffset, codeSize);
+
+    if (!valid) {
+      // Code of other shaders is likely gone as well,
+      // so do not make the problem any worse
+      if (m_evictCode.exchange(false))
+        Logger::err("DXVK: Shader cache file changed, disabling shader code eviction");
+
+      return false;
+    }
+
+    code = SpirvCodeBuffer(codeSize / sizeof(uint32_t));
+    std::memcpy(code.data(), data.data() + codeOffset, codeSize);
+    return true;
+  }
+
+
+  void DxvkShaderCache::removeShader(
+          DxvkShader*           shader) {
+    std::lock_guard<dxvk::mutex> lock(m_shaderMutex);
+    m_shaders.erase(shader);
+  }
+
+
+  void DxvkShaderCache::trimShaderCode() {
+    if (!m_enabled || !m_evictCode.load())
+      return;
+
+    auto now = high_resolution_clock::now();
+
+    std::lock_guard<dxvk::mutex> lock(m_shaderMutex);
+
+    if (now - m_lastTrim < TrimInterval)
+      return;
+
+    m_lastTrim = now;
+
+    for (auto shader : m_shaders)
+      shader->evictCode(now - MaxCodeIdleTime);
+  }
+
+
+  void DxvkShaderCache::addShaderLocation(
+    const Rc<DxvkShader>&       shader,
+    const DxvkShaderCacheLocation& location) {
+    shader->setCacheLocation(this, location);
+
+    std::lock_guard<dxvk::mutex> lock(m_shaderMutex);
+    m_shaders.insert(shader.ptr());
+  }
+
+
+  bool DxvkShaderCache::readCacheFile(
+    const DxvkShaderCacheHeader&  expected) {
+    std::ifstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::ate);
+
+    if (!file)
+      return false;
+
+    std::streamoff fileSize = file.tellg();
+    std::vector<char> fileData(fileSize > 0 ? size_t(fileSize) : 0);
+
+    file.seekg(0, std::ios_base::beg);
+
+    if (fileSize <= 0 || !file.read(fileData.data(), fileData.size()))
+      return false;
+
+    file.close();
+
+    DxvkShaderCacheReader reader(fileData.data(), fileData.size());
+    DxvkShaderCacheHeader header;
+
+    if (!reader.read(header)
+     || std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+     || header.version != expected.version
+     || header.build != expected.build) {
+      Logger::warn("DXVK: Shader cache outdated, discarding");
+      return false;
+    }
+
+    // Later entries for the same key replace earlier ones,
+    // which happens if translation options have changed
+    uint32_t numInvalidEntries = 0;
+
+    while (true) {
+      uint32_t size;
+      Hash128 hash;
+
+      if (!reader.read(size) || !reader.read(hash))
+        break;
+
+      const char* data = reader.skip(size);
+
+      if (!data)
+        break;
+
+      if (hash != Hash128::compute(data, size) || size < sizeof(DxvkShaderKey) + sizeof(Sha1Hash)) {
+        numInvalidEntries += 1;
+        continue;
+      }
+
+      DxvkShaderCacheReader entryReader(data, size);
+
+      DxvkShaderKey key;
+      Entry entry;
+
+      entryReader.read(key);
+      entryReader.read(entry.optionsHash);
+
+      entry.location.hash   = hash;
+      entry.location.offset = uint64_t(data - fileData.data());
+      entry.location.size   = size;
+      m_entries[key] = entry;
+    }
+
+    m_fileSize = uint64_t(fileSize);
+
+    Logger::info(str::format("DXVK: Read ", m_entries.size(), " shader cache entries"));
+
+    if (numInvalidEntries) {
+      Logger::warn(str::format("DXVK: Skipped ",
+        numInvalidEntries, " invalid shader cache entries"));
+    }
+
+    m_file.open(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::app);
+    return true;
+  }
+
+
+  void DxvkShaderCache::createCacheFile(
+    const DxvkShaderCacheHeader&  header) {
+    Logger::info("DXVK: Creating new shader cache file");
+
+    m_entries.clear();
+
+    m_file.open(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!m_file && env::createDirectory(getCacheDir())) {
+      m_file.open(getCacheFileName().c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.flush();
+
+    m_fileSize = sizeof(header);
+  }
+
+
+  bool DxvkShaderCache::readEntry(
+    const DxvkShaderCacheLocation& location,
+          std::vector<char>&    data) {
+    // The file may have grown since the last read,
+    // so reset the end-of-file state before seeking
+    m_reader.clear();
+    m_reader.seekg(std::streamoff(location.offset), std::ios_base::beg);
+
+    data.resize(location.size);
+
+    if (!m_reader.read(data.data(), data.size()))
+      return false;
+
+    // Guard against the file having been modified
+    // or truncated by another process in the meantime
+    return location.hash == Hash128::compute(data.data(), data.size());
+  }
+
+
+  bool DxvkShaderCache::parseEntry(
+    const std::vector<char>&    data,
+          DxvkShaderKey&        key,
+          Sha1Hash&             optionsHash,
+          size_t&               codeOffset,
+          size_t&               codeSize) {
+    DxvkShaderCacheReader reader(data.data(), data.size());
+    DxvkShaderCacheEntryInfo info;
+
+    if (!reader.read(key)
+     || !reader.read(optionsHash)
+     || !reader.read(info)
+     || !reader.skip(sizeof(DxvkBindingInfo) * info.bindingCount)
+     || !reader.skip(info.uniformSize))
+      return false;
+
+    const char* code = reader.skip(sizeof(uint32_t) * info.codeDwords);
+
+    if (!code)
+      return false;
+
+    codeOffset = size_t(code - data.data());
+    codeSize = sizeof(uint32_t) * info.codeDwords;
+    return true;
+  }
+
+
+  void DxvkShaderCache::setCodeLocation(
+          DxvkShaderCacheLocation& location,
+    const std::vector<char>&    data) {
+    DxvkShaderKey key;
+    size_t codeOffset = 0;
+    size_t codeSize = 0;
+
+    if (parseEntry(data, key, location.optionsHash, codeOffset, codeSize))
+      location.codeHash = Hash128::compute(data.data() + codeOffset, codeSize);
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::decodeShader(
+    const DxvkShaderKey&        key,
+    const std::vector<char>&    data) {
+    DxvkShaderCacheReader reader(data.data(), data.size());
+
+    DxvkShaderKey entryKey;
+    Sha1Hash optionsHash;
+    DxvkShaderCacheEntryInfo info;
+
+    if (!reader.read(entryKey)
+     || !reader.read(optionsHash)
+     || !reader.read(info))
+      return nullptr;
+
+    std::vector<DxvkBindingInfo> bindings(info.bindingCount);
+    std::vector<char> uniformData(info.uniformSize);
+
+    if (!reader.read(bindings.data(), sizeof(DxvkBindingInfo) * bindings.size())
+     || !reader.read(uniformData.data(), uniformData.size()))
+      return nullptr;
+
+    SpirvCodeBuffer code(info.codeDwords);
+
+    if (!reader.read(code.data(), code.size()))
+      return nullptr;
+
+    DxvkShaderCreateInfo createInfo;
+    createInfo.stage = info.stage;
+    createInfo.bindingCount = bindings.size();
+    createInfo.bindings = bindings.data();
+    createInfo.inputMask = info.inputMask;
+    createInfo.outputMask = info.outputMask;
+    createInfo.pushConstOffset = info.pushConstOffset;
+    createInfo.pushConstSize = info.pushConstSize;
+    createInfo.uniformSize = uniformData.size();
+    createInfo.uniformData = uniformData.data();
+    createInfo.xfbRasterizedStream = info.xfbRasterizedStream;
+
+    for (uint32_t i = 0; i < MaxNumXfbBuffers; i++)
+      createInfo.xfbStrides[i] = info.xfbStrides[i];
+
+    Rc<DxvkShader> shader = new DxvkShader(createInfo, std::move(code));
+    shader->setShaderKey(key);
+    return shader;
+  }
+
+
+  std::vector<char> DxvkShaderCache::encodeShader(
+    const Rc<DxvkShader>&       shader,
+    const Sha1Hash&             optionsHash) {
+    const DxvkShaderCreateInfo& createInfo = shader->info();
+    const DxvkBindingLayout& layout = shader->getBindings();
+
+    // Bindings are stored per set in the order in which they
+    // were added, so adding them again in set order results
+    // in an identical binding layout.
+    std::vector<DxvkBindingInfo> bindings;
+
+    for (uint32_t i = 0; i < DxvkDescriptorSets::SetCount; i++) {
+      for (uint32_t j = 0; j < layout.getBindingCount(i); j++)
+        bindings.push_back(layout.getBinding(i, j));
+    }
+
+    SpirvCodeBuffer code = shader->getRawCode();
+
+    DxvkShaderCacheEntryInfo info;
+    info.stage = createInfo.stage;
+    info.bindingCount = bindings.size();
+    info.inputMask = createInfo.inputMask;
+    info.outputMask = createInfo.outputMask;
+    info.pushConstOffset = createInfo.pushConstOffset;
+    info.pushConstSize = createInfo.pushConstSize;
+    info.uniformSize = createInfo.uniformSize;
+    info.xfbRasterizedStream = createInfo.xfbRasterizedStream;
+    info.codeDwords = code.dwords();
+
+    for (uint32_t i = 0; i < MaxNumXfbBuffers; i++)
+      info.xfbStrides[i] = createInfo.xfbStrides[i];
+
+    DxvkShaderKey key = shader->getShaderKey();
+
+    std::vector<char> data;
+    appendShaderCacheData(data, &key, 1);
+    appendShaderCacheData(data, &optionsHash, 1);
+    appendShaderCacheData(data, &info, 1);
+    appendShaderCacheData(data, bindings.data(), bindings.size());
+    appendShaderCacheData(data, createInfo.uniformData, createInfo.uniformSize);
+    appendShaderCacheData(data, code.data(), code.dwords());
+    return data;
+  }
+
+
+  std::wstring DxvkShaderCache::getCacheFileName() {
+    std::string path = getCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    std::string exeName = env::getExeBaseName();
+    path += exeName + ".dxvk-shaders";
+    return str::tows(path.c_str());
+  }
+
+
+  std::string DxvkShaderCache::getCacheDir() {
+    return env::getEnvVar("DXVK_STATE_CACHE_PATH");
+  }
+
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dxvk_shader.h"
+
+#include "../util/util_hash128.h"
+
+#include "../util/sha1/sha1_util.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Shader cache file header
+   *
+   * Stores the file format version as well as a hash
+   * of the DXVK version string, since the generated
+   * SPIR-V depends on the shader compiler and must
+   * be discarded whenever the compiler changes.
+   * Entries are checked for corruption using a
+   * fast 128-bit hash.
+   */
+  struct DxvkShaderCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'S', 'C' };
+    uint32_t version    = 4;
+    Sha1Hash build;
+  };
+
+
+  /**
+   * \brief Persistent shader cache
+   *
+   * Stores translated SPIR-V shaders along with all the
+   * metadata needed to recreate the \c DxvkShader object,
+   * so that front-ends can skip translating the original
+   * shader bytecode on subsequent runs. Entries are keyed
+   * by the shader key and a hash of all front-end options
+   * that affect shader translation. Only the location
+   * of each entry within the cache file is kept in
+   * memory, entry data is read back on demand. This
+   * class is thread-safe.
+   *
+   * The SPIR-V code of cached shaders that have not
+   * been used to compile pipelines in a while gets
+   * evicted from memory and reloaded from the file.
+   */
+  class DxvkShaderCache {
+    /// Time after which unused shader code gets evicted
+    constexpr static auto MaxCodeIdleTime = std::chrono::seconds(30);
+    /// Minimum interval between shader code eviction passes
+    constexpr static auto TrimInterval = std::chrono::seconds(1);
+
+  public:
+
+    DxvkShaderCache(DxvkDevice* device);
+
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] key Shader key
+     * \param [in] optionsHash Hash of translation options
+     * \returns The shader, or \c nullptr if not found
+     */
+    Rc<DxvkShader> findShader(
+      const DxvkShaderKey&        key,
+      const Sha1Hash&             optionsHash);
+
+    /**
+     * \brief Looks up all shaders with the given options
+     *
+     * Lets front-ends that generate shaders themselves
+     * register previously generated shaders with the
+     * device before the shaders are first needed.
+     * \param [in] optionsHash Hash of translation options
+     * \returns All shaders created with these options
+     */
+    std::vector<Rc<DxvkShader>> findShaders(
+      const Sha1Hash&             optionsHash);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * The shader key must be set. The shader gets
+     * written to the cache file immediately.
+     * \param [in] shader The shader
+     * \param [in] optionsHash Hash of translation options
+     */
+    void addShader(
+      const Rc<DxvkShader>&       shader,
+      const Sha1Hash&             optionsHash);
+
+    /**
+     * \brief Reads shader code from the cache file
+     *
+     * Verifies that the entry at the given location still
+     * belongs to the shader, since the file may have been
+     * rewritten by another process. Stops evicting shader
+     * code if that is not the case.
+     * \param [in] key Shader key
+     * \param [in] location Entry location
+     * \param [out] code Shader code
+     * \returns \c true on success
+     */
+    bool loadCode(
+      const DxvkShaderKey&        key,
+      const DxvkShaderCacheLocation& location,
+            SpirvCodeBuffer&      code);
+
+    /**
+     * \brief Unregisters a shader
+     *
+     * Called when a shader with a cache
+     * location gets destroyed.
+     * \param [in] shader The shader
+     */
+    void removeShader(
+            DxvkShader*           shader);
+
+    /**
+     * \brief Evicts code of idle shaders
+     *
+     * Called periodically. Frees the SPIR-V code of
+     * cached shaders that have not been used in a
+     * while, since it can be read back from the file.
+     */
+    void trimShaderCode();
+
+  private:
+
+    struct Entry {
+      Sha1Hash                optionsHash;
+      DxvkShaderCacheLocation location;
+    };
+
+    bool              m_enabled = false;
+    std::atomic<bool> m_evictCode = { true };
+
+    dxvk::mutex       m_mutex;
+    std::ofstream     m_file;
+    std::ifstream     m_reader;
+    uint64_t          m_fileSize = 0;
+
+    dxvk::mutex                       m_shaderMutex;
+    std::unordered_set<DxvkShader*>   m_shaders;
+    high_resolution_clock::time_point m_lastTrim = high_resolution_clock::now();
+
+    std::unordered_map<
+      DxvkShaderKey, Entry,
+      DxvkHash, DxvkEq> m_entries;
+
+    bool readCacheFile(
+      const DxvkShaderCacheHeader&  expected);
+
+    void createCacheFile(
+      const DxvkShaderCacheHeader&  header);
+
+    bool readEntry(
+      const DxvkShaderCacheLocation& location,
+            std::vector<char>&    data);
+
+    void addShaderLocation(
+      const Rc<DxvkShader>&       shader,
+      const DxvkShaderCacheLocation& location);
+
+    static bool parseEntry(
+      const std::vector<char>&    data,
+            DxvkShaderKey&        key,
+            Sha1Hash&             optionsHash,
+            size_t&               codeOffset,
+            size_t&               codeSize);
+
+    static void setCodeLocation(
+            DxvkShaderCacheLocation& location,
+      const std::vector<char>&    data);
+
+    static Rc<DxvkShader> decodeShader(
+      const DxvkShaderKey&        key,
+      const std::vector<char>&    data);
+
+    static std::vector<char> encodeShader(
+      const Rc<DxvkShader>&       shader,
+      const Sha1Hash&             optionsHash);
+
+    static std::wstring getCacheFileName();
+
+    static std::string getCacheDir();
+
+  };
+
+}
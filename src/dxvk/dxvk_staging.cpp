@@ -2,21 +2,60 @@
 #include "dxvk_staging.h"
 
 namespace dxvk {
-  
-  DxvkStagingBuffer::DxvkStagingBuffer(
-    const Rc<DxvkDevice>&     device,
-          VkDeviceSize        size)
-  : m_device(device), m_offset(0), m_size(size) {
+
+  DxvkStagingPool::DxvkStagingPool(DxvkDevice* device)
+  : m_device(device) {
 
   }
 
 
-  DxvkStagingBuffer::~DxvkStagingBuffer() {
+  DxvkStagingPool::~DxvkStagingPool() {
 
   }
 
 
-  DxvkBufferSlice DxvkStagingBuffer::alloc(VkDeviceSize align, VkDeviceSize size) {
+  Rc<DxvkBuffer> DxvkStagingPool::alloc(VkDeviceSize size) {
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      auto now = dxvk::high_resolution_clock::now();
+      auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(now - m_intervalStart);
+
+      // Adjust the amount of idle memory to retain to
+      // the staging traffic observed in the last interval
+      if (ticks.count() >= BudgetInterval) {
+        m_budget = m_intervalBytes;
+        m_intervalBytes = 0;
+        m_intervalStart = now;
+      }
+
+      m_intervalBytes += size;
+
+      Rc<DxvkBuffer> result;
+      VkDeviceSize idleBytes = 0;
+
+      for (size_t i = 0; i < m_buffers.size(); ) {
+        if (!m_buffers[i]->isUniquelyReferenced()) {
+          i += 1;
+          continue;
+        }
+
+        VkDeviceSize bufferSize = m_buffers[i]->info().size;
+
+        if (result == nullptr && bufferSize == size) {
+          result = m_buffers[i++];
+        } else if (idleBytes + bufferSize > m_budget) {
+          m_buffers[i] = std::move(m_buffers.back());
+          m_buffers.pop_back();
+        } else {
+          idleBytes += bufferSize;
+          i += 1;
+        }
+      }
+
+      if (result != nullptr)
+        return result;
+    }
+
     DxvkBufferCreateInfo info;
     info.size   = size;
     info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
@@ -27,23 +66,59 @@ namespace dxvk {
                 | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     info.access = VK_ACCESS_TRANSFER_READ_BIT
                 | VK_ACCESS_SHADER_READ_BIT;
+    info.category = DxvkMemoryCategory::Staging;
+
+    Rc<DxvkBuffer> buffer = m_device->createBuffer(info,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_buffers.push_back(buffer);
+    return buffer;
+  }
+
+
+  DxvkStagingStats DxvkStagingPool::getStats() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
 
+    DxvkStagingStats result;
+
+    for (const auto& buffer : m_buffers) {
+      VkDeviceSize size = buffer->info().size;
+      result.memoryAllocated += size;
+
+      if (!buffer->isUniquelyReferenced())
+        result.memoryUsed += size;
+    }
+
+    return result;
+  }
+
+  
+  DxvkStagingBuffer::DxvkStagingBuffer(
+    const Rc<DxvkDevice>&     device,
+          VkDeviceSize        size)
+  : m_device(device), m_offset(0), m_size(size) {
+
+  }
+
+
+  DxvkStagingBuffer::~DxvkStagingBuffer() {
+
+  }
+
+
+  DxvkBufferSlice DxvkStagingBuffer::alloc(VkDeviceSize align, VkDeviceSize size) {
     VkDeviceSize alignedSize = dxvk::align(size, align);
     VkDeviceSize alignedOffset = dxvk::align(m_offset, align);
 
-    if (2 * alignedSize > m_size) {
-      return DxvkBufferSlice(m_device->createBuffer(info,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-    }
+    if (2 * alignedSize > m_size)
+      return DxvkBufferSlice(m_device->allocStagingBuffer(size));
 
     if (alignedOffset + alignedSize > m_size || m_buffer == nullptr) {
-      info.size = m_size;
-
-      // Free resources first if possible, in some rare
-      // situations this may help avoid a memory allocation.
+      // Release the current buffer first so that the
+      // pool can hand it out again once it is idle.
       m_buffer = nullptr;
-      m_buffer = m_device->createBuffer(info,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      m_buffer = m_device->allocStagingBuffer(m_size);
       alignedOffset = 0;
     }
 
@@ -1,18 +1,80 @@
 #pragma once
 
-#include <queue>
+#include <vector>
 
 #include "dxvk_buffer.h"
 
+#include "../util/util_time.h"
+
 namespace dxvk {
   
   class DxvkDevice;
 
+  /**
+   * \brief Staging pool statistics
+   */
+  struct DxvkStagingStats {
+    VkDeviceSize memoryAllocated = 0;
+    VkDeviceSize memoryUsed      = 0;
+  };
+
+
+  /**
+   * \brief Staging buffer pool
+   *
+   * Device-wide pool of staging buffers shared by all
+   * staging buffer allocators. A buffer is recycled as
+   * soon as the pool holds the only reference to it,
+   * which means that it is neither referenced by any
+   * pending command nor by its previous owner. Memory
+   * of idle buffers is retained up to the amount of
+   * staging memory requested during the last interval.
+   */
+  class DxvkStagingPool {
+    /// Interval over which staging traffic is measured, in us
+    constexpr static int64_t BudgetInterval = 1'000'000;
+  public:
+
+    DxvkStagingPool(DxvkDevice* device);
+
+    ~DxvkStagingPool();
+
+    /**
+     * \brief Allocates a staging buffer
+     *
+     * \param [in] size Buffer size
+     * \returns Idle buffer of the given size
+     */
+    Rc<DxvkBuffer> alloc(VkDeviceSize size);
+
+    /**
+     * \brief Queries pool statistics
+     * \returns Allocated and used staging memory
+     */
+    DxvkStagingStats getStats();
+
+  private:
+
+    DxvkDevice*                 m_device;
+
+    dxvk::mutex                 m_mutex;
+    std::vector<Rc<DxvkBuffer>> m_buffers;
+
+    VkDeviceSize                m_intervalBytes = 0;
+    VkDeviceSize                m_budget        = 0;
+
+    dxvk::high_resolution_clock::time_point m_intervalStart
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief Staging buffer
    *
    * Provides a simple linear staging buffer
-   * allocator for data uploads.
+   * allocator for data uploads. Backing buffers
+   * are taken from the device's staging pool.
    */
   class DxvkStagingBuffer {
 
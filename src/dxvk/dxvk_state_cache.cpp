@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "dxvk_device.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
@@ -84,6 +86,14 @@ namespace dxvk {
       return read(data);
     }
 
+    bool read(DxvkStateCacheFallbacks& data, uint32_t version) {
+      // v14 introduced this field
+      if (version < 14)
+        return true;
+
+      return read(data);
+    }
+
     bool read(DxvkIlBinding& data, uint32_t version) {
       if (version < 10) {
         DxvkIlBindingV9 v9;
@@ -176,6 +186,37 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief In-memory stream buffer
+   *
+   * Exposes a block of memory as a read-only stream
+   * buffer, so that the entire cache file can be read
+   * with a single read call and parsed from memory.
+   */
+  class DxvkStateCacheMemoryBuffer : public std::streambuf {
+
+  public:
+
+    DxvkStateCacheMemoryBuffer(char* data, size_t size) {
+      setg(data, data, data + size);
+    }
+
+  };
+
+
+  /**
+   * \brief Hash function for entry hashes
+   *
+   * Entry hashes are SHA-1 hashes, so any
+   * part of the digest is a good hash value.
+   */
+  struct DxvkStateCacheEntryHash {
+    size_t operator () (const Sha1Hash& hash) const {
+      return hash.dword(0);
+    }
+  };
+
+
   template<typename T>
   bool readCacheEntryTyped(std::istream& stream, T& entry) {
     auto data = reinterpret_cast<char*>(&entry);
@@ -216,41 +257,19 @@ namespace dxvk {
           DxvkDevice*           device,
           DxvkPipelineManager*  pipeManager)
   : m_device      (device),
-    m_pipeManager (pipeManager) {
-    bool newFile = !readCacheFile();
-
-    if (newFile) {
-      Logger::warn("DXVK: Creating new state cache file");
-
-      // Start with an empty file
-      std::ofstream file(getCacheFileName().c_str(),
-        std::ios_base::binary |
-        std::ios_base::trunc);
-
-      if (!file && env::createDirectory(getCacheDir())) {
-        file = std::ofstream(getCacheFileName().c_str(),
-          std::ios_base::binary |
-          std::ios_base::trunc);
-      }
-
-      // Write header with the current version number
-      DxvkStateCacheHeader header;
-
-      auto data = reinterpret_cast<const char*>(&header);
-      auto size = sizeof(header);
-
-      file.write(data, size);
-
-      // Write all valid entries to the cache file in
-      // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(file, e);
-    }
+    m_pipeManager (pipeManager),
+    m_shareEntries(device->config().shareStateCache),
+    m_localFallbacks(getLocalFallbacks()) {
+    // Load the cache file in the background so that
+    // the app can keep creating shaders in the meantime
+    m_loaderThread = dxvk::thread([this] () { loaderFunc(); });
   }
   
 
   DxvkStateCache::~DxvkStateCache() {
     this->stopWorkerThreads();
+    this->logEntryUsage();
+    this->writeUsageFile();
   }
 
 
@@ -261,20 +280,24 @@ namespace dxvk {
       return;
     
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+      auto entries = m_entryMap.equal_range(shaders);
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      const DxvkStateCacheEntry& entry = m_entries[e->second];
+      for (auto e = entries.first; e != entries.second; e++) {
+        const DxvkStateCacheEntry& entry = m_entries[e->second];
 
-      if (entry.gpState == state)
-        return;
+        if (entry.gpState == state) {
+          recordEntryUsage(e->second);
+          return;
+        }
+      }
     }
 
     // Queue a job to write this pipeline to the cache
     std::unique_lock<dxvk::mutex> lock(m_writerLock);
 
     m_writerQueue.push({ shaders, state,
-      DxvkComputePipelineStateInfo(), g_nullHash });
+      DxvkComputePipelineStateInfo(), g_nullHash, m_localFallbacks });
     m_writerCond.notify_one();
 
     createWriter();
@@ -288,11 +311,15 @@ namespace dxvk {
       return;
 
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+      auto entries = m_entryMap.equal_range(shaders);
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].cpState == state)
-        return;
+      for (auto e = entries.first; e != entries.second; e++) {
+        if (m_entries[e->second].cpState == state) {
+          recordEntryUsage(e->second);
+          return;
+        }
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -324,46 +351,45 @@ namespace dxvk {
     for (auto p = pipelines.first; p != pipelines.second; p++) {
       WorkerItem item;
 
-      if (!getShaderByKey(p->second.vs,  item.gp.vs)
-       || !getShaderByKey(p->second.tcs, item.gp.tcs)
-       || !getShaderByKey(p->second.tes, item.gp.tes)
-       || !getShaderByKey(p->second.gs,  item.gp.gs)
-       || !getShaderByKey(p->second.fs,  item.gp.fs)
-       || !getShaderByKey(p->second.cs,  item.cp.cs))
+      if (!getWorkerItem(p->second, item))
         continue;
-      
+
       if (!workerLock)
         workerLock = std::unique_lock<dxvk::mutex>(m_workerLock);
       
       m_workerQueue.push(item);
-    }
-
-    if (workerLock) {
-      m_workerCond.notify_all();
-      createWorkers();
+      submitCompileTask();
     }
   }
 
 
   void DxvkStateCache::stopWorkerThreads() {
-    { std::lock_guard<dxvk::mutex> workerLock(m_workerLock);
+    // Tasks on the worker thread pool are stopped by
+    // the pipeline manager before calling this method
+    { std::lock_guard<dxvk::mutex> loaderLock(m_loaderLock);
       std::lock_guard<dxvk::mutex> writerLock(m_writerLock);
 
       if (m_stopThreads.exchange(true))
         return;
 
-      m_workerCond.notify_all();
+      m_loaderCond.notify_all();
       m_writerCond.notify_all();
     }
 
-    for (auto& worker : m_workerThreads)
-      worker.join();
-    
+    if (m_loaderThread.joinable())
+      m_loaderThread.join();
+
     if (m_writerThread.joinable())
       m_writerThread.join();
   }
 
 
+  size_t DxvkStateCache::getPendingCount() {
+    std::lock_guard<dxvk::mutex> lock(m_workerLock);
+    return m_workerQueue.size();
+  }
+
+
   DxvkShaderKey DxvkStateCache::getShaderKey(const Rc<DxvkShader>& shader) const {
     return shader != nullptr ? shader->getShaderKey() : g_nullShaderKey;
   }
@@ -384,6 +410,22 @@ namespace dxvk {
   }
 
 
+  bool DxvkStateCache::getWorkerItem(
+    const DxvkStateCacheKey&        key,
+          WorkerItem&               item) const {
+    if (!getShaderByKey(key.vs,  item.gp.vs)
+     || !getShaderByKey(key.tcs, item.gp.tcs)
+     || !getShaderByKey(key.tes, item.gp.tes)
+     || !getShaderByKey(key.gs,  item.gp.gs)
+     || !getShaderByKey(key.fs,  item.gp.fs)
+     || !getShaderByKey(key.cs,  item.cp.cs))
+      return false;
+
+    item.priority = getPipelinePriority(key);
+    return true;
+  }
+
+
   void DxvkStateCache::mapPipelineToEntry(
     const DxvkStateCacheKey&        key,
           size_t                    entryId) {
@@ -399,6 +441,281 @@ namespace dxvk {
   }
 
 
+  size_t DxvkStateCache::getPipelinePriority(
+    const DxvkStateCacheKey&        key) const {
+    size_t result = ~size_t(0);
+
+    auto entries = m_entryMap.equal_range(key);
+
+    for (auto e = entries.first; e != entries.second; e++)
+      result = std::min(result, e->second);
+
+    return result;
+  }
+
+
+  void DxvkStateCache::recordEntryUsage(
+          size_t                    entryId) {
+    auto time = dxvk::high_resolution_clock::now();
+    auto us   = std::chrono::duration_cast<std::chrono::microseconds>(time - m_startTime);
+
+    EntryUsage& usage = m_entryUsage[entryId];
+
+    if (!usage.hitCount++)
+      usage.firstUse = uint64_t(us.count());
+  }
+
+
+  void DxvkStateCache::logEntryUsage() {
+    std::lock_guard<dxvk::mutex> lock(m_entryLock);
+
+    // A hit means that the game needed a cached pipeline
+    // before the background workers got to compile it
+    uint32_t entryCount = 0;
+    uint32_t earlyCount = 0;
+    uint32_t hitCount   = 0;
+
+    for (const auto& usage : m_entryUsage) {
+      if (!usage.hitCount)
+        continue;
+
+      entryCount += 1;
+      hitCount   += usage.hitCount;
+
+      if (usage.firstUse < 60'000'000ull)
+        earlyCount += 1;
+    }
+
+    if (entryCount) {
+      Logger::info(str::format("DXVK: ", entryCount,
+        " cached pipelines were needed before being compiled (",
+        earlyCount, " in the first minute, ", hitCount, " requests)"));
+    }
+  }
+
+
+  void DxvkStateCache::readUsageFile() {
+    std::unordered_map<Sha1Hash,
+      DxvkStateCacheUsageRecord,
+      DxvkStateCacheEntryHash> records;
+
+    { std::lock_guard<sync::FileLock> fileLock(*m_fileLock);
+
+      std::ifstream file(getUsageFileName().c_str(),
+        std::ios_base::binary);
+
+      DxvkStateCacheUsageHeader expected;
+      DxvkStateCacheUsageHeader header;
+
+      if (file && file.read(reinterpret_cast<char*>(&header), sizeof(header))
+       && !std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+       && header.version == expected.version) {
+        m_session = header.session + 1;
+
+        DxvkStateCacheUsageRecord record;
+
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+          // Specialized variants of the same entry share
+          // a hash, so keep the most recent usage info
+          auto entry = records.insert({ record.hash, record });
+
+          if (entry.first->second.lastSession < record.lastSession)
+            entry.first->second = record;
+        }
+      }
+    }
+
+    std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+    auto applyRecord = [&records] (const DxvkStateCacheEntry& entry, EntryUsage& usage) {
+      auto record = records.find(entry.hash);
+
+      if (record != records.end()) {
+        usage.lastSession = record->second.lastSession;
+        usage.totalHits   = record->second.hitCount;
+      }
+    };
+
+    for (size_t i = 0; i < m_entries.size(); i++)
+      applyRecord(m_entries[i], m_entryUsage[i]);
+
+    m_foreignUsage.resize(m_foreignEntries.size());
+
+    for (size_t i = 0; i < m_foreignEntries.size(); i++)
+      applyRecord(m_foreignEntries[i], m_foreignUsage[i]);
+  }
+
+
+  void DxvkStateCache::writeUsageFile() {
+    // The loader may have been stopped before
+    // usage info from the file was applied
+    if (!m_cacheLoaded.load())
+      return;
+
+    std::vector<DxvkStateCacheUsageRecord> records;
+
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+      auto getRecord = [this] (const DxvkStateCacheEntry& entry, const EntryUsage& usage) {
+        DxvkStateCacheUsageRecord record;
+        record.hash        = entry.hash;
+        record.lastSession = (usage.used || usage.hitCount || !usage.lastSession)
+          ? m_session : usage.lastSession;
+        record.hitCount    = usage.totalHits + usage.hitCount;
+        return record;
+      };
+
+      records.reserve(m_entries.size() + m_foreignEntries.size());
+
+      for (size_t i = 0; i < m_entries.size(); i++) {
+        if (!m_entryUsage[i].pruned)
+          records.push_back(getRecord(m_entries[i], m_entryUsage[i]));
+      }
+
+      for (size_t i = 0; i < m_foreignEntries.size(); i++)
+        records.push_back(getRecord(m_foreignEntries[i], m_foreignUsage[i]));
+    }
+
+    // If multiple processes share the cache, the last one to
+    // exit wins, which at worst delays pruning some entries
+    std::lock_guard<sync::FileLock> fileLock(*m_fileLock);
+
+    std::ofstream file(getUsageFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    DxvkStateCacheUsageHeader header;
+    header.session = m_session;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()),
+      sizeof(DxvkStateCacheUsageRecord) * records.size());
+  }
+
+
+  bool DxvkStateCache::pruneEntries() {
+    std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+    size_t entryCount = m_entries.size() + m_foreignEntries.size();
+
+    if (!entryCount)
+      return false;
+
+    // Entries without usage info were added recently. Entries
+    // used by another device cannot be checked here, so those
+    // are only removed in order to meet the size limit.
+    auto getLastSession = [this] (const EntryUsage& usage) {
+      return (usage.used || usage.hitCount || !usage.lastSession)
+        ? m_session : usage.lastSession;
+    };
+
+    struct Candidate {
+      size_t    index;
+      bool      foreign;
+      uint32_t  lastSession;
+      uint32_t  hitCount;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(entryCount);
+
+    size_t staleCount = 0;
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+      uint32_t lastSession = getLastSession(m_entryUsage[i]);
+
+      if (m_session - lastSession > MaxIdleSessions)
+        m_entryUsage[i].pruned = true;
+
+      if (m_entryUsage[i].pruned)
+        staleCount += 1;
+      else
+        candidates.push_back({ i, false, lastSession, m_entryUsage[i].totalHits });
+    }
+
+    for (size_t i = 0; i < m_foreignEntries.size(); i++)
+      candidates.push_back({ i, true, getLastSession(m_foreignUsage[i]), m_foreignUsage[i].totalHits });
+
+    // Estimate the number of entries that fit into the size
+    // limit based on the average entry size of the loaded file
+    size_t maxCount = candidates.size();
+
+    uint64_t maxSize = uint64_t(std::max(m_device->config().stateCacheMaxSize, 0)) << 20;
+
+    if (maxSize && m_fileSize > sizeof(DxvkStateCacheHeader)) {
+      uint64_t entrySize = std::max<uint64_t>(1,
+        (m_fileSize - sizeof(DxvkStateCacheHeader)) / entryCount);
+      maxCount = std::min<size_t>(maxCount, maxSize / entrySize);
+    }
+
+    if (staleCount * StaleEntryRatio < entryCount && maxCount == candidates.size()) {
+      // Not worth rewriting the file yet
+      for (size_t i = 0; i < m_entries.size(); i++)
+        m_entryUsage[i].pruned = false;
+
+      return false;
+    }
+
+    // Keep the most recently and most frequently used entries
+    std::stable_sort(candidates.begin(), candidates.end(),
+      [] (const Candidate& a, const Candidate& b) {
+        if (a.lastSession != b.lastSession)
+          return a.lastSession > b.lastSession;
+        return a.hitCount > b.hitCount;
+      });
+
+    std::vector<bool> keepForeign(m_foreignEntries.size(), false);
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+      const Candidate& c = candidates[i];
+
+      if (c.foreign)
+        keepForeign[c.index] = i < maxCount;
+      else if (i >= maxCount)
+        m_entryUsage[c.index].pruned = true;
+    }
+
+    // Pruned entries are no longer compiled, and get
+    // written back as new entries if the game uses them
+    size_t prunedCount = 0;
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+      if (!m_entryUsage[i].pruned)
+        continue;
+
+      auto range = m_entryMap.equal_range(m_entries[i].shaders);
+
+      for (auto e = range.first; e != range.second; e++) {
+        if (e->second == i) {
+          m_entryMap.erase(e);
+          break;
+        }
+      }
+
+      prunedCount += 1;
+    }
+
+    size_t foreignCount = 0;
+
+    for (size_t i = 0; i < m_foreignEntries.size(); i++) {
+      if (keepForeign[i]) {
+        m_foreignEntries[foreignCount] = m_foreignEntries[i];
+        m_foreignUsage[foreignCount] = m_foreignUsage[i];
+        foreignCount += 1;
+      }
+    }
+
+    prunedCount += m_foreignEntries.size() - foreignCount;
+
+    m_foreignEntries.resize(foreignCount);
+    m_foreignUsage.resize(foreignCount);
+
+    Logger::info(str::format("DXVK: Removing ", prunedCount,
+      " unused state cache entries (", staleCount, " stale)"));
+    return true;
+  }
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
     DxvkStateCacheKey key;
     key.vs  = getShaderKey(item.gp.vs);
@@ -408,35 +725,72 @@ namespace dxvk {
     key.fs  = getShaderKey(item.gp.fs);
     key.cs  = getShaderKey(item.cp.cs);
 
+    // Copy the state vectors since the loader may still
+    // be adding entries while we're compiling pipelines
+    std::vector<DxvkStateCacheEntry> entries;
+
+    { std::lock_guard<dxvk::mutex> lock(m_entryLock);
+      auto range = m_entryMap.equal_range(key);
+
+      for (auto e = range.first; e != range.second; e++) {
+        entries.push_back(m_entries[e->second]);
+
+        // All shaders of the entry exist, so the
+        // game still uses them in this session
+        m_entryUsage[e->second].used = true;
+      }
+    }
+
+    // All entries for these shaders may have been pruned
+    if (entries.empty())
+      return;
+
     if (item.cp.cs == nullptr) {
       auto pipeline = m_pipeManager->createGraphicsPipeline(item.gp);
-      auto entries = m_entryMap.equal_range(key);
 
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
+      for (const auto& entry : entries)
         pipeline->compilePipeline(entry.gpState);
-      }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cp);
-      auto entries = m_entryMap.equal_range(key);
 
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
+      for (const auto& entry : entries)
         pipeline->compilePipeline(entry.cpState);
-      }
     }
   }
 
 
   bool DxvkStateCache::readCacheFile() {
+    // Other processes may be appending to the file
+    std::lock_guard<sync::FileLock> fileLock(*m_fileLock);
+
     // Open state file and just fail if it doesn't exist
-    std::ifstream ifile(getCacheFileName().c_str(), std::ios_base::binary);
+    std::ifstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::ate);
 
-    if (!ifile) {
+    if (!file) {
       Logger::warn("DXVK: No state cache file found");
       return false;
     }
 
+    // Read the whole file at once and parse it from memory,
+    // reading entries from the file stream one small read
+    // at a time is slow for large cache files.
+    std::streamoff fileSize = file.tellg();
+    m_loadData.resize(fileSize > 0 ? size_t(fileSize) : 0);
+
+    file.seekg(0, std::ios_base::beg);
+
+    if (fileSize <= 0 || !file.read(m_loadData.data(), m_loadData.size())) {
+      Logger::warn("DXVK: Failed to read state cache file");
+      return false;
+    }
+
+    file.close();
+
+    DxvkStateCacheMemoryBuffer fileBuffer(m_loadData.data(), m_loadData.size());
+    std::istream ifile(&fileBuffer);
+
     // The header stores the state cache version,
     // we need to regenerate it if it's outdated
     DxvkStateCacheHeader newHeader;
@@ -457,44 +811,353 @@ namespace dxvk {
     if (curHeader.version != newHeader.version)
       Logger::warn(str::format("DXVK: Updating state cache version to v", newHeader.version));
 
-    // Read actual cache entries from the file.
-    // If we encounter invalid entries, we should
-    // regenerate the entire state cache file.
-    uint32_t numInvalidEntries = 0;
+    m_loadVersion = curHeader.version;
+
+    // Split the file into blocks of entries. This only needs to
+    // look at the entry headers, parsing and validating the actual
+    // entry data is done by the compiler threads in parallel.
+    size_t offset = sizeof(DxvkStateCacheHeader);
+    size_t count  = 0;
+
+    LoadBlock block;
+    block.offset = offset;
 
-    while (ifile) {
+    while (offset + sizeof(DxvkStateCacheEntryHeader) + sizeof(Sha1Hash) <= m_loadData.size()) {
+      DxvkStateCacheEntryHeader header;
+      std::memcpy(&header, &m_loadData[offset], sizeof(header));
+
+      size_t entrySize = sizeof(header) + sizeof(Sha1Hash) + header.entrySize;
+
+      // Ignore truncated entries at the end of the file
+      if (offset + entrySize > m_loadData.size())
+        break;
+
+      offset += entrySize;
+
+      if (++count == LoadBlockEntryCount) {
+        block.size = offset - block.offset;
+        m_loadBlocks.push_back(std::move(block));
+
+        block = LoadBlock();
+        block.offset = offset;
+        count = 0;
+      }
+    }
+
+    if (count) {
+      block.size = offset - block.offset;
+      m_loadBlocks.push_back(std::move(block));
+    }
+
+    // Entries past this point were written by
+    // other processes and get picked up later
+    m_fileSize = m_loadData.size();
+
+    // Rewrite entire state cache if it is outdated
+    return curHeader.version == newHeader.version;
+  }
+
+
+  void DxvkStateCache::parseCacheBlock(
+          LoadBlock&                block) {
+    DxvkStateCacheMemoryBuffer buffer(&m_loadData[block.offset], block.size);
+    std::istream stream(&buffer);
+
+    block.entries.reserve(LoadBlockEntryCount);
+
+    while (stream) {
       DxvkStateCacheEntry entry;
 
-      if (readCacheEntry(curHeader.version, ifile, entry)) {
-        size_t entryId = m_entries.size();
-        m_entries.push_back(entry);
+      if (readCacheEntry(m_loadVersion, stream, entry))
+        specializeEntry(entry, block);
+      else if (stream)
+        block.invalidCount += 1;
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_loaderLock);
+    block.done = true;
+
+    m_loaderCond.notify_one();
+  }
+
+
+  void DxvkStateCache::mergeCacheBlock(
+          LoadBlock&                block) {
+    std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+    std::unordered_set<DxvkStateCacheKey, DxvkHash, DxvkEq> keys;
+
+    for (const auto& entry : block.entries) {
+      size_t entryId = m_entries.size();
+      m_entries.push_back(entry);
+
+      mapPipelineToEntry(entry.shaders, entryId);
+
+      mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
+      mapShaderToPipeline(entry.shaders.tes, entry.shaders);
+      mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
+
+      keys.insert(entry.shaders);
+    }
+
+    m_entryUsage.resize(m_entries.size());
 
-        mapPipelineToEntry(entry.shaders, entryId);
+    m_foreignEntries.insert(m_foreignEntries.end(),
+      block.foreignEntries.begin(), block.foreignEntries.end());
+
+    // Shaders may have been registered before the entries
+    // using them were loaded, queue those pipelines now
+    std::unique_lock<dxvk::mutex> workerLock;
+
+    for (const auto& key : keys) {
+      WorkerItem item;
+
+      if (!getWorkerItem(key, item))
+        continue;
+
+      if (!workerLock)
+        workerLock = std::unique_lock<dxvk::mutex>(m_workerLock);
+
+      m_workerQueue.push(item);
+      submitCompileTask();
+    }
+  }
+
+
+  void DxvkStateCache::specializeEntry(
+    const DxvkStateCacheEntry&      entry,
+          LoadBlock&                block) const {
+    // Compute pipeline state does not depend on the device
+    if (!entry.shaders.cs.eq(g_nullShaderKey)) {
+      block.entries.push_back(entry);
+      return;
+    }
+
+    auto changeDepthFormat = [] (const DxvkRtInfo& rt, VkFormat format) {
+      std::array<VkFormat, MaxNumRenderTargets> colorFormats;
+
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+        colorFormats[i] = rt.getColorFormat(i);
+
+      return DxvkRtInfo(MaxNumRenderTargets, colorFormats.data(),
+        format, rt.getDepthStencilReadOnlyAspects());
+    };
+
+    VkFormat depthFormat = entry.gpState.rt.getDepthStencilFormat();
+    bool hasLocalD24S8 = !m_localFallbacks.test(DxvkStateCacheFallback::D24S8);
+
+    // Use the depth format that the front-end would pick on this
+    // device if the entry was recorded with a 24-bit depth buffer
+    DxvkStateCacheEntry local = entry;
+
+    if (depthFormat == VK_FORMAT_D24_UNORM_S8_UINT && !hasLocalD24S8) {
+      local.gpState.rt = changeDepthFormat(entry.gpState.rt, VK_FORMAT_D32_SFLOAT_S8_UINT);
+      local.fallbacks = m_localFallbacks;
+    }
 
-        mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
-        mapShaderToPipeline(entry.shaders.tes, entry.shaders);
-        mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
-      } else if (ifile) {
-        numInvalidEntries += 1;
+    // Keep entries that cannot be used on this device around,
+    // so that rewriting the cache file does not drop them
+    if (!isEntrySupported(local)) {
+      block.foreignEntries.push_back(entry);
+      return;
+    }
+
+    block.entries.push_back(local);
+
+    // If the recording device did not support D24S8, the application
+    // may have created a 24-bit depth buffer, so compile both variants
+    if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT && hasLocalD24S8
+     && entry.fallbacks.test(DxvkStateCacheFallback::D24S8)) {
+      local.gpState.rt = changeDepthFormat(entry.gpState.rt, VK_FORMAT_D24_UNORM_S8_UINT);
+      local.fallbacks = m_localFallbacks;
+
+      block.entries.push_back(local);
+    }
+  }
+
+
+  bool DxvkStateCache::isEntrySupported(
+    const DxvkStateCacheEntry&      entry) const {
+    const auto& state = entry.gpState;
+    const auto& features = m_device->features();
+    const auto adapter = m_device->adapter();
+
+    if (state.rs.conservativeMode() != VK_CONSERVATIVE_RASTERIZATION_MODE_DISABLED_EXT
+     && !m_device->extensions().extConservativeRasterization)
+      return false;
+
+    if (state.ds.enableDepthBoundsTest() && !features.core.features.depthBounds)
+      return false;
+
+    // Entries recorded with dynamic vertex input only store attribute
+    // locations, which is not enough to compile a pipeline without it
+    bool dynamicVertexInput = features.extVertexInputDynamicState.vertexInputDynamicState;
+
+    for (uint32_t i = 0; i < state.il.attributeCount(); i++) {
+      VkFormat format = state.ilAttributes[i].format();
+
+      if (format == VK_FORMAT_UNDEFINED) {
+        if (!dynamicVertexInput)
+          return false;
+      } else if (!(adapter->formatProperties(format).bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT)) {
+        return false;
       }
     }
 
-    Logger::info(str::format(
-      "DXVK: Read ", m_entries.size(),
-      " valid state cache entries"));
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      VkFormat format = state.rt.getColorFormat(i);
 
-    if (numInvalidEntries) {
-      Logger::warn(str::format(
-        "DXVK: Skipped ", numInvalidEntries,
-        " invalid state cache entries"));
+      if (format != VK_FORMAT_UNDEFINED
+       && !(adapter->formatProperties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT))
+        return false;
+    }
+
+    VkFormat depthFormat = state.rt.getDepthStencilFormat();
+
+    if (depthFormat != VK_FORMAT_UNDEFINED
+     && !(adapter->formatProperties(depthFormat).optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT))
       return false;
+
+    return true;
+  }
+
+
+  DxvkStateCacheFallbacks DxvkStateCache::getLocalFallbacks() const {
+    DxvkStateCacheFallbacks result;
+
+    // Matches the checks that front-ends use
+    // to decide on depth format fallbacks
+    VkFormatProperties d24s8 = m_device->adapter()->formatProperties(VK_FORMAT_D24_UNORM_S8_UINT);
+    VkFormatFeatureFlags d24s8Features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                       | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+    if ((d24s8.optimalTilingFeatures & d24s8Features) != d24s8Features)
+      result.set(DxvkStateCacheFallback::D24S8);
+
+    return result;
+  }
+
+
+  void DxvkStateCache::createCacheFile() {
+    Logger::warn("DXVK: Creating new state cache file");
+
+    std::lock_guard<sync::FileLock> fileLock(*m_fileLock);
+
+    // Start with an empty file
+    std::ofstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(getCacheFileName().c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
     }
-    
-    // Rewrite entire state cache if it is outdated
-    return curHeader.version == newHeader.version;
+
+    // Write header with the current version number
+    DxvkStateCacheHeader header;
+
+    auto data = reinterpret_cast<const char*>(&header);
+    auto size = sizeof(header);
+
+    file.write(data, size);
+
+    // Write all valid entries to the cache file in
+    // case we're recovering a corrupted cache file
+    for (size_t i = 0; i < m_entries.size(); i++) {
+      if (!m_entryUsage[i].pruned)
+        writeCacheEntry(file, m_entries[i]);
+    }
+
+    for (auto& e : m_foreignEntries)
+      writeCacheEntry(file, e);
+
+    file.flush();
+    m_fileSize = size_t(std::max<std::streamoff>(file.tellp(), 0));
+  }
+
+
+  void DxvkStateCache::syncCacheFile() {
+    std::ifstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::ate);
+
+    if (!file)
+      return;
+
+    size_t fileSize = size_t(std::max<std::streamoff>(file.tellg(), 0));
+
+    // If another process rewrote the file, read it again from
+    // the start. Entries we already know are skipped anyway.
+    if (fileSize < m_fileSize) {
+      DxvkStateCacheHeader header;
+      file.seekg(0, std::ios_base::beg);
+
+      if (!readCacheHeader(file, header) || header.version != DxvkStateCacheHeader().version) {
+        m_fileSize = fileSize;
+        return;
+      }
+
+      m_fileSize = sizeof(header);
+    }
+
+    if (fileSize <= m_fileSize)
+      return;
+
+    std::vector<char> data(fileSize - m_fileSize);
+    file.seekg(m_fileSize, std::ios_base::beg);
+
+    if (!file.read(data.data(), data.size()))
+      return;
+
+    m_fileSize = fileSize;
+
+    DxvkStateCacheMemoryBuffer buffer(data.data(), data.size());
+    std::istream stream(&buffer);
+
+    LoadBlock block;
+    DxvkStateCacheEntry entry;
+
+    while (readCacheEntry(DxvkStateCacheHeader().version, stream, entry))
+      specializeEntry(entry, block);
+
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+
+      block.entries.erase(std::remove_if(block.entries.begin(), block.entries.end(),
+        [this] (const DxvkStateCacheEntry& e) { return hasEntry(e); }),
+        block.entries.end());
+    }
+
+    // Entries from other devices are already in the file
+    block.foreignEntries.clear();
+
+    if (block.entries.empty())
+      return;
+
+    Logger::info(str::format("DXVK: Read ", block.entries.size(),
+      " state cache entries from other processes"));
+
+    mergeCacheBlock(block);
+  }
+
+
+  bool DxvkStateCache::hasEntry(
+    const DxvkStateCacheEntry&      entry) const {
+    auto entries = m_entryMap.equal_range(entry.shaders);
+
+    for (auto e = entries.first; e != entries.second; e++) {
+      const DxvkStateCacheEntry& other = m_entries[e->second];
+
+      if (entry.shaders.cs.eq(g_nullShaderKey)
+        ? other.gpState == entry.gpState
+        : other.cpState == entry.cpState)
+        return true;
+    }
+
+    return false;
   }
 
 
@@ -536,6 +1199,9 @@ namespace dxvk {
     if (hash != data.computeHash())
       return false;
 
+    // Keep the hash around to look up usage info
+    entry.hash = hash;
+
     // Read shader hashes
     VkShaderStageFlags stageMask = VkShaderStageFlags(header.stageMask);
     auto keys = &entry.shaders.vs;
@@ -569,6 +1235,7 @@ namespace dxvk {
        || !data.read(entry.gpState.ds, version)
        || !data.read(entry.gpState.om, version)
        || !data.read(entry.gpState.rt, version)
+       || !data.read(entry.fallbacks, version)
        || !data.read(entry.gpState.dsFront, version)
        || !data.read(entry.gpState.dsBack, version))
         return false;
@@ -648,6 +1315,7 @@ namespace dxvk {
       data.write(entry.gpState.ds);
       data.write(entry.gpState.om);
       data.write(entry.gpState.rt);
+      data.write(entry.fallbacks);
       data.write(entry.gpState.dsFront);
       data.write(entry.gpState.dsBack);
 
@@ -693,38 +1361,90 @@ namespace dxvk {
     stream.write(reinterpret_cast<char*>(&header), sizeof(header));
     stream.write(reinterpret_cast<char*>(&hash), sizeof(hash));
     stream.write(data.data(), data.size());
-    stream.flush();
   }
 
 
-  void DxvkStateCache::workerFunc() {
-    env::setThreadName("dxvk-shader");
+  void DxvkStateCache::loaderFunc() {
+    env::setThreadName("dxvk-loader");
 
-    while (!m_stopThreads.load()) {
-      WorkerItem item;
+    m_fileLock = std::make_unique<sync::FileLock>(getLockFileName());
 
-      { std::unique_lock<dxvk::mutex> lock(m_workerLock);
+    if (!m_fileLock->isValid() && env::createDirectory(getCacheDir()))
+      m_fileLock = std::make_unique<sync::FileLock>(getLockFileName());
 
-        if (m_workerQueue.empty()) {
-          m_workerBusy -= 1;
-          m_workerCond.wait(lock, [this] () {
-            return m_workerQueue.size()
-                || m_stopThreads.load();
-          });
+    bool isValid = readCacheFile();
 
-          if (!m_workerQueue.empty())
-            m_workerBusy += 1;
-        }
+    // Let the worker threads parse and validate the
+    // cache file, they will start compiling pipelines
+    // as soon as the first blocks have been loaded.
+    // Loading takes precedence over compiling the
+    // pipelines within the file.
+    for (auto& block : m_loadBlocks) {
+      m_pipeManager->getThreadPool().submit([this, &block] {
+        parseCacheBlock(block);
+      }, ThreadPoolPriority::Normal);
+    }
 
-        if (m_workerQueue.empty())
-          break;
-        
-        item = m_workerQueue.front();
-        m_workerQueue.pop();
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+      size_t estimatedEntryCount = m_loadBlocks.size() * LoadBlockEntryCount;
+      m_entries.reserve(estimatedEntryCount);
+      m_entryMap.reserve(estimatedEntryCount);
+    }
+
+    // Merge blocks in file order so that entry indices
+    // and thus compile priorities match the file layout
+    uint32_t numInvalidEntries = 0;
+
+    for (auto& block : m_loadBlocks) {
+      { std::unique_lock<dxvk::mutex> lock(m_loaderLock);
+
+        m_loaderCond.wait(lock, [this, &block] () {
+          return block.done || m_stopThreads.load();
+        });
+
+        // Workers may still be accessing file data
+        if (!block.done)
+          return;
       }
 
-      compilePipelines(item);
+      numInvalidEntries += block.invalidCount;
+      mergeCacheBlock(block);
     }
+
+    m_loadBlocks.clear();
+    m_loadData = std::vector<char>();
+
+    Logger::info(str::format(
+      "DXVK: Read ", m_entries.size(),
+      " valid state cache entries"));
+
+    if (!m_foreignEntries.empty()) {
+      Logger::info(str::format(
+        "DXVK: Skipped ", m_foreignEntries.size(),
+        " state cache entries not supported by this device"));
+    }
+
+    if (numInvalidEntries) {
+      Logger::warn(str::format(
+        "DXVK: Skipped ", numInvalidEntries,
+        " invalid state cache entries"));
+      isValid = false;
+    }
+
+    // Rewrite the file without stale entries if
+    // a large part of it has not been used lately
+    readUsageFile();
+
+    if (pruneEntries())
+      isValid = false;
+
+    if (!isValid)
+      createCacheFile();
+
+    // Allow the writer to append new entries to the file
+    std::lock_guard<dxvk::mutex> writerLock(m_writerLock);
+    m_cacheLoaded.store(true);
+    m_writerCond.notify_one();
   }
 
 
@@ -732,62 +1452,100 @@ namespace dxvk {
     env::setThreadName("dxvk-writer");
 
     std::ofstream file;
+    std::vector<DxvkStateCacheEntry> entries;
 
     while (!m_stopThreads.load()) {
-      DxvkStateCacheEntry entry;
-
       { std::unique_lock<dxvk::mutex> lock(m_writerLock);
 
-        m_writerCond.wait(lock, [this] () {
-          return m_writerQueue.size()
+        // Entries must not be appended to the file
+        // before the loader is done rewriting it
+        auto ready = [this] () {
+          return (m_writerQueue.size() && m_cacheLoaded.load())
               || m_stopThreads.load();
-        });
+        };
+
+        // When sharing the cache, wake up periodically in order
+        // to pick up entries that other processes have written
+        if (m_shareEntries) {
+          if (!m_writerCond.wait_for(lock, std::chrono::milliseconds(SyncIntervalMs), ready)
+           && !m_cacheLoaded.load())
+            continue;
+        } else {
+          m_writerCond.wait(lock, ready);
+        }
 
-        if (m_writerQueue.size() == 0)
+        if (!m_cacheLoaded.load() || (m_writerQueue.size() == 0 && m_stopThreads.load()))
           break;
 
-        entry = m_writerQueue.front();
-        m_writerQueue.pop();
+        // Take all pending entries so that we only
+        // have to flush the file once per batch
+        while (!m_writerQueue.empty()) {
+          entries.push_back(m_writerQueue.front());
+          m_writerQueue.pop();
+        }
       }
 
+      // Other processes may append to the same file. Read their entries
+      // first so that our own entries end up past the known file size.
+      std::lock_guard<sync::FileLock> fileLock(*m_fileLock);
+
+      if (m_shareEntries)
+        syncCacheFile();
+
+      if (entries.empty())
+        continue;
+
       if (!file.is_open()) {
         file.open(getCacheFileName().c_str(),
           std::ios_base::binary |
           std::ios_base::app);
       }
 
-      writeCacheEntry(file, entry);
+      for (auto& entry : entries)
+        writeCacheEntry(file, entry);
+
+      file.flush();
+      entries.clear();
+
+      m_fileSize = size_t(std::max<std::streamoff>(file.tellp(), 0));
     }
   }
 
 
-  void DxvkStateCache::createWorkers() {
-    if (m_workerThreads.empty()) {
-      // Use half the available CPU cores for pipeline compilation
-      uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
-      uint32_t numWorkers  = ((std::max(1u, numCpuCores) - 1) * 5) / 7;
+  void DxvkStateCache::submitCompileTask() {
+    // Each task compiles whichever item has the highest priority
+    // at the time it runs, not necessarily the one just queued
+    m_workerBusy += 1;
 
-      if (numWorkers <  1) numWorkers =  1;
-      if (numWorkers > 32) numWorkers = 32;
+    m_pipeManager->getThreadPool().submit([this] {
+      runCompileTask();
+    }, ThreadPoolPriority::Low);
+  }
 
-      if (m_device->config().numCompilerThreads > 0)
-        numWorkers = m_device->config().numCompilerThreads;
 
-      Logger::info(str::format("DXVK: Using ", numWorkers, " compiler threads"));
+  void DxvkStateCache::runCompileTask() {
+    WorkerItem item;
 
-      // Start the worker threads and the file writer
-      m_workerBusy.store(numWorkers);
+    { std::lock_guard<dxvk::mutex> lock(m_workerLock);
 
-      for (uint32_t i = 0; i < numWorkers; i++) {
-        m_workerThreads.emplace_back([this] () { workerFunc(); });
-        m_workerThreads[i].set_priority(ThreadPriority::Lowest);
+      if (m_workerQueue.empty() || m_stopThreads.load()) {
+        m_workerBusy -= 1;
+        return;
       }
+
+      item = m_workerQueue.top();
+      m_workerQueue.pop();
     }
+
+    compilePipelines(item);
+    m_workerBusy -= 1;
   }
 
 
   void DxvkStateCache::createWriter() {
-    if (!m_writerThread.joinable())
+    // Called with the writer lock held. Never start the thread
+    // after stopWorkerThreads, since nothing would join it.
+    if (!m_writerThread.joinable() && !m_stopThreads.load())
       m_writerThread = dxvk::thread([this] () { writerFunc(); });
   }
 
@@ -804,6 +1562,16 @@ namespace dxvk {
   }
 
 
+  std::wstring DxvkStateCache::getLockFileName() const {
+    return getCacheFileName() + L".lock";
+  }
+
+
+  std::wstring DxvkStateCache::getUsageFileName() const {
+    return getCacheFileName() + L".usage";
+  }
+
+
   std::string DxvkStateCache::getCacheDir() const {
     return env::getEnvVar("DXVK_STATE_CACHE_PATH");
   }
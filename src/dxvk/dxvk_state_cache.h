@@ -6,10 +6,15 @@
 #include <mutex>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "dxvk_state_cache_types.h"
 
+#include "../util/util_time.h"
+
+#include "../util/sync/sync_file_lock.h"
+
 namespace dxvk {
 
   class DxvkDevice;
@@ -79,23 +84,101 @@ namespace dxvk {
      * \returns \c true if we're compiling shaders
      */
     bool isCompilingShaders() {
-      return m_workerBusy.load() > 0;
+      return m_workerBusy.load() > 0
+          || !m_cacheLoaded.load();
     }
 
+    /**
+     * \brief Queries number of queued compile jobs
+     * \returns Number of pipelines waiting to be compiled
+     */
+    size_t getPendingCount();
+
   private:
 
+    /// Number of entries parsed by a worker in one go
+    constexpr static size_t LoadBlockEntryCount = 1024;
+    /// Interval at which to check for entries
+    /// written by other processes, in milliseconds
+    constexpr static uint32_t SyncIntervalMs = 1000;
+    /// Number of sessions after which an entry
+    /// that was not used is considered stale
+    constexpr static uint32_t MaxIdleSessions = 10;
+    /// Compact the cache file once at least
+    /// 1/n of the entries are stale
+    constexpr static size_t StaleEntryRatio = 4;
+
     using WriterItem = DxvkStateCacheEntry;
 
     struct WorkerItem {
       DxvkGraphicsPipelineShaders gp;
       DxvkComputePipelineShaders  cp;
+      size_t                      priority;
+    };
+
+    /**
+     * \brief Orders worker items by priority
+     *
+     * Entries are appended to the cache file in the order
+     * in which the game first needed them, so items with
+     * a lower entry index are likely to be needed sooner.
+     */
+    struct WorkerItemOrder {
+      bool operator () (const WorkerItem& a, const WorkerItem& b) const {
+        return a.priority > b.priority;
+      }
+    };
+
+    /**
+     * \brief Entry usage
+     *
+     * Records how often the game requested a cached
+     * pipeline before it was compiled in the background,
+     * and when that happened for the first time. An entry
+     * is also considered used once all of its shaders have
+     * been created. Usage from previous sessions is read
+     * from the usage file, a last session of zero means
+     * that no usage info is known for the entry.
+     */
+    struct EntryUsage {
+      uint32_t hitCount     = 0;
+      uint64_t firstUse     = 0;
+      uint32_t lastSession  = 0;
+      uint32_t totalHits    = 0;
+      bool     used         = false;
+      bool     pruned       = false;
+    };
+
+    /**
+     * \brief Block of cache file entries
+     *
+     * Range of the cache file that gets parsed and
+     * validated by a single worker while loading.
+     */
+    struct LoadBlock {
+      size_t                            offset       = 0;
+      size_t                            size         = 0;
+      uint32_t                          invalidCount = 0;
+      bool                              done         = false;
+      std::vector<DxvkStateCacheEntry>  entries;
+      std::vector<DxvkStateCacheEntry>  foreignEntries;
     };
 
     DxvkDevice*                       m_device;
     DxvkPipelineManager*              m_pipeManager;
+    bool                              m_shareEntries = false;
+    DxvkStateCacheFallbacks           m_localFallbacks;
 
     std::vector<DxvkStateCacheEntry>  m_entries;
+    std::vector<DxvkStateCacheEntry>  m_foreignEntries;
+    std::vector<EntryUsage>           m_entryUsage;
+    std::vector<EntryUsage>           m_foreignUsage;
+    uint32_t                          m_session = 1;
     std::atomic<bool>                 m_stopThreads = { false };
+    std::atomic<bool>                 m_cacheLoaded = { false };
+
+    dxvk::high_resolution_clock::time_point m_startTime
+      = dxvk::high_resolution_clock::now();
 
     dxvk::mutex                       m_entryLock;
 
@@ -112,22 +195,36 @@ namespace dxvk {
       DxvkHash, DxvkEq> m_shaderMap;
 
     dxvk::mutex                       m_workerLock;
-    dxvk::condition_variable          m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
-    std::atomic<uint32_t>             m_workerBusy;
-    std::vector<dxvk::thread>         m_workerThreads;
+    std::priority_queue<WorkerItem,
+      std::vector<WorkerItem>,
+      WorkerItemOrder>                m_workerQueue;
+    std::atomic<uint32_t>             m_workerBusy = { 0 };
+
+    dxvk::mutex                       m_loaderLock;
+    dxvk::condition_variable          m_loaderCond;
+    std::vector<char>                 m_loadData;
+    std::vector<LoadBlock>            m_loadBlocks;
+    uint32_t                          m_loadVersion      = 0;
+    dxvk::thread                      m_loaderThread;
 
     dxvk::mutex                       m_writerLock;
     dxvk::condition_variable          m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
     dxvk::thread                      m_writerThread;
 
+    std::unique_ptr<sync::FileLock>   m_fileLock;
+    size_t                            m_fileSize = 0;
+
     DxvkShaderKey getShaderKey(
       const Rc<DxvkShader>&           shader) const;
 
     bool getShaderByKey(
       const DxvkShaderKey&            key,
             Rc<DxvkShader>&           shader) const;
+
+    bool getWorkerItem(
+      const DxvkStateCacheKey&        key,
+            WorkerItem&               item) const;
     
     void mapPipelineToEntry(
       const DxvkStateCacheKey&        key,
@@ -137,11 +234,47 @@ namespace dxvk {
       const DxvkShaderKey&            shader,
       const DxvkStateCacheKey&        key);
 
+    size_t getPipelinePriority(
+      const DxvkStateCacheKey&        key) const;
+
+    void recordEntryUsage(
+            size_t                    entryId);
+
+    void logEntryUsage();
+
+    void readUsageFile();
+
+    void writeUsageFile();
+
+    bool pruneEntries();
+
     void compilePipelines(
       const WorkerItem&               item);
 
     bool readCacheFile();
 
+    void parseCacheBlock(
+            LoadBlock&                block);
+
+    void mergeCacheBlock(
+            LoadBlock&                block);
+
+    void specializeEntry(
+      const DxvkStateCacheEntry&      entry,
+            LoadBlock&                block) const;
+
+    bool isEntrySupported(
+      const DxvkStateCacheEntry&      entry) const;
+
+    DxvkStateCacheFallbacks getLocalFallbacks() const;
+
+    void createCacheFile();
+
+    void syncCacheFile();
+
+    bool hasEntry(
+      const DxvkStateCacheEntry&      entry) const;
+
     bool readCacheHeader(
             std::istream&             stream,
             DxvkStateCacheHeader&     header) const;
@@ -155,15 +288,21 @@ namespace dxvk {
             std::ostream&             stream, 
             DxvkStateCacheEntry&      entry) const;
     
-    void workerFunc();
+    void loaderFunc();
 
     void writerFunc();
 
-    void createWorkers();
+    void submitCompileTask();
+
+    void runCompileTask();
 
     void createWriter();
 
     std::wstring getCacheFileName() const;
+
+    std::wstring getLockFileName() const;
+
+    std::wstring getUsageFileName() const;
     
     std::string getCacheDir() const;
 
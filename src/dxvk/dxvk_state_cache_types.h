@@ -26,6 +26,21 @@ namespace dxvk {
   };
 
   
+  /**
+   * \brief Format fallbacks
+   *
+   * Formats that the device which recorded a state
+   * cache entry did not support, and that front-ends
+   * replace with a different format in that case.
+   * Needed to specialize entries to other devices.
+   */
+  enum class DxvkStateCacheFallback : uint32_t {
+    D24S8 = 0,  ///< D24S8 replaced with D32S8
+  };
+
+  using DxvkStateCacheFallbacks = Flags<DxvkStateCacheFallback>;
+
+
   /**
    * \brief State entry
    * 
@@ -39,6 +54,7 @@ namespace dxvk {
     DxvkGraphicsPipelineStateInfo gpState;
     DxvkComputePipelineStateInfo  cpState;
     Sha1Hash                      hash;
+    DxvkStateCacheFallbacks       fallbacks;
   };
 
 
@@ -51,13 +67,46 @@ namespace dxvk {
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 13;
+    uint32_t version    = 14;
     uint32_t entrySize  = 0; /* no longer meaningful */
   };
 
   static_assert(sizeof(DxvkStateCacheHeader) == 12);
 
 
+  /**
+   * \brief State cache usage file header
+   *
+   * The usage file is stored next to the state cache
+   * file and counts the sessions in which the cache
+   * was loaded. It is only used to decide which
+   * entries to remove when compacting the cache.
+   */
+  struct DxvkStateCacheUsageHeader {
+    char     magic[4]   = { 'D', 'X', 'V', 'U' };
+    uint32_t version    = 1;
+    uint32_t session    = 0;
+  };
+
+
+  /**
+   * \brief State cache usage record
+   *
+   * Identifies an entry by the hash stored in the
+   * state cache file, and stores the last session
+   * in which the entry was used as well as the
+   * number of times the game needed the pipeline
+   * before it was compiled.
+   */
+  struct DxvkStateCacheUsageRecord {
+    Sha1Hash hash;
+    uint32_t lastSession;
+    uint32_t hitCount;
+  };
+
+  static_assert(sizeof(DxvkStateCacheUsageRecord) == 28);
+
+
   class DxvkBindingMaskV8 : DxvkBindingSet<128> {
 
   public:
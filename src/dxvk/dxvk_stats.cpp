@@ -30,5 +30,93 @@ namespace dxvk {
     for (size_t i = 0; i < m_counters.size(); i++)
       m_counters[i] = 0;
   }
+
+  
+  const char* DxvkStatCounters::getName(DxvkStatCounter ctr) {
+    switch (ctr) {
+      case DxvkStatCounter::CmdDrawCalls:            return "cmd_draw_calls";
+      case DxvkStatCounter::CmdDispatchCalls:        return "cmd_dispatch_calls";
+      case DxvkStatCounter::CmdRenderPassCount:      return "cmd_render_pass_count";
+      case DxvkStatCounter::CmdBarrierCount:         return "cmd_barrier_count";
+      case DxvkStatCounter::CmdRenderPassSplitsAvoided: return "cmd_render_pass_splits_avoided";
+      case DxvkStatCounter::PipeCountGraphics:       return "pipe_count_graphics";
+      case DxvkStatCounter::PipeCountCompute:        return "pipe_count_compute";
+      case DxvkStatCounter::PipeCompilerBusy:        return "pipe_compiler_busy";
+      case DxvkStatCounter::PipeCountPending:        return "pipe_count_pending";
+      case DxvkStatCounter::PipeSkippedDraws:        return "pipe_skipped_draws";
+      case DxvkStatCounter::PipeQueueHigh:           return "pipe_queue_high";
+      case DxvkStatCounter::PipeQueueNormal:         return "pipe_queue_normal";
+      case DxvkStatCounter::PipeQueueLow:            return "pipe_queue_low";
+      case DxvkStatCounter::PipeLatencyHigh:         return "pipe_latency_high";
+      case DxvkStatCounter::PipeLatencyNormal:       return "pipe_latency_normal";
+      case DxvkStatCounter::PipeLatencyLow:          return "pipe_latency_low";
+      case DxvkStatCounter::PipeBlockingCount:       return "pipe_blocking_count";
+      case DxvkStatCounter::PipeBlockingTicks:       return "pipe_blocking_ticks";
+      case DxvkStatCounter::PipeBlockingHist0:       return "pipe_blocking_lt1ms";
+      case DxvkStatCounter::PipeBlockingHist1:       return "pipe_blocking_lt4ms";
+      case DxvkStatCounter::PipeBlockingHist2:       return "pipe_blocking_lt16ms";
+      case DxvkStatCounter::PipeBlockingHist3:       return "pipe_blocking_lt64ms";
+      case DxvkStatCounter::PipeBlockingHist4:       return "pipe_blocking_lt256ms";
+      case DxvkStatCounter::PipeBlockingHist5:       return "pipe_blocking_ge256ms";
+      case DxvkStatCounter::PipeBackgroundCount:     return "pipe_background_count";
+      case DxvkStatCounter::PipeBackgroundTicks:     return "pipe_background_ticks";
+      case DxvkStatCounter::PipeBackgroundHist0:     return "pipe_background_lt1ms";
+      case DxvkStatCounter::PipeBackgroundHist1:     return "pipe_background_lt4ms";
+      case DxvkStatCounter::PipeBackgroundHist2:     return "pipe_background_lt16ms";
+      case DxvkStatCounter::PipeBackgroundHist3:     return "pipe_background_lt64ms";
+      case DxvkStatCounter::PipeBackgroundHist4:     return "pipe_background_lt256ms";
+      case DxvkStatCounter::PipeBackgroundHist5:     return "pipe_background_ge256ms";
+      case DxvkStatCounter::QueueSubmitCount:        return "queue_submit_count";
+      case DxvkStatCounter::QueueSubmitBatched:      return "queue_submit_batched";
+      case DxvkStatCounter::CmdListCount:            return "cmdlist_count";
+      case DxvkStatCounter::CmdListFree:             return "cmdlist_free";
+      case DxvkStatCounter::CmdListCapacity:         return "cmdlist_capacity";
+      case DxvkStatCounter::QueuePresentCount:       return "queue_present_count";
+      case DxvkStatCounter::PresentUpscaleCount:     return "present_upscale_count";
+      case DxvkStatCounter::PresentUpscaleTicks:     return "present_upscale_ticks";
+      case DxvkStatCounter::QueueFlushExplicit:      return "queue_flush_explicit";
+      case DxvkStatCounter::QueueFlushIdle:          return "queue_flush_idle";
+      case DxvkStatCounter::QueueFlushInterval:      return "queue_flush_interval";
+      case DxvkStatCounter::QueueFlushSize:          return "queue_flush_size";
+      case DxvkStatCounter::QueueFlushSkipped:       return "queue_flush_skipped";
+      case DxvkStatCounter::LatencyApp:              return "latency_app";
+      case DxvkStatCounter::LatencyCs:               return "latency_cs";
+      case DxvkStatCounter::LatencyQueue:            return "latency_queue";
+      case DxvkStatCounter::LatencyGpu:              return "latency_gpu";
+      case DxvkStatCounter::LatencyPresent:          return "latency_present";
+      case DxvkStatCounter::LatencyTotal:            return "latency_total";
+      case DxvkStatCounter::GpuSyncCount:            return "gpu_sync_count";
+      case DxvkStatCounter::GpuSyncTicks:            return "gpu_sync_ticks";
+      case DxvkStatCounter::GpuIdleTicks:            return "gpu_idle_ticks";
+      case DxvkStatCounter::CsSyncCount:             return "cs_sync_count";
+      case DxvkStatCounter::CsSyncTicks:             return "cs_sync_ticks";
+      case DxvkStatCounter::CsChunkCount:            return "cs_chunk_count";
+      case DxvkStatCounter::CsChunkLiveCount:        return "cs_chunk_live_count";
+      case DxvkStatCounter::CsChunkLiveBytes:        return "cs_chunk_live_bytes";
+      case DxvkStatCounter::CsChunkPeakBytes:        return "cs_chunk_peak_bytes";
+      case DxvkStatCounter::CsCmdRedundantCount:     return "cs_cmd_redundant_count";
+      case DxvkStatCounter::DescriptorPoolCount:     return "descriptor_pool_count";
+      case DxvkStatCounter::DescriptorSetCount:      return "descriptor_set_count";
+      case DxvkStatCounter::DescriptorCacheHits:     return "descriptor_cache_hits";
+      case DxvkStatCounter::DescriptorCacheMisses:   return "descriptor_cache_misses";
+      case DxvkStatCounter::MemCacheHits:            return "mem_cache_hits";
+      case DxvkStatCounter::MemCacheMisses:          return "mem_cache_misses";
+      case DxvkStatCounter::MemCacheContention:      return "mem_cache_contention";
+      case DxvkStatCounter::MemAllocContention:      return "mem_alloc_contention";
+      case DxvkStatCounter::StagingMemoryAllocated:  return "staging_memory_allocated";
+      case DxvkStatCounter::StagingMemoryUsed:       return "staging_memory_used";
+      case DxvkStatCounter::MappedMemoryBar:         return "mapped_memory_bar";
+      case DxvkStatCounter::MappedMemorySysmem:      return "mapped_memory_sysmem";
+      case DxvkStatCounter::SamplerCount:            return "sampler_count";
+      case DxvkStatCounter::SamplerEvictions:        return "sampler_evictions";
+      case DxvkStatCounter::QueryPoolCount:          return "query_pool_count";
+      case DxvkStatCounter::QueryCountAllocated:     return "query_count_allocated";
+      case DxvkStatCounter::QueryCountUsed:          return "query_count_used";
+      case DxvkStatCounter::MetaPipelineMisses:      return "meta_pipeline_misses";
+      case DxvkStatCounter::DrawStateFastPath:       return "draw_state_fast_path";
+      case DxvkStatCounter::DrawStateFullPath:       return "draw_state_full_path";
+      default:                                       return "unknown";
+    }
+  }
   
 }
@@ -15,19 +15,83 @@ namespace dxvk {
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
     CmdBarrierCount,          ///< Number of pipeline barriers
+    CmdRenderPassSplitsAvoided, ///< Transfers moved out of render passes
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
     PipeCompilerBusy,         ///< Boolean indicating compiler activity
+    PipeCountPending,         ///< Number of queued pipeline compile jobs
+    PipeSkippedDraws,         ///< Draws skipped due to missing pipelines
+    PipeQueueHigh,            ///< Pending high priority compile jobs
+    PipeQueueNormal,          ///< Pending normal priority compile jobs
+    PipeQueueLow,             ///< Pending low priority compile jobs
+    PipeLatencyHigh,          ///< High priority compile latency, in us
+    PipeLatencyNormal,        ///< Normal priority compile latency, in us
+    PipeLatencyLow,           ///< Low priority compile latency, in us
+    PipeBlockingCount,        ///< Pipeline compiles that blocked a draw
+    PipeBlockingTicks,        ///< Time spent in blocking compiles, in us
+    PipeBlockingHist0,        ///< Blocking compiles taking less than 1 ms
+    PipeBlockingHist1,        ///< Blocking compiles taking less than 4 ms
+    PipeBlockingHist2,        ///< Blocking compiles taking less than 16 ms
+    PipeBlockingHist3,        ///< Blocking compiles taking less than 64 ms
+    PipeBlockingHist4,        ///< Blocking compiles taking less than 256 ms
+    PipeBlockingHist5,        ///< Blocking compiles taking 256 ms or more
+    PipeBackgroundCount,      ///< Pipeline compiles done by workers
+    PipeBackgroundTicks,      ///< Time spent in background compiles, in us
+    PipeBackgroundHist0,      ///< Background compiles taking less than 1 ms
+    PipeBackgroundHist1,      ///< Background compiles taking less than 4 ms
+    PipeBackgroundHist2,      ///< Background compiles taking less than 16 ms
+    PipeBackgroundHist3,      ///< Background compiles taking less than 64 ms
+    PipeBackgroundHist4,      ///< Background compiles taking less than 256 ms
+    PipeBackgroundHist5,      ///< Background compiles taking 256 ms or more
     QueueSubmitCount,         ///< Number of command buffer submissions
+    QueueSubmitBatched,       ///< Command lists submitted in batches
+    CmdListCount,             ///< Number of live command lists
+    CmdListFree,              ///< Command lists available for reuse
+    CmdListCapacity,          ///< Command lists the pool may keep
     QueuePresentCount,        ///< Number of present calls / frames
+    PresentUpscaleCount,      ///< Number of upscaled presents with timing data
+    PresentUpscaleTicks,      ///< GPU time spent upscaling, in us
+    QueueFlushExplicit,       ///< Flushes requested explicitly
+    QueueFlushIdle,           ///< Implicit flushes because the GPU was idle
+    QueueFlushInterval,       ///< Implicit flushes after the flush interval
+    QueueFlushSize,           ///< Implicit flushes due to large batches
+    QueueFlushSkipped,        ///< Implicit flush points that did not flush
+    LatencyApp,               ///< Interval between Present calls, in us
+    LatencyCs,                ///< Present call to CS thread present, in us
+    LatencyQueue,             ///< CS thread present to queue submission, in us
+    LatencyGpu,               ///< Queue submission to GPU completion, in us
+    LatencyPresent,           ///< Queue submission to present completion, in us
+    LatencyTotal,             ///< Present call to frame completion, in us
     GpuSyncCount,             ///< Number of GPU synchronizations
     GpuSyncTicks,             ///< Time spent waiting for GPU
     GpuIdleTicks,             ///< GPU idle time in microseconds
     CsSyncCount,              ///< CS thread synchronizations
     CsSyncTicks,              ///< Time spent waiting on CS
     CsChunkCount,             ///< Submitted CS chunks
+    CsChunkLiveCount,         ///< CS chunks currently in use
+    CsChunkLiveBytes,         ///< Memory used by CS chunks in use
+    CsChunkPeakBytes,         ///< Peak memory used by CS chunks
+    CsCmdRedundantCount,      ///< Skipped redundant CS state commands
     DescriptorPoolCount,      ///< Descriptor pool count
     DescriptorSetCount,       ///< Descriptor sets allocated
+    DescriptorCacheHits,      ///< Descriptor sets reused from set cache
+    DescriptorCacheMisses,    ///< Descriptor sets written after cache miss
+    MemCacheHits,             ///< Small allocations served from cache
+    MemCacheMisses,           ///< Small allocations that missed the cache
+    MemCacheContention,       ///< Contended allocation cache locks
+    MemAllocContention,       ///< Contended memory allocator locks
+    StagingMemoryAllocated,   ///< Memory allocated for staging buffers
+    StagingMemoryUsed,        ///< Staging memory currently in use
+    MappedMemoryBar,          ///< CPU-written memory placed in BAR memory
+    MappedMemorySysmem,       ///< CPU-written memory placed in system memory
+    SamplerCount,             ///< Number of live sampler objects
+    SamplerEvictions,         ///< Samplers evicted from the sampler pool
+    QueryPoolCount,           ///< Number of Vulkan query pools
+    QueryCountAllocated,      ///< Queries allocated in query pools
+    QueryCountUsed,           ///< Queries currently in use
+    MetaPipelineMisses,       ///< Meta pipelines compiled on first use
+    DrawStateFastPath,        ///< Draws that skipped state validation
+    DrawStateFullPath,        ///< Draws that validated all state
     NumCounters,              ///< Number of counters available
   };
   
@@ -107,6 +171,16 @@ namespace dxvk {
      * Sets all counters to zero.
      */
     void reset();
+
+    /**
+     * \brief Retrieves counter name
+     *
+     * Returns a short, stable identifier for the
+     * counter, for use in exported statistics.
+     * \param [in] ctr The counter
+     * \returns Counter name
+     */
+    static const char* getName(DxvkStatCounter ctr);
     
   private:
     
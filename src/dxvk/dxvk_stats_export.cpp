@@ -0,0 +1,195 @@
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "dxvk_device.h"
+#include "dxvk_stats_export.h"
+
+namespace dxvk {
+
+  DxvkStatsExporter::DxvkStatsExporter(DxvkDevice* device)
+  : m_device(device), m_startTime(high_resolution_clock::now()) {
+    m_heapCount = device->adapter()->memoryProperties().memoryHeapCount;
+
+    std::string path = env::getEnvVar("DXVK_STATS_FILE");
+    std::string name = env::getEnvVar("DXVK_STATS_SHM");
+
+    if (!path.empty())
+      openFile(path);
+
+    if (!name.empty())
+      openSharedBlock(name);
+  }
+
+
+  DxvkStatsExporter::~DxvkStatsExporter() {
+    closeSharedBlock();
+  }
+
+
+  void DxvkStatsExporter::exportFrame(
+          uint64_t              frameId) {
+    if (!isEnabled())
+      return;
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+
+    std::array<DxvkMemoryStats, VK_MAX_MEMORY_HEAPS> memory;
+    std::array<DxvkMemoryCategoryStats, VK_MAX_MEMORY_HEAPS> categories;
+
+    for (uint32_t i = 0; i < m_heapCount; i++) {
+      memory[i]     = m_device->getMemoryStats(i);
+      categories[i] = m_device->getMemoryCategoryStats(i);
+    }
+
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+      high_resolution_clock::now() - m_startTime).count();
+
+    if (m_file.is_open()) {
+      m_file << frameId << ',' << timestamp;
+
+      for (uint32_t i = 0; i < uint32_t(DxvkStatCounter::NumCounters); i++)
+        m_file << ',' << counters.getCtr(DxvkStatCounter(i));
+
+      for (uint32_t i = 0; i < m_heapCount; i++)
+        m_file << ',' << memory[i].memoryAllocated << ',' << memory[i].memoryUsed;
+
+      for (uint32_t i = 0; i < m_heapCount; i++) {
+        for (uint32_t j = 0; j < DxvkMemoryCategoryCount; j++)
+          m_file << ',' << categories[i].memoryUsed[j];
+      }
+
+      m_file << '\n';
+    }
+
+    if (m_block) {
+      // Odd sequence numbers indicate that an update is in
+      // progress, readers retry until they see the same
+      // even number before and after reading the block.
+      m_block->sequence = m_block->sequence + 1;
+      std::atomic_thread_fence(std::memory_order_release);
+
+      m_block->frameId   = frameId;
+      m_block->timestamp = timestamp;
+
+      for (uint32_t i = 0; i < uint32_t(DxvkStatCounter::NumCounters); i++)
+        m_block->counters[i] = counters.getCtr(DxvkStatCounter(i));
+
+      for (uint32_t i = 0; i < m_heapCount; i++) {
+        m_block->memoryAllocated[i] = memory[i].memoryAllocated;
+        m_block->memoryUsed[i]      = memory[i].memoryUsed;
+
+        for (uint32_t j = 0; j < DxvkMemoryCategoryCount; j++)
+          m_block->categoryUsed[i][j] = categories[i].memoryUsed[j];
+      }
+
+      std::atomic_thread_fence(std::memory_order_release);
+      m_block->sequence = m_block->sequence + 1;
+    }
+  }
+
+
+  void DxvkStatsExporter::openFile(
+    const std::string&          path) {
+    m_file.open(str::tows(path.c_str()).c_str(), std::ios_base::trunc);
+
+    if (!m_file) {
+      Logger::warn(str::format("DXVK: Failed to open stats file ", path));
+      return;
+    }
+
+    Logger::info(str::format("DXVK: Writing stats to ", path));
+    writeFileHeader();
+  }
+
+
+  void DxvkStatsExporter::writeFileHeader() {
+    m_file << "frame,timestamp_us";
+
+    for (uint32_t i = 0; i < uint32_t(DxvkStatCounter::NumCounters); i++)
+      m_file << ',' << DxvkStatCounters::getName(DxvkStatCounter(i));
+
+    for (uint32_t i = 0; i < m_heapCount; i++)
+      m_file << ",heap" << i << "_allocated,heap" << i << "_used";
+
+    for (uint32_t i = 0; i < m_heapCount; i++) {
+      for (uint32_t j = 0; j < DxvkMemoryCategoryCount; j++)
+        m_file << ",heap" << i << '_' << DxvkMemoryAllocator::getCategoryName(DxvkMemoryCategory(j));
+    }
+
+    m_file << std::endl;
+  }
+
+
+  void DxvkStatsExporter::openSharedBlock(
+    const std::string&          name) {
+    size_t size = sizeof(DxvkStatsSharedBlock);
+    void* ptr = nullptr;
+
+#ifdef _WIN32
+    m_mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+      PAGE_READWRITE, 0, DWORD(size), str::tows(name.c_str()).c_str());
+
+    if (m_mapping)
+      ptr = ::MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    m_shmName = name[0] == '/' ? name : "/" + name;
+
+    int fd = ::shm_open(m_shmName.c_str(), O_CREAT | O_RDWR, 0644);
+
+    if (fd >= 0) {
+      if (!::ftruncate(fd, size))
+        ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+      if (ptr == MAP_FAILED)
+        ptr = nullptr;
+
+      ::close(fd);
+    }
+#endif
+
+    if (!ptr) {
+      Logger::warn(str::format("DXVK: Failed to create shared stats block ", name));
+      closeSharedBlock();
+      return;
+    }
+
+    Logger::info(str::format("DXVK: Publishing stats to shared memory block ", name));
+
+    m_block = static_cast<DxvkStatsSharedBlock*>(ptr);
+    std::memset(m_block, 0, size);
+    std::memcpy(m_block->magic, "DXST", sizeof(m_block->magic));
+
+    m_block->version      = 2;
+    m_block->counterCount = uint32_t(DxvkStatCounter::NumCounters);
+    m_block->heapCount    = m_heapCount;
+  }
+
+
+  void DxvkStatsExporter::closeSharedBlock() {
+#ifdef _WIN32
+    if (m_block)
+      ::UnmapViewOfFile(m_block);
+
+    if (m_mapping)
+      ::CloseHandle(m_mapping);
+
+    m_mapping = nullptr;
+#else
+    if (m_block)
+      ::munmap(m_block, sizeof(DxvkStatsSharedBlock));
+
+    if (!m_shmName.empty())
+      ::shm_unlink(m_shmName.c_str());
+
+    m_shmName.clear();
+#endif
+    m_block = nullptr;
+  }
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "dxvk_memory.h"
+#include "dxvk_stats.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Shared memory stat block
+   *
+   * Layout of the named shared memory block that exported
+   * stats are published through. Readers must check that
+   * \c sequence is even and unchanged before and after
+   * copying the data, otherwise the copy may be torn.
+   * Counters are stored in \c DxvkStatCounter order,
+   * per-category memory usage in \c DxvkMemoryCategory
+   * order.
+   */
+  struct DxvkStatsSharedBlock {
+    char              magic[4];
+    uint32_t          version;
+    uint32_t          counterCount;
+    uint32_t          heapCount;
+    volatile uint64_t sequence;
+    uint64_t          frameId;
+    uint64_t          timestamp;
+    uint64_t          counters[uint32_t(DxvkStatCounter::NumCounters)];
+    uint64_t          memoryAllocated[VK_MAX_MEMORY_HEAPS];
+    uint64_t          memoryUsed[VK_MAX_MEMORY_HEAPS];
+    uint64_t          categoryUsed[VK_MAX_MEMORY_HEAPS][DxvkMemoryCategoryCount];
+  };
+
+
+  /**
+   * \brief Stat counter exporter
+   *
+   * Writes all stat counters and per-heap memory stats
+   * once per frame, either to a CSV file specified via
+   * \c DXVK_STATS_FILE, or to a named shared memory block
+   * specified via \c DXVK_STATS_SHM, or both. Counter
+   * values are written as reported by the device, i.e.
+   * cumulative counters are not reset between frames.
+   */
+  class DxvkStatsExporter {
+
+  public:
+
+    DxvkStatsExporter(DxvkDevice* device);
+
+    ~DxvkStatsExporter();
+
+    /**
+     * \brief Checks whether stat export is enabled
+     * \returns \c true if any output is enabled
+     */
+    bool isEnabled() const {
+      return m_file.is_open() || m_block != nullptr;
+    }
+
+    /**
+     * \brief Exports stats for the current frame
+     *
+     * Queries the device for current stat counters
+     * and memory stats and writes them out. Must
+     * only be called from one thread at a time.
+     * \param [in] frameId Current frame number
+     */
+    void exportFrame(
+            uint64_t              frameId);
+
+  private:
+
+    DxvkDevice*           m_device;
+    uint32_t              m_heapCount = 0;
+
+    high_resolution_clock::time_point m_startTime;
+
+    std::ofstream         m_file;
+
+#ifdef _WIN32
+    HANDLE                m_mapping = nullptr;
+#else
+    std::string           m_shmName;
+#endif
+    DxvkStatsSharedBlock* m_block   = nullptr;
+
+    void openFile(
+      const std::string&          path);
+
+    void writeFileHeader();
+
+    void openSharedBlock(
+      const std::string&          name);
+
+    void closeSharedBlock();
+
+  };
+
+}
@@ -4,12 +4,23 @@
 #include <dxvk_present_frag_blit.h>
 #include <dxvk_present_frag_ms.h>
 #include <dxvk_present_frag_ms_amd.h>
+#include <dxvk_present_frag_upscale.h>
 #include <dxvk_present_vert.h>
 
 namespace dxvk {
   
   DxvkSwapchainBlitter::DxvkSwapchainBlitter(const Rc<DxvkDevice>& device)
   : m_device(device) {
+    const auto& options = device->config();
+    const auto& limits = device->properties().core.properties.limits;
+
+    if (options.adaptiveUpscale) {
+      m_sharpness = float(std::clamp(options.upscaleSharpness, 0, 100)) / 100.0f;
+
+      if (limits.timestampComputeAndGraphics)
+        m_timestampPeriod = double(limits.timestampPeriod);
+    }
+
     this->createSampler();
     this->createShaders();
   }
@@ -25,10 +36,14 @@ namespace dxvk {
     const Rc<DxvkImageView>&  dstView,
           VkRect2D            dstRect,
     const Rc<DxvkImageView>&  srcView,
-          VkRect2D            srcRect) {
+          VkRect2D            srcRect,
+          VkRect2D            updateRect) {
     if (m_gammaDirty)
       this->updateGammaTexture(ctx);
 
+    if (!m_upscaleQueries.empty())
+      this->processUpscaleQueries();
+
     // Fix up default present areas if necessary
     if (!dstRect.extent.width || !dstRect.extent.height) {
       dstRect.offset = { 0, 0 };
@@ -44,12 +59,25 @@ namespace dxvk {
         srcView->imageInfo().extent.height };
     }
 
+    if (!updateRect.extent.width || !updateRect.extent.height) {
+      updateRect.offset = { 0, 0 };
+      updateRect.extent = {
+        dstView->imageInfo().extent.width,
+        dstView->imageInfo().extent.height };
+    }
+
+    m_updateRect = updateRect;
+
     bool sameSize = dstRect.extent == srcRect.extent;
     bool usedResolveImage = false;
 
-    if (srcView->imageInfo().sampleCount == VK_SAMPLE_COUNT_1_BIT) {
-      this->draw(ctx, sameSize ? m_fsCopy : m_fsBlit,
-        dstView, dstRect, srcView, srcRect);
+    if (this->canCopyImage(dstView, dstRect, srcView, srcRect)) {
+      this->copy(ctx, dstView, srcView, srcRect);
+    } else if (srcView->imageInfo().sampleCount == VK_SAMPLE_COUNT_1_BIT) {
+      if (sameSize)
+        this->draw(ctx, m_fsCopy, dstView, dstRect, srcView, srcRect);
+      else
+        this->magnify(ctx, dstView, dstRect, srcView, srcRect);
     } else if (sameSize) {
       this->draw(ctx, m_fsResolve,
         dstView, dstRect, srcView, srcRect);
@@ -60,7 +88,7 @@ namespace dxvk {
           this->createResolveImage(srcView->imageInfo());
 
       this->resolve(ctx, m_resolveView, srcView);
-      this->draw(ctx, m_fsBlit, dstView, dstRect, m_resolveView, srcRect);
+      this->magnify(ctx, dstView, dstRect, m_resolveView, srcRect);
 
       usedResolveImage = true;
     }
@@ -82,6 +110,7 @@ namespace dxvk {
         bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         bufInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
         bufInfo.access = VK_ACCESS_TRANSFER_READ_BIT;
+        bufInfo.category = DxvkMemoryCategory::Meta;
 
         m_gammaBuffer = m_device->createBuffer(bufInfo,
           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
@@ -173,8 +202,23 @@ namespace dxvk {
     viewport.height   = float(dstRect.extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    
-    ctx->setViewports(1, &viewport, &dstRect);
+
+    // Only touch pixels inside the update rect, the
+    // rest of the image is known to be up to date
+    int32_t x0 = std::max(dstRect.offset.x, m_updateRect.offset.x);
+    int32_t y0 = std::max(dstRect.offset.y, m_updateRect.offset.y);
+    int32_t x1 = std::min(dstRect.offset.x + int32_t(dstRect.extent.width),
+                          m_updateRect.offset.x + int32_t(m_updateRect.extent.width));
+    int32_t y1 = std::min(dstRect.offset.y + int32_t(dstRect.extent.height),
+                          m_updateRect.offset.y + int32_t(m_updateRect.extent.height));
+
+    VkRect2D scissor;
+    scissor.offset = { x0, y0 };
+    scissor.extent = {
+      uint32_t(std::max(x1 - x0, 0)),
+      uint32_t(std::max(y1 - y0, 0)) };
+
+    ctx->setViewports(1, &viewport, &scissor);
 
     DxvkRenderTargets renderTargets;
     renderTargets.color[0].view   = dstView;
@@ -186,13 +230,12 @@ namespace dxvk {
       dstView->imageInfo().extent.width,
       dstView->imageInfo().extent.height };
 
-    if (dstRect.extent == dstExtent)
-      ctx->discardImageView(dstView, VK_IMAGE_ASPECT_COLOR_BIT);
-    else
-      ctx->clearRenderTarget(dstView, VK_IMAGE_ASPECT_COLOR_BIT, VkClearValue());
-
-    ctx->bindResourceSampler(VK_SHADER_STAGE_FRAGMENT_BIT, BindingIds::Image, m_samplerPresent);
-    ctx->bindResourceSampler(VK_SHADER_STAGE_FRAGMENT_BIT, BindingIds::Gamma, m_samplerGamma);
+    if (this->isFullUpdate(dstView)) {
+      if (dstRect.extent == dstExtent)
+        ctx->discardImageView(dstView, VK_IMAGE_ASPECT_COLOR_BIT);
+      else
+        ctx->clearRenderTarget(dstView, VK_IMAGE_ASPECT_COLOR_BIT, VkClearValue());
+    }
 
     ctx->bindResourceView(VK_SHADER_STAGE_FRAGMENT_BIT, BindingIds::Image, srcView, nullptr);
     ctx->bindResourceView(VK_SHADER_STAGE_FRAGMENT_BIT, BindingIds::Gamma, m_gammaView, nullptr);
@@ -202,6 +245,7 @@ namespace dxvk {
 
     PresenterArgs args;
     args.srcOffset = srcRect.offset;
+    args.sharpness = m_sharpness;
 
     if (dstRect.extent == srcRect.extent)
       args.dstOffset = dstRect.offset;
@@ -217,6 +261,72 @@ namespace dxvk {
     ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, 1, 0);
   }
 
+  void DxvkSwapchainBlitter::copy(
+          DxvkContext*        ctx,
+    const Rc<DxvkImageView>&  dstView,
+    const Rc<DxvkImageView>&  srcView,
+          VkRect2D            srcRect) {
+    VkImageSubresourceLayers subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+
+    // The destination rect covers the entire image here, so
+    // the update rect maps to the source image 1:1
+    VkOffset3D dstOffset = { m_updateRect.offset.x, m_updateRect.offset.y, 0 };
+    VkOffset3D srcOffset = {
+      srcRect.offset.x + m_updateRect.offset.x,
+      srcRect.offset.y + m_updateRect.offset.y, 0 };
+    VkExtent3D extent = { m_updateRect.extent.width, m_updateRect.extent.height, 1 };
+
+    if (srcView->imageInfo().sampleCount == VK_SAMPLE_COUNT_1_BIT) {
+      ctx->copyImage(
+        dstView->image(), subresource, dstOffset,
+        srcView->image(), subresource, srcOffset, extent);
+    } else {
+      VkImageResolve resolve;
+      resolve.srcSubresource = subresource;
+      resolve.srcOffset      = srcOffset;
+      resolve.dstSubresource = subresource;
+      resolve.dstOffset      = dstOffset;
+      resolve.extent         = extent;
+      ctx->resolveImage(dstView->image(), srcView->image(), resolve, VK_FORMAT_UNDEFINED);
+    }
+  }
+
+
+  bool DxvkSwapchainBlitter::canCopyImage(
+    const Rc<DxvkImageView>&  dstView,
+          VkRect2D            dstRect,
+    const Rc<DxvkImageView>&  srcView,
+          VkRect2D            srcRect) const {
+    // Gamma correction requires the shader
+    if (m_gammaView != nullptr)
+      return false;
+
+    // The destination rect must cover the entire swap chain
+    // image since the blit would clear the remaining area
+    VkExtent2D dstExtent = {
+      dstView->imageInfo().extent.width,
+      dstView->imageInfo().extent.height };
+
+    if (dstRect.offset.x || dstRect.offset.y
+     || dstRect.extent != dstExtent
+     || dstRect.extent != srcRect.extent)
+      return false;
+
+    if (!(dstView->imageInfo().usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+     || !(srcView->imageInfo().usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+      return false;
+
+    // Copies and resolves don't perform any format conversion,
+    // so both images must be viewed with their actual format
+    VkFormat format = dstView->info().format;
+
+    return dstView->imageInfo().format == format
+        && srcView->imageInfo().format == format
+        && srcView->info().format == format
+        && util::isIdentityMapping(srcView->info().swizzle);
+  }
+
+
   void DxvkSwapchainBlitter::resolve(
           DxvkContext*        ctx,
     const Rc<DxvkImageView>&  dstView,
@@ -231,6 +341,92 @@ namespace dxvk {
   }
 
 
+  void DxvkSwapchainBlitter::magnify(
+          DxvkContext*        ctx,
+    const Rc<DxvkImageView>&  dstView,
+          VkRect2D            dstRect,
+    const Rc<DxvkImageView>&  srcView,
+          VkRect2D            srcRect) {
+    if (!this->canUpscaleImage(dstRect, srcRect)) {
+      this->draw(ctx, m_fsBlit, dstView, dstRect, srcView, srcRect);
+      return;
+    }
+
+    if (!m_timestampPeriod) {
+      this->draw(ctx, m_fsUpscale, dstView, dstRect, srcView, srcRect);
+      return;
+    }
+
+    UpscaleQuery query;
+    query.begin = m_device->createGpuQuery(VK_QUERY_TYPE_TIMESTAMP, 0, 0);
+    query.end   = m_device->createGpuQuery(VK_QUERY_TYPE_TIMESTAMP, 0, 0);
+
+    ctx->writeTimestamp(query.begin);
+    this->draw(ctx, m_fsUpscale, dstView, dstRect, srcView, srcRect);
+    ctx->writeTimestamp(query.end);
+
+    m_upscaleQueries.push(std::move(query));
+  }
+
+
+  bool DxvkSwapchainBlitter::isFullUpdate(
+    const Rc<DxvkImageView>&  dstView) const {
+    VkExtent2D dstExtent = {
+      dstView->imageInfo().extent.width,
+      dstView->imageInfo().extent.height };
+
+    return !m_updateRect.offset.x && !m_updateRect.offset.y
+        && m_updateRect.extent == dstExtent;
+  }
+
+
+  bool DxvkSwapchainBlitter::canUpscaleImage(
+          VkRect2D            dstRect,
+          VkRect2D            srcRect) const {
+    if (m_fsUpscale == nullptr)
+      return false;
+
+    // The filter is designed for magnification, so fall back
+    // to the bilinear blit if the image shrinks in any way
+    return dstRect.extent.width  >= srcRect.extent.width
+        && dstRect.extent.height >= srcRect.extent.height;
+  }
+
+
+  void DxvkSwapchainBlitter::processUpscaleQueries() {
+    // Queries complete in submission order, so stop
+    // polling at the first one that is still pending
+    while (!m_upscaleQueries.empty()) {
+      const UpscaleQuery& query = m_upscaleQueries.front();
+
+      DxvkQueryData beginData = { };
+      DxvkQueryData endData = { };
+
+      DxvkGpuQueryStatus beginStatus = query.begin->getData(beginData);
+      DxvkGpuQueryStatus endStatus = query.end->getData(endData);
+
+      if (beginStatus == DxvkGpuQueryStatus::Pending
+       || endStatus == DxvkGpuQueryStatus::Pending)
+        return;
+
+      if (beginStatus == DxvkGpuQueryStatus::Available
+       && endStatus == DxvkGpuQueryStatus::Available) {
+        uint64_t begin = beginData.timestamp.time;
+        uint64_t end   = endData.timestamp.time;
+
+        uint64_t us = end > begin
+          ? uint64_t(double(end - begin) * m_timestampPeriod / 1000.0)
+          : uint64_t(0);
+
+        m_device->addStatCtr(DxvkStatCounter::PresentUpscaleCount, 1);
+        m_device->addStatCtr(DxvkStatCounter::PresentUpscaleTicks, us);
+      }
+
+      m_upscaleQueries.pop();
+    }
+  }
+
+
   void DxvkSwapchainBlitter::updateGammaTexture(DxvkContext* ctx) {
     uint32_t n = m_gammaCpCount;
 
@@ -253,6 +449,7 @@ namespace dxvk {
                             | VK_ACCESS_SHADER_READ_BIT;
         imgInfo.tiling      = VK_IMAGE_TILING_OPTIMAL;
         imgInfo.layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imgInfo.category    = DxvkMemoryCategory::Meta;
         
         m_gammaImage = m_device->createImage(
           imgInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -320,10 +517,12 @@ namespace dxvk {
     SpirvCodeBuffer fsCodeCopy(dxvk_present_frag);
     SpirvCodeBuffer fsCodeResolve(dxvk_present_frag_ms);
     SpirvCodeBuffer fsCodeResolveAmd(dxvk_present_frag_ms_amd);
+    SpirvCodeBuffer fsCodeUpscale(dxvk_present_frag_upscale);
 
+    // Samplers never change, so use them as immutable samplers
     const std::array<DxvkBindingInfo, 2> fsBindings = {{
-      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BindingIds::Image, VK_IMAGE_VIEW_TYPE_2D, 0, VK_ACCESS_SHADER_READ_BIT },
-      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BindingIds::Gamma, VK_IMAGE_VIEW_TYPE_1D, 0, VK_ACCESS_SHADER_READ_BIT },
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BindingIds::Image, VK_IMAGE_VIEW_TYPE_2D, 0, VK_ACCESS_SHADER_READ_BIT, 0, m_samplerPresent.ptr() },
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BindingIds::Gamma, VK_IMAGE_VIEW_TYPE_1D, 0, VK_ACCESS_SHADER_READ_BIT, 0, m_samplerGamma.ptr() },
     }};
 
     DxvkShaderCreateInfo vsInfo;
@@ -339,6 +538,9 @@ namespace dxvk {
     fsInfo.inputMask = 0x1;
     fsInfo.outputMask = 0x1;
     m_fsBlit = new DxvkShader(fsInfo, std::move(fsCodeBlit));
+
+    if (m_device->config().adaptiveUpscale)
+      m_fsUpscale = new DxvkShader(fsInfo, std::move(fsCodeUpscale));
     
     fsInfo.inputMask = 0;
     m_fsCopy = new DxvkShader(fsInfo, std::move(fsCodeCopy));
@@ -367,6 +569,7 @@ namespace dxvk {
                    | VK_ACCESS_SHADER_READ_BIT;
     newInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     newInfo.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    newInfo.category = DxvkMemoryCategory::Meta;
     m_resolveImage = m_device->createImage(newInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     DxvkImageViewCreateInfo viewInfo;
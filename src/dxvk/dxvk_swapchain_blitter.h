@@ -1,5 +1,7 @@
 #pragma once
 
+#include <queue>
+
 #include "../dxvk/dxvk_device.h"
 #include "../dxvk/dxvk_context.h"
 
@@ -16,7 +18,11 @@ namespace dxvk {
    * \brief Swap chain blitter
    *
    * Provides common rendering code for blitting
-   * rendered images to a swap chain image.
+   * rendered images to a swap chain image. If enabled,
+   * back buffers smaller than the destination rectangle
+   * are magnified with an edge-adaptive, sharpening
+   * filter rather than a plain bilinear blit, and the
+   * GPU time spent doing so is reported via stat counters.
    */
   class DxvkSwapchainBlitter : public RcObject {
     
@@ -33,13 +39,18 @@ namespace dxvk {
      * \param [in] srcView Image to present
      * \param [in] dstRect Destination rectangle
      * \param [in] srcRect Back buffer rectangle
+     * \param [in] updateRect Area of the swap chain image
+     *    to update. Everything outside this area must already
+     *    contain the correct contents. If the extent is zero,
+     *    the entire image will be updated.
      */
     void presentImage(
             DxvkContext*        ctx,
       const Rc<DxvkImageView>&  dstView,
             VkRect2D            dstRect,
       const Rc<DxvkImageView>&  srcView,
-            VkRect2D            srcRect);
+            VkRect2D            srcRect,
+            VkRect2D            updateRect = VkRect2D());
 
     /**
      * \brief Sets gamma ramp
@@ -67,12 +78,19 @@ namespace dxvk {
         VkExtent2D srcExtent;
         VkOffset2D dstOffset;
       };
+      float sharpness;
+    };
+
+    struct UpscaleQuery {
+      Rc<DxvkGpuQuery>  begin;
+      Rc<DxvkGpuQuery>  end;
     };
 
     Rc<DxvkDevice>      m_device;
 
     Rc<DxvkShader>      m_fsCopy;
     Rc<DxvkShader>      m_fsBlit;
+    Rc<DxvkShader>      m_fsUpscale;
     Rc<DxvkShader>      m_fsResolve;
     Rc<DxvkShader>      m_vs;
 
@@ -89,6 +107,13 @@ namespace dxvk {
     Rc<DxvkSampler>     m_samplerPresent;
     Rc<DxvkSampler>     m_samplerGamma;
 
+    VkRect2D            m_updateRect      = { };
+
+    float               m_sharpness       = 0.0f;
+    double              m_timestampPeriod = 0.0;
+
+    std::queue<UpscaleQuery> m_upscaleQueries;
+
     void draw(
             DxvkContext*        ctx,
       const Rc<DxvkShader>&     fs,
@@ -97,11 +122,39 @@ namespace dxvk {
       const Rc<DxvkImageView>&  srcView,
             VkRect2D            srcRect);
 
+    void copy(
+            DxvkContext*        ctx,
+      const Rc<DxvkImageView>&  dstView,
+      const Rc<DxvkImageView>&  srcView,
+            VkRect2D            srcRect);
+
+    bool canCopyImage(
+      const Rc<DxvkImageView>&  dstView,
+            VkRect2D            dstRect,
+      const Rc<DxvkImageView>&  srcView,
+            VkRect2D            srcRect) const;
+
     void resolve(
             DxvkContext*        ctx,
       const Rc<DxvkImageView>&  dstView,
       const Rc<DxvkImageView>&  srcView);
 
+    void magnify(
+            DxvkContext*        ctx,
+      const Rc<DxvkImageView>&  dstView,
+            VkRect2D            dstRect,
+      const Rc<DxvkImageView>&  srcView,
+            VkRect2D            srcRect);
+
+    bool isFullUpdate(
+      const Rc<DxvkImageView>&  dstView) const;
+
+    bool canUpscaleImage(
+            VkRect2D            dstRect,
+            VkRect2D            srcRect) const;
+
+    void processUpscaleQueries();
+
     void updateGammaTexture(DxvkContext* ctx);
 
     void createSampler();
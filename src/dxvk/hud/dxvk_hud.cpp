@@ -39,13 +39,18 @@ namespace dxvk::hud {
     addItem<HudDeviceInfoItem>("devinfo", -1, m_device);
     addItem<HudFpsItem>("fps", -1);
     addItem<HudFrameTimeItem>("frametimes", -1);
+    addItem<HudLatencyItem>("latency", -1, device);
     addItem<HudSubmissionStatsItem>("submissions", -1, device);
     addItem<HudDrawCallStatsItem>("drawcalls", -1, device);
     addItem<HudPipelineStatsItem>("pipelines", -1, device);
+    addItem<HudAsyncPipelineItem>("async", -1, device);
+    addItem<HudPipelineCompileItem>("compiletimes", -1, device);
     addItem<HudDescriptorStatsItem>("descriptors", -1, device);
     addItem<HudMemoryStatsItem>("memory", -1, device);
     addItem<HudCsThreadItem>("cs", -1, device);
+    addItem<HudThreadItem>("threads", -1);
     addItem<HudGpuLoadItem>("gpuload", -1, device);
+    addItem<HudUpscaleItem>("upscale", -1, device);
     addItem<HudCompilerActivityItem>("compiler", -1, device);
   }
   
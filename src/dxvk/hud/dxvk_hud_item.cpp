@@ -292,6 +292,70 @@ namespace dxvk::hud {
   }
 
 
+  HudLatencyItem::HudLatencyItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudLatencyItem::~HudLatencyItem() {
+
+  }
+
+
+  void HudLatencyItem::update(dxvk::high_resolution_clock::time_point time) {
+    DxvkStatCounters counters = m_device->getStatCounters();
+
+    for (uint32_t i = 0; i < NumStages; i++)
+      m_sums[i] += counters.getCtr(DxvkStatCounter(uint32_t(DxvkStatCounter::LatencyApp) + i));
+
+    m_samples += 1;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() >= UpdateInterval) {
+      for (uint32_t i = 0; i < NumStages; i++) {
+        uint64_t us = m_sums[i] / m_samples;
+        m_strings[i] = str::format(us / 1000, ".", (us / 100) % 10, " ms");
+        m_sums[i] = 0;
+      }
+
+      m_samples = 0;
+      m_lastUpdate = time;
+    }
+  }
+
+
+  HudPos HudLatencyItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    static const std::array<const char*, NumStages> stageNames = {
+      "App:",
+      "CS:",
+      "Queue:",
+      "GPU:",
+      "Present:",
+      "Total latency:",
+    };
+
+    for (uint32_t i = 0; i < NumStages; i++) {
+      position.y += i ? 20.0f : 16.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 0.25f, 1.0f, 1.0f, 1.0f },
+        stageNames[i]);
+
+      renderer.drawText(16.0f,
+        { position.x + 168.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        m_strings[i]);
+    }
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudSubmissionStatsItem::HudSubmissionStatsItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -391,6 +455,7 @@ namespace dxvk::hud {
       m_cpCount = diffCounters.getCtr(DxvkStatCounter::CmdDispatchCalls);
       m_rpCount = diffCounters.getCtr(DxvkStatCounter::CmdRenderPassCount);
       m_pbCount = diffCounters.getCtr(DxvkStatCounter::CmdBarrierCount);
+      m_rsCount = diffCounters.getCtr(DxvkStatCounter::CmdRenderPassSplitsAvoided);
 
       m_lastUpdate = time;
     }
@@ -435,6 +500,17 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_rpCount));
     
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 0.5f, 1.0f, 1.0f },
+      "Splits avoided:");
+    
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_rsCount));
+    
     position.y += 20.0f;
     renderer.drawText(16.0f,
       { position.x, position.y },
@@ -500,6 +576,229 @@ namespace dxvk::hud {
   }
 
 
+  HudAsyncPipelineItem::HudAsyncPipelineItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudAsyncPipelineItem::~HudAsyncPipelineItem() {
+
+  }
+
+
+  void HudAsyncPipelineItem::update(dxvk::high_resolution_clock::time_point time) {
+    DxvkStatCounters counters = m_device->getStatCounters();
+
+    uint64_t currSkippedDraws = counters.getCtr(DxvkStatCounter::PipeSkippedDraws);
+
+    m_maxSkippedDraws = std::max(m_maxSkippedDraws, currSkippedDraws - m_prevSkippedDraws);
+    m_prevSkippedDraws = currSkippedDraws;
+
+    m_pendingPipelines = std::max(m_pendingPipelines,
+      counters.getCtr(DxvkStatCounter::PipeCountPending));
+
+    for (uint32_t i = 0; i < m_queueDepth.size(); i++) {
+      m_queueDepth[i] = std::max(m_queueDepth[i], counters.getCtr(
+        DxvkStatCounter(uint32_t(DxvkStatCounter::PipeQueueHigh) + i)));
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() >= UpdateInterval) {
+      m_skippedString = str::format(m_maxSkippedDraws);
+      m_pendingString = str::format(m_pendingPipelines);
+
+      for (uint32_t i = 0; i < m_queueDepth.size(); i++) {
+        uint64_t latency = counters.getCtr(
+          DxvkStatCounter(uint32_t(DxvkStatCounter::PipeLatencyHigh) + i));
+
+        m_queueStrings[i] = str::format(m_queueDepth[i],
+          " (", latency / 1000, ".", (latency / 100) % 10, " ms)");
+        m_queueDepth[i] = 0;
+      }
+
+      m_maxSkippedDraws = 0;
+      m_pendingPipelines = 0;
+
+      m_lastUpdate = time;
+    }
+  }
+
+
+  HudPos HudAsyncPipelineItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.25f, 1.0f, 1.0f },
+      "Pending pipelines:");
+
+    renderer.drawText(16.0f,
+      { position.x + 240.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_pendingString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.25f, 1.0f, 1.0f },
+      "Skipped draws:");
+
+    renderer.drawText(16.0f,
+      { position.x + 240.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_skippedString);
+
+    static const std::array<const char*, 3> queueNames = {
+      "High priority:",
+      "Normal priority:",
+      "Low priority:",
+    };
+
+    for (uint32_t i = 0; i < queueNames.size(); i++) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        queueNames[i]);
+
+      renderer.drawText(16.0f,
+        { position.x + 240.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        m_queueStrings[i]);
+    }
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
+  HudPipelineCompileItem::HudPipelineCompileItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudPipelineCompileItem::~HudPipelineCompileItem() {
+
+  }
+
+
+  void HudPipelineCompileItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() < UpdateInterval)
+      return;
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+
+    const std::array<DxvkStatCounter, DxvkPipelineCompileTypeCount> compileCounters = {
+      DxvkStatCounter::PipeBlockingCount,
+      DxvkStatCounter::PipeBackgroundCount,
+    };
+
+    for (uint32_t i = 0; i < DxvkPipelineCompileTypeCount; i++) {
+      uint32_t base = uint32_t(compileCounters[i]);
+
+      uint64_t count = counters.getCtr(DxvkStatCounter(base + 0));
+      uint64_t ticks = counters.getCtr(DxvkStatCounter(base + 1));
+
+      m_totalStrings[i] = str::format(count, " (", ticks / 1000, " ms)");
+
+      for (uint32_t j = 0; j < DxvkPipelineHistogramSize; j++)
+        m_histogramStrings[i][j] = str::format(counters.getCtr(DxvkStatCounter(base + 2 + j)));
+    }
+
+    m_stallStrings.clear();
+
+    for (const auto& stall : m_device->getPipelineStalls(MaxStallCount)) {
+      m_stallStrings.push_back(str::format(stall.totalTime / 1000, " ms (",
+        stall.numStalls, "x): ", stall.shaders));
+    }
+
+    m_lastUpdate = time;
+  }
+
+
+  HudPos HudPipelineCompileItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    static const std::array<const char*, DxvkPipelineHistogramSize> bucketNames = {
+      "< 1 ms:",
+      "< 4 ms:",
+      "< 16 ms:",
+      "< 64 ms:",
+      "< 256 ms:",
+      ">= 256 ms:",
+    };
+
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.25f, 1.0f, 1.0f },
+      "Compile time:");
+
+    renderer.drawText(16.0f,
+      { position.x + 160.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      "Blocking");
+
+    renderer.drawText(16.0f,
+      { position.x + 320.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      "Background");
+
+    for (uint32_t i = 0; i < DxvkPipelineHistogramSize; i++) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        bucketNames[i]);
+
+      for (uint32_t j = 0; j < DxvkPipelineCompileTypeCount; j++) {
+        renderer.drawText(16.0f,
+          { position.x + 160.0f * float(j + 1), position.y },
+          { 1.0f, 1.0f, 1.0f, 1.0f },
+          m_histogramStrings[j][i]);
+      }
+    }
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.25f, 1.0f, 1.0f },
+      "Total:");
+
+    for (uint32_t j = 0; j < DxvkPipelineCompileTypeCount; j++) {
+      renderer.drawText(16.0f,
+        { position.x + 160.0f * float(j + 1), position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        m_totalStrings[j]);
+    }
+
+    if (!m_stallStrings.empty()) {
+      position.y += 24.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        "Worst stalls:");
+
+      for (const auto& stall : m_stallStrings) {
+        position.y += 20.0f;
+        renderer.drawText(12.0f,
+          { position.x, position.y },
+          { 1.0f, 1.0f, 1.0f, 1.0f },
+          stall);
+      }
+    }
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudDescriptorStatsItem::HudDescriptorStatsItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -516,6 +815,18 @@ namespace dxvk::hud {
 
     m_descriptorPoolCount = counters.getCtr(DxvkStatCounter::DescriptorPoolCount);
     m_descriptorSetCount  = counters.getCtr(DxvkStatCounter::DescriptorSetCount);
+
+    uint64_t cacheHits   = counters.getCtr(DxvkStatCounter::DescriptorCacheHits);
+    uint64_t cacheMisses = counters.getCtr(DxvkStatCounter::DescriptorCacheMisses);
+
+    uint64_t diffHits    = cacheHits   - m_prevCacheHits;
+    uint64_t diffLookups = cacheMisses - m_prevCacheMisses + diffHits;
+
+    if (diffLookups)
+      m_cacheHitRate = (100 * diffHits) / diffLookups;
+
+    m_prevCacheHits   = cacheHits;
+    m_prevCacheMisses = cacheMisses;
   }
 
 
@@ -544,6 +855,17 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_descriptorSetCount));
 
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.25f, 0.5f, 1.0f },
+      "Set cache hits:");
+
+    renderer.drawText(16.0f,
+      { position.x + 216.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_cacheHitRate, "%"));
+
     position.y += 8.0f;
     return position;
   }
@@ -561,8 +883,24 @@ namespace dxvk::hud {
 
 
   void HudMemoryStatsItem::update(dxvk::high_resolution_clock::time_point time) {
-    for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++)
+    m_categoryVidmem = { };
+    m_categorySysmem = { };
+
+    for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++) {
       m_heaps[i] = m_device->getMemoryStats(i);
+
+      DxvkMemoryCategoryStats categories = m_device->getMemoryCategoryStats(i);
+      bool isDeviceLocal = m_memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+      for (uint32_t j = 0; j < DxvkMemoryCategoryCount; j++)
+        (isDeviceLocal ? m_categoryVidmem : m_categorySysmem)[j] += categories.memoryUsed[j];
+    }
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+    m_stagingAllocated = counters.getCtr(DxvkStatCounter::StagingMemoryAllocated);
+    m_stagingUsed      = counters.getCtr(DxvkStatCounter::StagingMemoryUsed);
+    m_mappedBar        = counters.getCtr(DxvkStatCounter::MappedMemoryBar);
+    m_mappedSysmem     = counters.getCtr(DxvkStatCounter::MappedMemorySysmem);
   }
 
 
@@ -593,7 +931,67 @@ namespace dxvk::hud {
       position.y += 4.0f;
     }
 
+    static const std::array<const char*, DxvkMemoryCategoryCount> s_categoryLabels = {{
+      "Render targets: ",
+      "Textures: ",
+      "Vertex/index: ",
+      "Constants: ",
+      "Staging data: ",
+      "Shader data: ",
+      "Internal: ",
+    }};
+
+    for (uint32_t i = 0; i < DxvkMemoryCategoryCount; i++) {
+      if (!m_categoryVidmem[i] && !m_categorySysmem[i])
+        continue;
+
+      std::string text = str::format(std::setfill(' '), std::setw(5), m_categoryVidmem[i] >> 20, " MB vid ",
+        std::setw(9), m_categorySysmem[i] >> 20, " MB sys");
+
+      position.y += 16.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 1.0f, 0.25f, 1.0f },
+        s_categoryLabels[i]);
+
+      renderer.drawText(16.0f,
+        { position.x + 168.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        text);
+      position.y += 4.0f;
+    }
+
+    std::string stagingText = str::format(std::setfill(' '), std::setw(5), m_stagingAllocated >> 20, " MB ",
+      std::setw(13), m_stagingUsed >> 20, " MB used");
+
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.25f, 1.0f },
+      "Staging: ");
+
+    renderer.drawText(16.0f,
+      { position.x + 168.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      stagingText);
+
     position.y += 4.0f;
+
+    std::string mappedText = str::format(std::setfill(' '), std::setw(5), m_mappedBar >> 20, " MB BAR ",
+      std::setw(9), m_mappedSysmem >> 20, " MB sysmem");
+
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.25f, 1.0f },
+      "Mapped: ");
+
+    renderer.drawText(16.0f,
+      { position.x + 168.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      mappedText);
+
+    position.y += 8.0f;
     return position;
   }
 
@@ -633,7 +1031,12 @@ namespace dxvk::hud {
 
       uint64_t syncTicks = m_maxCsSyncTicks / 100;
 
+      uint64_t liveChunks = counters.getCtr(DxvkStatCounter::CsChunkLiveCount);
+      uint64_t liveBytes  = counters.getCtr(DxvkStatCounter::CsChunkLiveBytes);
+      uint64_t peakBytes  = counters.getCtr(DxvkStatCounter::CsChunkPeakBytes);
+
       m_csChunkString = str::format(diffCsChunks);
+      m_csMemoryString = str::format(liveChunks, " (", liveBytes >> 10, " kB, peak ", peakBytes >> 10, " kB)");
       m_csSyncString = m_maxCsSyncCount
         ? str::format(m_maxCsSyncCount, " (", (syncTicks / 10), ".", (syncTicks % 10), " ms)")
         : str::format(m_maxCsSyncCount);
@@ -661,6 +1064,17 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       m_csChunkString);
 
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.25f, 1.0f },
+      "CS memory:");
+
+    renderer.drawText(16.0f,
+      { position.x + 132.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_csMemoryString);
+
     position.y += 20.0f;
     renderer.drawText(16.0f,
       { position.x, position.y },
@@ -677,6 +1091,86 @@ namespace dxvk::hud {
   }
 
 
+  HudThreadItem::HudThreadItem() {
+
+  }
+
+
+  HudThreadItem::~HudThreadItem() {
+
+  }
+
+
+  void HudThreadItem::update(dxvk::high_resolution_clock::time_point time) {
+    uint64_t ticks = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate).count();
+
+    if (ticks < UpdateInterval)
+      return;
+
+    std::vector<ThreadCpuTime> threads = ThreadFn::getCpuTimes();
+    std::unordered_map<uint32_t, uint64_t> cpuTimes;
+
+    m_groups.clear();
+
+    for (const auto& thread : threads) {
+      cpuTimes.insert({ thread.id, thread.cpuTime });
+
+      // Threads created since the last update only
+      // start contributing with the next update
+      auto prev = m_prevCpuTimes.find(thread.id);
+      uint64_t delta = prev != m_prevCpuTimes.end() && prev->second <= thread.cpuTime
+        ? thread.cpuTime - prev->second : 0;
+
+      std::string name = thread.name.empty() ? "unnamed" : thread.name;
+
+      auto group = std::find_if(m_groups.begin(), m_groups.end(),
+        [&name] (const ThreadGroup& g) { return g.name == name; });
+
+      if (group == m_groups.end())
+        group = m_groups.insert(m_groups.end(), { name, 0u, 0ull });
+
+      group->count   += 1;
+      group->cpuTime += delta;
+    }
+
+    // Store usage in tenths of a percent
+    for (auto& group : m_groups)
+      group.cpuTime = (1000 * group.cpuTime) / ticks;
+
+    std::sort(m_groups.begin(), m_groups.end(),
+      [] (const ThreadGroup& a, const ThreadGroup& b) { return a.name < b.name; });
+
+    m_prevCpuTimes = std::move(cpuTimes);
+    m_lastUpdate = time;
+  }
+
+
+  HudPos HudThreadItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    for (const auto& group : m_groups) {
+      position.y += 20.0f;
+
+      std::string label = group.count > 1
+        ? str::format(group.name, " (", group.count, "):")
+        : str::format(group.name, ":");
+
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 0.25f, 1.0f, 0.25f, 1.0f },
+        label);
+
+      renderer.drawText(16.0f,
+        { position.x + 228.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(group.cpuTime / 10, ".", group.cpuTime % 10, "%"));
+    }
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudGpuLoadItem::HudGpuLoadItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -728,6 +1222,62 @@ namespace dxvk::hud {
   }
 
 
+  HudUpscaleItem::HudUpscaleItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudUpscaleItem::~HudUpscaleItem() {
+
+  }
+
+
+  void HudUpscaleItem::update(dxvk::high_resolution_clock::time_point time) {
+    uint64_t ticks = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate).count();
+
+    if (ticks >= UpdateInterval) {
+      DxvkStatCounters counters = m_device->getStatCounters();
+      uint64_t currCount = counters.getCtr(DxvkStatCounter::PresentUpscaleCount);
+      uint64_t currTicks = counters.getCtr(DxvkStatCounter::PresentUpscaleTicks);
+
+      uint64_t diffCount = currCount - m_prevCount;
+      uint64_t diffTicks = currTicks - m_prevTicks;
+
+      if (diffCount) {
+        uint64_t us = diffTicks / diffCount;
+        m_upscaleString = str::format(us / 1000, ".", (us % 1000) / 100, (us % 100) / 10, " ms");
+      } else {
+        m_upscaleString = "n/a";
+      }
+
+      m_prevCount = currCount;
+      m_prevTicks = currTicks;
+      m_lastUpdate = time;
+    }
+  }
+
+
+  HudPos HudUpscaleItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 0.5f, 0.25f, 1.0f },
+      "Upscale:");
+
+    renderer.drawText(16.0f,
+      { position.x + 108.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_upscaleString);
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudCompilerActivityItem::HudCompilerActivityItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -237,6 +238,43 @@ namespace dxvk::hud {
   };
 
 
+  /**
+   * \brief HUD item to display frame latency
+   *
+   * Shows the average time each frame spends in the
+   * application, CS thread, submission queue, GPU and
+   * present, which helps identify the bottleneck.
+   */
+  class HudLatencyItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+    constexpr static uint32_t NumStages = 6;
+  public:
+
+    HudLatencyItem(const Rc<DxvkDevice>& device);
+
+    ~HudLatencyItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>  m_device;
+
+    std::array<uint64_t, NumStages>     m_sums = { };
+    uint64_t                            m_samples = 0;
+
+    std::array<std::string, NumStages>  m_strings;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief HUD item to display queue statistics
    */
@@ -301,6 +339,7 @@ namespace dxvk::hud {
     uint64_t          m_gpCount = 0;
     uint64_t          m_cpCount = 0;
     uint64_t          m_rpCount = 0;
+    uint64_t          m_rsCount = 0;
     uint64_t          m_pbCount = 0;
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
@@ -336,6 +375,82 @@ namespace dxvk::hud {
   };
 
 
+  /**
+   * \brief HUD item to display async pipeline stats
+   */
+  class HudAsyncPipelineItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudAsyncPipelineItem(const Rc<DxvkDevice>& device);
+
+    ~HudAsyncPipelineItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>  m_device;
+
+    uint64_t        m_prevSkippedDraws  = 0;
+    uint64_t        m_maxSkippedDraws   = 0;
+    uint64_t        m_pendingPipelines  = 0;
+
+    std::array<uint64_t, 3> m_queueDepth = { };
+
+    std::string     m_skippedString;
+    std::string     m_pendingString;
+
+    std::array<std::string, 3> m_queueStrings;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display pipeline compile times
+   *
+   * Shows a histogram of blocking and background
+   * pipeline compile times, as well as the shaders
+   * responsible for the longest blocking stalls.
+   */
+  class HudPipelineCompileItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+    constexpr static uint32_t MaxStallCount = 3;
+  public:
+
+    HudPipelineCompileItem(const Rc<DxvkDevice>& device);
+
+    ~HudPipelineCompileItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>  m_device;
+
+    std::array<std::array<std::string, DxvkPipelineHistogramSize>,
+      DxvkPipelineCompileTypeCount> m_histogramStrings;
+    std::array<std::string, DxvkPipelineCompileTypeCount> m_totalStrings;
+
+    std::vector<std::string> m_stallStrings;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief HUD item to display descriptor stats
    */
@@ -360,6 +475,10 @@ namespace dxvk::hud {
     uint64_t m_descriptorPoolCount = 0;
     uint64_t m_descriptorSetCount  = 0;
 
+    uint64_t m_prevCacheHits       = 0;
+    uint64_t m_prevCacheMisses     = 0;
+    uint64_t m_cacheHitRate        = 0;
+
   };
 
 
@@ -386,6 +505,15 @@ namespace dxvk::hud {
     VkPhysicalDeviceMemoryProperties  m_memory;
     DxvkMemoryStats                   m_heaps[VK_MAX_MEMORY_HEAPS];
 
+    std::array<uint64_t, DxvkMemoryCategoryCount> m_categoryVidmem = { };
+    std::array<uint64_t, DxvkMemoryCategoryCount> m_categorySysmem = { };
+
+    uint64_t                          m_stagingAllocated = 0;
+    uint64_t                          m_stagingUsed      = 0;
+
+    uint64_t                          m_mappedBar        = 0;
+    uint64_t                          m_mappedSysmem     = 0;
+
   };
 
 
@@ -421,6 +549,45 @@ namespace dxvk::hud {
 
     std::string m_csSyncString;
     std::string m_csChunkString;
+    std::string m_csMemoryString;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display thread CPU usage
+   *
+   * Shows the CPU usage of DXVK threads, in percent
+   * of a single core. Threads with the same name,
+   * such as worker threads, are combined.
+   */
+  class HudThreadItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudThreadItem();
+
+    ~HudThreadItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    struct ThreadGroup {
+      std::string name;
+      uint32_t    count;
+      uint64_t    cpuTime;
+    };
+
+    std::unordered_map<uint32_t, uint64_t> m_prevCpuTimes;
+    std::vector<ThreadGroup>  m_groups;
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
       = dxvk::high_resolution_clock::now();
@@ -460,6 +627,41 @@ namespace dxvk::hud {
   };
 
 
+  /**
+   * \brief HUD item to display upscaling cost
+   *
+   * Shows the average GPU time that the swap chain
+   * blitter spends on magnifying the back buffer.
+   */
+  class HudUpscaleItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudUpscaleItem(const Rc<DxvkDevice>& device);
+
+    ~HudUpscaleItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice> m_device;
+
+    uint64_t m_prevCount = 0;
+    uint64_t m_prevTicks = 0;
+
+    std::string m_upscaleString;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief HUD item to display pipeline compiler activity
    */
@@ -225,6 +225,7 @@ namespace dxvk::hud {
     info.stages         = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
                         | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     info.access         = VK_ACCESS_SHADER_READ_BIT;
+    info.category       = DxvkMemoryCategory::Meta;
     
     return m_device->createBuffer(info,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
@@ -252,6 +253,7 @@ namespace dxvk::hud {
                         | VK_PIPELINE_STAGE_TRANSFER_BIT;
     info.access         = VK_ACCESS_SHADER_READ_BIT
                         | VK_ACCESS_TRANSFER_WRITE_BIT;
+    info.category       = DxvkMemoryCategory::Meta;
     
     return m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   }
@@ -274,6 +276,7 @@ namespace dxvk::hud {
                         | VK_ACCESS_SHADER_READ_BIT;
     info.tiling         = VK_IMAGE_TILING_OPTIMAL;
     info.layout         = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    info.category       = DxvkMemoryCategory::Meta;
     
     return m_device->createImage(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   }
@@ -0,0 +1,70 @@
+#version 450
+
+layout(constant_id = 1) const bool s_gamma_bound = false;
+
+layout(binding = 0) uniform sampler2D s_image;
+layout(binding = 1) uniform sampler1D s_gamma;
+
+layout(location = 0) in  vec2 i_coord;
+layout(location = 0) out vec4 o_color;
+
+layout(push_constant)
+uniform present_info_t {
+  ivec2 src_offset;
+  uvec2 src_extent;
+  float sharpness;
+};
+
+// The present sampler uses unnormalized coordinates,
+// so all offsets below are in source pixels.
+vec4 fetch(vec2 coord) {
+  return textureLod(s_image, coord, 0.0f);
+}
+
+float luma(vec4 color) {
+  return dot(color.rgb, vec3(0.299f, 0.587f, 0.114f));
+}
+
+void main() {
+  vec2 coord = vec2(src_offset) + vec2(src_extent) * i_coord;
+
+  vec4 c = fetch(coord);
+  vec4 l = fetch(coord - vec2(1.0f, 0.0f));
+  vec4 r = fetch(coord + vec2(1.0f, 0.0f));
+  vec4 t = fetch(coord - vec2(0.0f, 1.0f));
+  vec4 b = fetch(coord + vec2(0.0f, 1.0f));
+
+  // Estimate the local edge direction from the luma gradient and
+  // interpolate along the edge rather than across it, which keeps
+  // edges from getting jagged or blurry when magnified.
+  vec2 grad = vec2(luma(r) - luma(l), luma(b) - luma(t));
+  float edge = length(grad);
+
+  if (edge > 1.0f / 64.0f) {
+    vec2 dir = vec2(-grad.y, grad.x) / edge;
+
+    vec4 e = 0.5f * (fetch(coord + 0.5f * dir) + fetch(coord - 0.5f * dir));
+    c = mix(c, e, clamp(4.0f * edge, 0.0f, 1.0f));
+  }
+
+  // Contrast-adaptive sharpening. Sharpen less in areas that
+  // already have high contrast, and clamp the result to the
+  // local range in order to avoid ringing artifacts.
+  vec4 lo = min(min(l, r), min(t, b));
+  vec4 hi = max(max(l, r), max(t, b));
+
+  vec3 amp = clamp(min(lo.rgb, 1.0f - hi.rgb) / max(hi.rgb, 1.0f / 256.0f), 0.0f, 1.0f);
+  vec3 w = sharpness * sqrt(amp);
+
+  vec3 avg = 0.25f * (l.rgb + r.rgb + t.rgb + b.rgb);
+  o_color.rgb = clamp(c.rgb + w * (c.rgb - avg), min(lo.rgb, c.rgb), max(hi.rgb, c.rgb));
+  o_color.a = c.a;
+
+  if (s_gamma_bound) {
+    o_color = vec4(
+      texture(s_gamma, o_color.r).r,
+      texture(s_gamma, o_color.g).g,
+      texture(s_gamma, o_color.b).b,
+      o_color.a);
+  }
+}
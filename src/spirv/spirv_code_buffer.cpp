@@ -52,20 +52,27 @@ namespace dxvk {
 
   void SpirvCodeBuffer::append(const SpirvCodeBuffer& other) {
     if (other.size() != 0) {
-      const size_t size = m_code.size();
-      m_code.resize(size + other.m_code.size());
-      
-            uint32_t* dst = this->m_code.data();
-      const uint32_t* src = other.m_code.data();
-      
-      std::memcpy(dst + size, src, other.size());
+      m_code.insert(m_code.end(),
+        other.m_code.begin(),
+        other.m_code.end());
       m_ptr += other.m_code.size();
     }
   }
+
+
+  void SpirvCodeBuffer::reserve(size_t dwords) {
+    m_code.reserve(dwords);
+  }
   
   
   void SpirvCodeBuffer::putWord(uint32_t word) {
-    m_code.insert(m_code.begin() + m_ptr, word);
+    // Appending is by far the most common case, and
+    // push_back is cheaper than a generic insertion
+    if (m_ptr == m_code.size())
+      m_code.push_back(word);
+    else
+      m_code.insert(m_code.begin() + m_ptr, word);
+
     m_ptr += 1;
   }
   
@@ -95,6 +95,16 @@ namespace dxvk {
      * \param [in] other Code buffer to append
      */
     void append(const SpirvCodeBuffer& other);
+
+    /**
+     * \brief Reserves storage for code
+     *
+     * Large shaders can be generated without repeatedly
+     * reallocating the buffer if the code size can be
+     * estimated in advance.
+     * \param [in] dwords Expected code size, in dwords
+     */
+    void reserve(size_t dwords);
     
     /**
      * \brief Appends an 32-bit word to the buffer
@@ -95,6 +95,29 @@ namespace dxvk {
 
     constexpr uint32_t shiftAmounts = 0x0c101420;
 
+    // A full block decodes to at most 32 dwords. As long as that
+    // fits into the output, we can unconditionally write both
+    // halves of each token and avoid all branches in the inner
+    // loop. Words written past the end of a single-dword token
+    // are always overwritten by the next token.
+    while (dstOffset + 32 <= m_size) {
+      uint32_t blockMask = m_code[srcOffset];
+
+      for (uint32_t i = 0; i < 16; i++) {
+        uint32_t schema = (blockMask >> (i << 1)) & 0x3;
+        uint32_t shift  = (shiftAmounts >> (schema << 3)) & 0xff;
+        uint64_t mask   = ~(~0ull << shift);
+        uint64_t encode = m_code[srcOffset + i + 1];
+
+        data[dstOffset + 0] = encode & mask;
+        data[dstOffset + 1] = encode >> shift;
+
+        dstOffset += 1 + (schema != 0);
+      }
+
+      srcOffset += 17;
+    }
+
     while (dstOffset < m_size) {
       uint32_t blockMask = m_code[srcOffset];
 
@@ -16,7 +16,25 @@ namespace dxvk {
   
   
   SpirvCodeBuffer SpirvModule::compile() const {
+    // Allocate the final buffer once instead of growing
+    // it for every section that gets appended to it
+    constexpr size_t HeaderSize = 5;
+
+    size_t size = HeaderSize
+      + m_capabilities.dwords()
+      + m_extensions.dwords()
+      + m_instExt.dwords()
+      + m_memoryModel.dwords()
+      + m_entryPoints.dwords()
+      + m_execModeInfo.dwords()
+      + m_debugNames.dwords()
+      + m_annotations.dwords()
+      + m_typeConstDefs.dwords()
+      + m_variables.dwords()
+      + m_code.dwords();
+
     SpirvCodeBuffer result;
+    result.reserve(size);
     result.putHeader(m_version, m_id);
     result.append(m_capabilities);
     result.append(m_extensions);
@@ -33,6 +51,11 @@ namespace dxvk {
   }
   
   
+  void SpirvModule::reserveCode(size_t dwords) {
+    m_code.reserve(dwords);
+  }
+
+
   uint32_t SpirvModule::allocateId() {
     return m_id++;
   }
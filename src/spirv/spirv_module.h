@@ -50,6 +50,13 @@ namespace dxvk {
     ~SpirvModule();
     
     SpirvCodeBuffer compile() const;
+
+    /**
+     * \brief Reserves storage for function code
+     *
+     * \param [in] dwords Expected code size, in dwords
+     */
+    void reserveCode(size_t dwords);
     
     size_t getInsertionPtr() {
       return m_code.getInsertionPtr();
@@ -0,0 +1,623 @@
+#include "spirv_optimizer.h"
+
+namespace dxvk {
+
+  SpirvOptimizer::SpirvOptimizer(const SpirvCodeBuffer& code)
+  : m_words(code.data(), code.data() + code.dwords()) {
+
+  }
+
+
+  SpirvOptimizer::~SpirvOptimizer() {
+
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::optimize() {
+    if (!parseModule())
+      return SpirvCodeBuffer(m_words.size(), m_words.data());
+
+    m_stats.insCountBefore = m_codeCount;
+
+    findForwardableVariables();
+    processFunctions();
+    removeDeadCode();
+    removeDeadNames();
+    return buildModule();
+  }
+
+
+  bool SpirvOptimizer::parseModule() {
+    if (m_words.size() < HeaderSize || m_words[0] != spv::MagicNumber)
+      return false;
+
+    m_bound = m_words[3];
+    m_defs.resize(m_bound, InvalidIns);
+    m_flags.resize(m_bound, 0);
+
+    uint32_t offset = HeaderSize;
+
+    while (offset < m_words.size()) {
+      Ins ins;
+      ins.offset = offset;
+      ins.length = m_words[offset] >> spv::WordCountShift;
+      ins.live   = true;
+
+      if (!ins.length || offset + ins.length > m_words.size())
+        return false;
+
+      uint32_t index = m_ins.size();
+      m_ins.push_back(ins);
+
+      spv::Op op = getOp(ins);
+
+      if (op == spv::OpFunction && m_funcStart == InvalidIns)
+        m_funcStart = index;
+
+      uint32_t resultIndex = getResultIndex(op);
+
+      if (resultIndex && resultIndex < ins.length) {
+        uint32_t id = getArg(ins, resultIndex);
+
+        if (id < m_bound)
+          m_defs[id] = index;
+      }
+
+      if (op == spv::OpDecorate)
+        setFlag(getArg(ins, 1), FlagDecorated);
+
+      if (op == spv::OpVariable && getArg(ins, 3) == spv::StorageClassFunction)
+        setFlag(getArg(ins, 2), FlagFunctionVar | FlagForwardable);
+
+      offset += ins.length;
+    }
+
+    m_codeCount = m_ins.size();
+
+    if (m_funcStart == InvalidIns)
+      m_funcStart = m_codeCount;
+
+    return true;
+  }
+
+
+  void SpirvOptimizer::findForwardableVariables() {
+    // Only variables that are exclusively accessed through
+    // plain loads and stores can be tracked reliably. Every
+    // other word that matches a variable ID disqualifies the
+    // variable, even if it is a literal.
+    for (const auto& ins : m_ins) {
+      spv::Op op = getOp(ins);
+
+      if (isDebugOp(op))
+        continue;
+
+      uint32_t ptrIndex = 0;
+      uint32_t memIndex = 0;
+
+      if (op == spv::OpLoad) {
+        ptrIndex = 3;
+        memIndex = 4;
+      } else if (op == spv::OpStore) {
+        ptrIndex = 1;
+        memIndex = 3;
+      }
+
+      if (ptrIndex && memIndex < ins.length
+       && (getArg(ins, memIndex) & spv::MemoryAccessVolatileMask))
+        clearFlag(getArg(ins, ptrIndex), FlagForwardable);
+
+      uint32_t resultIndex = getResultIndex(op);
+
+      for (uint32_t i = 1; i < ins.length; i++) {
+        if (i != ptrIndex && i != resultIndex)
+          clearFlag(getArg(ins, i), FlagForwardable);
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::processFunctions() {
+    std::vector<uint32_t> values(m_bound, 0);
+    std::vector<uint32_t> stores(m_bound, InvalidIns);
+    std::vector<uint32_t> blocks(m_bound, 0);
+
+    uint32_t block = 0;
+
+    for (uint32_t i = m_funcStart; i < m_codeCount; i++) {
+      if (!m_ins[i].live)
+        continue;
+
+      Ins ins = m_ins[i];
+
+      switch (getOp(ins)) {
+        case spv::OpFunction:
+        case spv::OpLabel: {
+          block += 1;
+        } break;
+
+        case spv::OpStore: {
+          uint32_t ptr = getArg(ins, 1);
+
+          if (!hasFlag(ptr, FlagForwardable))
+            break;
+
+          // Any load in between was forwarded, so a previous
+          // store in the same block can never be observed
+          if (blocks[ptr] == block && stores[ptr] != InvalidIns)
+            m_ins[stores[ptr]].live = false;
+
+          values[ptr] = getArg(ins, 2);
+          stores[ptr] = i;
+          blocks[ptr] = block;
+        } break;
+
+        case spv::OpLoad: {
+          uint32_t ptr = getArg(ins, 3);
+
+          if (!hasFlag(ptr, FlagForwardable) || blocks[ptr] != block
+           || hasFlag(getArg(ins, 2), FlagDecorated))
+            break;
+
+          rewriteAsCopy(i, values[ptr]);
+          m_stats.forwardedLoads += 1;
+
+          foldInstruction(i);
+        } break;
+
+        case spv::OpCopyObject:
+        case spv::OpCompositeExtract:
+        case spv::OpCompositeConstruct:
+        case spv::OpVectorShuffle:
+        case spv::OpSelect: {
+          foldInstruction(i);
+        } break;
+
+        default:;
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::foldInstruction(
+          uint32_t              index) {
+    Ins ins = m_ins[index];
+
+    // Moving decorated results to the
+    // global scope may not be legal
+    if (hasFlag(getArg(ins, 2), FlagDecorated))
+      return;
+
+    switch (getOp(ins)) {
+      case spv::OpCopyObject: {
+        cloneConstant(index, getArg(ins, 3));
+      } break;
+
+      case spv::OpCompositeExtract: {
+        uint32_t id = getArg(ins, 3);
+
+        for (uint32_t i = 4; i < ins.length && id; i++)
+          id = getConstituent(id, getArg(ins, i));
+
+        if (id)
+          cloneConstant(index, id);
+      } break;
+
+      case spv::OpCompositeConstruct: {
+        uint32_t typeId = getArg(ins, 1);
+
+        if (getDefOp(typeId) != spv::OpTypeVector
+         || getArg(m_ins[m_defs[typeId]], 3) != ins.length - 3)
+          return;
+
+        std::vector<uint32_t> words(ins.length);
+        words[0] = spv::OpConstantComposite | (ins.length << spv::WordCountShift);
+
+        for (uint32_t i = 1; i < ins.length; i++) {
+          words[i] = getArg(ins, i);
+
+          if (i >= 3) {
+            spv::Op op = getDefOp(words[i]);
+
+            if (op != spv::OpConstant && op != spv::OpConstantTrue && op != spv::OpConstantFalse)
+              return;
+          }
+        }
+
+        addConstant(index, std::move(words));
+      } break;
+
+      case spv::OpVectorShuffle: {
+        uint32_t aId = getArg(ins, 3);
+        uint32_t bId = getArg(ins, 4);
+
+        uint32_t aCount = getConstituentCount(aId);
+
+        if (!aCount)
+          return;
+
+        std::vector<uint32_t> words(ins.length - 2);
+        words[0] = spv::OpConstantComposite | (uint32_t(words.size()) << spv::WordCountShift);
+        words[1] = getArg(ins, 1);
+        words[2] = getArg(ins, 2);
+
+        for (uint32_t i = 5; i < ins.length; i++) {
+          uint32_t component = getArg(ins, i);
+
+          if (component == ~0u)
+            return;
+
+          uint32_t id = component < aCount
+            ? getConstituent(aId, component)
+            : getConstituent(bId, component - aCount);
+
+          if (!id)
+            return;
+
+          words[i - 2] = id;
+        }
+
+        addConstant(index, std::move(words));
+      } break;
+
+      case spv::OpSelect: {
+        spv::Op op = getDefOp(getArg(ins, 3));
+
+        if (op != spv::OpConstantTrue && op != spv::OpConstantFalse)
+          return;
+
+        rewriteAsCopy(index, getArg(ins, op == spv::OpConstantTrue ? 4 : 5));
+        foldInstruction(index);
+      } break;
+
+      default:;
+    }
+  }
+
+
+  void SpirvOptimizer::rewriteAsCopy(
+          uint32_t              index,
+          uint32_t              operand) {
+    Ins& ins = m_ins[index];
+
+    // Copies take no more space than any of the
+    // instructions we rewrite, so do it in-place
+    ins.length = 4;
+
+    m_words[ins.offset + 0] = spv::OpCopyObject | (ins.length << spv::WordCountShift);
+    m_words[ins.offset + 3] = operand;
+  }
+
+
+  void SpirvOptimizer::cloneConstant(
+          uint32_t              index,
+          uint32_t              operand) {
+    if (!isConstantOp(getDefOp(operand)))
+      return;
+
+    const Ins& def = m_ins[m_defs[operand]];
+
+    std::vector<uint32_t> words(
+      m_words.begin() + def.offset,
+      m_words.begin() + def.offset + def.length);
+
+    words[1] = getArg(m_ins[index], 1);
+    words[2] = getArg(m_ins[index], 2);
+
+    addConstant(index, std::move(words));
+  }
+
+
+  void SpirvOptimizer::addConstant(
+          uint32_t              index,
+          std::vector<uint32_t>&& words) {
+    uint32_t resultId = words[2];
+
+    Ins ins;
+    ins.offset = m_words.size();
+    ins.length = words.size();
+    ins.live   = true;
+
+    m_words.insert(m_words.end(), words.begin(), words.end());
+
+    // The constant reuses the result ID of the original
+    // instruction, so no uses need to be rewritten
+    m_ins[index].live = false;
+    m_defs[resultId] = m_ins.size();
+    m_ins.push_back(ins);
+
+    m_stats.foldedConstants += 1;
+  }
+
+
+  void SpirvOptimizer::removeDeadCode() {
+    std::vector<uint32_t> uses(m_bound, 0);
+
+    for (uint32_t i = 0; i < m_ins.size(); i++) {
+      if (m_ins[i].live)
+        countUses(i, uses, 1);
+    }
+
+    // Walk backwards so that chains of dead instructions
+    // are mostly removed in a single iteration
+    bool progress = true;
+
+    while (progress) {
+      progress = false;
+
+      for (uint32_t i = m_codeCount; i > m_funcStart; i--) {
+        if (!m_ins[i - 1].live || !isDead(i - 1, uses))
+          continue;
+
+        countUses(i - 1, uses, -1);
+        removeIns(i - 1);
+
+        progress = true;
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::removeDeadNames() {
+    for (uint32_t i = 0; i < m_funcStart; i++) {
+      spv::Op op = getOp(m_ins[i]);
+
+      if ((op == spv::OpName || op == spv::OpDecorate)
+       && hasFlag(getArg(m_ins[i], 1), FlagRemoved))
+        m_ins[i].live = false;
+    }
+  }
+
+
+  bool SpirvOptimizer::isDead(
+          uint32_t              index,
+    const std::vector<uint32_t>& uses) const {
+    const Ins& ins = m_ins[index];
+    spv::Op op = getOp(ins);
+
+    switch (op) {
+      case spv::OpStore: {
+        uint32_t ptr = getArg(ins, 1);
+        return hasFlag(ptr, FlagFunctionVar) && !uses[ptr];
+      }
+
+      case spv::OpLoad: {
+        if (ins.length > 4 && (getArg(ins, 4) & spv::MemoryAccessVolatileMask))
+          return false;
+      } break;
+
+      case spv::OpVariable: {
+        if (getArg(ins, 3) != spv::StorageClassFunction)
+          return false;
+      } break;
+
+      default: {
+        if (!isPureOp(op))
+          return false;
+      }
+    }
+
+    uint32_t id = getArg(ins, 2);
+    return id < m_bound && !uses[id];
+  }
+
+
+  void SpirvOptimizer::countUses(
+          uint32_t              index,
+          std::vector<uint32_t>& uses,
+          int32_t               delta) const {
+    const Ins& ins = m_ins[index];
+    spv::Op op = getOp(ins);
+
+    if (isDebugOp(op))
+      return;
+
+    // Stores do not count as uses of function variables,
+    // so that variables which are never read are dead
+    uint32_t skipIndex = getResultIndex(op);
+
+    if (op == spv::OpStore && hasFlag(getArg(ins, 1), FlagFunctionVar))
+      skipIndex = 1;
+
+    for (uint32_t i = 1; i < ins.length; i++) {
+      uint32_t id = getArg(ins, i);
+
+      if (i != skipIndex && id < m_bound)
+        uses[id] += delta;
+    }
+  }
+
+
+  void SpirvOptimizer::removeIns(
+          uint32_t              index) {
+    Ins& ins = m_ins[index];
+
+    uint32_t resultIndex = getResultIndex(getOp(ins));
+
+    if (resultIndex)
+      setFlag(getArg(ins, resultIndex), FlagRemoved);
+
+    ins.live = false;
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::buildModule() {
+    std::vector<uint32_t> code;
+    code.reserve(m_words.size());
+    code.insert(code.end(), m_words.begin(), m_words.begin() + HeaderSize);
+
+    auto emit = [&] (uint32_t first, uint32_t last) {
+      for (uint32_t i = first; i < last; i++) {
+        const Ins& ins = m_ins[i];
+
+        if (ins.live) {
+          code.insert(code.end(),
+            m_words.begin() + ins.offset,
+            m_words.begin() + ins.offset + ins.length);
+          m_stats.insCountAfter += 1;
+        }
+      }
+    };
+
+    // Folded constants go to the end of the global
+    // section, right before the first function
+    emit(0, m_funcStart);
+    emit(m_codeCount, m_ins.size());
+    emit(m_funcStart, m_codeCount);
+
+    return SpirvCodeBuffer(code.size(), code.data());
+  }
+
+
+  uint32_t SpirvOptimizer::getConstituent(
+          uint32_t              id,
+          uint32_t              index) const {
+    if (getDefOp(id) != spv::OpConstantComposite)
+      return 0;
+
+    return getArg(m_ins[m_defs[id]], 3 + index);
+  }
+
+
+  uint32_t SpirvOptimizer::getConstituentCount(
+          uint32_t              id) const {
+    if (getDefOp(id) != spv::OpConstantComposite)
+      return 0;
+
+    return m_ins[m_defs[id]].length - 3;
+  }
+
+
+  spv::Op SpirvOptimizer::getDefOp(
+          uint32_t              id) const {
+    if (id >= m_bound || m_defs[id] == InvalidIns)
+      return spv::OpNop;
+
+    const Ins& def = m_ins[m_defs[id]];
+    return def.live ? getOp(def) : spv::OpNop;
+  }
+
+
+  uint32_t SpirvOptimizer::getResultIndex(spv::Op op) {
+    if (op == spv::OpTypeVector)
+      return 1;
+
+    if (op == spv::OpVariable || op == spv::OpLoad
+     || isConstantOp(op) || isPureOp(op))
+      return 2;
+
+    return 0;
+  }
+
+
+  bool SpirvOptimizer::isPureOp(spv::Op op) {
+    switch (op) {
+      case spv::OpCopyObject:
+      case spv::OpPhi:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpVectorInsertDynamic:
+      case spv::OpVectorShuffle:
+      case spv::OpCompositeConstruct:
+      case spv::OpCompositeExtract:
+      case spv::OpCompositeInsert:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpUConvert:
+      case spv::OpSConvert:
+      case spv::OpFConvert:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpMatrixTimesScalar:
+      case spv::OpVectorTimesMatrix:
+      case spv::OpMatrixTimesVector:
+      case spv::OpMatrixTimesMatrix:
+      case spv::OpDot:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+
+  bool SpirvOptimizer::isConstantOp(spv::Op op) {
+    return op == spv::OpConstant
+        || op == spv::OpConstantTrue
+        || op == spv::OpConstantFalse
+        || op == spv::OpConstantComposite
+        || op == spv::OpConstantNull;
+  }
+
+
+  bool SpirvOptimizer::isDebugOp(spv::Op op) {
+    return op == spv::OpName
+        || op == spv::OpMemberName
+        || op == spv::OpDecorate
+        || op == spv::OpMemberDecorate;
+  }
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V optimizer statistics
+   */
+  struct SpirvOptimizerStats {
+    uint32_t insCountBefore   = 0;
+    uint32_t insCountAfter    = 0;
+    uint32_t forwardedLoads   = 0;
+    uint32_t foldedConstants  = 0;
+  };
+
+
+  /**
+   * \brief Lightweight SPIR-V optimizer
+   *
+   * Cleans up some of the redundant code generated by
+   * the shader compilers so that drivers with simple
+   * shader compilers do not have to deal with it:
+   *
+   * - Loads from function-local variables are replaced by
+   *   the value stored within the same block, and stores
+   *   that get overwritten within a block are removed.
+   * - Composite operations on constants are folded into
+   *   new constants.
+   * - Instructions without side effects whose results
+   *   are never used are removed.
+   *
+   * The pass only looks at instructions it knows, and
+   * treats every other instruction conservatively.
+   */
+  class SpirvOptimizer {
+    constexpr static uint32_t HeaderSize = 5;
+    constexpr static uint32_t InvalidIns = ~0u;
+
+    constexpr static uint8_t FlagFunctionVar  = 0x1;
+    constexpr static uint8_t FlagForwardable  = 0x2;
+    constexpr static uint8_t FlagDecorated    = 0x4;
+    constexpr static uint8_t FlagRemoved      = 0x8;
+  public:
+
+    SpirvOptimizer(const SpirvCodeBuffer& code);
+
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Runs the optimizer
+     *
+     * Returns the unmodified code if the
+     * module cannot be parsed.
+     * \returns Optimized code
+     */
+    SpirvCodeBuffer optimize();
+
+    /**
+     * \brief Retrieves optimizer statistics
+     * \returns Statistics for the optimized module
+     */
+    SpirvOptimizerStats getStats() const {
+      return m_stats;
+    }
+
+  private:
+
+    struct Ins {
+      uint32_t offset;
+      uint32_t length;
+      bool     live;
+    };
+
+    std::vector<uint32_t> m_words;
+    std::vector<Ins>      m_ins;
+    std::vector<uint32_t> m_defs;
+    std::vector<uint8_t>  m_flags;
+
+    uint32_t m_bound      = 0;
+    uint32_t m_funcStart  = InvalidIns;
+    uint32_t m_codeCount  = 0;
+
+    SpirvOptimizerStats m_stats;
+
+    bool parseModule();
+
+    void findForwardableVariables();
+
+    void processFunctions();
+
+    void foldInstruction(
+            uint32_t              index);
+
+    void rewriteAsCopy(
+            uint32_t              index,
+            uint32_t              operand);
+
+    void cloneConstant(
+            uint32_t              index,
+            uint32_t              operand);
+
+    void addConstant(
+            uint32_t              index,
+            std::vector<uint32_t>&& words);
+
+    void removeDeadCode();
+
+    void removeDeadNames();
+
+    bool isDead(
+            uint32_t              index,
+      const std::vector<uint32_t>& uses) const;
+
+    void countUses(
+            uint32_t              index,
+            std::vector<uint32_t>& uses,
+            int32_t               delta) const;
+
+    void removeIns(
+            uint32_t              index);
+
+    SpirvCodeBuffer buildModule();
+
+    uint32_t getConstituent(
+            uint32_t              id,
+            uint32_t              index) const;
+
+    uint32_t getConstituentCount(
+            uint32_t              id) const;
+
+    spv::Op getDefOp(
+            uint32_t              id) const;
+
+    spv::Op getOp(const Ins& ins) const {
+      return spv::Op(m_words[ins.offset] & spv::OpCodeMask);
+    }
+
+    uint32_t getArg(const Ins& ins, uint32_t idx) const {
+      return idx < ins.length ? m_words[ins.offset + idx] : 0;
+    }
+
+    bool hasFlag(uint32_t id, uint8_t flag) const {
+      return id < m_bound && (m_flags[id] & flag);
+    }
+
+    void setFlag(uint32_t id, uint8_t flag) {
+      if (id < m_bound)
+        m_flags[id] |= flag;
+    }
+
+    void clearFlag(uint32_t id, uint8_t flag) {
+      if (id < m_bound)
+        m_flags[id] &= ~flag;
+    }
+
+    static uint32_t getResultIndex(spv::Op op);
+
+    static bool isPureOp(spv::Op op);
+
+    static bool isConstantOp(spv::Op op);
+
+    static bool isDebugOp(spv::Op op);
+
+  };
+
+}
@@ -1,7 +1,6 @@
+#include <algorithm>
 #include <array>
 #include <fstream>
-#include <sstream>
-#include <iostream>
 #include <regex>
 #include <utility>
 
@@ -600,6 +599,192 @@ namespace dxvk {
   }};
 
 
+  /**
+   * \brief Index over built-in app profiles
+   *
+   * Most profiles match a plain executable name, e.g.
+   * \c \\Game\.exe$, which can be checked with a hash
+   * lookup. Only the remaining patterns are evaluated as
+   * regular expressions, and only if the executable path
+   * contains the literal text each pattern starts with.
+   */
+  class AppProfileIndex {
+
+  public:
+
+    AppProfileIndex() {
+      for (size_t i = 0; i < g_appDefaults.size(); i++) {
+        const char* pattern = g_appDefaults[i].first;
+        std::string literal;
+
+        if (parseLiteral(pattern, literal)) {
+          m_literals[getFileName(literal)].push_back({ i, "\\" + literal });
+        } else {
+          m_patterns.push_back({ i, "\\" + parsePrefix(pattern) });
+        }
+      }
+    }
+
+    /**
+     * \brief Finds profile for the given executable
+     *
+     * \param [in] appName Executable path
+     * \returns Index of the first matching profile, or
+     *    the number of profiles if none matches
+     */
+    size_t find(const std::string& appName) const {
+      std::string path = Config::toLower(appName);
+      size_t result = g_appDefaults.size();
+
+      auto literals = m_literals.find(getFileName(path));
+
+      if (literals != m_literals.end()) {
+        for (const auto& entry : literals->second) {
+          if (entry.index < result && endsWith(path, entry.text))
+            result = entry.index;
+        }
+      }
+
+      // Patterns are sorted by index, so we can stop as
+      // soon as a literal match takes precedence
+      for (const auto& entry : m_patterns) {
+        if (entry.index >= result)
+          break;
+
+        if (path.find(entry.text) == std::string::npos)
+          continue;
+
+        std::regex expr(g_appDefaults[entry.index].first, std::regex::extended | std::regex::icase);
+
+        if (std::regex_search(appName, expr))
+          return entry.index;
+      }
+
+      return result;
+    }
+
+  private:
+
+    struct Entry {
+      size_t      index;
+      std::string text;
+    };
+
+    std::unordered_map<std::string, std::vector<Entry>> m_literals;
+    std::vector<Entry>                                  m_patterns;
+
+    static bool isLiteralChar(char ch) {
+      return (ch >= '0' && ch <= '9')
+          || (ch >= 'a' && ch <= 'z')
+          || (ch >= 'A' && ch <= 'Z')
+          || (ch == ' ' || ch == '_' || ch == '-');
+    }
+
+    static bool endsWith(const std::string& str, const std::string& suffix) {
+      return str.size() >= suffix.size()
+          && !str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+    }
+
+    static std::string getFileName(const std::string& path) {
+      size_t n = path.rfind('\\');
+
+      return n != std::string::npos
+        ? path.substr(n + 1) : path;
+    }
+
+    /**
+     * \brief Parses literal escaped character
+     *
+     * \param [in] pattern Pattern string
+     * \param [in] n Index of the backslash
+     * \returns Escaped character if it is a backslash
+     *    or a dot, or zero for any other sequence
+     */
+    static char parseEscape(const char* pattern, size_t n) {
+      char ch = pattern[n + 1];
+      return (ch == '\\' || ch == '.') ? ch : '\0';
+    }
+
+    /**
+     * \brief Checks whether a pattern is a plain file name
+     *
+     * Accepts patterns of the form \c \\Name\.exe$, which
+     * only match paths ending with the given name.
+     * \param [in] pattern Pattern string
+     * \param [out] literal Lower-case name to match
+     * \returns \c true if the pattern is a plain name
+     */
+    static bool parseLiteral(const char* pattern, std::string& literal) {
+      if (pattern[0] != '\\' || pattern[1] != '\\')
+        return false;
+
+      for (size_t n = 2; pattern[n]; n++) {
+        if (isLiteralChar(pattern[n])) {
+          literal += pattern[n];
+        } else if (pattern[n] == '\\' && parseEscape(pattern, n)) {
+          literal += pattern[++n];
+        } else {
+          literal = Config::toLower(literal);
+          return pattern[n] == '$' && !pattern[n + 1];
+        }
+      }
+
+      return false;
+    }
+
+    /**
+     * \brief Extracts literal prefix of a pattern
+     *
+     * Returns the lower-case text following the initial
+     * backslash up to the first special character. Any
+     * path matching the pattern must contain this text.
+     * \param [in] pattern Pattern string
+     * \returns Literal prefix, may be empty
+     */
+    static std::string parsePrefix(const char* pattern) {
+      std::string prefix;
+
+      if (pattern[0] != '\\' || pattern[1] != '\\')
+        return prefix;
+
+      // A top-level alternation may not contain the prefix at all
+      for (size_t n = 0, depth = 0; pattern[n]; n++) {
+        if (pattern[n] == '\\' && pattern[n + 1])
+          n += 1;
+        else if (pattern[n] == '(')
+          depth += 1;
+        else if (pattern[n] == ')')
+          depth -= 1;
+        else if (pattern[n] == '|' && !depth)
+          return prefix;
+      }
+
+      size_t n = 2;
+
+      while (pattern[n]) {
+        if (isLiteralChar(pattern[n])) {
+          prefix += pattern[n++];
+        } else if (pattern[n] == '\\' && parseEscape(pattern, n)) {
+          prefix += pattern[n + 1];
+          n += 2;
+        } else {
+          break;
+        }
+      }
+
+      // Quantifiers apply to the last character, which
+      // therefore isn't necessarily part of the path
+      char ch = pattern[n];
+
+      if (!prefix.empty() && (ch == '?' || ch == '*' || ch == '{'))
+        prefix.pop_back();
+
+      return Config::toLower(prefix);
+    }
+
+  };
+
+
   static bool isWhitespace(char ch) {
     return ch == ' ' || ch == '\x9' || ch == '\r';
   }
@@ -626,8 +811,8 @@ namespace dxvk {
 
 
   static void parseUserConfigLine(Config& config, ConfigContext& ctx, const std::string& line) {
-    std::stringstream key;
-    std::stringstream value;
+    std::string key;
+    std::string value;
 
     // Extract the key
     size_t n = skipWhitespace(line, 0);
@@ -639,13 +824,13 @@ namespace dxvk {
       while (e > n && line[e] != ']')
         e -= 1;
 
-      while (n < e)
-        key << line[n++];
+      if (n < e)
+        key.assign(line, n, e - n);
       
-      ctx.active = key.str() == env::getExeName();
+      ctx.active = key == env::getExeName();
     } else {
       while (n < line.size() && isValidKeyChar(line[n]))
-        key << line[n++];
+        key += line[n++];
       
       // Check whether the next char is a '='
       n = skipWhitespace(line, n);
@@ -664,11 +849,11 @@ namespace dxvk {
           insideString = !insideString;
           n++;
         } else
-          value << line[n++];
+          value += line[n++];
       }
       
       if (ctx.active)
-        config.setOption(key.str(), value.str());
+        config.setOption(key, value);
     }
   }
 
@@ -787,11 +972,9 @@ namespace dxvk {
 
 
   Config Config::getAppConfig(const std::string& appName) {
-    auto appConfig = std::find_if(g_appDefaults.begin(), g_appDefaults.end(),
-      [&appName] (const std::pair<const char*, Config>& pair) {
-        std::regex expr(pair.first, std::regex::extended | std::regex::icase);
-        return std::regex_search(appName, expr);
-      });
+    static const AppProfileIndex s_index;
+
+    auto appConfig = g_appDefaults.begin() + s_index.find(appName);
     
     if (appConfig != g_appDefaults.end()) {
       // Inform the user that we loaded a default config
@@ -830,11 +1013,26 @@ namespace dxvk {
     ConfigContext ctx;
     ctx.active = true;
 
-    // Parse the file line by line
+    // Read the entire file at once and parse it line by line
+    stream.seekg(0, std::ios::end);
+    std::string data(size_t(stream.tellg()), '\0');
+    stream.seekg(0, std::ios::beg);
+    stream.read(data.data(), data.size());
+    data.resize(size_t(stream.gcount()));
+
     std::string line;
 
-    while (std::getline(stream, line))
+    for (size_t n = 0; n < data.size(); ) {
+      size_t e = data.find('\n', n);
+
+      if (e == std::string::npos)
+        e = data.size();
+
+      line.assign(data, n, e - n);
       parseUserConfigLine(config, ctx, line);
+
+      n = e + 1;
+    }
     
     return config;
   }
@@ -1,6 +1,7 @@
 #include "log.h"
 
 #include "../util_env.h"
+#include "../util_likely.h"
 
 namespace dxvk {
   
@@ -12,10 +13,59 @@ namespace dxvk {
       if (!path.empty())
         m_fileStream = std::ofstream(str::tows(path.c_str()).c_str());
     }
+
+    for (uint32_t i = 0; i < QueueSize; i++)
+      m_entries[i].seq.store(i, std::memory_order_relaxed);
   }
   
   
-  Logger::~Logger() { }
+  Logger::~Logger() {
+    if (m_state.load() != WriterState::Running)
+      return;
+
+    // Joining the writer thread is not safe here since this
+    // runs while the loader lock is held. Instead, wait for
+    // the writer to finish, and if it does not, assume that
+    // it was terminated on process exit and write any
+    // remaining messages on this thread. Don't block on the
+    // mutex either, a terminated thread may still own it.
+    m_stopped.store(true, std::memory_order_release);
+
+    if (m_mutex.try_lock()) {
+      m_cond.notify_one();
+      m_mutex.unlock();
+    } else {
+      m_cond.notify_one();
+    }
+
+    bool finished = false;
+
+    for (uint32_t i = 0; i < 10 && !finished; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      finished = m_state.load(std::memory_order_acquire) == WriterState::Finished;
+    }
+
+    // The writer may just be slow rather than terminated. Only
+    // drain the queue once we own its consumer side, the writer
+    // exits instead of popping messages once we do. If a writer
+    // that was terminated mid-write still owns it, give up.
+    if (!finished) {
+      bool owned = false;
+
+      for (uint32_t i = 0; i < 10 && !owned; i++) {
+        owned = !m_consuming.exchange(true, std::memory_order_acquire);
+
+        if (!owned)
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      if (owned)
+        writePending();
+    }
+
+    m_thread.detach();
+  }
+
   
   
   void Logger::trace(const std::string& message) {
@@ -49,24 +99,207 @@ namespace dxvk {
   
   
   void Logger::emitMsg(LogLevel level, const std::string& message) {
-    if (level >= m_minLevel) {
+    if (level < m_minLevel)
+      return;
+
+    WriterState state = m_state.load(std::memory_order_acquire);
+
+    if (unlikely(state == WriterState::Idle)) {
+      startWriter();
+      state = m_state.load(std::memory_order_acquire);
+    }
+
+    if (unlikely(state == WriterState::Failed)) {
       std::lock_guard<dxvk::mutex> lock(m_mutex);
-      
-      static std::array<const char*, 5> s_prefixes
-        = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
-      
-      const char* prefix = s_prefixes.at(static_cast<uint32_t>(level));
+      writeMsg(level, message);
+      return;
+    }
+
+    bool pushed = pushMsg(level, message);
+
+    // Errors are rare and usually important, so give the
+    // writer a chance to catch up rather than dropping them
+    for (uint32_t i = 0; unlikely(!pushed && level >= LogLevel::Error) && i < 1000; i++) {
+      if (m_stopped.load(std::memory_order_acquire))
+        break;
+
+      m_cond.notify_one();
+      dxvk::this_thread::yield();
+      pushed = pushMsg(level, message);
+    }
+
+    if (likely(pushed))
+      m_cond.notify_one();
+    else
+      m_dropCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+
+  bool Logger::pushMsg(LogLevel level, const std::string& message) {
+    uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+    while (true) {
+      LogEntry& entry = m_entries[pos & (QueueSize - 1)];
+
+      uint64_t seq = entry.seq.load(std::memory_order_acquire);
+      int64_t diff = int64_t(seq - pos);
+
+      if (diff == 0) {
+        // Slot is free, try to claim it
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          entry.level = level;
+          entry.message = message;
+          entry.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // Writer has not consumed this slot yet
+        return false;
+      } else {
+        // Another thread claimed the slot
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+
+  bool Logger::popMsg(LogLevel& level, std::string& message) {
+    LogEntry& entry = m_entries[m_dequeuePos & (QueueSize - 1)];
+
+    if (entry.seq.load(std::memory_order_acquire) != m_dequeuePos + 1)
+      return false;
+
+    // Swap strings so that allocations get reused
+    level = entry.level;
+    std::swap(message, entry.message);
+
+    entry.seq.store(m_dequeuePos + QueueSize, std::memory_order_release);
+    m_dequeuePos += 1;
+    return true;
+  }
+
 
-      std::stringstream stream(message);
-      std::string       line;
+  bool Logger::hasMsg() const {
+    const LogEntry& entry = m_entries[m_dequeuePos & (QueueSize - 1)];
+    return entry.seq.load(std::memory_order_acquire) == m_dequeuePos + 1;
+  }
+
+
+  void Logger::formatMsg(std::string& buffer, LogLevel level, const std::string& message) {
+    static std::array<const char*, 5> s_prefixes
+      = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
+    
+    const char* prefix = s_prefixes.at(static_cast<uint32_t>(level));
+
+    size_t n = 0;
+
+    while (n < message.size()) {
+      size_t e = message.find('\n', n);
+
+      if (e == std::string::npos)
+        e = message.size();
+
+      buffer.append(prefix);
+      buffer.append(message, n, e - n);
+      buffer.push_back('\n');
+
+      n = e + 1;
+    }
+  }
+
+
+  void Logger::writeMsg(LogLevel level, const std::string& message) {
+    std::string buffer;
+    formatMsg(buffer, level, message);
+    writeBuffer(buffer);
+  }
+
+
+  void Logger::writeBuffer(const std::string& buffer) {
+    std::cerr.write(buffer.data(), buffer.size());
+    std::cerr.flush();
+
+    if (m_fileStream) {
+      m_fileStream.write(buffer.data(), buffer.size());
+      m_fileStream.flush();
+    }
+  }
+
+
+  void Logger::writePending() {
+    LogLevel    level;
+    std::string message;
+    std::string buffer;
 
-      while (std::getline(stream, line, '\n')) {
-        std::cerr << prefix << line << std::endl;
+    // Write messages in batches in order to
+    // reduce the number of write operations
+    while (popMsg(level, message)) {
+      formatMsg(buffer, level, message);
 
-        if (m_fileStream)
-          m_fileStream << prefix << line << std::endl;
+      if (buffer.size() >= 65536) {
+        writeBuffer(buffer);
+        buffer.clear();
       }
     }
+
+    uint64_t dropCount = m_dropCount.exchange(0, std::memory_order_relaxed);
+
+    if (dropCount)
+      formatMsg(buffer, LogLevel::Warn, str::format("Logger: Dropped ", dropCount, " messages"));
+
+    if (!buffer.empty())
+      writeBuffer(buffer);
+  }
+
+
+  void Logger::startWriter() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_state.load() != WriterState::Idle)
+      return;
+
+    try {
+      m_thread = dxvk::thread([this] { runWriter(); });
+      m_state.store(WriterState::Running, std::memory_order_release);
+    } catch (const DxvkError&) {
+      m_state.store(WriterState::Failed, std::memory_order_release);
+    }
+  }
+
+
+  void Logger::runWriter() {
+    env::setThreadName("dxvk-log");
+
+    while (true) {
+      // Check the stop flag before draining the queue so
+      // that messages pushed before the flag was set are
+      // always written out
+      bool stopped = m_stopped.load(std::memory_order_acquire);
+
+      // The destructor takes over the queue if we take too
+      // long to exit, and never gives it back in that case
+      if (m_consuming.exchange(true, std::memory_order_acquire))
+        break;
+
+      writePending();
+
+      m_consuming.store(false, std::memory_order_release);
+
+      if (stopped)
+        break;
+
+      // Producers notify without holding the lock so a wakeup
+      // may get lost, the timeout limits the delay in that case
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+      m_cond.wait_for(lock, std::chrono::milliseconds(10), [this] {
+        return m_stopped.load(std::memory_order_acquire)
+            || m_dropCount.load(std::memory_order_relaxed)
+            || hasMsg();
+      });
+    }
+
+    m_state.store(WriterState::Finished, std::memory_order_release);
   }
   
   
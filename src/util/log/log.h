@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -23,9 +24,16 @@ namespace dxvk {
    * 
    * Logger for one DLL. Creates a text file and
    * writes all log messages to that file.
+   *
+   * Messages are pushed to a fixed-size lock-free queue
+   * and written by a background thread, so that logging
+   * never blocks the calling thread on I/O. If the queue
+   * is full, messages are dropped, and the number of
+   * dropped messages is written to the log instead.
    */
   class Logger {
-    
+    /// Number of queued messages, must be a power of two
+    constexpr static uint32_t QueueSize = 1024;
   public:
     
     Logger(const std::string& file_name);
@@ -43,6 +51,19 @@ namespace dxvk {
     }
     
   private:
+
+    enum class WriterState : uint32_t {
+      Idle,     ///< Writer thread not started yet
+      Running,  ///< Writer thread is running
+      Finished, ///< Writer thread wrote its last message
+      Failed,   ///< No writer thread, write synchronously
+    };
+
+    struct LogEntry {
+      std::atomic<uint64_t> seq     = { 0ull };
+      LogLevel              level   = LogLevel::Info;
+      std::string           message;
+    };
     
     static Logger s_instance;
     
@@ -50,9 +71,43 @@ namespace dxvk {
     
     dxvk::mutex   m_mutex;
     std::ofstream m_fileStream;
+
+    std::array<LogEntry, QueueSize> m_entries;
+
+    std::atomic<uint64_t>     m_enqueuePos  = { 0ull };
+    uint64_t                  m_dequeuePos  = 0ull;
+    std::atomic<uint64_t>     m_dropCount   = { 0ull };
+
+    std::atomic<WriterState>  m_state       = { WriterState::Idle };
+    std::atomic<bool>         m_stopped     = { false };
+    std::atomic<bool>         m_consuming   = { false };
+
+    dxvk::condition_variable  m_cond;
+    dxvk::thread              m_thread;
     
     void emitMsg(LogLevel level, const std::string& message);
+
+    bool pushMsg(LogLevel level, const std::string& message);
+
+    bool popMsg(LogLevel& level, std::string& message);
+
+    bool hasMsg() const;
+
+    void writeMsg(LogLevel level, const std::string& message);
+
+    void writeBuffer(const std::string& buffer);
+
+    void writePending();
+
+    void startWriter();
+
+    void runWriter();
     
+    static void formatMsg(
+            std::string&        buffer,
+            LogLevel            level,
+      const std::string&        message);
+
     static LogLevel getMinLogLevel();
     
     static std::string getFileName(
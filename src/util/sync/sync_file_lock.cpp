@@ -0,0 +1,74 @@
+#include "sync_file_lock.h"
+
+#include "../util_string.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+namespace dxvk::sync {
+
+  FileLock::FileLock(const std::wstring& path) {
+#ifdef _WIN32
+    m_handle = ::CreateFileW(path.c_str(),
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+    m_fd = ::open(str::fromws(path.c_str()).c_str(),
+      O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+  }
+
+
+  FileLock::~FileLock() {
+#ifdef _WIN32
+    if (m_handle != INVALID_HANDLE_VALUE)
+      ::CloseHandle(m_handle);
+#else
+    if (m_fd >= 0)
+      ::close(m_fd);
+#endif
+  }
+
+
+  bool FileLock::isValid() const {
+#ifdef _WIN32
+    return m_handle != INVALID_HANDLE_VALUE;
+#else
+    return m_fd >= 0;
+#endif
+  }
+
+
+  void FileLock::lock() {
+#ifdef _WIN32
+    if (m_handle != INVALID_HANDLE_VALUE) {
+      OVERLAPPED overlapped = { };
+      ::LockFileEx(m_handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped);
+    }
+#else
+    if (m_fd >= 0) {
+      while (::flock(m_fd, LOCK_EX) && errno == EINTR)
+        continue;
+    }
+#endif
+  }
+
+
+  void FileLock::unlock() {
+#ifdef _WIN32
+    if (m_handle != INVALID_HANDLE_VALUE) {
+      OVERLAPPED overlapped = { };
+      ::UnlockFileEx(m_handle, 0, 1, 0, &overlapped);
+    }
+#else
+    if (m_fd >= 0)
+      ::flock(m_fd, LOCK_UN);
+#endif
+  }
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+#include "../com/com_include.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Inter-process file lock
+   *
+   * Exclusive advisory lock on a lock file, used to
+   * serialize access to cache files that may be shared
+   * by multiple processes at the same time. If the lock
+   * file cannot be opened, locking is a no-op so that
+   * callers keep working as if there was no other process.
+   * Not recursive, and not meant to be used for locking
+   * between threads of the same process.
+   */
+  class FileLock {
+
+  public:
+
+    FileLock(const std::wstring& path);
+
+    ~FileLock();
+
+    FileLock             (const FileLock&) = delete;
+    FileLock& operator = (const FileLock&) = delete;
+
+    /**
+     * \brief Checks whether the lock file is open
+     * \returns \c true if locking is functional
+     */
+    bool isValid() const;
+
+    void lock();
+
+    void unlock();
+
+  private:
+
+#ifdef _WIN32
+    HANDLE  m_handle = INVALID_HANDLE_VALUE;
+#else
+    int     m_fd     = -1;
+#endif
+
+  };
+
+}
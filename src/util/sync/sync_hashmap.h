@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "../thread.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Read-mostly concurrent hash map
+   *
+   * Entries can be added but never removed, which allows
+   * lookups to traverse bucket chains without locking.
+   * Insertion takes a lock only if the key is not yet
+   * present, so that each value is created exactly once.
+   * Pointers to values remain valid until the map is
+   * destroyed.
+   *
+   * The bucket table doubles in size whenever the number
+   * of entries exceeds the number of buckets. Since readers
+   * may still traverse an old table, retired tables are only
+   * freed together with the map.
+   */
+  template<typename K, typename V,
+    typename Hash = std::hash<K>,
+    typename Eq   = std::equal_to<K>,
+    size_t InitialBucketCount = 256>
+  class HashMap {
+
+    struct Entry {
+      template<typename... Args>
+      Entry(const K& key_, size_t hash_, Args&&... args)
+      : key(key_), hash(hash_), value(std::forward<Args>(args)...) { }
+
+      K      key;
+      size_t hash;
+      V      value;
+    };
+
+    struct Node {
+      Entry* entry;
+      Node*  next;
+    };
+
+    struct Table {
+      Table(size_t count, Table* prev_)
+      : bucketCount(count), buckets(new std::atomic<Node*>[count]), prev(prev_) {
+        for (size_t i = 0; i < count; i++)
+          buckets[i].store(nullptr, std::memory_order_relaxed);
+      }
+
+      ~Table() {
+        for (size_t i = 0; i < bucketCount; i++) {
+          Node* n = buckets[i].load(std::memory_order_relaxed);
+
+          while (n) {
+            Node* next = n->next;
+            delete n;
+            n = next;
+          }
+        }
+      }
+
+      std::atomic<Node*>& getBucket(size_t hash) const {
+        return buckets[hash % bucketCount];
+      }
+
+      size_t                                bucketCount;
+      std::unique_ptr<std::atomic<Node*>[]> buckets;
+      Table*                                prev;
+    };
+
+  public:
+
+    HashMap()
+    : m_table(new Table(InitialBucketCount, nullptr)) { }
+
+    ~HashMap() {
+      Table* table = m_table.load(std::memory_order_relaxed);
+
+      // Every entry is linked into the current table exactly once
+      for (size_t i = 0; i < table->bucketCount; i++) {
+        for (Node* n = table->buckets[i].load(std::memory_order_relaxed); n; n = n->next)
+          delete n->entry;
+      }
+
+      while (table) {
+        Table* prev = table->prev;
+        delete table;
+        table = prev;
+      }
+    }
+
+    HashMap             (const HashMap&) = delete;
+    HashMap& operator = (const HashMap&) = delete;
+
+    /**
+     * \brief Looks up a value
+     *
+     * Does not take any locks.
+     * \param [in] key Key to look up
+     * \returns Pointer to the value, or \c nullptr
+     */
+    V* find(const K& key) const {
+      size_t hash = Hash()(key);
+      Table* table = m_table.load(std::memory_order_acquire);
+      return findEntry(table->getBucket(hash).load(std::memory_order_acquire), key, hash);
+    }
+
+    /**
+     * \brief Looks up or inserts a value
+     *
+     * If no value exists for the given key, a new one is
+     * constructed from the given arguments. The lock is
+     * only taken if the initial lookup fails.
+     * \param [in] key Key to look up
+     * \param [in] args Value constructor arguments
+     * \returns Pointer to the value, and \c true
+     *    if a new value has been inserted
+     */
+    template<typename... Args>
+    std::pair<V*, bool> emplace(const K& key, Args&&... args) {
+      V* value = find(key);
+
+      if (value)
+        return { value, false };
+
+      size_t hash = Hash()(key);
+
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      // Another thread may have inserted the same key in the
+      // meantime. The table and bucket heads only change with
+      // the lock held.
+      Table* table = m_table.load(std::memory_order_relaxed);
+      value = findEntry(table->getBucket(hash).load(std::memory_order_relaxed), key, hash);
+
+      if (value)
+        return { value, false };
+
+      Entry* e = new Entry(key, hash, std::forward<Args>(args)...);
+
+      if (++m_size > table->bucketCount)
+        table = growTable(table);
+
+      insertNode(table, e);
+      return { &e->value, true };
+    }
+
+    /**
+     * \brief Iterates over all values
+     *
+     * Values inserted concurrently may or may not be visited.
+     * \param [in] fn Function to call for each key and value
+     */
+    template<typename Fn>
+    void forEach(const Fn& fn) const {
+      Table* table = m_table.load(std::memory_order_acquire);
+
+      for (size_t i = 0; i < table->bucketCount; i++) {
+        for (Node* n = table->buckets[i].load(std::memory_order_acquire); n; n = n->next)
+          fn(n->entry->key, n->entry->value);
+      }
+    }
+
+    /**
+     * \brief Names the internal lock for profiling
+     * \param [in] name Lock name
+     */
+    void setLockName(const char* name) {
+      sync::setLockName(m_mutex, name);
+    }
+
+  private:
+
+    dxvk::mutex         m_mutex;
+    std::atomic<Table*> m_table;
+    size_t              m_size = 0;
+
+    Table* growTable(Table* table) {
+      // Build the new table completely before publishing it, so
+      // that readers see either the old or the new table in full
+      Table* result = new Table(table->bucketCount * 2, table);
+
+      for (size_t i = 0; i < table->bucketCount; i++) {
+        for (Node* n = table->buckets[i].load(std::memory_order_relaxed); n; n = n->next)
+          insertNode(result, n->entry);
+      }
+
+      m_table.store(result, std::memory_order_release);
+      return result;
+    }
+
+    static void insertNode(Table* table, Entry* e) {
+      auto& bucket = table->getBucket(e->hash);
+
+      Node* n = new Node();
+      n->entry = e;
+      n->next  = bucket.load(std::memory_order_relaxed);
+
+      bucket.store(n, std::memory_order_release);
+    }
+
+    static V* findEntry(Node* n, const K& key, size_t hash) {
+      for ( ; n; n = n->next) {
+        if (n->entry->hash == hash && Eq()(n->entry->key, key))
+          return &n->entry->value;
+      }
+
+      return nullptr;
+    }
+
+  };
+
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "sync_profile.h"
+
+#include "../log/log.h"
+
+#include "../util_string.h"
+
+namespace dxvk::sync {
+
+  static std::atomic<LockStats*> g_lockStats = { nullptr };
+
+
+  LockStats* getLockStats(const char* name) {
+    LockStats* head = g_lockStats.load(std::memory_order_acquire);
+
+    for (LockStats* e = head; e; e = e->next) {
+      if (!std::strcmp(e->name, name))
+        return e;
+    }
+
+    // Entries are only ever prepended, so if another thread added
+    // the same name concurrently, it will be found on retry
+    LockStats* entry = new LockStats();
+    entry->name = name;
+    entry->next = head;
+
+    while (!g_lockStats.compare_exchange_weak(entry->next, entry,
+        std::memory_order_release, std::memory_order_acquire)) {
+      for (LockStats* e = entry->next; e != head; e = e->next) {
+        if (!std::strcmp(e->name, name)) {
+          delete entry;
+          return e;
+        }
+      }
+
+      head = entry->next;
+    }
+
+    return entry;
+  }
+
+
+  void logLockStats() {
+#ifdef DXVK_LOCK_PROFILING
+    std::vector<const LockStats*> entries;
+
+    for (LockStats* e = g_lockStats.load(std::memory_order_acquire); e; e = e->next) {
+      if (e->acquireCount.load())
+        entries.push_back(e);
+    }
+
+    if (entries.empty())
+      return;
+
+    std::sort(entries.begin(), entries.end(),
+      [] (const LockStats* a, const LockStats* b) {
+        return a->waitTime.load() > b->waitTime.load();
+      });
+
+    Logger::info("Lock statistics:");
+
+    for (const auto* e : entries) {
+      uint64_t acquired  = e->acquireCount.load();
+      uint64_t contended = e->contendedCount.load();
+      uint64_t waitTime  = e->waitTime.load();
+
+      Logger::info(str::format("  ", e->name, ": ",
+        acquired, " acquired, ",
+        contended, " contended (", (100 * contended) / acquired, "%), ",
+        waitTime / 1000000, " ms waited, ",
+        contended ? waitTime / contended : 0, " ns per contended acquisition"));
+    }
+#endif
+  }
+
+}
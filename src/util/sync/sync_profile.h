@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Lock statistics
+   *
+   * Contention statistics for all locks that share
+   * the same name. Only recorded in builds that
+   * define \c DXVK_LOCK_PROFILING.
+   */
+  struct LockStats {
+    /// Lock name
+    const char*           name = nullptr;
+    /// Total number of acquisitions
+    std::atomic<uint64_t> acquireCount    = { 0ull };
+    /// Acquisitions that had to wait
+    std::atomic<uint64_t> contendedCount  = { 0ull };
+    /// Total time spent waiting, in nanoseconds
+    std::atomic<uint64_t> waitTime        = { 0ull };
+    /// Next entry in the global list
+    LockStats*            next            = nullptr;
+  };
+
+
+  /**
+   * \brief Retrieves statistics for a named lock
+   *
+   * Entries are created on first use and never freed,
+   * so locks can safely keep a pointer to them.
+   * \param [in] name Lock name. Must be a string
+   *    literal or otherwise outlive the process.
+   * \returns Statistics for the given name
+   */
+  LockStats* getLockStats(const char* name);
+
+  /**
+   * \brief Writes lock statistics to the log
+   *
+   * Lists all named locks that were acquired at least
+   * once, sorted by total wait time. Does nothing unless
+   * lock profiling is enabled.
+   */
+  void logLockStats();
+
+
+  /**
+   * \brief Acquires a lock and records statistics
+   *
+   * Tries to acquire the lock without waiting first, and
+   * only measures time if that fails, so that uncontended
+   * acquisitions stay cheap.
+   * \param [in] stats Lock statistics, may be \c nullptr
+   * \param [in] tryLock Function that tries to acquire the lock
+   * \param [in] lock Function that acquires the lock
+   */
+  template<typename TryLockFn, typename LockFn>
+  void profiledLock(
+          LockStats*        stats,
+    const TryLockFn&        tryLock,
+    const LockFn&           lock) {
+    if (!stats) {
+      lock();
+      return;
+    }
+
+    stats->acquireCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (tryLock())
+      return;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    lock();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    stats->contendedCount.fetch_add(1, std::memory_order_relaxed);
+    stats->waitTime.fetch_add(ns, std::memory_order_relaxed);
+  }
+
+
+  /**
+   * \brief Names a lock for profiling
+   *
+   * Locks are only profiled once they have a name.
+   * This is a no-op unless lock profiling is enabled,
+   * and works with any lock type in that case.
+   * \param [in] lock The lock
+   * \param [in] name Lock name, usually a string literal
+   */
+  template<typename T>
+  void setLockName(T& lock, const char* name) {
+#ifdef DXVK_LOCK_PROFILING
+    lock.set_name(name);
+#endif
+  }
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+
+#include "sync_spinlock.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Sequence lock
+   *
+   * Allows any number of readers to access data without
+   * taking a lock. Readers retry if a writer modified the
+   * data while they were reading it, so read operations
+   * must be cheap and must not have any side effects.
+   *
+   * Writers must be serialized externally, e.g. by a
+   * regular lock that protects the same data.
+   */
+  class SeqLock {
+
+  public:
+
+    SeqLock() { }
+    ~SeqLock() { }
+
+    SeqLock             (const SeqLock&) = delete;
+    SeqLock& operator = (const SeqLock&) = delete;
+
+    /**
+     * \brief Begins a write operation
+     *
+     * Readers will retry until the
+     * write operation has completed.
+     */
+    void beginWrite() {
+      uint32_t seq = m_seq.load(std::memory_order_relaxed);
+      m_seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * \brief Ends a write operation
+     */
+    void endWrite() {
+      uint32_t seq = m_seq.load(std::memory_order_relaxed);
+      m_seq.store(seq + 1, std::memory_order_release);
+    }
+
+    /**
+     * \brief Reads protected data
+     *
+     * Calls the given function until it has observed
+     * a consistent state, i.e. no write operation was
+     * in progress or completed while it was running.
+     * \param [in] fn Function that copies the data
+     */
+    template<typename Fn>
+    void read(const Fn& fn) const {
+      uint32_t seq;
+
+      do {
+        spin(200, [this, &seq] {
+          seq = m_seq.load(std::memory_order_acquire);
+          return !(seq & 1);
+        });
+
+        fn();
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+      } while (unlikely(m_seq.load(std::memory_order_relaxed) != seq));
+    }
+
+  private:
+
+    std::atomic<uint32_t> m_seq = { 0u };
+
+  };
+
+}
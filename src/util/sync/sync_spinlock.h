@@ -48,7 +48,13 @@ namespace dxvk::sync {
     Spinlock& operator = (const Spinlock&) = delete;
     
     void lock() {
+#ifdef DXVK_LOCK_PROFILING
+      sync::profiledLock(m_stats,
+        [this] { return try_lock(); },
+        [this] { spin(200, [this] { return try_lock(); }); });
+#else
       spin(200, [this] { return try_lock(); });
+#endif
     }
     
     void unlock() {
@@ -59,10 +65,20 @@ namespace dxvk::sync {
       return likely(!m_lock.load())
           && likely(!m_lock.exchange(1, std::memory_order_acquire));
     }
+
+#ifdef DXVK_LOCK_PROFILING
+    void set_name(const char* name) {
+      m_stats = sync::getLockStats(name);
+    }
+#endif
     
   private:
     
     std::atomic<uint32_t> m_lock = { 0 };
+
+#ifdef DXVK_LOCK_PROFILING
+    sync::LockStats*      m_stats = nullptr;
+#endif
     
   };
   
@@ -19,10 +19,13 @@ namespace dxvk::sync {
   public:
 
     void lock() {
-      uint32_t ticket = m_counter.fetch_add(1);
-
-      while (m_serving.load(std::memory_order_acquire) != ticket)
-        continue;
+#ifdef DXVK_LOCK_PROFILING
+      sync::profiledLock(m_stats,
+        [this] { return try_lock(); },
+        [this] { acquire(); });
+#else
+      acquire();
+#endif
     }
 
     void unlock() {
@@ -30,11 +33,36 @@ namespace dxvk::sync {
       m_serving.store(serveNext, std::memory_order_release);
     }
 
+    bool try_lock() {
+      uint32_t ticket = m_serving.load(std::memory_order_acquire);
+
+      // Only take a ticket if it would be served immediately
+      return m_counter.compare_exchange_strong(ticket, ticket + 1,
+        std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+#ifdef DXVK_LOCK_PROFILING
+    void set_name(const char* name) {
+      m_stats = sync::getLockStats(name);
+    }
+#endif
+
   private:
 
     std::atomic<uint32_t> m_counter = { 0 };
     std::atomic<uint32_t> m_serving = { 0 };
 
+#ifdef DXVK_LOCK_PROFILING
+    sync::LockStats*      m_stats = nullptr;
+#endif
+
+    void acquire() {
+      uint32_t ticket = m_counter.fetch_add(1);
+
+      while (m_serving.load(std::memory_order_acquire) != ticket)
+        continue;
+    }
+
   };
   
 }
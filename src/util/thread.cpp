@@ -1,9 +1,179 @@
 #include "thread.h"
 #include "util_likely.h"
 
+#include <algorithm>
 #include <atomic>
 
-#ifndef _WIN32
+#ifdef _WIN32
+
+namespace dxvk {
+
+  struct ThreadRegistry {
+    dxvk::mutex             lock;
+    std::vector<ThreadFn*>  threads;
+  };
+
+  static ThreadRegistry& getThreadRegistry() {
+    // Intentionally leaked, since threads may still
+    // be destroyed during static destruction
+    static ThreadRegistry* registry = new ThreadRegistry();
+    return *registry;
+  }
+
+  static thread_local ThreadFn* g_currentThread = nullptr;
+
+
+  ThreadFn::ThreadFn(Proc&& proc)
+  : m_proc(std::move(proc)) {
+    // Reference for the thread function
+    this->incRef();
+
+    // Register the thread before it can start running,
+    // so that it cannot exit before being registered
+    ThreadRegistry& registry = getThreadRegistry();
+    std::lock_guard<dxvk::mutex> lock(registry.lock);
+
+    m_handle = ::CreateThread(nullptr, 0x100000,
+      ThreadFn::threadProc, this, STACK_SIZE_PARAM_IS_A_RESERVATION,
+      nullptr);
+
+    if (m_handle == nullptr)
+      throw DxvkError("Failed to create thread");
+
+    registry.threads.push_back(this);
+  }
+
+
+  ThreadFn::~ThreadFn() {
+    if (this->joinable())
+      std::terminate();
+
+    ThreadRegistry& registry = getThreadRegistry();
+    std::lock_guard<dxvk::mutex> lock(registry.lock);
+    auto entry = std::find(registry.threads.begin(), registry.threads.end(), this);
+
+    if (entry != registry.threads.end())
+      registry.threads.erase(entry);
+  }
+
+
+  void ThreadFn::detach() {
+    // Thread handles may be in use by getCpuTimes
+    ThreadRegistry& registry = getThreadRegistry();
+    std::lock_guard<dxvk::mutex> lock(registry.lock);
+    ::CloseHandle(m_handle);
+    m_handle = nullptr;
+  }
+
+
+  void ThreadFn::setCurrentName(
+    const std::string&  name) {
+    if (g_currentThread) {
+      ThreadRegistry& registry = getThreadRegistry();
+      std::lock_guard<dxvk::mutex> lock(registry.lock);
+      g_currentThread->m_name = name;
+    }
+  }
+
+
+  std::vector<ThreadCpuTime> ThreadFn::getCpuTimes() {
+    ThreadRegistry& registry = getThreadRegistry();
+    std::lock_guard<dxvk::mutex> lock(registry.lock);
+
+    std::vector<ThreadCpuTime> result;
+    result.reserve(registry.threads.size());
+
+    for (auto thread : registry.threads) {
+      FILETIME creationTime, exitTime, kernelTime, userTime;
+
+      if (!thread->m_handle || !::GetThreadTimes(thread->m_handle,
+          &creationTime, &exitTime, &kernelTime, &userTime))
+        continue;
+
+      // Thread times are given in 100ns units
+      uint64_t kernel = (uint64_t(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+      uint64_t user   = (uint64_t(userTime.dwHighDateTime)   << 32) | userTime.dwLowDateTime;
+
+      ThreadCpuTime& entry = result.emplace_back();
+      entry.id      = uint32_t(::GetThreadId(thread->m_handle));
+      entry.name    = thread->m_name;
+      entry.cpuTime = (kernel + user) / 10;
+    }
+
+    return result;
+  }
+
+
+  DWORD WINAPI ThreadFn::threadProc(void *arg) {
+    auto thread = reinterpret_cast<ThreadFn*>(arg);
+    g_currentThread = thread;
+
+    thread->m_proc();
+    thread->decRef();
+
+    g_currentThread = nullptr;
+    return 0;
+  }
+
+
+  uint64_t thread::core_mask(ThreadCoreClass coreClass) {
+    DWORD size = 0;
+
+    if (::GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &size)
+     || ::GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+      return 0;
+
+    std::vector<char> data(size);
+    auto base = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(data.data());
+
+    if (!::GetLogicalProcessorInformationEx(RelationProcessorCore, base, &size))
+      return 0;
+
+    // Higher efficiency classes denote faster cores. On CPUs
+    // without different core types, all cores use class 0.
+    struct CoreInfo {
+      uint64_t mask;
+      uint32_t efficiencyClass;
+    };
+
+    std::vector<CoreInfo> cores;
+    uint32_t minClass = ~0u;
+    uint32_t maxClass = 0u;
+
+    for (DWORD offset = 0; offset < size; ) {
+      auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(&data[offset]);
+
+      if (info->Relationship == RelationProcessorCore
+       && info->Processor.GroupMask[0].Group == 0) {
+        CoreInfo core;
+        core.mask = uint64_t(info->Processor.GroupMask[0].Mask);
+        core.efficiencyClass = info->Processor.EfficiencyClass;
+        cores.push_back(core);
+
+        minClass = std::min(minClass, core.efficiencyClass);
+        maxClass = std::max(maxClass, core.efficiencyClass);
+      }
+
+      offset += info->Size;
+    }
+
+    uint64_t mask = 0;
+
+    for (const auto& core : cores) {
+      bool include = coreClass == ThreadCoreClass::Any || minClass == maxClass
+        || (coreClass == ThreadCoreClass::Performance && core.efficiencyClass == maxClass)
+        || (coreClass == ThreadCoreClass::Efficiency  && core.efficiencyClass == minClass);
+
+      if (include)
+        mask |= core.mask;
+    }
+
+    return mask;
+  }
+
+}
+
+#else
 
 namespace dxvk::this_thread {
   
@@ -4,7 +4,9 @@
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "util_error.h"
 
@@ -13,6 +15,8 @@
 #include "./rc/util_rc.h"
 #include "./rc/util_rc_ptr.h"
 
+#include "./sync/sync_profile.h"
+
 namespace dxvk {
 
 #ifdef _WIN32
@@ -27,6 +31,31 @@ namespace dxvk {
     Highest     = THREAD_PRIORITY_HIGHEST,
   };
 
+  /**
+   * \brief CPU core class
+   *
+   * Selects cores on hybrid CPUs that have both
+   * performance and efficiency cores. On other
+   * CPUs, all classes include all cores.
+   */
+  enum class ThreadCoreClass : uint32_t {
+    Any         = 0,
+    Performance = 1,
+    Efficiency  = 2,
+  };
+
+  /**
+   * \brief Thread CPU time
+   */
+  struct ThreadCpuTime {
+    /// Thread ID
+    uint32_t    id;
+    /// Name set via \c env::setThreadName
+    std::string name;
+    /// Total user and kernel time, in microseconds
+    uint64_t    cpuTime;
+  };
+
   /**
    * \brief Thread helper class
    * 
@@ -40,28 +69,11 @@ namespace dxvk {
     using Proc = std::function<void()>;
   public:
 
-    ThreadFn(Proc&& proc)
-    : m_proc(std::move(proc)) {
-      // Reference for the thread function
-      this->incRef();
-
-      m_handle = ::CreateThread(nullptr, 0x100000,
-        ThreadFn::threadProc, this, STACK_SIZE_PARAM_IS_A_RESERVATION,
-        nullptr);
-      
-      if (m_handle == nullptr)
-        throw DxvkError("Failed to create thread");
-    }
+    ThreadFn(Proc&& proc);
 
-    ~ThreadFn() {
-      if (this->joinable())
-        std::terminate();
-    }
+    ~ThreadFn();
     
-    void detach() {
-      ::CloseHandle(m_handle);
-      m_handle = nullptr;
-    }
+    void detach();
 
     void join() {
       if(::WaitForSingleObjectEx(m_handle, INFINITE, FALSE) == WAIT_FAILED)
@@ -77,17 +89,35 @@ namespace dxvk {
       ::SetThreadPriority(m_handle, int32_t(priority));
     }
 
+    void set_affinity(uint64_t mask) {
+      if (mask)
+        ::SetThreadAffinityMask(m_handle, DWORD_PTR(mask));
+    }
+
+    /**
+     * \brief Sets name of the calling thread
+     *
+     * Only affects threads created via \c ThreadFn.
+     * \param [in] name Thread name
+     */
+    static void setCurrentName(
+      const std::string&  name);
+
+    /**
+     * \brief Queries CPU time of all running threads
+     *
+     * Only includes threads created via \c ThreadFn.
+     * \returns CPU time for each thread
+     */
+    static std::vector<ThreadCpuTime> getCpuTimes();
+
   private:
 
-    Proc    m_proc;
-    HANDLE  m_handle;
+    Proc        m_proc;
+    HANDLE      m_handle = nullptr;
+    std::string m_name;
 
-    static DWORD WINAPI threadProc(void *arg) {
-      auto thread = reinterpret_cast<ThreadFn*>(arg);
-      thread->m_proc();
-      thread->decRef();
-      return 0;
-    }
+    static DWORD WINAPI threadProc(void *arg);
 
   };
 
@@ -131,6 +161,10 @@ namespace dxvk {
     void set_priority(ThreadPriority priority) {
       m_thread->set_priority(priority);
     }
+
+    void set_affinity(uint64_t mask) {
+      m_thread->set_affinity(mask);
+    }
     
     static uint32_t hardware_concurrency() {
       SYSTEM_INFO info = { };
@@ -138,6 +172,16 @@ namespace dxvk {
       return info.dwNumberOfProcessors;
     }
 
+    /**
+     * \brief Queries affinity mask for a core class
+     *
+     * Only considers the first processor group, since
+     * that is all a thread affinity mask can address.
+     * \param [in] coreClass Core class
+     * \returns Affinity mask, or 0 if unknown
+     */
+    static uint64_t core_mask(ThreadCoreClass coreClass);
+
   private:
 
     Rc<ThreadFn> m_thread;
@@ -174,7 +218,13 @@ namespace dxvk {
     mutex& operator = (const mutex&) = delete;
 
     void lock() {
+#ifdef DXVK_LOCK_PROFILING
+      sync::profiledLock(m_stats,
+        [this] { return try_lock(); },
+        [this] { AcquireSRWLockExclusive(&m_lock); });
+#else
       AcquireSRWLockExclusive(&m_lock);
+#endif
     }
 
     void unlock() {
@@ -189,10 +239,20 @@ namespace dxvk {
       return &m_lock;
     }
 
+#ifdef DXVK_LOCK_PROFILING
+    void set_name(const char* name) {
+      m_stats = sync::getLockStats(name);
+    }
+#endif
+
   private:
 
     SRWLOCK m_lock = SRWLOCK_INIT;
 
+#ifdef DXVK_LOCK_PROFILING
+    sync::LockStats* m_stats = nullptr;
+#endif
+
   };
 
 
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+#include "util_env.h"
+
+namespace dxvk {
+
+  ThreadPool::ThreadPool(
+          std::string               name,
+          uint32_t                  threadCount,
+          ThreadPriority            priority,
+          uint64_t                  affinity)
+  : m_name        (std::move(name)),
+    m_threadCount (std::max(threadCount, 1u)),
+    m_priority    (priority),
+    m_affinity    (affinity) {
+    sync::setLockName(m_mutex, "ThreadPool");
+
+    m_queues.reserve(m_threadCount);
+
+    for (uint32_t i = 0; i < m_threadCount; i++) {
+      m_queues.push_back(std::make_unique<WorkerQueue>());
+      sync::setLockName(m_queues.back()->lock, "ThreadPool::queue");
+    }
+  }
+
+
+  ThreadPool::~ThreadPool() {
+    this->stop();
+  }
+
+
+  void ThreadPool::submit(
+          std::function<void ()>&&  task,
+          ThreadPoolPriority        priority,
+          uint32_t                  group) {
+    if (m_stopped.load())
+      return;
+
+    uint32_t queueId = group
+      ? group % m_threadCount
+      : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_threadCount;
+
+    WorkerQueue& queue = *m_queues[queueId];
+
+    { std::lock_guard<sync::Spinlock> lock(queue.lock);
+      queue.tasks[uint32_t(priority)].push_back(std::move(task));
+      m_queued[uint32_t(priority)] += 1;
+    }
+
+    // Notify with the lock held so that a worker cannot
+    // miss the task between checking and going to sleep
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (!std::exchange(m_started, true)) {
+      for (uint32_t i = 0; i < m_threadCount; i++) {
+        m_threads.emplace_back([this, i] () { runWorker(i); });
+        m_threads[i].set_priority(m_priority);
+        m_threads[i].set_affinity(m_affinity);
+      }
+    }
+
+    m_cond.notify_one();
+  }
+
+
+  void ThreadPool::suspendBackgroundTasks() {
+    m_suspended += 1;
+  }
+
+
+  void ThreadPool::resumeBackgroundTasks() {
+    if (!(--m_suspended)) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_cond.notify_all();
+    }
+  }
+
+
+  void ThreadPool::stop() {
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (m_stopped.exchange(true))
+        return;
+
+      m_cond.notify_all();
+    }
+
+    for (auto& thread : m_threads)
+      thread.join();
+
+    m_threads.clear();
+
+    for (auto& queue : m_queues) {
+      std::lock_guard<sync::Spinlock> lock(queue->lock);
+
+      for (auto& tasks : queue->tasks)
+        tasks.clear();
+    }
+
+    for (auto& count : m_queued)
+      count.store(0u);
+  }
+
+
+  uint32_t ThreadPool::getRunnablePriorityCount() const {
+    return m_suspended.load()
+      ? uint32_t(ThreadPoolPriority::High) + 1
+      : ThreadPoolPriorityCount;
+  }
+
+
+  bool ThreadPool::hasRunnableTask() const {
+    uint32_t priorityCount = getRunnablePriorityCount();
+
+    for (uint32_t i = 0; i < priorityCount; i++) {
+      if (m_queued[i].load())
+        return true;
+    }
+
+    return false;
+  }
+
+
+  std::function<void ()> ThreadPool::takeTask(
+          uint32_t                  queueId) {
+    uint32_t priorityCount = getRunnablePriorityCount();
+
+    for (uint32_t p = 0; p < priorityCount; p++) {
+      if (!m_queued[p].load())
+        continue;
+
+      // Check our own queue first, then steal from
+      // the other workers in a fixed order
+      for (uint32_t i = 0; i < m_threadCount; i++) {
+        WorkerQueue& queue = *m_queues[(queueId + i) % m_threadCount];
+        std::lock_guard<sync::Spinlock> lock(queue.lock);
+
+        auto& tasks = queue.tasks[p];
+
+        if (!tasks.empty()) {
+          std::function<void ()> task = std::move(tasks.front());
+          tasks.pop_front();
+
+          m_queued[p] -= 1;
+          return task;
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+
+  void ThreadPool::runWorker(
+          uint32_t                  queueId) {
+    env::setThreadName(m_name);
+
+    while (!m_stopped.load()) {
+      std::function<void ()> task = takeTask(queueId);
+
+      if (task) {
+        task();
+        continue;
+      }
+
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+      m_cond.wait(lock, [this] {
+        return m_stopped.load() || hasRunnableTask();
+      });
+    }
+  }
+
+}
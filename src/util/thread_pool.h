@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thread.h"
+
+#include "sync/sync_spinlock.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Thread pool task priority
+   *
+   * Tasks are processed in order of priority. Tasks
+   * of the same priority are processed roughly in
+   * the order in which they were submitted.
+   */
+  enum class ThreadPoolPriority : uint32_t {
+    High    = 0,
+    Normal  = 1,
+    Low     = 2,
+  };
+
+  constexpr uint32_t ThreadPoolPriorityCount = 3;
+
+
+  /**
+   * \brief Work-stealing thread pool
+   *
+   * Runs tasks from different subsystems on one shared set
+   * of worker threads, so that they do not compete for CPU
+   * cores with each other. Each worker has its own queues,
+   * and idle workers steal tasks from other workers. Tasks
+   * submitted with the same affinity group are queued on
+   * the same worker, which helps when they share data or
+   * locks. Threads are only started once there is work.
+   */
+  class ThreadPool {
+
+  public:
+
+    ThreadPool(
+            std::string               name,
+            uint32_t                  threadCount,
+            ThreadPriority            priority,
+            uint64_t                  affinity = 0);
+
+    ~ThreadPool();
+
+    ThreadPool             (const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    /**
+     * \brief Number of worker threads
+     * \returns Worker thread count
+     */
+    uint32_t threadCount() const {
+      return m_threadCount;
+    }
+
+    /**
+     * \brief Submits a task
+     *
+     * Tasks submitted after the pool has
+     * been stopped are silently discarded.
+     * \param [in] task Function to execute
+     * \param [in] priority Task priority
+     * \param [in] group Affinity group. Tasks of the same
+     *    non-zero group are preferably run by the same worker.
+     */
+    void submit(
+            std::function<void ()>&&  task,
+            ThreadPoolPriority        priority,
+            uint32_t                  group = 0);
+
+    /**
+     * \brief Suspends non-high priority tasks
+     *
+     * Until the matching call to \c resumeBackgroundTasks,
+     * workers only start high priority tasks. Calls can be
+     * nested. Tasks that are already running are not affected.
+     */
+    void suspendBackgroundTasks();
+
+    /**
+     * \brief Resumes non-high priority tasks
+     */
+    void resumeBackgroundTasks();
+
+    /**
+     * \brief Stops all worker threads
+     *
+     * Waits for running tasks to complete and
+     * discards all tasks that are still queued.
+     */
+    void stop();
+
+  private:
+
+    struct WorkerQueue {
+      sync::Spinlock  lock;
+      std::array<std::deque<std::function<void ()>>, ThreadPoolPriorityCount> tasks;
+    };
+
+    std::string                     m_name;
+    uint32_t                        m_threadCount;
+    ThreadPriority                  m_priority;
+    uint64_t                        m_affinity;
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::array<std::atomic<uint32_t>, ThreadPoolPriorityCount> m_queued = { };
+    std::atomic<uint32_t>           m_nextQueue  = { 0u };
+    std::atomic<uint32_t>           m_suspended  = { 0u };
+    std::atomic<bool>               m_stopped    = { false };
+
+    dxvk::mutex                     m_mutex;
+    dxvk::condition_variable        m_cond;
+    bool                            m_started = false;
+    std::vector<dxvk::thread>       m_threads;
+
+    uint32_t getRunnablePriorityCount() const;
+
+    bool hasRunnableTask() const;
+
+    std::function<void ()> takeTask(
+            uint32_t                  queueId);
+
+    void runWorker(
+            uint32_t                  queueId);
+
+  };
+
+}
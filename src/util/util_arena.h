@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dxvk {
+
+  /**
+   * \brief Arena
+   *
+   * Linear allocator for objects that share a common
+   * lifetime. Memory is handed out from large chunks
+   * and only released when the arena is destroyed, so
+   * individual deallocations are free.
+   */
+  class Arena {
+    constexpr static size_t ChunkSize = 64u << 10;
+  public:
+
+    Arena() { }
+
+    Arena             (const Arena&) = delete;
+    Arena& operator = (const Arena&) = delete;
+
+    /**
+     * \brief Allocates memory
+     *
+     * Large allocations get a dedicated chunk so
+     * that they do not waste the current chunk.
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment
+     * \returns Pointer to uninitialized memory
+     */
+    void* alloc(size_t size, size_t align) {
+      if (size > ChunkSize / 4)
+        return allocChunk(size + align, align);
+
+      size_t offset = alignOffset(m_current, m_offset, align);
+
+      if (!m_current || offset + size > m_capacity) {
+        m_current  = allocChunk(ChunkSize, 1);
+        m_capacity = ChunkSize;
+        offset     = alignOffset(m_current, 0, align);
+      }
+
+      m_offset = offset + size;
+      return m_current + offset;
+    }
+
+    /**
+     * \brief Creates an object in the arena
+     *
+     * The destructor will not be run, so this
+     * must only be used for trivial types.
+     * \param [in] args Constructor arguments
+     * \returns Pointer to the new object
+     */
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+      static_assert(std::is_trivially_destructible_v<T>);
+      return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+  private:
+
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+
+    char*   m_current  = nullptr;
+    size_t  m_offset   = 0;
+    size_t  m_capacity = 0;
+
+    char* allocChunk(size_t size, size_t align) {
+      char* ptr = m_chunks.emplace_back(new char[size]).get();
+      return ptr + alignOffset(ptr, 0, align);
+    }
+
+    static size_t alignOffset(const char* base, size_t offset, size_t align) {
+      size_t addr = reinterpret_cast<size_t>(base) + offset;
+      return offset + (((addr + align - 1) & ~(align - 1)) - addr);
+    }
+
+  };
+
+
+  /**
+   * \brief Arena allocator
+   *
+   * Standard allocator that takes memory from an
+   * arena, for use with STL containers. The arena
+   * must outlive all containers using it.
+   */
+  template<typename T>
+  class ArenaAllocator {
+    template<typename U> friend class ArenaAllocator;
+  public:
+
+    using value_type = T;
+
+    ArenaAllocator(Arena* arena)
+    : m_arena(arena) { }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+    : m_arena(other.m_arena) { }
+
+    T* allocate(size_t n) {
+      return reinterpret_cast<T*>(m_arena->alloc(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) { }
+
+    template<typename U>
+    bool operator == (const ArenaAllocator<U>& other) const {
+      return m_arena == other.m_arena;
+    }
+
+    template<typename U>
+    bool operator != (const ArenaAllocator<U>& other) const {
+      return m_arena != other.m_arena;
+    }
+
+  private:
+
+    Arena* m_arena;
+
+  };
+
+
+  template<typename T>
+  using arena_vector = std::vector<T, ArenaAllocator<T>>;
+
+  template<typename K, typename V>
+  using arena_unordered_map = std::unordered_map<K, V,
+    std::hash<K>, std::equal_to<K>, ArenaAllocator<std::pair<const K, V>>>;
+
+}
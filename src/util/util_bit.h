@@ -144,6 +144,18 @@ namespace dxvk::bit {
     #endif
   }
 
+  inline uint32_t lzcnt(uint64_t n) {
+    #if (defined(_M_X64) && defined(_MSC_VER) && !defined(__clang__)) || (defined(__x86_64__) && defined(__LZCNT__))
+    return _lzcnt_u64(n);
+    #elif defined(__GNUC__) || defined(__clang__)
+    return n != 0 ? __builtin_clzll(n) : 64;
+    #else
+    uint32_t lo = uint32_t(n);
+    uint32_t hi = uint32_t(n >> 32u);
+    return hi ? lzcnt(hi) : 32u + lzcnt(lo);
+    #endif
+  }
+
   template<typename T>
   uint32_t pack(T& dst, uint32_t& shift, T src, uint32_t count) {
     constexpr uint32_t Bits = 8 * sizeof(T);
@@ -214,6 +226,63 @@ namespace dxvk::bit {
     #endif
   }
 
+  /**
+   * \brief Accumulates one 16-byte block into a hash
+   *
+   * Multiplies the two 32-bit halves of each 64-bit
+   * lane of the keyed input and adds the result as
+   * well as the lane-swapped input to the accumulator.
+   */
+  inline __m128i bhashStep(__m128i acc, __m128i data, __m128i key) {
+    __m128i keyed = _mm_xor_si128(data, key);
+    __m128i prod  = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+    __m128i swap  = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(_mm_add_epi64(acc, prod), swap);
+  }
+
+  /**
+   * \brief Hashes an aligned struct
+   *
+   * Processes the struct in 32-byte steps using two
+   * independent accumulators. The result is intended
+   * for hash table lookups only and is not stable
+   * across DXVK versions.
+   * \param [in] a The struct
+   * \returns Hash of the struct
+   */
+  template<typename T>
+  size_t bhash(const T* a) {
+    static_assert(alignof(T) >= 16 && sizeof(T) % 16 == 0);
+    auto ai = reinterpret_cast<const __m128i*>(a);
+
+    const __m128i key0 = _mm_set_epi32(0x85ebca6b, 0xc2b2ae35, 0x27d4eb2f, 0x165667b1);
+    const __m128i key1 = _mm_set_epi32(0x9e3779b1, 0x61c88647, 0x7feb352d, 0x846ca68b);
+
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+
+    size_t i = 0;
+
+    for ( ; i < 2 * (sizeof(T) / 32); i += 2) {
+      acc0 = bhashStep(acc0, _mm_load_si128(ai + i),     key0);
+      acc1 = bhashStep(acc1, _mm_load_si128(ai + i + 1), key1);
+    }
+
+    if (i < sizeof(T) / 16)
+      acc0 = bhashStep(acc0, _mm_load_si128(ai + i), key0);
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes),
+      _mm_xor_si128(acc0, _mm_shuffle_epi32(acc1, _MM_SHUFFLE(1, 0, 3, 2))));
+
+    // Final avalanche so that all bits of the result are usable
+    uint64_t hash = lanes[0] ^ (lanes[1] * 0x9e3779b97f4a7c15ull);
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 32;
+    return size_t(hash);
+  }
+
   template <size_t Bits>
   class bitset {
     static constexpr size_t Dwords = align(Bits, 32) / 32;
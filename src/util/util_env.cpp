@@ -9,6 +9,8 @@
 #endif
 
 #include "util_env.h"
+#include "util_trace.h"
+#include "thread.h"
 
 #include "./com/com_include.h"
 
@@ -101,11 +103,17 @@ namespace dxvk::env {
       str::tows(name.c_str(), wideName.data(), wideName.size());
       (*proc)(::GetCurrentThread(), wideName.data());
     }
+
+    ThreadFn::setCurrentName(name);
 #else
     std::array<char, 16> posixName = {};
     dxvk::str::strlcpy(posixName.data(), name.c_str(), 16);
     ::pthread_setname_np(pthread_self(), posixName.data());
 #endif
+
+#ifdef DXVK_TRACING
+    trace::setThreadName(name.c_str());
+#endif
   }
 
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <thread>
 
 #include "thread.h"
@@ -7,6 +9,10 @@
 
 #include "./log/log.h"
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 namespace dxvk {
   
   FpsLimiter::FpsLimiter() {
@@ -24,7 +30,18 @@ namespace dxvk {
 
 
   FpsLimiter::~FpsLimiter() {
+    if (m_stats.frameCount > 1) {
+      double n    = double(m_stats.frameCount);
+      double mean = m_stats.sum / n;
+      double var  = std::max(0.0, m_stats.sumSquares / n - mean * mean);
+
+      Logger::info(str::format("FpsLimiter: ", m_stats.frameCount, " frames, ",
+        "avg frame time ", mean / 1000.0, " ms, ",
+        "std dev ", std::sqrt(var) / 1000.0, " ms"));
+    }
 
+    if (m_timer)
+      ::CloseHandle(m_timer);
   }
 
 
@@ -51,6 +68,17 @@ namespace dxvk {
   }
 
 
+  void FpsLimiter::setVblankAlignment(bool enable) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_vblankAlign = enable;
+  }
+
+
+  void FpsLimiter::notifyVblank(dxvk::high_resolution_clock::time_point time) {
+    m_lastVblank.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+  }
+
+
   void FpsLimiter::delay(bool vsyncEnabled) {
     std::lock_guard<dxvk::mutex> lock(m_mutex);
 
@@ -77,52 +105,76 @@ namespace dxvk {
       // Don't call sleep if the amount of time to sleep is shorter
       // than the time the function calls are likely going to take
       NtTimerDuration sleepDuration = m_targetInterval - m_deviation - frameTime;
+      NtTimerDuration correction = NtTimerDuration::zero();
+
+      if (m_vblankAlign) {
+        correction = computeVblankCorrection(t1 + sleepDuration);
+        sleepDuration -= correction;
+      }
+
       t1 = sleep(t1, sleepDuration);
 
       // Compensate for any sleep inaccuracies in the next frame, and
       // limit cumulative deviation in order to avoid stutter in case we
       // have a number of slow frames immediately followed by a fast one.
+      // The vblank correction is intentional and must not be undone.
       frameTime = std::chrono::duration_cast<NtTimerDuration>(t1 - t0);
-      m_deviation += frameTime - m_targetInterval;
+      m_deviation += frameTime - (m_targetInterval - correction);
       m_deviation = std::min(m_deviation, m_targetInterval / 16);
     }
 
+    recordFrameTime(frameTime);
     m_lastFrame = t1;
   }
 
 
+  void FpsLimiter::sleepFor(std::chrono::microseconds duration) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (!m_initialized)
+      initialize();
+
+    sleep(dxvk::high_resolution_clock::now(),
+      std::chrono::duration_cast<NtTimerDuration>(duration));
+  }
+
+
   FpsLimiter::TimePoint FpsLimiter::sleep(TimePoint t0, NtTimerDuration duration) {
     if (duration <= NtTimerDuration::zero())
       return t0;
 
-    // On wine, we can rely on NtDelayExecution waiting for more or
-    // less exactly the desired amount of time, and we want to avoid
-    // spamming QueryPerformanceCounter for performance reasons.
-    // On Windows, we busy-wait for the last couple of milliseconds
-    // since sleeping is highly inaccurate and inconsistent.
-    NtTimerDuration sleepThreshold = m_sleepThreshold;
-
-    if (m_sleepGranularity != NtTimerDuration::zero())
-      sleepThreshold += duration / 6;
+    // Sleep for as long as we can and busy-wait for the remaining
+    // time. The busy-wait period is based on how much OS sleeps
+    // have been observed to overshoot, so that we don't burn CPU
+    // time on systems with accurate timers. On wine, this usually
+    // converges to a very small value, and we want to avoid spamming
+    // QueryPerformanceCounter for performance reasons anyway.
+    NtTimerDuration sleepThreshold = std::max(m_sleepThreshold, m_sleepOvershoot);
 
     NtTimerDuration remaining = duration;
     TimePoint t1 = t0;
 
     while (remaining > sleepThreshold) {
       NtTimerDuration sleepDuration = remaining - sleepThreshold;
-
-      if (NtDelayExecution) {
-        LARGE_INTEGER ticks;
-        ticks.QuadPart = -sleepDuration.count();
-
-        NtDelayExecution(FALSE, &ticks);
-      } else {
-        std::this_thread::sleep_for(sleepDuration);
-      }
+      sleepOs(sleepDuration);
 
       t1 = dxvk::high_resolution_clock::now();
-      remaining -= std::chrono::duration_cast<NtTimerDuration>(t1 - t0);
+
+      NtTimerDuration elapsed = std::chrono::duration_cast<NtTimerDuration>(t1 - t0);
+      remaining -= elapsed;
       t0 = t1;
+
+      // Track overshoot, adapting quickly if sleeps get less
+      // accurate and slowly if they become more accurate.
+      NtTimerDuration overshoot = std::clamp(elapsed - sleepDuration,
+        NtTimerDuration::zero(), MaxSpinDuration);
+
+      if (overshoot > m_sleepOvershoot)
+        m_sleepOvershoot = overshoot;
+      else
+        m_sleepOvershoot -= (m_sleepOvershoot - overshoot) / 16;
+
+      sleepThreshold = std::max(m_sleepThreshold, m_sleepOvershoot);
     }
 
     // Busy-wait until we have slept long enough
@@ -136,6 +188,68 @@ namespace dxvk {
   }
 
 
+  void FpsLimiter::sleepOs(NtTimerDuration duration) {
+    LARGE_INTEGER ticks;
+    ticks.QuadPart = -duration.count();
+
+    if (m_timer) {
+      if (::SetWaitableTimer(m_timer, &ticks, 0, nullptr, nullptr, FALSE)) {
+        ::WaitForSingleObject(m_timer, INFINITE);
+        return;
+      }
+    }
+
+    if (NtDelayExecution)
+      NtDelayExecution(FALSE, &ticks);
+    else
+      std::this_thread::sleep_for(duration);
+  }
+
+
+  FpsLimiter::NtTimerDuration FpsLimiter::computeVblankCorrection(TimePoint target) const {
+    int64_t vblank = m_lastVblank.load(std::memory_order_relaxed);
+    int64_t refresh = m_refreshInterval.count();
+    int64_t interval = m_targetInterval.count();
+
+    if (!vblank || refresh <= 0)
+      return NtTimerDuration::zero();
+
+    // Alignment only makes sense if each frame is
+    // supposed to be displayed for a whole number
+    // of refresh cycles
+    int64_t cycles = (interval + refresh / 2) / refresh;
+
+    if (!cycles || std::abs(interval - cycles * refresh) * 100 > refresh * 3)
+      return NtTimerDuration::zero();
+
+    // Ignore stale data, e.g. if present wait timed out or the
+    // refresh rate is slightly off, the phase is meaningless
+    TimePoint vblankTime = TimePoint(TimePoint::duration(vblank));
+    int64_t delta = std::chrono::duration_cast<NtTimerDuration>(target - vblankTime).count();
+
+    if (delta < 0 || delta > 16 * refresh)
+      return NtTimerDuration::zero();
+
+    // Signed distance to the closest vblank. Only correct
+    // part of the error per frame to avoid visible jumps.
+    int64_t phase = delta % refresh;
+
+    if (phase > refresh / 2)
+      phase -= refresh;
+
+    return NtTimerDuration(phase / 8);
+  }
+
+
+  void FpsLimiter::recordFrameTime(NtTimerDuration frameTime) {
+    double us = double(std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count());
+
+    m_stats.frameCount += 1;
+    m_stats.sum        += us;
+    m_stats.sumSquares += us * us;
+  }
+
+
   void FpsLimiter::initialize() {
     HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
 
@@ -164,7 +278,19 @@ namespace dxvk {
       m_sleepGranularity = NtTimerDuration(10000);
     }
 
-    m_sleepThreshold = 4 * m_sleepGranularity;
+    // High-resolution waitable timers are much more accurate than
+    // regular sleeps regardless of the timer resolution, but are
+    // only supported on Windows 10 1803 and newer.
+    m_timer = ::CreateWaitableTimerExW(nullptr, nullptr,
+      CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    if (m_timer)
+      Logger::info("FpsLimiter: Using high-resolution waitable timer");
+
+    // Start out with a conservative busy-wait period and
+    // adapt it based on how accurate sleeps actually are
+    m_sleepThreshold = NtTimerDuration(m_sleepGranularity.count() / 4);
+    m_sleepOvershoot = std::min(4 * m_sleepGranularity, MaxSpinDuration);
     m_lastFrame = dxvk::high_resolution_clock::now();
     m_initialized = true;
   }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "thread.h"
 #include "util_time.h"
 
@@ -38,6 +40,27 @@ namespace dxvk {
      */
     void setDisplayRefreshRate(double refreshRate);
 
+    /**
+     * \brief Enables alignment to vertical blanking intervals
+     *
+     * If enabled, and if the target frame interval is a multiple
+     * of the refresh interval, the limiter gradually shifts frame
+     * start times so that they keep a constant phase relative to
+     * the time frames are displayed, as reported via
+     * \ref notifyVblank. This avoids frames drifting across
+     * vblanks, which causes uneven frame pacing.
+     * \param [in] enable Whether to enable vblank alignment
+     */
+    void setVblankAlignment(bool enable);
+
+    /**
+     * \brief Notifies the limiter that a frame was displayed
+     *
+     * May be called from any thread without blocking.
+     * \param [in] time Time at which the frame was displayed
+     */
+    void notifyVblank(dxvk::high_resolution_clock::time_point time);
+
     /**
      * \brief Stalls calling thread as necessary
      *
@@ -48,6 +71,16 @@ namespace dxvk {
      */
     void delay(bool vsyncEnabled);
 
+    /**
+     * \brief Stalls calling thread for a given time
+     *
+     * Uses the same high-precision sleep as the limiter
+     * itself, and works even if the limiter is disabled.
+     * Used to delay the start of a frame in low latency mode.
+     * \param [in] duration Time to stall the thread for
+     */
+    void sleepFor(std::chrono::microseconds duration);
+
     /**
      * \brief Checks whether the frame rate limiter is enabled
      * \returns \c true if the target frame rate is non-zero.
@@ -65,6 +98,15 @@ namespace dxvk {
     using NtSetTimerResolutionProc = UINT (WINAPI *) (ULONG, BOOL, ULONG*);
     using NtDelayExecutionProc = UINT (WINAPI *) (BOOL, LARGE_INTEGER*);
 
+    /// Upper bound for the busy-wait portion of a sleep
+    constexpr static NtTimerDuration MaxSpinDuration = NtTimerDuration(20000);
+
+    struct FrameStats {
+      uint64_t  frameCount  = 0;
+      double    sum         = 0.0;
+      double    sumSquares  = 0.0;
+    };
+
     dxvk::mutex     m_mutex;
 
     NtTimerDuration m_targetInterval  = NtTimerDuration::zero();
@@ -74,14 +116,27 @@ namespace dxvk {
 
     bool            m_initialized     = false;
     bool            m_envOverride     = false;
+    bool            m_vblankAlign     = false;
+
+    std::atomic<int64_t> m_lastVblank = { 0ll };
 
     NtTimerDuration m_sleepGranularity = NtTimerDuration::zero();
     NtTimerDuration m_sleepThreshold   = NtTimerDuration::zero();
+    NtTimerDuration m_sleepOvershoot   = NtTimerDuration::zero();
 
     NtDelayExecutionProc NtDelayExecution = nullptr;
+    HANDLE          m_timer = nullptr;
+
+    FrameStats      m_stats;
 
     TimePoint sleep(TimePoint t0, NtTimerDuration duration);
 
+    void sleepOs(NtTimerDuration duration);
+
+    NtTimerDuration computeVblankCorrection(TimePoint target) const;
+
+    void recordFrameTime(NtTimerDuration frameTime);
+
     void initialize();
 
   };
@@ -0,0 +1,166 @@
+#include <cstring>
+
+#include "util_hash128.h"
+
+namespace dxvk {
+
+  constexpr uint64_t Hash128Prime1 = 0x9E3779B185EBCA87ull;
+  constexpr uint64_t Hash128Prime2 = 0xC2B2AE3D27D4EB4Full;
+  constexpr uint64_t Hash128Prime3 = 0x165667B19E3779F9ull;
+  constexpr uint64_t Hash128Prime4 = 0x85EBCA77C2B2AE63ull;
+  constexpr uint64_t Hash128Prime5 = 0x27D4EB2F165667C5ull;
+
+  constexpr uint64_t Hash128SeedLo = 0ull;
+  constexpr uint64_t Hash128SeedHi = 0x9E3779B97F4A7C15ull;
+
+  static inline uint64_t hashRotl(uint64_t x, uint32_t r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static inline uint64_t hashRead64(const uint8_t* p) {
+    uint64_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+  }
+
+  static inline uint32_t hashRead32(const uint8_t* p) {
+    uint32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+  }
+
+  static inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+    acc += input * Hash128Prime2;
+    acc  = hashRotl(acc, 31);
+    return acc * Hash128Prime1;
+  }
+
+  static inline uint64_t hashMergeRound(uint64_t acc, uint64_t val) {
+    acc ^= hashRound(0, val);
+    return acc * Hash128Prime1 + Hash128Prime4;
+  }
+
+
+  /**
+   * \brief XXH64 accumulator lanes
+   */
+  struct Hash128Lanes {
+    uint64_t v[4];
+
+    void init(uint64_t seed) {
+      v[0] = seed + Hash128Prime1 + Hash128Prime2;
+      v[1] = seed + Hash128Prime2;
+      v[2] = seed;
+      v[3] = seed - Hash128Prime1;
+    }
+
+    uint64_t merge() const {
+      uint64_t h = hashRotl(v[0],  1) + hashRotl(v[1],  7)
+                 + hashRotl(v[2], 12) + hashRotl(v[3], 18);
+
+      for (uint32_t i = 0; i < 4; i++)
+        h = hashMergeRound(h, v[i]);
+
+      return h;
+    }
+  };
+
+
+  static uint64_t hashFinalize(
+          uint64_t      h,
+    const uint8_t*      p,
+          size_t        remaining) {
+    while (remaining >= 8) {
+      h ^= hashRound(0, hashRead64(p));
+      h  = hashRotl(h, 27) * Hash128Prime1 + Hash128Prime4;
+      p += 8; remaining -= 8;
+    }
+
+    if (remaining >= 4) {
+      h ^= uint64_t(hashRead32(p)) * Hash128Prime1;
+      h  = hashRotl(h, 23) * Hash128Prime2 + Hash128Prime3;
+      p += 4; remaining -= 4;
+    }
+
+    while (remaining) {
+      h ^= uint64_t(*p) * Hash128Prime5;
+      h  = hashRotl(h, 11) * Hash128Prime1;
+      p += 1; remaining -= 1;
+    }
+
+    h ^= h >> 33;
+    h *= Hash128Prime2;
+    h ^= h >> 29;
+    h *= Hash128Prime3;
+    h ^= h >> 32;
+    return h;
+  }
+
+
+  std::string Hash128::toString() const {
+    static const char nibbles[]
+      = { '0', '1', '2', '3', '4', '5', '6', '7',
+          '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+
+    std::string result;
+    result.resize(32);
+
+    for (uint32_t i = 0; i < 16; i++) {
+      uint64_t v = i < 8 ? m_hi : m_lo;
+      uint32_t s = 60 - 8 * (i & 7);
+
+      result.at(2 * i + 0) = nibbles[(v >> (s - 0)) & 0xF];
+      result.at(2 * i + 1) = nibbles[(v >> (s - 4)) & 0xF];
+    }
+
+    return result;
+  }
+
+
+  Hash128 Hash128::compute(
+    const void*     data,
+          size_t    size) {
+    return compute(data, size, Hash128(Hash128SeedLo, Hash128SeedHi));
+  }
+
+
+  Hash128 Hash128::compute(
+    const void*     data,
+          size_t    size,
+    const Hash128&  seed) {
+    auto p = reinterpret_cast<const uint8_t*>(data);
+
+    uint64_t lo = seed.m_lo + Hash128Prime5;
+    uint64_t hi = seed.m_hi + Hash128Prime5;
+
+    if (size >= 32) {
+      // Both lanes consume the same input, so that
+      // the data only needs to be loaded once
+      Hash128Lanes lanesLo, lanesHi;
+      lanesLo.init(seed.m_lo);
+      lanesHi.init(seed.m_hi);
+
+      const uint8_t* end = p + size - 32;
+
+      do {
+        for (uint32_t i = 0; i < 4; i++) {
+          uint64_t input = hashRead64(p + 8 * i);
+          lanesLo.v[i] = hashRound(lanesLo.v[i], input);
+          lanesHi.v[i] = hashRound(lanesHi.v[i], input);
+        }
+
+        p += 32;
+      } while (p <= end);
+
+      lo = lanesLo.merge();
+      hi = lanesHi.merge();
+    }
+
+    size_t remaining = size & 31;
+
+    lo = hashFinalize(lo + uint64_t(size), p, remaining);
+    hi = hashFinalize(hi + uint64_t(size), p, remaining);
+    return Hash128(lo, hi);
+  }
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dxvk {
+
+  /**
+   * \brief Fast 128-bit hash
+   *
+   * Non-cryptographic hash built from two XXH64 lanes with
+   * different seeds, computed in a single pass over the data.
+   * Much faster than SHA-1 for large inputs, and suitable for
+   * identifying data in memory and for detecting corrupted
+   * cache files. Must not be used where the hash is part of
+   * a file format that other versions of DXVK depend on.
+   */
+  class Hash128 {
+
+  public:
+
+    Hash128() { }
+    Hash128(uint64_t lo, uint64_t hi)
+    : m_lo(lo), m_hi(hi) { }
+
+    uint64_t lo() const {
+      return m_lo;
+    }
+
+    uint64_t hi() const {
+      return m_hi;
+    }
+
+    std::string toString() const;
+
+    size_t hash() const {
+      return size_t(m_lo);
+    }
+
+    bool eq(const Hash128& other) const {
+      return m_lo == other.m_lo
+          && m_hi == other.m_hi;
+    }
+
+    bool operator == (const Hash128& other) const {
+      return eq(other);
+    }
+
+    bool operator != (const Hash128& other) const {
+      return !eq(other);
+    }
+
+    /**
+     * \brief Computes hash of a memory region
+     *
+     * \param [in] data Pointer to data
+     * \param [in] size Number of bytes
+     * \returns Hash of the given data
+     */
+    static Hash128 compute(
+      const void*     data,
+            size_t    size);
+
+    /**
+     * \brief Computes hash seeded with a previous hash
+     *
+     * Allows hashing multiple discontiguous memory
+     * regions by chaining the returned hashes. The
+     * result differs from hashing the concatenated data.
+     * \param [in] data Pointer to data
+     * \param [in] size Number of bytes
+     * \param [in] seed Hash of the preceding data
+     * \returns Hash of the given data
+     */
+    static Hash128 compute(
+      const void*     data,
+            size_t    size,
+      const Hash128&  seed);
+
+    template<typename T>
+    static Hash128 compute(const T& data) {
+      return compute(&data, sizeof(T));
+    }
+
+  private:
+
+    uint64_t m_lo = 0;
+    uint64_t m_hi = 0;
+
+  };
+
+}
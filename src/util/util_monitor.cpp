@@ -1,9 +1,17 @@
+#include <unordered_map>
+
 #include "util_monitor.h"
 #include "util_string.h"
 
 #include "./log/log.h"
 
+#include "thread.h"
+
 namespace dxvk {
+
+  static dxvk::mutex g_monitorModeMutex;
+  static std::unordered_map<HMONITOR, std::vector<DEVMODEW>> g_monitorModes;
+
   
   HMONITOR GetDefaultMonitor() {
     return ::MonitorFromPoint({ 0, 0 }, MONITOR_DEFAULTTOPRIMARY);
@@ -70,6 +78,37 @@ namespace dxvk {
   }
 
 
+  std::vector<DEVMODEW> GetMonitorDisplayModes(
+          HMONITOR                hMonitor) {
+    std::lock_guard<dxvk::mutex> lock(g_monitorModeMutex);
+
+    auto entry = g_monitorModes.find(hMonitor);
+
+    if (entry != g_monitorModes.end())
+      return entry->second;
+
+    std::vector<DEVMODEW> modes;
+
+    DEVMODEW devMode = { };
+    devMode.dmSize = sizeof(devMode);
+
+    for (uint32_t i = 0; GetMonitorDisplayMode(hMonitor, i, &devMode); i++)
+      modes.push_back(devMode);
+
+    // Don't cache anything if the monitor is not valid
+    if (!modes.empty())
+      g_monitorModes.insert({ hMonitor, modes });
+
+    return modes;
+  }
+
+
+  void InvalidateMonitorDisplayModes() {
+    std::lock_guard<dxvk::mutex> lock(g_monitorModeMutex);
+    g_monitorModes.clear();
+  }
+
+
   BOOL CALLBACK RestoreMonitorDisplayModeCallback(
           HMONITOR                hMonitor,
           HDC                     hDC,
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "./com/com_include.h"
 
 namespace dxvk {
@@ -35,6 +37,26 @@ namespace dxvk {
           DWORD                   modeNum,
           DEVMODEW*               pMode);
 
+  /**
+   * \brief Enumerates all monitor display modes
+   *
+   * Display modes are enumerated only once per monitor and
+   * then cached, since enumerating them can be slow and some
+   * applications query the mode list many times.
+   * \param [in] hMonitor The monitor to query
+   * \returns All display modes supported by the monitor
+   */
+  std::vector<DEVMODEW> GetMonitorDisplayModes(
+          HMONITOR                hMonitor);
+
+  /**
+   * \brief Invalidates cached display mode lists
+   *
+   * Must be called when the set of available display
+   * modes may have changed, e.g. on \c WM_DISPLAYCHANGE.
+   */
+  void InvalidateMonitorDisplayModes();
+
   /**
    * \brief Change display modes to registry settings
    * \returns \c true on success
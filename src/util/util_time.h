@@ -19,9 +19,12 @@ namespace dxvk {
     using time_point = std::chrono::time_point<high_resolution_clock>;
 
     static inline time_point now() noexcept {
+      return fromCounter(getCounter());
+    }
+
+    static inline time_point fromCounter(int64_t counter) noexcept {
       // Keep the frequency static, this doesn't change at all.
       static const int64_t freq = getFrequency();
-      const int64_t counter     = getCounter();
 
       const int64_t whole = (counter / freq) * period::den;
       const int64_t part  = (counter % freq) * period::den / freq;
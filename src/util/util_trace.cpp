@@ -0,0 +1,176 @@
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "util_env.h"
+#include "util_string.h"
+#include "util_trace.h"
+
+#include "thread.h"
+
+namespace dxvk::trace {
+
+  /// Number of events buffered per thread before writing
+  constexpr static size_t  MaxBufferedEvents = 1024;
+  /// Time after which buffered events are written, in ns
+  constexpr static int64_t MaxBufferedTime = 100'000'000;
+
+
+  /**
+   * \brief Trace file writer
+   *
+   * Writes events in the JSON array variant of the
+   * Chrome trace event format. The closing bracket
+   * is optional in that format, so a trace remains
+   * readable if the process gets terminated.
+   */
+  class TraceWriter {
+
+  public:
+
+    TraceWriter() {
+      std::string path = env::getEnvVar("DXVK_TRACE_PATH");
+
+      if (path == "none")
+        return;
+
+      if (!path.empty() && *path.rbegin() != '/')
+        path += '/';
+
+      path += env::getExeBaseName() + "_trace.json";
+
+      m_stream = std::ofstream(str::tows(path.c_str()).c_str());
+
+      if (m_stream)
+        m_stream << "[";
+    }
+
+    ~TraceWriter() {
+      if (m_stream)
+        m_stream << "\n]\n";
+    }
+
+    void write(const std::string& data) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (m_stream) {
+        // Every record starts with a separator, which
+        // must be omitted for the first one in the file
+        size_t offset = m_empty ? 1 : 0;
+        m_stream.write(data.data() + offset, data.size() - offset);
+        m_stream.flush();
+        m_empty = false;
+      }
+    }
+
+  private:
+
+    dxvk::mutex   m_mutex;
+    std::ofstream m_stream;
+    bool          m_empty = true;
+
+  };
+
+
+  /**
+   * \brief Per-thread event buffer
+   */
+  class TraceBuffer {
+
+  public:
+
+    TraceBuffer()
+    : m_tid(dxvk::this_thread::get_id()) {
+      m_events.reserve(MaxBufferedEvents);
+    }
+
+    ~TraceBuffer() {
+      flush();
+    }
+
+    void record(const TraceEvent& event) {
+      if (m_events.empty())
+        m_firstEvent = event.end;
+
+      m_events.push_back(event);
+
+      if (m_events.size() >= MaxBufferedEvents
+       || event.end - m_firstEvent >= MaxBufferedTime)
+        flush();
+    }
+
+    void setName(const char* name) {
+      m_data += str::format(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":", getPid(),
+        ",\"tid\":", m_tid, ",\"args\":{\"name\":\"", name, "\"}}");
+    }
+
+    void flush() {
+      for (const auto& e : m_events) {
+        m_data += str::format(",\n{\"name\":\"", e.name, "\",\"ph\":\"X\",\"pid\":", getPid(),
+          ",\"tid\":", m_tid, ",\"ts\":", formatTime(e.start),
+          ",\"dur\":", formatTime(e.end - e.start), "}");
+      }
+
+      m_events.clear();
+
+      if (!m_data.empty()) {
+        getWriter().write(m_data);
+        m_data.clear();
+      }
+    }
+
+  private:
+
+    uint32_t                m_tid;
+    int64_t                 m_firstEvent = 0;
+    std::vector<TraceEvent> m_events;
+    std::string             m_data;
+
+    static std::string formatTime(int64_t ns) {
+      // Trace timestamps are in microseconds
+      return str::format(ns / 1000, ".", std::setfill('0'), std::setw(3), ns % 1000);
+    }
+
+    static uint32_t getPid() {
+#ifdef _WIN32
+      return uint32_t(::GetCurrentProcessId());
+#else
+      return uint32_t(::getpid());
+#endif
+    }
+
+    static TraceWriter& getWriter() {
+      static TraceWriter writer;
+      return writer;
+    }
+
+  };
+
+
+  static TraceBuffer& getThreadBuffer() {
+    static thread_local TraceBuffer buffer;
+    return buffer;
+  }
+
+
+  void recordEvent(const TraceEvent& event) {
+    getThreadBuffer().record(event);
+  }
+
+
+  void setThreadName(const char* name) {
+    getThreadBuffer().setName(name);
+  }
+
+
+  void flush() {
+#ifdef DXVK_TRACING
+    getThreadBuffer().flush();
+#endif
+  }
+
+}
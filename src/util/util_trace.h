@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+#include "util_time.h"
+
+namespace dxvk::trace {
+
+  /**
+   * \brief Trace event
+   *
+   * A named CPU time range on a given thread.
+   * Timestamps are raw \c high_resolution_clock
+   * values, so that they line up with traces that
+   * the application records with the same clock.
+   */
+  struct TraceEvent {
+    /// Zone name, must be a string literal
+    const char* name  = nullptr;
+    /// Start time, in nanoseconds
+    int64_t     start = 0;
+    /// End time, in nanoseconds
+    int64_t     end   = 0;
+  };
+
+
+  /**
+   * \brief Records a trace event for the calling thread
+   *
+   * Events are buffered per thread and written to the
+   * trace file in the Chrome trace event format, which
+   * can be opened in Perfetto or chrome://tracing. The
+   * file is \c <exe>_trace.json in \c DXVK_TRACE_PATH,
+   * or in the working directory if that is not set.
+   * Setting \c DXVK_TRACE_PATH to \c none disables it.
+   * \param [in] event The event
+   */
+  void recordEvent(const TraceEvent& event);
+
+  /**
+   * \brief Names the calling thread in the trace
+   *
+   * \param [in] name Thread name
+   */
+  void setThreadName(const char* name);
+
+  /**
+   * \brief Writes buffered events of the calling thread
+   *
+   * Events of other threads are written when their
+   * buffers fill up or when those threads exit. Does
+   * nothing unless tracing is enabled.
+   */
+  void flush();
+
+
+  /**
+   * \brief Trace zone
+   *
+   * Records the time between construction
+   * and destruction as a trace event.
+   */
+  class TraceScope {
+
+  public:
+
+    explicit TraceScope(const char* name) {
+      m_event.name  = name;
+      m_event.start = now();
+    }
+
+    ~TraceScope() {
+      m_event.end = now();
+      recordEvent(m_event);
+    }
+
+    TraceScope             (const TraceScope&) = delete;
+    TraceScope& operator = (const TraceScope&) = delete;
+
+  private:
+
+    TraceEvent m_event;
+
+    static int64_t now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        dxvk::high_resolution_clock::now().time_since_epoch()).count();
+    }
+
+  };
+
+}
+
+#define DXVK_TRACE_CONCAT_(a, b) a ## b
+#define DXVK_TRACE_CONCAT(a, b) DXVK_TRACE_CONCAT_(a, b)
+
+/**
+ * \brief Declares a trace zone for the current scope
+ *
+ * Compiles to nothing unless \c DXVK_TRACING is
+ * defined, which the \c enable_tracing build
+ * option does. The name must be a string literal.
+ */
+#ifdef DXVK_TRACING
+#define DXVK_TRACE_SCOPE(name) \
+  ::dxvk::trace::TraceScope DXVK_TRACE_CONCAT(dxvk_trace_, __LINE__)(name)
+#else
+#define DXVK_TRACE_SCOPE(name) do { } while (0)
+#endif
@@ -134,6 +134,10 @@ namespace dxvk::vk {
     VULKAN_FN(vkGetPhysicalDeviceSurfacePresentModesKHR);
     #endif
     
+    #ifdef VK_EXT_calibrated_timestamps
+    VULKAN_FN(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT);
+    #endif
+
     #ifdef VK_EXT_debug_report
     VULKAN_FN(vkCreateDebugReportCallbackEXT);
     VULKAN_FN(vkDestroyDebugReportCallbackEXT);
@@ -309,11 +313,20 @@ namespace dxvk::vk {
     VULKAN_FN(vkQueuePresentKHR);
     #endif
 
+    #ifdef VK_EXT_calibrated_timestamps
+    VULKAN_FN(vkGetCalibratedTimestampsEXT);
+    #endif
+
     #ifdef VK_EXT_conditional_rendering
     VULKAN_FN(vkCmdBeginConditionalRenderingEXT);
     VULKAN_FN(vkCmdEndConditionalRenderingEXT);
     #endif
 
+    #ifdef VK_EXT_multi_draw
+    VULKAN_FN(vkCmdDrawMultiEXT);
+    VULKAN_FN(vkCmdDrawMultiIndexedEXT);
+    #endif
+
     #ifdef VK_EXT_extended_dynamic_state
     VULKAN_FN(vkCmdBindVertexBuffers2EXT);
     VULKAN_FN(vkCmdSetCullModeEXT);
@@ -329,6 +342,12 @@ namespace dxvk::vk {
     VULKAN_FN(vkCmdSetViewportWithCountEXT);
     #endif
 
+    #ifdef VK_EXT_extended_dynamic_state2
+    VULKAN_FN(vkCmdSetDepthBiasEnableEXT);
+    VULKAN_FN(vkCmdSetLogicOpEXT);
+    VULKAN_FN(vkCmdSetPrimitiveRestartEnableEXT);
+    #endif
+
     #ifdef VK_EXT_full_screen_exclusive
     VULKAN_FN(vkAcquireFullScreenExclusiveModeEXT);
     VULKAN_FN(vkReleaseFullScreenExclusiveModeEXT);
@@ -348,6 +367,10 @@ namespace dxvk::vk {
     VULKAN_FN(vkCmdEndQueryIndexedEXT);
     #endif
 
+    #ifdef VK_EXT_vertex_input_dynamic_state
+    VULKAN_FN(vkCmdSetVertexInputEXT);
+    #endif
+
     #ifdef VK_NVX_image_view_handle
     VULKAN_FN(vkGetImageViewHandleNVX);
     VULKAN_FN(vkGetImageViewAddressNVX);
@@ -370,10 +393,32 @@ namespace dxvk::vk {
     VULKAN_FN(vkCmdEndRenderingKHR);
     #endif
 
+    #ifdef VK_KHR_present_wait
+    VULKAN_FN(vkWaitForPresentKHR);
+    #endif
+
+    #ifdef VK_KHR_push_descriptor
+    VULKAN_FN(vkCmdPushDescriptorSetKHR);
+    #endif
+
+    #ifdef VK_KHR_synchronization2
+    VULKAN_FN(vkCmdPipelineBarrier2KHR);
+    #endif
+
+    #ifdef VK_KHR_timeline_semaphore
+    VULKAN_FN(vkGetSemaphoreCounterValueKHR);
+    VULKAN_FN(vkWaitSemaphoresKHR);
+    #endif
+
     #ifdef VK_KHR_external_memory_win32
     VULKAN_FN(vkGetMemoryWin32HandleKHR);
     VULKAN_FN(vkGetMemoryWin32HandlePropertiesKHR);
     #endif
+
+    #ifdef VK_KHR_external_semaphore_win32
+    VULKAN_FN(vkGetSemaphoreWin32HandleKHR);
+    VULKAN_FN(vkImportSemaphoreWin32HandleKHR);
+    #endif
   };
   
 }
@@ -2,6 +2,8 @@
 
 #include "../dxvk/dxvk_format.h"
 
+#include "../util/util_env.h"
+
 namespace dxvk::vk {
 
   Presenter::Presenter(
@@ -24,11 +26,24 @@ namespace dxvk::vk {
 
     if (recreateSwapChain(desc) != VK_SUCCESS)
       throw DxvkError("Failed to create swap chain");
+
+    if (m_device.features.presentWait)
+      m_frameThread = dxvk::thread([this] () { runFrameThread(); });
   }
 
   
   Presenter::~Presenter() {
+    if (m_frameThread.joinable()) {
+      { std::lock_guard<dxvk::mutex> lock(m_frameMutex);
+        m_frameStopped = true;
+      }
+
+      m_frameCond.notify_all();
+      m_frameThread.join();
+    }
+
     destroySwapchain();
+    destroyRetiredSwapchains(true);
     destroySurface();
   }
 
@@ -61,9 +76,19 @@ namespace dxvk::vk {
   }
 
 
-  VkResult Presenter::presentImage() {
+  VkResult Presenter::presentImage(
+          uint64_t        frameId,
+    const std::vector<VkRectLayerKHR>& regions) {
     PresenterSync sync = m_semaphores.at(m_frameIndex);
 
+    uint64_t presentId = ++m_presentId;
+
+    VkPresentIdKHR presentIdInfo;
+    presentIdInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.pNext          = nullptr;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds    = &presentId;
+
     VkPresentInfoKHR info;
     info.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     info.pNext              = nullptr;
@@ -74,8 +99,45 @@ namespace dxvk::vk {
     info.pImageIndices      = &m_imageIndex;
     info.pResults           = nullptr;
 
+    if (m_device.features.presentWait)
+      info.pNext = &presentIdInfo;
+
+    // Let the compositor know which parts of the image changed
+    VkPresentRegionKHR region;
+    region.rectangleCount = uint32_t(regions.size());
+    region.pRectangles    = regions.data();
+
+    VkPresentRegionsKHR regionInfo;
+    regionInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR;
+    regionInfo.pNext          = info.pNext;
+    regionInfo.swapchainCount = 1;
+    regionInfo.pRegions       = &region;
+
+    if (m_device.features.incrementalPresent && !regions.empty())
+      info.pNext = &regionInfo;
+
     VkResult status = m_vkd->vkQueuePresentKHR(m_device.queue, &info);
 
+    if (m_device.features.presentWait && frameId) {
+      // Hand the frame off to the frame thread even if presentation
+      // failed, so that frames are always signaled in order and the
+      // application never waits for a frame that won't be displayed
+      std::lock_guard<dxvk::mutex> lock(m_frameMutex);
+
+      PresenterFrame frame;
+      frame.swapchain = m_swapchain;
+      frame.presentId = status >= 0 ? presentId : 0;
+      frame.frameId   = frameId;
+      frame.signal    = m_signal;
+
+      m_frameQueue.push_back(std::move(frame));
+      m_frameCond.notify_one();
+    }
+
+    // Free swap chains that the GPU is no longer using
+    if (!m_retired.empty())
+      destroyRetiredSwapchains(false);
+
     if (status != VK_SUCCESS && status != VK_SUBOPTIMAL_KHR)
       return status;
 
@@ -98,9 +160,20 @@ namespace dxvk::vk {
   }
 
   
+  void Presenter::setFrameSignal(
+    const Rc<sync::Signal>& signal) {
+    std::lock_guard<dxvk::mutex> lock(m_frameMutex);
+    m_signal = signal;
+  }
+
+
   VkResult Presenter::recreateSwapChain(const PresenterDesc& desc) {
+    // Keep the old swap chain around so that it can be handed
+    // to the new one, and free it once the GPU is done with it
+    VkSwapchainKHR oldSwapchain = m_swapchain;
+
     if (m_swapchain)
-      destroySwapchain();
+      retireSwapchain();
 
     // Query surface capabilities. Some properties might
     // have changed, including the size limits and supported
@@ -114,7 +187,11 @@ namespace dxvk::vk {
     if ((status = m_vki->vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
         m_device.adapter, m_surface, &caps)) != VK_SUCCESS) {
       if (status == VK_ERROR_SURFACE_LOST_KHR) {
-        // Recreate the surface and try again.
+        // Recreate the surface and try again. Swap chains
+        // must be destroyed before the surface they use.
+        destroyRetiredSwapchains(true);
+        oldSwapchain = VK_NULL_HANDLE;
+
         if (m_surface)
           destroySurface();
         if ((status = createSurface()) != VK_SUCCESS)
@@ -168,7 +245,7 @@ namespace dxvk::vk {
     swapInfo.compositeAlpha         = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapInfo.presentMode            = m_info.presentMode;
     swapInfo.clipped                = VK_TRUE;
-    swapInfo.oldSwapchain           = VK_NULL_HANDLE;
+    swapInfo.oldSwapchain           = oldSwapchain;
 
     if (m_device.features.fullScreenExclusive)
       swapInfo.pNext = &fullScreenInfo;
@@ -253,6 +330,17 @@ namespace dxvk::vk {
   }
 
 
+  void Presenter::setFrameRateLimiterVblankAlignment(bool enable) {
+    m_fpsLimiter.setVblankAlignment(enable);
+  }
+
+
+  void Presenter::delayFrameStart(std::chrono::microseconds duration) {
+    if (duration.count() > 0)
+      m_fpsLimiter.sleepFor(duration);
+  }
+
+
   VkResult Presenter::getSupportedFormats(std::vector<VkSurfaceFormatKHR>& formats, const PresenterDesc& desc) {
     uint32_t numFormats = 0;
 
@@ -477,20 +565,95 @@ namespace dxvk::vk {
 
 
   void Presenter::destroySwapchain() {
-    for (const auto& img : m_images)
+    // The frame thread may still be waiting on the swap chain
+    waitForFrames();
+
+    PresenterRetiredSwapchain objects;
+    objects.swapchain  = std::exchange(m_swapchain, VK_NULL_HANDLE);
+    objects.images     = std::exchange(m_images, { });
+    objects.semaphores = std::exchange(m_semaphores, { });
+
+    destroySwapchainObjects(objects);
+  }
+
+
+  void Presenter::retireSwapchain() {
+    PresenterRetiredSwapchain objects;
+    objects.swapchain  = std::exchange(m_swapchain, VK_NULL_HANDLE);
+    objects.images     = std::exchange(m_images, { });
+    objects.semaphores = std::exchange(m_semaphores, { });
+
+    // An empty submission with a fence covers all work that was
+    // previously submitted to the queue, including any command
+    // buffers that access the swap images or their semaphores.
+    VkFenceCreateInfo fenceInfo;
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.pNext = nullptr;
+    fenceInfo.flags = 0;
+
+    VkResult status = m_vkd->vkCreateFence(m_vkd->device(),
+      &fenceInfo, nullptr, &objects.fence);
+
+    if (status == VK_SUCCESS)
+      status = m_vkd->vkQueueSubmit(m_device.queue, 0, nullptr, objects.fence);
+
+    if (status != VK_SUCCESS) {
+      Logger::warn(str::format("Presenter: Failed to retire swap chain: ", status));
+
+      m_vkd->vkQueueWaitIdle(m_device.queue);
+      waitForFrames();
+
+      destroySwapchainObjects(objects);
+      return;
+    }
+
+    m_retired.push_back(std::move(objects));
+  }
+
+
+  void Presenter::destroyRetiredSwapchains(
+          bool                      wait) {
+    if (wait)
+      waitForFrames();
+
+    for (auto i = m_retired.begin(); i != m_retired.end(); ) {
+      bool done = true;
+
+      if (wait) {
+        m_vkd->vkWaitForFences(m_vkd->device(), 1, &i->fence,
+          VK_TRUE, std::numeric_limits<uint64_t>::max());
+      } else {
+        done = m_vkd->vkGetFenceStatus(m_vkd->device(), i->fence) == VK_SUCCESS;
+
+        // Don't pull the swap chain out from under the frame thread
+        std::lock_guard<dxvk::mutex> lock(m_frameMutex);
+
+        for (size_t j = 0; j < m_frameQueue.size() && done; j++)
+          done = m_frameQueue[j].swapchain != i->swapchain;
+      }
+
+      if (done) {
+        destroySwapchainObjects(*i);
+        i = m_retired.erase(i);
+      } else {
+        i++;
+      }
+    }
+  }
+
+
+  void Presenter::destroySwapchainObjects(
+          PresenterRetiredSwapchain& objects) {
+    for (const auto& img : objects.images)
       m_vkd->vkDestroyImageView(m_vkd->device(), img.view, nullptr);
     
-    for (const auto& sem : m_semaphores) {
+    for (const auto& sem : objects.semaphores) {
       m_vkd->vkDestroySemaphore(m_vkd->device(), sem.acquire, nullptr);
       m_vkd->vkDestroySemaphore(m_vkd->device(), sem.present, nullptr);
     }
 
-    m_vkd->vkDestroySwapchainKHR(m_vkd->device(), m_swapchain, nullptr);
-
-    m_images.clear();
-    m_semaphores.clear();
-
-    m_swapchain = VK_NULL_HANDLE;
+    m_vkd->vkDestroySwapchainKHR(m_vkd->device(), objects.swapchain, nullptr);
+    m_vkd->vkDestroyFence(m_vkd->device(), objects.fence, nullptr);
   }
 
 
@@ -498,4 +661,52 @@ namespace dxvk::vk {
     m_vki->vkDestroySurfaceKHR(m_vki->instance(), m_surface, nullptr);
   }
 
+
+  void Presenter::waitForFrames() {
+    std::unique_lock<dxvk::mutex> lock(m_frameMutex);
+
+    m_frameCond.wait(lock, [this] {
+      return m_frameQueue.empty();
+    });
+  }
+
+
+  void Presenter::runFrameThread() {
+    env::setThreadName("dxvk-frame");
+
+    std::unique_lock<dxvk::mutex> lock(m_frameMutex);
+
+    while (true) {
+      m_frameCond.wait(lock, [this] {
+        return m_frameStopped || !m_frameQueue.empty();
+      });
+
+      // Drain the queue before exiting so that
+      // no frame is left without being signaled
+      if (m_frameQueue.empty())
+        break;
+
+      PresenterFrame frame = m_frameQueue.front();
+      lock.unlock();
+
+      // Use a timeout so that we don't block indefinitely
+      // on frames that never get displayed, e.g. if the
+      // window is minimized or the swap chain gets lost.
+      if (frame.presentId) {
+        VkResult vr = m_vkd->vkWaitForPresentKHR(m_vkd->device(),
+          frame.swapchain, frame.presentId, PresentWaitTimeout);
+
+        if (vr == VK_SUCCESS)
+          m_fpsLimiter.notifyVblank(dxvk::high_resolution_clock::now());
+      }
+
+      if (frame.signal != nullptr)
+        frame.signal->signal(frame.frameId);
+
+      lock.lock();
+      m_frameQueue.pop_front();
+      m_frameCond.notify_all();
+    }
+  }
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <vector>
 
 #include "../util/log/log.h"
@@ -9,6 +10,8 @@
 #include "../util/util_math.h"
 #include "../util/util_string.h"
 
+#include "../util/sync/sync_signal.h"
+
 #include "vulkan_loader.h"
 
 namespace dxvk::vk {
@@ -48,6 +51,8 @@ namespace dxvk::vk {
    */
   struct PresenterFeatures {
     bool                fullScreenExclusive : 1;
+    bool                presentWait         : 1;
+    bool                incrementalPresent  : 1;
   };
   
   /**
@@ -81,6 +86,35 @@ namespace dxvk::vk {
     VkSemaphore present;
   };
 
+  /**
+   * \brief Pending frame
+   *
+   * Stores the present ID to wait for on the
+   * frame thread, as well as the signal and
+   * value to signal once the wait completes.
+   */
+  struct PresenterFrame {
+    VkSwapchainKHR      swapchain;
+    uint64_t            presentId;
+    uint64_t            frameId;
+    Rc<sync::Signal>    signal;
+  };
+
+  /**
+   * \brief Retired swap chain
+   *
+   * Swap chain objects that may still be in use by
+   * the GPU after the swap chain has been replaced.
+   * The fence is signaled once all work submitted
+   * prior to retiring the swap chain has completed.
+   */
+  struct PresenterRetiredSwapchain {
+    VkSwapchainKHR              swapchain = VK_NULL_HANDLE;
+    VkFence                     fence     = VK_NULL_HANDLE;
+    std::vector<PresenterImage> images;
+    std::vector<PresenterSync>  semaphores;
+  };
+
   /**
    * \brief Vulkan presenter
    * 
@@ -89,7 +123,8 @@ namespace dxvk::vk {
    * window system integration.
    */
   class Presenter : public RcObject {
-
+    /// Maximum time to wait for a single present, in ns
+    constexpr static uint64_t PresentWaitTimeout = 100'000'000ull;
   public:
 
     Presenter(
@@ -138,16 +173,27 @@ namespace dxvk::vk {
      * Presents the current image. If this returns
      * an error, the swap chain must be recreated,
      * but do not present before acquiring an image.
+     * If present wait is supported, the given frame
+     * ID will be signaled on the frame signal once
+     * the image has actually been displayed.
+     * \param [in] frameId Frame ID to signal, or 0
+     * \param [in] regions Changed regions of the image. If
+     *    empty, the entire image is assumed to have changed.
      * \returns Status of the operation
      */
-    VkResult presentImage();
+    VkResult presentImage(
+            uint64_t        frameId,
+      const std::vector<VkRectLayerKHR>& regions);
     
     /**
      * \brief Changes presenter properties
      * 
-     * Recreates the swap chain immediately. Note that
-     * no swap chain resources must be in use by the
-     * GPU at the time this is called.
+     * Recreates the swap chain immediately. The old swap
+     * chain is passed to the new one and retired, and its
+     * resources are freed once the GPU is done with them,
+     * so there is no need to wait for the device to go
+     * idle. The caller must lock the device queue, and
+     * must not call this while a present is pending.
      * \param [in] desc Swap chain description
      */
     VkResult recreateSwapChain(
@@ -171,6 +217,47 @@ namespace dxvk::vk {
      */
     void setFrameRateLimiterRefreshRate(double refreshRate);
 
+    /**
+     * \brief Enables frame rate limiter alignment to vblanks
+     *
+     * Only has an effect if present wait is supported,
+     * since vblank times are measured on the frame thread.
+     * \param [in] enable Whether to align frames to vblanks
+     */
+    void setFrameRateLimiterVblankAlignment(bool enable);
+
+    /**
+     * \brief Delays the start of the next frame
+     *
+     * Stalls the calling thread using the frame rate
+     * limiter's sleep function. Used in low latency mode.
+     * \param [in] duration Time to stall for
+     */
+    void delayFrameStart(std::chrono::microseconds duration);
+
+    /**
+     * \brief Checks whether present wait is supported
+     *
+     * If this returns \c true, the presenter will signal
+     * frames on the frame signal once they are displayed,
+     * and the caller must not signal them on its own.
+     * \returns \c true if present wait is enabled
+     */
+    bool hasPresentWait() const {
+      return m_device.features.presentWait;
+    }
+
+    /**
+     * \brief Sets frame signal
+     *
+     * Frame IDs passed to \ref presentImage are signaled
+     * on this object once the corresponding image has been
+     * displayed. Only used if present wait is supported.
+     * \param [in] signal Frame signal
+     */
+    void setFrameSignal(
+      const Rc<sync::Signal>& signal);
+
     /**
      * \brief Checks whether a Vulkan swap chain exists
      *
@@ -198,6 +285,8 @@ namespace dxvk::vk {
     std::vector<PresenterImage> m_images;
     std::vector<PresenterSync>  m_semaphores;
 
+    std::vector<PresenterRetiredSwapchain> m_retired;
+
     uint32_t m_imageIndex = 0;
     uint32_t m_frameIndex = 0;
 
@@ -205,6 +294,15 @@ namespace dxvk::vk {
 
     FpsLimiter m_fpsLimiter;
 
+    uint64_t                    m_presentId = 0;
+    Rc<sync::Signal>            m_signal;
+
+    dxvk::mutex                 m_frameMutex;
+    dxvk::condition_variable    m_frameCond;
+    std::deque<PresenterFrame>  m_frameQueue;
+    bool                        m_frameStopped = false;
+    dxvk::thread                m_frameThread;
+
     VkResult getSupportedFormats(
             std::vector<VkSurfaceFormatKHR>& formats,
       const PresenterDesc&            desc);
@@ -241,6 +339,18 @@ namespace dxvk::vk {
 
     void destroySwapchain();
 
+    void retireSwapchain();
+
+    void destroyRetiredSwapchains(
+            bool                      wait);
+
+    void destroySwapchainObjects(
+            PresenterRetiredSwapchain& objects);
+
+    void waitForFrames();
+
+    void runFrameThread();
+
     void destroySurface();
 
   };
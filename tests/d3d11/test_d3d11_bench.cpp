@@ -0,0 +1,449 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <d3dcompiler.h>
+#include <d3d11.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+Logger Logger::s_instance("d3d11_bench.log");
+
+constexpr uint32_t FramesPerLog      = 100;
+constexpr uint32_t DeferredContexts  = 4;
+constexpr uint32_t StreamTextureSize = 128;
+constexpr uint32_t StreamTextures    = 64;
+
+const std::string g_vertexShaderCode =
+  "cbuffer vs_cb : register(b0) {\n"
+  "  float4 v_rect;\n"
+  "};\n"
+  "float4 main(uint vid : SV_VERTEXID) : SV_POSITION {\n"
+  "  float2 coord = float2(vid & 1, vid >> 1);\n"
+  "  return float4(v_rect.xy + coord * v_rect.zw, 0.0f, 1.0f);\n"
+  "}\n";
+
+const std::string g_pixelShaderCode =
+  "Texture2D<float4> tex0 : register(t0);\n"
+  "cbuffer ps_cb : register(b0) {\n"
+  "  float4 color;\n"
+  "};\n"
+  "float4 main() : SV_TARGET {\n"
+  "  return color * tex0.Load(int3(0, 0, 0));\n"
+  "}\n";
+
+enum class Workload {
+  Draws,          ///< Many draws with minimal state changes
+  ConstantStorm,  ///< Constant buffer map/discard before every draw
+  Streaming,      ///< Texture uploads and texture re-creation
+  Deferred,       ///< Draws recorded on deferred contexts
+  Pipelines,      ///< Draws that need a new pipeline each time
+};
+
+struct WorkloadInfo {
+  const char* name;
+  Workload    workload;
+  uint32_t    callsPerFrame;
+};
+
+const std::array<WorkloadInfo, 5> g_workloads = {{
+  { "draws",     Workload::Draws,         50000 },
+  { "cbstorm",   Workload::ConstantStorm, 16384 },
+  { "streaming", Workload::Streaming,     256   },
+  { "deferred",  Workload::Deferred,      16384 },
+  { "pipelines", Workload::Pipelines,     64    },
+}};
+
+/**
+ * Synthetic D3D11 front-end workloads. Each frame issues a fixed
+ * number of API calls of one kind, and the CPU time spent recording
+ * them and presenting is logged every few frames. The pipelines
+ * workload should be run with DXVK_STATE_CACHE=0 and the driver's
+ * shader cache disabled in order to measure cold pipeline creation.
+ *
+ * Usage: d3d11-bench.exe [draws|cbstorm|streaming|deferred|pipelines]
+ */
+class BenchApp {
+
+public:
+
+  BenchApp(HINSTANCE instance, HWND window, const WorkloadInfo& workload)
+  : m_window(window), m_workload(workload) {
+    DXGI_SWAP_CHAIN_DESC swapDesc = { };
+    swapDesc.BufferDesc.Width   = 1024;
+    swapDesc.BufferDesc.Height  = 600;
+    swapDesc.BufferDesc.Format  = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapDesc.SampleDesc         = { 1, 0 };
+    swapDesc.BufferUsage        = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapDesc.BufferCount        = 2;
+    swapDesc.OutputWindow       = m_window;
+    swapDesc.Windowed           = TRUE;
+    swapDesc.SwapEffect         = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+
+    D3D_FEATURE_LEVEL fl = D3D_FEATURE_LEVEL_11_0;
+
+    if (FAILED(D3D11CreateDeviceAndSwapChain(nullptr,
+        D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, &fl, 1, D3D11_SDK_VERSION,
+        &swapDesc, &m_swapChain, &m_device, nullptr, &m_context)))
+      throw DxvkError("Failed to create D3D11 device");
+
+    Com<ID3D11Texture2D> backBuffer;
+
+    if (FAILED(m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)))
+     || FAILED(m_device->CreateRenderTargetView(backBuffer.ptr(), nullptr, &m_rtv)))
+      throw DxvkError("Failed to create render target view");
+
+    Com<ID3DBlob> vsBlob;
+    Com<ID3DBlob> psBlob;
+
+    if (FAILED(D3DCompile(g_vertexShaderCode.data(), g_vertexShaderCode.size(),
+          "Vertex shader", nullptr, nullptr, "main", "vs_5_0", 0, 0, &vsBlob, nullptr))
+     || FAILED(D3DCompile(g_pixelShaderCode.data(), g_pixelShaderCode.size(),
+          "Pixel shader", nullptr, nullptr, "main", "ps_5_0", 0, 0, &psBlob, nullptr)))
+      throw DxvkError("Failed to compile shaders");
+
+    if (FAILED(m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &m_vs))
+     || FAILED(m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &m_ps)))
+      throw DxvkError("Failed to create shaders");
+
+    // Tiny quad so that the benchmark stays CPU-bound
+    std::array<float, 4> rect = { -1.0f, -1.0f, 0.01f, 0.01f };
+    std::array<float, 4> color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    m_vsCb = createConstantBuffer(rect.data(), D3D11_USAGE_IMMUTABLE);
+    m_psCb = createConstantBuffer(color.data(), D3D11_USAGE_IMMUTABLE);
+    m_dynamicCb = createConstantBuffer(color.data(), D3D11_USAGE_DYNAMIC);
+
+    m_texData.resize(StreamTextureSize * StreamTextureSize);
+
+    for (uint32_t i = 0; i < m_texData.size(); i++)
+      m_texData[i] = 0xff000000u | (i * 0x010203u);
+
+    for (uint32_t i = 0; i < m_srvs.size(); i++)
+      createTexture(1, &m_textures[i], &m_srvs[i]);
+
+    if (m_workload.workload == Workload::Streaming) {
+      m_streamTextures.resize(StreamTextures);
+      m_streamSrvs.resize(StreamTextures);
+
+      for (uint32_t i = 0; i < StreamTextures; i++)
+        createTexture(StreamTextureSize, &m_streamTextures[i], &m_streamSrvs[i]);
+    }
+
+    if (m_workload.workload == Workload::Deferred) {
+      for (uint32_t i = 0; i < DeferredContexts; i++) {
+        if (FAILED(m_device->CreateDeferredContext(0, &m_deferred[i])))
+          throw DxvkError("Failed to create deferred context");
+      }
+    }
+  }
+
+  void run() {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    const float clearColor[4] = { 0.17f, 0.24f, 0.31f, 0.0f };
+    m_context->ClearRenderTargetView(m_rtv.ptr(), clearColor);
+    setupState(m_context.ptr());
+
+    switch (m_workload.workload) {
+      case Workload::Draws:         runDraws(m_context.ptr(), m_workload.callsPerFrame); break;
+      case Workload::ConstantStorm: runConstantStorm(); break;
+      case Workload::Streaming:     runStreaming(); break;
+      case Workload::Deferred:      runDeferred(); break;
+      case Workload::Pipelines:     runPipelines(); break;
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_swapChain->Present(0, 0);
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    m_recordTime  += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    m_presentTime += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+    if (++m_frameCount == FramesPerLog) {
+      double usPerFrame   = double(m_recordTime)  / double(m_frameCount);
+      double usPerPresent = double(m_presentTime) / double(m_frameCount);
+      double nsPerCall    = 1000.0 * usPerFrame / double(m_workload.callsPerFrame);
+
+      Logger::info(str::format(m_workload.name, ": ", m_workload.callsPerFrame, " calls per frame, ",
+        uint32_t(usPerFrame), " us per frame, ", uint32_t(usPerPresent), " us per present, ",
+        uint32_t(nsPerCall), " ns per call"));
+
+      m_frameCount  = 0;
+      m_recordTime  = 0;
+      m_presentTime = 0;
+    }
+  }
+
+private:
+
+  HWND                              m_window;
+  WorkloadInfo                      m_workload;
+
+  Com<ID3D11Device>                 m_device;
+  Com<ID3D11DeviceContext>          m_context;
+  Com<IDXGISwapChain>               m_swapChain;
+  Com<ID3D11RenderTargetView>       m_rtv;
+
+  Com<ID3D11VertexShader>           m_vs;
+  Com<ID3D11PixelShader>            m_ps;
+
+  Com<ID3D11Buffer>                 m_vsCb;
+  Com<ID3D11Buffer>                 m_psCb;
+  Com<ID3D11Buffer>                 m_dynamicCb;
+
+  std::array<Com<ID3D11Texture2D>, 2>           m_textures;
+  std::array<Com<ID3D11ShaderResourceView>, 2>  m_srvs;
+
+  std::vector<uint32_t>                         m_texData;
+  std::vector<Com<ID3D11Texture2D>>             m_streamTextures;
+  std::vector<Com<ID3D11ShaderResourceView>>    m_streamSrvs;
+
+  std::array<Com<ID3D11DeviceContext>, DeferredContexts> m_deferred;
+
+  uint32_t                          m_pipelineIndex = 0;
+  uint32_t                          m_streamIndex   = 0;
+
+  uint32_t                          m_frameCount  = 0;
+  uint64_t                          m_recordTime  = 0;
+  uint64_t                          m_presentTime = 0;
+
+  Com<ID3D11Buffer> createConstantBuffer(const void* data, D3D11_USAGE usage) {
+    D3D11_BUFFER_DESC desc = { };
+    desc.ByteWidth      = 16;
+    desc.Usage          = usage;
+    desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = usage == D3D11_USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0;
+
+    D3D11_SUBRESOURCE_DATA initial = { data, 0, 0 };
+
+    Com<ID3D11Buffer> buffer;
+
+    if (FAILED(m_device->CreateBuffer(&desc, &initial, &buffer)))
+      throw DxvkError("Failed to create constant buffer");
+
+    return buffer;
+  }
+
+  void createTexture(uint32_t size, ID3D11Texture2D** texture, ID3D11ShaderResourceView** srv) {
+    D3D11_TEXTURE2D_DESC desc = { };
+    desc.Width      = size;
+    desc.Height     = size;
+    desc.MipLevels  = 1;
+    desc.ArraySize  = 1;
+    desc.Format     = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc = { 1, 0 };
+    desc.Usage      = D3D11_USAGE_DEFAULT;
+    desc.BindFlags  = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA initial = { m_texData.data(), size * sizeof(uint32_t), 0 };
+
+    if (FAILED(m_device->CreateTexture2D(&desc, &initial, texture))
+     || FAILED(m_device->CreateShaderResourceView(*texture, nullptr, srv)))
+      throw DxvkError("Failed to create texture");
+  }
+
+  void setupState(ID3D11DeviceContext* ctx) {
+    D3D11_VIEWPORT viewport = { 0.0f, 0.0f, 1024.0f, 600.0f, 0.0f, 1.0f };
+
+    ctx->OMSetRenderTargets(1, &m_rtv, nullptr);
+    ctx->RSSetViewports(1, &viewport);
+    ctx->IASetInputLayout(nullptr);
+    ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    ctx->VSSetShader(m_vs.ptr(), nullptr, 0);
+    ctx->VSSetConstantBuffers(0, 1, &m_vsCb);
+    ctx->PSSetShader(m_ps.ptr(), nullptr, 0);
+    ctx->PSSetConstantBuffers(0, 1, &m_psCb);
+  }
+
+  void runDraws(ID3D11DeviceContext* ctx, uint32_t count) {
+    // Alternate between two textures so that every
+    // draw has to process at least one binding change
+    for (uint32_t i = 0; i < count; i++) {
+      ctx->PSSetShaderResources(0, 1, &m_srvs[i & 1]);
+      ctx->Draw(4, 0);
+    }
+  }
+
+  void runConstantStorm() {
+    m_context->PSSetConstantBuffers(0, 1, &m_dynamicCb);
+    m_context->PSSetShaderResources(0, 1, &m_srvs[0]);
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      D3D11_MAPPED_SUBRESOURCE sr;
+
+      if (SUCCEEDED(m_context->Map(m_dynamicCb.ptr(), 0, D3D11_MAP_WRITE_DISCARD, 0, &sr))) {
+        float color[4] = { float(i & 0xff) / 255.0f, 1.0f, 1.0f, 1.0f };
+        std::memcpy(sr.pData, color, sizeof(color));
+        m_context->Unmap(m_dynamicCb.ptr(), 0);
+      }
+
+      m_context->Draw(4, 0);
+    }
+  }
+
+  void runStreaming() {
+    // Mostly uploads to existing textures, with the occasional
+    // texture being destroyed and re-created, similar to what
+    // open-world games do when streaming in new assets
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      uint32_t index = (m_streamIndex++) % StreamTextures;
+
+      if (!(m_streamIndex % 64)) {
+        m_streamSrvs[index] = nullptr;
+        m_streamTextures[index] = nullptr;
+
+        createTexture(StreamTextureSize, &m_streamTextures[index], &m_streamSrvs[index]);
+      } else {
+        m_context->UpdateSubresource(m_streamTextures[index].ptr(), 0, nullptr,
+          m_texData.data(), StreamTextureSize * sizeof(uint32_t), 0);
+      }
+
+      m_context->PSSetShaderResources(0, 1, &m_streamSrvs[index]);
+      m_context->Draw(4, 0);
+    }
+  }
+
+  void runDeferred() {
+    uint32_t drawsPerContext = m_workload.callsPerFrame / DeferredContexts;
+
+    std::array<Com<ID3D11CommandList>, DeferredContexts> cmdLists;
+
+    for (uint32_t i = 0; i < DeferredContexts; i++) {
+      setupState(m_deferred[i].ptr());
+      runDraws(m_deferred[i].ptr(), drawsPerContext);
+
+      if (FAILED(m_deferred[i]->FinishCommandList(FALSE, &cmdLists[i])))
+        throw DxvkError("Failed to finish command list");
+    }
+
+    for (uint32_t i = 0; i < DeferredContexts; i++)
+      m_context->ExecuteCommandList(cmdLists[i].ptr(), TRUE);
+  }
+
+  void runPipelines() {
+    static const std::array<D3D11_BLEND, 8> factors = {
+      D3D11_BLEND_ZERO,           D3D11_BLEND_ONE,
+      D3D11_BLEND_SRC_COLOR,      D3D11_BLEND_INV_SRC_COLOR,
+      D3D11_BLEND_SRC_ALPHA,      D3D11_BLEND_INV_SRC_ALPHA,
+      D3D11_BLEND_DEST_COLOR,     D3D11_BLEND_INV_DEST_COLOR,
+    };
+
+    // D3D11 allows up to 4096 unique blend state objects
+    constexpr uint32_t MaxPipelines = 15 * factors.size() * factors.size();
+
+    m_context->PSSetShaderResources(0, 1, &m_srvs[0]);
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      uint32_t index = m_pipelineIndex % MaxPipelines;
+
+      if (++m_pipelineIndex == MaxPipelines)
+        Logger::info("pipelines: All pipeline variants created, pipelines are warm from now on");
+
+      D3D11_BLEND_DESC desc = { };
+      desc.RenderTarget[0].BlendEnable    = TRUE;
+      desc.RenderTarget[0].SrcBlend       = factors[index % factors.size()];
+      desc.RenderTarget[0].DestBlend      = factors[(index / factors.size()) % factors.size()];
+      desc.RenderTarget[0].BlendOp        = D3D11_BLEND_OP_ADD;
+      desc.RenderTarget[0].SrcBlendAlpha  = D3D11_BLEND_ONE;
+      desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+      desc.RenderTarget[0].BlendOpAlpha   = D3D11_BLEND_OP_ADD;
+      desc.RenderTarget[0].RenderTargetWriteMask = UINT8(1 + (index / (factors.size() * factors.size())) % 15);
+
+      Com<ID3D11BlendState> blendState;
+
+      if (FAILED(m_device->CreateBlendState(&desc, &blendState)))
+        throw DxvkError("Failed to create blend state");
+
+      m_context->OMSetBlendState(blendState.ptr(), nullptr, 0xffffffffu);
+      m_context->Draw(4, 0);
+    }
+
+    m_context->OMSetBlendState(nullptr, nullptr, 0xffffffffu);
+  }
+
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  std::string workloadName = lpCmdLine && *lpCmdLine ? lpCmdLine : "draws";
+  const WorkloadInfo* workload = nullptr;
+
+  for (const auto& info : g_workloads) {
+    if (workloadName == info.name)
+      workload = &info;
+  }
+
+  if (!workload) {
+    std::cerr << "Unknown workload: " << workloadName << std::endl;
+    return 1;
+  }
+
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"D3D11 benchmark",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    1024, 600,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+
+  try {
+    BenchApp app(hInstance, hWnd, *workload);
+
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
@@ -0,0 +1,119 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <d3d11.h>
+
+#include <windows.h>
+#include <windowsx.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+// Number of command lists recorded and executed per frame
+constexpr uint32_t ListsPerFrame = 1024;
+// Number of clears recorded into each command list
+constexpr uint32_t ClearsPerList = 8;
+// Number of frames to measure
+constexpr uint32_t FrameCount = 100;
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  Com<ID3D11Device>             device;
+  Com<ID3D11DeviceContext>      context;
+  Com<ID3D11DeviceContext>      deferred;
+  Com<ID3D11Texture2D>          texture;
+  Com<ID3D11RenderTargetView>   rtv;
+
+  if (FAILED(D3D11CreateDevice(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE,
+        nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+        &device, nullptr, &context))) {
+    std::cerr << "Failed to create D3D11 device" << std::endl;
+    return 1;
+  }
+
+  if (FAILED(device->CreateDeferredContext(0, &deferred))) {
+    std::cerr << "Failed to create deferred context" << std::endl;
+    return 1;
+  }
+
+  D3D11_TEXTURE2D_DESC textureDesc;
+  textureDesc.Width              = 64;
+  textureDesc.Height             = 64;
+  textureDesc.MipLevels          = 1;
+  textureDesc.ArraySize          = 1;
+  textureDesc.Format             = DXGI_FORMAT_R8G8B8A8_UNORM;
+  textureDesc.SampleDesc.Count   = 1;
+  textureDesc.SampleDesc.Quality = 0;
+  textureDesc.Usage              = D3D11_USAGE_DEFAULT;
+  textureDesc.BindFlags          = D3D11_BIND_RENDER_TARGET;
+  textureDesc.CPUAccessFlags     = 0;
+  textureDesc.MiscFlags          = 0;
+
+  if (FAILED(device->CreateTexture2D(&textureDesc, nullptr, &texture))) {
+    std::cerr << "Failed to create render target" << std::endl;
+    return 1;
+  }
+
+  if (FAILED(device->CreateRenderTargetView(texture.ptr(), nullptr, &rtv))) {
+    std::cerr << "Failed to create render target view" << std::endl;
+    return 1;
+  }
+
+  D3D11_VIEWPORT viewport = { 0.0f, 0.0f, 64.0f, 64.0f, 0.0f, 1.0f };
+
+  std::vector<Com<ID3D11CommandList>> lists(ListsPerFrame);
+
+  uint64_t recordUs  = 0;
+  uint64_t executeUs = 0;
+
+  for (uint32_t f = 0; f < FrameCount; f++) {
+    // Record many small command lists, similar
+    // to what multi-threaded engines do per frame
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < ListsPerFrame; i++) {
+      deferred->OMSetRenderTargets(1, &rtv, nullptr);
+      deferred->RSSetViewports(1, &viewport);
+
+      for (uint32_t j = 0; j < ClearsPerList; j++) {
+        std::array<float, 4> color = { float(i) / ListsPerFrame, float(j) / ClearsPerList, 0.0f, 1.0f };
+        deferred->ClearRenderTargetView(rtv.ptr(), color.data());
+      }
+
+      lists[i] = nullptr;
+
+      if (FAILED(deferred->FinishCommandList(FALSE, &lists[i]))) {
+        std::cerr << "Failed to finish command list" << std::endl;
+        return 1;
+      }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < ListsPerFrame; i++)
+      context->ExecuteCommandList(lists[i].ptr(), FALSE);
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    context->Flush();
+
+    recordUs  += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    executeUs += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+  }
+
+  uint64_t listCount = uint64_t(ListsPerFrame) * FrameCount;
+
+  std::cout << "Recorded " << listCount << " command lists in " << recordUs << " us ("
+            << (recordUs * 1000) / listCount << " ns per list)" << std::endl;
+  std::cout << "Executed " << listCount << " command lists in " << executeUs << " us ("
+            << (executeUs * 1000) / listCount << " ns per list)" << std::endl;
+
+  context->ClearState();
+  return 0;
+}
@@ -0,0 +1,392 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <d3d9.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+Logger Logger::s_instance("d3d9_bench.log");
+
+struct Vertex {
+  float x, y, z, rhw;
+  DWORD color;
+  float u, v;
+};
+
+constexpr DWORD    VertexFvf         = D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1;
+constexpr uint32_t FramesPerLog      = 100;
+constexpr uint32_t StreamTextureSize = 128;
+constexpr uint32_t StreamTextures    = 64;
+
+enum class Workload {
+  Draws,          ///< Many draws from a static vertex buffer
+  BufferStorm,    ///< Dynamic vertex buffer lock/discard before every draw
+  UpStorm,        ///< DrawPrimitiveUP for every draw
+  Streaming,      ///< Texture uploads and texture re-creation
+  Pipelines,      ///< Draws that need a new pipeline each time
+};
+
+struct WorkloadInfo {
+  const char* name;
+  Workload    workload;
+  uint32_t    callsPerFrame;
+};
+
+const std::array<WorkloadInfo, 5> g_workloads = {{
+  { "draws",     Workload::Draws,       50000 },
+  { "vbstorm",   Workload::BufferStorm, 16384 },
+  { "up",        Workload::UpStorm,     16384 },
+  { "streaming", Workload::Streaming,   256   },
+  { "pipelines", Workload::Pipelines,   64    },
+}};
+
+/**
+ * Synthetic D3D9 front-end workloads. Each frame issues a fixed
+ * number of API calls of one kind, and the CPU time spent recording
+ * them and presenting is logged every few frames. The pipelines
+ * workload should be run with DXVK_STATE_CACHE=0 and the driver's
+ * shader cache disabled in order to measure cold pipeline creation.
+ *
+ * Usage: d3d9-bench.exe [draws|vbstorm|up|streaming|pipelines]
+ */
+class BenchApp {
+
+public:
+
+  BenchApp(HINSTANCE instance, HWND window, const WorkloadInfo& workload)
+  : m_window(window), m_workload(workload) {
+    HRESULT status = Direct3DCreate9Ex(D3D_SDK_VERSION, &m_d3d);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 interface");
+
+    D3DPRESENT_PARAMETERS params = { };
+    params.BackBufferCount        = 1;
+    params.BackBufferFormat       = D3DFMT_X8R8G8B8;
+    params.BackBufferWidth        = 1024;
+    params.BackBufferHeight       = 600;
+    params.hDeviceWindow          = m_window;
+    params.MultiSampleType        = D3DMULTISAMPLE_NONE;
+    params.PresentationInterval   = D3DPRESENT_INTERVAL_IMMEDIATE;
+    params.SwapEffect             = D3DSWAPEFFECT_DISCARD;
+    params.Windowed               = TRUE;
+
+    status = m_d3d->CreateDeviceEx(
+      D3DADAPTER_DEFAULT,
+      D3DDEVTYPE_HAL,
+      m_window,
+      D3DCREATE_HARDWARE_VERTEXPROCESSING,
+      &params,
+      nullptr,
+      &m_device);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 device");
+
+    m_device->SetFVF(VertexFvf);
+    m_device->SetRenderState(D3DRS_LIGHTING, FALSE);
+    m_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    m_device->SetRenderState(D3DRS_ZENABLE,  D3DZB_FALSE);
+
+    // Tiny quad so that the benchmark stays CPU-bound
+    DWORD color = D3DCOLOR_XRGB(0xff, 0x80, 0x40);
+
+    m_quad[0] = { 0.0f, 0.0f, 0.0f, 1.0f, color, 0.0f, 0.0f };
+    m_quad[1] = { 4.0f, 0.0f, 0.0f, 1.0f, color, 1.0f, 0.0f };
+    m_quad[2] = { 0.0f, 4.0f, 0.0f, 1.0f, color, 0.0f, 1.0f };
+    m_quad[3] = { 4.0f, 4.0f, 0.0f, 1.0f, color, 1.0f, 1.0f };
+
+    m_staticVb  = createVertexBuffer(0, D3DPOOL_DEFAULT);
+    m_dynamicVb = createVertexBuffer(D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DPOOL_DEFAULT);
+
+    m_texData.resize(StreamTextureSize * StreamTextureSize);
+
+    for (uint32_t i = 0; i < m_texData.size(); i++)
+      m_texData[i] = 0xff000000u | (i * 0x010203u);
+
+    for (uint32_t i = 0; i < m_textures.size(); i++)
+      m_textures[i] = createTexture(1);
+
+    if (m_workload.workload == Workload::Streaming) {
+      m_streamTextures.resize(StreamTextures);
+
+      for (uint32_t i = 0; i < StreamTextures; i++)
+        m_streamTextures[i] = createTexture(StreamTextureSize);
+    }
+  }
+
+  void run() {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_device->BeginScene();
+    m_device->Clear(0, nullptr, D3DCLEAR_TARGET,
+      D3DCOLOR_RGBA(44, 62, 80, 0), 0.0f, 0);
+
+    switch (m_workload.workload) {
+      case Workload::Draws:       runDraws(); break;
+      case Workload::BufferStorm: runBufferStorm(); break;
+      case Workload::UpStorm:     runUpStorm(); break;
+      case Workload::Streaming:   runStreaming(); break;
+      case Workload::Pipelines:   runPipelines(); break;
+    }
+
+    m_device->EndScene();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_device->PresentEx(nullptr, nullptr, nullptr, nullptr, 0);
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    m_recordTime  += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    m_presentTime += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+    if (++m_frameCount == FramesPerLog) {
+      double usPerFrame   = double(m_recordTime)  / double(m_frameCount);
+      double usPerPresent = double(m_presentTime) / double(m_frameCount);
+      double nsPerCall    = 1000.0 * usPerFrame / double(m_workload.callsPerFrame);
+
+      Logger::info(str::format(m_workload.name, ": ", m_workload.callsPerFrame, " calls per frame, ",
+        uint32_t(usPerFrame), " us per frame, ", uint32_t(usPerPresent), " us per present, ",
+        uint32_t(nsPerCall), " ns per call"));
+
+      m_frameCount  = 0;
+      m_recordTime  = 0;
+      m_presentTime = 0;
+    }
+  }
+
+private:
+
+  HWND                                  m_window;
+  WorkloadInfo                          m_workload;
+
+  Com<IDirect3D9Ex>                     m_d3d;
+  Com<IDirect3DDevice9Ex>               m_device;
+
+  std::array<Vertex, 4>                 m_quad;
+
+  Com<IDirect3DVertexBuffer9>           m_staticVb;
+  Com<IDirect3DVertexBuffer9>           m_dynamicVb;
+
+  std::array<Com<IDirect3DTexture9>, 2> m_textures;
+
+  std::vector<uint32_t>                 m_texData;
+  std::vector<Com<IDirect3DTexture9>>   m_streamTextures;
+
+  uint32_t                              m_pipelineIndex = 0;
+  uint32_t                              m_streamIndex   = 0;
+
+  uint32_t                              m_frameCount  = 0;
+  uint64_t                              m_recordTime  = 0;
+  uint64_t                              m_presentTime = 0;
+
+  Com<IDirect3DVertexBuffer9> createVertexBuffer(DWORD usage, D3DPOOL pool) {
+    Com<IDirect3DVertexBuffer9> buffer;
+
+    if (FAILED(m_device->CreateVertexBuffer(sizeof(m_quad), usage, VertexFvf, pool, &buffer, nullptr)))
+      throw DxvkError("Failed to create vertex buffer");
+
+    void* data = nullptr;
+
+    if (FAILED(buffer->Lock(0, 0, &data, usage & D3DUSAGE_DYNAMIC ? D3DLOCK_DISCARD : 0)))
+      throw DxvkError("Failed to lock vertex buffer");
+
+    std::memcpy(data, m_quad.data(), sizeof(m_quad));
+    buffer->Unlock();
+    return buffer;
+  }
+
+  Com<IDirect3DTexture9> createTexture(uint32_t size) {
+    Com<IDirect3DTexture9> texture;
+
+    if (FAILED(m_device->CreateTexture(size, size, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &texture, nullptr)))
+      throw DxvkError("Failed to create texture");
+
+    uploadTexture(texture.ptr(), size);
+    return texture;
+  }
+
+  void uploadTexture(IDirect3DTexture9* texture, uint32_t size) {
+    D3DLOCKED_RECT rect;
+
+    if (FAILED(texture->LockRect(0, &rect, nullptr, 0)))
+      return;
+
+    for (uint32_t y = 0; y < size; y++) {
+      std::memcpy(reinterpret_cast<char*>(rect.pBits) + y * rect.Pitch,
+        &m_texData[y * size], size * sizeof(uint32_t));
+    }
+
+    texture->UnlockRect(0);
+  }
+
+  void runDraws() {
+    // Alternate between two textures so that every
+    // draw has to process at least one binding change
+    m_device->SetStreamSource(0, m_staticVb.ptr(), 0, sizeof(Vertex));
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      m_device->SetTexture(0, m_textures[i & 1].ptr());
+      m_device->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
+    }
+  }
+
+  void runBufferStorm() {
+    m_device->SetStreamSource(0, m_dynamicVb.ptr(), 0, sizeof(Vertex));
+    m_device->SetTexture(0, m_textures[0].ptr());
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      void* data = nullptr;
+
+      if (SUCCEEDED(m_dynamicVb->Lock(0, 0, &data, D3DLOCK_DISCARD))) {
+        std::memcpy(data, m_quad.data(), sizeof(m_quad));
+        m_dynamicVb->Unlock();
+      }
+
+      m_device->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
+    }
+  }
+
+  void runUpStorm() {
+    m_device->SetTexture(0, m_textures[0].ptr());
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++)
+      m_device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, m_quad.data(), sizeof(Vertex));
+  }
+
+  void runStreaming() {
+    // Mostly uploads to existing textures, with the occasional
+    // texture being destroyed and re-created, similar to what
+    // open-world games do when streaming in new assets
+    m_device->SetStreamSource(0, m_staticVb.ptr(), 0, sizeof(Vertex));
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      uint32_t index = (m_streamIndex++) % StreamTextures;
+
+      if (!(m_streamIndex % 64)) {
+        m_streamTextures[index] = nullptr;
+        m_streamTextures[index] = createTexture(StreamTextureSize);
+      } else {
+        uploadTexture(m_streamTextures[index].ptr(), StreamTextureSize);
+      }
+
+      m_device->SetTexture(0, m_streamTextures[index].ptr());
+      m_device->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
+    }
+  }
+
+  void runPipelines() {
+    static const std::array<D3DBLEND, 8> factors = {
+      D3DBLEND_ZERO,          D3DBLEND_ONE,
+      D3DBLEND_SRCCOLOR,      D3DBLEND_INVSRCCOLOR,
+      D3DBLEND_SRCALPHA,      D3DBLEND_INVSRCALPHA,
+      D3DBLEND_DESTCOLOR,     D3DBLEND_INVDESTCOLOR,
+    };
+
+    constexpr uint32_t MaxPipelines = 15 * factors.size() * factors.size();
+
+    m_device->SetStreamSource(0, m_staticVb.ptr(), 0, sizeof(Vertex));
+    m_device->SetTexture(0, m_textures[0].ptr());
+    m_device->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+
+    for (uint32_t i = 0; i < m_workload.callsPerFrame; i++) {
+      uint32_t index = m_pipelineIndex % MaxPipelines;
+
+      if (++m_pipelineIndex == MaxPipelines)
+        Logger::info("pipelines: All pipeline variants created, pipelines are warm from now on");
+
+      m_device->SetRenderState(D3DRS_SRCBLEND,  factors[index % factors.size()]);
+      m_device->SetRenderState(D3DRS_DESTBLEND, factors[(index / factors.size()) % factors.size()]);
+      m_device->SetRenderState(D3DRS_COLORWRITEENABLE, 1 + (index / (factors.size() * factors.size())) % 15);
+      m_device->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
+    }
+
+    m_device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+    m_device->SetRenderState(D3DRS_COLORWRITEENABLE, 0xf);
+  }
+
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  std::string workloadName = lpCmdLine && *lpCmdLine ? lpCmdLine : "draws";
+  const WorkloadInfo* workload = nullptr;
+
+  for (const auto& info : g_workloads) {
+    if (workloadName == info.name)
+      workload = &info;
+  }
+
+  if (!workload) {
+    std::cerr << "Unknown workload: " << workloadName << std::endl;
+    return 1;
+  }
+
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"D3D9 benchmark",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    1024, 600,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+
+  try {
+    BenchApp app(hInstance, hWnd, *workload);
+
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
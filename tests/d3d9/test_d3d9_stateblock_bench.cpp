@@ -0,0 +1,174 @@
+#include <chrono>
+
+#include <d3d9.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+Logger Logger::s_instance("stateblock_bench.log");
+
+constexpr uint32_t AppliesPerFrame = 4096;
+constexpr uint32_t FramesPerLog    = 100;
+
+class StateBlockBenchApp {
+
+public:
+
+  StateBlockBenchApp(HINSTANCE instance, HWND window)
+  : m_window(window) {
+    HRESULT status = Direct3DCreate9Ex(D3D_SDK_VERSION, &m_d3d);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 interface");
+
+    D3DPRESENT_PARAMETERS params = { };
+    params.BackBufferCount        = 1;
+    params.BackBufferFormat       = D3DFMT_X8R8G8B8;
+    params.BackBufferWidth        = 1024;
+    params.BackBufferHeight       = 600;
+    params.hDeviceWindow          = m_window;
+    params.MultiSampleType        = D3DMULTISAMPLE_NONE;
+    params.PresentationInterval   = D3DPRESENT_INTERVAL_IMMEDIATE;
+    params.SwapEffect             = D3DSWAPEFFECT_DISCARD;
+    params.Windowed               = TRUE;
+
+    status = m_d3d->CreateDeviceEx(
+      D3DADAPTER_DEFAULT,
+      D3DDEVTYPE_HAL,
+      m_window,
+      D3DCREATE_HARDWARE_VERTEXPROCESSING,
+      &params,
+      nullptr,
+      &m_device);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 device");
+
+    // Record a state block resembling what games set up per
+    // material: a handful of render and sampler states, and
+    // a contiguous block of vertex and pixel shader constants
+    std::array<float, 4 * 64> constants = { };
+
+    for (uint32_t i = 0; i < constants.size(); i++)
+      constants[i] = float(i);
+
+    m_device->BeginStateBlock();
+    m_device->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+    m_device->SetRenderState(D3DRS_SRCBLEND,  D3DBLEND_SRCALPHA);
+    m_device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+    m_device->SetRenderState(D3DRS_ZWRITEENABLE, FALSE);
+    m_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    m_device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
+    m_device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+    m_device->SetVertexShaderConstantF(0, constants.data(), 64);
+    m_device->SetPixelShaderConstantF(0, constants.data(), 16);
+    m_device->EndStateBlock(&m_stateBlock);
+  }
+
+  void run() {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < AppliesPerFrame; i++)
+      m_stateBlock->Apply();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_device->BeginScene();
+    m_device->Clear(0, nullptr, D3DCLEAR_TARGET,
+      D3DCOLOR_RGBA(44, 62, 80, 0), 0.0f, 0);
+    m_device->EndScene();
+
+    m_device->PresentEx(nullptr, nullptr, nullptr, nullptr, 0);
+
+    m_applyTime += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+    if (++m_frameCount == FramesPerLog) {
+      double usPerFrame = double(m_applyTime) / double(m_frameCount);
+      double nsPerApply = 1000.0 * usPerFrame / double(AppliesPerFrame);
+
+      Logger::info(str::format("State block applies: ", AppliesPerFrame, " per frame, ",
+        uint32_t(usPerFrame), " us per frame, ", uint32_t(nsPerApply), " ns per apply"));
+
+      m_frameCount = 0;
+      m_applyTime  = 0;
+    }
+  }
+
+private:
+
+  HWND                          m_window;
+
+  Com<IDirect3D9Ex>             m_d3d;
+  Com<IDirect3DDevice9Ex>       m_device;
+  Com<IDirect3DStateBlock9>     m_stateBlock;
+
+  uint32_t                      m_frameCount = 0;
+  uint64_t                      m_applyTime  = 0;
+
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"D3D9 state block benchmark",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    1024, 600,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+
+  try {
+    StateBlockBenchApp app(hInstance, hWnd);
+
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
@@ -0,0 +1,196 @@
+#include <chrono>
+#include <cstring>
+
+#include <d3d9.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+Logger Logger::s_instance("up_bench.log");
+
+struct Vertex {
+  float x, y, z, rhw;
+  DWORD color;
+};
+
+constexpr DWORD    VertexFvf     = D3DFVF_XYZRHW | D3DFVF_DIFFUSE;
+constexpr uint32_t DrawsPerFrame = 4096;
+constexpr uint32_t FramesPerLog  = 100;
+
+class UpBenchApp {
+
+public:
+
+  UpBenchApp(HINSTANCE instance, HWND window)
+  : m_window(window) {
+    HRESULT status = Direct3DCreate9Ex(D3D_SDK_VERSION, &m_d3d);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 interface");
+
+    D3DPRESENT_PARAMETERS params = { };
+    params.BackBufferCount        = 1;
+    params.BackBufferFormat       = D3DFMT_X8R8G8B8;
+    params.BackBufferWidth        = 1024;
+    params.BackBufferHeight       = 600;
+    params.hDeviceWindow          = m_window;
+    params.MultiSampleType        = D3DMULTISAMPLE_NONE;
+    params.PresentationInterval   = D3DPRESENT_INTERVAL_IMMEDIATE;
+    params.SwapEffect             = D3DSWAPEFFECT_DISCARD;
+    params.Windowed               = TRUE;
+
+    status = m_d3d->CreateDeviceEx(
+      D3DADAPTER_DEFAULT,
+      D3DDEVTYPE_HAL,
+      m_window,
+      D3DCREATE_HARDWARE_VERTEXPROCESSING,
+      &params,
+      nullptr,
+      &m_device);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 device");
+
+    m_device->SetFVF(VertexFvf);
+    m_device->SetRenderState(D3DRS_LIGHTING, FALSE);
+    m_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    m_device->SetRenderState(D3DRS_ZENABLE,  D3DZB_FALSE);
+
+    // Grid of small quads, similar to what old games
+    // emit for sprites, particles and UI elements
+    for (uint32_t i = 0; i < DrawsPerFrame; i++) {
+      float x = float(8 * (i % 128));
+      float y = float(8 * (i / 128));
+
+      DWORD color = D3DCOLOR_XRGB(i & 0xff, (i >> 4) & 0xff, 0x80);
+
+      Vertex* quad = &m_vertices[4 * i];
+      quad[0] = { x,        y,        0.0f, 1.0f, color };
+      quad[1] = { x + 6.0f, y,        0.0f, 1.0f, color };
+      quad[2] = { x,        y + 6.0f, 0.0f, 1.0f, color };
+      quad[3] = { x + 6.0f, y + 6.0f, 0.0f, 1.0f, color };
+    }
+  }
+
+  void run() {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_device->BeginScene();
+    m_device->Clear(0, nullptr, D3DCLEAR_TARGET,
+      D3DCOLOR_RGBA(44, 62, 80, 0), 0.0f, 0);
+
+    static const uint16_t indices[6] = { 0, 1, 2, 2, 1, 3 };
+
+    // Alternate between both UP draw types so that
+    // vertex and index data share the same ring
+    for (uint32_t i = 0; i < DrawsPerFrame; i++) {
+      const Vertex* quad = &m_vertices[4 * i];
+
+      if (i & 1) {
+        m_device->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST,
+          0, 4, 2, indices, D3DFMT_INDEX16, quad, sizeof(Vertex));
+      } else {
+        m_device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP,
+          2, quad, sizeof(Vertex));
+      }
+    }
+
+    m_device->EndScene();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_device->PresentEx(nullptr, nullptr, nullptr, nullptr, 0);
+
+    m_drawTime += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+    if (++m_frameCount == FramesPerLog) {
+      double usPerFrame = double(m_drawTime) / double(m_frameCount);
+      double nsPerDraw  = 1000.0 * usPerFrame / double(DrawsPerFrame);
+
+      Logger::info(str::format("UP draws: ", DrawsPerFrame, " per frame, ",
+        uint32_t(usPerFrame), " us per frame, ", uint32_t(nsPerDraw), " ns per draw"));
+
+      m_frameCount = 0;
+      m_drawTime   = 0;
+    }
+  }
+
+private:
+
+  HWND                          m_window;
+
+  Com<IDirect3D9Ex>             m_d3d;
+  Com<IDirect3DDevice9Ex>       m_device;
+
+  std::array<Vertex, 4 * DrawsPerFrame> m_vertices;
+
+  uint32_t                      m_frameCount = 0;
+  uint64_t                      m_drawTime   = 0;
+
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"D3D9 UP draw benchmark",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    1024, 600,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+
+  try {
+    UpBenchApp app(hInstance, hWnd);
+
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
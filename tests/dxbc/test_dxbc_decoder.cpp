@@ -0,0 +1,88 @@
+#include <iterator>
+#include <fstream>
+
+#include "../../src/dxbc/dxbc_module.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-decoder.log");
+}
+
+using namespace dxvk;
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);  
+  
+  if (argc < 3) {
+    Logger::err("Usage: dxbc-decoder iterations input1.dxbc [input2.dxbc ...]");
+    return 1;
+  }
+  
+  try {
+    const uint32_t iterations = std::max(std::stoi(str::fromws(argv[1])), 1);
+    
+    // Load the entire corpus up front so that
+    // file I/O does not affect the measurements
+    std::vector<std::unique_ptr<DxbcModule>> modules;
+    
+    for (int i = 2; i < argc; i++) {
+      std::string ifileName = str::fromws(argv[i]);
+      std::ifstream ifile(ifileName, std::ios::binary);
+      ifile.ignore(std::numeric_limits<std::streamsize>::max());
+      std::streamsize length = ifile.gcount();
+      ifile.clear();
+      
+      ifile.seekg(0, std::ios_base::beg);
+      std::vector<char> dxbcCode(length);
+      ifile.read(dxbcCode.data(), length);
+      
+      DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+      modules.push_back(std::make_unique<DxbcModule>(reader));
+    }
+    
+    uint64_t insCount  = 0;
+    uint64_t wordCount = 0;
+    
+    DxbcDecodeContext decoder;
+    
+    auto t0 = high_resolution_clock::now();
+    
+    for (uint32_t i = 0; i < iterations; i++) {
+      for (const auto& module : modules) {
+        DxbcCodeSlice slice = module->code();
+        wordCount += slice.size();
+        
+        while (!slice.atEnd()) {
+          decoder.decodeInstruction(slice);
+          insCount += 1;
+        }
+      }
+    }
+    
+    auto t1 = high_resolution_clock::now();
+    
+    uint64_t us = std::max<uint64_t>(std::chrono::duration_cast<
+      std::chrono::microseconds>(t1 - t0).count(), 1);
+    
+    Logger::info(str::format("Decoded ", insCount, " instructions (",
+      wordCount * sizeof(uint32_t), " bytes) from ", modules.size(),
+      " shaders in ", us, " us"));
+    Logger::info(str::format("Throughput: ",
+      (insCount * 1000000) / us, " instructions/s, ",
+      (wordCount * sizeof(uint32_t)) / us, " MB/s"));
+    return 0;
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+}
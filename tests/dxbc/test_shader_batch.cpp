@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxso/dxso_module.h"
+#include "../../src/dxso/dxso_modinfo.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+#include "../../src/dxvk/dxvk_pipecache.h"
+#include "../../src/dxvk/dxvk_pipelayout.h"
+#include "../../src/dxvk/dxvk_shader.h"
+
+#include "../../src/util/thread.h"
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("shader-batch.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Shader file to translate
+ */
+struct ShaderJob {
+  std::string       fileName;
+  bool              isDxso = false;
+  std::vector<char> code;
+};
+
+
+/**
+ * \brief Translation result of a single shader
+ */
+struct ShaderResult {
+  VkShaderStageFlagBits stage       = VkShaderStageFlagBits(0);
+  bool                  success     = false;
+  bool                  hasPipeline = false;
+  uint64_t              compileUs   = 0;
+  uint64_t              pipelineUs  = 0;
+  size_t                inputSize   = 0;
+  size_t                outputSize  = 0;
+};
+
+
+/**
+ * \brief Accumulated statistics for one shader stage
+ */
+struct StageStats {
+  uint32_t count        = 0;
+  uint64_t compileUs    = 0;
+  uint64_t compileMaxUs = 0;
+  size_t   inputSize    = 0;
+  size_t   outputSize   = 0;
+  uint32_t pipelines    = 0;
+  uint64_t pipelineUs   = 0;
+  uint64_t pipelineMaxUs = 0;
+};
+
+
+/**
+ * \brief Creates Vulkan pipelines for translated shaders
+ *
+ * Compute shaders get a full compute pipeline. Vertex and
+ * fragment shaders are compiled as pipeline libraries if
+ * the device supports them, since no other pipeline state
+ * is known. Other stages are not compiled.
+ */
+class PipelineCompiler {
+
+public:
+
+  PipelineCompiler(const Rc<DxvkDevice>& device)
+  : m_device(device), m_cache(device.ptr()) { }
+
+  bool compile(const Rc<DxvkShader>& shader, uint64_t& us) {
+    VkShaderStageFlagBits stage = shader->info().stage;
+
+    bool isCompute = stage == VK_SHADER_STAGE_COMPUTE_BIT;
+    bool isLibrary = m_device->canUseGraphicsPipelineLibrary()
+      && shader->canUsePipelineLibrary();
+
+    if (!isCompute && !isLibrary)
+      return false;
+
+    const DxvkBindingLayout& layout = shader->getBindings();
+
+    std::array<std::unique_ptr<DxvkBindingSetLayout>, DxvkDescriptorSets::SetCount> setObjects;
+    std::array<const DxvkBindingSetLayout*, DxvkDescriptorSets::SetCount> setLayouts = { };
+
+    for (uint32_t i = 0; i < setObjects.size(); i++) {
+      setObjects[i] = std::make_unique<DxvkBindingSetLayout>(
+        m_device.ptr(), DxvkBindingSetLayoutKey(layout.getBindingList(i)));
+      setLayouts[i] = setObjects[i].get();
+    }
+
+    DxvkBindingLayoutObjects layoutObjects(m_device.ptr(), layout, setLayouts.data());
+
+    auto t0 = high_resolution_clock::now();
+
+    if (isCompute) {
+      auto vk = m_device->vkd();
+      auto csm = shader->createShaderModule(vk, &layoutObjects, DxvkShaderModuleCreateInfo());
+
+      VkComputePipelineCreateInfo info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+      info.stage              = csm.stageInfo(nullptr);
+      info.layout             = layoutObjects.getPipelineLayout(false);
+      info.basePipelineIndex  = -1;
+
+      VkPipeline pipeline = VK_NULL_HANDLE;
+
+      if (vk->vkCreateComputePipelines(vk->device(), m_cache.handle(), 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+        Logger::err(str::format("Failed to compile pipeline for ", shader->debugName()));
+
+      vk->vkDestroyPipeline(vk->device(), pipeline, nullptr);
+    } else {
+      DxvkShaderPipelineLibrary library(m_device.ptr(), &m_cache, shader, &layoutObjects);
+      library.compilePipeline();
+    }
+
+    auto t1 = high_resolution_clock::now();
+    us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return true;
+  }
+
+private:
+
+  Rc<DxvkDevice>    m_device;
+  DxvkPipelineCache m_cache;
+
+};
+
+
+std::vector<char> readFile(const std::string& fileName) {
+  std::ifstream ifile(fileName, std::ios::binary);
+  ifile.ignore(std::numeric_limits<std::streamsize>::max());
+  std::streamsize length = ifile.gcount();
+  ifile.clear();
+
+  ifile.seekg(0, std::ios_base::beg);
+  std::vector<char> data(length);
+  ifile.read(data.data(), length);
+  return data;
+}
+
+
+void findShaders(const std::string& path, std::vector<ShaderJob>& jobs) {
+  WIN32_FIND_DATAW findData;
+  HANDLE handle = FindFirstFileW(str::tows(str::format(path, "\\*").c_str()).c_str(), &findData);
+
+  if (handle == INVALID_HANDLE_VALUE)
+    return;
+
+  do {
+    std::string name = str::fromws(findData.cFileName);
+
+    if (name == "." || name == "..")
+      continue;
+
+    std::string fileName = str::format(path, "\\", name);
+
+    if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      findShaders(fileName, jobs);
+      continue;
+    }
+
+    // Only pick up the raw shader dumps, not
+    // the disassembly or compiled SPIR-V
+    auto ext = name.find_last_of('.');
+
+    if (ext == std::string::npos)
+      continue;
+
+    std::string extension = name.substr(ext);
+
+    if (extension != ".dxbc" && extension != ".dxso")
+      continue;
+
+    ShaderJob job;
+    job.fileName = std::move(fileName);
+    job.isDxso   = extension == ".dxso";
+    jobs.push_back(std::move(job));
+  } while (FindNextFileW(handle, &findData));
+
+  FindClose(handle);
+}
+
+
+Rc<DxvkShader> compileDxbc(const ShaderJob& job) {
+  DxbcReader reader(job.code.data(), job.code.size());
+  DxbcModule module(reader);
+
+  DxbcModuleInfo moduleInfo;
+  moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+  moduleInfo.options.useDemoteToHelperInvocation = true;
+  moduleInfo.options.minSsboAlignment = 4;
+  moduleInfo.tess = nullptr;
+  moduleInfo.xfb = nullptr;
+
+  return module.compile(moduleInfo, job.fileName);
+}
+
+
+Rc<DxvkShader> compileDxso(const ShaderJob& job) {
+  DxsoReader reader(job.code.data());
+  DxsoModule module(reader);
+
+  DxsoModuleInfo moduleInfo;
+  moduleInfo.options.useDemoteToHelperInvocation = true;
+  moduleInfo.options.strictConstantCopies = false;
+  moduleInfo.options.d3d9FloatEmulation = D3D9FloatEmulation::Enabled;
+  moduleInfo.options.strictPow = true;
+  moduleInfo.options.shaderModel = 3;
+  moduleInfo.options.invariantPosition = true;
+  moduleInfo.options.forceSamplerTypeSpecConstants = false;
+  moduleInfo.options.vertexFloatConstantBufferAsSSBO = false;
+  moduleInfo.options.longMad = false;
+  moduleInfo.options.alphaTestWiggleRoom = false;
+  moduleInfo.options.robustness2Supported = true;
+
+  // Use the same constant layout as a device
+  // without software vertex processing
+  D3D9ConstantLayout layout;
+
+  if (module.info().type() == DxsoProgramTypes::VertexShader) {
+    layout.floatCount = caps::MaxFloatConstantsVS;
+  } else {
+    layout.floatCount = caps::MaxFloatConstantsPS;
+  }
+
+  layout.intCount     = caps::MaxOtherConstants;
+  layout.boolCount    = caps::MaxOtherConstants;
+  layout.bitmaskCount = align(layout.boolCount, 32) / 32;
+
+  DxsoAnalysisInfo analysis = module.analyze();
+  return module.compile(moduleInfo, job.fileName, analysis, layout)[0];
+}
+
+
+const char* getStageName(VkShaderStageFlagBits stage) {
+  switch (stage) {
+    case VK_SHADER_STAGE_VERTEX_BIT:                  return "vs";
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:    return "hs";
+    case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: return "ds";
+    case VK_SHADER_STAGE_GEOMETRY_BIT:                return "gs";
+    case VK_SHADER_STAGE_FRAGMENT_BIT:                return "ps";
+    case VK_SHADER_STAGE_COMPUTE_BIT:                 return "cs";
+    default:                                          return "??";
+  }
+}
+
+
+uint32_t getStageIndex(VkShaderStageFlagBits stage) {
+  return bit::tzcnt(uint32_t(stage));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  uint32_t threadCount = dxvk::thread::hardware_concurrency();
+  bool createPipelines = false;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = str::fromws(argv[i]);
+
+    if (arg == "-p") {
+      createPipelines = true;
+    } else if (arg == "-j" && i + 1 < argc) {
+      threadCount = std::max(std::stoi(str::fromws(argv[++i])), 1);
+    } else {
+      paths.push_back(std::move(arg));
+    }
+  }
+
+  if (paths.empty()) {
+    Logger::err("Usage: shader-batch [-j threads] [-p] directory [directory ...]");
+    return 1;
+  }
+
+  try {
+    std::vector<ShaderJob> jobs;
+
+    for (const auto& path : paths)
+      findShaders(path, jobs);
+
+    // Load all files up front so that file
+    // I/O does not affect the measurements
+    for (auto& job : jobs)
+      job.code = readFile(job.fileName);
+
+    Logger::info(str::format("Found ", jobs.size(), " shaders, using ", threadCount, " threads"));
+
+    Rc<DxvkInstance> instance;
+    Rc<DxvkDevice> device;
+    std::unique_ptr<PipelineCompiler> pipelineCompiler;
+
+    if (createPipelines) {
+      instance = new DxvkInstance();
+      Rc<DxvkAdapter> adapter = instance->enumAdapters(0);
+
+      if (adapter == nullptr) {
+        Logger::err("No Vulkan adapter found");
+        return 1;
+      }
+
+      device = adapter->createDevice(instance, adapter->features());
+      pipelineCompiler = std::make_unique<PipelineCompiler>(device);
+    }
+
+    std::vector<ShaderResult> results(jobs.size());
+    std::atomic<size_t> nextJob = { 0u };
+
+    auto t0 = high_resolution_clock::now();
+
+    std::vector<dxvk::thread> threads;
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+      threads.emplace_back([&] {
+        size_t index;
+
+        while ((index = nextJob++) < jobs.size()) {
+          const ShaderJob& job = jobs[index];
+          ShaderResult& result = results[index];
+          result.inputSize = job.code.size();
+
+          try {
+            auto s0 = high_resolution_clock::now();
+
+            Rc<DxvkShader> shader = job.isDxso
+              ? compileDxso(job)
+              : compileDxbc(job);
+
+            auto s1 = high_resolution_clock::now();
+
+            result.stage      = shader->info().stage;
+            result.compileUs  = std::chrono::duration_cast<std::chrono::microseconds>(s1 - s0).count();
+            result.outputSize = shader->getRawCode().size();
+            result.success    = true;
+
+            if (pipelineCompiler != nullptr)
+              result.hasPipeline = pipelineCompiler->compile(shader, result.pipelineUs);
+          } catch (const DxvkError& e) {
+            Logger::err(str::format(job.fileName, ": ", e.message()));
+          }
+        }
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    auto t1 = high_resolution_clock::now();
+
+    // Accumulate and report statistics per stage
+    std::array<StageStats, 6> stats = { };
+    uint32_t failures = 0;
+
+    for (const auto& result : results) {
+      if (!result.success) {
+        failures += 1;
+        continue;
+      }
+
+      auto& s = stats[getStageIndex(result.stage)];
+      s.count        += 1;
+      s.compileUs    += result.compileUs;
+      s.compileMaxUs  = std::max(s.compileMaxUs, result.compileUs);
+      s.inputSize    += result.inputSize;
+      s.outputSize   += result.outputSize;
+
+      if (result.hasPipeline) {
+        s.pipelines    += 1;
+        s.pipelineUs   += result.pipelineUs;
+        s.pipelineMaxUs = std::max(s.pipelineMaxUs, result.pipelineUs);
+      }
+    }
+
+    for (uint32_t i = 0; i < stats.size(); i++) {
+      const auto& s = stats[i];
+
+      if (!s.count)
+        continue;
+
+      Logger::info(str::format(getStageName(VkShaderStageFlagBits(1u << i)), ": ",
+        s.count, " shaders, translate ", s.compileUs, " us total (avg ",
+        s.compileUs / s.count, " us, max ", s.compileMaxUs, " us), ",
+        s.inputSize, " bytes in, ", s.outputSize, " bytes SPIR-V"));
+
+      if (s.pipelines) {
+        Logger::info(str::format("    ", s.pipelines, " pipelines, compile ",
+          s.pipelineUs, " us total (avg ", s.pipelineUs / s.pipelines,
+          " us, max ", s.pipelineMaxUs, " us)"));
+      }
+    }
+
+    uint64_t totalUs = std::max<uint64_t>(std::chrono::duration_cast<
+      std::chrono::microseconds>(t1 - t0).count(), 1);
+
+    Logger::info(str::format("Processed ", jobs.size() - failures, " shaders in ",
+      totalUs, " us (", (uint64_t(jobs.size() - failures) * 1000000) / totalUs,
+      " shaders/s), ", failures, " failed"));
+    return failures ? 1 : 0;
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+}
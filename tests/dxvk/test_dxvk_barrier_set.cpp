@@ -0,0 +1,151 @@
+#include <iostream>
+
+#include "../../src/dxvk/dxvk_barrier.h"
+
+#include "../../src/util/util_time.h"
+
+using namespace dxvk;
+
+/**
+ * \brief Image slice with exact-match merging only
+ *
+ * Reference implementation of the merge behaviour previously
+ * used by \c DxvkBarrierImageSlice, used for comparison.
+ */
+class LegacyImageSlice {
+
+public:
+
+  LegacyImageSlice() { }
+
+  LegacyImageSlice(VkImageSubresourceRange range, DxvkAccessFlags access)
+  : m_range(range), m_slice(range, access) { }
+
+  bool overlaps(const LegacyImageSlice& slice) const {
+    return m_slice.overlaps(slice.m_slice);
+  }
+
+  bool isDirty(const LegacyImageSlice& slice) const {
+    return m_slice.isDirty(slice.m_slice);
+  }
+
+  bool canMerge(const LegacyImageSlice& slice) const {
+    return m_range.baseMipLevel   == slice.m_range.baseMipLevel
+        && m_range.levelCount     == slice.m_range.levelCount
+        && m_range.baseArrayLayer == slice.m_range.baseArrayLayer
+        && m_range.layerCount     == slice.m_range.layerCount;
+  }
+
+  void merge(const LegacyImageSlice& slice) {
+    m_slice.merge(slice.m_slice);
+  }
+
+  DxvkAccessFlags getAccess() const {
+    return m_slice.getAccess();
+  }
+
+private:
+
+  VkImageSubresourceRange m_range = { };
+  DxvkBarrierImageSlice   m_slice;
+
+};
+
+
+VkImageSubresourceRange makeRange(uint32_t mip, uint32_t layer) {
+  return { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, layer, 1 };
+}
+
+
+/**
+ * \brief Renders to each layer of a large array
+ *
+ * Checks for hazards before each write, similar to what
+ * happens when rendering to every layer of a shadow atlas
+ * within a single command list.
+ */
+template<typename T>
+uint32_t runLayerWrites(DxvkBarrierSubresourceSet<VkImage, T>& set, uint32_t layers) {
+  VkImage image = VkImage(0x1000);
+  uint32_t hazards = 0;
+
+  for (uint32_t i = 0; i < layers; i++) {
+    T slice(makeRange(0, i), DxvkAccess::Write);
+
+    if (set.isDirty(image, slice))
+      hazards += 1;
+
+    set.insert(image, slice);
+  }
+
+  return hazards;
+}
+
+
+/**
+ * \brief Generates mips for a large cube map array
+ *
+ * Reads each layer of the previous mip and writes to the
+ * same layer of the current mip, one layer at a time.
+ */
+template<typename T>
+uint32_t runMipGen(DxvkBarrierSubresourceSet<VkImage, T>& set, uint32_t layers, uint32_t mips) {
+  VkImage image = VkImage(0x2000);
+  uint32_t hazards = 0;
+
+  for (uint32_t m = 1; m < mips; m++) {
+    for (uint32_t i = 0; i < layers; i++) {
+      T src(makeRange(m - 1, i), DxvkAccess::Read);
+      T dst(makeRange(m,     i), DxvkAccess::Write);
+
+      if (set.isDirty(image, src) || set.isDirty(image, dst))
+        hazards += 1;
+
+      set.insert(image, src);
+      set.insert(image, dst);
+    }
+  }
+
+  return hazards;
+}
+
+
+template<typename T>
+void runBenchmark(const char* name) {
+  constexpr uint32_t Layers     = 2048;
+  constexpr uint32_t Mips       = 8;
+  constexpr uint32_t Iterations = 10;
+
+  DxvkBarrierSubresourceSet<VkImage, T> set;
+
+  auto t0 = high_resolution_clock::now();
+  uint32_t layerHazards = 0;
+
+  for (uint32_t i = 0; i < Iterations; i++) {
+    layerHazards += runLayerWrites(set, Layers);
+    set.clear();
+  }
+
+  auto t1 = high_resolution_clock::now();
+  uint32_t mipHazards = 0;
+
+  for (uint32_t i = 0; i < Iterations; i++) {
+    mipHazards += runMipGen(set, Layers, Mips);
+    set.clear();
+  }
+
+  auto t2 = high_resolution_clock::now();
+
+  auto layerUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+  auto mipUs   = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+  std::cout << name << ": layer writes " << layerUs << " us (" << layerHazards << " hazards), "
+            << "mip generation " << mipUs << " us (" << mipHazards << " hazards)" << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+  runBenchmark<LegacyImageSlice>("Exact merge   ");
+  runBenchmark<DxvkBarrierImageSlice>("Adjacent merge");
+  return 0;
+}
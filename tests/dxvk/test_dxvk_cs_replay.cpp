@@ -0,0 +1,335 @@
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_cs.h"
+#include "../../src/dxvk/dxvk_context.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+
+#include "../../src/util/util_time.h"
+
+using namespace dxvk;
+
+/**
+ * \brief Records a reusable command stream
+ *
+ * Commands are stored in multi-use CS chunks, so that
+ * the same stream can be dispatched to the CS thread
+ * any number of times. This makes the CPU cost of
+ * executing the stream reproducible between runs.
+ */
+class CsStreamRecorder {
+
+public:
+
+  CsStreamRecorder(const Rc<DxvkDevice>& device)
+  : m_pool(device) { }
+
+  template<typename Cmd>
+  void emit(Cmd&& command) {
+    if (m_chunks.empty() || !m_chunks.back()->push(command)) {
+      m_chunks.emplace_back(m_pool.allocChunk(DxvkCsChunkFlags()), &m_pool);
+      m_chunks.back()->push(command);
+    }
+  }
+
+  const std::vector<DxvkCsChunkRef>& chunks() const {
+    return m_chunks;
+  }
+
+private:
+
+  DxvkCsChunkPool             m_pool;
+  std::vector<DxvkCsChunkRef> m_chunks;
+
+};
+
+
+/**
+ * \brief Resources used by the synthetic frame
+ */
+struct FrameResources {
+  std::vector<Rc<DxvkBuffer>>    constantBuffers;
+  Rc<DxvkBuffer>                 srcBuffer;
+  Rc<DxvkBuffer>                 dstBuffer;
+  Rc<DxvkBuffer>                 uploadBuffer;
+  std::vector<Rc<DxvkImage>>     colorImages;
+  std::vector<Rc<DxvkImageView>> colorViews;
+  Rc<DxvkImage>                  depthImage;
+  Rc<DxvkImageView>              depthView;
+  Rc<DxvkImage>                  mipImage;
+  Rc<DxvkImageView>              mipView;
+  Rc<DxvkImage>                  arrayImage;
+};
+
+
+constexpr uint32_t ConstantBufferCount  = 64;
+constexpr uint32_t ColorTargetCount     = 8;
+constexpr uint32_t ArrayLayerCount      = 2048;
+constexpr uint32_t ArrayLayersPerFrame  = 256;
+
+constexpr VkExtent3D TargetExtent       = { 1920, 1080, 1 };
+constexpr VkExtent3D ArrayExtent        = { 64, 64, 1 };
+
+
+Rc<DxvkBuffer> createBuffer(const Rc<DxvkDevice>& device, VkDeviceSize size, VkMemoryPropertyFlags memoryType) {
+  DxvkBufferCreateInfo info;
+  info.size   = size;
+  info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+              | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+              | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT
+              | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+  info.access = VK_ACCESS_TRANSFER_READ_BIT
+              | VK_ACCESS_TRANSFER_WRITE_BIT
+              | VK_ACCESS_UNIFORM_READ_BIT;
+  return device->createBuffer(info, memoryType);
+}
+
+
+Rc<DxvkImage> createImage(const Rc<DxvkDevice>& device, VkFormat format, VkExtent3D extent,
+    uint32_t mips, uint32_t layers, VkImageUsageFlags usage) {
+  DxvkImageCreateInfo info;
+  info.type         = VK_IMAGE_TYPE_2D;
+  info.format       = format;
+  info.flags        = 0;
+  info.sampleCount  = VK_SAMPLE_COUNT_1_BIT;
+  info.extent       = extent;
+  info.numLayers    = layers;
+  info.mipLevels    = mips;
+  info.usage        = usage
+                    | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                    | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                    | VK_IMAGE_USAGE_SAMPLED_BIT;
+  info.stages       = VK_PIPELINE_STAGE_TRANSFER_BIT
+                    | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  info.access       = VK_ACCESS_TRANSFER_READ_BIT
+                    | VK_ACCESS_TRANSFER_WRITE_BIT
+                    | VK_ACCESS_SHADER_READ_BIT;
+  info.tiling       = VK_IMAGE_TILING_OPTIMAL;
+  info.layout       = VK_IMAGE_LAYOUT_GENERAL;
+
+  if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+    info.stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    info.access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                |  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    info.layout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  }
+
+  if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+    info.stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                |  VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    info.access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                |  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    info.layout  = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  }
+
+  return device->createImage(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+
+Rc<DxvkImageView> createView(const Rc<DxvkDevice>& device, const Rc<DxvkImage>& image,
+    VkImageUsageFlags usage, VkImageAspectFlags aspect) {
+  DxvkImageViewCreateInfo info;
+  info.type       = VK_IMAGE_VIEW_TYPE_2D;
+  info.format     = image->info().format;
+  info.usage      = usage;
+  info.aspect     = aspect;
+  info.minLevel   = 0;
+  info.numLevels  = image->info().mipLevels;
+  info.minLayer   = 0;
+  info.numLayers  = 1;
+  return device->createImageView(image, info);
+}
+
+
+FrameResources createResources(const Rc<DxvkDevice>& device) {
+  FrameResources res;
+
+  for (uint32_t i = 0; i < ConstantBufferCount; i++)
+    res.constantBuffers.push_back(createBuffer(device, 256, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+  res.srcBuffer = createBuffer(device, 16 << 20, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  res.dstBuffer = createBuffer(device, 16 << 20, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  res.uploadBuffer = createBuffer(device,
+    ArrayExtent.width * ArrayExtent.height * 4 * ArrayLayersPerFrame,
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  for (uint32_t i = 0; i < ColorTargetCount; i++) {
+    res.colorImages.push_back(createImage(device, VK_FORMAT_R8G8B8A8_UNORM,
+      TargetExtent, 1, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT));
+    res.colorViews.push_back(createView(device, res.colorImages.back(),
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT));
+  }
+
+  res.depthImage = createImage(device, VK_FORMAT_D32_SFLOAT,
+    TargetExtent, 1, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+  res.depthView = createView(device, res.depthImage,
+    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+  res.mipImage = createImage(device, VK_FORMAT_R8G8B8A8_UNORM,
+    VkExtent3D { 1024, 1024, 1 }, 11, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+  res.mipView = createView(device, res.mipImage,
+    VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+  res.arrayImage = createImage(device, VK_FORMAT_R8G8B8A8_UNORM,
+    ArrayExtent, 1, ArrayLayerCount, 0);
+  return res;
+}
+
+
+/**
+ * \brief Records one synthetic frame
+ *
+ * Exercises constant buffer updates, buffer copies, deferred
+ * render target clears, image copies, mip generation and
+ * uploads to a large texture array, all of which go through
+ * the barrier tracking and memory management paths.
+ */
+void recordFrame(CsStreamRecorder& recorder, const FrameResources& res, uint32_t frameId) {
+  for (uint32_t i = 0; i < ConstantBufferCount; i++) {
+    std::array<uint32_t, 64> data;
+
+    for (uint32_t j = 0; j < data.size(); j++)
+      data[j] = frameId * 4096 + i * 64 + j;
+
+    recorder.emit([cBuffer = res.constantBuffers[i], data] (DxvkContext* ctx) {
+      ctx->updateBuffer(cBuffer, 0, sizeof(data), data.data());
+    });
+  }
+
+  for (uint32_t i = 0; i < 16; i++) {
+    recorder.emit([cDst = res.dstBuffer, cSrc = res.srcBuffer, i] (DxvkContext* ctx) {
+      ctx->copyBuffer(cDst, VkDeviceSize(i) << 20, cSrc, VkDeviceSize(15 - i) << 20, 1 << 20);
+    });
+  }
+
+  for (uint32_t i = 0; i < ColorTargetCount; i++) {
+    recorder.emit([cView = res.colorViews[i], i] (DxvkContext* ctx) {
+      VkClearValue value = { };
+      value.color.float32[0] = float(i) / float(ColorTargetCount);
+      ctx->clearRenderTarget(cView, VK_IMAGE_ASPECT_COLOR_BIT, value);
+    });
+  }
+
+  recorder.emit([cView = res.depthView] (DxvkContext* ctx) {
+    VkClearValue value = { };
+    value.depthStencil.depth = 1.0f;
+    ctx->clearRenderTarget(cView, VK_IMAGE_ASPECT_DEPTH_BIT, value);
+  });
+
+  for (uint32_t i = 0; i < ColorTargetCount; i++) {
+    recorder.emit([cColor = res.colorViews[i], cDepth = res.depthView] (DxvkContext* ctx) {
+      DxvkRenderTargets targets;
+      targets.color[0].view   = cColor;
+      targets.color[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      targets.depth.view      = cDepth;
+      targets.depth.layout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      ctx->bindRenderTargets(targets);
+    });
+  }
+
+  for (uint32_t i = 1; i < ColorTargetCount; i++) {
+    recorder.emit([cDst = res.colorImages[i], cSrc = res.colorImages[i - 1]] (DxvkContext* ctx) {
+      VkImageSubresourceLayers subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+      ctx->copyImage(cDst, subresource, VkOffset3D { 0, 0, 0 },
+        cSrc, subresource, VkOffset3D { 0, 0, 0 }, TargetExtent);
+    });
+  }
+
+  recorder.emit([cView = res.mipView] (DxvkContext* ctx) {
+    ctx->generateMipmaps(cView, VK_FILTER_LINEAR);
+  });
+
+  uint32_t firstLayer = (frameId * ArrayLayersPerFrame) % ArrayLayerCount;
+
+  for (uint32_t i = 0; i < ArrayLayersPerFrame; i++) {
+    recorder.emit([cImage = res.arrayImage, cBuffer = res.uploadBuffer, layer = firstLayer + i, i] (DxvkContext* ctx) {
+      VkImageSubresourceLayers subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layer, 1 };
+      ctx->copyBufferToImage(cImage, subresource, VkOffset3D { 0, 0, 0 }, ArrayExtent,
+        cBuffer, VkDeviceSize(i) * ArrayExtent.width * ArrayExtent.height * 4, 0, 0);
+    });
+  }
+
+  recorder.emit([] (DxvkContext* ctx) {
+    ctx->endFrame();
+    ctx->flushCommandList();
+  });
+}
+
+
+int main(int argc, char** argv) {
+  constexpr uint32_t RecordedFrames = 8;
+  constexpr uint32_t ReplayCount    = 100;
+
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter> adapter = instance->enumAdapters(0);
+
+    if (adapter == nullptr) {
+      std::cerr << "No Vulkan adapter found" << std::endl;
+      return 1;
+    }
+
+    Rc<DxvkDevice> device = adapter->createDevice(instance, adapter->features());
+    Rc<DxvkContext> context = device->createContext(DxvkContextType::Primary);
+
+    FrameResources resources = createResources(device);
+
+    CsStreamRecorder setup(device);
+    setup.emit([device] (DxvkContext* ctx) {
+      ctx->beginRecording(device->createCommandList());
+    });
+
+    CsStreamRecorder stream(device);
+
+    for (uint32_t i = 0; i < RecordedFrames; i++)
+      recordFrame(stream, resources, i);
+
+    DxvkCsThread csThread(device, context);
+
+    for (const auto& chunk : setup.chunks())
+      csThread.dispatchChunk(DxvkCsChunkRef(chunk));
+
+    csThread.synchronize(DxvkCsThread::SynchronizeAll);
+
+    // Warm up once so that meta pipelines and memory
+    // chunks are created before we start measuring
+    for (const auto& chunk : stream.chunks())
+      csThread.dispatchChunk(DxvkCsChunkRef(chunk));
+
+    csThread.synchronize(DxvkCsThread::SynchronizeAll);
+    device->waitForIdle();
+
+    auto t0 = high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < ReplayCount; i++) {
+      for (const auto& chunk : stream.chunks())
+        csThread.dispatchChunk(DxvkCsChunkRef(chunk));
+    }
+
+    csThread.synchronize(DxvkCsThread::SynchronizeAll);
+
+    auto t1 = high_resolution_clock::now();
+    device->waitForIdle();
+    auto t2 = high_resolution_clock::now();
+
+    auto cpuUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    auto gpuUs = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t0).count();
+
+    uint32_t frameCount = RecordedFrames * ReplayCount;
+
+    std::cout << "Replayed " << frameCount << " frames ("
+              << stream.chunks().size() << " chunks per replay)" << std::endl;
+    std::cout << "CS thread: " << cpuUs << " us, "
+              << (cpuUs / frameCount) << " us per frame" << std::endl;
+    std::cout << "Including GPU: " << gpuUs << " us" << std::endl;
+  } catch (const DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
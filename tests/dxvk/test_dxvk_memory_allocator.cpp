@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_allocator.h"
+
+#include "../../src/util/util_time.h"
+
+using namespace dxvk;
+
+/**
+ * \brief Worst-fit free list allocator
+ *
+ * Reference implementation of the algorithm previously
+ * used by \c DxvkMemoryChunk, used for comparison.
+ */
+class FreeListAllocator {
+
+public:
+
+  FreeListAllocator(VkDeviceSize capacity)
+  : m_capacity(capacity) {
+    m_freeList.push_back({ 0, capacity });
+  }
+
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align) {
+    if (m_freeList.empty())
+      return DxvkTlsfAllocator::InvalidOffset;
+
+    auto bestSlice = m_freeList.begin();
+
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    VkDeviceSize sliceStart = bestSlice->offset;
+    VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+
+    VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+
+    if (allocEnd > sliceEnd)
+      return DxvkTlsfAllocator::InvalidOffset;
+
+    m_freeList.erase(bestSlice);
+
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+    return allocStart;
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length) {
+    auto curr = m_freeList.begin();
+
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    m_freeList.push_back({ offset, length });
+  }
+
+private:
+
+  struct FreeSlice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+
+  VkDeviceSize           m_capacity;
+  std::vector<FreeSlice> m_freeList;
+
+};
+
+
+struct Allocation {
+  VkDeviceSize offset;
+  VkDeviceSize length;
+};
+
+
+struct Request {
+  bool         isFree;
+  uint32_t     index;
+  VkDeviceSize size;
+  VkDeviceSize align;
+};
+
+
+/**
+ * \brief Generates a streaming-like workload
+ *
+ * Mostly small allocations with some larger ones mixed in,
+ * with a live set that fluctuates around a target size and
+ * frees in random order, which fragments the address space.
+ */
+std::vector<Request> generateWorkload(VkDeviceSize capacity, uint32_t count) {
+  std::mt19937 rng(0x1337u);
+
+  std::vector<Request> result;
+  std::vector<uint32_t> live;
+
+  VkDeviceSize liveSize = 0;
+  VkDeviceSize target   = capacity / 2;
+
+  for (uint32_t i = 0; i < count; i++) {
+    bool doFree = !live.empty() && (liveSize > target || (rng() % 3) == 0);
+
+    if (doFree) {
+      uint32_t slot = rng() % live.size();
+      uint32_t index = live[slot];
+
+      live[slot] = live.back();
+      live.pop_back();
+
+      result.push_back({ true, index, result[index].size, 0 });
+      liveSize -= result[index].size;
+    } else {
+      uint32_t kind = rng() % 100;
+
+      VkDeviceSize size;
+      VkDeviceSize align;
+
+      if (kind < 70) {
+        size  = 256 + (rng() % (64 << 10));
+        align = 256;
+      } else if (kind < 95) {
+        size  = (64 << 10) + (rng() % (1 << 20));
+        align = 64 << 10;
+      } else {
+        size  = (1 << 20) + (rng() % (8 << 20));
+        align = 64 << 10;
+      }
+
+      uint32_t index = uint32_t(result.size());
+      result.push_back({ false, index, size, align });
+      live.push_back(index);
+      liveSize += size;
+    }
+  }
+
+  return result;
+}
+
+
+template<typename Alloc, typename FreeFn>
+void runBenchmark(
+  const char*                 name,
+        Alloc&                allocator,
+        FreeFn&&              freeFn,
+  const std::vector<Request>& requests) {
+  std::vector<Allocation> allocations(requests.size(), { DxvkTlsfAllocator::InvalidOffset, 0 });
+
+  uint32_t failures = 0;
+
+  auto t0 = high_resolution_clock::now();
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    const Request& r = requests[i];
+
+    if (r.isFree) {
+      Allocation& a = allocations[r.index];
+
+      if (a.offset != DxvkTlsfAllocator::InvalidOffset)
+        freeFn(allocator, a.offset, a.length);
+    } else {
+      VkDeviceSize length = dxvk::align(r.size, r.align);
+      VkDeviceSize offset = allocator.alloc(length, r.align);
+
+      if (offset != DxvkTlsfAllocator::InvalidOffset)
+        allocations[i] = { offset, length };
+      else
+        failures += 1;
+    }
+  }
+
+  auto t1 = high_resolution_clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+  std::cout << name << ": " << requests.size() << " operations in "
+            << us << " us, " << failures << " failed allocations" << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+  constexpr VkDeviceSize Capacity = VkDeviceSize(128) << 20;
+  constexpr uint32_t     Count    = 200000;
+
+  std::vector<Request> requests = generateWorkload(Capacity, Count);
+
+  FreeListAllocator freeList(Capacity);
+  runBenchmark("Free list", freeList,
+    [] (FreeListAllocator& a, VkDeviceSize offset, VkDeviceSize length) {
+      a.free(offset, length);
+    }, requests);
+
+  DxvkTlsfAllocator tlsf(Capacity);
+  runBenchmark("TLSF     ", tlsf,
+    [] (DxvkTlsfAllocator& a, VkDeviceSize offset, VkDeviceSize length) {
+      a.free(offset);
+    }, requests);
+
+  return 0;
+}
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_format.h"
+#include "../../src/dxvk/dxvk_util.h"
+#include "../../src/dxvk/dxvk_barrier.h"
+#include "../../src/dxvk/dxvk_cs.h"
+#include "../../src/dxvk/dxvk_descriptor.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_graphics_state.h"
+#include "../../src/dxvk/dxvk_hash.h"
+#include "../../src/dxvk/dxvk_instance.h"
+#include "../../src/dxvk/dxvk_memory.h"
+
+#include "../../src/spirv/spirv_compression.h"
+
+#include "../../src/util/util_hash128.h"
+#include "../../src/util/util_time.h"
+
+#include "../../src/util/sha1/sha1_util.h"
+
+using namespace dxvk;
+
+/**
+ * \brief Global allocation counter
+ *
+ * Counts calls to the global allocation functions so that
+ * each benchmark can report heap allocations per operation.
+ */
+static std::atomic<uint64_t> g_allocCount = { 0u };
+
+void* operator new (size_t size) {
+  g_allocCount.fetch_add(1, std::memory_order_relaxed);
+
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size) {
+  return operator new (size);
+}
+
+void operator delete (void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[] (void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete (void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[] (void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+
+/**
+ * \brief Runs a single benchmark
+ *
+ * Runs the given function once to warm up caches and lazily
+ * created objects, then measures the given number of
+ * iterations. The function must perform \c opsPerIteration
+ * operations per call.
+ */
+template<typename Fn>
+void runBenchmark(
+  const char*                 name,
+        uint32_t              iterations,
+        uint32_t              opsPerIteration,
+        Fn&&                  fn) {
+  fn();
+
+  uint64_t allocs = g_allocCount.load();
+  auto t0 = high_resolution_clock::now();
+
+  for (uint32_t i = 0; i < iterations; i++)
+    fn();
+
+  auto t1 = high_resolution_clock::now();
+  allocs = g_allocCount.load() - allocs;
+
+  double ops = double(iterations) * double(opsPerIteration);
+  double ns  = double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed
+            << std::setw(10) << std::setprecision(1) << (ns / ops) << " ns/op"
+            << std::setw(10) << std::setprecision(3) << (double(allocs) / ops) << " allocs/op"
+            << std::endl;
+}
+
+
+/**
+ * \brief Command stream benchmark
+ *
+ * Fills a CS chunk with small commands and executes them.
+ * The commands do not touch the context, so this measures
+ * the overhead of the chunk itself.
+ */
+void benchmarkCsChunk() {
+  constexpr uint32_t CommandCount = 512;
+
+  DxvkCsChunk chunk(0);
+  uint64_t counter = 0;
+
+  runBenchmark("CS chunk push", 10000, CommandCount, [&] {
+    chunk.init(DxvkCsChunkFlags(DxvkCsChunkFlag::SingleUse));
+
+    for (uint32_t i = 0; i < CommandCount; i++) {
+      auto cmd = [&counter, i] (DxvkContext*) { counter += i; };
+      chunk.push(cmd);
+    }
+
+    chunk.reset();
+  });
+
+  runBenchmark("CS chunk push + executeAll", 10000, CommandCount, [&] {
+    chunk.init(DxvkCsChunkFlags(DxvkCsChunkFlag::SingleUse));
+
+    for (uint32_t i = 0; i < CommandCount; i++) {
+      auto cmd = [&counter, i] (DxvkContext*) { counter += i; };
+      chunk.push(cmd);
+    }
+
+    chunk.executeAll(nullptr);
+  });
+
+  if (!counter)
+    std::cout << std::endl;
+}
+
+
+/**
+ * \brief Barrier set benchmark
+ *
+ * Records accesses to a set of buffer slices and checks
+ * for hazards against them, similar to what the context
+ * does for every transfer or dispatch.
+ */
+void benchmarkBarrierSet() {
+  constexpr uint32_t SliceCount = 256;
+
+  std::vector<DxvkBufferSliceHandle> slices(SliceCount);
+
+  for (uint32_t i = 0; i < SliceCount; i++) {
+    slices[i].handle = VkBuffer(uintptr_t(1 + (i % 16)));
+    slices[i].offset = VkDeviceSize(i / 16) * 1024;
+    slices[i].length = 1024;
+    slices[i].mapPtr = nullptr;
+  }
+
+  DxvkBarrierSet barriers(DxvkCmdBuffer::ExecBuffer);
+  uint32_t hazards = 0;
+
+  runBenchmark("Barrier set accessBuffer", 10000, SliceCount, [&] {
+    for (uint32_t i = 0; i < SliceCount; i++) {
+      barriers.accessBuffer(slices[i],
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    }
+
+    barriers.reset();
+  });
+
+  for (uint32_t i = 0; i < SliceCount; i += 2) {
+    barriers.accessBuffer(slices[i],
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+  }
+
+  runBenchmark("Barrier set isBufferDirty", 10000, SliceCount, [&] {
+    for (uint32_t i = 0; i < SliceCount; i++)
+      hazards += barriers.isBufferDirty(slices[i], DxvkAccess::Read);
+  });
+
+  if (!hazards)
+    std::cout << std::endl;
+}
+
+
+/**
+ * \brief Hashing benchmark
+ *
+ * Measures \c DxvkHashState on its own as well
+ * as hashing the full graphics pipeline state.
+ */
+void benchmarkHash() {
+  constexpr uint32_t HashCount = 1024;
+
+  std::mt19937 rng(0x1337u);
+
+  std::vector<size_t> values(HashCount);
+
+  for (auto& v : values)
+    v = size_t(rng());
+
+  std::vector<DxvkGraphicsPipelineStateInfo> states(64);
+
+  for (auto& state : states) {
+    auto data = reinterpret_cast<uint8_t*>(&state);
+
+    for (size_t i = 0; i < sizeof(state); i++)
+      data[i] = uint8_t(rng() & 0x3);
+  }
+
+  size_t result = 0;
+
+  runBenchmark("DxvkHashState::add", 10000, HashCount, [&] {
+    DxvkHashState hash;
+
+    for (uint32_t i = 0; i < HashCount; i++)
+      hash.add(values[i]);
+
+    result += hash;
+  });
+
+  runBenchmark("DxvkGraphicsPipelineStateInfo::hash", 10000, states.size(), [&] {
+    for (const auto& state : states)
+      result += state.hash();
+  });
+
+  if (!result)
+    std::cout << std::endl;
+}
+
+
+/**
+ * \brief Data hashing benchmark
+ *
+ * Compares SHA-1 against \c Hash128 for buffers
+ * roughly the size of typical shader bytecode.
+ */
+void benchmarkDataHash() {
+  constexpr size_t DataSize = 16384;
+
+  std::mt19937 rng(0x1337u);
+  std::vector<uint8_t> data(DataSize);
+
+  for (auto& b : data)
+    b = uint8_t(rng());
+
+  uint32_t result = 0;
+
+  runBenchmark("Sha1Hash::compute (16 KiB)", 2000, 1, [&] {
+    result += Sha1Hash::compute(data.data(), data.size()).dword(0);
+  });
+
+  runBenchmark("Hash128::compute (16 KiB)", 2000, 1, [&] {
+    result += uint32_t(Hash128::compute(data.data(), data.size()).lo());
+  });
+
+  runBenchmark("Hash128::compute (64 B)", 100000, 1, [&] {
+    result += uint32_t(Hash128::compute(data.data(), 64).lo());
+  });
+
+  if (!result)
+    std::cout << std::endl;
+}
+
+
+/**
+ * \brief SPIR-V decompression benchmark
+ *
+ * Generates a code buffer with a mix of small and large
+ * instruction operands, roughly resembling translated
+ * shader code, and decompresses it repeatedly.
+ */
+void benchmarkSpirvDecompression() {
+  constexpr uint32_t InstructionCount = 4096;
+
+  std::mt19937 rng(0x1337u);
+
+  SpirvCodeBuffer code;
+  code.putHeader(0x10300, 4 * InstructionCount);
+
+  for (uint32_t i = 0; i < InstructionCount; i++) {
+    code.putIns(spv::OpIAdd, 5);
+    code.putWord(1 + (rng() % 64));
+    code.putWord(i + 1);
+    code.putWord(1 + (rng() % (i + 1)));
+    code.putWord(rng() % 8 ? 1 + (rng() % (i + 1)) : rng());
+  }
+
+  SpirvCompressedBuffer compressed(code);
+  size_t dwords = 0;
+
+  runBenchmark("SpirvCompressedBuffer::decompress", 1000, code.dwords(), [&] {
+    dwords += compressed.decompress().dwords();
+  });
+
+  if (!dwords)
+    std::cout << std::endl;
+}
+
+
+/**
+ * \brief Memory allocator benchmark
+ *
+ * Allocates and frees small device-local buffers in
+ * random order, so that most requests are served by
+ * existing memory chunks.
+ */
+void benchmarkMemoryAllocator(const Rc<DxvkDevice>& device) {
+  constexpr uint32_t AllocCount = 1024;
+
+  DxvkMemoryAllocator allocator(device.ptr());
+
+  VkMemoryDedicatedRequirements dedicatedReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS };
+  VkMemoryDedicatedAllocateInfo dedicatedInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO };
+
+  std::mt19937 rng(0x1337u);
+  std::vector<VkMemoryRequirements> requirements(AllocCount);
+
+  for (auto& req : requirements) {
+    req.size           = 256 + (rng() % (64 << 10));
+    req.alignment      = 256;
+    req.memoryTypeBits = ~0u;
+  }
+
+  std::vector<DxvkMemory> allocations(AllocCount);
+  std::vector<uint32_t> freeOrder(AllocCount);
+
+  for (uint32_t i = 0; i < AllocCount; i++)
+    freeOrder[i] = i;
+
+  std::shuffle(freeOrder.begin(), freeOrder.end(), rng);
+
+  runBenchmark("DxvkMemoryAllocator alloc + free", 100, AllocCount, [&] {
+    for (uint32_t i = 0; i < AllocCount; i++) {
+      allocations[i] = allocator.alloc(&requirements[i], dedicatedReq, dedicatedInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryFlags());
+    }
+
+    for (uint32_t i = 0; i < AllocCount; i++)
+      allocations[freeOrder[i]] = DxvkMemory();
+  });
+}
+
+
+/**
+ * \brief Descriptor pool benchmark
+ *
+ * Allocates descriptor sets for a typical layout
+ * and resets the pool in between iterations.
+ */
+void benchmarkDescriptorPool(const Rc<DxvkDevice>& device) {
+  constexpr uint32_t SetCount = 1024;
+
+  Rc<vk::DeviceFn> vkd = device->vkd();
+
+  std::array<VkDescriptorSetLayoutBinding, 3> bindings = {{
+    { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         4, VK_SHADER_STAGE_ALL_GRAPHICS },
+    { 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 8, VK_SHADER_STAGE_ALL_GRAPHICS },
+    { 12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,        2, VK_SHADER_STAGE_ALL_GRAPHICS },
+  }};
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+  layoutInfo.bindingCount = bindings.size();
+  layoutInfo.pBindings    = bindings.data();
+
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+
+  if (vkd->vkCreateDescriptorSetLayout(vkd->device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    throw DxvkError("Failed to create descriptor set layout");
+
+  { Rc<DxvkDescriptorManager> manager = new DxvkDescriptorManager(device.ptr(), DxvkContextType::Primary);
+    Rc<DxvkDescriptorPool> pool = manager->getDescriptorPool();
+
+    runBenchmark("DxvkDescriptorPool alloc", 100, SetCount, [&] {
+      for (uint32_t i = 0; i < SetCount; i++)
+        pool->alloc(layout);
+
+      pool->reset();
+    });
+
+    manager->recycleDescriptorPool(pool);
+  }
+
+  vkd->vkDestroyDescriptorSetLayout(vkd->device(), layout, nullptr);
+}
+
+
+int main(int argc, char** argv) {
+  benchmarkCsChunk();
+  benchmarkBarrierSet();
+  benchmarkHash();
+  benchmarkDataHash();
+  benchmarkSpirvDecompression();
+
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter> adapter = instance->enumAdapters(0);
+
+    if (adapter == nullptr) {
+      std::cerr << "No Vulkan adapter found, skipping device benchmarks" << std::endl;
+      return 0;
+    }
+
+    Rc<DxvkDevice> device = adapter->createDevice(instance, adapter->features());
+
+    benchmarkMemoryAllocator(device);
+    benchmarkDescriptorPool(device);
+  } catch (const DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
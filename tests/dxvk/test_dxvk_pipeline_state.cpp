@@ -0,0 +1,169 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_format.h"
+#include "../../src/dxvk/dxvk_util.h"
+#include "../../src/dxvk/dxvk_graphics_state.h"
+#include "../../src/dxvk/dxvk_hash.h"
+
+#include "../../src/util/util_time.h"
+
+using namespace dxvk;
+
+constexpr uint32_t BucketCount = 64;
+
+/**
+ * \brief Scalar reference hash
+ *
+ * Hashes the state vector one 64-bit word at a
+ * time using \c DxvkHashState, used for comparison.
+ */
+size_t scalarHash(const DxvkGraphicsPipelineStateInfo& state) {
+  auto data = reinterpret_cast<const uint64_t*>(&state);
+
+  DxvkHashState hash;
+
+  for (size_t i = 0; i < sizeof(state) / sizeof(uint64_t); i++)
+    hash.add(size_t(data[i]));
+
+  return hash;
+}
+
+
+struct Instance {
+  DxvkGraphicsPipelineStateInfo state;
+  size_t                        hash;
+  Instance*                     next;
+};
+
+
+/**
+ * \brief Generates similar state vectors
+ *
+ * Pipelines that are used with many render states tend
+ * to only differ in a handful of bytes, so start with
+ * one state vector and change a few words in each copy.
+ */
+std::vector<DxvkGraphicsPipelineStateInfo> generateStates(uint32_t count) {
+  std::mt19937 rng(0x1337u);
+
+  std::vector<DxvkGraphicsPipelineStateInfo> result(count);
+  constexpr uint32_t WordCount = sizeof(DxvkGraphicsPipelineStateInfo) / sizeof(uint32_t);
+
+  for (uint32_t i = 0; i < count; i++) {
+    auto words = reinterpret_cast<uint32_t*>(&result[i]);
+    words[0] = i;
+
+    for (uint32_t j = 0; j < 3; j++)
+      words[rng() % WordCount] = rng();
+  }
+
+  return result;
+}
+
+
+template<typename Fn>
+void runBenchmark(const char* name, uint32_t count, Fn&& fn) {
+  uint32_t found = 0;
+
+  auto t0 = high_resolution_clock::now();
+
+  for (uint32_t i = 0; i < count; i++)
+    found += fn(i) ? 1 : 0;
+
+  auto t1 = high_resolution_clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+  std::cout << name << ": " << count << " lookups in "
+            << us << " us (" << found << " hits)" << std::endl;
+}
+
+
+template<typename HashFn>
+std::vector<Instance*> buildTable(std::vector<Instance>& instances, HashFn&& hashFn) {
+  std::vector<Instance*> buckets(BucketCount, nullptr);
+
+  for (auto& instance : instances) {
+    auto& bucket = buckets[hashFn(instance.state) % BucketCount];
+    instance.hash = hashFn(instance.state);
+    instance.next = bucket;
+    bucket = &instance;
+  }
+
+  return buckets;
+}
+
+
+int main(int argc, char** argv) {
+  constexpr uint32_t InstanceCount = 500;
+  constexpr uint32_t LookupCount   = 1000000;
+
+  std::vector<DxvkGraphicsPipelineStateInfo> states = generateStates(InstanceCount);
+  std::vector<Instance> instances(InstanceCount);
+
+  for (uint32_t i = 0; i < InstanceCount; i++)
+    instances[i].state = states[i];
+
+  // Access pattern that favours recently added instances,
+  // similar to what happens during a typical frame
+  std::mt19937 rng(0x4242u);
+  std::vector<uint32_t> lookups(LookupCount);
+
+  for (uint32_t i = 0; i < LookupCount; i++)
+    lookups[i] = std::min(rng() % InstanceCount, rng() % InstanceCount);
+
+  runBenchmark("Linear, memcmp ", LookupCount, [&] (uint32_t i) {
+    const auto& state = states[lookups[i]];
+
+    for (const auto& instance : instances) {
+      if (!std::memcmp(&instance.state, &state, sizeof(state)))
+        return true;
+    }
+
+    return false;
+  });
+
+  runBenchmark("Linear, bcmpeq ", LookupCount, [&] (uint32_t i) {
+    const auto& state = states[lookups[i]];
+
+    for (const auto& instance : instances) {
+      if (instance.state == state)
+        return true;
+    }
+
+    return false;
+  });
+
+  auto scalarBuckets = buildTable(instances, scalarHash);
+
+  runBenchmark("Hashed, scalar ", LookupCount, [&] (uint32_t i) {
+    const auto& state = states[lookups[i]];
+    size_t hash = scalarHash(state);
+
+    for (auto instance = scalarBuckets[hash % BucketCount]; instance; instance = instance->next) {
+      if (instance->hash == hash && instance->state == state)
+        return true;
+    }
+
+    return false;
+  });
+
+  auto simdBuckets = buildTable(instances,
+    [] (const DxvkGraphicsPipelineStateInfo& state) { return state.hash(); });
+
+  runBenchmark("Hashed, SIMD   ", LookupCount, [&] (uint32_t i) {
+    const auto& state = states[lookups[i]];
+    size_t hash = state.hash();
+
+    for (auto instance = simdBuckets[hash % BucketCount]; instance; instance = instance->next) {
+      if (instance->hash == hash && instance->state == state)
+        return true;
+    }
+
+    return false;
+  });
+
+  return 0;
+}